@@ -0,0 +1,94 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_FOR_EACH_ROW_BAND_H
+#define INCLUDED_FOR_EACH_ROW_BAND_H
+
+//-----------------------------------------------------------------------------
+//
+//	function forEachRowBand() -- splits rows 0 to numRows - 1 of
+//	an image into bands of bandHeight rows, and calls rows (y0, y1)
+//	for each band, where y0 is the first row of the band, and y1 is
+//	one past the last row.  The bands are processed in parallel,
+//	using the global thread pool.  If rows throws an exception, the
+//	first exception is re-thrown after all bands have been processed.
+//
+//	This is shared by the command line tools, and is kept in a
+//	header so that each tool can simply include it.
+//
+//-----------------------------------------------------------------------------
+
+#include <IlmThreadPool.h>
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+class RowBandTask : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    RowBandTask (
+        ILMTHREAD_NAMESPACE::TaskGroup*        group,
+        const std::function<void (int, int)>& rows,
+        int                                    y0,
+        int                                    y1,
+        std::mutex&                            errorMutex,
+        std::exception_ptr&                    error)
+        : ILMTHREAD_NAMESPACE::Task (group)
+        , _rows (rows)
+        , _y0 (y0)
+        , _y1 (y1)
+        , _errorMutex (errorMutex)
+        , _error (error)
+    {}
+
+    void execute () override
+    {
+        try
+        {
+            _rows (_y0, _y1);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock (_errorMutex);
+            if (!_error) _error = std::current_exception ();
+        }
+    }
+
+private:
+    const std::function<void (int, int)>& _rows;
+    int                                    _y0;
+    int                                    _y1;
+    std::mutex&                            _errorMutex;
+    std::exception_ptr&                    _error;
+};
+
+inline void
+forEachRowBand (
+    int numRows, int bandHeight, const std::function<void (int, int)>& rows)
+{
+    std::mutex         errorMutex;
+    std::exception_ptr error;
+
+    {
+        ILMTHREAD_NAMESPACE::TaskGroup group;
+
+        for (int y = 0; y < numRows; y += bandHeight)
+        {
+            ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (new RowBandTask (
+                &group,
+                rows,
+                y,
+                std::min (y + bandHeight, numRows),
+                errorMutex,
+                error));
+        }
+    }
+
+    if (error) std::rethrow_exception (error);
+}
+
+#endif
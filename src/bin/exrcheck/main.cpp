@@ -4,9 +4,12 @@
 #include <ImathConfig.h>
 #include <ImfCheckFile.h>
 #include <ImfMisc.h>
+#include <ImfThreading.h>
 #include <OpenEXRConfig.h>
 
+#include <chrono>
 #include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <ostream>
@@ -37,6 +40,10 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
                "  -t            avoid spending excessive time (some files will not be fully checked)\n"
                "  -s            use stream API instead of file API\n"
                "  -c            add core library checks\n"
+               "  -p n          use n threads; with -c, the chunks of each file are\n"
+               "                checked in parallel, stopping at the first bad chunk\n"
+               "  --timing      report the time taken for each file, and the overall\n"
+               "                throughput\n"
                "  -h, --help    print this message\n"
                "      --version print version information\n"
                "\n"
@@ -50,7 +57,8 @@ exrCheck (
     bool        reduceMemory,
     bool        reduceTime,
     bool        useStream,
-    bool        enableCoreCheck)
+    bool        enableCoreCheck,
+    int         numThreads)
 {
     if (useStream)
     {
@@ -89,12 +97,17 @@ exrCheck (
             return true;
         }
         return checkOpenEXRFile (
-            data.data (), length, reduceMemory, reduceTime, enableCoreCheck);
+            data.data (),
+            length,
+            reduceMemory,
+            reduceTime,
+            enableCoreCheck,
+            numThreads);
     }
     else
     {
         return checkOpenEXRFile (
-            filename, reduceMemory, reduceTime, enableCoreCheck);
+            filename, reduceMemory, reduceTime, enableCoreCheck, numThreads);
     }
 }
 
@@ -112,6 +125,16 @@ main (int argc, char** argv)
     bool enableCoreCheck = false;
     bool badFileFound    = false;
     bool useStream       = false;
+    bool timing          = false;
+    int  numThreads      = 1;
+
+    //
+    // throughput statistics for --timing
+    //
+    int      numFiles   = 0;
+    uint64_t totalBytes = 0;
+    auto     startTime  = std::chrono::steady_clock::now ();
+
     for (int i = 1; i < argc; ++i)
     {
         if (!strcmp (argv[i], "-h") || !strcmp (argv[i], "--help"))
@@ -132,6 +155,24 @@ main (int argc, char** argv)
         else if (!strcmp (argv[i], "-t")) { reduceTime = true; }
         else if (!strcmp (argv[i], "-s")) { useStream = true; }
         else if (!strcmp (argv[i], "-c")) { enableCoreCheck = true; }
+        else if (!strcmp (argv[i], "-p"))
+        {
+            if (i > argc - 2)
+            {
+                cerr << "Missing thread count value with -p option\n";
+                return 1;
+            }
+            numThreads = atoi (argv[i + 1]);
+            if (numThreads < 1)
+            {
+                cerr << "bad thread count " << argv[i + 1]
+                     << " specified to -p option\n";
+                return 1;
+            }
+            setGlobalThreadCount (numThreads > 1 ? numThreads : 0);
+            i += 1;
+        }
+        else if (!strcmp (argv[i], "--timing")) { timing = true; }
         else if (!strcmp (argv[i], "--version"))
         {
             const char* libraryVersion = getLibraryVersion ();
@@ -161,16 +202,50 @@ main (int argc, char** argv)
             cout << " file " << argv[i] << ' ';
             cout.flush ();
 
+            auto fileStart = std::chrono::steady_clock::now ();
+
             bool hasError = exrCheck (
-                argv[i], reduceMemory, reduceTime, useStream, enableCoreCheck);
+                argv[i],
+                reduceMemory,
+                reduceTime,
+                useStream,
+                enableCoreCheck,
+                numThreads);
             if (hasError)
             {
-                cout << "bad\n";
+                cout << "bad";
                 badFileFound = true;
             }
-            else { cout << "OK\n"; }
+            else { cout << "OK"; }
+
+            if (timing)
+            {
+                std::chrono::duration<double> elapsed =
+                    std::chrono::steady_clock::now () - fileStart;
+                cout << " (" << elapsed.count () << "s)";
+
+                ifstream sizestream (argv[i], ifstream::binary | ifstream::ate);
+                if (sizestream) totalBytes += sizestream.tellg ();
+            }
+            cout << "\n";
+            ++numFiles;
         }
     }
 
+    if (timing && numFiles > 0)
+    {
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now () - startTime;
+        double seconds = elapsed.count ();
+        cout << "checked " << numFiles << " files ("
+             << double (totalBytes) / (1024.0 * 1024.0) << " MiB) in "
+             << seconds << "s";
+        if (seconds > 0)
+            cout << ": " << numFiles / seconds << " files/s, "
+                 << double (totalBytes) / (1024.0 * 1024.0) / seconds
+                 << " MiB/s";
+        cout << endl;
+    }
+
     return badFileFound;
 }
@@ -16,14 +16,18 @@
 #include "Iex.h"
 #include <algorithm>
 #include <cstring>
+#include <forEachRowBand.h>
 #include <iostream>
 #include <resizeImage.h>
 #include <string.h>
+#include <vector>
 
 using namespace IMF;
 using namespace std;
 using namespace IMATH;
 
+static const int ROW_BAND_HEIGHT = 4;
+
 inline int
 toInt (float x)
 {
@@ -296,69 +300,130 @@ blurImage (EnvmapImage& image1, bool verbose)
         Array2D<Rgba>& pixels1 = iptr1->pixels ();
         Array2D<Rgba>& pixels2 = iptr2->pixels ();
 
-        for (int f2 = CUBEFACE_POS_X; f2 <= CUBEFACE_NEG_Z; ++f2)
-        {
-            if (verbose) cout << "        face " << f2 << endl;
+        //
+        // Gather the directions and the colors of the input pixels
+        // into separate arrays, padded with zero directions to a
+        // multiple of NUM_LANES entries.  The innermost loop below
+        // then reads consecutive values from each array, and keeps
+        // NUM_LANES independent partial sums, so that the compiler
+        // can vectorize it.
+        //
+
+        const int NUM_LANES = 8;
 
-            CubeMapFace face2 = CubeMapFace (f2);
+        int numPixels1 = 6 * sof1 * sof1;
+        int tableSize  = (numPixels1 + NUM_LANES - 1) / NUM_LANES * NUM_LANES;
+
+        vector<float> dirX (tableSize, 0.0f);
+        vector<float> dirY (tableSize, 0.0f);
+        vector<float> dirZ (tableSize, 0.0f);
+        vector<float> colR (tableSize, 0.0f);
+        vector<float> colG (tableSize, 0.0f);
+        vector<float> colB (tableSize, 0.0f);
+        vector<float> colA (tableSize, 0.0f);
+
+        int i = 0;
+
+        for (int f1 = CUBEFACE_POS_X; f1 <= CUBEFACE_NEG_Z; ++f1)
+        {
+            CubeMapFace face1 = CubeMapFace (f1);
 
-            for (int y2 = 0; y2 < sof2; ++y2)
+            for (int y1 = 0; y1 < sof1; ++y1)
             {
-                for (int x2 = 0; x2 < sof2; ++x2)
+                for (int x1 = 0; x1 < sof1; ++x1)
                 {
-                    V2f posInFace2 (x2, y2);
+                    V2f posInFace1 (x1, y1);
 
-                    V3f dir2 = CubeMap::direction (face2, dw2, posInFace2);
+                    V3f dir1 = CubeMap::direction (face1, dw1, posInFace1);
 
-                    V2f pos2 = CubeMap::pixelPosition (face2, dw2, posInFace2);
+                    V2f pos1 = CubeMap::pixelPosition (face1, dw1, posInFace1);
 
-                    double weightTotal = 0;
-                    double rTotal      = 0;
-                    double gTotal      = 0;
-                    double bTotal      = 0;
-                    double aTotal      = 0;
+                    const Rgba& pixel1 =
+                        pixels1[toInt (pos1.y)][toInt (pos1.x)];
 
-                    Rgba& pixel2 = pixels2[toInt (pos2.y)][toInt (pos2.x)];
-
-                    for (int f1 = CUBEFACE_POS_X; f1 <= CUBEFACE_NEG_Z; ++f1)
-                    {
-                        CubeMapFace face1 = CubeMapFace (f1);
+                    dirX[i] = dir1.x;
+                    dirY[i] = dir1.y;
+                    dirZ[i] = dir1.z;
+                    colR[i] = pixel1.r;
+                    colG[i] = pixel1.g;
+                    colB[i] = pixel1.b;
+                    colA[i] = pixel1.a;
+                    ++i;
+                }
+            }
+        }
 
-                        for (int y1 = 0; y1 < sof1; ++y1)
-                        {
-                            for (int x1 = 0; x1 < sof1; ++x1)
-                            {
-                                V2f posInFace1 (x1, y1);
+        //
+        // The rows of all six output faces are computed in parallel.
+        //
 
-                                V3f dir1 =
-                                    CubeMap::direction (face1, dw1, posInFace1);
+        forEachRowBand (6 * sof2, ROW_BAND_HEIGHT, [&] (int row1, int row2) {
+            for (int row = row1; row < row2; ++row)
+            {
+                CubeMapFace face2 = CubeMapFace (CUBEFACE_POS_X + row / sof2);
+                int         y2    = row % sof2;
 
-                                V2f pos1 = CubeMap::pixelPosition (
-                                    face1, dw1, posInFace1);
+                for (int x2 = 0; x2 < sof2; ++x2)
+                {
+                    V2f posInFace2 (x2, y2);
 
-                                double weight = dir1 ^ dir2;
+                    V3f dir2 = CubeMap::direction (face2, dw2, posInFace2);
 
-                                if (weight <= 0) continue;
+                    V2f pos2 = CubeMap::pixelPosition (face2, dw2, posInFace2);
 
-                                Rgba& pixel1 =
-                                    pixels1[toInt (pos1.y)][toInt (pos1.x)];
+                    double weightTotal[NUM_LANES] = {0};
+                    double rTotal[NUM_LANES]      = {0};
+                    double gTotal[NUM_LANES]      = {0};
+                    double bTotal[NUM_LANES]      = {0};
+                    double aTotal[NUM_LANES]      = {0};
 
-                                weightTotal += weight;
-                                rTotal += pixel1.r * weight;
-                                gTotal += pixel1.g * weight;
-                                bTotal += pixel1.b * weight;
-                                aTotal += pixel1.a * weight;
-                            }
+                    for (int j = 0; j < tableSize; j += NUM_LANES)
+                    {
+                        for (int k = 0; k < NUM_LANES; ++k)
+                        {
+                            float d = dirX[j + k] * dir2.x +
+                                      dirY[j + k] * dir2.y +
+                                      dirZ[j + k] * dir2.z;
+
+                            //
+                            // Pixels facing away from dir2 must be
+                            // skipped, not multiplied by zero: an
+                            // infinite or NaN color times zero is NaN,
+                            // and would spread to every output pixel.
+                            // Select each contribution instead, which
+                            // the compiler turns into a compare and
+                            // blend.
+                            //
+
+                            bool   front  = d > 0;
+                            double weight = front ? d : 0;
+
+                            weightTotal[k] += weight;
+                            rTotal[k] += front ? colR[j + k] * weight : 0;
+                            gTotal[k] += front ? colG[j + k] * weight : 0;
+                            bTotal[k] += front ? colB[j + k] * weight : 0;
+                            aTotal[k] += front ? colA[j + k] * weight : 0;
                         }
                     }
 
-                    pixel2.r = rTotal / weightTotal;
-                    pixel2.g = gTotal / weightTotal;
-                    pixel2.b = bTotal / weightTotal;
-                    pixel2.a = aTotal / weightTotal;
+                    for (int k = 1; k < NUM_LANES; ++k)
+                    {
+                        weightTotal[0] += weightTotal[k];
+                        rTotal[0] += rTotal[k];
+                        gTotal[0] += gTotal[k];
+                        bTotal[0] += bTotal[k];
+                        aTotal[0] += aTotal[k];
+                    }
+
+                    Rgba& pixel2 = pixels2[toInt (pos2.y)][toInt (pos2.x)];
+
+                    pixel2.r = rTotal[0] / weightTotal[0];
+                    pixel2.g = gTotal[0] / weightTotal[0];
+                    pixel2.b = bTotal[0] / weightTotal[0];
+                    pixel2.a = aTotal[0] / weightTotal[0];
                 }
             }
-        }
+        });
 
         swap (iptr1, iptr2);
     }
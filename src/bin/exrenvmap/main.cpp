@@ -13,8 +13,11 @@
 #include <ImfEnvmap.h>
 #include <ImfHeader.h>
 #include <ImfMisc.h>
+#include <ImfThreading.h>
 #include <OpenEXRConfig.h>
 
+#include <IlmThreadPool.h>
+
 #include <blurImage.h>
 #include <makeCubeMap.h>
 #include <makeLatLongMap.h>
@@ -28,6 +31,7 @@
 
 #include "namespaceAlias.h"
 using namespace IMF;
+using namespace ILMTHREAD_NAMESPACE;
 using namespace std;
 
 namespace
@@ -130,6 +134,10 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
                "\n"
                "  -v            verbose mode\n"
                "\n"
+               "  --threads n   use n threads to resample, blur and write\n"
+               "                the image (default is the number of\n"
+               "                available processors, 0 disables threading)\n"
+               "\n"
                "  -h, --help    print this message\n"
                "\n"
                "      --version print version information\n"
@@ -175,6 +183,7 @@ main (int argc, char** argv)
     int               numSamples        = 5;
     bool              diffuseBlur       = false;
     bool              verbose           = false;
+    int               threads           = -1;
 
     //
     // Parse the command line.
@@ -372,6 +381,23 @@ main (int argc, char** argv)
                 verbose = true;
                 i += 1;
             }
+            else if (!strcmp (argv[i], "--threads"))
+            {
+                //
+                // Set number of threads
+                //
+
+                if (i > argc - 2)
+                    throw invalid_argument (
+                        "Missing thread count value with --threads option");
+
+                threads = strtol (argv[i + 1], 0, 0);
+
+                if (threads < 0)
+                    throw invalid_argument ("Thread count cannot be negative");
+
+                i += 2;
+            }
             else if (!strcmp (argv[i], "-h") || !strcmp (argv[i], "--help"))
             {
                 //
@@ -419,6 +445,11 @@ main (int argc, char** argv)
         // Load inFile, convert it, and save the result in outFile.
         //
 
+        if (threads < 0)
+            setGlobalThreadCount (ThreadPool::estimateThreadCountForFileIO ());
+        else
+            setGlobalThreadCount (threads);
+
         EnvmapImage  image;
         Header       header;
         RgbaChannels channels;
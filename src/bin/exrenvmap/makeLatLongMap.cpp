@@ -91,9 +91,8 @@ makeLatLongMap (
 
         out.setFrameBuffer (&(iptr2->pixels ()[0][0]), 1, dw.max.x + 1);
 
-        for (int tileY = 0; tileY < out.numYTiles (level); ++tileY)
-            for (int tileX = 0; tileX < out.numXTiles (level); ++tileX)
-                out.writeTile (tileX, tileY, level);
+        out.writeTiles (
+            0, out.numXTiles (level) - 1, 0, out.numYTiles (level) - 1, level);
 
         swap (iptr1, iptr2);
     }
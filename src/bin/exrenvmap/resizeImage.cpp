@@ -14,6 +14,7 @@
 #include <resizeImage.h>
 
 #include "Iex.h"
+#include <forEachRowBand.h>
 #include <string.h>
 
 #include "namespaceAlias.h"
@@ -21,6 +22,14 @@ using namespace IMF;
 using namespace std;
 using namespace IMATH;
 
+//
+// Bands are kept small, so that the work is spread evenly across
+// the threads even when the cost of a row varies, as it does for
+// the rows of a latitude-longitude map.
+//
+
+static const int ROW_BAND_HEIGHT = 4;
+
 void
 resizeLatLong (
     const EnvmapImage& image1,
@@ -38,14 +47,16 @@ resizeLatLong (
 
     Array2D<Rgba>& pixels = image2.pixels ();
 
-    for (int y = 0; y < h; ++y)
-    {
-        for (int x = 0; x < w; ++x)
+    forEachRowBand (h, ROW_BAND_HEIGHT, [&] (int y1, int y2) {
+        for (int y = y1; y < y2; ++y)
         {
-            V3f dir      = LatLongMap::direction (image2DataWindow, V2f (x, y));
-            pixels[y][x] = image1.filteredLookup (dir, radius, numSamples);
+            for (int x = 0; x < w; ++x)
+            {
+                V3f dir = LatLongMap::direction (image2DataWindow, V2f (x, y));
+                pixels[y][x] = image1.filteredLookup (dir, radius, numSamples);
+            }
         }
-    }
+    });
 }
 
 void
@@ -90,12 +101,16 @@ resizeCube (
 
     Array2D<Rgba>& pixels = image2.pixels ();
 
-    for (int f = CUBEFACE_POS_X; f <= CUBEFACE_NEG_Z; ++f)
-    {
-        CubeMapFace face = CubeMapFace (f);
+    //
+    // The rows of all six faces are processed in parallel.
+    //
 
-        for (int y = 0; y < sof; ++y)
+    forEachRowBand (6 * sof, ROW_BAND_HEIGHT, [&] (int y1, int y2) {
+        for (int row = y1; row < y2; ++row)
         {
+            CubeMapFace face = CubeMapFace (CUBEFACE_POS_X + row / sof);
+            int         y    = row % sof;
+
             for (int x = 0; x < sof; ++x)
             {
                 V2f posInFace (x, y);
@@ -110,5 +125,5 @@ resizeCube (
                     image1.filteredLookup (dir, radius, numSamples);
             }
         }
-    }
+    });
 }
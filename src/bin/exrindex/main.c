@@ -0,0 +1,282 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#include <openexr.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void
+usage (FILE* stream, const char* argv0, int verbose)
+{
+    fprintf (
+        stream,
+        "Usage: %s -o <index> <filename> [<filename> ...]\n"
+        "       %s -l <index>\n"
+        "       %s -c <index>\n\n",
+        argv0,
+        argv0,
+        argv0);
+
+    if (verbose)
+        fprintf (
+            stream,
+            "\n"
+            "Build an index of the headers and chunk offset tables of a\n"
+            "set of exr files (e.g. the frames of a sequence), so they can\n"
+            "later be opened without reading that metadata from each file\n"
+            "again (see exr_start_read_indexed in the OpenEXRCore API).\n"
+            "Entries are named by the filenames as given on the command line.\n"
+            "\n"
+            "Options:\n"
+            "  -o, --output <index>  write an index of the given files\n"
+            "  -l, --list <index>    list the entries of an index\n"
+            "  -c, --check <index>   check each entry still matches its file\n"
+            "  -h, --help            print this message\n"
+            "      --version         print version information\n"
+            "\n"
+            "Report bugs via https://github.com/AcademySoftwareFoundation/openexr/issues or email security@openexr.com\n"
+            "");
+}
+
+static void
+error_handler_cb (exr_const_context_t f, int code, const char* msg)
+{
+    const char* fn;
+    if (EXR_ERR_SUCCESS != exr_get_file_name (f, &fn)) fn = "<error>";
+    fprintf (
+        stderr,
+        "ERROR '%s' (%s): %s\n",
+        fn,
+        exr_get_error_code_as_string (code),
+        msg);
+}
+
+static int
+write_le (FILE* out, uint64_t v, int nbytes)
+{
+    unsigned char b[8];
+    for (int i = 0; i < nbytes; ++i)
+        b[i] = (unsigned char) (v >> (8 * i));
+    return fwrite (b, 1, (size_t) nbytes, out) == (size_t) nbytes;
+}
+
+static int
+build_index (const char* indexfn, int nfiles, const char* files[])
+{
+    int                       failcount = 0;
+    uint64_t                  written   = 0;
+    void*                     entry     = NULL;
+    size_t                    entrycap  = 0;
+    exr_context_initializer_t cinit     = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    FILE*                     out;
+
+    cinit.error_handler_fn = &error_handler_cb;
+
+    out = fopen (indexfn, "wb");
+    if (!out)
+    {
+        fprintf (stderr, "ERROR: unable to open '%s' for write\n", indexfn);
+        return 1;
+    }
+
+    /* the entry count is patched once the files have been read */
+    if (fwrite ("EXRX", 1, 4, out) != 4 || !write_le (out, 1, 4) ||
+        !write_le (out, 0, 8))
+        ++failcount;
+
+    for (int f = 0; f < nfiles && failcount == 0; ++f)
+    {
+        exr_context_t e = NULL;
+        size_t        entrysize, namelen;
+        static const char zeros[8] = {0};
+
+        if (EXR_ERR_SUCCESS != exr_start_read (&e, files[f], &cinit) ||
+            EXR_ERR_SUCCESS != exr_get_index_entry (e, NULL, &entrysize))
+        {
+            exr_finish (&e);
+            ++failcount;
+            break;
+        }
+
+        if (entrysize > entrycap)
+        {
+            free (entry);
+            entrycap = entrysize;
+            entry    = malloc (entrycap);
+        }
+
+        if (!entry ||
+            EXR_ERR_SUCCESS != exr_get_index_entry (e, entry, &entrysize))
+        {
+            exr_finish (&e);
+            ++failcount;
+            break;
+        }
+        exr_finish (&e);
+
+        namelen = strlen (files[f]) + 1;
+        if (!write_le (out, namelen, 4) || !write_le (out, 0, 4) ||
+            !write_le (out, entrysize, 8) ||
+            fwrite (files[f], 1, namelen, out) != namelen ||
+            fwrite (entry, 1, entrysize, out) != entrysize ||
+            fwrite (zeros, 1, (8 - (namelen + entrysize) % 8) % 8, out) !=
+                (8 - (namelen + entrysize) % 8) % 8)
+        {
+            fprintf (stderr, "ERROR: unable to write to '%s'\n", indexfn);
+            ++failcount;
+            break;
+        }
+        ++written;
+    }
+
+    if (failcount == 0 &&
+        (fseek (out, 8, SEEK_SET) != 0 || !write_le (out, written, 8)))
+    {
+        fprintf (stderr, "ERROR: unable to write to '%s'\n", indexfn);
+        ++failcount;
+    }
+
+    free (entry);
+    if (fclose (out) != 0) ++failcount;
+    if (failcount) remove (indexfn);
+    return failcount;
+}
+
+static void*
+load_index (const char* indexfn, size_t* size)
+{
+    FILE* in = fopen (indexfn, "rb");
+    void* data;
+    long  len;
+
+    if (!in)
+    {
+        fprintf (stderr, "ERROR: unable to open '%s'\n", indexfn);
+        return NULL;
+    }
+
+    if (fseek (in, 0, SEEK_END) != 0 || (len = ftell (in)) <= 0 ||
+        fseek (in, 0, SEEK_SET) != 0)
+    {
+        fprintf (stderr, "ERROR: unable to read '%s'\n", indexfn);
+        fclose (in);
+        return NULL;
+    }
+
+    data = malloc ((size_t) len);
+    if (data && fread (data, 1, (size_t) len, in) != (size_t) len)
+    {
+        free (data);
+        data = NULL;
+        fprintf (stderr, "ERROR: unable to read '%s'\n", indexfn);
+    }
+    fclose (in);
+    *size = (size_t) len;
+    return data;
+}
+
+static int
+process_index (const char* indexfn, int check)
+{
+    int                       failcount = 0;
+    size_t                    indexsize = 0;
+    void*                     index     = load_index (indexfn, &indexsize);
+    exr_context_initializer_t cinit     = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    exr_result_t              rv        = EXR_ERR_SUCCESS;
+
+    if (!index) return 1;
+
+    cinit.error_handler_fn = &error_handler_cb;
+
+    for (int i = 0; rv == EXR_ERR_SUCCESS; ++i)
+    {
+        const char*   name;
+        const void*   entry;
+        size_t        entrysize;
+        exr_context_t e = NULL;
+        int           parts;
+
+        rv = exr_get_index_entry_by_index (
+            index, indexsize, i, &name, &entry, &entrysize);
+        if (rv == EXR_ERR_ARGUMENT_OUT_OF_RANGE) break;
+        if (rv != EXR_ERR_SUCCESS)
+        {
+            fprintf (
+                stderr,
+                "ERROR '%s' (%s): invalid index\n",
+                indexfn,
+                exr_get_error_code_as_string (rv));
+            ++failcount;
+            break;
+        }
+
+        if (!check)
+        {
+            printf ("%s: %zu bytes\n", name, entrysize);
+            continue;
+        }
+
+        if (EXR_ERR_SUCCESS ==
+                exr_start_read_indexed (&e, name, entry, entrysize, &cinit) &&
+            EXR_ERR_SUCCESS == exr_get_count (e, &parts))
+            printf ("%s: ok, %d part(s)\n", name, parts);
+        else
+        {
+            printf ("%s: stale\n", name);
+            ++failcount;
+        }
+        exr_finish (&e);
+    }
+
+    free (index);
+    return failcount;
+}
+
+int
+main (int argc, const char* argv[])
+{
+    if (argc < 2)
+    {
+        usage (stderr, argv[0], 0);
+        return 1;
+    }
+
+    if (!strcmp (argv[1], "-h") || !strcmp (argv[1], "-?") ||
+        !strcmp (argv[1], "--help"))
+    {
+        usage (stdout, "exrindex", 1);
+        return 0;
+    }
+    else if (!strcmp (argv[1], "--version"))
+    {
+        printf (
+            "exrindex (OpenEXR) %s  https://openexr.com\n",
+            OPENEXR_VERSION_STRING);
+        printf ("Copyright (c) Contributors to the OpenEXR Project\n");
+        printf ("License BSD-3-Clause\n");
+        return 0;
+    }
+    else if (
+        (!strcmp (argv[1], "-o") || !strcmp (argv[1], "--output")) &&
+        argc > 3)
+    {
+        return build_index (argv[2], argc - 3, argv + 3);
+    }
+    else if (
+        (!strcmp (argv[1], "-l") || !strcmp (argv[1], "--list")) && argc == 3)
+    {
+        return process_index (argv[2], 0);
+    }
+    else if (
+        (!strcmp (argv[1], "-c") || !strcmp (argv[1], "--check")) &&
+        argc == 3)
+    {
+        return process_index (argv[2], 1);
+    }
+
+    usage (stderr, argv[0], 0);
+    return 1;
+}
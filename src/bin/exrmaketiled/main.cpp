@@ -14,8 +14,11 @@
 
 #include <ImfHeader.h>
 #include <ImfMisc.h>
+#include <ImfThreading.h>
 #include <OpenEXRConfig.h>
 
+#include <IlmThreadPool.h>
+
 #include <exception>
 #include <iostream>
 #include <sstream>
@@ -25,6 +28,7 @@
 
 #include "namespaceAlias.h"
 using namespace IMF;
+using namespace ILMTHREAD_NAMESPACE;
 using namespace std;
 
 namespace
@@ -82,6 +86,10 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
                "\n"
                "  -v            verbose mode\n"
                "\n"
+               "  --threads n   use n threads to read, resample and write\n"
+               "                the image (default is the number of\n"
+               "                available processors, 0 disables threading)\n"
+               "\n"
                "  -h, --help    print this message\n"
                "\n"
                "      --version print version information\n"
@@ -156,6 +164,7 @@ main (int argc, char** argv)
     Extrapolation     extX    = CLAMP;
     Extrapolation     extY    = CLAMP;
     bool              verbose = false;
+    int               threads = ThreadPool::estimateThreadCountForFileIO ();
 
     //
     // Parse the command line.
@@ -286,6 +295,23 @@ main (int argc, char** argv)
                 verbose = true;
                 i += 1;
             }
+            else if (!strcmp (argv[i], "--threads"))
+            {
+                //
+                // Set number of threads
+                //
+
+                if (i > argc - 2)
+                    throw invalid_argument (
+                        "Missing thread count value with --threads option");
+
+                threads = strtol (argv[i + 1], 0, 0);
+
+                if (threads < 0)
+                    throw invalid_argument ("Thread count cannot be negative");
+
+                i += 2;
+            }
             else if (!strcmp (argv[i], "-p"))
             {
                 getPartNum (argc, argv, i, &partnum);
@@ -360,6 +386,8 @@ main (int argc, char** argv)
                 throw invalid_argument ("Cannot make tile for deep data");
         }
 
+        setGlobalThreadCount (threads);
+
         makeTiled (
             inFile,
             outFile,
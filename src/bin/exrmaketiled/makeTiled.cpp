@@ -25,21 +25,34 @@
 #include "ImfOutputPart.h"
 #include "ImfStandardAttributes.h"
 #include "ImfTiledInputPart.h"
+#include "ImfThreading.h"
 #include "ImfTiledOutputPart.h"
+#include "IlmThreadPool.h"
+#include "forEachRowBand.h"
 
 #include <algorithm>
+#include <exception>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <vector>
 
 #include "namespaceAlias.h"
 using namespace IMF;
 using namespace IMATH_NAMESPACE;
+using namespace ILMTHREAD_NAMESPACE;
 using namespace std;
 
 namespace
 {
 
+//
+// Levels are generated in bands of rows, in parallel
+//
+
+const int ROW_BAND_HEIGHT = 16;
+
 string
 extToString (Extrapolation ext)
 {
@@ -67,158 +80,133 @@ mirror (int x, int w)
     return (d & 1) ? w - 1 - m : m;
 }
 
-template <class T>
-double
-sampleX (
-    const TypedImageChannel<T>& channel,
-    int                         w,
-    double                      x,
-    int                         y,
-    Extrapolation               ext)
-{
-    //
-    // Sample an image channel at location (x, y), where
-    // x is a floating point number, and y is an integer.
-    //
+//
+// The four-tap low-pass filter used to shrink an image level
+// samples the source level at four fractional positions around
+// the center of each destination pixel.  Each sample is a linear
+// interpolation between two neighboring source pixels.  The
+// positions and weights depend only on the destination x (or y)
+// coordinate, so they are computed once per level, not once per
+// pixel and channel.
+//
+// A source index equal to the width (or height) of the source
+// level refers to a black pixel outside the data window, for
+// extrapolation mode BLACK.
+//
 
-    int    xs = IMATH_NAMESPACE::floor (x);
-    int    xt = xs + 1;
-    double s  = xt - x;
-    double t  = 1 - s;
-    double vs = 0.0;
-    double vt = 0.0;
+struct FilterTaps
+{
+    int    i[4][2];
+    double s[4];
+    double t[4];
+};
 
+int
+extrapolate (int i, int n, Extrapolation ext)
+{
     switch (ext)
     {
-        case BLACK:
-
-            vs = (xs >= 0 && xs < w) ? double (channel (xs, y)) : 0.0;
-            vt = (xt >= 0 && xt < w) ? double (channel (xt, y)) : 0.0;
-            break;
-
-        case CLAMP:
-
-            xs = IMATH_NAMESPACE::clamp (xs, 0, w - 1);
-            xt = IMATH_NAMESPACE::clamp (xt, 0, w - 1);
-            vs = channel (xs, y);
-            vt = channel (xt, y);
-            break;
+        case BLACK: return (i >= 0 && i < n) ? i : n;
 
-        case PERIODIC:
+        case CLAMP: return IMATH_NAMESPACE::clamp (i, 0, n - 1);
 
-            xs = modp (xs, w);
-            xt = modp (xt, w);
-            vs = channel (xs, y);
-            vt = channel (xt, y);
-            break;
+        case PERIODIC: return modp (i, n);
 
-        case MIRROR:
-
-            xs = mirror (xs, w);
-            xt = mirror (xt, w);
-            vs = channel (xs, y);
-            vt = channel (xt, y);
-            break;
+        case MIRROR: return mirror (i, n);
     }
 
-    return s * vs + t * vt;
+    return i;
 }
 
-template <class T>
-double
-sampleY (
-    const TypedImageChannel<T>& channel,
-    int                         h,
-    int                         x,
-    double                      y,
-    Extrapolation               ext)
+vector<FilterTaps>
+filterTaps (int n0, int n1, Extrapolation ext)
 {
     //
-    // Sample an image channel at location (x, y), where
-    // x is an integer, and y is a floating point number.
+    // Filter taps for shrinking a row or column of n0 pixels
+    // to n1 pixels.  For pixels 0 and n1 - 1 in the destination,
+    // the filter is centered on pixels 0.5 and n0 - 1.5 in the
+    // source respectively.
     //
 
-    int    ys = IMATH_NAMESPACE::floor (y);
-    int    yt = ys + 1;
-    double s  = yt - y;
-    double t  = 1 - s;
-    double vs = 0.0;
-    double vt = 0.0;
+    double             f = (n1 > 1) ? double (n0 - 2) / (n1 - 1) : 1;
+    vector<FilterTaps> taps (n1);
 
-    switch (ext)
+    for (int j = 0; j < n1; ++j)
     {
-        case BLACK:
-
-            vs = (ys >= 0 && ys < h) ? double (channel (x, ys)) : 0.0;
-            vt = (yt >= 0 && yt < h) ? double (channel (x, yt)) : 0.0;
-            break;
-
-        case CLAMP:
-
-            ys = IMATH_NAMESPACE::clamp (ys, 0, h - 1);
-            yt = IMATH_NAMESPACE::clamp (yt, 0, h - 1);
-            vs = channel (x, ys);
-            vt = channel (x, yt);
-            break;
-
-        case PERIODIC:
-
-            ys = modp (ys, h);
-            yt = modp (yt, h);
-            vs = channel (x, ys);
-            vt = channel (x, yt);
-            break;
-
-        case MIRROR:
+        double c = j * f;
 
-            ys = mirror (ys, h);
-            yt = mirror (yt, h);
-            vs = channel (x, ys);
-            vt = channel (x, yt);
-            break;
+        for (int k = 0; k < 4; ++k)
+        {
+            double x  = c + (k - 1);
+            int    xs = IMATH_NAMESPACE::floor (x);
+            int    xt = xs + 1;
+
+            taps[j].s[k]    = xt - x;
+            taps[j].t[k]    = 1 - taps[j].s[k];
+            taps[j].i[k][0] = extrapolate (xs, n0, ext);
+            taps[j].i[k][1] = extrapolate (xt, n0, ext);
+        }
     }
 
-    return s * vs + t * vt;
+    return taps;
 }
 
 template <class T>
-T
-filterX (
-    const TypedImageChannel<T>& channel,
-    int                         w,
-    double                      x,
-    int                         y,
-    Extrapolation               ext)
+void
+filterRowX (const T* src, T* dst, int w1, const FilterTaps* taps)
 {
     //
-    // Horizontal four-tap filter, centered on pixel (x + 0.5, y)
+    // Horizontal four-tap filter, for one row of pixels
     //
 
-    return T (
-        0.125 * sampleX (channel, w, x - 1, y, ext) +
-        0.375 * sampleX (channel, w, x, y, ext) +
-        0.375 * sampleX (channel, w, x + 1, y, ext) +
-        0.125 * sampleX (channel, w, x + 2, y, ext));
+    for (int x = 0; x < w1; ++x)
+    {
+        const FilterTaps& k = taps[x];
+
+        dst[x] = T (
+            0.125 * (k.s[0] * double (src[k.i[0][0]]) +
+                     k.t[0] * double (src[k.i[0][1]])) +
+            0.375 * (k.s[1] * double (src[k.i[1][0]]) +
+                     k.t[1] * double (src[k.i[1][1]])) +
+            0.375 * (k.s[2] * double (src[k.i[2][0]]) +
+                     k.t[2] * double (src[k.i[2][1]])) +
+            0.125 * (k.s[3] * double (src[k.i[3][0]]) +
+                     k.t[3] * double (src[k.i[3][1]])));
+    }
 }
 
 template <class T>
-T
-filterY (
-    const TypedImageChannel<T>& channel,
-    int                         h,
-    int                         x,
-    double                      y,
-    Extrapolation               ext)
+void
+filterRowY (const T* const src[4][2], T* dst, int w, const FilterTaps& k)
 {
     //
-    // Vertical four-tap filter, centered on pixel (x, y + 0.5)
+    // Vertical four-tap filter, for one row of pixels.
+    // The taps are the same for every pixel in the row,
+    // so the loop reads and writes consecutive pixels.
     //
 
-    return T (
-        0.125 * sampleY (channel, h, x, y - 1, ext) +
-        0.375 * sampleY (channel, h, x, y, ext) +
-        0.375 * sampleY (channel, h, x, y + 1, ext) +
-        0.125 * sampleY (channel, h, x, y + 2, ext));
+    const T* a0 = src[0][0];
+    const T* a1 = src[0][1];
+    const T* b0 = src[1][0];
+    const T* b1 = src[1][1];
+    const T* c0 = src[2][0];
+    const T* c1 = src[2][1];
+    const T* d0 = src[3][0];
+    const T* d1 = src[3][1];
+
+    double as = k.s[0], at = k.t[0];
+    double bs = k.s[1], bt = k.t[1];
+    double cs = k.s[2], ct = k.t[2];
+    double ds = k.s[3], dt = k.t[3];
+
+    for (int x = 0; x < w; ++x)
+    {
+        dst[x] = T (
+            0.125 * (as * double (a0[x]) + at * double (a1[x])) +
+            0.375 * (bs * double (b0[x]) + bt * double (b1[x])) +
+            0.375 * (cs * double (c0[x]) + ct * double (c1[x])) +
+            0.125 * (ds * double (d0[x]) + dt * double (d1[x])));
+    }
 }
 
 template <class T>
@@ -227,32 +215,41 @@ reduceX (
     const TypedImageChannel<T>& channel0,
     TypedImageChannel<T>&       channel1,
     bool                        filter,
-    Extrapolation&              ext,
-    bool                        odd)
+    const vector<FilterTaps>&   taps,
+    bool                        odd,
+    int                         y0,
+    int                         y1)
 {
     //
-    // Shrink an image channel, channel0, horizontally
-    // by a factor of 2, and store the result in channel1.
+    // Shrink rows y0 to y1 - 1 of an image channel, channel0,
+    // horizontally by a factor of 2, and store the result in
+    // channel1.  The data window of channel0 may cover only
+    // some of the rows of channel1.
     //
 
-    int w0 = channel0.image ().width ();
-    int w1 = channel1.image ().width ();
-    int h1 = channel1.image ().height ();
+    const Image& image0 = channel0.image ();
+    const Image& image1 = channel1.image ();
+
+    int w0 = image0.width ();
+    int w1 = image1.width ();
+    int dy = image0.dataWindow ().min.y - image1.dataWindow ().min.y;
 
     if (filter)
     {
         //
-        // Low-pass filter and resample.
-        // For pixels (0, y) and (w1 - 1, y) in channel 1,
-        // the low-pass filter in channel0 is centered on
-        // pixels (0.5, y) and (w0 - 1.5, y) respectively.
+        // Low-pass filter and resample.  Each source row is
+        // copied into a buffer with one extra black pixel at
+        // the end, for taps that fall outside the data window.
         //
 
-        double f = (w1 > 1) ? double (w0 - 2) / (w1 - 1) : 1;
+        vector<T> row (w0 + 1, T (0));
 
-        for (int y = 0; y < h1; ++y)
-            for (int x = 0; x < w1; ++x)
-                channel1 (x, y) = filterX (channel0, w0, x * f, y, ext);
+        for (int y = y0; y < y1; ++y)
+        {
+            const T* src = &channel0 (0, y);
+            copy (src, src + w0, row.begin ());
+            filterRowX (row.data (), &channel1 (0, y + dy), w1, taps.data ());
+        }
     }
     else
     {
@@ -267,9 +264,14 @@ reduceX (
 
         int offset = odd ? ((w0 - 1) - 2 * (w1 - 1)) : 0;
 
-        for (int y = 0; y < h1; ++y)
+        for (int y = y0; y < y1; ++y)
+        {
+            const T* src = &channel0 (offset, y);
+            T*       dst = &channel1 (0, y + dy);
+
             for (int x = 0; x < w1; ++x)
-                channel1 (x, y) = channel0 (2 * x + offset, y);
+                dst[x] = src[2 * x];
+        }
     }
 }
 
@@ -279,12 +281,15 @@ reduceY (
     const TypedImageChannel<T>& channel0,
     TypedImageChannel<T>&       channel1,
     bool                        filter,
-    Extrapolation               ext,
-    bool                        odd)
+    const vector<FilterTaps>&   taps,
+    bool                        odd,
+    int                         y0,
+    int                         y1)
 {
     //
-    // Shrink an image channel, channel0, vertically
-    // by a factor of 2, and store the result in channel1.
+    // Shrink an image channel, channel0, vertically by a
+    // factor of 2, and store rows y0 to y1 - 1 of the result
+    // in channel1.
     //
 
     int w1 = channel1.image ().width ();
@@ -294,17 +299,24 @@ reduceY (
     if (filter)
     {
         //
-        // Low-pass filter and resample.
-        // For pixels (x, 0) and (x, h1 - 1) in channel 1,
-        // the low-pass filter in channel0 is centered on
-        // pixels (x, 0.5) and (x, h0 - 1.5) respectively.
+        // Low-pass filter and resample.  Taps that fall
+        // outside the data window read from a black row.
         //
 
-        double f = (h1 > 1) ? double (h0 - 2) / (h1 - 1) : 1;
+        vector<T> black (w1, T (0));
 
-        for (int y = 0; y < h1; ++y)
-            for (int x = 0; x < w1; ++x)
-                channel1 (x, y) = filterY (channel0, h0, x, y * f, ext);
+        for (int y = y0; y < y1; ++y)
+        {
+            const FilterTaps& k = taps[y];
+            const T*          src[4][2];
+
+            for (int i = 0; i < 4; ++i)
+                for (int j = 0; j < 2; ++j)
+                    src[i][j] = (k.i[i][j] < h0) ? &channel0 (0, k.i[i][j])
+                                                 : black.data ();
+
+            filterRowY (src, &channel1 (0, y), w1, k);
+        }
     }
     else
     {
@@ -319,12 +331,58 @@ reduceY (
 
         int offset = odd ? ((h0 - 1) - 2 * (h1 - 1)) : 0;
 
-        for (int y = 0; y < h1; ++y)
-            for (int x = 0; x < w1; ++x)
-                channel1 (x, y) = channel0 (x, 2 * y + offset);
+        for (int y = y0; y < y1; ++y)
+        {
+            const T* src = &channel0 (0, 2 * y + offset);
+            copy (src, src + w1, &channel1 (0, y));
+        }
     }
 }
 
+template <class T>
+void
+reduceX (
+    const Image&              image0,
+    Image&                    image1,
+    const char*               name,
+    bool                      filter,
+    const vector<FilterTaps>& taps,
+    bool                      odd,
+    int                       y0,
+    int                       y1)
+{
+    reduceX (
+        image0.typedChannel<T> (name),
+        image1.typedChannel<T> (name),
+        filter,
+        taps,
+        odd,
+        y0,
+        y1);
+}
+
+template <class T>
+void
+reduceY (
+    const Image&              image0,
+    Image&                    image1,
+    const char*               name,
+    bool                      filter,
+    const vector<FilterTaps>& taps,
+    bool                      odd,
+    int                       y0,
+    int                       y1)
+{
+    reduceY (
+        image0.typedChannel<T> (name),
+        image1.typedChannel<T> (name),
+        filter,
+        taps,
+        odd,
+        y0,
+        y1);
+}
+
 void
 reduceX (
     const ChannelList& channels,
@@ -336,50 +394,46 @@ reduceX (
 {
     //
     // Shrink image image0 horizontally by a factor of 2,
-    // and store the result in image image1.
+    // and store the result in image image1.  Image0 may
+    // hold only some of the rows of image1.  Bands of rows
+    // are processed in parallel.
     //
 
-    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
-         ++i)
-    {
-        const char*    name    = i.name ();
-        const Channel& channel = i.channel ();
-        bool           filter = (doNotFilter.find (name) == doNotFilter.end ());
+    vector<FilterTaps> taps =
+        filterTaps (image0.width (), image1.width (), ext);
 
-        switch (channel.type)
+    forEachRowBand (image0.height (), ROW_BAND_HEIGHT, [&] (int y0, int y1) {
+        for (ChannelList::ConstIterator i = channels.begin ();
+             i != channels.end ();
+             ++i)
         {
-            case IMF::HALF:
-
-                reduceX (
-                    image0.typedChannel<half> (name),
-                    image1.typedChannel<half> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-
-            case IMF::FLOAT:
-
-                reduceX (
-                    image0.typedChannel<float> (name),
-                    image1.typedChannel<float> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-
-            case IMF::UINT:
-
-                reduceX (
-                    image0.typedChannel<unsigned int> (name),
-                    image1.typedChannel<unsigned int> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-            default: break;
+            const char* name   = i.name ();
+            bool        filter =
+                (doNotFilter.find (name) == doNotFilter.end ());
+
+            switch (i.channel ().type)
+            {
+                case IMF::HALF:
+
+                    reduceX<half> (
+                        image0, image1, name, filter, taps, odd, y0, y1);
+                    break;
+
+                case IMF::FLOAT:
+
+                    reduceX<float> (
+                        image0, image1, name, filter, taps, odd, y0, y1);
+                    break;
+
+                case IMF::UINT:
+
+                    reduceX<unsigned int> (
+                        image0, image1, name, filter, taps, odd, y0, y1);
+                    break;
+                default: break;
+            }
         }
-    }
+    });
 }
 
 void
@@ -393,50 +447,60 @@ reduceY (
 {
     //
     // Shrink image image0 vertically by a factor of 2,
-    // and store the result in image image1.
+    // and store the result in image image1.  Bands of
+    // rows are processed in parallel.
     //
 
-    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
-         ++i)
-    {
-        const char*    name    = i.name ();
-        const Channel& channel = i.channel ();
-        bool           filter = (doNotFilter.find (name) == doNotFilter.end ());
+    vector<FilterTaps> taps =
+        filterTaps (image0.height (), image1.height (), ext);
 
-        switch (channel.type)
+    forEachRowBand (image1.height (), ROW_BAND_HEIGHT, [&] (int y0, int y1) {
+        for (ChannelList::ConstIterator i = channels.begin ();
+             i != channels.end ();
+             ++i)
         {
-            case IMF::HALF:
-
-                reduceY (
-                    image0.typedChannel<half> (name),
-                    image1.typedChannel<half> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-
-            case IMF::FLOAT:
-
-                reduceY (
-                    image0.typedChannel<float> (name),
-                    image1.typedChannel<float> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-
-            case IMF::UINT:
-
-                reduceY (
-                    image0.typedChannel<unsigned int> (name),
-                    image1.typedChannel<unsigned int> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-            default: break;
+            const char* name   = i.name ();
+            bool        filter =
+                (doNotFilter.find (name) == doNotFilter.end ());
+
+            switch (i.channel ().type)
+            {
+                case IMF::HALF:
+
+                    reduceY<half> (
+                        image0, image1, name, filter, taps, odd, y0, y1);
+                    break;
+
+                case IMF::FLOAT:
+
+                    reduceY<float> (
+                        image0, image1, name, filter, taps, odd, y0, y1);
+                    break;
+
+                case IMF::UINT:
+
+                    reduceY<unsigned int> (
+                        image0, image1, name, filter, taps, odd, y0, y1);
+                    break;
+                default: break;
+            }
         }
+    });
+}
+
+FrameBuffer
+frameBuffer (const ChannelList& channels, const Image& image)
+{
+    FrameBuffer fb;
+
+    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
+         ++i)
+    {
+        const char* name = i.name ();
+        fb.insert (name, image.channel (name).slice ());
     }
+
+    return fb;
 }
 
 void
@@ -449,22 +513,56 @@ storeLevel (
 {
     //
     // Store the pixels for level (lx, ly) in output file out.
+    // All tiles are handed to the library at once, so they
+    // are compressed in parallel.
     //
 
-    FrameBuffer fb;
+    out.setFrameBuffer (frameBuffer (channels, image));
+    out.writeTiles (
+        0, out.numXTiles (lx) - 1, 0, out.numYTiles (ly) - 1, lx, ly);
+}
 
-    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
-         ++i)
+void
+storeLevelZero (
+    InputPart&         in,
+    TiledOutputPart&   out,
+    const ChannelList& channels,
+    const set<string>& doNotFilter,
+    Extrapolation      extX,
+    Image&             band,
+    Image*             image1)
+{
+    //
+    // Copy the pixels of the input image to level (0, 0)
+    // of output file out, reading and writing a band of
+    // tile rows at a time, so that the input image is never
+    // held in memory in its entirety.  If image1 is not null,
+    // each band is also shrunk horizontally, and stored in
+    // the corresponding rows of image1.
+    //
+
+    const Box2i& dw       = out.header ().dataWindow ();
+    int          numTiles = out.numYTiles (0);
+    int          tileRows = std::max (globalThreadCount (), 1);
+
+    for (int ty0 = 0; ty0 < numTiles; ty0 += tileRows)
     {
-        const char* name = i.name ();
-        fb.insert (name, image.channel (name).slice ());
-    }
+        int ty1 = std::min (ty0 + tileRows, numTiles) - 1;
+        int y0  = out.dataWindowForTile (0, ty0, 0).min.y;
+        int y1  = out.dataWindowForTile (0, ty1, 0).max.y;
+
+        band.resize (Box2i (V2i (dw.min.x, y0), V2i (dw.max.x, y1)));
 
-    out.setFrameBuffer (fb);
+        FrameBuffer fb = frameBuffer (channels, band);
 
-    for (int y = 0; y < out.numYTiles (ly); ++y)
-        for (int x = 0; x < out.numXTiles (lx); ++x)
-            out.writeTile (x, y, lx, ly);
+        in.setFrameBuffer (fb);
+        in.readPixels (y0, y1);
+
+        out.setFrameBuffer (fb);
+        out.writeTiles (0, out.numXTiles (0) - 1, ty0, ty1, 0);
+
+        if (image1) reduceX (channels, doNotFilter, extX, true, band, *image1);
+    }
 }
 
 } // namespace
@@ -484,15 +582,15 @@ makeTiled (
     Extrapolation      extY,
     bool               verbose)
 {
+    Image          band;
     Image          image0;
     Image          image1;
     Image          image2;
     Header         header;
-    FrameBuffer    fb;
     vector<Header> headers;
 
     //
-    // Load the input image
+    // Read the input file's headers
     //
 
     MultiPartInputFile input (inFileName);
@@ -504,8 +602,7 @@ makeTiled (
 
         if (p == partnum)
         {
-            InputPart in (input, p);
-            header = in.header ();
+            header = input.header (p);
             if (hasEnvmap (header) && mode != ONE_LEVEL)
             {
                 //
@@ -520,8 +617,6 @@ makeTiled (
                     "Use exrenvmap instead.");
             }
 
-            image0.resize (header.dataWindow ());
-
             for (ChannelList::ConstIterator i = header.channels ().begin ();
                  i != header.channels ().end ();
                  ++i)
@@ -536,16 +631,12 @@ makeTiled (
                         "not supported in tiled files.");
                 }
 
+                band.addChannel (name, channel.type);
                 image0.addChannel (name, channel.type);
                 image1.addChannel (name, channel.type);
                 image2.addChannel (name, channel.type);
-                fb.insert (name, image0.channel (name).slice ());
             }
 
-            in.setFrameBuffer (fb);
-            in.readPixels (
-                header.dataWindow ().min.y, header.dataWindow ().max.y);
-
             //
             // Generate the header for the output file by modifying
             // the input file's header
@@ -589,20 +680,55 @@ makeTiled (
         {
             try
             {
+                InputPart       in (input, partnum);
                 TiledOutputPart out (output, partnum);
                 //    TiledOutputFile out (outFileName, header);
 
-                out.setFrameBuffer (fb);
-
                 if (verbose)
                     cout << "writing file " << outFileName
                          << "\n"
                             "level (0, 0)"
                          << endl;
 
-                for (int y = 0; y < out.numYTiles (0); ++y)
-                    for (int x = 0; x < out.numXTiles (0); ++x)
-                        out.writeTile (x, y, 0);
+                if (mode == RIPMAP_LEVELS)
+                {
+                    //
+                    // The vertically reduced levels are computed
+                    // from the whole of level (0, 0).
+                    //
+
+                    image0.resize (header.dataWindow ());
+
+                    in.setFrameBuffer (
+                        frameBuffer (header.channels (), image0));
+                    in.readPixels (
+                        header.dataWindow ().min.y, header.dataWindow ().max.y);
+
+                    storeLevel (out, header.channels (), 0, 0, image0);
+                }
+                else
+                {
+                    //
+                    // Level (0, 0) is read and stored one band at a time.
+                    // For a MIPMAP_LEVELS image, level (1, 1) is computed
+                    // from the horizontally reduced bands, in image1.
+                    //
+
+                    bool reduce = mode == MIPMAP_LEVELS && out.numLevels () > 1;
+
+                    if (reduce) image1.resize (out.dataWindowForLevel (1, 0));
+
+                    storeLevelZero (
+                        in,
+                        out,
+                        header.channels (),
+                        doNotFilter,
+                        extX,
+                        band,
+                        reduce ? &image1 : 0);
+
+                    band.resize (Box2i (V2i (0, 0), V2i (0, 0)));
+                }
 
                 //
                 // If necessary, generate the lower-resolution mipmap
@@ -613,15 +739,18 @@ makeTiled (
                 {
                     for (int l = 1; l < out.numLevels (); ++l)
                     {
-                        image1.resize (out.dataWindowForLevel (l, l - 1));
+                        if (l > 1)
+                        {
+                            image1.resize (out.dataWindowForLevel (l, l - 1));
 
-                        reduceX (
-                            header.channels (),
-                            doNotFilter,
-                            extX,
-                            l & 1,
-                            image0,
-                            image1);
+                            reduceX (
+                                header.channels (),
+                                doNotFilter,
+                                extX,
+                                l & 1,
+                                image0,
+                                image1);
+                        }
 
                         image0.resize (out.dataWindowForLevel (l, l));
 
@@ -13,6 +13,7 @@
 #include <ImfIDManifestAttribute.h>
 #include <ImfStandardAttributes.h>
 
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -31,15 +32,15 @@ using std::to_string;
 using std::vector;
 
 size_t
-dumpManifest (const IDManifest& mfst)
+dumpManifest (const CompactIDManifest& mfst)
 {
 
     size_t uncompressedSize = 0;
 
     for (size_t i = 0; i < mfst.size (); ++i)
     {
-        const IDManifest::ChannelGroupManifest& m     = mfst[i];
-        bool                                    first = true;
+        const CompactIDManifest::ChannelGroup& m     = mfst[i];
+        bool                                   first = true;
         if (i > 0) { cout << "\n\n"; }
         cout << " channels  : ";
         for (set<string>::const_iterator s = m.getChannels ().begin ();
@@ -72,47 +73,45 @@ dumpManifest (const IDManifest& mfst)
         // compute max field sizes
         //
         size_t         maxNumLen = 0;
-        vector<size_t> componentLength (m.getComponents ().size ());
-        for (size_t c = 0; c < m.getComponents ().size (); ++c)
+        size_t         components = m.getComponents ().size ();
+        vector<size_t> componentLength (components);
+        for (size_t c = 0; c < components; ++c)
         {
             size_t componentSize = m.getComponents ()[c].size ();
             uncompressedSize += componentSize + 1;
             componentLength[c] = max (componentLength[c], componentSize);
         }
-        for (IDManifest::ChannelGroupManifest::ConstIterator q = m.begin ();
-             q != m.end ();
-             ++q)
+        for (size_t e = 0; e < m.size (); ++e)
         {
 
-            size_t stringLen = to_string (q.id ()).size ();
+            size_t stringLen = to_string (m.id (e)).size ();
             uncompressedSize += stringLen;
             maxNumLen = max (maxNumLen, stringLen);
 
-            for (size_t i = 0; i < q.text ().size (); i++)
+            for (size_t c = 0; c < components; c++)
             {
-                uncompressedSize += q.text ()[i].size () + 1;
-                componentLength[i] =
-                    max (componentLength[i], q.text ()[i].size ());
+                uncompressedSize += m.textLength (e, c) + 1;
+                componentLength[c] =
+                    max (componentLength[c], m.textLength (e, c));
             }
         }
 
         cout << "     " << string (maxNumLen + 1, ' ');
-        for (size_t c = 0; c < m.getComponents ().size (); ++c)
+        for (size_t c = 0; c < components; ++c)
         {
             string s = m.getComponents ()[c];
             cout << s << string (componentLength[c] + 1 - s.size (), ' ');
         }
         cout << endl;
-        for (IDManifest::ChannelGroupManifest::ConstIterator q = m.begin ();
-             q != m.end ();
-             ++q)
+        for (size_t e = 0; e < m.size (); ++e)
         {
-            string id = to_string (q.id ());
+            string id = to_string (m.id (e));
             cout << "     " << id << string (maxNumLen + 1 - id.size (), ' ');
-            for (size_t i = 0; i < q.text ().size (); i++)
+            for (size_t c = 0; c < components; c++)
             {
-                string s = q.text ()[i];
-                cout << s << string (componentLength[i] + 1 - s.size (), ' ');
+                size_t length = m.textLength (e, c);
+                cout.write (m.text (e, c), length);
+                cout << string (componentLength[c] + 1 - length, ' ');
             }
             cout << '\n';
         }
@@ -121,8 +120,45 @@ dumpManifest (const IDManifest& mfst)
     return uncompressedSize;
 }
 
+//
+// print the entries for the given IDs only. The manifest is indexed
+// rather than decoded, so this is cheap even for very large manifests
+//
 void
-printManifest (const char fileName[])
+lookupManifest (const LazyIDManifest& mfst, const vector<uint64_t>& ids)
+{
+    vector<string> text;
+    for (size_t i = 0; i < ids.size (); ++i)
+    {
+        bool found = false;
+        for (size_t g = 0; g < mfst.size (); ++g)
+        {
+            if (!mfst.lookup (g, ids[i], text)) { continue; }
+            found = true;
+
+            cout << "     " << ids[i] << ' ';
+            bool first = true;
+            for (set<string>::const_iterator s =
+                     mfst[g].getChannels ().begin ();
+                 s != mfst[g].getChannels ().end ();
+                 ++s)
+            {
+                if (!first) { cout << ','; }
+                else { first = false; }
+                cout << *s;
+            }
+            for (size_t c = 0; c < text.size (); ++c)
+            {
+                cout << ' ' << mfst[g].getComponents ()[c] << '=' << text[c];
+            }
+            cout << '\n';
+        }
+        if (!found) { cout << "     " << ids[i] << " not found\n"; }
+    }
+}
+
+void
+printManifest (const char fileName[], const vector<uint64_t>& ids)
 {
 
     MultiPartInputFile in (fileName);
@@ -137,7 +173,12 @@ printManifest (const char fileName[])
         {
             const OPENEXR_IMF_NAMESPACE::CompressedIDManifest& mfst =
                 idManifest (in.header (part));
-            size_t size = dumpManifest (mfst);
+            if (!ids.empty ())
+            {
+                lookupManifest (LazyIDManifest (mfst), ids);
+                continue;
+            }
+            size_t size = dumpManifest (CompactIDManifest (mfst));
             cout << "raw text size    : " << size << endl;
             cout << "uncompressed size: " << mfst._uncompressedDataSize << endl;
             cout << "compressed size  : " << mfst._compressedDataSize << endl;
@@ -149,7 +190,8 @@ printManifest (const char fileName[])
 void
 usageMessage (ostream& stream, const char* program_name, bool verbose = false)
 {
-    stream << "Usage: " << program_name << " imagefile [imagefile ...]\n";
+    stream << "Usage: " << program_name
+           << " [options] imagefile [imagefile ...]\n";
 
     if (verbose)
         stream
@@ -157,6 +199,9 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
                "Read exr files and print the contents of the embedded manifest.\n"
                "\n"
                "Options:\n"
+               "  -i, --id id       only print the entries for the given\n"
+               "                    ID, looked up without decoding the\n"
+               "                    whole manifest. May be repeated\n"
                "  -h, --help        print this message\n"
                "      --version     print version information\n"
                "\n"
@@ -174,6 +219,9 @@ main (int argc, char* argv[])
         return -1;
     }
 
+    vector<const char*> files;
+    vector<uint64_t>    ids;
+
     for (int i = 1; i < argc; ++i)
     {
         if (!strcmp (argv[i], "-h") || !strcmp (argv[1], "--help"))
@@ -193,18 +241,36 @@ main (int argc, char* argv[])
             cout << "License BSD-3-Clause" << endl;
             return 0;
         }
+        else if (!strcmp (argv[i], "-i") || !strcmp (argv[i], "--id"))
+        {
+            char* end = nullptr;
+            if (i + 1 < argc)
+                ids.push_back (strtoull (argv[i + 1], &end, 10));
+            if (!end || end == argv[i + 1] || *end != '\0')
+            {
+                cerr << argv[0] << ": " << argv[i]
+                     << " requires a numeric ID" << endl;
+                return 1;
+            }
+            ++i;
+        }
+        else { files.push_back (argv[i]); }
+    }
+
+    if (files.empty ())
+    {
+        usageMessage (cerr, argv[0], false);
+        return -1;
     }
 
     try
     {
-        for (int i = 1; i < argc; ++i)
-            printManifest (argv[i]);
+        for (size_t i = 0; i < files.size (); ++i)
+            printManifest (files[i], ids);
     }
     catch (const exception& e)
     {
         cerr << argv[0] << ": " << e.what () << endl;
         return 1;
     }
-
-    for (int i = 1; i < argc; ++i) {}
 }
@@ -10,10 +10,6 @@
 //-----------------------------------------------------------------------------
 
 #include <ImfChannelList.h>
-#include <ImfDeepScanLineInputPart.h>
-#include <ImfDeepScanLineOutputPart.h>
-#include <ImfDeepTiledInputPart.h>
-#include <ImfDeepTiledOutputPart.h>
 #include <ImfInputPart.h>
 #include <ImfMultiPartInputFile.h>
 #include <ImfMultiPartOutputFile.h>
@@ -21,18 +17,20 @@
 #include <ImfPartHelper.h>
 #include <ImfPartType.h>
 #include <ImfStringAttribute.h>
-#include <ImfTiledInputPart.h>
-#include <ImfTiledOutputPart.h>
 #include <ImfMisc.h>
+#include <ImfStandardAttributes.h>
 #include <OpenEXRConfig.h>
 
 #include <Iex.h>
 #include <OpenEXRConfig.h>
 
+#include <openexr.h>
+
 #include <algorithm>
 #include <assert.h>
 #include <cctype>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <stdlib.h>
 #include <utility> // pair
@@ -52,55 +50,175 @@ using namespace OPENEXR_IMF_NAMESPACE;
 #endif
 
 void
-copy_tile (
-    MultiPartInputFile&  input,
-    MultiPartOutputFile& output,
-    int                  inPart,
-    int                  outPart)
+core_check (exr_result_t rv, const char* what, const string& filename)
 {
-    TiledInputPart  in (input, inPart);
-    TiledOutputPart out (output, outPart);
-
-    out.copyPixels (in);
+    if (rv != EXR_ERR_SUCCESS)
+    {
+        std::stringstream e;
+        e << "Unable to " << what << " '" << filename
+          << "': " << exr_get_error_code_as_string (rv);
+        throw runtime_error (e.str ());
+    }
 }
 
 void
-copy_tiledeep (
-    MultiPartInputFile&  input,
-    MultiPartOutputFile& output,
-    int                  inPart,
-    int                  outPart)
+print_part_type (int p, exr_storage_t storage)
 {
-    DeepTiledInputPart  in (input, inPart);
-    DeepTiledOutputPart out (output, outPart);
-
-    out.copyPixels (in);
+    cout << "part " << p << ": ";
+    switch (storage)
+    {
+        case EXR_STORAGE_SCANLINE: cout << "scanlineimage"; break;
+        case EXR_STORAGE_TILED: cout << "tiledimage"; break;
+        case EXR_STORAGE_DEEP_SCANLINE: cout << "deepscanlineimage"; break;
+        case EXR_STORAGE_DEEP_TILED: cout << "deeptile"; break;
+        default: cout << "unknown"; break;
+    }
+    cout << endl;
 }
 
+//
+// write the output file with the OpenEXRCore API, copying the packed
+// chunks of each part straight from the input files with
+// exr_copy_chunks: the pixel data is never decompressed or
+// recompressed. headers[p] provides the part name and view, and the
+// shared attributes (taken from headers[0] when overriding); the
+// remaining attributes are copied from the input part
+//
+
 void
-copy_scanline (
-    MultiPartInputFile&  input,
-    MultiPartOutputFile& output,
-    int                  inPart,
-    int                  outPart)
+copy_parts (
+    const char*           outname,
+    const vector<string>& filenames,
+    const vector<int>&    partnums,
+    const vector<Header>& headers,
+    bool                  override)
 {
-    InputPart  in (input, inPart);
-    OutputPart out (output, outPart);
+    map<string, exr_context_t> inputs;
+    exr_context_t              out = nullptr;
 
-    out.copyPixels (in);
-}
+    try
+    {
+        for (size_t p = 0; p < partnums.size (); p++)
+        {
+            exr_context_t& in = inputs[filenames[p]];
+            if (!in)
+                core_check (
+                    exr_start_read (&in, filenames[p].c_str (), nullptr),
+                    "open",
+                    filenames[p]);
+        }
 
-void
-copy_scanlinedeep (
-    MultiPartInputFile&  input,
-    MultiPartOutputFile& output,
-    int                  inPart,
-    int                  outPart)
-{
-    DeepScanLineInputPart  in (input, inPart);
-    DeepScanLineOutputPart out (output, outPart);
+        core_check (
+            exr_start_write (&out, outname, EXR_WRITE_FILE_DIRECTLY, nullptr),
+            "create",
+            outname);
+
+        for (size_t p = 0; p < partnums.size (); p++)
+        {
+            exr_context_t in = inputs[filenames[p]];
+            const Header& h  = headers[p];
+            const Header& sh = override ? headers[0] : headers[p];
+
+            exr_storage_t storage;
+            int           idx;
+
+            core_check (
+                exr_get_storage (in, partnums[p], &storage),
+                "read",
+                filenames[p]);
+            core_check (
+                exr_add_part (
+                    out,
+                    h.hasName () ? h.name ().c_str () : nullptr,
+                    storage,
+                    &idx),
+                "add part to",
+                outname);
+
+            if (h.hasView ())
+                core_check (
+                    exr_attr_set_string (out, idx, "view", h.view ().c_str ()),
+                    "set view in",
+                    outname);
+
+            exr_attr_box2i_t dispwin;
+            dispwin.min.x = sh.displayWindow ().min.x;
+            dispwin.min.y = sh.displayWindow ().min.y;
+            dispwin.max.x = sh.displayWindow ().max.x;
+            dispwin.max.y = sh.displayWindow ().max.y;
+            core_check (
+                exr_set_display_window (out, idx, &dispwin),
+                "set display window in",
+                outname);
+            core_check (
+                exr_set_pixel_aspect_ratio (out, idx, sh.pixelAspectRatio ()),
+                "set pixel aspect ratio in",
+                outname);
+
+            if (override && hasTimeCode (sh))
+            {
+                exr_attr_timecode_t tc;
+                tc.time_and_flags = timeCode (sh).timeAndFlags ();
+                tc.user_data      = timeCode (sh).userData ();
+                core_check (
+                    exr_attr_set_timecode (out, idx, "timeCode", &tc),
+                    "set time code in",
+                    outname);
+            }
+
+            if (override && hasChromaticities (sh))
+            {
+                const Chromaticities&     c = chromaticities (sh);
+                exr_attr_chromaticities_t chroma;
+                chroma.red_x   = c.red.x;
+                chroma.red_y   = c.red.y;
+                chroma.green_x = c.green.x;
+                chroma.green_y = c.green.y;
+                chroma.blue_x  = c.blue.x;
+                chroma.blue_y  = c.blue.y;
+                chroma.white_x = c.white.x;
+                chroma.white_y = c.white.y;
+                core_check (
+                    exr_attr_set_chromaticities (
+                        out, idx, "chromaticities", &chroma),
+                    "set chromaticities in",
+                    outname);
+            }
+
+            core_check (
+                exr_copy_unset_attributes (out, idx, in, partnums[p]),
+                "copy header to",
+                outname);
+        }
+
+        core_check (exr_write_header (out), "write header to", outname);
+
+        for (size_t p = 0; p < partnums.size (); p++)
+        {
+            exr_context_t in = inputs[filenames[p]];
+            exr_storage_t storage;
 
-    out.copyPixels (in);
+            exr_get_storage (in, partnums[p], &storage);
+            print_part_type (static_cast<int> (p), storage);
+
+            core_check (
+                exr_copy_chunks (out, static_cast<int> (p), in, partnums[p]),
+                "copy pixel data to",
+                outname);
+        }
+
+        core_check (exr_finish (&out), "finish writing", outname);
+    }
+    catch (...)
+    {
+        if (out) exr_finish (&out);
+        for (auto& in: inputs)
+            if (in.second) exr_finish (&in.second);
+        throw;
+    }
+
+    for (auto& in: inputs)
+        exr_finish (&in.second);
 }
 
 bool
@@ -383,6 +501,7 @@ combine (
     MultiPartInputFile*         infile;
     vector<Header>              headers;
     vector<string>              fornamecheck;
+    vector<string>              filenames;
 
     //
     // parse all inputs
@@ -422,6 +541,7 @@ combine (
                     headers[headers.size () - 1].setView (views[i]);
 
                 partnums.push_back (j);
+                filenames.push_back (filename);
             }
         } // no user parts specified
         else
@@ -450,6 +570,7 @@ combine (
                 headers[headers.size () - 1].setView (views[i]);
 
             partnums.push_back (partnum);
+            filenames.push_back (filename);
         } // user parts specified
     }
 
@@ -463,38 +584,11 @@ combine (
     // do combine
     //
 
-    // early bail if need be
-    MultiPartOutputFile temp (outname, &headers[0], headers.size (), override);
-
-    MultiPartOutputFile out (outname, &headers[0], headers.size (), override);
-
-    for (size_t p = 0; p < partnums.size (); p++)
+    // early bail if need be: the library validates the part names
+    // and shared attributes of the headers
     {
-        std::string type = headers[p].type ();
-        if (type == SCANLINEIMAGE)
-        {
-            cout << "part " << p << ": "
-                 << "scanlineimage" << endl;
-            copy_scanline (*inputs[p], out, partnums[p], p);
-        }
-        else if (type == TILEDIMAGE)
-        {
-            cout << "part " << p << ": "
-                 << "tiledimage" << endl;
-            copy_tile (*inputs[p], out, partnums[p], p);
-        }
-        else if (type == DEEPSCANLINE)
-        {
-            cout << "part " << p << ": "
-                 << "deepscanlineimage" << endl;
-            copy_scanlinedeep (*inputs[p], out, partnums[p], p);
-        }
-        else if (type == DEEPTILE)
-        {
-            cout << "part " << p << ": "
-                 << "deeptile" << endl;
-            copy_tiledeep (*inputs[p], out, partnums[p], p);
-        }
+        MultiPartOutputFile temp (
+            outname, &headers[0], headers.size (), override);
     }
 
     for (size_t k = 0; k < fordelete.size (); k++)
@@ -504,6 +598,8 @@ combine (
 
     inputs.clear ();
 
+    copy_parts (outname, filenames, partnums, headers, override);
+
     cout << "\n"
          << "Combine Success" << endl;
 }
@@ -552,32 +648,14 @@ separate (vector<const char*> in, const char* out, bool override)
     //
     for (int p = 0; p < numOutputs; p++)
     {
-        Header header = inputimage->header (p);
-
-        MultiPartOutputFile out (
-            fornamecheck[p].c_str (), &header, 1, override);
-
-        std::string type = header.type ();
-        if (type == "scanlineimage")
-        {
-            cout << "scanlineimage" << endl;
-            copy_scanline (*inputimage, out, p, 0);
-        }
-        else if (type == "tiledimage")
-        {
-            cout << "tiledimage" << endl;
-            copy_tile (*inputimage, out, p, 0);
-        }
-        else if (type == "deepscanline")
-        {
-            cout << "deepscanline" << endl;
-            copy_scanlinedeep (*inputimage, out, p, 0);
-        }
-        else if (type == "deeptile")
-        {
-            cout << "deeptile" << endl;
-            copy_tiledeep (*inputimage, out, p, 0);
-        }
+        vector<Header> header (1, inputimage->header (p));
+
+        copy_parts (
+            fornamecheck[p].c_str (),
+            vector<string> (1, filename),
+            vector<int> (1, p),
+            header,
+            override);
     }
 
     delete inputimage;
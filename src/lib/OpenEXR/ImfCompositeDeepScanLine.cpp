@@ -286,132 +286,164 @@ CompositeDeepScanLine::setFrameBuffer (const FrameBuffer& fr)
 namespace
 {
 
+//
+// an output slice, resolved once per readPixels() call so the
+// per-pixel loop doesn't walk the FrameBuffer map
+//
+
+struct OutputSlice
+{
+    PixelType type;
+    intptr_t  base;
+    size_t    xStride;
+    size_t    yStride;
+    int       channel; // index into the composited pixel
+};
+
 class LineCompositeTask : public Task
 {
 public:
     LineCompositeTask (
         TaskGroup*                      group,
         CompositeDeepScanLine::Data*    data,
-        int                             y,
+        int                             y0,
+        int                             y1,
         int                             start,
         vector<const char*>*            names,
         vector<vector<vector<float*>>>* pointers,
         vector<unsigned int>*           total_sizes,
-        vector<unsigned int>*           num_sources)
+        vector<unsigned int>*           num_sources,
+        vector<OutputSlice>*            slices)
         : Task (group)
         , _Data (data)
-        , _y (y)
+        , _y0 (y0)
+        , _y1 (y1)
         , _start (start)
         , _names (names)
         , _pointers (pointers)
         , _total_sizes (total_sizes)
         , _num_sources (num_sources)
+        , _slices (slices)
     {}
 
     virtual ~LineCompositeTask () {}
 
     virtual void                    execute ();
     CompositeDeepScanLine::Data*    _Data;
-    int                             _y;
+    int                             _y0;
+    int                             _y1;
     int                             _start;
     vector<const char*>*            _names;
     vector<vector<vector<float*>>>* _pointers;
     vector<unsigned int>*           _total_sizes;
     vector<unsigned int>*           _num_sources;
+    vector<OutputSlice>*            _slices;
 };
 
+//
+// composite scanlines y0 to y1 inclusive; the scratch pixel and input
+// pointers are shared by every pixel of the block
+//
+
 void
-composite_line (
-    int                                   y,
+composite_lines (
+    int                                   y0,
+    int                                   y1,
     int                                   start,
     CompositeDeepScanLine::Data*          _Data,
     vector<const char*>&                  names,
     const vector<vector<vector<float*>>>& pointers,
     const vector<unsigned int>&           total_sizes,
-    const vector<unsigned int>&           num_sources)
+    const vector<unsigned int>&           num_sources,
+    const vector<OutputSlice>&            slices)
 {
     vector<float> output_pixel (names.size ()); //the pixel we'll output to
     vector<const float*> inputs (names.size ());
     DeepCompositing      d; // fallback compositing engine
     DeepCompositing*     comp = _Data->_comp ? _Data->_comp : &d;
 
-    int pixel =
-        (y - start) * (_Data->_dataWindow.max.x + 1 - _Data->_dataWindow.min.x);
+    const int num_channels = static_cast<int> (names.size ());
+    const int width = _Data->_dataWindow.max.x + 1 - _Data->_dataWindow.min.x;
 
-    for (int x = _Data->_dataWindow.min.x; x <= _Data->_dataWindow.max.x; x++)
+    for (int y = y0; y <= y1; y++)
     {
-        // set inputs[] to point to the first sample of the first part of each channel
-        // if there's a zback, set all channel independently...
+        int pixel = (y - start) * width;
 
-        if (_Data->_zback)
+        for (int x = _Data->_dataWindow.min.x; x <= _Data->_dataWindow.max.x;
+             x++)
         {
+            // set inputs[] to point to the first sample of the first part of each channel
+            // if there's a zback, set all channel independently...
 
-            for (size_t channel = 0; channel < names.size (); channel++)
+            if (_Data->_zback)
             {
-                inputs[channel] = pointers[0][channel][pixel];
+
+                for (int channel = 0; channel < num_channels; channel++)
+                {
+                    inputs[channel] = pointers[0][channel][pixel];
+                }
             }
-        }
-        else
-        {
+            else
+            {
 
-            // otherwise, set 0 and 1 to point to Z
+                // otherwise, set 0 and 1 to point to Z
 
-            inputs[0] = pointers[0][0][pixel];
-            inputs[1] = pointers[0][0][pixel];
-            for (size_t channel = 2; channel < names.size (); channel++)
-            {
-                inputs[channel] = pointers[0][channel][pixel];
+                inputs[0] = pointers[0][0][pixel];
+                inputs[1] = pointers[0][0][pixel];
+                for (int channel = 2; channel < num_channels; channel++)
+                {
+                    inputs[channel] = pointers[0][channel][pixel];
+                }
             }
-        }
-        comp->composite_pixel (
-            &output_pixel[0],
-            &inputs[0],
-            &names[0],
-            static_cast<int> (names.size ()),
-            total_sizes[pixel],
-            num_sources[pixel]);
-
-        size_t channel_number = 0;
+            comp->composite_pixel (
+                &output_pixel[0],
+                &inputs[0],
+                &names[0],
+                num_channels,
+                total_sizes[pixel],
+                num_sources[pixel]);
 
-        //
-        // write out composited value into internal frame buffer
-        //
-        for (FrameBuffer::Iterator it = _Data->_outputFrameBuffer.begin ();
-             it != _Data->_outputFrameBuffer.end ();
-             it++)
-        {
+            //
+            // write out composited value into internal frame buffer
+            //
+            for (size_t i = 0; i < slices.size (); i++)
+            {
+                const OutputSlice& slice = slices[i];
 
-            float value = output_pixel
-                [_Data->_bufferMap[channel_number]]; // value to write
-            intptr_t base = reinterpret_cast<intptr_t> (it.slice ().base);
+                float value = output_pixel[slice.channel]; // value to write
+                intptr_t addr =
+                    slice.base + y * slice.yStride + x * slice.xStride;
 
-            // cast to half float if necessary
-            if (it.slice ().type == OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT)
-            {
-                float* ptr = reinterpret_cast<float*> (
-                    base + y * it.slice ().yStride + x * it.slice ().xStride);
-                *ptr = value;
-            }
-            else if (it.slice ().type == HALF)
-            {
-                half* ptr = reinterpret_cast<half*> (
-                    base + y * it.slice ().yStride + x * it.slice ().xStride);
-                *ptr = half (value);
+                // cast to half float if necessary
+                if (slice.type == OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT)
+                {
+                    *reinterpret_cast<float*> (addr) = value;
+                }
+                else if (slice.type == HALF)
+                {
+                    *reinterpret_cast<half*> (addr) = half (value);
+                }
             }
 
-            channel_number++;
-        }
+            pixel++;
 
-        pixel++;
-
-    } // next pixel on row
+        } // next pixel on row
+    }     // next row
 }
 
 void
 LineCompositeTask::execute ()
 {
-    composite_line (
-        _y, _start, _Data, *_names, *_pointers, *_total_sizes, *_num_sources);
+    composite_lines (
+        _y0,
+        _y1,
+        _start,
+        _Data,
+        *_names,
+        *_pointers,
+        *_total_sizes,
+        *_num_sources,
+        *_slices);
 }
 
 } // namespace
@@ -591,19 +623,57 @@ CompositeDeepScanLine::readPixels (int start, int end)
     if (!_Data->_zback)
         names[1] = names[0]; // no zback channel, so make it point to z
 
+    //
+    // resolve the output slices once, rather than per pixel
+    //
+
+    vector<OutputSlice> slices;
+    {
+        size_t channel_number = 0;
+        for (FrameBuffer::Iterator it = _Data->_outputFrameBuffer.begin ();
+             it != _Data->_outputFrameBuffer.end ();
+             it++)
+        {
+            OutputSlice slice;
+            slice.type    = it.slice ().type;
+            slice.base    = reinterpret_cast<intptr_t> (it.slice ().base);
+            slice.xStride = it.slice ().xStride;
+            slice.yStride = it.slice ().yStride;
+            slice.channel = _Data->_bufferMap[channel_number];
+            slices.push_back (slice);
+            channel_number++;
+        }
+    }
+
+    //
+    // composite in blocks of scanlines: enough blocks to balance the
+    // load across the pool, without paying a task per scanline
+    //
+
+    int lines       = end - start + 1;
+    int threads     = ThreadPool::globalThreadPool ().numThreads ();
+    int blocks      = threads > 1 ? threads * 4 : 1;
+    int block_lines = (lines + blocks - 1) / blocks;
+    if (block_lines < 1) block_lines = 1;
+
     TaskGroup g;
-    for (int y = start; y <= end; y++)
+    for (int y = start; y <= end; y += block_lines)
     {
+        int y1 = y + block_lines - 1;
+        if (y1 > end) y1 = end;
+
         ThreadPool::addGlobalTask (new LineCompositeTask (
             &g,
             _Data,
             y,
+            y1,
             start,
             &names,
             &pointers,
             &total_sizes,
-            &num_sources));
-    } //next row
+            &num_sources,
+            &slices));
+    } //next block
 }
 
 const FrameBuffer&
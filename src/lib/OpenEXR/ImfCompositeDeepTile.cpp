@@ -0,0 +1,723 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#include "ImfCompositeDeepTile.h"
+#include "IlmThreadPool.h"
+#include "ImfChannelList.h"
+#include "ImfDeepCompositing.h"
+#include "ImfDeepFrameBuffer.h"
+#include "ImfDeepTiledInputFile.h"
+#include "ImfDeepTiledInputPart.h"
+#include "ImfFrameBuffer.h"
+#include "ImfPixelType.h"
+
+#include <Iex.h>
+#include <algorithm>
+#include <stddef.h>
+#include <vector>
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
+using IMATH_NAMESPACE::Box2i;
+using std::string;
+using std::vector;
+
+namespace
+{
+
+//
+// a deep tiled source: either a file or a part, kept in the order
+// they were added so samples are composited in a predictable order
+//
+
+struct Source
+{
+    DeepTiledInputFile* file;
+    DeepTiledInputPart* part;
+
+    Box2i dataWindowForTile (int dx, int dy, int lx, int ly) const
+    {
+        return file ? file->dataWindowForTile (dx, dy, lx, ly)
+                    : part->dataWindowForTile (dx, dy, lx, ly);
+    }
+
+    void setFrameBuffer (const DeepFrameBuffer& buf) const
+    {
+        if (file)
+            file->setFrameBuffer (buf);
+        else
+            part->setFrameBuffer (buf);
+    }
+
+    void readPixelSampleCounts (int dx1, int dx2, int dy, int lx, int ly) const
+    {
+        if (file)
+            file->readPixelSampleCounts (dx1, dx2, dy, dy, lx, ly);
+        else
+            part->readPixelSampleCounts (dx1, dx2, dy, dy, lx, ly);
+    }
+
+    void readTiles (int dx1, int dx2, int dy, int lx, int ly) const
+    {
+        if (file)
+            file->readTiles (dx1, dx2, dy, dy, lx, ly);
+        else
+            part->readTiles (dx1, dx2, dy, dy, lx, ly);
+    }
+};
+
+//
+// an output slice, resolved once per row of tiles
+//
+
+struct OutputSlice
+{
+    PixelType type;
+    intptr_t  base;
+    size_t    xStride;
+    size_t    yStride;
+    bool      xTileCoords;
+    bool      yTileCoords;
+    int       channel; // index into the composited pixel
+};
+
+int64_t maximumSampleCount = 0;
+
+} // namespace
+
+struct CompositeDeepTile::Data
+{
+public:
+    vector<Source>   _sources;           // files and parts, in order added
+    FrameBuffer      _outputFrameBuffer; // output frame buffer provided
+    bool _zback; // true if we are using zback (otherwise channel 1 = channel 0)
+    Box2i            _dataWindow;      // data window shared by all sources
+    TileDescription  _tileDescription; // tiling shared by all sources
+    DeepCompositing* _comp;            // user-provided compositor
+    vector<string>   _channels;        // names of channels that will be composited
+    vector<int>
+        _bufferMap; // entry _outputFrameBuffer[n].name() == _channels[ _bufferMap[n] ].name()
+
+    void check_valid (
+        const Header&
+            header); // check newly added part/file is OK; on first good call, set _zback/_dataWindow
+
+    //
+    // set up the given deep frame buffer to contain the required channels
+    // for the pixels of region
+    //
+
+    void handleDeepFrameBuffer (
+        DeepFrameBuffer&      buf,
+        vector<unsigned int>& counts, //per-pixel counts
+        vector<vector<float*>>&
+                     pointers, //per-channel-per-pixel pointers to data
+        const Box2i& region);
+
+    //
+    // read and composite tiles dx1 to dx2 of tile row dy
+    //
+
+    void readTileRow (int dx1, int dx2, int dy, int lx, int ly);
+
+    Data ();
+};
+
+CompositeDeepTile::Data::Data () : _zback (false), _comp (NULL)
+{}
+
+CompositeDeepTile::CompositeDeepTile () : _Data (new Data)
+{}
+
+CompositeDeepTile::~CompositeDeepTile ()
+{
+    delete _Data;
+}
+
+void
+CompositeDeepTile::addSource (DeepTiledInputPart* part)
+{
+    _Data->check_valid (part->header ());
+    Source s = {NULL, part};
+    _Data->_sources.push_back (s);
+}
+
+void
+CompositeDeepTile::addSource (DeepTiledInputFile* file)
+{
+    _Data->check_valid (file->header ());
+    Source s = {file, NULL};
+    _Data->_sources.push_back (s);
+}
+
+int
+CompositeDeepTile::sources () const
+{
+    return int (_Data->_sources.size ());
+}
+
+void
+CompositeDeepTile::Data::check_valid (const Header& header)
+{
+
+    bool has_z     = false;
+    bool has_alpha = false;
+    // check good channel names
+    for (ChannelList::ConstIterator i = header.channels ().begin ();
+         i != header.channels ().end ();
+         ++i)
+    {
+        std::string n (i.name ());
+        if (n == "ZBack") { _zback = true; }
+        else if (n == "Z") { has_z = true; }
+        else if (n == "A") { has_alpha = true; }
+    }
+
+    if (!has_z)
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Deep data provided to CompositeDeepTile is missing a Z channel");
+    }
+
+    if (!has_alpha)
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Deep data provided to CompositeDeepTile is missing an alpha channel");
+    }
+
+    if (_sources.size () == 0)
+    {
+        // first in - update and return
+
+        _dataWindow      = header.dataWindow ();
+        _tileDescription = header.tileDescription ();
+
+        return;
+    }
+
+    //
+    // tiles are composited one against another, so the tile grids
+    // of all sources must line up exactly
+    //
+
+    if (_dataWindow != header.dataWindow ())
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Deep data provided to CompositeDeepTile has a different dataWindow to previously provided data");
+    }
+
+    if (!(_tileDescription == header.tileDescription ()))
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Deep data provided to CompositeDeepTile has a different tile description to previously provided data");
+    }
+}
+
+void
+CompositeDeepTile::Data::handleDeepFrameBuffer (
+    DeepFrameBuffer&             buf,
+    std::vector<unsigned int>&   counts,
+    vector<std::vector<float*>>& pointers,
+    const Box2i&                 region)
+{
+    ptrdiff_t width      = region.size ().x + 1;
+    size_t    pixelcount = width * (region.size ().y + 1);
+    ptrdiff_t origin     = region.min.x + region.min.y * width;
+
+    pointers.resize (_channels.size ());
+    counts.resize (pixelcount);
+    buf.insertSampleCountSlice (Slice (
+        OPENEXR_IMF_INTERNAL_NAMESPACE::UINT,
+        (char*) (&counts[0] - origin),
+        sizeof (unsigned int),
+        sizeof (unsigned int) * width));
+
+    pointers[0].resize (pixelcount);
+    buf.insert (
+        "Z",
+        DeepSlice (
+            OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT,
+            (char*) (&pointers[0][0] - origin),
+            sizeof (float*),
+            sizeof (float*) * width,
+            sizeof (float)));
+
+    if (_zback)
+    {
+        pointers[1].resize (pixelcount);
+        buf.insert (
+            "ZBack",
+            DeepSlice (
+                OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT,
+                (char*) (&pointers[1][0] - origin),
+                sizeof (float*),
+                sizeof (float*) * width,
+                sizeof (float)));
+    }
+
+    pointers[2].resize (pixelcount);
+    buf.insert (
+        "A",
+        DeepSlice (
+            OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT,
+            (char*) (&pointers[2][0] - origin),
+            sizeof (float*),
+            sizeof (float*) * width,
+            sizeof (float)));
+
+    size_t i = 0;
+    for (FrameBuffer::ConstIterator qt = _outputFrameBuffer.begin ();
+         qt != _outputFrameBuffer.end ();
+         qt++)
+    {
+        int channel_in_source = _bufferMap[i];
+        if (channel_in_source > 2)
+        {
+            // not dealt with yet (0,1,2 previously inserted)
+            pointers[channel_in_source].resize (pixelcount);
+            buf.insert (
+                qt.name (),
+                DeepSlice (
+                    OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT,
+                    (char*) (&pointers[channel_in_source][0] - origin),
+                    sizeof (float*),
+                    sizeof (float*) * width,
+                    sizeof (float)));
+        }
+
+        i++;
+    }
+}
+
+void
+CompositeDeepTile::setCompositing (DeepCompositing* c)
+{
+    _Data->_comp = c;
+}
+
+const IMATH_NAMESPACE::Box2i&
+CompositeDeepTile::dataWindow () const
+{
+    return _Data->_dataWindow;
+}
+
+const TileDescription&
+CompositeDeepTile::tileDescription () const
+{
+    return _Data->_tileDescription;
+}
+
+int
+CompositeDeepTile::numXTiles (int lx) const
+{
+    if (_Data->_sources.empty ())
+    {
+        throw IEX_NAMESPACE::ArgExc ("No sources added to CompositeDeepTile");
+    }
+
+    const Source& s = _Data->_sources[0];
+    return s.file ? s.file->numXTiles (lx) : s.part->numXTiles (lx);
+}
+
+int
+CompositeDeepTile::numYTiles (int ly) const
+{
+    if (_Data->_sources.empty ())
+    {
+        throw IEX_NAMESPACE::ArgExc ("No sources added to CompositeDeepTile");
+    }
+
+    const Source& s = _Data->_sources[0];
+    return s.file ? s.file->numYTiles (ly) : s.part->numYTiles (ly);
+}
+
+void
+CompositeDeepTile::setFrameBuffer (const FrameBuffer& fr)
+{
+
+    //
+    // count channels; build map between channels in frame buffer
+    // and channels in internal buffers
+    //
+
+    _Data->_channels.resize (3);
+    _Data->_channels[0] = "Z";
+    _Data->_channels[1] = _Data->_zback ? "ZBack" : "Z";
+    _Data->_channels[2] = "A";
+    _Data->_bufferMap.resize (0);
+
+    for (FrameBuffer::ConstIterator q = fr.begin (); q != fr.end (); q++)
+    {
+
+        //
+        // Frame buffer must have xSampling and ySampling set to 1
+        // (Sampling in FrameBuffers must match sampling in file,
+        //  and Header::sanityCheck enforces sampling in deep files is 1)
+        //
+
+        if (q.slice ().xSampling != 1 || q.slice ().ySampling != 1)
+        {
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "X and/or y subsampling factors "
+                "of \""
+                    << q.name ()
+                    << "\" channel in framebuffer "
+                       "are not 1");
+        }
+
+        string name (q.name ());
+        if (name == "ZBack") { _Data->_bufferMap.push_back (1); }
+        else if (name == "Z") { _Data->_bufferMap.push_back (0); }
+        else if (name == "A") { _Data->_bufferMap.push_back (2); }
+        else
+        {
+            _Data->_bufferMap.push_back (
+                static_cast<int> (_Data->_channels.size ()));
+            _Data->_channels.push_back (name);
+        }
+    }
+
+    _Data->_outputFrameBuffer = fr;
+}
+
+const FrameBuffer&
+CompositeDeepTile::frameBuffer () const
+{
+    return _Data->_outputFrameBuffer;
+}
+
+namespace
+{
+
+//
+// the state shared by the tasks compositing one row of tiles
+//
+
+struct TileRow
+{
+    Box2i                          region; // pixels of the row of tiles
+    int                            tileXSize;
+    bool                           zback;
+    DeepCompositing*               comp;
+    vector<const char*>            names;
+    vector<vector<vector<float*>>> pointers; // [source][channel][pixel]
+    vector<unsigned int>           total_sizes;
+    vector<unsigned int>           num_sources;
+    vector<OutputSlice>            slices;
+};
+
+//
+// composite lines y0 to y1 inclusive of a row of tiles; the scratch
+// pixel and input pointers are shared by every pixel of the block
+//
+
+void
+composite_lines (int y0, int y1, const TileRow& row)
+{
+    vector<const char*>  names (row.names);
+    vector<float>        output_pixel (names.size ()); //the pixel we'll output to
+    vector<const float*> inputs (names.size ());
+    DeepCompositing      d; // fallback compositing engine
+    DeepCompositing*     comp = row.comp ? row.comp : &d;
+
+    const int num_channels = static_cast<int> (names.size ());
+    const int width        = row.region.max.x + 1 - row.region.min.x;
+
+    const vector<vector<float*>>& pointers = row.pointers[0];
+
+    for (int y = y0; y <= y1; y++)
+    {
+        for (int tx = row.region.min.x; tx <= row.region.max.x;
+             tx += row.tileXSize)
+        {
+            int tx1   = std::min (tx + row.tileXSize - 1, row.region.max.x);
+            int pixel = (y - row.region.min.y) * width;
+            pixel += tx - row.region.min.x;
+
+            for (int x = tx; x <= tx1; x++)
+            {
+                // set inputs[] to point to the first sample of the first source of each channel
+                // if there's a zback, set all channel independently...
+
+                if (row.zback)
+                {
+                    for (int channel = 0; channel < num_channels; channel++)
+                    {
+                        inputs[channel] = pointers[channel][pixel];
+                    }
+                }
+                else
+                {
+                    // otherwise, set 0 and 1 to point to Z
+
+                    inputs[0] = pointers[0][pixel];
+                    inputs[1] = pointers[0][pixel];
+                    for (int channel = 2; channel < num_channels; channel++)
+                    {
+                        inputs[channel] = pointers[channel][pixel];
+                    }
+                }
+                comp->composite_pixel (
+                    &output_pixel[0],
+                    &inputs[0],
+                    &names[0],
+                    num_channels,
+                    row.total_sizes[pixel],
+                    row.num_sources[pixel]);
+
+                //
+                // write out composited value into the output frame buffer,
+                // relative to the tile origin for slices in tile coordinates
+                //
+                for (size_t i = 0; i < row.slices.size (); i++)
+                {
+                    const OutputSlice& slice = row.slices[i];
+
+                    float value = output_pixel[slice.channel]; // value to write
+                    int   sx    = slice.xTileCoords ? x - tx : x;
+                    int   sy    = slice.yTileCoords ? y - row.region.min.y : y;
+                    intptr_t addr =
+                        slice.base + sy * slice.yStride + sx * slice.xStride;
+
+                    // cast to half float if necessary
+                    if (slice.type == OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT)
+                    {
+                        *reinterpret_cast<float*> (addr) = value;
+                    }
+                    else if (slice.type == HALF)
+                    {
+                        *reinterpret_cast<half*> (addr) = half (value);
+                    }
+                }
+
+                pixel++;
+
+            } // next pixel in tile
+        }     // next tile
+    }         // next line
+}
+
+class TileRowCompositeTask : public Task
+{
+public:
+    TileRowCompositeTask (TaskGroup* group, const TileRow* row, int y0, int y1)
+        : Task (group), _row (row), _y0 (y0), _y1 (y1)
+    {}
+
+    virtual ~TileRowCompositeTask () {}
+
+    virtual void   execute () { composite_lines (_y0, _y1, *_row); }
+    const TileRow* _row;
+    int            _y0;
+    int            _y1;
+};
+
+} // namespace
+
+void
+CompositeDeepTile::setMaximumSampleCount (int64_t c)
+{
+    maximumSampleCount = c;
+}
+
+int64_t
+CompositeDeepTile::getMaximumSampleCount ()
+{
+    return maximumSampleCount;
+}
+
+void
+CompositeDeepTile::Data::readTileRow (int dx1, int dx2, int dy, int lx, int ly)
+{
+    size_t parts = _sources.size ();
+
+    TileRow row;
+    row.region.min = _sources[0].dataWindowForTile (dx1, dy, lx, ly).min;
+    row.region.max = _sources[0].dataWindowForTile (dx2, dy, lx, ly).max;
+    row.tileXSize  = _tileDescription.xSize;
+    row.zback      = _zback;
+    row.comp       = _comp;
+
+    vector<DeepFrameBuffer>      framebuffers (parts);
+    vector<vector<unsigned int>> counts (parts);
+    row.pointers.resize (parts);
+
+    for (size_t i = 0; i < parts; i++)
+    {
+        handleDeepFrameBuffer (
+            framebuffers[i], counts[i], row.pointers[i], row.region);
+        _sources[i].setFrameBuffer (framebuffers[i]);
+        _sources[i].readPixelSampleCounts (dx1, dx2, dy, lx, ly);
+    }
+
+    //
+    // accumulate pixel counts
+    //
+
+    size_t total_pixels = counts[0].size ();
+    row.total_sizes.resize (total_pixels);
+    row.num_sources.resize (
+        total_pixels); //number of parts with non-zero sample count
+
+    int64_t overall_sample_count =
+        0; // sum of all samples in all sources in this row of tiles
+
+    for (size_t ptr = 0; ptr < total_pixels; ptr++)
+    {
+        row.total_sizes[ptr] = 0;
+        row.num_sources[ptr] = 0;
+        for (size_t j = 0; j < parts; j++)
+        {
+            row.total_sizes[ptr] += counts[j][ptr];
+            if (counts[j][ptr] > 0) row.num_sources[ptr]++;
+        }
+        overall_sample_count += row.total_sizes[ptr];
+    }
+
+    if (maximumSampleCount > 0 && overall_sample_count > maximumSampleCount)
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Cannot composite tiles: total sample count in row of tiles exceeds "
+            "limit set by CompositeDeepTile::setMaximumSampleCount()");
+    }
+
+    //
+    // allocate arrays for pixel data, and point each source's samples
+    // for a pixel directly after the previous source's
+    //
+
+    vector<vector<float>> samples (_channels.size ());
+
+    for (size_t channel = 0; channel < samples.size (); channel++)
+    {
+        if (channel != 1 || _zback)
+        {
+            samples[channel].resize (overall_sample_count);
+
+            float* data = samples[channel].data ();
+            for (size_t pixel = 0; pixel < total_pixels; pixel++)
+            {
+                for (size_t part = 0; part < parts; part++)
+                {
+                    row.pointers[part][channel][pixel] = data;
+                    data += counts[part][pixel];
+                }
+            }
+        }
+    }
+
+    //
+    // read data
+    //
+
+    for (size_t i = 0; i < parts; i++)
+    {
+        _sources[i].readTiles (dx1, dx2, dy, lx, ly);
+    }
+
+    //
+    // turn vector of strings into array of char *
+    // and make sure 'ZBack' channel is correct
+    //
+
+    row.names.resize (_channels.size ());
+    for (size_t i = 0; i < row.names.size (); i++)
+    {
+        row.names[i] = _channels[i].c_str ();
+    }
+
+    if (!_zback)
+        row.names[1] = row.names[0]; // no zback channel, so make it point to z
+
+    //
+    // resolve the output slices
+    //
+
+    {
+        size_t channel_number = 0;
+        for (FrameBuffer::Iterator it = _outputFrameBuffer.begin ();
+             it != _outputFrameBuffer.end ();
+             it++)
+        {
+            OutputSlice slice;
+            slice.type        = it.slice ().type;
+            slice.base        = reinterpret_cast<intptr_t> (it.slice ().base);
+            slice.xStride     = it.slice ().xStride;
+            slice.yStride     = it.slice ().yStride;
+            slice.xTileCoords = it.slice ().xTileCoords;
+            slice.yTileCoords = it.slice ().yTileCoords;
+            slice.channel     = _bufferMap[channel_number];
+            row.slices.push_back (slice);
+            channel_number++;
+        }
+    }
+
+    //
+    // composite in blocks of lines
+    //
+
+    int lines       = row.region.max.y - row.region.min.y + 1;
+    int threads     = ThreadPool::globalThreadPool ().numThreads ();
+    int blocks      = threads > 1 ? threads * 4 : 1;
+    int block_lines = (lines + blocks - 1) / blocks;
+    if (block_lines < 1) block_lines = 1;
+
+    TaskGroup g;
+    for (int y = row.region.min.y; y <= row.region.max.y; y += block_lines)
+    {
+        int y1 = std::min (y + block_lines - 1, row.region.max.y);
+        ThreadPool::addGlobalTask (new TileRowCompositeTask (&g, &row, y, y1));
+    }
+}
+
+void
+CompositeDeepTile::readTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly)
+{
+    if (_Data->_sources.empty ())
+    {
+        throw IEX_NAMESPACE::ArgExc ("No sources added to CompositeDeepTile");
+    }
+
+    if (_Data->_channels.empty ())
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "readTiles called on CompositeDeepTile with no frame buffer");
+    }
+
+    if (dx1 > dx2) std::swap (dx1, dx2);
+    if (dy1 > dy2) std::swap (dy1, dy2);
+
+    //
+    // one row of tiles at a time, so only one row's samples are held
+    //
+
+    for (int dy = dy1; dy <= dy2; dy++)
+    {
+        _Data->readTileRow (dx1, dx2, dy, lx, ly);
+    }
+}
+
+void
+CompositeDeepTile::readTiles (int dx1, int dx2, int dy1, int dy2, int l)
+{
+    readTiles (dx1, dx2, dy1, dy2, l, l);
+}
+
+void
+CompositeDeepTile::readTile (int dx, int dy, int lx, int ly)
+{
+    readTiles (dx, dx, dy, dy, lx, ly);
+}
+
+void
+CompositeDeepTile::readTile (int dx, int dy, int l)
+{
+    readTiles (dx, dx, dy, dy, l, l);
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -0,0 +1,167 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_COMPOSITEDEEPTILE_H
+#define INCLUDED_IMF_COMPOSITEDEEPTILE_H
+
+//-----------------------------------------------------------------------------
+//
+//	Class to composite deep tiled samples into a frame buffer
+//      The tiled counterpart of CompositeDeepScanLine:
+//      initialise with one or more deep tiled input parts or files,
+//      then call setFrameBuffer, and readTile or readTiles, exactly as
+//      for reading regular tiled images.
+//
+//      Tiles are processed one row of tiles at a time, so the memory
+//      held for deep samples is bounded by the samples in a single row
+//      of the requested tiles, not the whole image. Tiles are decoded
+//      by the sources using the global thread pool, and composited in
+//      parallel on it.
+//
+//      The frame buffer slices may use tile coordinates (xTileCoords,
+//      yTileCoords), so a buffer the size of a single tile, or a single
+//      row of tiles, can be set on both this object and a TiledOutputFile
+//      to flatten a deep tiled image into a flat tiled one piecewise:
+//
+//          for (int dy = 0; dy < comp.numYTiles (); ++dy)
+//          {
+//              comp.readTiles (0, comp.numXTiles () - 1, dy, dy);
+//              out.writeTiles (0, comp.numXTiles () - 1, dy, dy);
+//          }
+//
+//      Restrictions - source(s) must contain at least Z and alpha channels
+//                   - if multiple files/parts are provided, their data
+//                     windows and tile descriptions must match
+//                   - all requested channels will be composited as premultiplied
+//                   - only half and float channels can be requested
+//
+//      This object should not be considered threadsafe
+//
+//      As with CompositeDeepScanLine, a DeepCompositing instance may be
+//      passed to setCompositing() to override sorting and compositing.
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfForward.h"
+#include "ImfTileDescription.h"
+
+#include <ImathBox.h>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+class IMF_EXPORT_TYPE CompositeDeepTile
+{
+public:
+    IMF_EXPORT
+    CompositeDeepTile ();
+    IMF_EXPORT
+    virtual ~CompositeDeepTile ();
+
+    /// set the source data as a part
+    ///@note all parts must remain valid until after last interaction with DeepComp
+    IMF_EXPORT
+    void addSource (DeepTiledInputPart* part);
+
+    /// set the source data as a file
+    ///@note all file must remain valid until after last interaction with DeepComp
+    IMF_EXPORT
+    void addSource (DeepTiledInputFile* file);
+
+    IMF_EXPORT
+    int sources () const; // return number of sources
+
+    /////////////////////////////////////////
+    //
+    // set the frame buffer for output values
+    // the buffers specified must be large enough
+    // to handle the tiles that are read, in the
+    // pixel space of the level being read
+    //
+    /////////////////////////////////////////
+    IMF_EXPORT
+    void setFrameBuffer (const FrameBuffer& fr);
+
+    /////////////////////////////////////////
+    //
+    // retrieve frameBuffer
+    //
+    ////////////////////////////////////////
+    IMF_EXPORT
+    const FrameBuffer& frameBuffer () const;
+
+    ////////////////////////////////////////////////
+    //
+    // retrieve the datawindow and tile layout,
+    // shared by all sources
+    //
+    ////////////////////////////////////////////////
+
+    IMF_EXPORT
+    const IMATH_NAMESPACE::Box2i& dataWindow () const;
+
+    IMF_EXPORT
+    const TileDescription& tileDescription () const;
+
+    IMF_EXPORT
+    int numXTiles (int lx = 0) const;
+    IMF_EXPORT
+    int numYTiles (int ly = 0) const;
+
+    //////////////////////////////////////////////////
+    //
+    // read tiles from the source(s), storing the
+    // composited result in the frame buffer provided
+    //
+    // readTiles(dx1, dx2, dy1, dy2, lx, ly) reads
+    // all tiles with dx1 <= dx <= dx2 and
+    // dy1 <= dy <= dy2 of level (lx, ly)
+    //
+    //////////////////////////////////////////////////
+
+    IMF_EXPORT
+    void readTile (int dx, int dy, int l = 0);
+    IMF_EXPORT
+    void readTile (int dx, int dy, int lx, int ly);
+
+    IMF_EXPORT
+    void readTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly);
+    IMF_EXPORT
+    void readTiles (int dx1, int dx2, int dy1, int dy2, int l = 0);
+
+    //
+    // override default sorting/compositing operation
+    // (otherwise an instance of the base class will be used)
+    //
+
+    IMF_EXPORT
+    void setCompositing (DeepCompositing*);
+
+    struct IMF_HIDDEN Data;
+
+    //
+    // set the maximum number of samples that will be composited.
+    // If a single row of the requested tiles has more samples,
+    // readTiles will throw an exception. This mechanism prevents the
+    // library allocating excessive memory to composite deep tiled images.
+    // A value of 0 or less disables the limit
+    //
+    IMF_EXPORT
+    static void setMaximumSampleCount (int64_t sampleCount);
+
+    IMF_EXPORT
+    static int64_t getMaximumSampleCount ();
+
+private:
+    struct Data* _Data;
+
+    CompositeDeepTile (const CompositeDeepTile&)            = delete;
+    CompositeDeepTile& operator= (const CompositeDeepTile&) = delete;
+    CompositeDeepTile (CompositeDeepTile&&)                 = delete;
+    CompositeDeepTile& operator= (CompositeDeepTile&&)      = delete;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
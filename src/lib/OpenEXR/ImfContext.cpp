@@ -342,7 +342,7 @@ Context::attrCount (int partidx) const
                                                 << fileName () << "'");
     }
 
-    return 0;
+    return attrcnt;
 }
 
 ////////////////////////////////////////
@@ -105,6 +105,14 @@ public:
         return *this;
     }
 
+    /// size of the first read when parsing the header, 0 for the
+    /// default (see exr_context_initializer_t::header_read_size)
+    ContextInitializer& setHeaderReadSize (size_t sz) noexcept
+    {
+        _initializer.header_read_size = sz;
+        return *this;
+    }
+
     ContextInitializer& strictHeaderValidation (bool onoff) noexcept
     {
         setFlag (EXR_CONTEXT_FLAG_STRICT_HEADER, onoff);
@@ -19,6 +19,42 @@ DeepCompositing::DeepCompositing ()
 DeepCompositing::~DeepCompositing ()
 {}
 
+namespace
+{
+
+//
+// Pixels with up to this many samples sort and composite using scratch
+// space on the stack, rather than allocating it per pixel.
+//
+
+const int STACK_SAMPLES = 256;
+
+//
+// The sort key of a sample: sorting these directly, rather than an
+// index array through an indirect comparator, keeps the comparisons
+// in cache. The comparison is the same as ever (Z, then ZBack, then
+// original sample index), so the resulting order is identical.
+//
+
+struct SortKey
+{
+    float z;
+    float zback;
+    int   index;
+};
+
+inline bool
+operator< (const SortKey& a, const SortKey& b)
+{
+    if (a.z < b.z) return true;
+    if (a.z > b.z) return false;
+    if (a.zback < b.zback) return true;
+    if (a.zback > b.zback) return false;
+    return a.index < b.index;
+}
+
+} // namespace
+
 void
 DeepCompositing::composite_pixel (
     float        outputs[],
@@ -33,14 +69,22 @@ DeepCompositing::composite_pixel (
     // no samples? do nothing
     if (num_samples == 0) { return; }
 
-    vector<int> sort_order;
+    int         stack_order[STACK_SAMPLES];
+    vector<int> heap_order;
+    int*        sort_order = nullptr;
     if (sources > 1)
     {
-        sort_order.resize (num_samples);
+        if (num_samples <= STACK_SAMPLES)
+            sort_order = stack_order;
+        else
+        {
+            heap_order.resize (num_samples);
+            sort_order = &heap_order[0];
+        }
         for (int i = 0; i < num_samples; i++)
             sort_order[i] = i;
         sort (
-            &sort_order[0],
+            sort_order,
             inputs,
             channel_names,
             num_channels,
@@ -54,27 +98,14 @@ DeepCompositing::composite_pixel (
         float alpha = outputs[2];
         if (alpha >= 1.0f) return;
 
+        float transmission = 1.0f - alpha;
         for (int c = 0; c < num_channels; c++)
         {
-            outputs[c] += (1.0f - alpha) * inputs[c][s];
+            outputs[c] += transmission * inputs[c][s];
         }
     }
 }
 
-struct sort_helper
-{
-    const float** inputs;
-    bool          operator() (int a, int b)
-    {
-        if (inputs[0][a] < inputs[0][b]) return true;
-        if (inputs[0][a] > inputs[0][b]) return false;
-        if (inputs[1][a] < inputs[1][b]) return true;
-        if (inputs[1][a] > inputs[1][b]) return false;
-        return a < b;
-    }
-    sort_helper (const float** i) : inputs (i) {}
-};
-
 void
 DeepCompositing::sort (
     int          order[],
@@ -84,7 +115,27 @@ DeepCompositing::sort (
     int          num_samples,
     int          sources)
 {
-    std::sort (order + 0, order + num_samples, sort_helper (inputs));
+    SortKey         stack_keys[STACK_SAMPLES];
+    vector<SortKey> heap_keys;
+    SortKey*        keys = stack_keys;
+    if (num_samples > STACK_SAMPLES)
+    {
+        heap_keys.resize (num_samples);
+        keys = &heap_keys[0];
+    }
+
+    for (int i = 0; i < num_samples; i++)
+    {
+        int s         = order[i];
+        keys[i].z     = inputs[0][s];
+        keys[i].zback = inputs[1][s];
+        keys[i].index = s;
+    }
+
+    std::sort (keys, keys + num_samples);
+
+    for (int i = 0; i < num_samples; i++)
+        order[i] = keys[i].index;
 }
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -28,6 +28,7 @@ struct IMF_EXPORT_TYPE                            Chromaticities;
 class IMF_EXPORT_TYPE Attribute;
 
 class IMF_EXPORT_TYPE Header;
+class IMF_EXPORT_TYPE HeaderView;
 
 // file handling classes
 class IMF_EXPORT_TYPE OutputFile;
@@ -77,6 +78,7 @@ struct IMF_EXPORT_TYPE DeepSlice;
 // compositing
 class IMF_EXPORT_TYPE DeepCompositing;
 class IMF_EXPORT_TYPE CompositeDeepScanLine;
+class IMF_EXPORT_TYPE CompositeDeepTile;
 
 // preview image
 class IMF_EXPORT_TYPE  PreviewImage;
@@ -88,6 +90,8 @@ class IMF_EXPORT_TYPE IStream;
 
 class IMF_EXPORT_TYPE IDManifest;
 class IMF_EXPORT_TYPE CompressedIDManifest;
+class IMF_EXPORT_TYPE CompactIDManifest;
+class IMF_EXPORT_TYPE LazyIDManifest;
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
 
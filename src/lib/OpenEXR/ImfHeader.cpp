@@ -42,6 +42,7 @@
 #include <ImfVersion.h>
 #include <atomic>
 #include <cmath>
+#include <cstdint>
 #include <sstream>
 #include <stdlib.h>
 #include <time.h>
@@ -82,6 +83,13 @@ struct CompressionRecord
 //
 // but if we just use the once_flag / call_once mechanism, windows
 // then starts crashing on exit in a different way.
+//
+// The records can't live in the Header itself without changing its
+// size, so they are kept here, keyed by address. Every Header copy,
+// assignment and destruction consults the stash, so it is split into
+// shards, each with its own lock, and each shard keeps a count of its
+// records: the common case of headers that never had a compression
+// level set then takes no lock at all, and the others rarely contend.
 
 struct CompressionStash;
 // assignments to here happen in static singleton ctor which is
@@ -92,8 +100,25 @@ struct CompressionStash;
 // include proper support for those.
 static std::atomic<CompressionStash*> s_stash{nullptr};
 
+struct CompressionShard
+{
+#if ILMTHREAD_THREADING_ENABLED
+    std::mutex _mutex;
+#endif
+    // number of entries in _store, readable without the lock. A
+    // header's own record can only be added by a thread using that
+    // header, so a zero count means there is nothing to look up.
+    std::atomic<size_t>                      _count{0};
+    std::map<const void*, CompressionRecord> _store;
+
+    void updateCount () { _count.store (_store.size ()); }
+    bool empty () const { return _count.load () == 0; }
+};
+
 struct CompressionStash
 {
+    static const int NUM_SHARDS = 64;
+
     CompressionStash () { s_stash.store (this); }
     ~CompressionStash ()
     {
@@ -108,19 +133,28 @@ struct CompressionStash
         // changing the abi other than say don't have static/global
         // Header objects?
         s_stash.store (nullptr);
-#if ILMTHREAD_THREADING_ENABLED
-        // let's explicitly grab the lock and clear the map in case
+        // let's explicitly grab the locks and clear the maps in case
         // there is someone waiting on a lock concurrently at static
         // destruction time, just to be pedantic
-        _mutex.lock ();
-        _store.clear ();
-        _mutex.unlock ();
-#endif
-    }
+        for (CompressionShard& shard: _shards)
+        {
 #if ILMTHREAD_THREADING_ENABLED
-    std::mutex _mutex;
+            std::lock_guard<std::mutex> lk (shard._mutex);
 #endif
-    std::map<const void*, CompressionRecord> _store;
+            shard._store.clear ();
+            shard.updateCount ();
+        }
+    }
+
+    CompressionShard& shard (const void* hdr)
+    {
+        // Headers are at least a few pointers in size, so the low
+        // bits of the address carry little information
+        uintptr_t a = reinterpret_cast<uintptr_t> (hdr);
+        return _shards[((a >> 4) ^ (a >> 10)) % NUM_SHARDS];
+    }
+
+    CompressionShard _shards[NUM_SHARDS];
 };
 
 static CompressionStash*
@@ -136,28 +170,46 @@ clearCompressionRecord (Header* hdr)
     CompressionStash* s = getStash ();
     if (s)
     {
+        CompressionShard& shard = s->shard (hdr);
+        if (shard.empty ()) return;
 #if ILMTHREAD_THREADING_ENABLED
-        std::lock_guard<std::mutex> lk (s->_mutex);
+        std::lock_guard<std::mutex> lk (shard._mutex);
 #endif
-        auto i = s->_store.find (hdr);
-        if (i != s->_store.end ()) s->_store.erase (i);
+        auto i = shard._store.find (hdr);
+        if (i != shard._store.end ())
+        {
+            shard._store.erase (i);
+            shard.updateCount ();
+        }
     }
 }
 
-static CompressionRecord
-retrieveCompressionRecord (const Header* hdr)
+static bool
+findCompressionRecord (const Header* hdr, CompressionRecord& rec)
 {
-    CompressionRecord retval;
-
     CompressionStash* s = getStash ();
     if (s)
     {
+        CompressionShard& shard = s->shard (hdr);
+        if (shard.empty ()) return false;
 #if ILMTHREAD_THREADING_ENABLED
-        std::lock_guard<std::mutex> lk (s->_mutex);
+        std::lock_guard<std::mutex> lk (shard._mutex);
 #endif
-        auto i = s->_store.find (hdr);
-        if (i != s->_store.end ()) retval = i->second;
+        auto i = shard._store.find (hdr);
+        if (i != shard._store.end ())
+        {
+            rec = i->second;
+            return true;
+        }
     }
+    return false;
+}
+
+static CompressionRecord
+retrieveCompressionRecord (const Header* hdr)
+{
+    CompressionRecord retval;
+    findCompressionRecord (hdr, retval);
     return retval;
 }
 
@@ -167,10 +219,13 @@ retrieveCompressionRecord (Header* hdr)
     CompressionStash* s = getStash ();
     if (s)
     {
+        CompressionShard& shard = s->shard (hdr);
 #if ILMTHREAD_THREADING_ENABLED
-        std::lock_guard<std::mutex> lk (s->_mutex);
+        std::lock_guard<std::mutex> lk (shard._mutex);
 #endif
-        return s->_store[hdr];
+        CompressionRecord& rec = shard._store[hdr];
+        shard.updateCount ();
+        return rec;
     }
     // this will only happen at app shutdown, so it'd be an invalid
     // store anyway, but just return something to avoid a crash
@@ -181,20 +236,21 @@ retrieveCompressionRecord (Header* hdr)
 static void
 copyCompressionRecord (Header* dst, const Header* src)
 {
-    CompressionStash* s = getStash ();
-    if (s)
+    CompressionRecord rec;
+    if (findCompressionRecord (src, rec))
     {
+        CompressionStash* s = getStash ();
+        if (s)
+        {
+            CompressionShard& shard = s->shard (dst);
 #if ILMTHREAD_THREADING_ENABLED
-        std::lock_guard<std::mutex> lk (s->_mutex);
+            std::lock_guard<std::mutex> lk (shard._mutex);
 #endif
-        auto i = s->_store.find (src);
-        if (i != s->_store.end ()) { s->_store[dst] = i->second; }
-        else
-        {
-            i = s->_store.find (dst);
-            if (i != s->_store.end ()) s->_store.erase (i);
+            shard._store[dst] = rec;
+            shard.updateCount ();
         }
     }
+    else { clearCompressionRecord (dst); }
 };
 
 void
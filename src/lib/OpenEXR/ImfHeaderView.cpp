@@ -0,0 +1,283 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#include "ImfHeaderView.h"
+
+#include "openexr.h"
+
+#include "Iex.h"
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+////////////////////////////////////////
+
+HeaderView::HeaderView (const Context& ctxt, int partidx)
+    : _ctxt (ctxt), _part (partidx)
+{
+    int pc = _ctxt.partCount ();
+    if (partidx < 0 || partidx >= pc)
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Invalid out of bounds part number " << partidx << ", only " << pc
+                                                 << " parts in '"
+                                                 << _ctxt.fileName () << "'");
+    }
+}
+
+////////////////////////////////////////
+
+int
+HeaderView::attributeCount () const
+{
+    return _ctxt.attrCount (_part);
+}
+
+////////////////////////////////////////
+
+const exr_attribute_t*
+HeaderView::attribute (int attridx) const
+{
+    return _ctxt.getAttr (_part, attridx);
+}
+
+////////////////////////////////////////
+
+const exr_attribute_t*
+HeaderView::findAttribute (const char* name) const
+{
+    return _ctxt.getAttr (_part, name);
+}
+
+////////////////////////////////////////
+
+const exr_attribute_t*
+HeaderView::findAttribute (const char* name, exr_attribute_type_t type) const
+{
+    const exr_attribute_t* attr = _ctxt.getAttr (_part, name);
+    if (attr && attr->type == type) return attr;
+    return nullptr;
+}
+
+////////////////////////////////////////
+
+IMATH_NAMESPACE::Box2i
+HeaderView::displayWindow () const
+{
+    exr_attr_box2i_t dw;
+
+    if (EXR_ERR_SUCCESS != exr_get_display_window (_ctxt, _part, &dw))
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Unable to get the display window for part "
+                << _part << " in file '" << _ctxt.fileName () << "'");
+    }
+
+    return IMATH_NAMESPACE::Box2i (
+        IMATH_NAMESPACE::V2i (dw.min.x, dw.min.y),
+        IMATH_NAMESPACE::V2i (dw.max.x, dw.max.y));
+}
+
+////////////////////////////////////////
+
+IMATH_NAMESPACE::Box2i
+HeaderView::dataWindow () const
+{
+    exr_attr_box2i_t dw = _ctxt.dataWindow (_part);
+
+    return IMATH_NAMESPACE::Box2i (
+        IMATH_NAMESPACE::V2i (dw.min.x, dw.min.y),
+        IMATH_NAMESPACE::V2i (dw.max.x, dw.max.y));
+}
+
+////////////////////////////////////////
+
+float
+HeaderView::pixelAspectRatio () const
+{
+    float par = 1.f;
+
+    if (EXR_ERR_SUCCESS != exr_get_pixel_aspect_ratio (_ctxt, _part, &par))
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Unable to get the pixel aspect ratio for part "
+                << _part << " in file '" << _ctxt.fileName () << "'");
+    }
+
+    return par;
+}
+
+////////////////////////////////////////
+
+IMATH_NAMESPACE::V2f
+HeaderView::screenWindowCenter () const
+{
+    exr_attr_v2f_t swc;
+
+    if (EXR_ERR_SUCCESS != exr_get_screen_window_center (_ctxt, _part, &swc))
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Unable to get the screen window center for part "
+                << _part << " in file '" << _ctxt.fileName () << "'");
+    }
+
+    return IMATH_NAMESPACE::V2f (swc.x, swc.y);
+}
+
+////////////////////////////////////////
+
+float
+HeaderView::screenWindowWidth () const
+{
+    float sww = 1.f;
+
+    if (EXR_ERR_SUCCESS != exr_get_screen_window_width (_ctxt, _part, &sww))
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Unable to get the screen window width for part "
+                << _part << " in file '" << _ctxt.fileName () << "'");
+    }
+
+    return sww;
+}
+
+////////////////////////////////////////
+
+LineOrder
+HeaderView::lineOrder () const
+{
+    return LineOrder (_ctxt.lineOrder (_part));
+}
+
+////////////////////////////////////////
+
+Compression
+HeaderView::compression () const
+{
+    exr_compression_t comp;
+
+    if (EXR_ERR_SUCCESS != exr_get_compression (_ctxt, _part, &comp))
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Unable to get the compression for part "
+                << _part << " in file '" << _ctxt.fileName () << "'");
+    }
+
+    return Compression (comp);
+}
+
+////////////////////////////////////////
+
+const exr_attr_chlist_t*
+HeaderView::channels () const
+{
+    return _ctxt.channels (_part);
+}
+
+////////////////////////////////////////
+
+bool
+HeaderView::hasTileDescription () const
+{
+    return findAttribute ("tiles", EXR_ATTR_TILEDESC) != nullptr;
+}
+
+////////////////////////////////////////
+
+TileDescription
+HeaderView::tileDescription () const
+{
+    const exr_attribute_t* attr = findAttribute ("tiles", EXR_ATTR_TILEDESC);
+
+    if (!attr)
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "No tile description for part " << _part << " in file '"
+                                            << _ctxt.fileName () << "'");
+    }
+
+    return TileDescription (
+        attr->tiledesc->x_size,
+        attr->tiledesc->y_size,
+        (LevelMode) (EXR_GET_TILE_LEVEL_MODE (*attr->tiledesc)),
+        (LevelRoundingMode) (EXR_GET_TILE_ROUND_MODE (*attr->tiledesc)));
+}
+
+////////////////////////////////////////
+
+const char*
+HeaderView::findString (const char* name) const
+{
+    const exr_attribute_t* attr = findAttribute (name, EXR_ATTR_STRING);
+
+    // the core library nul terminates strings as they are parsed
+    return attr ? attr->string->str : nullptr;
+}
+
+////////////////////////////////////////
+
+const char*
+HeaderView::name () const
+{
+    return findString ("name");
+}
+
+////////////////////////////////////////
+
+const char*
+HeaderView::type () const
+{
+    return findString ("type");
+}
+
+////////////////////////////////////////
+
+const char*
+HeaderView::view () const
+{
+    return findString ("view");
+}
+
+////////////////////////////////////////
+
+exr_storage_t
+HeaderView::storage () const
+{
+    return _ctxt.storage (_part);
+}
+
+////////////////////////////////////////
+
+int
+HeaderView::chunkCount () const
+{
+    int32_t count = 0;
+
+    if (EXR_ERR_SUCCESS != exr_get_chunk_count (_ctxt, _part, &count))
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Unable to get the chunk count for part "
+                << _part << " in file '" << _ctxt.fileName () << "'");
+    }
+
+    return count;
+}
+
+////////////////////////////////////////
+
+Header
+HeaderView::header () const
+{
+    return _ctxt.header (_part);
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
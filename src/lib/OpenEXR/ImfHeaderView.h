@@ -0,0 +1,97 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_HEADER_VIEW_H
+#define INCLUDED_IMF_HEADER_VIEW_H
+
+#include "ImfCompression.h"
+#include "ImfContext.h"
+#include "ImfLineOrder.h"
+#include "ImfTileDescription.h"
+
+#include <ImathBox.h>
+#include <ImathVec.h>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+/// \brief HeaderView provides read-only access to the header of one
+/// part of a file, directly on top of the Core library attribute list
+///
+/// Unlike Header, no attributes are copied or allocated: the typed
+/// accessors read the values the Core library parsed from the file,
+/// and the generic accessors return the Core attribute structures
+/// themselves. This makes it the cheap choice for tools that only
+/// scan metadata (indexers, exrheader-style dumps, etc.). Use
+/// header() when a full, mutable Header is needed.
+///
+/// A view shares ownership of the underlying context, so it stays
+/// valid even if the file object it came from is destroyed. Pointers
+/// returned by the view are valid as long as the view (or any other
+/// owner of the context) is.
+class IMF_EXPORT_TYPE HeaderView
+{
+public:
+    IMF_EXPORT HeaderView (const Context& ctxt, int partidx);
+
+    int partNumber () const noexcept { return _part; }
+
+    // generic attribute access
+
+    /// number of attributes in the part
+    IMF_EXPORT int attributeCount () const;
+
+    /// attribute by index, in the order they appear in the file
+    IMF_EXPORT const exr_attribute_t* attribute (int attridx) const;
+
+    /// attribute by name, or nullptr if the part has no such attribute
+    IMF_EXPORT const exr_attribute_t* findAttribute (const char* name) const;
+
+    /// attribute by name, or nullptr if the part has no such
+    /// attribute or it is not of the given type
+    IMF_EXPORT const exr_attribute_t*
+    findAttribute (const char* name, exr_attribute_type_t type) const;
+
+    bool hasAttribute (const char* name) const
+    {
+        return findAttribute (name) != nullptr;
+    }
+
+    // standard attributes
+
+    IMF_EXPORT IMATH_NAMESPACE::Box2i displayWindow () const;
+    IMF_EXPORT IMATH_NAMESPACE::Box2i dataWindow () const;
+    IMF_EXPORT float                  pixelAspectRatio () const;
+    IMF_EXPORT IMATH_NAMESPACE::V2f   screenWindowCenter () const;
+    IMF_EXPORT float                  screenWindowWidth () const;
+    IMF_EXPORT LineOrder              lineOrder () const;
+    IMF_EXPORT Compression            compression () const;
+
+    /// the channel list as parsed by the Core library, sorted by name
+    IMF_EXPORT const exr_attr_chlist_t* channels () const;
+
+    IMF_EXPORT bool            hasTileDescription () const;
+    IMF_EXPORT TileDescription tileDescription () const;
+
+    /// optional string attributes; nullptr when not present
+    IMF_EXPORT const char* name () const;
+    IMF_EXPORT const char* type () const;
+    IMF_EXPORT const char* view () const;
+
+    IMF_EXPORT exr_storage_t storage () const;
+    IMF_EXPORT int           chunkCount () const;
+
+    /// materialize a full copy of the header
+    IMF_EXPORT Header header () const;
+
+private:
+    const char* findString (const char* name) const;
+
+    Context _ctxt;
+    int     _part;
+}; // class HeaderView
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif // INCLUDED_IMF_HEADER_VIEW_H
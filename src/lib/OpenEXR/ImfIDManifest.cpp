@@ -299,243 +299,395 @@ writePascalString (char*& outPtr, const string& str)
     Xdr::write<CharPtrIO> ((char*&) outPtr, (const char*) str.c_str (), length);
 }
 
-} // namespace
+//
+// a manifest ready to be written: the distinct strings of all channel
+// groups in sorted order with the number of times each is used, and
+// the entries of each group in ascending ID order, referring to those
+// strings by index. Both IDManifest and CompactIDManifest are
+// serialized through this, so they produce identical data
+//
+struct SerialString
+{
+    const char* str;
+    size_t      size;
+    int         uses;
+};
 
-IDManifest::IDManifest (const char* data, const char* endOfData)
+struct SerialGroup
 {
-    init (data, endOfData);
-}
+    const set<string>*     channels;
+    const vector<string>*  components;
+    IDManifest::IdLifetime lifeTime;
+    const string*          hashScheme;
+    const string*          encodingScheme;
+    vector<uint64_t>       ids;
+    vector<int>            text; // components->size() string indices per ID
+};
 
 void
-IDManifest::init (const char* data, const char* endOfData)
+writeManifest (
+    const vector<SerialString>& strings,
+    const vector<SerialGroup>&  groups,
+    std::vector<char>&          data)
 {
-
-    unsigned int version;
-    Xdr::read<CharPtrIO> (data, version);
-    if (version != 0)
-    {
-        throw IEX_NAMESPACE::InputExc ("Unrecognized IDmanifest version");
-    }
-
     //
-    // first comes list of all strings used in manifest
+    // compressed string representation - all but first string starts with number of characters to copy from previous string.
+    // max 65535 bytes - use two bytes to store if previous string was more than 255 characters, big endian
+    // the prefixed strings are written directly from the original strings, only the prefix length is kept
     //
-    vector<string> stringList;
-    readStringList (data, endOfData, stringList);
+    vector<size_t> common (strings.size (), 0);
 
     //
-    // expand the strings in the stringlist
-    // each string begins with number of characters to copy from the previous string
-    // the remainder is the 'new' bit that appears after that
+    // also make a sorted list so the most common entry appears first. Keep equally likely entries in numerical order
     //
+    vector<pair<int, int>> sortedIndices (strings.size ());
 
-    for (size_t i = 1; i < stringList.size (); ++i)
+    int stringTableSize = 4; // 4 bytes to store number of entries
+    for (size_t index = 0; index < strings.size (); ++index)
     {
+        const SerialString& str    = strings[index];
+        size_t              length = str.size;
 
-        size_t common; // number of characters in common with previous string
-        int    stringStart = 1; // first character of string itself;
-        //
-        // previous string had more than 255 characters?
-        //
-        if (stringList[i - 1].size () > 255)
-        {
-            common = size_t (((unsigned char) (stringList[i][0])) << 8) +
-                     size_t ((unsigned char) (stringList[i][1]));
-            stringStart = 2;
-        }
-        else { common = (unsigned char) stringList[i][0]; }
-        if (common > stringList[i - 1].size ())
+        if (index > 0)
         {
-            throw IEX_NAMESPACE::InputExc (
-                "Bad common string length in IDmanifest string table");
+            const SerialString& prev = strings[index - 1];
+            size_t              c    = 0;
+            while (c < 65535 && c < prev.size && c < str.size &&
+                   prev.str[c] == str.str[c])
+            {
+                ++c;
+            }
+            common[index] = c;
+            length        = (prev.size > 255 ? 2 : 1) + str.size - c;
         }
-        stringList[i] = stringList[i - 1].substr (0, common) +
-                        stringList[i].substr (stringStart);
+        stringTableSize += length + getVariableLengthIntegerSize (length);
+
+        sortedIndices[index].first =
+            -str.uses; // use negative of count so largest count appears first
+        sortedIndices[index].second = index;
     }
 
+    sort (sortedIndices.begin (), sortedIndices.end ());
+
     //
-    // decode mapping table from indices in table to indices in string list
-    // the mapping uses smaller indices for more commonly occurring strings, since these are encoded with fewer bits
-    // comments in serialize function describe the format
+    // the first 1<<7 characters will all be encoded with 1 byte, regardless of how common they are
+    // the next 1<<14 characters will be encoded with 2 bytes
+    // (a full huffman encode would do this at the bit level, not the byte level)
+    //
+    // the mapping table can be reduced in size by rewriting the IDs to exploit that
+    // can rearrange the IDs to have more long runs by sorting numbers
+    // that will need the same number of bytes to encode together
     //
+    {
+        size_t i = 0;
 
-    vector<int> mapping (stringList.size ());
+        for (; i < sortedIndices.size () && i < 1 << 7; ++i)
+        {
+            sortedIndices[i].first = 1;
+        }
+        for (; i < sortedIndices.size () && i < 1 << 14; ++i)
+        {
+            sortedIndices[i].first = 2;
+        }
+        for (; i < sortedIndices.size () && i < 1 << 21; ++i)
+        {
+            sortedIndices[i].first = 3;
+        }
+        for (; i < sortedIndices.size () && i < 1 << 28; ++i)
+        {
+            sortedIndices[i].first = 4;
+        }
+        for (; i < sortedIndices.size (); ++i)
+        {
+            sortedIndices[i].first = 5;
+        }
+    }
+    sort (sortedIndices.begin (), sortedIndices.end ());
+
+    vector<int> stringIndices (sortedIndices.size ());
 
     //
-    // overlapping sequences: A list [(4,5),(3,6)] expands to 4,5,3,6 - because 4 and 5 are including already
-    // they are not included again
-    // the 'seen' list indicates which values have already been used, so they are not re-referenced
+    // table will be stored with RLE encoding - store pairs of 'start index,end index'
+    // so, the sequence 10,11,12,1,2,3,4  is stored as [ (10,12) , (1,4)]
+    //
+    // sequential IDs ignore already referenced IDs, so the sequence  11,9,10,12,13 can be stored as [ (11,11) , (9,13)]
+    // on reading, don't reference an entry that has already been seen
+    // on writing, need to track which entries have already been stored to allow this overlapping to occur
     //
 
-    vector<char> seen (stringList.size ());
+    vector<pair<int, int>> RLEmapping;
 
-    int rleLength;
-    if (endOfData < data + 4)
+    if (sortedIndices.size () > 0)
     {
-        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
-    }
+        RLEmapping.resize (1);
+        RLEmapping[0].first  = sortedIndices[0].second;
+        RLEmapping[0].second = sortedIndices[0].second;
 
-    Xdr::read<CharPtrIO> (data, rleLength);
+        fill (stringIndices.begin (), stringIndices.end (), -1);
 
-    int currentIndex = 0;
-    for (int i = 0; i < rleLength; ++i)
-    {
-        int first;
-        int last;
-        if (endOfData < data + 8)
-        {
-            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
-        }
-        Xdr::read<CharPtrIO> (data, first);
-        Xdr::read<CharPtrIO> (data, last);
+        stringIndices[sortedIndices[0].second] = 0;
 
-        if (first < 0 || last < 0 || first > last ||
-            first >= int (stringList.size ()) ||
-            last >= int (stringList.size ()))
-        {
-            throw IEX_NAMESPACE::InputExc (
-                "Bad mapping table entry in IDManifest");
-        }
-        for (int entry = first; entry <= last; entry++)
+        //
+        // as the loop below runs, nextToInclude tracks the value that can be merged with the current run length
+        // (RLWmapping.back()) - generally this is on more than the current length, but it jumps forward
+        // over values already seen
+        //
+        int nextToInclude = stringIndices[sortedIndices[0].second] + 1;
+
+        for (size_t i = 1; i < sortedIndices.size (); ++i)
         {
-            // don't remap already mapped values
-            if (seen[entry] == 0)
+            if (sortedIndices[i].second == nextToInclude)
             {
-                mapping[currentIndex] = entry;
-                seen[entry]           = 1;
-                currentIndex++;
+                //
+                // this index can be treated as part of the current run, so extend the run to include it
+                //
+                RLEmapping.back ().second = sortedIndices[i].second;
+            }
+            else
+            {
+                pair<int, int> newEntry (
+                    sortedIndices[i].second, sortedIndices[i].second);
+                RLEmapping.push_back (newEntry);
+            }
+            // build mapping for this entry
+            stringIndices[sortedIndices[i].second] = i;
+
+            // what would the next entry have to be to be included in this run
+            // skip over already mapped strings
+            nextToInclude = sortedIndices[i].second + 1;
+
+            while (nextToInclude < int (stringIndices.size ()) &&
+                   stringIndices[nextToInclude] >= 0)
+            {
+                nextToInclude++;
             }
         }
     }
-
 #ifdef DUMP_TABLE
-    //
-    // dump mapping table for debugging
-    //
-    for (size_t i = 0; i < mapping.size (); ++i)
+    // dump RLE table for debugging
+    for (size_t i = 1; i < sortedIndices.size (); ++i)
     {
-        std::cout << i << ' ' << mapping[i] << std::endl;
+        std::cout << i << ' ' << sortedIndices[i].second << std::endl;
     }
 #endif
 
-    //
-    // number of manifest entries comes after string list
-    //
-    int manifestEntries;
+    // now compute size of uncompressed memory block for serialization
 
-    if (endOfData < data + 4)
-    {
-        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
-    }
+    int outputSize =
+        8; // at least need four bytes for integer to store number of channel manifests, plus four bytes to indicate version pattern
 
-    Xdr::read<CharPtrIO> (data, manifestEntries);
+    outputSize += stringTableSize;
 
-    _manifest.clear ();
+    //
+    // RLE mapping table size - number of entries followed by eight bytes for each run length
+    //
+    outputSize += RLEmapping.size () * 8 + 4;
 
-    _manifest.resize (manifestEntries);
+    //
+    // track which storage scheme is optimal for storing the IDs of each type
+    // ID storage scheme: 0 = 8 bytes per ID, 1 = 4 bytes per ID, 2 = variable
+    //
 
-    for (int manifestEntry = 0; manifestEntry < manifestEntries;
-         ++manifestEntry)
-    {
+    std::vector<char> storageSchemes;
 
-        ChannelGroupManifest& m = _manifest[manifestEntry];
+    for (size_t groupNumber = 0; groupNumber < groups.size (); ++groupNumber)
+    {
+        const SerialGroup& m = groups[groupNumber];
+        outputSize += getStringListSize (*m.channels); //size of channel group
+        outputSize +=
+            getStringListSize (*m.components); //size of component list
+        outputSize += 1;                       //size of lifetime enum
+        outputSize += getStringSize (*m.hashScheme);
+        outputSize += getStringSize (*m.encodingScheme);
 
-        //
-        // read header of this manifest entry
-        //
-        readStringList (data, endOfData, m._channels);
-        readStringList (data, endOfData, m._components);
+        outputSize += 1; // ID scheme
+        outputSize +=
+            4; // size of storage for number of 32 bit entries in ID table
 
-        char lifetime;
-        if (endOfData < data + 4)
+        uint64_t previousId                 = 0;
+        uint64_t IdStorageForVariableScheme = 0;
+        bool     canUse32Bits               = true;
+        for (size_t i = 0; i < m.ids.size (); ++i)
         {
-            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
-        }
-        Xdr::read<CharPtrIO> (data, lifetime);
-
-        m.setLifetime (IdLifetime (lifetime));
-        readPascalString (data, endOfData, m._hashScheme);
-        readPascalString (data, endOfData, m._encodingScheme);
 
-        if (endOfData < data + 5)
+            uint64_t idToStore = m.ids[i] - previousId;
+            IdStorageForVariableScheme +=
+                getVariableLengthIntegerSize (idToStore);
+            if (idToStore >= 1llu << 32) { canUse32Bits = false; }
+            previousId = m.ids[i];
+        }
+        for (size_t s = 0; s < m.text.size (); ++s)
         {
-            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+            outputSize +=
+                getVariableLengthIntegerSize (stringIndices[m.text[s]]);
         }
-        char storageScheme;
-        Xdr::read<CharPtrIO> (data, storageScheme);
-
-        int tableSize;
-        Xdr::read<CharPtrIO> (data, tableSize);
-
-        uint64_t previousId = 0;
-
-        for (int entry = 0; entry < tableSize; ++entry)
+        // pick best scheme to use to store IDs
+        if (canUse32Bits)
         {
-            uint64_t id;
-
-            switch (storageScheme)
+            if (IdStorageForVariableScheme < m.ids.size () * 4)
             {
-                case 0: {
-                    if (endOfData < data + 8)
-                    {
-                        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
-                    }
-                    Xdr::read<CharPtrIO> (data, id);
-                    break;
-                }
-                case 1: {
-                    if (endOfData < data + 4)
-                    {
-                        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
-                    }
-                    unsigned int id32;
-                    Xdr::read<CharPtrIO> (data, id32);
-                    id = id32;
-                    break;
-                }
-                default: {
-                    id = readVariableLengthInteger (data, endOfData);
-                }
+                //
+                // variable storage smaller than fixed 32 bit, so use that
+                //
+                storageSchemes.push_back (2);
+                outputSize += IdStorageForVariableScheme;
+            }
+            else
+            {
+                //
+                // variable scheme bigger than fixed 32 bit, but all ID differences fit into 32 bits
+                //
+                storageSchemes.push_back (1);
+                outputSize += m.ids.size () * 4;
+            }
+        }
+        else
+        {
+            if (IdStorageForVariableScheme < m.ids.size () * 8)
+            {
+                //
+                // variable storage smaller than fixed 64 bit, so use that
+                //
+                storageSchemes.push_back (2);
+                outputSize += IdStorageForVariableScheme;
+            }
+            else
+            {
+                //
+                // variable scheme bigger than fixed 64 bit, and some ID differences bigger than 32 bit
+                //
+                storageSchemes.push_back (0);
+                outputSize += m.ids.size () * 8;
             }
+        }
+    }
 
-            id += previousId;
-            previousId = id;
+    //
+    // resize output array
+    //
+    data.resize (outputSize);
 
-            //
-            // insert into table - insert tells us if it was already there
-            //
-            pair<map<uint64_t, vector<string>>::iterator, bool> insertion =
-                m._table.insert (make_pair (id, vector<string> ()));
-            if (insertion.second == false)
+    //
+    // populate output array
+    //
+    char* outPtr = &data[0];
+
+    //
+    // zeroes to indicate this is version 0 of the header
+    //
+    Xdr::write<CharPtrIO> (outPtr, int (0));
+
+    //
+    // table of strings: number of strings, all the lengths, then all the strings (see writeStringList)
+    //
+    Xdr::write<CharPtrIO> (outPtr, int (strings.size ()));
+    for (size_t index = 0; index < strings.size (); ++index)
+    {
+        size_t length = strings[index].size;
+        if (index > 0)
+        {
+            length = (strings[index - 1].size > 255 ? 2 : 1) +
+                     strings[index].size - common[index];
+        }
+        writeVariableLengthInteger (outPtr, length);
+    }
+    for (size_t index = 0; index < strings.size (); ++index)
+    {
+        size_t c = common[index];
+        if (index > 0)
+        {
+            if (strings[index - 1].size > 255)
             {
-                throw IEX_NAMESPACE::InputExc (
-                    "ID manifest contains multiple entries for the same ID");
+                //
+                // long previous string - use two bytes to encode number of common chars
+                //
+                *outPtr++ = char (c >> 8);
+                *outPtr++ = char (c & 255);
             }
-            (insertion.first)->second.resize (m.getComponents ().size ());
-            for (size_t i = 0; i < m.getComponents ().size (); ++i)
+            else { *outPtr++ = char (c); }
+        }
+        Xdr::write<CharPtrIO> (
+            outPtr, strings[index].str + c, int (strings[index].size - c));
+    }
+
+    //
+    // RLE block
+    //
+    Xdr::write<CharPtrIO> (outPtr, int (RLEmapping.size ()));
+    for (size_t i = 0; i < RLEmapping.size (); ++i)
+    {
+        Xdr::write<CharPtrIO> (outPtr, RLEmapping[i].first);
+        Xdr::write<CharPtrIO> (outPtr, RLEmapping[i].second);
+    }
+
+    //
+    // number of manifests
+    //
+    Xdr::write<CharPtrIO> (outPtr, int (groups.size ()));
+
+    for (size_t groupNumber = 0; groupNumber < groups.size (); ++groupNumber)
+    {
+        const SerialGroup& m          = groups[groupNumber];
+        size_t             components = m.components->size ();
+        //
+        // manifest header
+        //
+        writeStringList (outPtr, *m.channels);
+        writeStringList (outPtr, *m.components);
+        Xdr::write<CharPtrIO> (outPtr, char (m.lifeTime));
+        writePascalString (outPtr, *m.hashScheme);
+        writePascalString (outPtr, *m.encodingScheme);
+
+        char scheme = storageSchemes[groupNumber];
+        Xdr::write<CharPtrIO> (outPtr, scheme);
+
+        Xdr::write<CharPtrIO> (outPtr, int (m.ids.size ()));
+
+        uint64_t previousId = 0;
+        //
+        // table
+        //
+        for (size_t i = 0; i < m.ids.size (); ++i)
+        {
+
+            uint64_t idToWrite = m.ids[i] - previousId;
+            switch (scheme)
             {
-                int stringIndex = readVariableLengthInteger (data, endOfData);
-                if (size_t (stringIndex) > stringList.size () ||
-                    stringIndex < 0)
-                {
-                    throw IEX_NAMESPACE::InputExc (
-                        "Bad string index in IDManifest");
-                }
-                (insertion.first)->second[i] = stringList[mapping[stringIndex]];
+                case 0: Xdr::write<CharPtrIO> (outPtr, idToWrite); break;
+                case 1:
+                    Xdr::write<CharPtrIO> (outPtr, (unsigned int) idToWrite);
+                    break;
+                case 2: writeVariableLengthInteger (outPtr, idToWrite);
+            }
+
+            previousId = m.ids[i];
+
+            for (size_t s = 0; s < components; ++s)
+            {
+                writeVariableLengthInteger (
+                    outPtr, stringIndices[m.text[i * components + s]]);
             }
         }
     }
+    //
+    // check we've written the ID manifest correctly
+    //
+    if (outPtr != &data[0] + data.size ())
+    {
+        throw IEX_NAMESPACE::ArgExc ("Error - IDManifest size error");
+    }
 }
 
-IDManifest::IDManifest (const CompressedIDManifest& compressed)
+void
+uncompressManifest (const CompressedIDManifest& compressed, vector<char>& uncomp)
 {
     //
     // decompress the compressed manifest
     //
 
-    vector<char> uncomp (compressed._uncompressedDataSize);
-    size_t       outSize;
-    size_t       inSize = static_cast<size_t> (compressed._compressedDataSize);
+    uncomp.resize (compressed._uncompressedDataSize);
+    size_t outSize;
+    size_t inSize = static_cast<size_t> (compressed._compressedDataSize);
     if (EXR_ERR_SUCCESS != exr_uncompress_buffer (
                                nullptr,
                                compressed._data,
@@ -552,395 +704,353 @@ IDManifest::IDManifest (const CompressedIDManifest& compressed)
         throw IEX_NAMESPACE::InputExc (
             "IDManifest decompression (zlib) failed: mismatch in decompressed data size");
     }
+}
+
+void
+compressManifest (const vector<char>& serial, CompressedIDManifest& compressed)
+{
+    size_t outputSize = serial.size ();
+
+    //
+    // allocate a buffer which is guaranteed to be big enough for compression
+    //
+    size_t compressedBufferSize = exr_compress_max_buffer_size (outputSize);
+    size_t compressedDataSize;
+    compressed._data = (unsigned char*) malloc (compressedBufferSize);
+    if (EXR_ERR_SUCCESS != exr_compress_buffer (
+                               nullptr,
+                               -1,
+                               serial.data (),
+                               outputSize,
+                               compressed._data,
+                               compressedBufferSize,
+                               &compressedDataSize))
+    {
+        throw IEX_NAMESPACE::InputExc ("ID manifest compression failed");
+    }
+
+    // now call realloc to reallocate the buffer to a smaller size - this might free up memory
+    compressed._data =
+        (unsigned char*) realloc (compressed._data, compressedDataSize);
+
+    compressed._uncompressedDataSize = outputSize;
+    compressed._compressedDataSize   = compressedDataSize;
+}
+
+} // namespace
 
-    init ((const char*) &uncomp[0], (const char*) &uncomp[0] + outSize);
+IDManifest::IDManifest (const char* data, const char* endOfData)
+{
+    init (data, endOfData);
 }
 
 void
-IDManifest::serialize (std::vector<char>& data) const
+IDManifest::init (const char* data, const char* endOfData)
 {
 
-    indexedStringSet stringSet;
+    unsigned int version;
+    Xdr::read<CharPtrIO> (data, version);
+    if (version != 0)
+    {
+        throw IEX_NAMESPACE::InputExc ("Unrecognized IDmanifest version");
+    }
 
     //
-    // build string map - this turns unique strings into indices
-    // the manifest stores the string indices - this allows duplicated
-    // strings to point to the same place
-    // grabs all the strings regardless of which manifest/mapping they are in
+    // first comes list of all strings used in manifest
     //
-    // at this point we just count the manifest entries
+    vector<string> stringList;
+    readStringList (data, endOfData, stringList);
+
+    //
+    // expand the strings in the stringlist
+    // each string begins with number of characters to copy from the previous string
+    // the remainder is the 'new' bit that appears after that
     //
+
+    for (size_t i = 1; i < stringList.size (); ++i)
     {
+
+        size_t common; // number of characters in common with previous string
+        int    stringStart = 1; // first character of string itself;
         //
-        // over each channel group
+        // previous string had more than 255 characters?
         //
-        for (size_t m = 0; m < _manifest.size (); ++m)
+        if (stringList[i - 1].size () > 255)
         {
-            // over each mapping
-            for (IDManifest::ChannelGroupManifest::IDTable::const_iterator i =
-                     _manifest[m]._table.begin ();
-                 i != _manifest[m]._table.end ();
-                 ++i)
-            {
-                // over each string in the mapping
-
-                for (size_t s = 0; s < i->second.size (); ++s)
-                {
-                    stringSet[i->second[s]]++;
-                }
-            }
+            common = size_t (((unsigned char) (stringList[i][0])) << 8) +
+                     size_t ((unsigned char) (stringList[i][1]));
+            stringStart = 2;
+        }
+        else { common = (unsigned char) stringList[i][0]; }
+        if (common > stringList[i - 1].size ())
+        {
+            throw IEX_NAMESPACE::InputExc (
+                "Bad common string length in IDmanifest string table");
         }
+        stringList[i] = stringList[i - 1].substr (0, common) +
+                        stringList[i].substr (stringStart);
     }
 
     //
-    // build compressed string representation - all but first string starts with number of characters to copy from previous string.
-    // max 65535 bytes - use two bytes to store if previous string was more than 255 characters, big endian
+    // decode mapping table from indices in table to indices in string list
+    // the mapping uses smaller indices for more commonly occurring strings, since these are encoded with fewer bits
+    // comments in serialize function describe the format
     //
-    vector<string> prefixedStringList (stringSet.size ());
+
+    vector<int> mapping (stringList.size ());
 
     //
-    // also make a sorted list so the most common entry appears first. Keep equally likely entries in numerical order
+    // overlapping sequences: A list [(4,5),(3,6)] expands to 4,5,3,6 - because 4 and 5 are including already
+    // they are not included again
+    // the 'seen' list indicates which values have already been used, so they are not re-referenced
     //
-    vector<pair<int, int>> sortedIndices (stringSet.size ());
 
-    string prevString;
-    int    index = 0;
-    for (indexedStringSet::iterator i = stringSet.begin ();
-         i != stringSet.end ();
-         ++i)
+    vector<char> seen (stringList.size ());
+
+    int rleLength;
+    if (endOfData < data + 4)
     {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
 
-        // no prefix on first string - map stores index of each string, so use that rather than a counter;
-        if (index == 0) { prefixedStringList[index] = i->first; }
-        else
+    Xdr::read<CharPtrIO> (data, rleLength);
+
+    int currentIndex = 0;
+    for (int i = 0; i < rleLength; ++i)
+    {
+        int first;
+        int last;
+        if (endOfData < data + 8)
         {
-            size_t common = 0;
-            while (common < 65535 && common < prevString.size () &&
-                   common < i->first.size () &&
-                   prevString[common] == i->first[common])
-            {
-                ++common;
-            }
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        Xdr::read<CharPtrIO> (data, first);
+        Xdr::read<CharPtrIO> (data, last);
 
-            if (prevString.size () > 255)
-            {
-                //
-                // long previous string - use two bytes to encode number of common chars
-                //
-                prefixedStringList[index] = string (1, char (common >> 8)) +
-                                            string (1, char (common & 255)) +
-                                            i->first.substr (common);
-            }
-            else
+        if (first < 0 || last < 0 || first > last ||
+            first >= int (stringList.size ()) ||
+            last >= int (stringList.size ()))
+        {
+            throw IEX_NAMESPACE::InputExc (
+                "Bad mapping table entry in IDManifest");
+        }
+        for (int entry = first; entry <= last; entry++)
+        {
+            // don't remap already mapped values
+            if (seen[entry] == 0)
             {
-                prefixedStringList[index] =
-                    string (1, char (common)) + i->first.substr (common);
+                mapping[currentIndex] = entry;
+                seen[entry]           = 1;
+                currentIndex++;
             }
         }
-        prevString = i->first;
-        sortedIndices[index].first =
-            -i->second; // use negative of count so largest count appears first
-        sortedIndices[index].second = index;
-
-        //
-        // also, repurpose stringSet so that it maps from string names to indices in the string table
-        //
-        i->second = index;
-
-        index++;
     }
 
-    sort (sortedIndices.begin (), sortedIndices.end ());
-
-    //
-    // the first 1<<7 characters will all be encoded with 1 byte, regardless of how common they are
-    // the next 1<<14 characters will be encoded with 2 bytes
-    // (a full huffman encode would do this at the bit level, not the byte level)
+#ifdef DUMP_TABLE
     //
-    // the mapping table can be reduced in size by rewriting the IDs to exploit that
-    // can rearrange the IDs to have more long runs by sorting numbers
-    // that will need the same number of bytes to encode together
+    // dump mapping table for debugging
     //
+    for (size_t i = 0; i < mapping.size (); ++i)
     {
-        size_t i = 0;
-
-        for (; i < sortedIndices.size () && i < 1 << 7; ++i)
-        {
-            sortedIndices[i].first = 1;
-        }
-        for (; i < sortedIndices.size () && i < 1 << 14; ++i)
-        {
-            sortedIndices[i].first = 2;
-        }
-        for (; i < sortedIndices.size () && i < 1 << 21; ++i)
-        {
-            sortedIndices[i].first = 3;
-        }
-        for (; i < sortedIndices.size () && i < 1 << 28; ++i)
-        {
-            sortedIndices[i].first = 4;
-        }
-        for (; i < sortedIndices.size (); ++i)
-        {
-            sortedIndices[i].first = 5;
-        }
+        std::cout << i << ' ' << mapping[i] << std::endl;
     }
-    sort (sortedIndices.begin (), sortedIndices.end ());
-
-    vector<int> stringIndices (sortedIndices.size ());
+#endif
 
     //
-    // table will be stored with RLE encoding - store pairs of 'start index,end index'
-    // so, the sequence 10,11,12,1,2,3,4  is stored as [ (10,12) , (1,4)]
-    //
-    // sequential IDs ignore already referenced IDs, so the sequence  11,9,10,12,13 can be stored as [ (11,11) , (9,13)]
-    // on reading, don't reference an entry that has already been seen
-    // on writing, need to track which entries have already been stored to allow this overlapping to occur
+    // number of manifest entries comes after string list
     //
+    int manifestEntries;
 
-    vector<pair<int, int>> RLEmapping;
-
-    if (sortedIndices.size () > 0)
+    if (endOfData < data + 4)
     {
-        RLEmapping.resize (1);
-        RLEmapping[0].first  = sortedIndices[0].second;
-        RLEmapping[0].second = sortedIndices[0].second;
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
 
-        fill (stringIndices.begin (), stringIndices.end (), -1);
+    Xdr::read<CharPtrIO> (data, manifestEntries);
 
-        stringIndices[sortedIndices[0].second] = 0;
+    _manifest.clear ();
+
+    _manifest.resize (manifestEntries);
+
+    for (int manifestEntry = 0; manifestEntry < manifestEntries;
+         ++manifestEntry)
+    {
+
+        ChannelGroupManifest& m = _manifest[manifestEntry];
 
         //
-        // as the loop below runs, nextToInclude tracks the value that can be merged with the current run length
-        // (RLWmapping.back()) - generally this is on more than the current length, but it jumps forward
-        // over values already seen
+        // read header of this manifest entry
         //
-        int nextToInclude = stringIndices[sortedIndices[0].second] + 1;
+        readStringList (data, endOfData, m._channels);
+        readStringList (data, endOfData, m._components);
 
-        for (size_t i = 1; i < sortedIndices.size (); ++i)
+        char lifetime;
+        if (endOfData < data + 4)
         {
-            if (sortedIndices[i].second == nextToInclude)
-            {
-                //
-                // this index can be treated as part of the current run, so extend the run to include it
-                //
-                RLEmapping.back ().second = sortedIndices[i].second;
-            }
-            else
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        Xdr::read<CharPtrIO> (data, lifetime);
+
+        m.setLifetime (IdLifetime (lifetime));
+        readPascalString (data, endOfData, m._hashScheme);
+        readPascalString (data, endOfData, m._encodingScheme);
+
+        if (endOfData < data + 5)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        char storageScheme;
+        Xdr::read<CharPtrIO> (data, storageScheme);
+
+        int tableSize;
+        Xdr::read<CharPtrIO> (data, tableSize);
+
+        uint64_t previousId = 0;
+
+        for (int entry = 0; entry < tableSize; ++entry)
+        {
+            uint64_t id;
+
+            switch (storageScheme)
             {
-                pair<int, int> newEntry (
-                    sortedIndices[i].second, sortedIndices[i].second);
-                RLEmapping.push_back (newEntry);
+                case 0: {
+                    if (endOfData < data + 8)
+                    {
+                        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+                    }
+                    Xdr::read<CharPtrIO> (data, id);
+                    break;
+                }
+                case 1: {
+                    if (endOfData < data + 4)
+                    {
+                        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+                    }
+                    unsigned int id32;
+                    Xdr::read<CharPtrIO> (data, id32);
+                    id = id32;
+                    break;
+                }
+                default: {
+                    id = readVariableLengthInteger (data, endOfData);
+                }
             }
-            // build mapping for this entry
-            stringIndices[sortedIndices[i].second] = i;
 
-            // what would the next entry have to be to be included in this run
-            // skip over already mapped strings
-            nextToInclude = sortedIndices[i].second + 1;
+            id += previousId;
+            previousId = id;
 
-            while (nextToInclude < int (stringIndices.size ()) &&
-                   stringIndices[nextToInclude] >= 0)
+            //
+            // insert into table - insert tells us if it was already there
+            //
+            pair<map<uint64_t, vector<string>>::iterator, bool> insertion =
+                m._table.insert (make_pair (id, vector<string> ()));
+            if (insertion.second == false)
             {
-                nextToInclude++;
+                throw IEX_NAMESPACE::InputExc (
+                    "ID manifest contains multiple entries for the same ID");
+            }
+            (insertion.first)->second.resize (m.getComponents ().size ());
+            for (size_t i = 0; i < m.getComponents ().size (); ++i)
+            {
+                int stringIndex = readVariableLengthInteger (data, endOfData);
+                if (size_t (stringIndex) > stringList.size () ||
+                    stringIndex < 0)
+                {
+                    throw IEX_NAMESPACE::InputExc (
+                        "Bad string index in IDManifest");
+                }
+                (insertion.first)->second[i] = stringList[mapping[stringIndex]];
             }
         }
     }
-#ifdef DUMP_TABLE
-    // dump RLE table for debugging
-    for (size_t i = 1; i < sortedIndices.size (); ++i)
-    {
-        std::cout << i << ' ' << sortedIndices[i].second << std::endl;
-    }
-#endif
+}
 
-    // now compute size of uncompressed memory block for serialization
+IDManifest::IDManifest (const CompressedIDManifest& compressed)
+{
+    vector<char> uncomp;
+    uncompressManifest (compressed, uncomp);
+    init (uncomp.data (), uncomp.data () + uncomp.size ());
+}
 
-    int outputSize =
-        8; // at least need four bytes for integer to store number of channel manifests, plus four bytes to indicate version pattern
+void
+IDManifest::serialize (std::vector<char>& data) const
+{
 
-    outputSize += getStringListSize (prefixedStringList);
+    indexedStringSet stringSet;
 
     //
-    // RLE mapping table size - number of entries followed by eight bytes for each run length
+    // build string map - this turns unique strings into indices
+    // the manifest stores the string indices - this allows duplicated
+    // strings to point to the same place
+    // grabs all the strings regardless of which manifest/mapping they are in
     //
-    outputSize += RLEmapping.size () * 8 + 4;
+    // at this point we just count the manifest entries
+    //
+    {
+        //
+        // over each channel group
+        //
+        for (size_t m = 0; m < _manifest.size (); ++m)
+        {
+            // over each mapping
+            for (IDManifest::ChannelGroupManifest::IDTable::const_iterator i =
+                     _manifest[m]._table.begin ();
+                 i != _manifest[m]._table.end ();
+                 ++i)
+            {
+                // over each string in the mapping
+
+                for (size_t s = 0; s < i->second.size (); ++s)
+                {
+                    stringSet[i->second[s]]++;
+                }
+            }
+        }
+    }
 
     //
-    // track which storage scheme is optimal for storing the IDs of each type
-    // ID storage scheme: 0 = 8 bytes per ID, 1 = 4 bytes per ID, 2 = variable
+    // the map is sorted, so its order is the order of the string table;
+    // repurpose stringSet so that it maps from string names to indices in the string table
     //
+    vector<SerialString> strings;
+    strings.reserve (stringSet.size ());
+    for (indexedStringSet::iterator i = stringSet.begin ();
+         i != stringSet.end ();
+         ++i)
+    {
+        SerialString str = {i->first.data (), i->first.size (), i->second};
+        i->second        = int (strings.size ());
+        strings.push_back (str);
+    }
 
-    std::vector<char> storageSchemes;
-
+    vector<SerialGroup> groups (_manifest.size ());
     for (size_t groupNumber = 0; groupNumber < _manifest.size (); ++groupNumber)
     {
         const ChannelGroupManifest& m = _manifest[groupNumber];
-        outputSize += getStringListSize (m._channels); //size of channel group
-        outputSize +=
-            getStringListSize (m._components); //size of component list
-        outputSize += 1;                       //size of lifetime enum
-        outputSize += getStringSize (m._hashScheme);
-        outputSize += getStringSize (m._encodingScheme);
+        SerialGroup&                g = groups[groupNumber];
 
-        outputSize += 1; // ID scheme
-        outputSize +=
-            4; // size of storage for number of 32 bit entries in ID table
+        g.channels       = &m._channels;
+        g.components     = &m._components;
+        g.lifeTime       = m._lifeTime;
+        g.hashScheme     = &m._hashScheme;
+        g.encodingScheme = &m._encodingScheme;
+        g.ids.reserve (m._table.size ());
+        g.text.reserve (m._table.size () * m._components.size ());
 
-        uint64_t previousId                 = 0;
-        uint64_t IdStorageForVariableScheme = 0;
-        bool     canUse32Bits               = true;
         for (IDManifest::ChannelGroupManifest::IDTable::const_iterator i =
                  m._table.begin ();
              i != m._table.end ();
              ++i)
         {
-
-            uint64_t idToStore = i->first - previousId;
-            IdStorageForVariableScheme +=
-                getVariableLengthIntegerSize (idToStore);
-            if (idToStore >= 1llu << 32) { canUse32Bits = false; }
-            previousId = i->first;
-
+            g.ids.push_back (i->first);
             for (size_t s = 0; s < m._components.size (); ++s)
             {
-                int stringID  = stringSet[i->second[s]];
-                int idToWrite = stringIndices[stringID];
-                outputSize += getVariableLengthIntegerSize (idToWrite);
-            }
-        }
-        // pick best scheme to use to store IDs
-        if (canUse32Bits)
-        {
-            if (IdStorageForVariableScheme < m._table.size () * 4)
-            {
-                //
-                // variable storage smaller than fixed 32 bit, so use that
-                //
-                storageSchemes.push_back (2);
-                outputSize += IdStorageForVariableScheme;
-            }
-            else
-            {
-                //
-                // variable scheme bigger than fixed 32 bit, but all ID differences fit into 32 bits
-                //
-                storageSchemes.push_back (1);
-                outputSize += m._table.size () * 4;
-            }
-        }
-        else
-        {
-            if (IdStorageForVariableScheme < m._table.size () * 8)
-            {
-                //
-                // variable storage smaller than fixed 64 bit, so use that
-                //
-                storageSchemes.push_back (2);
-                outputSize += IdStorageForVariableScheme;
-            }
-            else
-            {
-                //
-                // variable scheme bigger than fixed 64 bit, and some ID differences bigger than 32 bit
-                //
-                storageSchemes.push_back (0);
-                outputSize += m._table.size () * 8;
+                g.text.push_back (stringSet[i->second[s]]);
             }
         }
     }
 
-    //
-    // resize output array
-    //
-    data.resize (outputSize);
-
-    //
-    // populate output array
-    //
-    char* outPtr = &data[0];
-
-    //
-    // zeroes to indicate this is version 0 of the header
-    //
-    Xdr::write<CharPtrIO> (outPtr, int (0));
-
-    //
-    // table of strings
-    //
-    writeStringList (outPtr, prefixedStringList);
-
-    //
-    // RLE block
-    //
-    Xdr::write<CharPtrIO> (outPtr, int (RLEmapping.size ()));
-    for (size_t i = 0; i < RLEmapping.size (); ++i)
-    {
-        Xdr::write<CharPtrIO> (outPtr, RLEmapping[i].first);
-        Xdr::write<CharPtrIO> (outPtr, RLEmapping[i].second);
-    }
-
-    //
-    // number of manifests
-    //
-    Xdr::write<CharPtrIO> (outPtr, int (_manifest.size ()));
-    int manifestIndex = 0;
-
-    for (size_t groupNumber = 0; groupNumber < _manifest.size (); ++groupNumber)
-    {
-        const ChannelGroupManifest& m = _manifest[groupNumber];
-        //
-        // manifest header
-        //
-        writeStringList (outPtr, m._channels);
-        writeStringList (outPtr, m._components);
-        Xdr::write<CharPtrIO> (outPtr, char (m._lifeTime));
-        writePascalString (outPtr, m._hashScheme);
-        writePascalString (outPtr, m._encodingScheme);
-
-        char scheme = storageSchemes[manifestIndex];
-        Xdr::write<CharPtrIO> (outPtr, scheme);
-
-        Xdr::write<CharPtrIO> (outPtr, int (m._table.size ()));
-
-        uint64_t previousId = 0;
-        //
-        // table
-        //
-        for (IDManifest::ChannelGroupManifest::IDTable::const_iterator i =
-                 m._table.begin ();
-             i != m._table.end ();
-             ++i)
-        {
-
-            uint64_t idToWrite = i->first - previousId;
-            switch (scheme)
-            {
-                case 0: Xdr::write<CharPtrIO> (outPtr, idToWrite); break;
-                case 1:
-                    Xdr::write<CharPtrIO> (outPtr, (unsigned int) idToWrite);
-                    break;
-                case 2: writeVariableLengthInteger (outPtr, idToWrite);
-            }
-
-            previousId = i->first;
-
-            for (size_t s = 0; s < m._components.size (); ++s)
-            {
-                int stringID  = stringSet[i->second[s]];
-                int idToWrite = stringIndices[stringID];
-                writeVariableLengthInteger (outPtr, idToWrite);
-            }
-        }
-        manifestIndex++;
-    }
-    //
-    // check we've written the ID manifest correctly
-    //
-    if (outPtr != &data[0] + data.size ())
-    {
-        throw IEX_NAMESPACE::ArgExc ("Error - IDManifest size error");
-    }
+    writeManifest (strings, groups, data);
 }
 
 bool
@@ -1061,31 +1171,16 @@ CompressedIDManifest::CompressedIDManifest (const IDManifest& manifest)
 
     manifest.serialize (serial);
 
-    size_t outputSize = serial.size ();
+    compressManifest (serial, *this);
+}
 
-    //
-    // allocate a buffer which is guaranteed to be big enough for compression
-    //
-    size_t compressedBufferSize = exr_compress_max_buffer_size (outputSize);
-    size_t compressedDataSize;
-    _data = (unsigned char*) malloc (compressedBufferSize);
-    if (EXR_ERR_SUCCESS != exr_compress_buffer (
-                               nullptr,
-                               -1,
-                               serial.data (),
-                               outputSize,
-                               _data,
-                               compressedBufferSize,
-                               &compressedDataSize))
-    {
-        throw IEX_NAMESPACE::InputExc ("ID manifest compression failed");
-    }
+CompressedIDManifest::CompressedIDManifest (const CompactIDManifest& manifest)
+{
+    std::vector<char> serial;
 
-    // now call realloc to reallocate the buffer to a smaller size - this might free up memory
-    _data = (unsigned char*) realloc (_data, compressedDataSize);
+    manifest.serialize (serial);
 
-    _uncompressedDataSize = outputSize;
-    _compressedDataSize   = compressedDataSize;
+    compressManifest (serial, *this);
 }
 
 IDManifest::ChannelGroupManifest::ChannelGroupManifest ()
@@ -1641,4 +1736,1271 @@ IDManifest::MurmurHash64 (const vector<string>& idString)
     return MurmurHash64 (str);
 }
 
+namespace
+{
+
+const uint32_t NOT_INTERNED = ~uint32_t (0);
+
+// the table size for a given number of entries, keeping the load below one half
+size_t
+slotsFor (size_t entries)
+{
+    size_t slots = 16;
+    while (slots < entries * 2)
+    {
+        slots *= 2;
+    }
+    return slots;
+}
+
+inline size_t
+hashId (uint64_t id)
+{
+    // IDs may be sequential rather than hashes, so mix the bits (splitmix64 finalizer)
+    id ^= id >> 30;
+    id *= 0xbf58476d1ce4e5b9ull;
+    id ^= id >> 27;
+    id *= 0x94d049bb133111ebull;
+    id ^= id >> 31;
+    return size_t (id);
+}
+
+inline size_t
+hashString (const char* str, size_t length)
+{
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < length; ++i)
+    {
+        h ^= (unsigned char) str[i];
+        h *= 0x100000001b3ull;
+    }
+    return size_t (h ^ (h >> 32));
+}
+
+// order strings as std::string does
+inline bool
+stringLess (const char* a, size_t alen, const char* b, size_t blen)
+{
+    int c = memcmp (a, b, std::min (alen, blen));
+    return c < 0 || (c == 0 && alen < blen);
+}
+
+} // namespace
+
+CompactIDManifest::ChannelGroup::ChannelGroup ()
+    : _lifeTime (IDManifest::LIFETIME_STABLE)
+    , _hashScheme (IDManifest::UNKNOWN)
+    , _encodingScheme (IDManifest::UNKNOWN)
+    , _stringOffsets (1, 0)
+{}
+
+void
+CompactIDManifest::ChannelGroup::setComponents (
+    const std::vector<std::string>& components)
+{
+    // if there are already entries in the table, cannot change the number of components
+    if (_ids.size () != 0 && components.size () != _components.size ())
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "attempt to change number of components in manifest once entries have been added");
+    }
+    _components = components;
+}
+
+void
+CompactIDManifest::ChannelGroup::setComponent (const std::string& component)
+{
+    vector<string> components (1);
+    components[0] = component;
+    setComponents (components);
+}
+
+void
+CompactIDManifest::ChannelGroup::rehashIds (size_t slots)
+{
+    _idSlots.assign (slots, 0);
+    size_t mask = slots - 1;
+    for (size_t e = 0; e < _ids.size (); ++e)
+    {
+        size_t h = hashId (_ids[e]) & mask;
+        while (_idSlots[h] != 0)
+        {
+            h = (h + 1) & mask;
+        }
+        _idSlots[h] = uint32_t (e + 1);
+    }
+}
+
+void
+CompactIDManifest::ChannelGroup::rehashStrings (size_t slots)
+{
+    _stringSlots.assign (slots, 0);
+    size_t mask = slots - 1;
+    for (size_t i = 0; i + 1 < _stringOffsets.size (); ++i)
+    {
+        size_t h = hashString (
+                       &_arena[_stringOffsets[i]],
+                       _stringOffsets[i + 1] - _stringOffsets[i] - 1) &
+                   mask;
+        while (_stringSlots[h] != 0)
+        {
+            h = (h + 1) & mask;
+        }
+        _stringSlots[h] = uint32_t (i + 1);
+    }
+}
+
+size_t
+CompactIDManifest::ChannelGroup::find (uint64_t idValue) const
+{
+    if (_idSlots.empty ()) { return npos; }
+
+    size_t mask = _idSlots.size () - 1;
+    size_t h    = hashId (idValue) & mask;
+    while (_idSlots[h] != 0)
+    {
+        size_t e = _idSlots[h] - 1;
+        if (_ids[e] == idValue) { return e; }
+        h = (h + 1) & mask;
+    }
+    return npos;
+}
+
+const char*
+CompactIDManifest::ChannelGroup::lookup (
+    uint64_t idValue, size_t component) const
+{
+    size_t e = find (idValue);
+    if (e == npos || component >= _components.size ()) { return nullptr; }
+    return text (e, component);
+}
+
+uint32_t
+CompactIDManifest::ChannelGroup::intern (const char* str, size_t length)
+{
+    size_t count = stringCount ();
+    if (_stringSlots.size () < (count + 1) * 2)
+    {
+        if (count >= size_t (NOT_INTERNED - 1))
+        {
+            THROW (IEX_NAMESPACE::ArgExc, "Too many strings in ID manifest");
+        }
+        rehashStrings (slotsFor (count + 1));
+    }
+
+    size_t mask = _stringSlots.size () - 1;
+    size_t h    = hashString (str, length) & mask;
+    while (_stringSlots[h] != 0)
+    {
+        uint32_t i = _stringSlots[h] - 1;
+        if (_stringOffsets[i + 1] - _stringOffsets[i] - 1 == length &&
+            memcmp (&_arena[_stringOffsets[i]], str, length) == 0)
+        {
+            return i;
+        }
+        h = (h + 1) & mask;
+    }
+
+    _stringSlots[h] = uint32_t (count + 1);
+    _arena.insert (_arena.end (), str, str + length);
+    _arena.push_back ('\0');
+    _stringOffsets.push_back (_arena.size ());
+    return uint32_t (count);
+}
+
+uint32_t
+CompactIDManifest::ChannelGroup::append (const char* str, size_t length)
+{
+    //
+    // add a string known not to be in the group yet. The string index
+    // is dropped, and rebuilt by the next call to intern()
+    //
+    size_t count = stringCount ();
+    if (count >= size_t (NOT_INTERNED - 1))
+    {
+        THROW (IEX_NAMESPACE::ArgExc, "Too many strings in ID manifest");
+    }
+    _stringSlots.clear ();
+    _arena.insert (_arena.end (), str, str + length);
+    _arena.push_back ('\0');
+    _stringOffsets.push_back (_arena.size ());
+    return uint32_t (count);
+}
+
+bool
+CompactIDManifest::ChannelGroup::insertEntry (
+    uint64_t idValue, const uint32_t* strings)
+{
+    size_t count = _ids.size ();
+    if (_idSlots.size () < (count + 1) * 2)
+    {
+        if (count >= size_t (NOT_INTERNED - 1))
+        {
+            THROW (IEX_NAMESPACE::ArgExc, "Too many entries in ID manifest");
+        }
+        rehashIds (slotsFor (count + 1));
+    }
+
+    size_t mask = _idSlots.size () - 1;
+    size_t h    = hashId (idValue) & mask;
+    while (_idSlots[h] != 0)
+    {
+        if (_ids[_idSlots[h] - 1] == idValue) { return false; }
+        h = (h + 1) & mask;
+    }
+
+    _idSlots[h] = uint32_t (count + 1);
+    _ids.push_back (idValue);
+    _text.insert (_text.end (), strings, strings + _components.size ());
+    return true;
+}
+
+void
+CompactIDManifest::ChannelGroup::reserve (size_t entries)
+{
+    _ids.reserve (entries);
+    _text.reserve (entries * _components.size ());
+    if (_idSlots.size () < entries * 2) { rehashIds (slotsFor (entries)); }
+}
+
+bool
+CompactIDManifest::ChannelGroup::insert (
+    uint64_t idValue, const std::vector<std::string>& text)
+{
+    if (_components.size () != text.size ())
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "mismatch between number of components in manifest and number of components in inserted entry");
+    }
+
+    // check first, so a rejected entry leaves no strings behind
+    if (find (idValue) != npos) { return false; }
+
+    uint32_t              local[8];
+    std::vector<uint32_t> large;
+    uint32_t*             strings = local;
+    if (text.size () > 8)
+    {
+        large.resize (text.size ());
+        strings = large.data ();
+    }
+
+    for (size_t c = 0; c < text.size (); ++c)
+    {
+        strings[c] = intern (text[c].data (), text[c].size ());
+    }
+    return insertEntry (idValue, strings);
+}
+
+bool
+CompactIDManifest::ChannelGroup::insert (
+    uint64_t idValue, const std::string& text)
+{
+    if (_components.size () != 1)
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Cannot insert single component attribute into manifest with multiple components");
+    }
+
+    if (find (idValue) != npos) { return false; }
+
+    uint32_t str = intern (text.data (), text.size ());
+    return insertEntry (idValue, &str);
+}
+
+uint64_t
+CompactIDManifest::ChannelGroup::insert (const std::vector<std::string>& text)
+{
+    uint64_t hash;
+    if (_hashScheme == IDManifest::MURMURHASH3_32)
+    {
+        hash = IDManifest::MurmurHash32 (text);
+    }
+    else if (_hashScheme == IDManifest::MURMURHASH3_64)
+    {
+        hash = IDManifest::MurmurHash64 (text);
+    }
+    else
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Cannot compute hash: unknown hashing scheme");
+    }
+    insert (hash, text);
+    return hash;
+}
+
+uint64_t
+CompactIDManifest::ChannelGroup::insert (const std::string& text)
+{
+    uint64_t hash;
+    if (_hashScheme == IDManifest::MURMURHASH3_32)
+    {
+        hash = IDManifest::MurmurHash32 (text);
+    }
+    else if (_hashScheme == IDManifest::MURMURHASH3_64)
+    {
+        hash = IDManifest::MurmurHash64 (text);
+    }
+    else
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Cannot compute hash: unknown hashing scheme");
+    }
+    insert (hash, text);
+    return hash;
+}
+
+CompactIDManifest::CompactIDManifest ()
+{}
+
+CompactIDManifest::CompactIDManifest (const char* data, const char* endOfData)
+{
+    init (data, endOfData);
+}
+
+CompactIDManifest::CompactIDManifest (const CompressedIDManifest& compressed)
+{
+    vector<char> uncomp;
+    uncompressManifest (compressed, uncomp);
+    init (uncomp.data (), uncomp.data () + uncomp.size ());
+}
+
+CompactIDManifest::CompactIDManifest (const IDManifest& manifest)
+{
+    _groups.resize (manifest.size ());
+    for (size_t g = 0; g < manifest.size (); ++g)
+    {
+        const IDManifest::ChannelGroupManifest& m     = manifest[g];
+        ChannelGroup&                           group = _groups[g];
+
+        group._channels       = m.getChannels ();
+        group._components     = m.getComponents ();
+        group._lifeTime       = m.getLifetime ();
+        group._hashScheme     = m.getHashScheme ();
+        group._encodingScheme = m.getEncodingScheme ();
+        group.reserve (m.size ());
+
+        for (IDManifest::ChannelGroupManifest::ConstIterator i = m.begin ();
+             i != m.end ();
+             ++i)
+        {
+            group.insert (i.id (), i.text ());
+        }
+    }
+}
+
+void
+CompactIDManifest::init (const char* data, const char* endOfData)
+{
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
+
+    unsigned int version;
+    Xdr::read<CharPtrIO> (data, version);
+    if (version != 0)
+    {
+        throw IEX_NAMESPACE::InputExc ("Unrecognized IDmanifest version");
+    }
+
+    //
+    // first comes list of all strings used in manifest, see
+    // IDManifest::init. They are expanded into a single buffer
+    //
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc (
+            "IDManifest too small for string list size");
+    }
+    int numberOfStrings;
+    Xdr::read<CharPtrIO> (data, numberOfStrings);
+
+    // each string needs at least one byte for its length
+    if (numberOfStrings < 0 || numberOfStrings > endOfData - data)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small for string list");
+    }
+
+    vector<size_t> offsets (numberOfStrings + 1, 0);
+    size_t         totalLength = 0;
+    for (int i = 0; i < numberOfStrings; ++i)
+    {
+        offsets[i + 1] = readVariableLengthInteger (data, endOfData);
+        if (offsets[i + 1] > size_t (endOfData - data))
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small for string");
+        }
+        totalLength += offsets[i + 1];
+    }
+    if (totalLength > size_t (endOfData - data))
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small for string");
+    }
+
+    vector<char> strings;
+    strings.reserve (totalLength);
+    for (int i = 0; i < numberOfStrings; ++i)
+    {
+        size_t length = offsets[i + 1];
+        size_t start  = strings.size ();
+
+        if (i == 0) { strings.insert (strings.end (), data, data + length); }
+        else
+        {
+            //
+            // each string begins with number of characters to copy from the previous string
+            //
+            size_t prevLength  = start - offsets[i - 1];
+            size_t common      = (unsigned char) data[0];
+            size_t stringStart = 1;
+            if (prevLength > 255)
+            {
+                if (length < 2)
+                {
+                    throw IEX_NAMESPACE::InputExc (
+                        "Bad common string length in IDmanifest string table");
+                }
+                common = (size_t ((unsigned char) data[0]) << 8) +
+                         size_t ((unsigned char) data[1]);
+                stringStart = 2;
+            }
+            if (length < stringStart || common > prevLength)
+            {
+                throw IEX_NAMESPACE::InputExc (
+                    "Bad common string length in IDmanifest string table");
+            }
+
+            strings.resize (start + common + length - stringStart);
+            memmove (&strings[start], &strings[offsets[i - 1]], common);
+            memcpy (
+                &strings[start + common],
+                data + stringStart,
+                length - stringStart);
+        }
+        data += length;
+        offsets[i] = start;
+    }
+    offsets[numberOfStrings] = strings.size ();
+
+    //
+    // decode mapping table from indices in table to indices in string list
+    //
+    vector<int>  mapping (numberOfStrings);
+    vector<char> seen (numberOfStrings);
+
+    int rleLength;
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
+
+    Xdr::read<CharPtrIO> (data, rleLength);
+
+    int currentIndex = 0;
+    for (int i = 0; i < rleLength; ++i)
+    {
+        int first;
+        int last;
+        if (endOfData < data + 8)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        Xdr::read<CharPtrIO> (data, first);
+        Xdr::read<CharPtrIO> (data, last);
+
+        if (first < 0 || last < 0 || first > last ||
+            first >= numberOfStrings || last >= numberOfStrings)
+        {
+            throw IEX_NAMESPACE::InputExc (
+                "Bad mapping table entry in IDManifest");
+        }
+        for (int entry = first; entry <= last; entry++)
+        {
+            // don't remap already mapped values
+            if (seen[entry] == 0)
+            {
+                mapping[currentIndex] = entry;
+                seen[entry]           = 1;
+                currentIndex++;
+            }
+        }
+    }
+
+    int manifestEntries;
+
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
+
+    Xdr::read<CharPtrIO> (data, manifestEntries);
+
+    if (manifestEntries < 0 || manifestEntries > endOfData - data)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
+
+    _groups.clear ();
+    _groups.resize (manifestEntries);
+
+    // index in the group's strings of each string of the table, once used
+    vector<uint32_t> interned (numberOfStrings);
+    vector<uint32_t> entryStrings;
+
+    for (int manifestEntry = 0; manifestEntry < manifestEntries;
+         ++manifestEntry)
+    {
+        ChannelGroup& m = _groups[manifestEntry];
+
+        //
+        // read header of this manifest entry
+        //
+        readStringList (data, endOfData, m._channels);
+        readStringList (data, endOfData, m._components);
+
+        char lifetime;
+        if (endOfData < data + 4)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        Xdr::read<CharPtrIO> (data, lifetime);
+
+        m.setLifetime (IDManifest::IdLifetime (lifetime));
+        readPascalString (data, endOfData, m._hashScheme);
+        readPascalString (data, endOfData, m._encodingScheme);
+
+        if (endOfData < data + 5)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        char storageScheme;
+        Xdr::read<CharPtrIO> (data, storageScheme);
+
+        int tableSize;
+        Xdr::read<CharPtrIO> (data, tableSize);
+
+        // every entry needs at least one byte
+        if (tableSize < 0 || tableSize > endOfData - data)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+
+        size_t components = m._components.size ();
+        m.reserve (tableSize);
+        entryStrings.resize (components);
+        fill (interned.begin (), interned.end (), NOT_INTERNED);
+
+        uint64_t previousId = 0;
+
+        for (int entry = 0; entry < tableSize; ++entry)
+        {
+            uint64_t id;
+
+            switch (storageScheme)
+            {
+                case 0: {
+                    if (endOfData < data + 8)
+                    {
+                        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+                    }
+                    Xdr::read<CharPtrIO> (data, id);
+                    break;
+                }
+                case 1: {
+                    if (endOfData < data + 4)
+                    {
+                        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+                    }
+                    unsigned int id32;
+                    Xdr::read<CharPtrIO> (data, id32);
+                    id = id32;
+                    break;
+                }
+                default: {
+                    id = readVariableLengthInteger (data, endOfData);
+                }
+            }
+
+            id += previousId;
+            previousId = id;
+
+            for (size_t i = 0; i < components; ++i)
+            {
+                uint64_t stringIndex =
+                    readVariableLengthInteger (data, endOfData);
+                if (stringIndex >= uint64_t (numberOfStrings))
+                {
+                    throw IEX_NAMESPACE::InputExc (
+                        "Bad string index in IDManifest");
+                }
+                int s = mapping[stringIndex];
+                if (interned[s] == NOT_INTERNED)
+                {
+                    // the strings of the table are distinct, so need no lookup
+                    interned[s] = m.append (
+                        strings.data () + offsets[s],
+                        offsets[s + 1] - offsets[s]);
+                }
+                entryStrings[i] = interned[s];
+            }
+
+            if (!m.insertEntry (id, entryStrings.data ()))
+            {
+                throw IEX_NAMESPACE::InputExc (
+                    "ID manifest contains multiple entries for the same ID");
+            }
+        }
+    }
+}
+
+size_t
+CompactIDManifest::find (const string& channel) const
+{
+    for (size_t i = 0; i < _groups.size (); ++i)
+    {
+        if (_groups[i]._channels.find (channel) != _groups[i]._channels.end ())
+        {
+            return i;
+        }
+    }
+    //  not find, return size()
+    return _groups.size ();
+}
+
+CompactIDManifest::ChannelGroup&
+CompactIDManifest::add (const set<string>& group)
+{
+    _groups.push_back (ChannelGroup ());
+    ChannelGroup& mfst = _groups.back ();
+    mfst._channels     = group;
+    return mfst;
+}
+
+CompactIDManifest::ChannelGroup&
+CompactIDManifest::add (const string& channel)
+{
+    _groups.push_back (ChannelGroup ());
+    ChannelGroup& mfst = _groups.back ();
+    mfst._channels.insert (channel);
+    return mfst;
+}
+
+void
+CompactIDManifest::serialize (std::vector<char>& data) const
+{
+    //
+    // the string table is shared by all groups: sort the strings of
+    // every group together, and count how often each one is used
+    //
+    vector<vector<int>>          uses (_groups.size ());
+    vector<pair<size_t, size_t>> order; // (group, string)
+    for (size_t g = 0; g < _groups.size (); ++g)
+    {
+        const ChannelGroup& m = _groups[g];
+        uses[g].assign (m.stringCount (), 0);
+        for (size_t t = 0; t < m._text.size (); ++t)
+        {
+            uses[g][m._text[t]]++;
+        }
+        for (size_t i = 0; i < m.stringCount (); ++i)
+        {
+            if (uses[g][i] > 0) { order.push_back (make_pair (g, i)); }
+        }
+    }
+
+    auto strOf = [this] (const pair<size_t, size_t>& r) {
+        const ChannelGroup& m = _groups[r.first];
+        return make_pair (
+            &m._arena[m._stringOffsets[r.second]],
+            m._stringOffsets[r.second + 1] - m._stringOffsets[r.second] - 1);
+    };
+
+    sort (
+        order.begin (),
+        order.end (),
+        [&strOf] (
+            const pair<size_t, size_t>& a, const pair<size_t, size_t>& b) {
+            auto sa = strOf (a);
+            auto sb = strOf (b);
+            return stringLess (sa.first, sa.second, sb.first, sb.second);
+        });
+
+    // index in the string table of each string of each group
+    vector<vector<int>>  tableIndex (_groups.size ());
+    vector<SerialString> strings;
+    for (size_t g = 0; g < _groups.size (); ++g)
+    {
+        tableIndex[g].resize (_groups[g].stringCount ());
+    }
+    for (size_t o = 0; o < order.size (); ++o)
+    {
+        auto str = strOf (order[o]);
+        int  use = uses[order[o].first][order[o].second];
+        if (strings.empty () || strings.back ().size != str.second ||
+            memcmp (strings.back ().str, str.first, str.second) != 0)
+        {
+            SerialString s = {str.first, str.second, use};
+            strings.push_back (s);
+        }
+        else { strings.back ().uses += use; }
+        tableIndex[order[o].first][order[o].second] = int (strings.size () - 1);
+    }
+
+    //
+    // entries are written in ID order
+    //
+    vector<SerialGroup> groups (_groups.size ());
+    vector<uint32_t>    entries;
+    for (size_t g = 0; g < _groups.size (); ++g)
+    {
+        const ChannelGroup& m          = _groups[g];
+        SerialGroup&        sg         = groups[g];
+        size_t              components = m._components.size ();
+
+        sg.channels       = &m._channels;
+        sg.components     = &m._components;
+        sg.lifeTime       = m._lifeTime;
+        sg.hashScheme     = &m._hashScheme;
+        sg.encodingScheme = &m._encodingScheme;
+
+        entries.resize (m._ids.size ());
+        for (size_t e = 0; e < entries.size (); ++e)
+        {
+            entries[e] = uint32_t (e);
+        }
+        sort (
+            entries.begin (), entries.end (), [&m] (uint32_t a, uint32_t b) {
+                return m._ids[a] < m._ids[b];
+            });
+
+        sg.ids.resize (entries.size ());
+        sg.text.resize (entries.size () * components);
+        for (size_t e = 0; e < entries.size (); ++e)
+        {
+            sg.ids[e] = m._ids[entries[e]];
+            for (size_t c = 0; c < components; ++c)
+            {
+                sg.text[e * components + c] =
+                    tableIndex[g][m.stringIndex (entries[e], c)];
+            }
+        }
+    }
+
+    writeManifest (strings, groups, data);
+}
+
+IDManifest
+CompactIDManifest::toIDManifest () const
+{
+    IDManifest     out;
+    vector<string> text;
+    for (size_t g = 0; g < _groups.size (); ++g)
+    {
+        const ChannelGroup&               m   = _groups[g];
+        IDManifest::ChannelGroupManifest& grp = out.add (m._channels);
+
+        grp.setComponents (m._components);
+        grp.setLifetime (m._lifeTime);
+        grp.setHashScheme (m._hashScheme);
+        grp.setEncodingScheme (m._encodingScheme);
+
+        text.resize (m._components.size ());
+        for (size_t e = 0; e < m.size (); ++e)
+        {
+            for (size_t c = 0; c < text.size (); ++c)
+            {
+                text[c].assign (m.text (e, c), m.textLength (e, c));
+            }
+            grp.insert (m._ids[e], text);
+        }
+    }
+    return out;
+}
+
+namespace
+{
+
+// entries of a LazyIDManifest channel group are indexed in blocks of
+const size_t LAZY_BLOCK_SIZE = 64;
+
+// LazyIDManifest::_stringCommon holds the number of common characters in
+// the low bits, and the number of bytes storing it in the top two
+const uint32_t COMMON_MASK  = 0xffff;
+const int      PREFIX_SHIFT = 30;
+
+uint64_t
+readEntryId (const char*& data, const char* endOfData, char storageScheme)
+{
+    switch (storageScheme)
+    {
+        case 0: {
+            if (endOfData < data + 8)
+            {
+                throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+            }
+            uint64_t id;
+            Xdr::read<CharPtrIO> (data, id);
+            return id;
+        }
+        case 1: {
+            if (endOfData < data + 4)
+            {
+                throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+            }
+            unsigned int id32;
+            Xdr::read<CharPtrIO> (data, id32);
+            return id32;
+        }
+        default: return readVariableLengthInteger (data, endOfData);
+    }
+}
+
+} // namespace
+
+LazyIDManifest::LazyIDManifest ()
+{}
+
+LazyIDManifest::LazyIDManifest (const CompressedIDManifest& compressed)
+{
+    uncompressManifest (compressed, _data);
+    index ();
+}
+
+LazyIDManifest::LazyIDManifest (const char* data, const char* endOfData)
+    : _data (data, endOfData)
+{
+    index ();
+}
+
+void
+LazyIDManifest::index ()
+{
+    const char* begin     = _data.data ();
+    const char* data      = begin;
+    const char* endOfData = begin + _data.size ();
+
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
+
+    unsigned int version;
+    Xdr::read<CharPtrIO> (data, version);
+    if (version != 0)
+    {
+        throw IEX_NAMESPACE::InputExc ("Unrecognized IDmanifest version");
+    }
+
+    //
+    // string table: see IDManifest::init. Only the position of each
+    // string and how much it shares with the previous one are recorded
+    //
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc (
+            "IDManifest too small for string list size");
+    }
+    int numberOfStrings;
+    Xdr::read<CharPtrIO> (data, numberOfStrings);
+
+    // each string needs at least one byte for its length
+    if (numberOfStrings < 0 || numberOfStrings > endOfData - data)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small for string list");
+    }
+
+    _stringOffsets.assign (numberOfStrings + 1, 0);
+    _stringCommon.assign (numberOfStrings, 0);
+    _stringShorter.assign (numberOfStrings, 0);
+
+    // the lengths are read into the offset of the next string
+    for (int i = 0; i < numberOfStrings; ++i)
+    {
+        _stringOffsets[i + 1] = readVariableLengthInteger (data, endOfData);
+    }
+
+    size_t offset     = data - begin;
+    size_t prevLength = 0;
+    for (int i = 0; i < numberOfStrings; ++i)
+    {
+        size_t length = _stringOffsets[i + 1];
+        if (length > _data.size () - offset)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small for string");
+        }
+
+        const unsigned char* str    = (const unsigned char*) begin + offset;
+        size_t               common = 0;
+        uint32_t             prefix = 0;
+        if (i > 0)
+        {
+            prefix = prevLength > 255 ? 2 : 1;
+            if (length < prefix)
+            {
+                throw IEX_NAMESPACE::InputExc (
+                    "Bad common string length in IDmanifest string table");
+            }
+            common = prefix == 2 ? (size_t (str[0]) << 8) + str[1] : str[0];
+            if (common > prevLength)
+            {
+                throw IEX_NAMESPACE::InputExc (
+                    "Bad common string length in IDmanifest string table");
+            }
+        }
+
+        _stringOffsets[i] = offset;
+        _stringCommon[i]  = uint32_t (common) | (prefix << PREFIX_SHIFT);
+
+        //
+        // the first 'common' characters of this string are those of the
+        // closest earlier string which shares fewer characters with its
+        // predecessor: record it, so decoding can skip the ones between
+        //
+        uint32_t shorter = 0;
+        if (common > 0)
+        {
+            shorter = uint32_t (i - 1);
+            while (shorter > 0 &&
+                   (_stringCommon[shorter] & COMMON_MASK) >= common)
+            {
+                shorter = _stringShorter[shorter];
+            }
+        }
+        _stringShorter[i] = shorter;
+
+        prevLength = common + length - prefix;
+        offset += length;
+    }
+    _stringOffsets[numberOfStrings] = offset;
+    data                            = begin + offset;
+
+    //
+    // decode mapping table from indices in table to indices in string list
+    //
+    _mapping.assign (numberOfStrings, 0);
+    vector<char> seen (numberOfStrings);
+
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
+
+    int rleLength;
+    Xdr::read<CharPtrIO> (data, rleLength);
+
+    int currentIndex = 0;
+    for (int i = 0; i < rleLength; ++i)
+    {
+        int first;
+        int last;
+        if (endOfData < data + 8)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        Xdr::read<CharPtrIO> (data, first);
+        Xdr::read<CharPtrIO> (data, last);
+
+        if (first < 0 || last < 0 || first > last ||
+            first >= numberOfStrings || last >= numberOfStrings)
+        {
+            throw IEX_NAMESPACE::InputExc (
+                "Bad mapping table entry in IDManifest");
+        }
+        for (int entry = first; entry <= last; entry++)
+        {
+            // don't remap already mapped values
+            if (seen[entry] == 0)
+            {
+                _mapping[currentIndex] = entry;
+                seen[entry]            = 1;
+                currentIndex++;
+            }
+        }
+    }
+
+    int manifestEntries;
+
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
+
+    Xdr::read<CharPtrIO> (data, manifestEntries);
+
+    if (manifestEntries < 0 || manifestEntries > endOfData - data)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
+
+    _groups.clear ();
+    _groups.resize (manifestEntries);
+
+    for (int manifestEntry = 0; manifestEntry < manifestEntries;
+         ++manifestEntry)
+    {
+        ChannelGroup& m = _groups[manifestEntry];
+
+        readStringList (data, endOfData, m._channels);
+        readStringList (data, endOfData, m._components);
+
+        char lifetime;
+        if (endOfData < data + 4)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        Xdr::read<CharPtrIO> (data, lifetime);
+
+        m._lifeTime = IDManifest::IdLifetime (lifetime);
+        readPascalString (data, endOfData, m._hashScheme);
+        readPascalString (data, endOfData, m._encodingScheme);
+
+        if (endOfData < data + 5)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        Xdr::read<CharPtrIO> (data, m._storageScheme);
+
+        int tableSize;
+        Xdr::read<CharPtrIO> (data, tableSize);
+
+        // every entry needs at least one byte
+        if (tableSize < 0 || tableSize > endOfData - data)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+
+        m._entries = tableSize;
+        m._blockIds.reserve (
+            (tableSize + LAZY_BLOCK_SIZE - 1) / LAZY_BLOCK_SIZE);
+        m._blockOffsets.reserve (m._blockIds.capacity ());
+
+        //
+        // skip over the entries, recording where each block starts. This
+        // only finds entries if they are in ID order, as they are when
+        // written by serialize(), so note whether they are
+        //
+        const char* tableStart = data;
+        size_t      components = m._components.size ();
+        uint64_t    previousId = 0;
+        bool        ordered    = true;
+        for (int entry = 0; entry < tableSize; ++entry)
+        {
+            size_t   entryOffset = data - begin;
+            uint64_t id =
+                previousId + readEntryId (data, endOfData, m._storageScheme);
+
+            if (entry > 0 && id <= previousId)
+            {
+                if (id == previousId)
+                {
+                    throw IEX_NAMESPACE::InputExc (
+                        "ID manifest contains multiple entries for the same ID");
+                }
+                ordered = false;
+            }
+            if (entry % LAZY_BLOCK_SIZE == 0)
+            {
+                m._blockIds.push_back (id);
+                m._blockOffsets.push_back (entryOffset);
+            }
+            previousId = id;
+
+            for (size_t i = 0; i < components; ++i)
+            {
+                uint64_t stringIndex =
+                    readVariableLengthInteger (data, endOfData);
+                if (stringIndex >= uint64_t (numberOfStrings))
+                {
+                    throw IEX_NAMESPACE::InputExc (
+                        "Bad string index in IDManifest");
+                }
+            }
+        }
+
+        if (ordered) { continue; }
+
+        //
+        // the entries were written in some other order (IDManifest::init
+        // accepts any): sort them all instead, as the blocks can't be
+        // searched. The data was validated above
+        //
+        m._blockIds.clear ();
+        m._blockOffsets.clear ();
+        m._sortedEntries.reserve (tableSize);
+
+        const char* entryData = tableStart;
+        previousId            = 0;
+        for (int entry = 0; entry < tableSize; ++entry)
+        {
+            uint64_t id = previousId +
+                          readEntryId (entryData, endOfData, m._storageScheme);
+            m._sortedEntries.push_back (
+                make_pair (id, size_t (entryData - begin)));
+            previousId = id;
+
+            for (size_t i = 0; i < components; ++i)
+            {
+                readVariableLengthInteger (entryData, endOfData);
+            }
+        }
+
+        sort (m._sortedEntries.begin (), m._sortedEntries.end ());
+        for (size_t i = 1; i < m._sortedEntries.size (); ++i)
+        {
+            if (m._sortedEntries[i].first == m._sortedEntries[i - 1].first)
+            {
+                throw IEX_NAMESPACE::InputExc (
+                    "ID manifest contains multiple entries for the same ID");
+            }
+        }
+    }
+}
+
+const char*
+LazyIDManifest::findEntry (size_t group, uint64_t idValue) const
+{
+    if (group >= _groups.size ())
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Invalid channel group " << group << " in ID manifest with "
+                                     << _groups.size () << " groups");
+    }
+
+    const ChannelGroup& m = _groups[group];
+
+    if (!m._sortedEntries.empty ())
+    {
+        vector<pair<uint64_t, size_t>>::const_iterator e = lower_bound (
+            m._sortedEntries.begin (),
+            m._sortedEntries.end (),
+            make_pair (idValue, size_t (0)));
+        if (e == m._sortedEntries.end () || e->first != idValue)
+        {
+            return nullptr;
+        }
+        return _data.data () + e->second;
+    }
+
+    vector<uint64_t>::const_iterator b =
+        upper_bound (m._blockIds.begin (), m._blockIds.end (), idValue);
+    if (b == m._blockIds.begin ()) { return nullptr; }
+
+    size_t      block     = (b - m._blockIds.begin ()) - 1;
+    const char* data      = _data.data () + m._blockOffsets[block];
+    const char* endOfData = _data.data () + _data.size ();
+    size_t      entries =
+        std::min (LAZY_BLOCK_SIZE, m._entries - block * LAZY_BLOCK_SIZE);
+    size_t components = m._components.size ();
+
+    uint64_t id = 0;
+    for (size_t entry = 0; entry < entries; ++entry)
+    {
+        uint64_t delta = readEntryId (data, endOfData, m._storageScheme);
+        id             = entry == 0 ? m._blockIds[block] : id + delta;
+
+        if (id == idValue) { return data; }
+        if (id > idValue) { return nullptr; }
+
+        for (size_t i = 0; i < components; ++i)
+        {
+            readVariableLengthInteger (data, endOfData);
+        }
+    }
+    return nullptr;
+}
+
+void
+LazyIDManifest::decodeString (uint64_t index, std::string& out) const
+{
+    //
+    // the characters of a string not shared with the previous string
+    // are stored with it, the others come from earlier strings
+    //
+    size_t prefix = _stringCommon[index] >> PREFIX_SHIFT;
+    size_t common = _stringCommon[index] & COMMON_MASK;
+    size_t needed = common + _stringOffsets[index + 1] -
+                    _stringOffsets[index] - prefix;
+
+    out.resize (needed);
+    while (needed > 0)
+    {
+        prefix = _stringCommon[index] >> PREFIX_SHIFT;
+        common = _stringCommon[index] & COMMON_MASK;
+        if (common < needed)
+        {
+            memcpy (
+                &out[common],
+                _data.data () + _stringOffsets[index] + prefix,
+                needed - common);
+            needed = common;
+        }
+        index = _stringShorter[index];
+    }
+}
+
+size_t
+LazyIDManifest::find (const string& channel) const
+{
+    for (size_t i = 0; i < _groups.size (); ++i)
+    {
+        if (_groups[i]._channels.find (channel) != _groups[i]._channels.end ())
+        {
+            return i;
+        }
+    }
+    //  not find, return size()
+    return _groups.size ();
+}
+
+bool
+LazyIDManifest::contains (size_t group, uint64_t idValue) const
+{
+    return findEntry (group, idValue) != nullptr;
+}
+
+bool
+LazyIDManifest::lookup (
+    size_t group, uint64_t idValue, std::vector<std::string>& text) const
+{
+    const char* data = findEntry (group, idValue);
+    if (!data) { return false; }
+
+    const char* endOfData = _data.data () + _data.size ();
+    text.resize (_groups[group]._components.size ());
+    for (size_t i = 0; i < text.size (); ++i)
+    {
+        decodeString (
+            _mapping[readVariableLengthInteger (data, endOfData)], text[i]);
+    }
+    return true;
+}
+
+bool
+LazyIDManifest::lookup (
+    size_t group, uint64_t idValue, size_t component, std::string& text) const
+{
+    const char* data = findEntry (group, idValue);
+    if (!data || component >= _groups[group]._components.size ())
+    {
+        return false;
+    }
+
+    const char* endOfData = _data.data () + _data.size ();
+    for (size_t i = 0; i < component; ++i)
+    {
+        readVariableLengthInteger (data, endOfData);
+    }
+    decodeString (
+        _mapping[readVariableLengthInteger (data, endOfData)], text);
+    return true;
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -15,6 +15,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
@@ -310,6 +311,8 @@ public:
     //
     IMF_EXPORT
     CompressedIDManifest (const IDManifest& manifest);
+    IMF_EXPORT
+    CompressedIDManifest (const CompactIDManifest& manifest);
 
     IMF_EXPORT
     ~CompressedIDManifest ();
@@ -319,6 +322,334 @@ public:
     unsigned char* _data;
 };
 
+//
+// CompactIDManifest holds the same information as IDManifest, laid out
+// for manifests with very many IDs (e.g. Cryptomatte): the text of
+// each channel group is stored once per distinct string in a single
+// string arena, entries refer to it by index, and IDs are found
+// through an open addressing hash table rather than a std::map.
+// Decoding, looking up, inserting and serializing entries do not
+// allocate per entry.
+//
+// Entries can be inserted but not modified or removed, and are kept
+// in insertion order; serialize() sorts them by ID, and produces the
+// same data as IDManifest::serialize() for the same content.
+//
+class IMF_EXPORT_TYPE CompactIDManifest
+{
+public:
+    class IMF_EXPORT_TYPE ChannelGroup
+    {
+    public:
+        static constexpr size_t npos = ~size_t (0);
+
+        IMF_EXPORT
+        ChannelGroup ();
+
+        const std::set<std::string>& getChannels () const { return _channels; }
+        void setChannels (const std::set<std::string>& channels)
+        {
+            _channels = channels;
+        }
+
+        const std::vector<std::string>& getComponents () const
+        {
+            return _components;
+        }
+
+        // throws an exception if there are already entries in the table
+        // and the number of components changes
+        IMF_EXPORT
+        void setComponents (const std::vector<std::string>& components);
+
+        // set a single component
+        IMF_EXPORT
+        void setComponent (const std::string& component);
+
+        IDManifest::IdLifetime getLifetime () const { return _lifeTime; }
+        void setLifetime (IDManifest::IdLifetime lifeTime)
+        {
+            _lifeTime = lifeTime;
+        }
+
+        const std::string& getHashScheme () const { return _hashScheme; }
+        void               setHashScheme (const std::string& hashScheme)
+        {
+            _hashScheme = hashScheme;
+        }
+
+        const std::string& getEncodingScheme () const
+        {
+            return _encodingScheme;
+        }
+        void setEncodingScheme (const std::string& encodingScheme)
+        {
+            _encodingScheme = encodingScheme;
+        }
+
+        // number of entries
+        size_t size () const { return _ids.size (); }
+
+        // number of distinct strings used by the entries
+        size_t stringCount () const { return _stringOffsets.size () - 1; }
+
+        // index of the entry with the given ID, or npos
+        IMF_EXPORT
+        size_t find (uint64_t idValue) const;
+
+        bool contains (uint64_t idValue) const
+        {
+            return find (idValue) != npos;
+        }
+
+        // ID of the given entry
+        uint64_t id (size_t entry) const { return _ids[entry]; }
+
+        // nul terminated text of a component of the given entry.
+        // Valid until the next insertion into this channel group
+        const char* text (size_t entry, size_t component) const
+        {
+            return &_arena[_stringOffsets[stringIndex (entry, component)]];
+        }
+
+        // length of the text of a component of the given entry
+        size_t textLength (size_t entry, size_t component) const
+        {
+            uint32_t s = stringIndex (entry, component);
+            return _stringOffsets[s + 1] - _stringOffsets[s] - 1;
+        }
+
+        // text of a component of the entry with the given ID, or nullptr
+        IMF_EXPORT
+        const char* lookup (uint64_t idValue, size_t component = 0) const;
+
+        // insert a new entry - text must contain same number of items
+        // as getComponents. Returns false, and leaves the table
+        // unchanged, if the ID is already present
+        IMF_EXPORT
+        bool insert (uint64_t idValue, const std::vector<std::string>& text);
+
+        // insert a new entry - getComponents must be a single entry
+        IMF_EXPORT
+        bool insert (uint64_t idValue, const std::string& text);
+
+        // compute hash of given entry, insert into manifest, and return
+        // the computed hash. Exception will be thrown if hash scheme isn't recognised
+        IMF_EXPORT
+        uint64_t insert (const std::vector<std::string>& text);
+        IMF_EXPORT
+        uint64_t insert (const std::string& text);
+
+        // preallocate for the given number of entries
+        IMF_EXPORT
+        void reserve (size_t entries);
+
+    private:
+        uint32_t stringIndex (size_t entry, size_t component) const
+        {
+            return _text[entry * _components.size () + component];
+        }
+
+        uint32_t intern (const char* str, size_t length);
+        uint32_t append (const char* str, size_t length);
+        bool     insertEntry (uint64_t idValue, const uint32_t* strings);
+        void     rehashIds (size_t slots);
+        void     rehashStrings (size_t slots);
+
+        std::set<std::string>    _channels;
+        std::vector<std::string> _components;
+        IDManifest::IdLifetime   _lifeTime;
+        std::string              _hashScheme;
+        std::string              _encodingScheme;
+
+        std::vector<uint64_t> _ids;  // ID of each entry
+        std::vector<uint32_t> _text; // string of each component of each entry
+        std::vector<uint32_t> _idSlots; // entry index + 1, 0 when empty
+
+        std::vector<char>     _arena;         // nul terminated strings
+        std::vector<size_t>   _stringOffsets; // start of each string, then end
+        std::vector<uint32_t> _stringSlots;   // string index + 1, 0 when empty
+
+        friend class CompactIDManifest;
+    };
+
+    IMF_EXPORT
+    CompactIDManifest ();
+
+    //
+    // decompress a compressed IDManifest
+    //
+    IMF_EXPORT
+    explicit CompactIDManifest (const CompressedIDManifest& compressed);
+
+    //
+    // construct manifest from serialized representation stored at 'data'
+    //
+    IMF_EXPORT
+    CompactIDManifest (const char* data, const char* end);
+
+    IMF_EXPORT
+    explicit CompactIDManifest (const IDManifest& manifest);
+
+    // number of channel groups
+    size_t size () const { return _groups.size (); }
+
+    // find the first channel group that defines the given channel
+    // if channel not find, returns a value equal to size()
+    IMF_EXPORT
+    size_t find (const std::string& channel) const;
+
+    const ChannelGroup& operator[] (size_t index) const
+    {
+        return _groups[index];
+    }
+    ChannelGroup& operator[] (size_t index) { return _groups[index]; }
+
+    // add an empty channel group for the given channels
+    IMF_EXPORT
+    ChannelGroup& add (const std::set<std::string>& group);
+    IMF_EXPORT
+    ChannelGroup& add (const std::string& channel);
+
+    //
+    // serialize manifest into data array. Array will be resized to the required size
+    //
+    IMF_EXPORT
+    void serialize (std::vector<char>& data) const;
+
+    // convert to an IDManifest, e.g. to modify or merge entries
+    IMF_EXPORT
+    IDManifest toIDManifest () const;
+
+private:
+    IMF_HIDDEN void init (const char* data, const char* end);
+
+    std::vector<ChannelGroup> _groups;
+};
+
+//
+// LazyIDManifest resolves individual IDs of a serialized manifest
+// without decoding all of it, for tools which only need a few entries
+// of a large manifest (e.g. the objects under the cursor).
+//
+// It keeps the uncompressed data, and builds a sparse index of the
+// entries and of the shared string table in a single pass, which
+// validates the data but does not decode any strings or allocate per
+// entry. A lookup then decodes at most one block of entries and the
+// strings it returns. Groups whose entries are not stored in ID order
+// (serialize() always sorts them, but other writers need not) are
+// indexed by a sorted table of every entry instead.
+//
+// Lookups do not modify the manifest, so may be made from several
+// threads at once.
+//
+class IMF_EXPORT_TYPE LazyIDManifest
+{
+public:
+    class IMF_EXPORT_TYPE ChannelGroup
+    {
+    public:
+        const std::set<std::string>& getChannels () const { return _channels; }
+        const std::vector<std::string>& getComponents () const
+        {
+            return _components;
+        }
+        IDManifest::IdLifetime getLifetime () const { return _lifeTime; }
+        const std::string&     getHashScheme () const { return _hashScheme; }
+        const std::string&     getEncodingScheme () const
+        {
+            return _encodingScheme;
+        }
+
+        // number of entries
+        size_t size () const { return _entries; }
+
+    private:
+        friend class LazyIDManifest;
+
+        std::set<std::string>    _channels;
+        std::vector<std::string> _components;
+        IDManifest::IdLifetime   _lifeTime = IDManifest::LIFETIME_STABLE;
+        std::string              _hashScheme;
+        std::string              _encodingScheme;
+
+        char   _storageScheme = 0;
+        size_t _entries       = 0;
+
+        // first ID and offset of each block of entries
+        std::vector<uint64_t> _blockIds;
+        std::vector<size_t>   _blockOffsets;
+
+        // ID and offset of the text of each entry, sorted by ID, for
+        // groups whose entries are not stored in ID order
+        std::vector<std::pair<uint64_t, size_t>> _sortedEntries;
+    };
+
+    IMF_EXPORT
+    LazyIDManifest ();
+
+    IMF_EXPORT
+    explicit LazyIDManifest (const CompressedIDManifest& compressed);
+
+    //
+    // indexes the data from the given pointer; the data is copied
+    //
+    IMF_EXPORT
+    LazyIDManifest (const char* data, const char* end);
+
+    // number of channel groups
+    size_t size () const { return _groups.size (); }
+
+    // find the first channel group that defines the given channel
+    // if channel not find, returns a value equal to size()
+    IMF_EXPORT
+    size_t find (const std::string& channel) const;
+
+    const ChannelGroup& operator[] (size_t index) const
+    {
+        return _groups[index];
+    }
+
+    // true if the given channel group has an entry for the ID
+    IMF_EXPORT
+    bool contains (size_t group, uint64_t idValue) const;
+
+    //
+    // text of all components of the entry for the ID in the given
+    // channel group. Returns false, leaving text unchanged, if there
+    // is no such entry. Reusing text between calls avoids allocation
+    //
+    IMF_EXPORT
+    bool lookup (
+        size_t group, uint64_t idValue, std::vector<std::string>& text) const;
+
+    // text of one component of the entry for the ID
+    IMF_EXPORT
+    bool lookup (
+        size_t       group,
+        uint64_t     idValue,
+        size_t       component,
+        std::string& text) const;
+
+private:
+    IMF_HIDDEN void        index ();
+    IMF_HIDDEN const char* findEntry (size_t group, uint64_t idValue) const;
+    IMF_HIDDEN void        decodeString (uint64_t index, std::string& out) const;
+
+    std::vector<char> _data;
+
+    // for each string of the shared table: offset in the data, number
+    // of characters shared with the previous string (and of bytes used
+    // to store that), and the closest earlier string sharing fewer
+    // characters
+    std::vector<size_t>   _stringOffsets;
+    std::vector<uint32_t> _stringCommon;
+    std::vector<uint32_t> _stringShorter;
+    std::vector<uint32_t> _mapping;
+
+    std::vector<ChannelGroup> _groups;
+};
+
 //
 // Read/Write Iterator object to access individual entries within a manifest
 //
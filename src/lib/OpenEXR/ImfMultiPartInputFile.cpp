@@ -45,10 +45,33 @@ struct MultiPartInputFile::Data
     {
         InputPartData data;
         std::any file;
+        bool haveHeader = false;
     };
     std::vector<Part> parts;
+    bool tiled = false;
+    bool autoAddType = true;
+
+    // the C++ header of a part is only materialized on first use, so
+    // header-only scans through headerView () never pay for the copy;
+    // callers must hold _mx
+    InputPartData& partData (const Context& ctxt, int n);
 };
 
+InputPartData&
+MultiPartInputFile::Data::partData (const Context& ctxt, int n)
+{
+    Part& p = parts[n];
+    if (!p.haveHeader)
+    {
+        p.data.header = ctxt.header (n);
+
+        if (autoAddType && !p.data.header.hasType ())
+            p.data.header.setType (tiled ? TILEDIMAGE : SCANLINEIMAGE);
+        p.haveHeader = true;
+    }
+    return p.data;
+}
+
 ////////////////////////////////////////
 
 MultiPartInputFile::MultiPartInputFile (
@@ -59,21 +82,17 @@ MultiPartInputFile::MultiPartInputFile (
     : _ctxt (filename, ctxtinit, Context::read_mode_t{})
     , _data (std::make_shared<Data> ())
 {
-    int version = _ctxt.version ();
     int pc = _ctxt.partCount ();
     _data->parts.resize (pc);
+    _data->tiled       = isTiled (_ctxt.version ());
+    _data->autoAddType = autoAddType;
 
     for ( int p = 0; p < pc; ++p )
     {
-        _data->parts[p].data = InputPartData (_ctxt, p, numThreads);
-
-        if (autoAddType && ! _data->parts[p].data.header.hasType ())
-        {
-            if (isTiled (version))
-                _data->parts[p].data.header.setType (TILEDIMAGE);
-            else
-                _data->parts[p].data.header.setType (SCANLINEIMAGE);
-        }
+        InputPartData& d = _data->parts[p].data;
+        d.numThreads     = numThreads;
+        d.partNumber     = p;
+        d.context        = _ctxt;
     }
 }
 
@@ -127,6 +146,12 @@ MultiPartInputFile::header (int partNumber) const
     return getPart (partNumber)->header;
 }
 
+HeaderView
+MultiPartInputFile::headerView (int partNumber) const
+{
+    return HeaderView (_ctxt, partNumber);
+}
+
 void
 MultiPartInputFile::flushPartCache ()
 {
@@ -165,7 +190,7 @@ MultiPartInputFile::getInputPart (int partNumber)
         // TODO: change to copy / value semantics
         // stupid make_shared and friend functions, can we remove this restriction?
         // f = std::make_shared<T> (&(_data->parts[partNumber].data));
-        f.reset (new T (&(_data->parts[partNumber].data)));
+        f.reset (new T (&(_data->partData (_ctxt, partNumber))));
         _data->parts[partNumber].file = f;
     }
     else
@@ -192,7 +217,11 @@ MultiPartInputFile::getPart (int n) const
             "MultiPartInputFile::getPart called with invalid part "
                 << n << " on file with " << _data->parts.size () << " parts");
     }
-    return &(_data->parts[n].data);
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (_data->_mx);
+#endif
+    return &(_data->partData (_ctxt, n));
 }
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -11,6 +11,7 @@
 #include "ImfThreading.h"
 
 #include "ImfContext.h"
+#include "ImfHeaderView.h"
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 
@@ -71,6 +72,15 @@ public:
     IMF_EXPORT
     const Header& header (int partNumber) const;
 
+    //------------------------------------------------------
+    // Read-only view of a part's header, read directly from
+    // the parsed file without copying any attributes. Prefer
+    // this over header () when only inspecting metadata.
+    //------------------------------------------------------
+
+    IMF_EXPORT
+    HeaderView headerView (int partNumber) const;
+
     // =----------------------------------------
     // Check whether the entire chunk offset
     // table for the part is written correctly
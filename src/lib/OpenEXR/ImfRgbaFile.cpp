@@ -10,6 +10,7 @@
 //
 //-----------------------------------------------------------------------------
 
+#include "IlmThreadPool.h"
 #include <Iex.h>
 #include <ImathFun.h>
 #include <ImfChannelList.h>
@@ -22,6 +23,7 @@
 #include <algorithm>
 #include <mutex>
 #include <string.h>
+#include <vector>
 
 #include "ImfNamespace.h"
 
@@ -30,6 +32,9 @@ OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 using namespace std;
 using namespace IMATH_NAMESPACE;
 using namespace RgbaYca;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
 
 namespace
 {
@@ -159,26 +164,58 @@ public:
     int  currentScanLine () const;
 
 private:
-    void padTmpBuf ();
-    void rotateBuffers ();
-    void duplicateLastBuffer ();
-    void duplicateSecondToLastBuffer ();
-    void decimateChromaVertAndWriteScanLine ();
+    class LineTask;
+
+    typedef void (ToYca::*LineFunc) (int first, int last);
+
+    //
+    // The scan lines are converted in batches of up to BATCH_SIZE
+    // lines. Converting the lines from RGBA to YCA and filtering
+    // them horizontally, and filtering them vertically, are done
+    // by tasks in the global thread pool, one range of lines per
+    // task. Every batch is then handed to the output file with a
+    // single writePixels() call, so its line buffers can be
+    // compressed in parallel as well.
+    //
+
+    static const int BATCH_SIZE = 16;
+
+    void runLineTasks (LineFunc func, int first, int last);
+
+    void convertLinesToY (int first, int last);
+    void decimateLinesHoriz (int first, int last);
+    void decimateLinesVert (int first, int last);
+
+    void copyScanLine (int line, Rgba* out) const;
+    int  scanLine (int line) const;
+    int  streamLine (int i) const;
+    bool filterLine (int line) const;
+
+    Rgba* hLine (int line) const;
+    Rgba* outLine (int line) const;
+
+    void setOutputLines (int first, int last);
+    void writeOutputLines (int first, int last);
 
     OutputFile& _outputFile;
     bool        _writeY;
     bool        _writeC;
     bool        _writeA;
     int         _xMin;
+    int         _yMin;
+    int         _yMax;
     int         _width;
     int         _height;
     int         _linesConverted;
+    int         _linesWritten;
     LineOrder   _lineOrder;
     int         _currentScanLine;
     V3f         _yw;
-    Rgba*       _bufBase;
-    Rgba*       _buf[N];
-    Rgba*       _tmpBuf;
+    ptrdiff_t   _lineStride;
+    Rgba*       _hBuf;
+    int         _hBufLines;
+    Rgba*       _outBuf;
+    int         _outYLow;
     const Rgba* _fbBase;
     size_t      _fbXStride;
     size_t      _fbYStride;
@@ -186,6 +223,27 @@ private:
     int         _roundC;
 };
 
+class RgbaOutputFile::ToYca::LineTask : public Task
+{
+public:
+    LineTask (
+        TaskGroup* group, ToYca* toYca, LineFunc func, int first, int last)
+        : Task (group)
+        , _toYca (toYca)
+        , _func (func)
+        , _first (first)
+        , _last (last)
+    {}
+
+    void execute () override { (_toYca->*_func) (_first, _last); }
+
+private:
+    ToYca*   _toYca;
+    LineFunc _func;
+    int      _first;
+    int      _last;
+};
+
 RgbaOutputFile::ToYca::ToYca (OutputFile& outputFile, RgbaChannels rgbaChannels)
     : _outputFile (outputFile)
 {
@@ -196,10 +254,13 @@ RgbaOutputFile::ToYca::ToYca (OutputFile& outputFile, RgbaChannels rgbaChannels)
     const Box2i dw = _outputFile.header ().dataWindow ();
 
     _xMin   = dw.min.x;
+    _yMin   = dw.min.y;
+    _yMax   = dw.max.y;
     _width  = dw.max.x - dw.min.x + 1;
     _height = dw.max.y - dw.min.y + 1;
 
     _linesConverted = 0;
+    _linesWritten   = 0;
     _lineOrder      = _outputFile.header ().lineOrder ();
 
     if (_lineOrder == INCREASING_Y)
@@ -209,14 +270,31 @@ RgbaOutputFile::ToYca::ToYca (OutputFile& outputFile, RgbaChannels rgbaChannels)
 
     _yw = ywFromHeader (_outputFile.header ());
 
-    ptrdiff_t pad = cachePadding (_width * sizeof (Rgba)) / sizeof (Rgba);
+    _lineStride =
+        _width + cachePadding (_width * sizeof (Rgba)) / sizeof (Rgba);
 
-    _bufBase = new Rgba[(_width + pad) * N];
+    //
+    // Vertical filtering lags N2 lines behind horizontal filtering,
+    // so the ring of horizontally filtered lines holds the N - 1
+    // lines the next output line needs, plus a batch of new lines.
+    // Once the last input line has been converted, the remaining
+    // N2 output lines are written along with the last batch.
+    //
 
-    for (int i = 0; i < N; ++i)
-        _buf[i] = _bufBase + (i * (_width + pad));
+    if (_writeC)
+    {
+        _hBufLines = BATCH_SIZE + N - 1;
+        _hBuf      = new Rgba[_lineStride * _hBufLines];
+        _outBuf    = new Rgba[_lineStride * (BATCH_SIZE + N2)];
+    }
+    else
+    {
+        _hBufLines = 0;
+        _hBuf      = 0;
+        _outBuf    = new Rgba[_lineStride * BATCH_SIZE];
+    }
 
-    _tmpBuf = new Rgba[_width + N - 1];
+    _outYLow = _currentScanLine;
 
     _fbBase    = 0;
     _fbXStride = 0;
@@ -228,8 +306,8 @@ RgbaOutputFile::ToYca::ToYca (OutputFile& outputFile, RgbaChannels rgbaChannels)
 
 RgbaOutputFile::ToYca::~ToYca ()
 {
-    delete[] _bufBase;
-    delete[] _tmpBuf;
+    delete[] _hBuf;
+    delete[] _outBuf;
 }
 
 void
@@ -243,61 +321,7 @@ void
 RgbaOutputFile::ToYca::setFrameBuffer (
     const Rgba* base, size_t xStride, size_t yStride)
 {
-    if (_fbBase == 0)
-    {
-        FrameBuffer fb;
-
-        if (_writeY)
-        {
-            fb.insert (
-                "Y",
-                Slice (
-                    HALF,                       // type
-                    (char*) &_tmpBuf[-_xMin].g, // base
-                    sizeof (Rgba),              // xStride
-                    0,                          // yStride
-                    1,                          // xSampling
-                    1));                        // ySampling
-        }
-
-        if (_writeC)
-        {
-            fb.insert (
-                "RY",
-                Slice (
-                    HALF,                       // type
-                    (char*) &_tmpBuf[-_xMin].r, // base
-                    sizeof (Rgba) * 2,          // xStride
-                    0,                          // yStride
-                    2,                          // xSampling
-                    2));                        // ySampling
-
-            fb.insert (
-                "BY",
-                Slice (
-                    HALF,                       // type
-                    (char*) &_tmpBuf[-_xMin].b, // base
-                    sizeof (Rgba) * 2,          // xStride
-                    0,                          // yStride
-                    2,                          // xSampling
-                    2));                        // ySampling
-        }
-
-        if (_writeA)
-        {
-            fb.insert (
-                "A",
-                Slice (
-                    HALF,                       // type
-                    (char*) &_tmpBuf[-_xMin].a, // base
-                    sizeof (Rgba),              // xStride
-                    0,                          // yStride
-                    1,                          // xSampling
-                    1));                        // ySampling
-        }
-
-        _outputFile.setFrameBuffer (fb);
-    }
+    if (_fbBase == 0) setOutputLines (_linesWritten, _linesWritten + 1);
 
     _fbBase    = base;
     _fbXStride = xStride;
@@ -317,196 +341,305 @@ RgbaOutputFile::ToYca::writePixels (int numScanLines)
                  << "\".");
     }
 
-    intptr_t base = reinterpret_cast<intptr_t> (_fbBase);
-    if (_writeY && !_writeC)
-    {
-        //
-        // We are writing only luminance; filtering
-        // and subsampling are not necessary.
-        //
+    //
+    // Lines past the end of the data window are left to the
+    // output file to reject, after the valid lines are written.
+    //
 
-        for (int i = 0; i < numScanLines; ++i)
-        {
-            //
-            // Copy the next scan line from the caller's
-            // frame buffer into _tmpBuf.
-            //
+    int numValid = min (numScanLines, _height - _linesConverted);
 
-            for (int j = 0; j < _width; ++j)
-            {
-                _tmpBuf[j] = *reinterpret_cast<Rgba*> (
-                    base + sizeof (Rgba) * (_fbYStride * _currentScanLine +
-                                            _fbXStride * (j + _xMin)));
-            }
+    for (int i = 0; i < numValid;)
+    {
+        int first = _linesConverted;
+        int last  = first + min (numValid - i, int (BATCH_SIZE));
 
+        if (_writeY && !_writeC)
+        {
             //
-            // Convert the scan line from RGB to luminance/chroma,
-            // and store the result in the output file.
+            // We are writing only luminance; filtering
+            // and subsampling are not necessary.
             //
 
-            RGBAtoYCA (_yw, _width, _writeA, _tmpBuf, _tmpBuf);
-            _outputFile.writePixels (1);
+            setOutputLines (first, last);
+            runLineTasks (&ToYca::convertLinesToY, first, last);
 
-            ++_linesConverted;
-
-            if (_lineOrder == INCREASING_Y)
-                ++_currentScanLine;
-            else
-                --_currentScanLine;
+            _linesConverted = last;
+            writeOutputLines (first, last);
         }
-    }
-    else
-    {
-        //
-        // We are writing chroma; the pixels must be filtered and subsampled.
-        //
-
-        for (int i = 0; i < numScanLines; ++i)
+        else
         {
             //
-            // Copy the next scan line from the caller's
-            // frame buffer into _tmpBuf.
+            // We are writing chroma; the pixels must be filtered and
+            // subsampled. Output line k is filtered from the window of
+            // N horizontally filtered lines starting at streamLine (k),
+            // so it can be written once line k + N2 has been converted,
+            // or once all lines have been converted.
             //
 
-            intptr_t base = reinterpret_cast<intptr_t> (_fbBase);
+            runLineTasks (&ToYca::decimateLinesHoriz, first, last);
+            _linesConverted = last;
+
+            int outLast = _linesConverted < _height
+                              ? max (_linesWritten, _linesConverted - N2)
+                              : _height;
 
-            for (int j = 0; j < _width; ++j)
+            if (outLast > _linesWritten)
             {
-                const Rgba* ptr = reinterpret_cast<const Rgba*> (
-                    base + sizeof (Rgba) * (_fbYStride * _currentScanLine +
-                                            _fbXStride * (j + _xMin)));
-                _tmpBuf[j + N2] = *ptr;
+                setOutputLines (_linesWritten, outLast);
+                runLineTasks (
+                    &ToYca::decimateLinesVert, _linesWritten, outLast);
+                writeOutputLines (_linesWritten, outLast);
             }
+        }
 
-            //
-            // Convert the scan line from RGB to luminance/chroma.
-            //
-
-            RGBAtoYCA (_yw, _width, _writeA, _tmpBuf + N2, _tmpBuf + N2);
-
-            //
-            // Append N2 copies of the first and last pixel to the
-            // beginning and end of the scan line.
-            //
+        if (_lineOrder == INCREASING_Y)
+            _currentScanLine += last - first;
+        else
+            _currentScanLine -= last - first;
 
-            padTmpBuf ();
+        i += last - first;
+    }
 
-            //
-            // Filter and subsample the scan line's chroma channels
-            // horizontally; store the result in _buf.
-            //
+    if (numScanLines > numValid)
+        _outputFile.writePixels (numScanLines - numValid);
+}
 
-            rotateBuffers ();
-            decimateChromaHoriz (_width, _tmpBuf, _buf[N - 1]);
+int
+RgbaOutputFile::ToYca::currentScanLine () const
+{
+    return _currentScanLine;
+}
 
-            //
-            // If this is the first scan line in the image,
-            // store N2 more copies of the scan line in _buf.
-            //
+void
+RgbaOutputFile::ToYca::runLineTasks (LineFunc func, int first, int last)
+{
+    int numLines = last - first;
+    int numTasks =
+        min (numLines, ThreadPool::globalThreadPool ().numThreads ());
 
-            if (_linesConverted == 0)
-            {
-                for (int j = 0; j < N2; ++j)
-                    duplicateLastBuffer ();
-            }
+    if (numTasks <= 1)
+    {
+        (this->*func) (first, last);
+        return;
+    }
 
-            ++_linesConverted;
+    TaskGroup group;
 
-            //
-            // If we have have converted at least N2 scan lines from
-            // RGBA to luminance/chroma, then we can start to filter
-            // and subsample vertically, and store pixels in the
-            // output file.
-            //
+    for (int i = 0; i < numTasks; ++i)
+    {
+        ThreadPool::addGlobalTask (new LineTask (
+            &group,
+            this,
+            func,
+            first + numLines * i / numTasks,
+            first + numLines * (i + 1) / numTasks));
+    }
+}
 
-            if (_linesConverted > N2) decimateChromaVertAndWriteScanLine ();
+void
+RgbaOutputFile::ToYca::convertLinesToY (int first, int last)
+{
+    for (int line = first; line < last; ++line)
+    {
+        Rgba* out = outLine (line);
 
-            //
-            // If we have already converted the last scan line in
-            // the image to luminance/chroma, filter, subsample and
-            // store the remaining scan lines in _buf.
-            //
+        copyScanLine (line, out);
+        RGBAtoYCA (_yw, _width, _writeA, out, out);
+    }
+}
 
-            if (_linesConverted >= _height)
-            {
-                for (int j = 0; j < N2 - _height; ++j)
-                    duplicateLastBuffer ();
+void
+RgbaOutputFile::ToYca::decimateLinesHoriz (int first, int last)
+{
+    vector<Rgba> tmpBuf (_width + N - 1);
 
-                duplicateSecondToLastBuffer ();
-                ++_linesConverted;
-                decimateChromaVertAndWriteScanLine ();
+    for (int line = first; line < last; ++line)
+    {
+        //
+        // Convert the scan line from RGB to luminance/chroma,
+        // append N2 copies of the first and last pixel to the
+        // beginning and end of the scan line, and filter and
+        // subsample the chroma channels horizontally.
+        //
 
-                for (int j = 1; j < min (_height, N2); ++j)
-                {
-                    duplicateLastBuffer ();
-                    ++_linesConverted;
-                    decimateChromaVertAndWriteScanLine ();
-                }
-            }
+        copyScanLine (line, &tmpBuf[N2]);
+        RGBAtoYCA (_yw, _width, _writeA, &tmpBuf[N2], &tmpBuf[N2]);
 
-            if (_lineOrder == INCREASING_Y)
-                ++_currentScanLine;
-            else
-                --_currentScanLine;
+        for (int i = 0; i < N2; ++i)
+        {
+            tmpBuf[i]               = tmpBuf[N2];
+            tmpBuf[_width + N2 + i] = tmpBuf[max (_width - 2, 0) + N2];
         }
+
+        decimateChromaHoriz (_width, &tmpBuf[0], hLine (line));
     }
 }
 
-int
-RgbaOutputFile::ToYca::currentScanLine () const
+void
+RgbaOutputFile::ToYca::decimateLinesVert (int first, int last)
 {
-    return _currentScanLine;
+    for (int line = first; line < last; ++line)
+    {
+        Rgba* out = outLine (line);
+
+        if (filterLine (line))
+        {
+            const Rgba* window[N];
+
+            for (int i = 0; i < N; ++i)
+                window[i] = hLine (streamLine (line + i));
+
+            decimateChromaVert (_width, window, out);
+        }
+        else
+        {
+            memcpy (
+                out, hLine (streamLine (line + N2)), _width * sizeof (Rgba));
+        }
+
+        if (_writeY && _writeC)
+            roundYCA (_width, _roundY, _roundC, out, out);
+    }
 }
 
 void
-RgbaOutputFile::ToYca::padTmpBuf ()
+RgbaOutputFile::ToYca::copyScanLine (int line, Rgba* out) const
 {
-    for (int i = 0; i < N2; ++i)
+    intptr_t base = reinterpret_cast<intptr_t> (_fbBase);
+    int      y    = scanLine (line);
+
+    for (int j = 0; j < _width; ++j)
     {
-        _tmpBuf[i]               = _tmpBuf[N2];
-        _tmpBuf[_width + N2 + i] = _tmpBuf[_width + N2 - 2];
+        out[j] = *reinterpret_cast<const Rgba*> (
+            base + sizeof (Rgba) * (_fbYStride * y + _fbXStride * (j + _xMin)));
     }
 }
 
-void
-RgbaOutputFile::ToYca::rotateBuffers ()
+int
+RgbaOutputFile::ToYca::scanLine (int line) const
+{
+    return _lineOrder == INCREASING_Y ? _yMin + line : _yMax - line;
+}
+
+int
+RgbaOutputFile::ToYca::streamLine (int i) const
 {
-    Rgba* tmp = _buf[0];
+    //
+    // The vertical filter sees a stream of horizontally filtered
+    // lines: N2 + 1 copies of the first line, the other lines, and,
+    // past the last line, copies of the last or second to last
+    // line. Output line k is filtered from stream lines k to k + N - 1.
+    //
+
+    if (i < N2) return 0;
 
-    for (int i = 0; i < N - 1; ++i)
-        _buf[i] = _buf[i + 1];
+    int line = i - N2;
 
-    _buf[N - 1] = tmp;
+    if (line < _height) return line;
+
+    if (line < max (_height, N2)) return _height - 1;
+
+    return _height >= N2 ? _height - 2 : _height - 1;
 }
 
-void
-RgbaOutputFile::ToYca::duplicateLastBuffer ()
+bool
+RgbaOutputFile::ToYca::filterLine (int line) const
 {
-    rotateBuffers ();
-    memcpy (_buf[N - 1], _buf[N - 2], _width * sizeof (Rgba));
+    //
+    // Every other output line is filtered vertically, the others
+    // are copied from the center of their window. The first line
+    // is filtered, except in images with an even number of lines
+    // that is less than N2.
+    //
+
+    return ((line + min (_height, N2) + 1) & 1) == 0;
 }
 
-void
-RgbaOutputFile::ToYca::duplicateSecondToLastBuffer ()
+Rgba*
+RgbaOutputFile::ToYca::hLine (int line) const
+{
+    return _hBuf + (line % _hBufLines) * _lineStride;
+}
+
+Rgba*
+RgbaOutputFile::ToYca::outLine (int line) const
 {
-    rotateBuffers ();
-    memcpy (_buf[N - 1], _buf[N - 3], _width * sizeof (Rgba));
+    return _outBuf + (scanLine (line) - _outYLow) * _lineStride;
 }
 
 void
-RgbaOutputFile::ToYca::decimateChromaVertAndWriteScanLine ()
+RgbaOutputFile::ToYca::setOutputLines (int first, int last)
 {
-    if (_linesConverted & 1)
-        memcpy (_tmpBuf, _buf[N2], _width * sizeof (Rgba));
-    else
-        decimateChromaVert (_width, _buf, _tmpBuf);
+    //
+    // Point the output file's frame buffer at _outBuf, which
+    // holds output lines first to last - 1, in y order.
+    //
+
+    _outYLow = min (scanLine (first), scanLine (last - 1));
 
-    if (_writeY && _writeC)
-        roundYCA (_width, _roundY, _roundC, _tmpBuf, _tmpBuf);
+    size_t    ys = _lineStride * sizeof (Rgba);
+    ptrdiff_t y0 = ptrdiff_t (_outYLow) * ys;
 
-    _outputFile.writePixels (1);
+    FrameBuffer fb;
+
+    if (_writeY)
+    {
+        fb.insert (
+            "Y",
+            Slice (
+                HALF,                            // type
+                (char*) &_outBuf[-_xMin].g - y0, // base
+                sizeof (Rgba),                   // xStride
+                ys,                              // yStride
+                1,                               // xSampling
+                1));                             // ySampling
+    }
+
+    if (_writeC)
+    {
+        fb.insert (
+            "RY",
+            Slice (
+                HALF,                            // type
+                (char*) &_outBuf[-_xMin].r - y0, // base
+                sizeof (Rgba) * 2,               // xStride
+                ys * 2,                          // yStride
+                2,                               // xSampling
+                2));                             // ySampling
+
+        fb.insert (
+            "BY",
+            Slice (
+                HALF,                            // type
+                (char*) &_outBuf[-_xMin].b - y0, // base
+                sizeof (Rgba) * 2,               // xStride
+                ys * 2,                          // yStride
+                2,                               // xSampling
+                2));                             // ySampling
+    }
+
+    if (_writeA)
+    {
+        fb.insert (
+            "A",
+            Slice (
+                HALF,                            // type
+                (char*) &_outBuf[-_xMin].a - y0, // base
+                sizeof (Rgba),                   // xStride
+                ys,                              // yStride
+                1,                               // xSampling
+                1));                             // ySampling
+    }
+
+    _outputFile.setFrameBuffer (fb);
 }
 
+void
+RgbaOutputFile::ToYca::writeOutputLines (int first, int last)
+{
+    _outputFile.writePixels (last - first);
+    _linesWritten = last;
+}
 RgbaOutputFile::RgbaOutputFile (
     const char    name[],
     const Header& header,
@@ -1086,7 +1219,7 @@ RgbaInputFile::FromYca::padTmpBuf ()
     for (int i = 0; i < N2; ++i)
     {
         _tmpBuf[i]               = _tmpBuf[N2];
-        _tmpBuf[_width + N2 + i] = _tmpBuf[_width + N2 - 2];
+        _tmpBuf[_width + N2 + i] = _tmpBuf[max (_width - 2, 0) + N2];
     }
 }
 
@@ -9,6 +9,8 @@
 //
 //-----------------------------------------------------------------------------
 
+#include "ImfSimd.h"
+#include "ImfSystemSpecific.h"
 #include <ImfRgbaYca.h>
 #include <algorithm>
 #include <assert.h>
@@ -29,6 +31,602 @@ computeYw (const Chromaticities& cr)
     return V3f (m[0][1], m[1][1], m[2][1]) / (m[0][1] + m[1][1] + m[2][1]);
 }
 
+namespace
+{
+
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+
+//
+// Coefficients of the chroma filters, in the order the scalar loops
+// below accumulate them. The decimation filter reads inputs 0, 2, ...
+// 12, 13, 14, 16, ... 26 of a window of N pixels or scan lines, the
+// reconstruction filter reads inputs 0, 2, ... 26.
+//
+
+const float decimateCoeffs[15] = {
+    0.001064f,
+    -0.003771f,
+    0.009801f,
+    -0.021586f,
+    0.043978f,
+    -0.093067f,
+    0.313659f,
+    0.499846f,
+    0.313659f,
+    -0.093067f,
+    0.043978f,
+    -0.021586f,
+    0.009801f,
+    -0.003771f,
+    0.001064f};
+
+const int decimateTaps[15] = {
+    0, 2, 4, 6, 8, 10, 12, 13, 14, 16, 18, 20, 22, 24, 26};
+
+const float reconstructCoeffs[14] = {
+    0.002128f,
+    -0.007540f,
+    0.019597f,
+    -0.043159f,
+    0.087929f,
+    -0.186077f,
+    0.627123f,
+    0.627123f,
+    -0.186077f,
+    0.087929f,
+    -0.043159f,
+    0.019597f,
+    -0.007540f,
+    0.002128f};
+
+//
+// The AVX + F16C kernels below work on 8 pixels at a time, with the
+// pixels transposed into one vector of halfs per channel. They do
+// the same float operations in the same order as the scalar loops,
+// and the F16C conversions round to nearest even just like half
+// (float), so the results are bit-identical. FMA is deliberately
+// not enabled, so the compiler cannot contract the multiply / adds.
+//
+
+bool
+haveAvxF16c ()
+{
+    static const bool avxF16c = [] () {
+        CpuId cpuId;
+        return cpuId.avx && cpuId.f16c;
+    }();
+
+    return avxF16c;
+}
+
+//
+// Transpose 4 vectors of 2 pixels each (r0 g0 b0 a0 r1 g1 b1 a1, ...)
+// into one vector of 8 halfs per channel, and back
+//
+
+IMF_AVX_F16C_FUNC inline void
+transposeToChannels (
+    __m128i  p0,
+    __m128i  p1,
+    __m128i  p2,
+    __m128i  p3,
+    __m128i& r,
+    __m128i& g,
+    __m128i& b,
+    __m128i& a)
+{
+    __m128i t0 = _mm_unpacklo_epi16 (p0, p1);
+    __m128i t1 = _mm_unpackhi_epi16 (p0, p1);
+    __m128i t2 = _mm_unpacklo_epi16 (p2, p3);
+    __m128i t3 = _mm_unpackhi_epi16 (p2, p3);
+
+    __m128i u0 = _mm_unpacklo_epi16 (t0, t1);
+    __m128i u1 = _mm_unpackhi_epi16 (t0, t1);
+    __m128i u2 = _mm_unpacklo_epi16 (t2, t3);
+    __m128i u3 = _mm_unpackhi_epi16 (t2, t3);
+
+    r = _mm_unpacklo_epi64 (u0, u2);
+    g = _mm_unpackhi_epi64 (u0, u2);
+    b = _mm_unpacklo_epi64 (u1, u3);
+    a = _mm_unpackhi_epi64 (u1, u3);
+}
+
+IMF_AVX_F16C_FUNC inline void
+transposeToPixels (
+    __m128i  r,
+    __m128i  g,
+    __m128i  b,
+    __m128i  a,
+    __m128i& p0,
+    __m128i& p1,
+    __m128i& p2,
+    __m128i& p3)
+{
+    __m128i u0 = _mm_unpacklo_epi64 (r, g);
+    __m128i u1 = _mm_unpacklo_epi64 (b, a);
+    __m128i u2 = _mm_unpackhi_epi64 (r, g);
+    __m128i u3 = _mm_unpackhi_epi64 (b, a);
+
+    __m128i v0 = _mm_unpacklo_epi16 (u0, u1);
+    __m128i v1 = _mm_unpackhi_epi16 (u0, u1);
+    __m128i v2 = _mm_unpacklo_epi16 (u2, u3);
+    __m128i v3 = _mm_unpackhi_epi16 (u2, u3);
+
+    p0 = _mm_unpacklo_epi16 (v0, v1);
+    p1 = _mm_unpackhi_epi16 (v0, v1);
+    p2 = _mm_unpacklo_epi16 (v2, v3);
+    p3 = _mm_unpackhi_epi16 (v2, v3);
+}
+
+IMF_AVX_F16C_FUNC inline void
+loadPixels (
+    const Rgba* in, __m128i& r, __m128i& g, __m128i& b, __m128i& a)
+{
+    const __m128i* p = reinterpret_cast<const __m128i*> (in);
+
+    transposeToChannels (
+        _mm_loadu_si128 (p),
+        _mm_loadu_si128 (p + 1),
+        _mm_loadu_si128 (p + 2),
+        _mm_loadu_si128 (p + 3),
+        r,
+        g,
+        b,
+        a);
+}
+
+IMF_AVX_F16C_FUNC inline void
+storePixels (Rgba* out, __m128i r, __m128i g, __m128i b, __m128i a)
+{
+    __m128i  p0, p1, p2, p3;
+    __m128i* p = reinterpret_cast<__m128i*> (out);
+
+    transposeToPixels (r, g, b, a, p0, p1, p2, p3);
+
+    _mm_storeu_si128 (p, p0);
+    _mm_storeu_si128 (p + 1, p1);
+    _mm_storeu_si128 (p + 2, p2);
+    _mm_storeu_si128 (p + 3, p3);
+}
+
+//
+// Load the 8 even (lo) and the 8 odd (hi) pixels of 16 pixels,
+// transposed. Each 128 bit load holds one even and one odd pixel.
+//
+
+IMF_AVX_F16C_FUNC inline void
+loadEvenOddPixels (
+    const Rgba* in, __m128i pairs[8], __m128i even[4], __m128i odd[4])
+{
+    const __m128i* p = reinterpret_cast<const __m128i*> (in);
+
+    for (int k = 0; k < 8; ++k)
+        pairs[k] = _mm_loadu_si128 (p + k);
+
+    __m128i e[4], o[4];
+
+    for (int k = 0; k < 4; ++k)
+    {
+        e[k] = _mm_unpacklo_epi64 (pairs[2 * k], pairs[2 * k + 1]);
+        o[k] = _mm_unpackhi_epi64 (pairs[2 * k], pairs[2 * k + 1]);
+    }
+
+    transposeToChannels (
+        e[0], e[1], e[2], e[3], even[0], even[1], even[2], even[3]);
+
+    transposeToChannels (
+        o[0], o[1], o[2], o[3], odd[0], odd[1], odd[2], odd[3]);
+}
+
+IMF_AVX_F16C_FUNC inline __m256
+toFloat (__m128i h)
+{
+    return _mm256_cvtph_ps (h);
+}
+
+IMF_AVX_F16C_FUNC inline __m128i
+toHalf (__m256 f)
+{
+    return _mm256_cvtps_ph (f, _MM_FROUND_TO_NEAREST_INT);
+}
+
+//
+// Narrow a mask of 8 floats to a mask of 8 halfs
+//
+
+IMF_AVX_F16C_FUNC inline __m128i
+halfMask (__m256 m)
+{
+    __m256i i = _mm256_castps_si256 (m);
+
+    return _mm_packs_epi32 (
+        _mm256_castsi256_si128 (i), _mm256_extractf128_si256 (i, 1));
+}
+
+//
+// Replace negative (but not -0) and non-finite halfs by 0
+//
+
+IMF_AVX_F16C_FUNC inline __m128i
+clampNegativeAndNonFinite (__m128i h)
+{
+    const __m128i expMask = _mm_set1_epi16 (0x7c00);
+    const __m128i negZero = _mm_set1_epi16 (short (0x8000));
+
+    __m128i nonFinite =
+        _mm_cmpeq_epi16 (_mm_and_si128 (h, expMask), expMask);
+
+    __m128i negative = _mm_andnot_si128 (
+        _mm_cmpeq_epi16 (h, negZero),
+        _mm_cmplt_epi16 (h, _mm_setzero_si128 ()));
+
+    return _mm_andnot_si128 (_mm_or_si128 (nonFinite, negative), h);
+}
+
+IMF_AVX_F16C_FUNC int
+RGBAtoYCA_avx (
+    const V3f& yw, int n, bool aIsValid, const Rgba rgbaIn[], Rgba ycaOut[])
+{
+    const __m256  x       = _mm256_set1_ps (yw.x);
+    const __m256  y       = _mm256_set1_ps (yw.y);
+    const __m256  z       = _mm256_set1_ps (yw.z);
+    const __m256  halfMax = _mm256_set1_ps (HALF_MAX);
+    const __m256  absMask =
+        _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff));
+    const __m128i one     = _mm_set1_epi16 (0x3c00);
+
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i rh, gh, bh, ah;
+        loadPixels (rgbaIn + i, rh, gh, bh, ah);
+
+        rh = clampNegativeAndNonFinite (rh);
+        gh = clampNegativeAndNonFinite (gh);
+        bh = clampNegativeAndNonFinite (bh);
+
+        __m256 r = toFloat (rh);
+        __m256 g = toFloat (gh);
+        __m256 b = toFloat (bh);
+
+        __m128i equal = halfMask (_mm256_and_ps (
+            _mm256_cmp_ps (r, g, _CMP_EQ_OQ),
+            _mm256_cmp_ps (g, b, _CMP_EQ_OQ)));
+
+        __m128i yh = toHalf (_mm256_add_ps (
+            _mm256_add_ps (_mm256_mul_ps (r, x), _mm256_mul_ps (g, y)),
+            _mm256_mul_ps (b, z)));
+
+        __m256 Y     = toFloat (yh);
+        __m256 limit = _mm256_mul_ps (halfMax, Y);
+
+        __m256 dr = _mm256_sub_ps (r, Y);
+        __m256 db = _mm256_sub_ps (b, Y);
+
+        __m256 cr = _mm256_and_ps (
+            _mm256_cmp_ps (_mm256_and_ps (dr, absMask), limit, _CMP_LT_OQ),
+            _mm256_div_ps (dr, Y));
+
+        __m256 cb = _mm256_and_ps (
+            _mm256_cmp_ps (_mm256_and_ps (db, absMask), limit, _CMP_LT_OQ),
+            _mm256_div_ps (db, Y));
+
+        storePixels (
+            ycaOut + i,
+            _mm_andnot_si128 (equal, toHalf (cr)),
+            _mm_blendv_epi8 (yh, gh, equal),
+            _mm_andnot_si128 (equal, toHalf (cb)),
+            aIsValid ? ah : one);
+    }
+
+    return i;
+}
+
+IMF_AVX_F16C_FUNC int
+YCAtoRGBA_avx (const V3f& yw, int n, const Rgba ycaIn[], Rgba rgbaOut[])
+{
+    const __m256 x    = _mm256_set1_ps (yw.x);
+    const __m256 y    = _mm256_set1_ps (yw.y);
+    const __m256 z    = _mm256_set1_ps (yw.z);
+    const __m256 one  = _mm256_set1_ps (1.0f);
+    const __m256 zero = _mm256_setzero_ps ();
+
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i rh, yh, bh, ah;
+        loadPixels (ycaIn + i, rh, yh, bh, ah);
+
+        __m256 Y  = toFloat (yh);
+        __m256 ry = toFloat (rh);
+        __m256 by = toFloat (bh);
+
+        __m128i gray = halfMask (_mm256_and_ps (
+            _mm256_cmp_ps (ry, zero, _CMP_EQ_OQ),
+            _mm256_cmp_ps (by, zero, _CMP_EQ_OQ)));
+
+        __m256 r = _mm256_mul_ps (_mm256_add_ps (ry, one), Y);
+        __m256 b = _mm256_mul_ps (_mm256_add_ps (by, one), Y);
+        __m256 g = _mm256_div_ps (
+            _mm256_sub_ps (
+                _mm256_sub_ps (Y, _mm256_mul_ps (r, x)), _mm256_mul_ps (b, z)),
+            y);
+
+        storePixels (
+            rgbaOut + i,
+            _mm_blendv_epi8 (toHalf (r), yh, gray),
+            _mm_blendv_epi8 (toHalf (g), yh, gray),
+            _mm_blendv_epi8 (toHalf (b), yh, gray),
+            ah);
+    }
+
+    return i;
+}
+
+//
+// The horizontal filters work on tiles of up to TILE even (or odd)
+// output pixels. The r and b channels of the input pixels of a tile
+// are converted to float once, split into even and odd pixels, so
+// that consecutive outputs of the same parity read consecutive floats.
+//
+
+const int TILE = 64;
+
+struct HorizTile
+{
+    // TILE + N2 pixel pairs are read, plus room for a partial vector
+    float er[TILE + 24];
+    float eb[TILE + 24];
+    float orr[TILE + 24];
+    float ob[TILE + 24];
+
+    unsigned short hr[TILE + 8];
+    unsigned short hb[TILE + 8];
+};
+
+IMF_AVX_F16C_FUNC void
+loadTile (const Rgba in[], int count, HorizTile& t)
+{
+    int p = 0;
+
+    for (; 2 * p + 16 <= count; p += 8)
+    {
+        __m128i pairs[8], even[4], odd[4];
+        loadEvenOddPixels (in + 2 * p, pairs, even, odd);
+
+        _mm256_storeu_ps (t.er + p, toFloat (even[0]));
+        _mm256_storeu_ps (t.eb + p, toFloat (even[2]));
+        _mm256_storeu_ps (t.orr + p, toFloat (odd[0]));
+        _mm256_storeu_ps (t.ob + p, toFloat (odd[2]));
+    }
+
+    for (; 2 * p + 1 < count; ++p)
+    {
+        t.er[p]  = in[2 * p].r;
+        t.eb[p]  = in[2 * p].b;
+        t.orr[p] = in[2 * p + 1].r;
+        t.ob[p]  = in[2 * p + 1].b;
+    }
+
+    if (2 * p < count)
+    {
+        t.er[p] = in[2 * p].r;
+        t.eb[p] = in[2 * p].b;
+    }
+}
+
+IMF_AVX_F16C_FUNC void
+decimateChromaHoriz_avx (int n, const Rgba ycaIn[], Rgba ycaOut[])
+{
+    //
+    // Even output pixel 2q reads the even input pixels 2q, 2q + 2,
+    // ... 2q + 26, and the odd input pixel 2q + 13.
+    //
+
+    HorizTile t = {};
+
+    const int nq = (n + 1) / 2;
+
+    for (int q0 = 0; q0 < nq; q0 += TILE)
+    {
+        int nt = min (TILE, nq - q0);
+
+        loadTile (
+            ycaIn + 2 * q0, min (2 * (nt + N2 + 1), n + N - 1 - 2 * q0), t);
+
+        for (int q = 0; q < nt; q += 8)
+        {
+            __m256 c  = _mm256_set1_ps (decimateCoeffs[0]);
+            __m256 sr = _mm256_mul_ps (_mm256_loadu_ps (t.er + q), c);
+            __m256 sb = _mm256_mul_ps (_mm256_loadu_ps (t.eb + q), c);
+
+            for (int k = 1; k < 15; ++k)
+            {
+                //
+                // tap 7 is the odd center pixel, the others are
+                // even pixels
+                //
+
+                int          m = q + (k < 7 ? k : k - 1);
+                const float* r = k == 7 ? t.orr + q + 6 : t.er + m;
+                const float* b = k == 7 ? t.ob + q + 6 : t.eb + m;
+
+                c  = _mm256_set1_ps (decimateCoeffs[k]);
+                sr = _mm256_add_ps (sr, _mm256_mul_ps (_mm256_loadu_ps (r), c));
+                sb = _mm256_add_ps (sb, _mm256_mul_ps (_mm256_loadu_ps (b), c));
+            }
+
+            _mm_storeu_si128 ((__m128i*) (t.hr + q), toHalf (sr));
+            _mm_storeu_si128 ((__m128i*) (t.hb + q), toHalf (sb));
+        }
+
+        for (int q = 0; q < nt; ++q)
+        {
+            int j = 2 * (q0 + q);
+
+            ycaOut[j].r.setBits (t.hr[q]);
+            ycaOut[j].b.setBits (t.hb[q]);
+            ycaOut[j].g = ycaIn[j + N2].g;
+            ycaOut[j].a = ycaIn[j + N2].a;
+
+            if (j + 1 < n)
+            {
+                ycaOut[j + 1].g = ycaIn[j + 1 + N2].g;
+                ycaOut[j + 1].a = ycaIn[j + 1 + N2].a;
+            }
+        }
+    }
+}
+
+IMF_AVX_F16C_FUNC void
+reconstructChromaHoriz_avx (int n, const Rgba ycaIn[], Rgba ycaOut[])
+{
+    //
+    // Odd output pixel 2q + 1 reads the odd input pixels 2q + 1,
+    // 2q + 3, ... 2q + 27.
+    //
+
+    HorizTile t = {};
+
+    const int nq = (n + 1) / 2;
+
+    for (int q0 = 0; q0 < nq; q0 += TILE)
+    {
+        int nt = min (TILE, nq - q0);
+
+        loadTile (
+            ycaIn + 2 * q0, min (2 * (nt + N2 + 1), n + N - 1 - 2 * q0), t);
+
+        for (int q = 0; q < nt; q += 8)
+        {
+            __m256 c  = _mm256_set1_ps (reconstructCoeffs[0]);
+            __m256 sr = _mm256_mul_ps (_mm256_loadu_ps (t.orr + q), c);
+            __m256 sb = _mm256_mul_ps (_mm256_loadu_ps (t.ob + q), c);
+
+            for (int k = 1; k < 14; ++k)
+            {
+                c  = _mm256_set1_ps (reconstructCoeffs[k]);
+                sr = _mm256_add_ps (
+                    sr, _mm256_mul_ps (_mm256_loadu_ps (t.orr + q + k), c));
+                sb = _mm256_add_ps (
+                    sb, _mm256_mul_ps (_mm256_loadu_ps (t.ob + q + k), c));
+            }
+
+            _mm_storeu_si128 ((__m128i*) (t.hr + q), toHalf (sr));
+            _mm_storeu_si128 ((__m128i*) (t.hb + q), toHalf (sb));
+        }
+
+        for (int q = 0; q < nt; ++q)
+        {
+            int j = 2 * (q0 + q);
+
+            ycaOut[j] = ycaIn[j + N2];
+
+            if (j + 1 < n)
+            {
+                ycaOut[j + 1].r.setBits (t.hr[q]);
+                ycaOut[j + 1].b.setBits (t.hb[q]);
+                ycaOut[j + 1].g = ycaIn[j + 1 + N2].g;
+                ycaOut[j + 1].a = ycaIn[j + 1 + N2].a;
+            }
+        }
+    }
+}
+
+//
+// The vertical filters work on 16 (decimation, only the even pixels
+// are filtered) or 8 (reconstruction) pixels of every scan line at a
+// time.
+//
+
+IMF_AVX_F16C_FUNC int
+decimateChromaVert_avx (int n, const Rgba* const ycaIn[N], Rgba ycaOut[])
+{
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i pairs[8], even[4], odd[4];
+        loadEvenOddPixels (ycaIn[0] + i, pairs, even, odd);
+
+        __m256 c  = _mm256_set1_ps (decimateCoeffs[0]);
+        __m256 sr = _mm256_mul_ps (toFloat (even[0]), c);
+        __m256 sb = _mm256_mul_ps (toFloat (even[2]), c);
+
+        for (int k = 1; k < 15; ++k)
+        {
+            loadEvenOddPixels (ycaIn[decimateTaps[k]] + i, pairs, even, odd);
+
+            c  = _mm256_set1_ps (decimateCoeffs[k]);
+            sr = _mm256_add_ps (sr, _mm256_mul_ps (toFloat (even[0]), c));
+            sb = _mm256_add_ps (sb, _mm256_mul_ps (toFloat (even[2]), c));
+        }
+
+        //
+        // Even pixels get the filtered chroma, odd pixels keep
+        // their chroma; both get luminance and alpha from the
+        // center scan line.
+        //
+
+        loadEvenOddPixels (ycaIn[N2] + i, pairs, even, odd);
+
+        __m128i e[4];
+        transposeToPixels (
+            toHalf (sr), even[1], toHalf (sb), even[3], e[0], e[1], e[2], e[3]);
+
+        __m128i* p = reinterpret_cast<__m128i*> (ycaOut + i);
+
+        for (int k = 0; k < 4; ++k)
+        {
+            __m128i o0 = _mm_blend_epi16 (
+                _mm_loadu_si128 (p + 2 * k), pairs[2 * k], 0xaa);
+            __m128i o1 = _mm_blend_epi16 (
+                _mm_loadu_si128 (p + 2 * k + 1), pairs[2 * k + 1], 0xaa);
+
+            _mm_storeu_si128 (p + 2 * k, _mm_blend_epi16 (o0, e[k], 0x0f));
+            _mm_storeu_si128 (p + 2 * k + 1, _mm_unpackhi_epi64 (e[k], o1));
+        }
+    }
+
+    return i;
+}
+
+IMF_AVX_F16C_FUNC int
+reconstructChromaVert_avx (int n, const Rgba* const ycaIn[N], Rgba ycaOut[])
+{
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i rh, gh, bh, ah;
+        loadPixels (ycaIn[0] + i, rh, gh, bh, ah);
+
+        __m256 c  = _mm256_set1_ps (reconstructCoeffs[0]);
+        __m256 sr = _mm256_mul_ps (toFloat (rh), c);
+        __m256 sb = _mm256_mul_ps (toFloat (bh), c);
+
+        for (int k = 1; k < 14; ++k)
+        {
+            loadPixels (ycaIn[2 * k] + i, rh, gh, bh, ah);
+
+            c  = _mm256_set1_ps (reconstructCoeffs[k]);
+            sr = _mm256_add_ps (sr, _mm256_mul_ps (toFloat (rh), c));
+            sb = _mm256_add_ps (sb, _mm256_mul_ps (toFloat (bh), c));
+        }
+
+        loadPixels (ycaIn[N2] + i, rh, gh, bh, ah);
+        storePixels (ycaOut + i, toHalf (sr), gh, toHalf (sb), ah);
+    }
+
+    return i;
+}
+
+#endif
+
+} // namespace
+
 void
 RGBAtoYCA (
     const V3f& yw,
@@ -37,7 +635,13 @@ RGBAtoYCA (
     const Rgba rgbaIn[/*n*/],
     Rgba       ycaOut[/*n*/])
 {
-    for (int i = 0; i < n; ++i)
+    int i = 0;
+
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+    if (haveAvxF16c ()) i = RGBAtoYCA_avx (yw, n, aIsValid, rgbaIn, ycaOut);
+#endif
+
+    for (; i < n; ++i)
     {
         Rgba  in  = rgbaIn[i];
         Rgba& out = ycaOut[i];
@@ -100,6 +704,14 @@ decimateChromaHoriz (int n, const Rgba ycaIn[/*n+N-1*/], Rgba ycaOut[/*n*/])
     assert (ycaIn != ycaOut);
 #endif
 
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+    if (haveAvxF16c ())
+    {
+        decimateChromaHoriz_avx (n, ycaIn, ycaOut);
+        return;
+    }
+#endif
+
     int begin = N2;
     int end   = begin + n;
 
@@ -136,7 +748,13 @@ decimateChromaHoriz (int n, const Rgba ycaIn[/*n+N-1*/], Rgba ycaOut[/*n*/])
 void
 decimateChromaVert (int n, const Rgba* const ycaIn[N], Rgba ycaOut[/*n*/])
 {
-    for (int i = 0; i < n; ++i)
+    int i = 0;
+
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+    if (haveAvxF16c ()) i = decimateChromaVert_avx (n, ycaIn, ycaOut);
+#endif
+
+    for (; i < n; ++i)
     {
         if ((i & 1) == 0)
         {
@@ -194,6 +812,14 @@ reconstructChromaHoriz (int n, const Rgba ycaIn[/*n+N-1*/], Rgba ycaOut[/*n*/])
     assert (ycaIn != ycaOut);
 #endif
 
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+    if (haveAvxF16c ())
+    {
+        reconstructChromaHoriz_avx (n, ycaIn, ycaOut);
+        return;
+    }
+#endif
+
     int begin = N2;
     int end   = begin + n;
 
@@ -233,7 +859,13 @@ reconstructChromaHoriz (int n, const Rgba ycaIn[/*n+N-1*/], Rgba ycaOut[/*n*/])
 void
 reconstructChromaVert (int n, const Rgba* const ycaIn[N], Rgba ycaOut[/*n*/])
 {
-    for (int i = 0; i < n; ++i)
+    int i = 0;
+
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+    if (haveAvxF16c ()) i = reconstructChromaVert_avx (n, ycaIn, ycaOut);
+#endif
+
+    for (; i < n; ++i)
     {
         ycaOut[i].r = ycaIn[0][i].r * 0.002128f + ycaIn[2][i].r * -0.007540f +
                       ycaIn[4][i].r * 0.019597f + ycaIn[6][i].r * -0.043159f +
@@ -263,7 +895,13 @@ YCAtoRGBA (
     const Rgba                  ycaIn[/*n*/],
     Rgba                        rgbaOut[/*n*/])
 {
-    for (int i = 0; i < n; ++i)
+    int i = 0;
+
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+    if (haveAvxF16c ()) i = YCAtoRGBA_avx (yw, n, ycaIn, rgbaOut);
+#endif
+
+    for (; i < n; ++i)
     {
         const Rgba& in  = ycaIn[i];
         Rgba&       out = rgbaOut[i];
@@ -50,6 +50,19 @@
 #    define IMF_HAVE_NEON_AARCH64 1
 #endif
 
+//
+// Function level AVX + F16C targeting, for kernels that are selected
+// at runtime with CpuId, so the rest of the library can be built
+// without VEX encoding:
+//    IMF_HAVE_AVX_F16C_TARGET - Defined if IMF_AVX_F16C_FUNC is usable
+//
+
+#if (defined(__x86_64__) || defined(_M_X64)) &&                                \
+    (defined(__GNUC__) || defined(__clang__)) && !defined(__e2k__)
+#    define IMF_HAVE_AVX_F16C_TARGET 1
+#    define IMF_AVX_F16C_FUNC __attribute__ ((target ("avx,f16c")))
+#endif
+
 extern "C" {
 #ifdef IMF_HAVE_SSE2
 #    include <emmintrin.h>
@@ -63,6 +76,10 @@ extern "C" {
 #ifdef IMF_HAVE_NEON
 #    include <arm_neon.h>
 #endif
+
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+#    include <immintrin.h>
+#endif
 }
 
 #include "OpenEXRConfigInternal.h"
@@ -0,0 +1,523 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#include "internal_buffer_pool.h"
+
+#include "internal_memory.h"
+#include "openexr_context.h"
+
+#include <libdeflate.h>
+#include <string.h>
+
+/* older libdeflate only has a process wide allocator, where a cached
+ * state could later be freed with another context's free routine, so
+ * only cache states which carry their own */
+#if (                                                                          \
+    LIBDEFLATE_VERSION_MAJOR > 1 ||                                            \
+    (LIBDEFLATE_VERSION_MAJOR == 1 && LIBDEFLATE_VERSION_MINOR > 18))
+#    define EXR_CACHE_DEFLATE_STATES 1
+#endif
+
+/* libdeflate does not report how big its states are, so cached states
+ * are counted against the pool limit using the sizes libdeflate 1.19
+ * allocates on 64-bit platforms, rounded up. The compressor size
+ * depends on the match finder used by the level */
+#define EXR_DEFLATE_DECOMPRESSOR_BYTES ((size_t) 12 * 1024)
+
+static inline size_t
+deflate_compressor_bytes (int level)
+{
+    if (level <= 0) return (size_t) 8 * 1024;
+    if (level == 1) return (size_t) 200 * 1024;
+    if (level <= 9) return (size_t) 656 * 1024;
+    return (size_t) 8800 * 1024;
+}
+
+/**************************************/
+
+static inline void
+pool_lock (struct _priv_exr_buffer_pool_t* pool)
+{
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    EnterCriticalSection (&pool->mutex);
+#    else
+    pthread_mutex_lock (&pool->mutex);
+#    endif
+#else
+    (void) pool;
+#endif
+}
+
+static inline void
+pool_unlock (struct _priv_exr_buffer_pool_t* pool)
+{
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    LeaveCriticalSection (&pool->mutex);
+#    else
+    pthread_mutex_unlock (&pool->mutex);
+#    endif
+#else
+    (void) pool;
+#endif
+}
+
+/* classes are (4 + sub) << (octave - 2) for sub in [0, 3], so the
+ * rounding waste is bounded at 25% */
+static inline size_t
+class_size (int idx)
+{
+    return ((size_t) (4 + (idx & 3)))
+           << ((idx >> 2) + EXR_BUFFER_POOL_MIN_SHIFT - 2);
+}
+
+/* the largest class whose size is <= bytes, bytes must be at least
+ * the minimum class size */
+static inline int
+class_floor (size_t bytes)
+{
+    int    k = 0;
+    size_t v = bytes;
+    while (v >>= 1)
+        ++k;
+    return (k - EXR_BUFFER_POOL_MIN_SHIFT) * 4 + (int) ((bytes >> (k - 2)) & 3);
+}
+
+/* don't let the class sizes overflow size_t on 32-bit platforms */
+#define EXR_BUFFER_POOL_USABLE_CLASSES                                         \
+    (((int) (sizeof (size_t) * 8) - EXR_BUFFER_POOL_MIN_SHIFT - 1) * 4 <       \
+             EXR_BUFFER_POOL_CLASSES                                           \
+         ? ((int) (sizeof (size_t) * 8) - EXR_BUFFER_POOL_MIN_SHIFT - 1) * 4   \
+         : EXR_BUFFER_POOL_CLASSES)
+
+/**************************************/
+
+exr_result_t
+internal_exr_buffer_pool_init (
+    struct _priv_exr_buffer_pool_t* pool,
+    exr_memory_allocation_func_t    alloc_fn,
+    exr_memory_free_func_t          free_fn,
+    size_t                          max_bytes)
+{
+    memset (pool, 0, sizeof (struct _priv_exr_buffer_pool_t));
+    pool->alloc_fn  = alloc_fn;
+    pool->free_fn   = free_fn;
+    pool->max_bytes = max_bytes;
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    InitializeCriticalSection (&pool->mutex);
+#    else
+    if (pthread_mutex_init (&pool->mutex, NULL) != 0)
+        return EXR_ERR_OUT_OF_MEMORY;
+#    endif
+#endif
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+void
+internal_exr_buffer_pool_destroy (struct _priv_exr_buffer_pool_t* pool)
+{
+    internal_exr_buffer_pool_trim (pool, 0);
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    DeleteCriticalSection (&pool->mutex);
+#    else
+    pthread_mutex_destroy (&pool->mutex);
+#    endif
+#endif
+}
+
+/**************************************/
+
+void*
+internal_exr_buffer_pool_acquire (
+    struct _priv_exr_buffer_pool_t* pool, size_t bytes, size_t* actual)
+{
+    internal_exr_pool_block_t* blk = NULL;
+    void*                      ret;
+    size_t                     allocsz;
+    int                        idx, pooled;
+
+    *actual = 0;
+    allocsz = bytes;
+    if (allocsz < ((size_t) 1 << EXR_BUFFER_POOL_MIN_SHIFT))
+        allocsz = ((size_t) 1 << EXR_BUFFER_POOL_MIN_SHIFT);
+
+    idx = class_floor (allocsz);
+    if (class_size (idx) < allocsz) ++idx;
+
+    if (idx >= EXR_BUFFER_POOL_USABLE_CLASSES)
+    {
+        ret = pool->alloc_fn (bytes);
+        if (ret) *actual = bytes;
+        return ret;
+    }
+
+    pool_lock (pool);
+    pooled = (pool->max_bytes > 0);
+    if (pooled)
+    {
+        blk = pool->free_lists[idx];
+        if (blk)
+        {
+            pool->free_lists[idx] = blk->next;
+            pool->cached_bytes -= blk->size;
+        }
+    }
+    pool_unlock (pool);
+
+    if (blk)
+    {
+        *actual = blk->size;
+        return blk;
+    }
+
+    /* no point in rounding up if it will not be kept */
+    allocsz = pooled ? class_size (idx) : bytes;
+    ret     = pool->alloc_fn (allocsz);
+    if (ret) *actual = allocsz;
+    return ret;
+}
+
+/**************************************/
+
+void
+internal_exr_buffer_pool_release (
+    struct _priv_exr_buffer_pool_t* pool, void* ptr, size_t bytes)
+{
+    int idx;
+
+    if (!ptr) return;
+
+    if (bytes < ((size_t) 1 << EXR_BUFFER_POOL_MIN_SHIFT))
+    {
+        pool->free_fn (ptr);
+        return;
+    }
+
+    idx = class_floor (bytes);
+    if (idx >= EXR_BUFFER_POOL_USABLE_CLASSES)
+    {
+        pool->free_fn (ptr);
+        return;
+    }
+
+    /* a pool with max_bytes == 0 can never fit the buffer */
+    pool_lock (pool);
+    if (pool->cached_bytes + bytes <= pool->max_bytes)
+    {
+        internal_exr_pool_block_t* blk = (internal_exr_pool_block_t*) ptr;
+
+        blk->size             = bytes;
+        blk->next             = pool->free_lists[idx];
+        pool->free_lists[idx] = blk;
+        pool->cached_bytes += bytes;
+        ptr = NULL;
+    }
+    pool_unlock (pool);
+
+    if (ptr) pool->free_fn (ptr);
+}
+
+/**************************************/
+
+void
+internal_exr_buffer_pool_trim (
+    struct _priv_exr_buffer_pool_t* pool, size_t keep_bytes)
+{
+    internal_exr_pool_block_t*      tofree = NULL;
+    internal_exr_pool_block_t*      blk;
+    struct libdeflate_compressor*   comps[EXR_BUFFER_POOL_DEFLATE_STATES];
+    struct libdeflate_decompressor* decomps[EXR_BUFFER_POOL_DEFLATE_STATES];
+    int                             ncomps = 0, ndecomps = 0;
+
+    /* unlink under the lock, but do the (potentially slow) free
+     * outside of it. Release the big buffers first, then the
+     * compressor states, which are more expensive to re-create */
+    pool_lock (pool);
+    for (int idx = EXR_BUFFER_POOL_CLASSES - 1;
+         idx >= 0 && pool->cached_bytes > keep_bytes;
+         --idx)
+    {
+        while (pool->free_lists[idx] && pool->cached_bytes > keep_bytes)
+        {
+            blk                   = pool->free_lists[idx];
+            pool->free_lists[idx] = blk->next;
+            pool->cached_bytes -= blk->size;
+            blk->next = tofree;
+            tofree    = blk;
+        }
+    }
+    while (pool->num_decompressors > 0 && pool->cached_bytes > keep_bytes)
+    {
+        decomps[ndecomps++] = pool->decompressors[--pool->num_decompressors];
+        pool->cached_bytes -= EXR_DEFLATE_DECOMPRESSOR_BYTES;
+    }
+    while (pool->num_compressors > 0 && pool->cached_bytes > keep_bytes)
+    {
+        int last = --pool->num_compressors;
+
+        comps[ncomps++] = pool->compressors[last];
+        pool->cached_bytes -=
+            deflate_compressor_bytes (pool->compressor_levels[last]);
+    }
+    pool_unlock (pool);
+
+    while (tofree)
+    {
+        blk    = tofree;
+        tofree = blk->next;
+        pool->free_fn (blk);
+    }
+
+    for (int i = 0; i < ncomps; ++i)
+        libdeflate_free_compressor (comps[i]);
+    for (int i = 0; i < ndecomps; ++i)
+        libdeflate_free_decompressor (decomps[i]);
+}
+
+/**************************************/
+
+struct libdeflate_compressor*
+internal_exr_buffer_pool_take_compressor (
+    struct _priv_exr_buffer_pool_t* pool, int level)
+{
+    struct libdeflate_compressor* ret = NULL;
+
+#ifdef EXR_CACHE_DEFLATE_STATES
+    pool_lock (pool);
+    for (int i = pool->num_compressors - 1; i >= 0; --i)
+    {
+        if (pool->compressor_levels[i] == level)
+        {
+            int last = --pool->num_compressors;
+
+            ret                        = pool->compressors[i];
+            pool->compressors[i]       = pool->compressors[last];
+            pool->compressor_levels[i] = pool->compressor_levels[last];
+            pool->cached_bytes -= deflate_compressor_bytes (level);
+            break;
+        }
+    }
+    pool_unlock (pool);
+#else
+    (void) pool;
+    (void) level;
+#endif
+    return ret;
+}
+
+/**************************************/
+
+void
+internal_exr_buffer_pool_give_compressor (
+    struct _priv_exr_buffer_pool_t* pool,
+    struct libdeflate_compressor*   comp,
+    int                             level)
+{
+    if (!comp) return;
+
+#ifdef EXR_CACHE_DEFLATE_STATES
+    pool_lock (pool);
+    if (pool->num_compressors < EXR_BUFFER_POOL_DEFLATE_STATES &&
+        pool->cached_bytes + deflate_compressor_bytes (level) <=
+            pool->max_bytes)
+    {
+        pool->compressors[pool->num_compressors]       = comp;
+        pool->compressor_levels[pool->num_compressors] = level;
+        ++pool->num_compressors;
+        pool->cached_bytes += deflate_compressor_bytes (level);
+        comp = NULL;
+    }
+    pool_unlock (pool);
+#else
+    (void) pool;
+    (void) level;
+#endif
+
+    if (comp) libdeflate_free_compressor (comp);
+}
+
+/**************************************/
+
+struct libdeflate_decompressor*
+internal_exr_buffer_pool_take_decompressor (
+    struct _priv_exr_buffer_pool_t* pool)
+{
+    struct libdeflate_decompressor* ret = NULL;
+
+#ifdef EXR_CACHE_DEFLATE_STATES
+    pool_lock (pool);
+    if (pool->num_decompressors > 0)
+    {
+        ret = pool->decompressors[--pool->num_decompressors];
+        pool->cached_bytes -= EXR_DEFLATE_DECOMPRESSOR_BYTES;
+    }
+    pool_unlock (pool);
+#else
+    (void) pool;
+#endif
+    return ret;
+}
+
+/**************************************/
+
+void
+internal_exr_buffer_pool_give_decompressor (
+    struct _priv_exr_buffer_pool_t* pool,
+    struct libdeflate_decompressor* decomp)
+{
+    if (!decomp) return;
+
+#ifdef EXR_CACHE_DEFLATE_STATES
+    pool_lock (pool);
+    if (pool->num_decompressors < EXR_BUFFER_POOL_DEFLATE_STATES &&
+        pool->cached_bytes + EXR_DEFLATE_DECOMPRESSOR_BYTES <=
+            pool->max_bytes)
+    {
+        pool->decompressors[pool->num_decompressors++] = decomp;
+        pool->cached_bytes += EXR_DEFLATE_DECOMPRESSOR_BYTES;
+        decomp = NULL;
+    }
+    pool_unlock (pool);
+#else
+    (void) pool;
+#endif
+
+    if (decomp) libdeflate_free_decompressor (decomp);
+}
+
+/**************************************/
+
+exr_result_t
+exr_buffer_pool_create (
+    exr_buffer_pool_t*           pool,
+    size_t                       max_bytes,
+    exr_memory_allocation_func_t alloc_fn,
+    exr_memory_free_func_t       free_fn)
+{
+    exr_buffer_pool_t ret;
+    exr_result_t      rv;
+
+    if (!pool) return EXR_ERR_INVALID_ARGUMENT;
+    *pool = NULL;
+
+    if (!alloc_fn) alloc_fn = &internal_exr_alloc;
+    if (!free_fn) free_fn = &internal_exr_free;
+
+    ret = alloc_fn (sizeof (struct _priv_exr_buffer_pool_t));
+    if (!ret) return EXR_ERR_OUT_OF_MEMORY;
+
+    rv = internal_exr_buffer_pool_init (ret, alloc_fn, free_fn, max_bytes);
+    if (rv != EXR_ERR_SUCCESS)
+    {
+        free_fn (ret);
+        return rv;
+    }
+
+    *pool = ret;
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+exr_result_t
+exr_buffer_pool_destroy (exr_buffer_pool_t* pool)
+{
+    exr_buffer_pool_t      p;
+    exr_memory_free_func_t dofree;
+
+    if (!pool) return EXR_ERR_INVALID_ARGUMENT;
+    p = *pool;
+    if (!p) return EXR_ERR_SUCCESS;
+    if (p->is_builtin) return EXR_ERR_INVALID_ARGUMENT;
+
+    dofree = p->free_fn;
+    internal_exr_buffer_pool_destroy (p);
+    dofree (p);
+    *pool = NULL;
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+exr_result_t
+exr_buffer_pool_set_max_bytes (exr_buffer_pool_t pool, size_t max_bytes)
+{
+    if (!pool) return EXR_ERR_INVALID_ARGUMENT;
+
+    pool_lock (pool);
+    pool->max_bytes = max_bytes;
+    pool_unlock (pool);
+
+    internal_exr_buffer_pool_trim (pool, max_bytes);
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+exr_result_t
+exr_buffer_pool_get_cached_bytes (exr_buffer_pool_t pool, size_t* bytes)
+{
+    if (!pool || !bytes) return EXR_ERR_INVALID_ARGUMENT;
+
+    pool_lock (pool);
+    *bytes = pool->cached_bytes;
+    pool_unlock (pool);
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+exr_result_t
+exr_buffer_pool_trim (exr_buffer_pool_t pool)
+{
+    if (!pool) return EXR_ERR_INVALID_ARGUMENT;
+
+    internal_exr_buffer_pool_trim (pool, 0);
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+exr_result_t
+exr_set_buffer_pool (exr_context_t ctxt, exr_buffer_pool_t pool)
+{
+    if (!ctxt) return EXR_ERR_MISSING_CONTEXT_ARG;
+
+    if (!pool) pool = &(ctxt->builtin_pool);
+
+    /* buffers migrate between the pool and the context (i.e. when a
+     * caller adopts a decode buffer), so they must agree on how
+     * memory is returned */
+    if (pool->free_fn != ctxt->free_fn)
+        return ctxt->report_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Buffer pool must use the same memory routines as the context");
+
+    internal_exr_lock (ctxt);
+    ctxt->buffer_pool = pool;
+    internal_exr_unlock (ctxt);
+
+    if (pool != &(ctxt->builtin_pool))
+        internal_exr_buffer_pool_trim (&(ctxt->builtin_pool), 0);
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+exr_result_t
+exr_get_buffer_pool (exr_const_context_t ctxt, exr_buffer_pool_t* pool)
+{
+    if (!ctxt) return EXR_ERR_MISSING_CONTEXT_ARG;
+    if (!pool) return ctxt->standard_error (ctxt, EXR_ERR_INVALID_ARGUMENT);
+
+    *pool = ctxt->buffer_pool;
+    return EXR_ERR_SUCCESS;
+}
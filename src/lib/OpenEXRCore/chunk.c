@@ -209,11 +209,88 @@ struct priv_chunk_leader
     uint64_t packed_size;
 };
 
+/* Reconstructing the chunk table walks the chunk leaders one after
+ * the other, each of which is only a few bytes. On high latency
+ * storage, a read per leader is very slow, so instead read larger
+ * windows of the file and parse the leaders out of those. The size
+ * of each read is scaled by the average chunk size seen so far, such
+ * that a read covers a number of chunks, but the window is not
+ * filled when the chunks are so large it would mostly be skipped.
+ */
+#define EXR_RECONSTRUCT_MIN_READ 4096
+#define EXR_RECONSTRUCT_MAX_READ (1024 * 1024)
+#define EXR_RECONSTRUCT_CHUNKS_PER_READ 32
+
+struct priv_read_window
+{
+    uint8_t* buffer;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t leader_count;
+    uint64_t leader_bytes;
+};
+
+static exr_result_t
+window_read (
+    exr_const_context_t      ctxt,
+    struct priv_read_window* win,
+    void*                    dst,
+    uint64_t                 sz,
+    uint64_t*                offsetp)
+{
+    uint64_t off = *offsetp;
+
+    if (!win || !win->buffer)
+        return ctxt->do_read (
+            ctxt, dst, sz, offsetp, NULL, EXR_MUST_READ_ALL);
+
+    if (off < win->offset || off + sz > win->offset + win->size)
+    {
+        exr_result_t rv;
+        uint64_t     roff   = off;
+        uint64_t     toread = EXR_RECONSTRUCT_MIN_READ;
+        int64_t      nread  = 0;
+
+        if (win->leader_count > 0)
+        {
+            uint64_t avg = win->leader_bytes / win->leader_count;
+
+            if (avg < EXR_RECONSTRUCT_MAX_READ / EXR_RECONSTRUCT_CHUNKS_PER_READ)
+                toread = avg * EXR_RECONSTRUCT_CHUNKS_PER_READ;
+            else if (avg < EXR_RECONSTRUCT_MAX_READ / 2)
+                toread = EXR_RECONSTRUCT_MAX_READ;
+            if (toread < EXR_RECONSTRUCT_MIN_READ)
+                toread = EXR_RECONSTRUCT_MIN_READ;
+        }
+
+        /* don't ask for more than is in the file, but leave the must
+         * read semantic in place for a leader past the end */
+        if (ctxt->file_size > 0 && off < (uint64_t) ctxt->file_size &&
+            toread > ((uint64_t) ctxt->file_size - off))
+            toread = (uint64_t) ctxt->file_size - off;
+        if (toread < sz) toread = sz;
+
+        win->size = 0;
+        rv        = ctxt->do_read (
+            ctxt, win->buffer, toread, &roff, &nread, EXR_ALLOW_SHORT_READ);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+
+        win->offset = off;
+        win->size   = (nread > 0) ? (uint64_t) nread : 0;
+        if (win->size < sz) return EXR_ERR_READ_IO;
+    }
+
+    memcpy (dst, win->buffer + (off - win->offset), sz);
+    *offsetp = off + sz;
+    return EXR_ERR_SUCCESS;
+}
+
 static exr_result_t
 extract_chunk_leader (
     exr_const_context_t       ctxt,
     exr_const_priv_part_t     part,
     int                       partnum,
+    struct priv_read_window*  win,
     uint64_t                  offset,
     uint64_t*                 next_offset,
     struct priv_chunk_leader* leaderdata)
@@ -244,13 +321,8 @@ extract_chunk_leader (
     else
         ntoread = 5;
 
-    rv = ctxt->do_read (
-        ctxt,
-        data,
-        (size_t) ntoread * sizeof (int32_t),
-        &nextoffset,
-        NULL,
-        EXR_MUST_READ_ALL);
+    rv = window_read (
+        ctxt, win, data, (uint64_t) ntoread * sizeof (int32_t), &nextoffset);
     if (rv != EXR_ERR_SUCCESS) return rv;
 
     priv_to_native32 (data, ntoread);
@@ -291,13 +363,8 @@ extract_chunk_leader (
     {
         int64_t deep_data[3];
 
-        rv = ctxt->do_read (
-            ctxt,
-            deep_data,
-            3 * sizeof (int64_t),
-            &nextoffset,
-            NULL,
-            EXR_MUST_READ_ALL);
+        rv = window_read (
+            ctxt, win, deep_data, 3 * sizeof (int64_t), &nextoffset);
 
         if (rv != EXR_ERR_SUCCESS) return rv;
         priv_to_native64 (deep_data, 3);
@@ -337,40 +404,48 @@ extract_chunk_leader (
     }
     nextoffset += leaderdata->packed_size;
 
+    if (win)
+    {
+        ++win->leader_count;
+        win->leader_bytes += nextoffset - offset;
+    }
+
     *next_offset = nextoffset;
     return rv;
 }
 
 static exr_result_t
 extract_chunk_size (
-    exr_const_context_t   ctxt,
-    exr_const_priv_part_t part,
-    int                   partnum,
-    uint64_t              offset,
-    uint64_t*             next_offset)
+    exr_const_context_t      ctxt,
+    exr_const_priv_part_t    part,
+    int                      partnum,
+    struct priv_read_window* win,
+    uint64_t                 offset,
+    uint64_t*                next_offset)
 {
     struct priv_chunk_leader leader;
 
     return extract_chunk_leader (
-        ctxt, part, partnum, offset, next_offset, &leader);
+        ctxt, part, partnum, win, offset, next_offset, &leader);
 }
 
 /**************************************/
 
 static exr_result_t
 read_and_validate_chunk_leader (
-    exr_const_context_t   ctxt,
-    exr_const_priv_part_t part,
-    int                   partnum,
-    uint64_t              offset,
-    int*                  indexio,
-    uint64_t*             next_offset)
+    exr_const_context_t      ctxt,
+    exr_const_priv_part_t    part,
+    int                      partnum,
+    struct priv_read_window* win,
+    uint64_t                 offset,
+    int*                     indexio,
+    uint64_t*                next_offset)
 {
     exr_result_t             rv = EXR_ERR_SUCCESS;
     struct priv_chunk_leader leader;
 
     rv = extract_chunk_leader (
-        ctxt, part, partnum, offset, next_offset, &leader);
+        ctxt, part, partnum, win, offset, next_offset, &leader);
     if (rv != EXR_ERR_SUCCESS) return rv;
 
     if (part->storage_mode == EXR_STORAGE_SCANLINE ||
@@ -426,6 +501,7 @@ reconstruct_chunk_table (
     exr_const_priv_part_t curpart = NULL;
     int                   found_ci, computed_ci, partnum = 0;
     size_t                chunkbytes;
+    struct priv_read_window win;
 
     curpart      = ctxt->parts[ctxt->num_parts - 1];
     offset_start = curpart->chunk_table_offset;
@@ -441,13 +517,22 @@ reconstruct_chunk_table (
     max_offset = (uint64_t) -1;
     if (ctxt->file_size > 0) max_offset = (uint64_t) ctxt->file_size;
 
+    // if the window can't be allocated, fall back to reading each
+    // leader individually
+    memset (&win, 0, sizeof (win));
+    win.buffer = (uint8_t*) ctxt->alloc_fn (EXR_RECONSTRUCT_MAX_READ);
+
     // for multi-part, need to start at the first part and extract everything, then
     // work our way back up to this one, then grab the end of the previous part
     if (partnum > 0)
     {
         curpart = ctxt->parts[partnum - 1];
         rv      = extract_chunk_table (ctxt, curpart, &curctable, &chunk_start);
-        if (rv != EXR_ERR_SUCCESS) return rv;
+        if (rv != EXR_ERR_SUCCESS)
+        {
+            if (win.buffer) ctxt->free_fn (win.buffer);
+            return rv;
+        }
 
         chunk_start = offset_start;
         for (int ci = 0; ci < curpart->chunk_count; ++ci)
@@ -457,13 +542,21 @@ reconstruct_chunk_table (
         }
 
         rv = extract_chunk_size (
-            ctxt, curpart, partnum - 1, chunk_start, &offset_start);
-        if (rv != EXR_ERR_SUCCESS) return rv;
+            ctxt, curpart, partnum - 1, &win, chunk_start, &offset_start);
+        if (rv != EXR_ERR_SUCCESS)
+        {
+            if (win.buffer) ctxt->free_fn (win.buffer);
+            return rv;
+        }
     }
 
     chunkbytes = (size_t) part->chunk_count * sizeof (uint64_t);
     curctable  = (uint64_t*) ctxt->alloc_fn (chunkbytes);
-    if (!curctable) return EXR_ERR_OUT_OF_MEMORY;
+    if (!curctable)
+    {
+        if (win.buffer) ctxt->free_fn (win.buffer);
+        return EXR_ERR_OUT_OF_MEMORY;
+    }
 
     memset (curctable, 0, chunkbytes);
 
@@ -480,7 +573,7 @@ reconstruct_chunk_table (
         found_ci = computed_ci;
 
         rv = read_and_validate_chunk_leader (
-            ctxt, part, partnum, chunk_start, &found_ci, &offset_start);
+            ctxt, part, partnum, &win, chunk_start, &found_ci, &offset_start);
         if (rv != EXR_ERR_SUCCESS)
         {
             chunk_start = 0;
@@ -505,6 +598,7 @@ reconstruct_chunk_table (
         }
     }
     ctxt->free_fn (curctable);
+    if (win.buffer) ctxt->free_fn (win.buffer);
 
     return firstfailrv;
 }
@@ -2124,7 +2218,9 @@ write_tile_chunk (
     if (ctxt->cur_output_part != part_index)
         return ctxt->standard_error (ctxt, EXR_ERR_INCORRECT_PART);
 
-    if (!packed_data || packed_size == 0)
+    /* a deep tile with no samples has no packed data */
+    if ((packed_size > 0 && !packed_data) ||
+        (packed_size == 0 && part->storage_mode != EXR_STORAGE_DEEP_TILED))
         return ctxt->print_error (
             ctxt,
             EXR_ERR_INVALID_ARGUMENT,
@@ -2219,7 +2315,7 @@ write_tile_chunk (
                 sample_data_size,
                 &(ctxt->output_file_offset));
     }
-    if (rv == EXR_ERR_SUCCESS)
+    if (rv == EXR_ERR_SUCCESS && packed_size > 0)
         rv = ctxt->do_write (
             ctxt, packed_data, packed_size, &(ctxt->output_file_offset));
 
@@ -2328,6 +2424,344 @@ exr_write_deep_tile_chunk (
 
 /**************************************/
 
+/* chunks whose payloads are adjacent in the source file (separated by
+ * no more than a chunk leader) are read together with a single read
+ * of up to this many bytes */
+#define EXR_COPY_CHUNKS_WINDOW (8 * 1024 * 1024)
+#define EXR_COPY_CHUNKS_BATCH 64
+#define EXR_COPY_CHUNKS_MAX_GAP 64
+
+typedef struct
+{
+    int32_t          tilex;
+    int32_t          tiley;
+    int32_t          levelx;
+    int32_t          levely;
+    exr_chunk_info_t cinfo;
+    uint64_t         start;
+    uint64_t         end;
+} copy_chunk_t;
+
+static exr_result_t
+validate_copy_parts (
+    exr_context_t         ctxt,
+    exr_const_priv_part_t part,
+    exr_const_priv_part_t srcpart)
+{
+    const exr_attr_chlist_t* chans;
+    const exr_attr_chlist_t* srcchans;
+
+    if (part->storage_mode != srcpart->storage_mode)
+        return ctxt->report_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Unable to copy chunks between parts of different storage types");
+
+    if (part->comp_type != srcpart->comp_type)
+        return ctxt->report_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Unable to copy chunks between parts with different compression");
+
+    if (part->data_window.min.x != srcpart->data_window.min.x ||
+        part->data_window.min.y != srcpart->data_window.min.y ||
+        part->data_window.max.x != srcpart->data_window.max.x ||
+        part->data_window.max.y != srcpart->data_window.max.y)
+        return ctxt->report_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Unable to copy chunks between parts with different data windows");
+
+    if (!part->channels || !srcpart->channels)
+        return ctxt->standard_error (ctxt, EXR_ERR_MISSING_REQ_ATTR);
+
+    chans    = part->channels->chlist;
+    srcchans = srcpart->channels->chlist;
+    if (chans->num_channels != srcchans->num_channels)
+        return ctxt->report_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Unable to copy chunks between parts with different channels");
+
+    for (int c = 0; c < chans->num_channels; ++c)
+    {
+        const exr_attr_chlist_entry_t* a = chans->entries + c;
+        const exr_attr_chlist_entry_t* b = srcchans->entries + c;
+
+        if (a->pixel_type != b->pixel_type || a->x_sampling != b->x_sampling ||
+            a->y_sampling != b->y_sampling ||
+            a->name.length != b->name.length ||
+            0 != strcmp (a->name.str, b->name.str))
+            return ctxt->print_error (
+                ctxt,
+                EXR_ERR_INVALID_ARGUMENT,
+                "Unable to copy chunks between parts with different channels ('%s' vs '%s')",
+                a->name.str,
+                b->name.str);
+    }
+
+    if (part->storage_mode == EXR_STORAGE_TILED ||
+        part->storage_mode == EXR_STORAGE_DEEP_TILED)
+    {
+        const exr_attr_tiledesc_t* td;
+        const exr_attr_tiledesc_t* srctd;
+
+        if (!part->tiles || !srcpart->tiles)
+            return ctxt->standard_error (ctxt, EXR_ERR_MISSING_REQ_ATTR);
+
+        td    = part->tiles->tiledesc;
+        srctd = srcpart->tiles->tiledesc;
+        if (td->x_size != srctd->x_size || td->y_size != srctd->y_size ||
+            td->level_and_round != srctd->level_and_round)
+            return ctxt->report_error (
+                ctxt,
+                EXR_ERR_INVALID_ARGUMENT,
+                "Unable to copy chunks between parts with different tile descriptions");
+    }
+
+    if (part->chunk_count != srcpart->chunk_count)
+        return ctxt->print_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Unable to copy chunks: destination has %d chunks, source %d",
+            part->chunk_count,
+            srcpart->chunk_count);
+
+    return EXR_ERR_SUCCESS;
+}
+
+/* advance the tile / scanline coordinates to the next chunk, in
+ * chunk table order */
+static void
+next_copy_chunk (exr_const_priv_part_t part, copy_chunk_t* c)
+{
+    if (part->storage_mode == EXR_STORAGE_SCANLINE ||
+        part->storage_mode == EXR_STORAGE_DEEP_SCANLINE)
+    {
+        c->tiley += part->lines_per_chunk;
+        return;
+    }
+
+    if (++(c->tilex) < part->tile_level_tile_count_x[c->levelx]) return;
+    c->tilex = 0;
+    if (++(c->tiley) < part->tile_level_tile_count_y[c->levely]) return;
+    c->tiley = 0;
+
+    if (EXR_GET_TILE_LEVEL_MODE ((*(part->tiles->tiledesc))) ==
+        EXR_TILE_RIPMAP_LEVELS)
+    {
+        if (++(c->levelx) < part->num_tile_levels_x) return;
+        c->levelx = 0;
+        ++(c->levely);
+    }
+    else
+    {
+        ++(c->levelx);
+        ++(c->levely);
+    }
+}
+
+static exr_result_t
+copy_chunk_batch (
+    exr_context_t       ctxt,
+    int                 part_index,
+    exr_priv_part_t     part,
+    exr_const_context_t source,
+    copy_chunk_t*       batch,
+    int                 n,
+    uint8_t**           buf,
+    uint64_t*           bufsize)
+{
+    exr_result_t rv;
+    uint64_t     start = batch[0].start;
+    uint64_t     span  = batch[n - 1].end - start;
+    uint64_t     off   = start;
+
+    if (span > *bufsize)
+    {
+        if (*buf) ctxt->free_fn (*buf);
+        *bufsize = 0;
+        *buf     = ctxt->alloc_fn (span);
+        if (!*buf) return ctxt->standard_error (ctxt, EXR_ERR_OUT_OF_MEMORY);
+        *bufsize = span;
+    }
+
+    if (span > 0)
+    {
+        rv = source->do_read (
+            source, *buf, span, &off, NULL, EXR_MUST_READ_ALL);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        const copy_chunk_t*     c      = batch + i;
+        const exr_chunk_info_t* ci     = &(c->cinfo);
+        const uint8_t*          packed = *buf + (ci->data_offset - start);
+        const uint8_t*          sample = NULL;
+
+        if (ci->sample_count_table_size > 0)
+            sample = *buf + (ci->sample_count_data_offset - start);
+
+        if (part->storage_mode == EXR_STORAGE_SCANLINE ||
+            part->storage_mode == EXR_STORAGE_DEEP_SCANLINE)
+        {
+            rv = write_scan_chunk (
+                ctxt,
+                part_index,
+                part,
+                c->tiley,
+                packed,
+                ci->packed_size,
+                ci->unpacked_size,
+                sample,
+                ci->sample_count_table_size);
+        }
+        else
+        {
+            rv = write_tile_chunk (
+                ctxt,
+                part_index,
+                part,
+                c->tilex,
+                c->tiley,
+                c->levelx,
+                c->levely,
+                packed,
+                ci->packed_size,
+                ci->unpacked_size,
+                sample,
+                ci->sample_count_table_size);
+        }
+        if (rv != EXR_ERR_SUCCESS) return rv;
+    }
+    return EXR_ERR_SUCCESS;
+}
+
+exr_result_t
+exr_copy_chunks (
+    exr_context_t       ctxt,
+    int                 part_index,
+    exr_const_context_t source,
+    int                 src_part_index)
+{
+    exr_result_t          rv;
+    exr_const_priv_part_t srcpart;
+    copy_chunk_t          batch[EXR_COPY_CHUNKS_BATCH];
+    copy_chunk_t          cur;
+    uint8_t*              buf     = NULL;
+    uint64_t              bufsize = 0;
+    int                   done, n, carry;
+    EXR_LOCK_AND_DEFINE_PART (part_index);
+
+    if (!source) return EXR_UNLOCK_AND_RETURN (EXR_ERR_MISSING_CONTEXT_ARG);
+    if (source->mode != EXR_CONTEXT_READ)
+        return EXR_UNLOCK_AND_RETURN (
+            source->standard_error (source, EXR_ERR_NOT_OPEN_READ));
+    if (src_part_index < 0 || src_part_index >= source->num_parts)
+        return EXR_UNLOCK_AND_RETURN (ctxt->print_error (
+            ctxt,
+            EXR_ERR_ARGUMENT_OUT_OF_RANGE,
+            "Source part index (%d) out of range",
+            src_part_index));
+    srcpart = source->parts[src_part_index];
+
+    if (ctxt->mode != EXR_CONTEXT_WRITING_DATA)
+    {
+        if (ctxt->mode == EXR_CONTEXT_WRITE)
+            return EXR_UNLOCK_AND_RETURN (
+                ctxt->standard_error (ctxt, EXR_ERR_HEADER_NOT_WRITTEN));
+        return EXR_UNLOCK_AND_RETURN (
+            ctxt->standard_error (ctxt, EXR_ERR_NOT_OPEN_WRITE));
+    }
+    if (ctxt->cur_output_part != part_index)
+        return EXR_UNLOCK_AND_RETURN (
+            ctxt->standard_error (ctxt, EXR_ERR_INCORRECT_PART));
+    if (ctxt->output_chunk_count != 0)
+        return EXR_UNLOCK_AND_RETURN (ctxt->report_error (
+            ctxt,
+            EXR_ERR_INCORRECT_CHUNK,
+            "Unable to copy chunks to a part which already has chunks written"));
+
+    rv = validate_copy_parts (ctxt, part, srcpart);
+    if (rv != EXR_ERR_SUCCESS) return EXR_UNLOCK_AND_RETURN (rv);
+
+    memset (&cur, 0, sizeof (cur));
+    cur.tiley = part->data_window.min.y;
+    if (part->storage_mode == EXR_STORAGE_TILED ||
+        part->storage_mode == EXR_STORAGE_DEEP_TILED)
+        cur.tiley = 0;
+
+    done  = 0;
+    carry = 0;
+    while (rv == EXR_ERR_SUCCESS && done < part->chunk_count)
+    {
+        /* gather a run of chunks adjacent in the source file */
+        n     = carry;
+        carry = 0;
+        while (done + n < part->chunk_count && n < EXR_COPY_CHUNKS_BATCH)
+        {
+            copy_chunk_t* c = batch + n;
+
+            *c = cur;
+            if (part->storage_mode == EXR_STORAGE_SCANLINE ||
+                part->storage_mode == EXR_STORAGE_DEEP_SCANLINE)
+                rv = exr_read_scanline_chunk_info (
+                    source, src_part_index, c->tiley, &(c->cinfo));
+            else
+                rv = exr_read_tile_chunk_info (
+                    source,
+                    src_part_index,
+                    c->tilex,
+                    c->tiley,
+                    c->levelx,
+                    c->levely,
+                    &(c->cinfo));
+            if (rv != EXR_ERR_SUCCESS) break;
+            next_copy_chunk (part, &cur);
+
+            c->start = c->cinfo.data_offset;
+            if (c->cinfo.sample_count_table_size > 0)
+                c->start = c->cinfo.sample_count_data_offset;
+            c->end = c->cinfo.data_offset + c->cinfo.packed_size;
+            if (c->cinfo.data_offset < c->start ||
+                (c->cinfo.sample_count_table_size > 0 &&
+                 c->cinfo.sample_count_data_offset +
+                         c->cinfo.sample_count_table_size >
+                     c->end))
+            {
+                rv = ctxt->report_error (
+                    ctxt,
+                    EXR_ERR_BAD_CHUNK_LEADER,
+                    "Unable to copy chunk with sample count table after its data");
+                break;
+            }
+
+            if (n > 0 &&
+                (c->start < batch[n - 1].end ||
+                 c->start - batch[n - 1].end > EXR_COPY_CHUNKS_MAX_GAP ||
+                 c->end - batch[0].start > EXR_COPY_CHUNKS_WINDOW))
+            {
+                carry = 1;
+                break;
+            }
+            ++n;
+        }
+
+        if (rv == EXR_ERR_SUCCESS && n > 0)
+            rv = copy_chunk_batch (
+                ctxt, part_index, part, source, batch, n, &buf, &bufsize);
+
+        done += n;
+        if (carry) batch[0] = batch[n];
+    }
+
+    if (buf) ctxt->free_fn (buf);
+    return EXR_UNLOCK_AND_RETURN (rv);
+}
+
+/**************************************/
+
 exr_result_t
 internal_validate_next_chunk (
     exr_encode_pipeline_t* encode,
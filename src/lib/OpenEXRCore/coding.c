@@ -4,6 +4,7 @@
 */
 
 #include "internal_coding.h"
+#include "internal_buffer_pool.h"
 #include "internal_util.h"
 
 #include <string.h>
@@ -134,7 +135,8 @@ internal_encode_free_buffer (
                 exr_const_context_t ctxt = encode->context;
                 EXR_CHECK_CONTEXT_AND_PART (encode->part_index);
 
-                ctxt->free_fn (curbuf);
+                internal_exr_buffer_pool_release (
+                    ctxt->buffer_pool, curbuf, cursz);
             }
         }
         *buf = NULL;
@@ -151,7 +153,8 @@ internal_encode_alloc_buffer (
     size_t*                              cursz,
     size_t                               newsz)
 {
-    void* curbuf = *buf;
+    void*  curbuf  = *buf;
+    size_t allocsz = newsz;
     if (newsz == 0)
     {
         exr_const_context_t ctxt = encode->context;
@@ -175,7 +178,8 @@ internal_encode_alloc_buffer (
             exr_const_context_t ctxt = encode->context;
             EXR_CHECK_CONTEXT_AND_PART (encode->part_index);
 
-            curbuf = ctxt->alloc_fn (newsz);
+            curbuf = internal_exr_buffer_pool_acquire (
+                ctxt->buffer_pool, newsz, &allocsz);
         }
 
         if (curbuf == NULL)
@@ -191,7 +195,7 @@ internal_encode_alloc_buffer (
         }
 
         *buf   = curbuf;
-        *cursz = newsz;
+        *cursz = allocsz;
     }
     return EXR_ERR_SUCCESS;
 }
@@ -216,7 +220,8 @@ internal_decode_free_buffer (
                 exr_const_context_t ctxt = decode->context;
                 EXR_CHECK_CONTEXT_AND_PART (decode->part_index);
 
-                ctxt->free_fn (curbuf);
+                internal_exr_buffer_pool_release (
+                    ctxt->buffer_pool, curbuf, cursz);
             }
         }
         *buf = NULL;
@@ -233,7 +238,8 @@ internal_decode_alloc_buffer (
     size_t*                              cursz,
     size_t                               newsz)
 {
-    void* curbuf = *buf;
+    void*  curbuf  = *buf;
+    size_t allocsz = newsz;
 
     /* We might have a zero size here due to y sampling on a scanline
      * image where there is an attempt to read that portion of the
@@ -253,7 +259,10 @@ internal_decode_alloc_buffer (
             exr_const_context_t ctxt = decode->context;
             EXR_CHECK_CONTEXT_AND_PART (decode->part_index);
 
-            curbuf = ctxt->alloc_fn (newsz);
+            /* may round up, so the buffer can be re-used for larger
+             * requests, record the actual size */
+            curbuf = internal_exr_buffer_pool_acquire (
+                ctxt->buffer_pool, newsz, &allocsz);
         }
 
         if (curbuf == NULL)
@@ -269,7 +278,7 @@ internal_decode_alloc_buffer (
         }
 
         *buf   = curbuf;
-        *cursz = newsz;
+        *cursz = allocsz;
     }
     return EXR_ERR_SUCCESS;
 }
@@ -7,6 +7,7 @@
 #include "openexr_base.h"
 #include "internal_memory.h"
 #include "internal_structs.h"
+#include "internal_buffer_pool.h"
 #include "internal_compress.h"
 #include "internal_decompress.h"
 #include "internal_coding.h"
@@ -79,7 +80,7 @@ exr_compress_buffer (
     size_t              out_bytes_avail,
     size_t*             actual_out)
 {
-    struct libdeflate_compressor* comp;
+    struct libdeflate_compressor* comp = NULL;
 
 #ifdef EXR_USE_CONFIG_DEFLATE_STRUCT
     struct libdeflate_options opt = {
@@ -100,18 +101,30 @@ exr_compress_buffer (
         if (level < 0) level = EXR_DEFAULT_ZLIB_COMPRESS_LEVEL;
     }
 
+    /* a compressor is a few hundred KiB which libdeflate initializes
+     * on creation, re-use an idle one from the context pool if we can */
+    if (ctxt)
+        comp = internal_exr_buffer_pool_take_compressor (
+            ctxt->buffer_pool, level);
+    if (!comp)
+    {
 #ifdef EXR_USE_CONFIG_DEFLATE_STRUCT
-    comp = libdeflate_alloc_compressor_ex (level, &opt);
+        comp = libdeflate_alloc_compressor_ex (level, &opt);
 #else
-    comp = libdeflate_alloc_compressor (level);
+        comp = libdeflate_alloc_compressor (level);
 #endif
+    }
     if (comp)
     {
         size_t outsz;
         outsz =
             libdeflate_zlib_compress (comp, in, in_bytes, out, out_bytes_avail);
 
-        libdeflate_free_compressor (comp);
+        if (ctxt)
+            internal_exr_buffer_pool_give_compressor (
+                ctxt->buffer_pool, comp, level);
+        else
+            libdeflate_free_compressor (comp);
 
         if (outsz != 0)
         {
@@ -134,7 +147,7 @@ exr_uncompress_buffer (
     size_t              out_bytes_avail,
     size_t*             actual_out)
 {
-    struct libdeflate_decompressor* decomp;
+    struct libdeflate_decompressor* decomp = NULL;
     enum libdeflate_result          res;
     size_t                          actual_in_bytes;
 #ifdef EXR_USE_CONFIG_DEFLATE_STRUCT
@@ -153,14 +166,20 @@ exr_uncompress_buffer (
 //        return EXR_ERR_SUCCESS;
 //    }
 
+    if (ctxt)
+        decomp = internal_exr_buffer_pool_take_decompressor (
+            ctxt->buffer_pool);
+    if (!decomp)
+    {
 #ifdef EXR_USE_CONFIG_DEFLATE_STRUCT
-    decomp = libdeflate_alloc_decompressor_ex (&opt);
+        decomp = libdeflate_alloc_decompressor_ex (&opt);
 #else
-    libdeflate_set_memory_allocator (
-        ctxt ? ctxt->alloc_fn : internal_exr_alloc,
-        ctxt ? ctxt->free_fn : internal_exr_free);
-    decomp = libdeflate_alloc_decompressor ();
+        libdeflate_set_memory_allocator (
+            ctxt ? ctxt->alloc_fn : internal_exr_alloc,
+            ctxt ? ctxt->free_fn : internal_exr_free);
+        decomp = libdeflate_alloc_decompressor ();
 #endif
+    }
     if (decomp)
     {
         res = libdeflate_zlib_decompress_ex (
@@ -172,7 +191,13 @@ exr_uncompress_buffer (
             &actual_in_bytes,
             actual_out);
 
-        libdeflate_free_decompressor (decomp);
+        /* the decompressor keeps no state between calls, so it can be
+         * handed back even if the stream was corrupt */
+        if (ctxt)
+            internal_exr_buffer_pool_give_decompressor (
+                ctxt->buffer_pool, decomp);
+        else
+            libdeflate_free_decompressor (decomp);
 
         if (res == LIBDEFLATE_SUCCESS)
         {
@@ -15,6 +15,7 @@
 
 #include "internal_constants.h"
 #include "internal_file.h"
+#include "internal_xdr.h"
 #include "backward_compatibility.h"
 
 #if defined(_WIN32) || defined(_WIN64)
@@ -66,6 +67,47 @@ dispatch_read (
 
 /**************************************/
 
+/* used in place of dispatch_read while parsing the header of a file
+ * opened from an index entry: requests for the header bytes are
+ * served from the entry, anything past them goes to the file */
+static exr_result_t
+dispatch_cached_read (
+    exr_const_context_t          ctxt,
+    void*                        buf,
+    uint64_t                     sz,
+    uint64_t*                    offsetp,
+    int64_t*                     nread,
+    enum _INTERNAL_EXR_READ_MODE rmode)
+{
+    uint64_t     off, avail;
+    exr_result_t rv;
+
+    if (!ctxt) return EXR_ERR_MISSING_CONTEXT_ARG;
+
+    if (!offsetp || *offsetp >= ctxt->header_cache_size)
+        return dispatch_read (ctxt, buf, sz, offsetp, nread, rmode);
+
+    off   = *offsetp;
+    avail = ctxt->header_cache_size - off;
+    if (sz <= avail || rmode == EXR_ALLOW_SHORT_READ)
+    {
+        if (sz > avail) sz = avail;
+        memcpy (buf, ctxt->header_cache + off, sz);
+        *offsetp += sz;
+        if (nread) *nread = (int64_t) sz;
+        return EXR_ERR_SUCCESS;
+    }
+
+    memcpy (buf, ctxt->header_cache + off, avail);
+    *offsetp += avail;
+    rv = dispatch_read (
+        ctxt, ((uint8_t*) buf) + avail, sz - avail, offsetp, nread, rmode);
+    if (nread && *nread >= 0) *nread += (int64_t) avail;
+    return rv;
+}
+
+/**************************************/
+
 static exr_result_t
 dispatch_write (
     exr_context_t ctxt, const void* buf, uint64_t sz, uint64_t* offsetp)
@@ -134,6 +176,10 @@ fill_context_data (const exr_context_initializer_t* ctxtdata)
         {
             inits.flags = ctxtdata->flags;
         }
+        if (ctxtdata->size >= sizeof (struct _exr_context_initializer_v4))
+        {
+            inits.header_read_size = ctxtdata->header_read_size;
+        }
     }
 
     internal_exr_update_default_handlers (&inits);
@@ -224,10 +270,141 @@ exr_finish (exr_context_t* pctxt)
 
 /**************************************/
 
-exr_result_t
-exr_start_read (
+/* an index entry is a fixed size header, the chunk count of each
+ * part, the raw header bytes of the file, then the chunk tables, all
+ * little endian */
+#define EXR_INDEX_ENTRY_VERSION 1
+#define EXR_INDEX_ENTRY_HEADER_SIZE 32
+#define EXR_INDEX_VERSION 1
+#define EXR_INDEX_HEADER_SIZE 16
+#define EXR_INDEX_RECORD_SIZE 16
+
+struct _index_entry_info
+{
+    uint64_t       file_size;
+    uint64_t       header_size;
+    int32_t        num_parts;
+    const uint8_t* counts;
+    const uint8_t* header;
+    const uint8_t* tables;
+};
+
+static inline uint32_t
+read_le32 (const uint8_t* p)
+{
+    uint32_t v;
+    memcpy (&v, p, sizeof (v));
+    return one_to_native32 (v);
+}
+
+static inline uint64_t
+read_le64 (const uint8_t* p)
+{
+    uint64_t v;
+    memcpy (&v, p, sizeof (v));
+    return one_to_native64 (v);
+}
+
+static inline void
+write_le32 (uint8_t* p, uint32_t v)
+{
+    v = one_from_native32 (v);
+    memcpy (p, &v, sizeof (v));
+}
+
+static inline void
+write_le64 (uint8_t* p, uint64_t v)
+{
+    v = one_from_native64 (v);
+    memcpy (p, &v, sizeof (v));
+}
+
+static int
+parse_index_entry (
+    const void* entry, size_t entrysize, struct _index_entry_info* info)
+{
+    const uint8_t* data = (const uint8_t*) entry;
+    uint64_t       remain;
+
+    if (!data || entrysize < EXR_INDEX_ENTRY_HEADER_SIZE) return 0;
+    if (memcmp (data, "EXRI", 4) != 0 ||
+        read_le32 (data + 4) != EXR_INDEX_ENTRY_VERSION)
+        return 0;
+
+    info->file_size   = read_le64 (data + 8);
+    info->header_size = read_le64 (data + 16);
+    info->num_parts   = (int32_t) read_le32 (data + 24);
+
+    remain = entrysize - EXR_INDEX_ENTRY_HEADER_SIZE;
+    if (info->num_parts <= 0 ||
+        (uint64_t) info->num_parts > remain / sizeof (int32_t))
+        return 0;
+    info->counts = data + EXR_INDEX_ENTRY_HEADER_SIZE;
+    remain -= sizeof (int32_t) * (uint64_t) info->num_parts;
+
+    /* at least the magic and version of the file */
+    if (info->header_size < 8 || info->header_size > remain) return 0;
+    info->header = info->counts + sizeof (int32_t) * (size_t) info->num_parts;
+    info->tables = info->header + info->header_size;
+    remain -= info->header_size;
+
+    for (int32_t p = 0; p < info->num_parts; ++p)
+    {
+        int32_t count = (int32_t) read_le32 (info->counts + 4 * p);
+        if (count < 0 || (uint64_t) count > remain / sizeof (uint64_t))
+            return 0;
+        remain -= sizeof (uint64_t) * (uint64_t) count;
+    }
+    return remain == 0;
+}
+
+/**************************************/
+
+static exr_result_t
+install_index_chunk_tables (
+    exr_context_t ctxt, const struct _index_entry_info* info)
+{
+    const uint8_t* tables = info->tables;
+
+    if (ctxt->num_parts != info->num_parts ||
+        ctxt->parts[0]->chunk_table_offset != info->header_size)
+        return ctxt->report_error (
+            ctxt,
+            EXR_ERR_FILE_BAD_HEADER,
+            "Index entry does not match the header it contains");
+
+    for (int p = 0; p < ctxt->num_parts; ++p)
+    {
+        exr_priv_part_t part  = ctxt->parts[p];
+        int32_t         count = (int32_t) read_le32 (info->counts + 4 * p);
+        exr_result_t    rv;
+
+        if (count != part->chunk_count)
+            return ctxt->print_error (
+                ctxt,
+                EXR_ERR_FILE_BAD_HEADER,
+                "Index entry chunk count (%d) does not match part %d chunk count (%d)",
+                count,
+                p,
+                part->chunk_count);
+
+        /* leave empty parts for the normal path to complain about */
+        if (count == 0) continue;
+
+        rv = internal_exr_set_chunk_table (ctxt, part, tables, count, 1);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+        tables += sizeof (uint64_t) * (size_t) count;
+    }
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+static exr_result_t
+start_read_impl (
     exr_context_t*                   ctxt,
     const char*                      filename,
+    const struct _index_entry_info*  info,
     const exr_context_initializer_t* ctxtdata)
 {
     exr_result_t              rv    = EXR_ERR_UNKNOWN;
@@ -267,7 +444,39 @@ exr_start_read (
 
                 if (rv == EXR_ERR_SUCCESS)
                     rv = process_query_size (ret, &inits);
+
+                if (rv == EXR_ERR_SUCCESS && info)
+                {
+                    if (info->file_size > 0 && ret->file_size > 0 &&
+                        info->file_size != (uint64_t) ret->file_size)
+                    {
+                        rv = ret->print_error (
+                            ret,
+                            EXR_ERR_FILE_BAD_HEADER,
+                            "Index entry is for a file of %" PRIu64
+                            " bytes, but '%s' is %" PRId64 " bytes",
+                            info->file_size,
+                            filename,
+                            ret->file_size);
+                    }
+                    else
+                    {
+                        ret->header_cache      = info->header;
+                        ret->header_cache_size = info->header_size;
+                        ret->do_read           = &dispatch_cached_read;
+                    }
+                }
+
                 if (rv == EXR_ERR_SUCCESS) rv = internal_exr_parse_header (ret);
+
+                if (info)
+                {
+                    ret->do_read           = &dispatch_read;
+                    ret->header_cache      = NULL;
+                    ret->header_cache_size = 0;
+                    if (rv == EXR_ERR_SUCCESS)
+                        rv = install_index_chunk_tables (ret, info);
+                }
             }
 
             if (rv != EXR_ERR_SUCCESS) exr_finish ((exr_context_t*) &ret);
@@ -291,6 +500,232 @@ exr_start_read (
 
 /**************************************/
 
+exr_result_t
+exr_start_read (
+    exr_context_t*                   ctxt,
+    const char*                      filename,
+    const exr_context_initializer_t* ctxtdata)
+{
+    return start_read_impl (ctxt, filename, NULL, ctxtdata);
+}
+
+/**************************************/
+
+exr_result_t
+exr_start_read_indexed (
+    exr_context_t*                   ctxt,
+    const char*                      filename,
+    const void*                      entry,
+    size_t                           entrysize,
+    const exr_context_initializer_t* ctxtdata)
+{
+    struct _index_entry_info info;
+
+    if (!parse_index_entry (entry, entrysize, &info))
+    {
+        exr_context_initializer_t inits = fill_context_data (ctxtdata);
+
+        if (!(inits.flags & EXR_CONTEXT_FLAG_SILENT_HEADER_PARSE))
+            inits.error_handler_fn (
+                NULL,
+                EXR_ERR_INVALID_ARGUMENT,
+                "Invalid index entry passed to start_read_indexed function");
+        if (ctxt) *ctxt = NULL;
+        return EXR_ERR_INVALID_ARGUMENT;
+    }
+
+    return start_read_impl (ctxt, filename, &info, ctxtdata);
+}
+
+/**************************************/
+
+exr_result_t
+exr_get_index_entry (exr_const_context_t ctxt, void* buffer, size_t* size)
+{
+    uint64_t     hdrsize, total;
+    uint64_t     fileoff = 0;
+    int64_t      nread   = 0;
+    uint8_t*     out;
+    exr_result_t rv;
+
+    if (!ctxt) return EXR_ERR_MISSING_CONTEXT_ARG;
+    if (ctxt->mode != EXR_CONTEXT_READ)
+        return ctxt->standard_error (ctxt, EXR_ERR_NOT_OPEN_READ);
+    if (!size) return ctxt->standard_error (ctxt, EXR_ERR_INVALID_ARGUMENT);
+
+    hdrsize = ctxt->parts[0]->chunk_table_offset;
+    total   = EXR_INDEX_ENTRY_HEADER_SIZE + hdrsize +
+            sizeof (int32_t) * (uint64_t) ctxt->num_parts;
+    for (int p = 0; p < ctxt->num_parts; ++p)
+        total += sizeof (uint64_t) * (uint64_t) ctxt->parts[p]->chunk_count;
+
+    if (!buffer)
+    {
+        *size = (size_t) total;
+        return EXR_ERR_SUCCESS;
+    }
+
+    if ((uint64_t) *size < total)
+        return ctxt->print_error (
+            ctxt,
+            EXR_ERR_ARGUMENT_OUT_OF_RANGE,
+            "Index entry buffer too small (%" PRIu64 "), need %" PRIu64
+            " bytes",
+            (uint64_t) *size,
+            total);
+
+    out = (uint8_t*) buffer;
+    memcpy (out, "EXRI", 4);
+    write_le32 (out + 4, EXR_INDEX_ENTRY_VERSION);
+    write_le64 (
+        out + 8, ctxt->file_size > 0 ? (uint64_t) ctxt->file_size : 0);
+    write_le64 (out + 16, hdrsize);
+    write_le32 (out + 24, (uint32_t) ctxt->num_parts);
+    write_le32 (out + 28, 0);
+    out += EXR_INDEX_ENTRY_HEADER_SIZE;
+
+    for (int p = 0; p < ctxt->num_parts; ++p)
+    {
+        write_le32 (out, (uint32_t) ctxt->parts[p]->chunk_count);
+        out += sizeof (int32_t);
+    }
+
+    /* the header is not kept in its serialized form, read it again */
+    rv = ctxt->do_read (
+        ctxt, out, hdrsize, &fileoff, &nread, EXR_MUST_READ_ALL);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+    out += hdrsize;
+
+    for (int p = 0; p < ctxt->num_parts; ++p)
+    {
+        uint64_t* ctable = NULL;
+        int32_t   count  = ctxt->parts[p]->chunk_count;
+
+        if (count <= 0) continue;
+
+        /* loads (or reconstructs) the table if not done already */
+        rv = exr_get_chunk_table (ctxt, p, &ctable, &count);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+
+        for (int32_t c = 0; c < count; ++c)
+        {
+            write_le64 (out, ctable[c]);
+            out += sizeof (uint64_t);
+        }
+    }
+
+    *size = (size_t) total;
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+static exr_result_t
+check_index (const void* index, size_t indexsize, uint64_t* count)
+{
+    const uint8_t* data = (const uint8_t*) index;
+
+    if (!data) return EXR_ERR_INVALID_ARGUMENT;
+    if (indexsize < EXR_INDEX_HEADER_SIZE || memcmp (data, "EXRX", 4) != 0 ||
+        read_le32 (data + 4) != EXR_INDEX_VERSION)
+        return EXR_ERR_FILE_BAD_HEADER;
+
+    *count = read_le64 (data + 8);
+    return EXR_ERR_SUCCESS;
+}
+
+static exr_result_t
+next_index_record (
+    const void*  index,
+    size_t       indexsize,
+    uint64_t*    pos,
+    const char** name,
+    const void** entry,
+    size_t*      entrysize)
+{
+    const uint8_t* data = (const uint8_t*) index;
+    uint64_t       cur  = *pos;
+    uint64_t       namelen, esize, recsize;
+
+    if ((uint64_t) indexsize - cur < EXR_INDEX_RECORD_SIZE)
+        return EXR_ERR_FILE_BAD_HEADER;
+    namelen = read_le32 (data + cur);
+    esize   = read_le64 (data + cur + 8);
+    cur += EXR_INDEX_RECORD_SIZE;
+
+    if (namelen == 0 || namelen > (uint64_t) indexsize - cur ||
+        esize > (uint64_t) indexsize - cur - namelen ||
+        data[cur + namelen - 1] != '\0')
+        return EXR_ERR_FILE_BAD_HEADER;
+
+    *name      = (const char*) (data + cur);
+    *entry     = data + cur + namelen;
+    *entrysize = (size_t) esize;
+
+    /* records are padded to 8 bytes, except maybe the last one */
+    recsize = (namelen + esize + 7) & ~((uint64_t) 7);
+    if (recsize > (uint64_t) indexsize - cur) recsize = indexsize - cur;
+    *pos = cur + recsize;
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+exr_result_t
+exr_get_index_entry_by_index (
+    const void*  index,
+    size_t       indexsize,
+    int          idx,
+    const char** name,
+    const void** entry,
+    size_t*      entrysize)
+{
+    uint64_t     count, pos = EXR_INDEX_HEADER_SIZE;
+    exr_result_t rv;
+
+    if (!name || !entry || !entrysize) return EXR_ERR_INVALID_ARGUMENT;
+
+    rv = check_index (index, indexsize, &count);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+    if (idx < 0 || (uint64_t) idx >= count)
+        return EXR_ERR_ARGUMENT_OUT_OF_RANGE;
+
+    for (int i = 0; i <= idx && rv == EXR_ERR_SUCCESS; ++i)
+        rv = next_index_record (index, indexsize, &pos, name, entry, entrysize);
+    return rv;
+}
+
+/**************************************/
+
+exr_result_t
+exr_find_index_entry (
+    const void*  index,
+    size_t       indexsize,
+    const char*  name,
+    const void** entry,
+    size_t*      entrysize)
+{
+    uint64_t     count, pos = EXR_INDEX_HEADER_SIZE;
+    const char*  curname;
+    exr_result_t rv;
+
+    if (!name || !entry || !entrysize) return EXR_ERR_INVALID_ARGUMENT;
+
+    rv = check_index (index, indexsize, &count);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        rv = next_index_record (
+            index, indexsize, &pos, &curname, entry, entrysize);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+        if (!strcmp (curname, name)) return EXR_ERR_SUCCESS;
+    }
+    return EXR_ERR_ARGUMENT_OUT_OF_RANGE;
+}
+
+/**************************************/
+
 exr_result_t
 exr_start_write (
     exr_context_t*                   ctxt,
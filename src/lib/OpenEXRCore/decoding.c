@@ -9,6 +9,7 @@
 
 #include "internal_coding.h"
 #include "internal_decompress.h"
+#include "internal_parallel.h"
 #include "internal_structs.h"
 #include "internal_xdr.h"
 
@@ -726,3 +727,271 @@ exr_decoding_destroy (exr_const_context_t ctxt, exr_decode_pipeline_t* decode)
     }
     return EXR_ERR_SUCCESS;
 }
+
+/**************************************/
+
+typedef struct
+{
+    exr_const_context_t                       ctxt;
+    int                                       part_index;
+    const exr_decode_part_parallel_options_t* opts;
+
+    int is_tiled;
+    int chunk_end;
+    int lines_per_chunk;
+    int origin_y;
+    int count_x;
+    int tile_w;
+    int tile_h;
+
+    atomic_uintptr_t next_chunk;
+    atomic_uintptr_t status;
+} parallel_decode_t;
+
+typedef struct
+{
+    exr_decode_pipeline_t decode;
+    /* per part channel, index into the option channel buffers (or -1) */
+    int* chan_to_buffer;
+    int  initialized;
+} parallel_decode_worker_t;
+
+static exr_result_t
+parallel_decode_init_worker (
+    parallel_decode_t*        job,
+    parallel_decode_worker_t* w,
+    const exr_chunk_info_t*   cinfo)
+{
+    exr_const_context_t                       ctxt = job->ctxt;
+    const exr_decode_part_parallel_options_t* opts = job->opts;
+    exr_result_t                              rv;
+
+    rv = exr_decoding_initialize (ctxt, job->part_index, cinfo, &(w->decode));
+    if (rv != EXR_ERR_SUCCESS) return rv;
+    w->initialized = 1;
+
+    w->chan_to_buffer =
+        ctxt->alloc_fn (sizeof (int) * (size_t) w->decode.channel_count);
+    if (!w->chan_to_buffer)
+        return ctxt->standard_error (ctxt, EXR_ERR_OUT_OF_MEMORY);
+
+    for (int c = 0; c < w->decode.channel_count; ++c)
+    {
+        const char* name = w->decode.channels[c].channel_name;
+
+        w->chan_to_buffer[c] = -1;
+        for (int b = 0; b < opts->num_channels; ++b)
+        {
+            const exr_decode_channel_buffer_t* buf = opts->channels + b;
+            if (buf->channel_name && buf->base &&
+                !strcmp (buf->channel_name, name))
+            {
+                w->chan_to_buffer[c] = b;
+                break;
+            }
+        }
+    }
+    return EXR_ERR_SUCCESS;
+}
+
+static exr_result_t
+parallel_decode_chunk (
+    parallel_decode_t* job, parallel_decode_worker_t* w, int idx)
+{
+    exr_const_context_t                       ctxt = job->ctxt;
+    const exr_decode_part_parallel_options_t* opts = job->opts;
+    exr_chunk_info_t                          cinfo;
+    exr_result_t                              rv;
+    int64_t                                   x0, y0;
+    int                                       first = 0;
+
+    if (job->is_tiled)
+    {
+        rv = exr_read_tile_chunk_info (
+            ctxt,
+            job->part_index,
+            idx % job->count_x,
+            idx / job->count_x,
+            opts->level_x,
+            opts->level_y,
+            &cinfo);
+    }
+    else
+    {
+        rv = exr_read_scanline_chunk_info (
+            ctxt,
+            job->part_index,
+            job->origin_y + idx * job->lines_per_chunk,
+            &cinfo);
+    }
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    if (!w->initialized)
+    {
+        rv    = parallel_decode_init_worker (job, w, &cinfo);
+        first = 1;
+    }
+    else
+        rv = exr_decoding_update (ctxt, job->part_index, &cinfo, &(w->decode));
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    if (job->is_tiled)
+    {
+        x0 = (int64_t) cinfo.start_x * (int64_t) job->tile_w;
+        y0 = (int64_t) cinfo.start_y * (int64_t) job->tile_h;
+    }
+    else
+    {
+        x0 = 0;
+        y0 = (int64_t) cinfo.start_y - (int64_t) job->origin_y;
+    }
+
+    for (int c = 0; c < w->decode.channel_count; ++c)
+    {
+        exr_coding_channel_info_t*         decc = w->decode.channels + c;
+        const exr_decode_channel_buffer_t* buf;
+        int                                b = w->chan_to_buffer[c];
+
+        if (b < 0 || decc->height == 0)
+        {
+            decc->decode_to_ptr     = NULL;
+            decc->user_pixel_stride = 0;
+            decc->user_line_stride  = 0;
+            continue;
+        }
+
+        buf                          = opts->channels + b;
+        decc->user_bytes_per_element = buf->user_bytes_per_element;
+        decc->user_data_type         = buf->user_data_type;
+        decc->user_pixel_stride      = buf->pixel_stride;
+        decc->user_line_stride       = buf->line_stride;
+        decc->decode_to_ptr =
+            buf->base +
+            (x0 / decc->x_samples) * (int64_t) buf->pixel_stride +
+            (y0 / decc->y_samples) * (int64_t) buf->line_stride;
+    }
+
+    if (first)
+    {
+        rv = exr_decoding_choose_default_routines (
+            ctxt, job->part_index, &(w->decode));
+        if (rv != EXR_ERR_SUCCESS) return rv;
+    }
+
+    return exr_decoding_run (ctxt, job->part_index, &(w->decode));
+}
+
+static void
+parallel_decode_worker (void* data)
+{
+    parallel_decode_t*       job = (parallel_decode_t*) data;
+    parallel_decode_worker_t w;
+    exr_result_t             rv = EXR_ERR_SUCCESS;
+
+    memset (&w, 0, sizeof (w));
+
+    while (rv == EXR_ERR_SUCCESS && atomic_load (&(job->status)) == 0)
+    {
+        int idx = internal_exr_claim_next (&(job->next_chunk), job->chunk_end);
+        if (idx >= job->chunk_end) break;
+
+        rv = parallel_decode_chunk (job, &w, idx);
+    }
+    internal_exr_record_error (&(job->status), rv);
+
+    if (w.chan_to_buffer) job->ctxt->free_fn (w.chan_to_buffer);
+    if (w.initialized) exr_decoding_destroy (job->ctxt, &(w.decode));
+}
+
+exr_result_t
+exr_decode_part_parallel (
+    exr_const_context_t                       ctxt,
+    int                                       part_index,
+    const exr_decode_part_parallel_options_t* opts)
+{
+    parallel_decode_t job;
+    exr_result_t      rv;
+    void**            tasks;
+    int               nchunks, nthreads;
+    EXR_READONLY_AND_DEFINE_PART (part_index);
+
+    if (!opts || opts->num_channels < 0 ||
+        (opts->num_channels > 0 && !opts->channels))
+        return ctxt->standard_error (ctxt, EXR_ERR_INVALID_ARGUMENT);
+
+    if (part->storage_mode == EXR_STORAGE_DEEP_SCANLINE ||
+        part->storage_mode == EXR_STORAGE_DEEP_TILED)
+        return ctxt->report_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Parallel part decode is not supported for deep data");
+
+    memset (&job, 0, sizeof (job));
+    job.ctxt       = ctxt;
+    job.part_index = part_index;
+    job.opts       = opts;
+
+    if (part->storage_mode == EXR_STORAGE_TILED)
+    {
+        int32_t cy = 0;
+
+        rv = exr_get_tile_counts (
+            ctxt, part_index, opts->level_x, opts->level_y, &(job.count_x), &cy);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+
+        job.is_tiled = 1;
+        job.tile_w   = (int) part->tiles->tiledesc->x_size;
+        job.tile_h   = (int) part->tiles->tiledesc->y_size;
+        nchunks      = job.count_x * cy;
+    }
+    else
+    {
+        int64_t h = (int64_t) part->data_window.max.y -
+                    (int64_t) part->data_window.min.y + 1;
+
+        if (part->lines_per_chunk <= 0)
+            return ctxt->standard_error (ctxt, EXR_ERR_INVALID_ATTR);
+
+        job.lines_per_chunk = part->lines_per_chunk;
+        job.origin_y        = part->data_window.min.y;
+        nchunks             = (int) ((h + part->lines_per_chunk - 1) /
+                             part->lines_per_chunk);
+    }
+
+    job.chunk_end = opts->chunk_end > 0 ? opts->chunk_end : nchunks;
+    if (opts->chunk_begin < 0 || job.chunk_end > nchunks ||
+        opts->chunk_begin > job.chunk_end)
+        return ctxt->print_error (
+            ctxt,
+            EXR_ERR_ARGUMENT_OUT_OF_RANGE,
+            "Invalid chunk range [%d, %d) requested, part has %d chunks",
+            opts->chunk_begin,
+            job.chunk_end,
+            nchunks);
+
+    if (opts->chunk_begin == job.chunk_end) return EXR_ERR_SUCCESS;
+
+    nthreads = opts->num_threads > 0 ? opts->num_threads
+                                     : internal_exr_default_thread_count ();
+    if (nthreads > job.chunk_end - opts->chunk_begin)
+        nthreads = job.chunk_end - opts->chunk_begin;
+
+    tasks = ctxt->alloc_fn (sizeof (void*) * (size_t) nthreads);
+    if (!tasks) return ctxt->standard_error (ctxt, EXR_ERR_OUT_OF_MEMORY);
+    for (int t = 0; t < nthreads; ++t)
+        tasks[t] = &job;
+
+    job.next_chunk = (uintptr_t) opts->chunk_begin;
+
+    rv = internal_exr_run_tasks (
+        ctxt,
+        nthreads,
+        &parallel_decode_worker,
+        tasks,
+        opts->spawn_fn,
+        opts->spawn_user_data);
+    ctxt->free_fn (tasks);
+
+    if (rv == EXR_ERR_SUCCESS) rv = (exr_result_t) atomic_load (&(job.status));
+    return rv;
+}
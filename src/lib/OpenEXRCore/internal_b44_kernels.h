@@ -0,0 +1,804 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#ifndef OPENEXR_PRIVATE_B44_KERNELS_H
+#define OPENEXR_PRIVATE_B44_KERNELS_H
+
+/*
+ * The B44 block coding, and the strips of blocks it is applied to, in
+ * scalar and AVX2 versions. These live in a header of their own so
+ * that the tests can check the two versions against each other.
+ */
+
+#include "openexr_errors.h"
+
+#include "internal_xdr.h"
+
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(_M_X64)) &&                                \
+    (defined(__GNUC__) || defined(__clang__)) && !defined(__e2k__)
+#    define B44_HAVE_AVX2_TARGET 1
+#    include <immintrin.h>
+#endif
+
+/**************************************/
+
+extern const uint16_t* exrcore_expTable;
+extern const uint16_t* exrcore_logTable;
+
+static inline void
+convertFromLinear (uint16_t s[16])
+{
+    for (int i = 0; i < 16; ++i)
+        s[i] = exrcore_expTable[s[i]];
+}
+
+static inline void
+convertToLinear (uint16_t s[16])
+{
+    for (int i = 0; i < 16; ++i)
+        s[i] = exrcore_logTable[s[i]];
+}
+
+/**************************************/
+
+static inline int
+shiftAndRound (int x, int shift)
+{
+    int a, b;
+    //
+    // Compute
+    //
+    //     y = x * pow (2, -shift),
+    //
+    // then round y to the nearest integer.
+    // In case of a tie, where y is exactly
+    // halfway between two integers, round
+    // to the even one.
+    //
+
+    x <<= 1;
+    a = (1 << shift) - 1;
+    shift += 1;
+    b = (x >> shift) & 1;
+    return (x + a + b) >> shift;
+}
+
+/*
+ * Pack a block of 4 by 4 16-bit pixels (32 bytes) into
+ * either 14 or 3 bytes.
+ *
+ *
+ * Integers s[0] ... s[15] represent floating-point numbers
+ * in what is essentially a sign-magnitude format.  Convert
+ * s[0] .. s[15] into a new set of integers, t[0] ... t[15],
+ * such that if t[i] is greater than t[j], the floating-point
+ * number that corresponds to s[i] is always greater than
+ * the floating-point number that corresponds to s[j].
+ *
+ * Also, replace any bit patterns that represent NaNs or
+ * infinities with bit patterns that represent floating-point
+ * zeroes.
+ *
+ *	bit pattern	floating-point		bit pattern
+ *	in s[i]		value			in t[i]
+ *
+ *  0x7fff		NAN			0x8000
+ *  0x7ffe		NAN			0x8000
+ *	  ...					  ...
+ *  0x7c01		NAN			0x8000
+ *  0x7c00		+infinity		0x8000
+ *  0x7bff		+HALF_MAX		0xfbff
+ *  0x7bfe					0xfbfe
+ *  0x7bfd					0xfbfd
+ *	  ...					  ...
+ *  0x0002		+2 * HALF_MIN		0x8002
+ *  0x0001		+HALF_MIN		0x8001
+ *  0x0000		+0.0			0x8000
+ *  0x8000		-0.0			0x7fff
+ *  0x8001		-HALF_MIN		0x7ffe
+ *  0x8002		-2 * HALF_MIN		0x7ffd
+ *	  ...					  ...
+ *  0xfbfd					0x0f02
+ *  0xfbfe					0x0401
+ *  0xfbff		-HALF_MAX		0x0400
+ *  0xfc00		-infinity		0x8000
+ *  0xfc01		NAN			0x8000
+ *	  ...					  ...
+ *  0xfffe		NAN			0x8000
+ *  0xffff		NAN			0x8000
+ */
+static int
+pack (const uint16_t s[16], uint8_t b[14], int flatfields, int exactmax)
+{
+    int      d[16];
+    int      r[15];
+    int      rMin;
+    int      rMax;
+    uint16_t t[16];
+    uint16_t tMax;
+    int      shift = -1;
+
+    const int bias = 0x20;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        if ((s[i] & 0x7c00) == 0x7c00)
+            t[i] = 0x8000;
+        else if (s[i] & 0x8000)
+            t[i] = ~s[i];
+        else
+            t[i] = s[i] | 0x8000;
+    }
+
+    // find max
+    tMax = 0;
+    for (int i = 0; i < 16; ++i)
+        if (tMax < t[i]) tMax = t[i];
+
+    //
+    // Compute a set of running differences, r[0] ... r[14]:
+    // Find a shift value such that after rounding off the
+    // rightmost bits and shifting all differences are between
+    // -32 and +31.  Then bias the differences so that they
+    // end up between 0 and 63.
+    //
+
+    do
+    {
+        shift += 1;
+
+        //
+        // Compute absolute differences, d[0] ... d[15],
+        // between tMax and t[0] ... t[15].
+        //
+        // Shift and round the absolute differences.
+        //
+
+        for (int i = 0; i < 16; ++i)
+            d[i] = shiftAndRound (tMax - t[i], shift);
+
+        //
+        // Convert d[0] .. d[15] into running differences
+        //
+
+        r[0] = d[0] - d[4] + bias;
+        r[1] = d[4] - d[8] + bias;
+        r[2] = d[8] - d[12] + bias;
+
+        r[3] = d[0] - d[1] + bias;
+        r[4] = d[4] - d[5] + bias;
+        r[5] = d[8] - d[9] + bias;
+        r[6] = d[12] - d[13] + bias;
+
+        r[7]  = d[1] - d[2] + bias;
+        r[8]  = d[5] - d[6] + bias;
+        r[9]  = d[9] - d[10] + bias;
+        r[10] = d[13] - d[14] + bias;
+
+        r[11] = d[2] - d[3] + bias;
+        r[12] = d[6] - d[7] + bias;
+        r[13] = d[10] - d[11] + bias;
+        r[14] = d[14] - d[15] + bias;
+
+        rMin = r[0];
+        rMax = r[0];
+
+        for (int i = 1; i < 15; ++i)
+        {
+            if (rMin > r[i]) rMin = r[i];
+
+            if (rMax < r[i]) rMax = r[i];
+        }
+    } while (rMin < 0 || rMax > 0x3f);
+
+    if (rMin == bias && rMax == bias && flatfields)
+    {
+        //
+        // Special case - all pixels have the same value.
+        // We encode this in 3 instead of 14 bytes by
+        // storing the value 0xfc in the third output byte,
+        // which cannot occur in the 14-byte encoding.
+        //
+
+        b[0] = (uint8_t) (t[0] >> 8);
+        b[1] = (uint8_t) t[0];
+        b[2] = 0xfc;
+
+        return 3;
+    }
+
+    if (exactmax)
+    {
+        //
+        // Adjust t[0] so that the pixel whose value is equal
+        // to tMax gets represented as accurately as possible.
+        //
+
+        t[0] = tMax - (uint16_t) (d[0] << shift);
+    }
+
+    //
+    // Pack t[0], shift and r[0] ... r[14] into 14 bytes:
+    //
+
+    b[0]  = (uint8_t) (t[0] >> 8);
+    b[1]  = (uint8_t) t[0];
+    b[2]  = (uint8_t) ((shift << 2) | (r[0] >> 4));
+    b[3]  = (uint8_t) ((r[0] << 4) | (r[1] >> 2));
+    b[4]  = (uint8_t) ((r[1] << 6) | r[2]);
+    b[5]  = (uint8_t) ((r[3] << 2) | (r[4] >> 4));
+    b[6]  = (uint8_t) ((r[4] << 4) | (r[5] >> 2));
+    b[7]  = (uint8_t) ((r[5] << 6) | r[6]);
+    b[8]  = (uint8_t) ((r[7] << 2) | (r[8] >> 4));
+    b[9]  = (uint8_t) ((r[8] << 4) | (r[9] >> 2));
+    b[10] = (uint8_t) ((r[9] << 6) | r[10]);
+    b[11] = (uint8_t) ((r[11] << 2) | (r[12] >> 4));
+    b[12] = (uint8_t) ((r[12] << 4) | (r[13] >> 2));
+    b[13] = (uint8_t) ((r[13] << 6) | r[14]);
+
+    return 14;
+}
+
+/**************************************/
+
+static inline void
+unpack14 (const uint8_t b[14], uint16_t s[16])
+{
+    uint16_t shift, bias;
+    s[0] = ((uint16_t) (b[0] << 8)) | ((uint16_t) b[1]);
+
+    shift = (b[2] >> 2);
+    bias  = (uint16_t) (0x20u << shift);
+
+    s[4]  = (uint16_t) ((uint32_t) s[0] +
+                       (uint32_t) ((((uint32_t) (b[2] << 4) |
+                                     (uint32_t) (b[3] >> 4)) &
+                                    0x3fu)
+                                   << shift) -
+                       bias);
+    s[8]  = (uint16_t) ((uint32_t) s[4] +
+                       (uint32_t) ((((uint32_t) (b[3] << 2) |
+                                     (uint32_t) (b[4] >> 6)) &
+                                    0x3fu)
+                                   << shift) -
+                       bias);
+    s[12] = (uint16_t) ((uint32_t) s[8] +
+                        (uint32_t) ((uint32_t) (b[4] & 0x3fu) << shift) - bias);
+
+    s[1]  = (uint16_t) ((uint32_t) s[0] +
+                       (uint32_t) ((uint32_t) (b[5] >> 2) << shift) - bias);
+    s[5]  = (uint16_t) ((uint32_t) s[4] +
+                       (uint32_t) ((((uint32_t) (b[5] << 4) |
+                                     (uint32_t) (b[6] >> 4)) &
+                                    0x3fu)
+                                   << shift) -
+                       bias);
+    s[9]  = (uint16_t) ((uint32_t) s[8] +
+                       (uint32_t) ((((uint32_t) (b[6] << 2) |
+                                     (uint32_t) (b[7] >> 6)) &
+                                    0x3fu)
+                                   << shift) -
+                       bias);
+    s[13] = (uint16_t) ((uint32_t) s[12] +
+                        (uint32_t) ((uint32_t) (b[7] & 0x3fu) << shift) - bias);
+
+    s[2]  = (uint16_t) ((uint32_t) s[1] +
+                       (uint32_t) ((uint32_t) (b[8] >> 2) << shift) - bias);
+    s[6]  = (uint16_t) ((uint32_t) s[5] +
+                       (uint32_t) ((((uint32_t) (b[8] << 4) |
+                                     (uint32_t) (b[9] >> 4)) &
+                                    0x3fu)
+                                   << shift) -
+                       bias);
+    s[10] = (uint16_t) ((uint32_t) s[9] +
+                        (uint32_t) ((((uint32_t) (b[9] << 2) |
+                                      (uint32_t) (b[10] >> 6)) &
+                                     0x3fu)
+                                    << shift) -
+                        bias);
+    s[14] =
+        (uint16_t) ((uint32_t) s[13] +
+                    (uint32_t) ((uint32_t) (b[10] & 0x3fu) << shift) - bias);
+
+    s[3]  = (uint16_t) ((uint32_t) s[2] +
+                       (uint32_t) ((uint32_t) (b[11] >> 2) << shift) - bias);
+    s[7]  = (uint16_t) ((uint32_t) s[6] +
+                       (uint32_t) ((((uint32_t) (b[11] << 4) |
+                                     (uint32_t) (b[12] >> 4)) &
+                                    0x3fu)
+                                   << shift) -
+                       bias);
+    s[11] = (uint16_t) ((uint32_t) s[10] +
+                        (uint32_t) ((((uint32_t) (b[12] << 2) |
+                                      (uint32_t) (b[13] >> 6)) &
+                                     0x3fu)
+                                    << shift) -
+                        bias);
+    s[15] =
+        (uint16_t) ((uint32_t) s[14] +
+                    (uint32_t) ((uint32_t) (b[13] & 0x3fu) << shift) - bias);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        if (s[i] & 0x8000)
+            s[i] &= 0x7fff;
+        else
+            s[i] = ~s[i];
+    }
+}
+
+static inline void
+unpack3 (const uint8_t b[3], uint16_t s[16])
+{
+    s[0] = ((uint16_t) (b[0] << 8)) | ((uint16_t) b[1]);
+
+    if (s[0] & 0x8000)
+        s[0] &= 0x7fff;
+    else
+        s[0] = ~s[0];
+
+    for (int i = 1; i < 16; ++i)
+        s[i] = s[0];
+}
+
+/**************************************/
+
+/*
+ * The 4x4 blocks of a channel are coded one strip of 4 scanlines at a
+ * time. The rows of a strip are row0 + k * nx, nrows of which are
+ * valid. When encoding, rows[] already repeats the bottom row for
+ * strips that are not 4 lines high.
+ */
+
+typedef exr_result_t (*b44_pack_strip_fn) (
+    const uint16_t* const rows[4],
+    int                   nx,
+    int                   flatfields,
+    int                   p_linear,
+    uint8_t*              out,
+    uint64_t              avail,
+    uint64_t*             nOut);
+
+typedef exr_result_t (*b44_unpack_strip_fn) (
+    const uint8_t* in,
+    uint64_t       avail,
+    uint64_t*      nIn,
+    uint16_t*      row0,
+    int            nx,
+    int            nrows,
+    int            p_linear);
+
+static inline void
+gatherBlock (const uint16_t* const rows[4], int x, int nx, uint16_t s[16])
+{
+    //
+    // Copy the next 4x4 pixel block into array s. If the width
+    // is not divisible by 4, pad the data by repeating the
+    // rightmost column.
+    //
+    if (x + 3 >= nx)
+    {
+        int n = nx - x;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            int j = i;
+            if (j > n - 1) j = n - 1;
+
+            s[i + 0]  = rows[0][x + j];
+            s[i + 4]  = rows[1][x + j];
+            s[i + 8]  = rows[2][x + j];
+            s[i + 12] = rows[3][x + j];
+        }
+    }
+    else
+    {
+        memcpy (&s[0], rows[0] + x, 4 * sizeof (uint16_t));
+        memcpy (&s[4], rows[1] + x, 4 * sizeof (uint16_t));
+        memcpy (&s[8], rows[2] + x, 4 * sizeof (uint16_t));
+        memcpy (&s[12], rows[3] + x, 4 * sizeof (uint16_t));
+    }
+}
+
+static inline void
+scatterBlock (uint16_t s[16], uint16_t* row0, int x, int nx, int nrows)
+{
+    uint64_t n = (x + 3 < nx) ? 4 * sizeof (uint16_t)
+                              : (uint64_t) (nx - x) * sizeof (uint16_t);
+
+    priv_from_native16 (s, 16);
+
+    row0 += x;
+    memcpy (row0, &s[0], n);
+    if (nrows > 1) memcpy (row0 + nx, &s[4], n);
+    if (nrows > 2) memcpy (row0 + 2 * nx, &s[8], n);
+    if (nrows > 3) memcpy (row0 + 3 * nx, &s[12], n);
+}
+
+static exr_result_t
+pack_strip_scalar (
+    const uint16_t* const rows[4],
+    int                   nx,
+    int                   flatfields,
+    int                   p_linear,
+    uint8_t*              out,
+    uint64_t              avail,
+    uint64_t*             nOut)
+{
+    uint64_t used = 0;
+    uint16_t s[16];
+
+    for (int x = 0; x < nx; x += 4)
+    {
+        gatherBlock (rows, x, nx, s);
+
+        if (p_linear) convertFromLinear (s);
+
+        used += (uint64_t) pack (s, out + used, flatfields, !p_linear);
+        if (used + 14 > avail)
+        {
+            *nOut = used;
+            return EXR_ERR_OUT_OF_MEMORY;
+        }
+    }
+    *nOut = used;
+    return EXR_ERR_SUCCESS;
+}
+
+static exr_result_t
+unpack_strip_scalar (
+    const uint8_t* in,
+    uint64_t       avail,
+    uint64_t*      nIn,
+    uint16_t*      row0,
+    int            nx,
+    int            nrows,
+    int            p_linear)
+{
+    uint64_t used = 0;
+    uint16_t s[16];
+
+    for (int x = 0; x < nx; x += 4)
+    {
+        if (used + 3 > avail) return EXR_ERR_OUT_OF_MEMORY;
+
+        /* check if 3-byte encoded flat field */
+        if (in[used + 2] >= (13 << 2))
+        {
+            unpack3 (in + used, s);
+            used += 3;
+        }
+        else
+        {
+            if (used + 14 > avail) return EXR_ERR_OUT_OF_MEMORY;
+            unpack14 (in + used, s);
+            used += 14;
+        }
+
+        if (p_linear) convertToLinear (s);
+
+        scatterBlock (s, row0, x, nx, nrows);
+    }
+    *nIn = used;
+    return EXR_ERR_SUCCESS;
+}
+
+#ifdef B44_HAVE_AVX2_TARGET
+
+/*
+ * The AVX2 kernels hold a block as two vectors of 32-bit lanes, rows
+ * 0 and 1 in the first and rows 2 and 3 in the second, so each
+ * 128-bit lane is one row of the block. The 14-byte encoding stores
+ * the 6-bit fields column by column, 3 bytes (4 fields) per column:
+ * shift and the 3 vertical differences of column 0, then the 4
+ * horizontal differences of each of columns 1 to 3. The math is the
+ * same integer math as pack / unpack14, so output is bit-identical.
+ */
+
+/* look up 16 table entries with 32-bit gathers that never read past
+ * the end of the table: fetch the aligned pair holding each entry and
+ * pick the half */
+__attribute__ ((target ("avx2"))) static inline __m256i
+lookupTable_avx2 (const uint16_t* table, __m256i idx)
+{
+    __m256i pairs = _mm256_i32gather_epi32 (
+        (const int*) table, _mm256_srli_epi32 (idx, 1), 4);
+    __m256i half = _mm256_slli_epi32 (
+        _mm256_and_si256 (idx, _mm256_set1_epi32 (1)), 4);
+
+    return _mm256_and_si256 (
+        _mm256_srlv_epi32 (pairs, half), _mm256_set1_epi32 (0xffff));
+}
+
+__attribute__ ((target ("avx2"))) static inline int
+pack_avx2 (const uint16_t s[16], uint8_t b[14], int flatfields, int p_linear)
+{
+    const __m256i lo16  = _mm256_set1_epi32 (0xffff);
+    const __m256i sign  = _mm256_set1_epi32 (0x8000);
+    const __m256i one   = _mm256_set1_epi32 (1);
+    const __m256i bias  = _mm256_set1_epi32 (0x20);
+    const __m256i range = _mm256_set1_epi32 (~0x3f);
+    const __m256i expo  = _mm256_set1_epi32 (0x7c00);
+
+    __m256i s01 = _mm256_cvtepu16_epi32 (_mm_loadu_si128 ((const __m128i*) s));
+    __m256i s23 =
+        _mm256_cvtepu16_epi32 (_mm_loadu_si128 ((const __m128i*) (s + 8)));
+    __m256i  t01, t23, tMax, x01, x23, d01, d23, r01, r23;
+    __m128i  fields;
+    int      shift = -1;
+    uint16_t t0;
+    uint8_t  tmp[16];
+
+    if (p_linear)
+    {
+        s01 = lookupTable_avx2 (exrcore_expTable, s01);
+        s23 = lookupTable_avx2 (exrcore_expTable, s23);
+    }
+
+    //
+    // map to the ordered magnitude t, NaN and infinity going to 0x8000
+    //
+    t01 = _mm256_blendv_epi8 (
+        _mm256_or_si256 (s01, sign),
+        _mm256_xor_si256 (s01, lo16),
+        _mm256_cmpgt_epi32 (s01, _mm256_set1_epi32 (0x7fff)));
+    t01 = _mm256_blendv_epi8 (
+        t01,
+        sign,
+        _mm256_cmpeq_epi32 (_mm256_and_si256 (s01, expo), expo));
+    t23 = _mm256_blendv_epi8 (
+        _mm256_or_si256 (s23, sign),
+        _mm256_xor_si256 (s23, lo16),
+        _mm256_cmpgt_epi32 (s23, _mm256_set1_epi32 (0x7fff)));
+    t23 = _mm256_blendv_epi8 (
+        t23,
+        sign,
+        _mm256_cmpeq_epi32 (_mm256_and_si256 (s23, expo), expo));
+
+    tMax = _mm256_max_epi32 (t01, t23);
+    tMax = _mm256_max_epi32 (tMax, _mm256_permute2x128_si256 (tMax, tMax, 1));
+    tMax = _mm256_max_epi32 (tMax, _mm256_shuffle_epi32 (tMax, 0x4e));
+    tMax = _mm256_max_epi32 (tMax, _mm256_shuffle_epi32 (tMax, 0xb1));
+
+    x01 = _mm256_slli_epi32 (_mm256_sub_epi32 (tMax, t01), 1);
+    x23 = _mm256_slli_epi32 (_mm256_sub_epi32 (tMax, t23), 1);
+
+    do
+    {
+        __m128i cnt;
+        __m256i a;
+
+        shift += 1;
+
+        // shiftAndRound (tMax - t[i], shift)
+        cnt = _mm_cvtsi32_si128 (shift + 1);
+        a   = _mm256_set1_epi32 ((1 << shift) - 1);
+        d01 = _mm256_srl_epi32 (
+            _mm256_add_epi32 (
+                _mm256_add_epi32 (x01, a),
+                _mm256_and_si256 (_mm256_srl_epi32 (x01, cnt), one)),
+            cnt);
+        d23 = _mm256_srl_epi32 (
+            _mm256_add_epi32 (
+                _mm256_add_epi32 (x23, a),
+                _mm256_and_si256 (_mm256_srl_epi32 (x23, cnt), one)),
+            cnt);
+
+        // running differences: from the left neighbour in columns
+        // 1 to 3, from the row above in column 0. The slot of d[0]
+        // gets the bias, which is neutral for the range and flat
+        // field checks
+        r01 = _mm256_blend_epi32 (
+            _mm256_sub_epi32 (_mm256_slli_si256 (d01, 4), d01),
+            _mm256_sub_epi32 (
+                _mm256_permute2x128_si256 (d01, d01, 0x08), d01),
+            0x11);
+        r23 = _mm256_blend_epi32 (
+            _mm256_sub_epi32 (_mm256_slli_si256 (d23, 4), d23),
+            _mm256_sub_epi32 (
+                _mm256_permute2x128_si256 (d01, d23, 0x21), d23),
+            0x11);
+        r01 = _mm256_blend_epi32 (_mm256_add_epi32 (r01, bias), bias, 0x01);
+        r23 = _mm256_add_epi32 (r23, bias);
+    } while (!_mm256_testz_si256 (_mm256_or_si256 (r01, r23), range));
+
+    t0 = (uint16_t) _mm256_cvtsi256_si32 (t01);
+
+    if (flatfields &&
+        _mm256_movemask_epi8 (_mm256_and_si256 (
+            _mm256_cmpeq_epi32 (r01, bias), _mm256_cmpeq_epi32 (r23, bias))) ==
+            -1)
+    {
+        b[0] = (uint8_t) (t0 >> 8);
+        b[1] = (uint8_t) t0;
+        b[2] = 0xfc;
+
+        return 3;
+    }
+
+    if (!p_linear)
+    {
+        t0 = (uint16_t) (_mm256_cvtsi256_si32 (tMax) -
+                         (_mm256_cvtsi256_si32 (d01) << shift));
+    }
+
+    //
+    // shift takes the slot of d[0]; then pack each column to 3 bytes
+    //
+    r01 = _mm256_blend_epi32 (r01, _mm256_set1_epi32 (shift), 0x01);
+    r01 = _mm256_or_si256 (
+        _mm256_sllv_epi32 (
+            r01, _mm256_setr_epi32 (18, 18, 18, 18, 12, 12, 12, 12)),
+        _mm256_sllv_epi32 (r23, _mm256_setr_epi32 (6, 6, 6, 6, 0, 0, 0, 0)));
+    fields = _mm_or_si128 (
+        _mm256_castsi256_si128 (r01), _mm256_extracti128_si256 (r01, 1));
+    fields = _mm_shuffle_epi8 (
+        fields,
+        _mm_setr_epi8 (-1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1));
+    fields =
+        _mm_insert_epi16 (fields, (uint16_t) ((t0 >> 8) | (t0 << 8)), 0);
+
+    _mm_storeu_si128 ((__m128i*) tmp, fields);
+    memcpy (b, tmp, 14);
+    return 14;
+}
+
+__attribute__ ((target ("avx2"))) static inline void
+unpack14_avx2 (const uint8_t b[16], uint16_t s[16], int p_linear)
+{
+    const __m256i m63   = _mm256_set1_epi32 (0x3f);
+    const __m256i lo16  = _mm256_set1_epi32 (0xffff);
+    const __m256i low15 = _mm256_set1_epi32 (0x7fff);
+    const __m256i sign  = _mm256_set1_epi32 (0x8000);
+    const __m256i bytes =
+        _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i*) b));
+
+    int     shift = b[2] >> 2;
+    __m128i cnt   = _mm_cvtsi32_si128 (shift);
+    __m256i bias  = _mm256_set1_epi32 (0x20 << shift);
+    __m256i cols, d01, d23, c01, c23, e01, e23;
+
+    // lane c holds the 24 bits of column c
+    cols = _mm256_shuffle_epi8 (
+        bytes,
+        _mm256_setr_epi8 (
+            4, 3, 2, -1, 7, 6, 5, -1, 10, 9, 8, -1, 13, 12, 11, -1,
+            4, 3, 2, -1, 7, 6, 5, -1, 10, 9, 8, -1, 13, 12, 11, -1));
+
+    d01 = _mm256_and_si256 (
+        _mm256_srlv_epi32 (
+            cols, _mm256_setr_epi32 (18, 18, 18, 18, 12, 12, 12, 12)),
+        m63);
+    d23 = _mm256_and_si256 (
+        _mm256_srlv_epi32 (cols, _mm256_setr_epi32 (6, 6, 6, 6, 0, 0, 0, 0)),
+        m63);
+    d01 = _mm256_sub_epi32 (_mm256_sll_epi32 (d01, cnt), bias);
+    d23 = _mm256_sub_epi32 (_mm256_sll_epi32 (d23, cnt), bias);
+    d01 = _mm256_blend_epi32 (
+        d01, _mm256_set1_epi32 ((b[0] << 8) | b[1]), 0x01);
+
+    //
+    // s[4r + c] is the sum of the column 0 differences of rows 0..r
+    // plus the differences of columns 1..c in row r: add up each row,
+    // then add the column 0 values of the rows above
+    //
+    c01 = _mm256_shuffle_epi32 (d01, 0);
+    c23 = _mm256_shuffle_epi32 (d23, 0);
+    e01 = _mm256_permute2x128_si256 (c01, c01, 0x08);
+    e23 = _mm256_add_epi32 (
+        _mm256_add_epi32 (
+            _mm256_permute2x128_si256 (c01, c01, 0x00),
+            _mm256_permute2x128_si256 (c01, c01, 0x11)),
+        _mm256_permute2x128_si256 (c23, c23, 0x08));
+
+    d01 = _mm256_add_epi32 (d01, _mm256_slli_si256 (d01, 4));
+    d01 = _mm256_add_epi32 (d01, _mm256_slli_si256 (d01, 8));
+    d01 = _mm256_and_si256 (_mm256_add_epi32 (d01, e01), lo16);
+    d23 = _mm256_add_epi32 (d23, _mm256_slli_si256 (d23, 4));
+    d23 = _mm256_add_epi32 (d23, _mm256_slli_si256 (d23, 8));
+    d23 = _mm256_and_si256 (_mm256_add_epi32 (d23, e23), lo16);
+
+    // back from the ordered magnitude: flip the sign bit of positive
+    // values, all bits of negative ones
+    d01 = _mm256_xor_si256 (
+        d01,
+        _mm256_or_si256 (
+            _mm256_andnot_si256 (
+                _mm256_srai_epi32 (_mm256_slli_epi32 (d01, 16), 31), low15),
+            sign));
+    d23 = _mm256_xor_si256 (
+        d23,
+        _mm256_or_si256 (
+            _mm256_andnot_si256 (
+                _mm256_srai_epi32 (_mm256_slli_epi32 (d23, 16), 31), low15),
+            sign));
+
+    if (p_linear)
+    {
+        d01 = lookupTable_avx2 (exrcore_logTable, d01);
+        d23 = lookupTable_avx2 (exrcore_logTable, d23);
+    }
+
+    _mm256_storeu_si256 (
+        (__m256i*) s,
+        _mm256_permute4x64_epi64 (_mm256_packus_epi32 (d01, d23), 0xd8));
+}
+
+__attribute__ ((target ("avx2"))) static exr_result_t
+pack_strip_avx2 (
+    const uint16_t* const rows[4],
+    int                   nx,
+    int                   flatfields,
+    int                   p_linear,
+    uint8_t*              out,
+    uint64_t              avail,
+    uint64_t*             nOut)
+{
+    uint64_t used = 0;
+    uint16_t s[16];
+
+    for (int x = 0; x < nx; x += 4)
+    {
+        gatherBlock (rows, x, nx, s);
+
+        used += (uint64_t) pack_avx2 (s, out + used, flatfields, p_linear);
+        if (used + 14 > avail)
+        {
+            *nOut = used;
+            return EXR_ERR_OUT_OF_MEMORY;
+        }
+    }
+    *nOut = used;
+    return EXR_ERR_SUCCESS;
+}
+
+__attribute__ ((target ("avx2"))) static exr_result_t
+unpack_strip_avx2 (
+    const uint8_t* in,
+    uint64_t       avail,
+    uint64_t*      nIn,
+    uint16_t*      row0,
+    int            nx,
+    int            nrows,
+    int            p_linear)
+{
+    uint64_t used = 0;
+    uint16_t s[16];
+
+    for (int x = 0; x < nx; x += 4)
+    {
+        if (used + 3 > avail) return EXR_ERR_OUT_OF_MEMORY;
+
+        if (in[used + 2] >= (13 << 2))
+        {
+            unpack3 (in + used, s);
+            used += 3;
+            if (p_linear) convertToLinear (s);
+        }
+        else if (used + 16 <= avail)
+        {
+            // the kernel loads 16 bytes
+            unpack14_avx2 (in + used, s, p_linear);
+            used += 14;
+        }
+        else
+        {
+            if (used + 14 > avail) return EXR_ERR_OUT_OF_MEMORY;
+            unpack14 (in + used, s);
+            used += 14;
+            if (p_linear) convertToLinear (s);
+        }
+
+        scatterBlock (s, row0, x, nx, nrows);
+    }
+    *nIn = used;
+    return EXR_ERR_SUCCESS;
+}
+
+#endif /* B44_HAVE_AVX2_TARGET */
+
+#endif /* OPENEXR_PRIVATE_B44_KERNELS_H */
@@ -0,0 +1,68 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#ifndef OPENEXR_PRIVATE_BUFFER_POOL_H
+#define OPENEXR_PRIVATE_BUFFER_POOL_H
+
+#include "internal_structs.h"
+
+/* default cap on the bytes retained by the pool embedded in each
+ * context. The pool only ever holds buffers (and zlib states) which
+ * were previously in use, so this bounds how much of the peak working
+ * set is kept around between pipelines. It is kept small since every
+ * open context has one: applications holding many files open should
+ * share a single pool between them instead */
+#define EXR_DEFAULT_BUFFER_POOL_BYTES ((size_t) 8 * 1024 * 1024)
+
+exr_result_t internal_exr_buffer_pool_init (
+    struct _priv_exr_buffer_pool_t* pool,
+    exr_memory_allocation_func_t    alloc_fn,
+    exr_memory_free_func_t          free_fn,
+    size_t                          max_bytes);
+
+/** Releases all the cached memory, and any synchronization
+ * primitives, but not the pool itself */
+void internal_exr_buffer_pool_destroy (struct _priv_exr_buffer_pool_t* pool);
+
+/** Returns a buffer of at least @p bytes, either re-using a previously
+ * released buffer, or allocating a new one. The usable size of the
+ * buffer (which may be larger than requested, due to size class
+ * rounding) is returned in @p actual. Returns NULL on allocation
+ * failure */
+void* internal_exr_buffer_pool_acquire (
+    struct _priv_exr_buffer_pool_t* pool, size_t bytes, size_t* actual);
+
+/** Gives a buffer of @p bytes (as returned in actual from acquire, or
+ * any buffer allocated with the pool allocator) back to the pool,
+ * freeing it if the pool is full */
+void internal_exr_buffer_pool_release (
+    struct _priv_exr_buffer_pool_t* pool, void* ptr, size_t bytes);
+
+/** Frees cached buffers, then cached compressor states, until at
+ * most @p keep_bytes remain cached */
+void internal_exr_buffer_pool_trim (
+    struct _priv_exr_buffer_pool_t* pool, size_t keep_bytes);
+
+/** Returns an idle compressor previously created for @p level, or
+ * NULL if the pool has none */
+struct libdeflate_compressor* internal_exr_buffer_pool_take_compressor (
+    struct _priv_exr_buffer_pool_t* pool, int level);
+
+/** Keeps @p comp for a later take, or frees it if the pool does not
+ * retain memory or is full */
+void internal_exr_buffer_pool_give_compressor (
+    struct _priv_exr_buffer_pool_t* pool,
+    struct libdeflate_compressor*   comp,
+    int                             level);
+
+struct libdeflate_decompressor*
+internal_exr_buffer_pool_take_decompressor (
+    struct _priv_exr_buffer_pool_t* pool);
+
+void internal_exr_buffer_pool_give_decompressor (
+    struct _priv_exr_buffer_pool_t* pool,
+    struct libdeflate_decompressor* decomp);
+
+#endif /* OPENEXR_PRIVATE_BUFFER_POOL_H */
@@ -125,6 +125,47 @@ check_for_x86_simd (int* f16c, int* avx, int* sse2)
 #endif
 }
 
+static inline int
+has_avx2 (void)
+{
+#ifdef __e2k__
+#    if defined(__AVX2__)
+    return 1;
+#    else
+    return 0;
+#    endif
+
+#elif defined(__AVX2__)
+    return 1;
+
+#elif OPENEXR_ENABLE_X86_SIMD_CHECK
+    int sse2, avx, f16c;
+
+    /* this also checks the OS saves the ymm registers */
+    check_for_x86_simd (&f16c, &avx, &sse2);
+    if (!avx) return 0;
+
+#    if defined(_WIN32)
+    int regs[4] = {0};
+
+    __cpuid (regs, 0);
+    if (regs[0] < 7) return 0;
+    __cpuidex (regs, 7, 0);
+#    else
+    unsigned int regs[4] = {0};
+
+    if (__get_cpuid_max (0, NULL) < 7) return 0;
+    __cpuid_count (7, 0, regs[0], regs[1], regs[2], regs[3]);
+#    endif
+
+    /* AVX2 is indicated by bit 5 of EBX (reg 1), leaf 7 */
+    return (regs[1] & (1 << 5)) ? 1 : 0;
+
+#else
+    return 0;
+#endif
+}
+
 static inline int
 has_native_half (void)
 {
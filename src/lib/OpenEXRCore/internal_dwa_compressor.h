@@ -559,9 +559,9 @@ DwaCompressor_compress (DwaCompressor* me)
                         memcpy (
                             me->_encode->compressed_buffer,
                             me->_encode->packed_buffer,
-                            me->_encode->packed_alloc_size);
+                            me->_encode->packed_bytes);
                         me->_encode->compressed_bytes =
-                            me->_encode->packed_alloc_size;
+                            me->_encode->packed_bytes;
                         return EXR_ERR_SUCCESS;
                     }
                     return rv;
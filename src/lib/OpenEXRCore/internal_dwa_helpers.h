@@ -58,6 +58,7 @@ std_max (size_t a, size_t b)
 }
 
 #include "internal_dwa_simd.h"
+#include "internal_dwa_quantize.h"
 #include "internal_dwa_channeldata.h"
 #include "internal_dwa_classifier.h"
 #include "internal_dwa_decoder.h"
@@ -0,0 +1,811 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef IMF_INTERNAL_DWA_HELPERS_H_HAS_BEEN_INCLUDED
+#    error "only include internal_dwa_helpers.h"
+#endif
+
+//
+// Quantization of the forward DCT coefficients for the lossy DCT
+// encoder. This is kept apart from the rest of the encoder, so the
+// vectorized version can be checked against the scalar one.
+//
+
+#ifdef _WIN32
+#    include <intrin.h>
+#elif defined(__x86_64__)
+#    include <x86intrin.h>
+#endif
+
+#if defined(__has_builtin)
+#    if __has_builtin(__builtin_popcount)
+#        define USE_POPCOUNT 1
+#    endif
+#    if __has_builtin(__builtin_clz)
+#        define USE_CLZ 1
+#    endif
+#endif
+#ifndef USE_POPCOUNT
+#    define USE_POPCOUNT 0
+#endif
+
+#ifndef USE_CLZ
+#    ifdef _MSC_VER
+static int __inline __builtin_clz(uint32_t v)
+{
+#ifdef __BMI1__
+    return __lzcnt(v);
+#else
+    unsigned long r;
+    _BitScanReverse(&r, v);
+    return 31 - r;
+#endif
+}
+#        define USE_CLZ 1
+#    else
+#        define USE_CLZ 0
+#    endif
+#endif
+
+//
+// Precomputing the bit count runs faster than using
+// the builtin instruction, at least in one case..
+//
+// Precomputing 8-bits is no slower than 16-bits,
+// and saves a fair bit of overhead..
+//
+
+#if USE_POPCOUNT
+static inline int
+countSetBits (uint16_t src)
+{
+    return __builtin_popcount (src);
+}
+#else
+// courtesy hacker's delight
+static inline int countSetBits(uint32_t x)
+{
+    uint64_t y;
+    y = x * 0x0002000400080010ULL;
+    y = y & 0x1111111111111111ULL;
+    y = y * 0x1111111111111111ULL;
+    y = y >> 60;
+    return y;
+}
+#endif
+
+#if USE_CLZ
+static inline int
+countLeadingZeros(uint16_t src)
+{
+    return __builtin_clz (src);
+}
+#else
+// courtesy hacker's delight
+static int inline countLeadingZeros( uint32_t x )
+{
+    x |= (x >> 1);
+    x |= (x >> 2);
+    x |= (x >> 4);
+    x |= (x >> 8);
+    x |= (x >> 16);
+    return 32 - countSetBits(x);
+}
+#endif
+
+//
+// Take a DCT coefficient, as well as an acceptable error. Search
+// nearby values within the error tolerance, that have fewer
+// bits set.
+//
+// -ffast-math -funsafe-math-optimizations (gcc), fast-math more aggressive
+//
+// clang -ffp-model=fast (~same as unsafe-math-opts)
+//                  aggressive (~-ffast-math)
+// -fno-math-errno
+// -f[no-]honor-nans, honor-infinities
+// -ffp-contract=[on|off|fast]
+// -f[no-]associative-math <- can really help with vectorization
+// -f[no-]reciprocal-math
+//
+// #pragma float_control(push|pop)
+// #pragma float_control(precise, on|off)
+// #pragma clang fp reassociate(on|off)
+// #pragma clang fp reciprocal(on|off)
+// #pragma STDC_FP_CONTRACT ON|OFF|DEFAULT
+//
+
+#define TEST_QUANT_ALTERNATE_LARGE(x)                                   \
+    alt = (x);                                                          \
+    bits = countSetBits (alt);                                          \
+    if (bits < smallbits)                                               \
+    {                                                                   \
+        delta = half_to_float ((uint16_t)alt) - srcFloat;               \
+        if (delta < errTol)                                             \
+        {                                                               \
+            smallbits = bits; smalldelta = delta; smallest = alt;       \
+        }                                                               \
+    }                                                                   \
+    else if (bits == smallbits)                                         \
+    {                                                                   \
+        delta = half_to_float ((uint16_t)alt) - srcFloat;               \
+        if (delta < smalldelta)                                         \
+        {                                                               \
+            smallest = alt;                                             \
+            smalldelta = delta;                                         \
+            smallbits = bits;                                           \
+        }                                                               \
+    }
+
+#define TEST_QUANT_ALTERNATE_SMALL(x)                                   \
+    alt = (x);                                                          \
+    bits = countSetBits (alt);                                          \
+    if (bits < smallbits)                                               \
+    {                                                                   \
+        delta = srcFloat - half_to_float ((uint16_t)alt);               \
+        if (delta < errTol)                                             \
+        {                                                               \
+            smallbits = bits; smalldelta = delta; smallest = alt;       \
+        }                                                               \
+    }                                                                   \
+    else if (bits == smallbits)                                         \
+    {                                                                   \
+        delta = srcFloat - half_to_float ((uint16_t)alt);               \
+        if (delta < smalldelta)                                         \
+        {                                                               \
+            smallest = alt;                                             \
+            smalldelta = delta;                                         \
+            smallbits = bits;                                           \
+        }                                                               \
+    }
+
+static uint32_t handleQuantizeDenormTol (
+    uint32_t abssrc, uint32_t tolSig, float errTol, float srcFloat)
+{
+    const uint32_t tsigshift = (32 - countLeadingZeros (tolSig));
+    const uint32_t npow2 = (1 << tsigshift);
+    const uint32_t lowermask = npow2 - 1;
+    const uint32_t mask = ~lowermask;
+    const uint32_t mask2 = mask ^ npow2;
+
+    uint32_t alt, smallest = abssrc;
+    int bits, smallbits = countSetBits(abssrc);
+    float delta, smalldelta = errTol;
+
+    TEST_QUANT_ALTERNATE_SMALL(abssrc & mask2);
+    TEST_QUANT_ALTERNATE_SMALL(abssrc & mask);
+    TEST_QUANT_ALTERNATE_LARGE((abssrc + npow2) & mask);
+    TEST_QUANT_ALTERNATE_LARGE((abssrc + (npow2 << 1)) & mask);
+
+    return smallest;
+}
+
+static uint32_t handleQuantizeGeneric (
+    uint32_t abssrc, uint32_t tolSig, float errTol, float srcFloat)
+{
+    // classic would do clz(significand - 1) but here we are trying to
+    // construct a mask, so want to ensure for an power of 2, we
+    // actually get the next (i.e. 2 returns 4)
+    const uint32_t tsigshift = (32 - countLeadingZeros (tolSig));
+    const uint32_t npow2 = (1 << tsigshift);
+    const uint32_t lowermask = npow2 - 1;
+    const uint32_t mask = ~lowermask;
+    const uint32_t mask2 = mask ^ npow2;
+    const uint32_t srcMaskedVal = abssrc & lowermask;
+    const uint32_t extrabit = (tolSig > srcMaskedVal);
+
+    const uint32_t mask3 = mask2 ^ (((npow2 << 1) * (extrabit)) |
+                                    ((npow2 >> 1) * (!extrabit)));
+
+    uint32_t alt, smallest = abssrc;
+    int bits, smallbits = countSetBits(abssrc);
+    float delta, smalldelta = errTol;
+
+    if (extrabit)
+    {
+        TEST_QUANT_ALTERNATE_SMALL(abssrc & mask3);
+        TEST_QUANT_ALTERNATE_SMALL(abssrc & mask2);
+
+        TEST_QUANT_ALTERNATE_SMALL(abssrc & mask);
+    }
+    else if ((abssrc & npow2) != 0)
+    {
+        TEST_QUANT_ALTERNATE_SMALL(abssrc & mask2);
+        TEST_QUANT_ALTERNATE_SMALL(abssrc & mask3);
+
+        TEST_QUANT_ALTERNATE_SMALL(abssrc & mask);
+    }
+    else
+    {
+        TEST_QUANT_ALTERNATE_SMALL(abssrc & mask2);
+
+        TEST_QUANT_ALTERNATE_SMALL(abssrc & mask);
+        TEST_QUANT_ALTERNATE_SMALL(abssrc & mask3);
+    }
+    TEST_QUANT_ALTERNATE_LARGE((abssrc + npow2) & mask);
+
+    return smallest;
+}
+
+// use same signature so we can get tail / sibling call optimisation
+// (can force with clang?), but notice we are sending in absolute src
+// value and the shifted tolerance significand instead
+static uint32_t handleQuantizeEqualExp (
+    uint32_t abssrc, uint32_t tolSig, float errTol, float srcFloat)
+{
+    const uint32_t npow2 = 0x0800;
+    const uint32_t lowermask = npow2 - 1;
+    const uint32_t mask = ~lowermask;
+    const uint32_t mask2 = mask ^ npow2;
+
+    const uint32_t srcMaskedVal = abssrc & lowermask;
+    const uint32_t extrabit = (tolSig > srcMaskedVal);
+
+    const uint32_t mask3 = mask2 ^ (((npow2 << 1) * (extrabit)) |
+                                    ((npow2 >> 1) * (!extrabit)));
+
+    // not yet clear how to narrow down below 3 values...
+    uint32_t alt, smallest = abssrc;
+    int bits, smallbits = countSetBits(abssrc);
+    float delta, smalldelta = errTol;
+
+    // doing in this order mask2, mask, +npow guarantees sorting of values
+    // so can avoid a couple of conditionals in the macros
+    if (srcMaskedVal == abssrc)
+    {
+        TEST_QUANT_ALTERNATE_SMALL(abssrc & mask3);
+    }
+    else
+    {
+        uint32_t alt0 = (abssrc & mask2);
+        uint32_t alt1 = (abssrc & mask);
+        if (alt0 == alt1) alt0 = (abssrc & mask3);
+
+        TEST_QUANT_ALTERNATE_SMALL(alt0);
+        TEST_QUANT_ALTERNATE_SMALL(alt1);
+    }
+    TEST_QUANT_ALTERNATE_LARGE((abssrc + npow2) & mask);
+
+    return smallest;
+}
+
+static uint32_t handleQuantizeCloseExp (
+    uint32_t abssrc, uint32_t tolSig, float errTol, float srcFloat)
+{
+    const uint32_t npow2 = 0x0400;
+    const uint32_t lowermask = npow2 - 1;
+    const uint32_t mask = ~lowermask;
+    const uint32_t mask2 = mask ^ npow2;
+
+    const uint32_t srcMaskedVal = abssrc & lowermask;
+    const uint32_t extrabit = (tolSig > srcMaskedVal);
+
+    const uint32_t mask3 = mask2 ^ (((npow2 << 1) * (extrabit)) |
+                                    ((npow2 >> 1) * (!extrabit)));
+
+    uint32_t alternates[3];
+
+    if ((abssrc & npow2) == 0) // by definition, src&mask2 == src&mask
+    {
+        if (extrabit)
+        {
+            alternates[0] = (abssrc & mask3);
+            alternates[1] = (abssrc & mask);
+        }
+        else
+        {
+            alternates[0] = (abssrc & mask);
+            alternates[1] = (abssrc & mask3);
+        }
+    }
+    else
+    {
+        if (extrabit)
+        {
+            alternates[0] = (abssrc & mask3);
+            alternates[1] = (abssrc & mask2);
+            float alt1delta = srcFloat - half_to_float ((uint16_t)alternates[1]);
+            if (alt1delta >= errTol)
+            {
+                alternates[1] = (abssrc & mask);
+            }
+        }
+        else
+        {
+            alternates[0] = (abssrc & mask2);
+            alternates[1] = (abssrc & mask3);
+            float alt0delta = srcFloat - half_to_float ((uint16_t)alternates[0]);
+            if (alt0delta >= errTol)
+                alternates[0] = (abssrc & mask);
+        }
+    }
+    alternates[2] = ((abssrc + npow2) & mask);
+
+    uint32_t alt, smallest = abssrc;
+    int bits, smallbits = countSetBits(abssrc);
+    float delta, smalldelta = errTol;
+
+    TEST_QUANT_ALTERNATE_SMALL(alternates[0]);
+    TEST_QUANT_ALTERNATE_SMALL(alternates[1]);
+    TEST_QUANT_ALTERNATE_LARGE(alternates[2]);
+
+    return smallest;
+}
+
+static inline uint32_t handleQuantizeLargerSig (
+    uint32_t abssrc, uint32_t npow2, uint32_t mask, float errTol, float srcFloat)
+{
+    // in this case, only need to test two scenarios:
+    //
+    // can't fully zero out the masked region, so go to "0.5" of that
+    // region and then test the rounded value...
+    const uint32_t mask2 = (mask ^ (npow2 | (npow2 >> 1)));
+
+    uint32_t alt0 = (abssrc & mask2);
+    uint32_t alt1 = ((abssrc + npow2) & mask);
+
+    int bits0 = countSetBits (alt0);
+    int bits1 = countSetBits (alt1);
+
+    float delta;
+
+    if (bits1 < bits0)
+    {
+        delta = half_to_float ((uint16_t)alt1) - srcFloat; // alt1 >= srcFloat
+        // bits1 < bits0 and if ok, just return
+        if (delta < errTol)
+            return alt1;
+        delta = srcFloat - half_to_float ((uint16_t)alt0); // alt0 <= srcFloat
+        if (delta < errTol)
+            return alt0;
+    }
+    else if (bits1 == bits0)
+    {
+        delta = srcFloat - half_to_float ((uint16_t)alt0);
+        float delta1 = half_to_float ((uint16_t)alt1) - srcFloat;
+        if (delta < errTol)
+            return (delta1 < delta) ? alt1 : alt0;
+
+        if (delta1 < errTol)
+            return alt1;
+    }
+    else
+    {
+        delta = srcFloat - half_to_float ((uint16_t)alt0);
+        // bits0 < bits1 so if ok, just return
+        if (delta < errTol)
+            return alt0;
+
+        // fallback...
+        // in this case, alt1 rounding could have made
+        // bits1 larger than src, test for that
+        int srcbits = countSetBits (abssrc);
+        if (bits1 < srcbits)
+        {
+            delta = half_to_float ((uint16_t)alt1) - srcFloat;
+            if (delta < errTol)
+                return alt1;
+        }
+    }
+    return abssrc;
+}
+
+static inline uint32_t handleQuantizeSmallerSig (
+    uint32_t abssrc, uint32_t npow2, uint32_t mask, float errTol, float srcFloat)
+{
+    // in this case, only need to test two cases:
+    //
+    // base truncation and rounded truncation
+    uint32_t alt0 = (abssrc & mask);
+    uint32_t alt1 = ((abssrc + npow2) & mask);
+
+    int bits0 = countSetBits (alt0);
+    int bits1 = countSetBits (alt1);
+
+    float delta;
+
+    if (bits1 < bits0)
+    {
+        delta = half_to_float ((uint16_t)alt1) - srcFloat; // alt1 >= srcFloat
+        // bits1 < bits0 and if ok, just return
+        if (delta < errTol)
+            return alt1;
+        delta = srcFloat - half_to_float ((uint16_t)alt0); // alt0 <= srcFloat
+        if (delta < errTol)
+            return alt0;
+    }
+    else if (bits1 == bits0)
+    {
+        delta = srcFloat - half_to_float ((uint16_t)alt0);
+        float delta1 = half_to_float ((uint16_t)alt1) - srcFloat;
+        if (delta < errTol)
+            return (delta1 < delta) ? alt1 : alt0;
+
+        if (delta1 < errTol)
+            return alt1;
+    }
+    else
+    {
+        delta = srcFloat - half_to_float ((uint16_t)alt0);
+        // bits0 < bits1 so if ok, just return
+        if (delta < errTol)
+            return alt0;
+
+        // fallback...
+        // in this case, alt1 rounding could have made
+        // bits1 larger than src, test for that
+        int srcbits = countSetBits (abssrc);
+        if (bits1 < srcbits)
+        {
+            delta = half_to_float ((uint16_t)alt1) - srcFloat;
+            if (delta < errTol)
+                return alt1;
+        }
+    }
+    return abssrc;
+}
+
+static inline uint32_t handleQuantizeEqualSig (
+    uint32_t abssrc, uint32_t npow2, uint32_t mask, float errTol, float srcFloat)
+{
+    // 99.99% of the time, mask is the best choice but for a very few
+    // 16-bit float to 32-bit float where even though the significands
+    // of the shifted tolerance we will need mask2, so have a
+    // different implementation than the basic choose 2 of the larger
+    // / smaller cases
+    uint32_t alt0 = (abssrc & mask);
+    uint32_t alt1 = ((abssrc + npow2) & mask);
+
+    // this costs us not much extra if it works (99.99% of the
+    // time) as we would compute this immediately assuming
+    // the mask almost always makes the bits smaller...
+    float delta0 = srcFloat - half_to_float ((uint16_t)alt0);
+    if (delta0 >= errTol)
+    {
+        const uint32_t mask2 = (mask ^ (npow2 | (npow2 >> 1)));
+
+        alt0 = (abssrc & mask2);
+        delta0 = srcFloat - half_to_float ((uint16_t)alt0);
+
+        // avoid a re-check against the tolerance below...
+        if (delta0 >= errTol)
+        {
+            float delta1 = half_to_float ((uint16_t)alt1) - srcFloat;
+            if (delta1 < errTol)
+            {
+                int bits1 = countSetBits (alt1);
+                int srcbits = countSetBits (abssrc);
+                if (bits1 < srcbits)
+                    return alt1;
+            }
+            return abssrc;
+        }
+    }
+
+    int bits0 = countSetBits (alt0);
+    int bits1 = countSetBits (alt1);
+
+    // bits0 is either the same as src (i.e. mask didn't mask any bits)
+    // or smaller than src, so do not need to check against that
+    //
+    // bits1 because we add npow2 may not actually end up smaller...
+    if (bits1 < bits0)
+    {
+        float delta1 = half_to_float ((uint16_t)alt1) - srcFloat;
+        // bits1 < bits0 and if ok, just return
+        if (delta1 < errTol) return alt1;
+    }
+    else if (bits1 == bits0)
+    {
+        float delta1 = half_to_float ((uint16_t)alt1) - srcFloat;
+        if (delta1 < delta0) return alt1;
+    }
+
+    // bits0 < bits1 and ok or alt1 failed
+    return alt0;
+}
+
+static uint32_t handleQuantizeDefault (
+    uint32_t abssrc, uint32_t tolSig, float errTol, float srcFloat)
+{
+    // classic would do clz(significand - 1) but here we are trying to
+    // construct a mask, so want to ensure for an power of 2, we
+    // actually get the next (i.e. 2 returns 4)
+    const uint32_t tsigshift = (32 - countLeadingZeros (tolSig));
+    const uint32_t npow2 = (1 << tsigshift);
+    const uint32_t lowermask = npow2 - 1;
+    const uint32_t mask = ~lowermask;
+    const uint32_t srcMaskedVal = abssrc & lowermask;
+
+    if (srcMaskedVal > tolSig)
+        return handleQuantizeLargerSig (abssrc, npow2, mask, errTol, srcFloat);
+    else if (srcMaskedVal < tolSig)
+        return handleQuantizeSmallerSig (abssrc, npow2, mask, errTol, srcFloat);
+
+    return handleQuantizeEqualSig (abssrc, npow2, mask, errTol, srcFloat);
+}
+
+static uint16_t algoQuantize (
+    uint32_t src, uint32_t herrTol, float errTol, float srcFloat)
+{
+    uint32_t sign = src & 0x8000;
+    uint32_t abssrc = src & 0x7FFF;
+
+    srcFloat = fabsf(srcFloat);
+
+    uint32_t srcExpBiased = src & 0x7C00;
+    uint32_t tolExpBiased = herrTol & 0x7C00;
+
+    // if nan / inf, just bail and return src
+    if (srcExpBiased == 0x7C00)
+        return src;
+
+    // can't possibly beat 0 bits
+    if (srcFloat < errTol)
+        return 0;
+
+    uint32_t expDiff = (srcExpBiased - tolExpBiased) >> 10;
+    uint32_t tolSig = (((herrTol & 0x3FF) | (1 << 10)) >> expDiff);
+
+    if (tolExpBiased == 0)
+    {
+        if (expDiff == 0 || expDiff == 1)
+        {
+            tolSig = (herrTol & 0x3FF);
+            if (tolSig == 0)
+                return src;
+            return sign | handleQuantizeGeneric (abssrc, tolSig, errTol, srcFloat);
+        }
+
+        tolSig = (herrTol & 0x3FF);
+        if (tolSig == 0)
+            return src;
+
+        tolSig >>= expDiff;
+        if (tolSig == 0)
+            tolSig = 1;
+
+        return sign | handleQuantizeDenormTol (abssrc, tolSig, errTol, srcFloat);
+    }
+
+    if (tolSig == 0)
+        return src;
+
+    // we want to try to find a number that has the fewest bits that
+    // is within the specified tolerance. To do so without a lookup
+    // table, we shift (multiply if you will) the tolerance to be
+    // within the same exponent range as the source value.
+    //
+    // we then need to consider a few bit scenarios
+    //
+    //
+    // all b bits should be preserved (or the delta would be too large)
+    // all a bits should be discarded (0'ed)
+    // s (first bit where the significand of the tolerance is on)
+    // p (next power of 2 above s - npow2 above)
+    // x (an extra bit above power of 2)
+    //
+    // we need to consider a bit mask of:
+    // ..bbbbxps aaaaa..
+    // ..bbbb110 00000.. (mask as above)
+    // ..bbbb100 00000..
+    // ..bbbb101 00000..
+    // ..bbbb000 00000..
+    // ..bbbb001 00000.. (mutually exclusive with previous)
+    // ..bbbb1+0 00000.. (add 1 at p bit, then same mask as first case)
+    //
+    // so if you collapse the mutually exclusive one, that gives 5
+    // choices, although they don't always apply, so only need 4 with
+    // a bit of conditional tests:
+    //
+    // uint16_t inexp = (npow2 > 0x0200);
+    // uint16_t mask2 = (mask ^ npow2) * inexp;
+    // uint16_t extrabit = (tolSig > srcMaskedVal);
+    // uint16_t mask3 = (mask ^ npow2);
+    // mask3 ^= ((npow2 << 1) * extrabit);
+    // mask3 |= ((npow2 >> 1) * (! extrabit));
+    //
+    // (src & mask)
+    // (src & mask2)
+    // (src & mask3)
+    // ((src + npow2) & mask);
+    //
+    // So one of those 4 is always one of our choices, but just
+    // blindly computing all 4 is about as expensive as doing the
+    // table lookup and having a sorted set by number of bits to
+    // return the first from, so we're not done yet.
+    //
+    // however, if the tolerance is small relative to the source, can reduce
+    // the ones we need to test, as some of these are always invalid when in
+    // that scenario:
+    //
+    // if the portion of the source significand is larger than the tolerance
+    // significand, we can't simply truncate, or would be out of range of the
+    // tolerance, so only left with 2 scenarios:
+    //
+    // ..bbbb101 00000.. (truncation with preservation of sig bit for "0.5")
+    // ..bbbb1+0 00000.. (add 1 to round up, then same mask)
+    //
+    // if the portion of the source significand is strictly less than
+    // the tolerance significand, we can do the base truncation and
+    // the "round up" may still be within the tolerance, but the
+    // deeper truncations will be out of range, so again only need 2
+    // (but different 2):
+    //
+    // ..bbbb110 00000.. (mask as above)
+    // ..bbbb1+0 00000.. (add 1 to round up, then same mask)
+    //
+    // if the significand is equal to the tolerance, depending on the
+    // translation back to 32 bit to compare against the 32 bit
+    // tolerance (if we could make that a 16-bit value, we could make
+    // different decisions), we have to test all 3 of those values:
+    //
+    // ..bbbb101 00000.. (truncation with preservation of sig bit for "0.5")
+    // ..bbbb110 00000.. (mask as above)
+    // ..bbbb1+0 00000.. (add 1 to round up, then same mask)
+    //
+    // 99.99% of the time, the mask or round will be a good choice,
+    // but only in a few combinations of tolerance will the truncation
+    // be needed because the mask truncation will be out of range,
+    // which is not surprising given we're just shifting the
+    // significand of the half-float tolerance, where the tolerance is
+    // against the original 32-bit value, but can be quickly tested
+    // and swapped for fewer comparisons than testing all 3 values
+    //
+    // when the exponent of the tolerance is close to the value of
+    // src, it is a bit harder to reason about, as the masking
+    // operations will be changing the exponent, and maybe preserving
+    // 1 bit of the significand. for example, when the two numbers are
+    // within the same exponent, it is ok to reduce to just 3 values:
+    //
+    // ..bbbb100 00000.. (mask2 as above)
+    // ..bbbb110 00000.. (mask as above)
+    // ..bbbb1+0 00000.. (add 1 to round up, then same mask)
+    //
+    // However that does not handle all scenarios for all (expected)
+    // tolerances, so a few other cased are contemplated in each
+    // scenario
+
+    // first, handle the default case of a 'large' diff between src
+    // and tolerance, or a denorm src
+    if (expDiff > 1 || srcExpBiased == 0)
+        return sign | handleQuantizeDefault (abssrc, tolSig, errTol, srcFloat);
+
+    if (expDiff == 0)
+        return sign | handleQuantizeEqualExp (abssrc, tolSig, errTol, srcFloat);
+    return sign | handleQuantizeCloseExp (abssrc, tolSig, errTol, srcFloat);
+}
+
+//static const int remap[] = {
+//    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+//    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+//    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+//    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+// inv_remap computed from original zigzag lookup remap so we can
+// deposit into a random destination instead of pulling from a source
+// and save a temporary and loop
+static const int inv_remap[] = {
+    0, 1, 5, 6, 14, 15, 27, 28, 2, 4, 7, 13, 16, 26, 29, 42,
+    3, 8, 12, 17, 25, 30, 41, 43, 9, 11, 18, 24, 31, 40, 44, 53,
+    10, 19, 23, 32, 39, 45, 52, 54, 20, 22, 33, 38, 46, 51, 55, 60,
+    21, 34, 37, 47, 50, 56, 59, 61, 35, 36, 48, 49, 57, 58, 62, 63};
+
+static void
+quantizeCoeffAndZigXDR_scalar (
+    uint16_t* restrict    halfZigCoeff,
+    const float* restrict dctvals,
+    const float* restrict tolerances,
+    const uint16_t* restrict halftols)
+{
+    // manually unrolling seems to help on at least x86
+    for ( int i = 0; i < 64; i += 4 )
+    {
+        uint16_t       src0     = float_to_half (dctvals[i+0]);
+        uint16_t       src1     = float_to_half (dctvals[i+1]);
+        uint16_t       src2     = float_to_half (dctvals[i+2]);
+        uint16_t       src3     = float_to_half (dctvals[i+3]);
+        const float    errTol0  = tolerances[i+0];
+        const float    errTol1  = tolerances[i+1];
+        const float    errTol2  = tolerances[i+2];
+        const float    errTol3  = tolerances[i+3];
+        const uint16_t herrTol0 = halftols[i+0];
+        const uint16_t herrTol1 = halftols[i+1];
+        const uint16_t herrTol2 = halftols[i+2];
+        const uint16_t herrTol3 = halftols[i+3];
+        src0 = algoQuantize (src0, herrTol0, errTol0, half_to_float (src0));
+        src1 = algoQuantize (src1, herrTol1, errTol1, half_to_float (src1));
+        src2 = algoQuantize (src2, herrTol2, errTol2, half_to_float (src2));
+        src3 = algoQuantize (src3, herrTol3, errTol3, half_to_float (src3));
+
+        halfZigCoeff[inv_remap[i+0]] = one_from_native16 (src0);
+        halfZigCoeff[inv_remap[i+1]] = one_from_native16 (src1);
+        halfZigCoeff[inv_remap[i+2]] = one_from_native16 (src2);
+        halfZigCoeff[inv_remap[i+3]] = one_from_native16 (src3);
+    }
+//    for ( int i = 0; i < 64; ++i )
+//    {
+//        uint16_t       src     = float_to_half (dctvals[i]);
+//        const float    errTol  = tolerances[i];
+//        const uint16_t herrTol = halftols[i];
+//        src = algoQuantize (src, herrTol, errTol, half_to_float (src));
+//        halfZigCoeff[inv_remap[i]] = one_from_native16 (src);
+//    }
+}
+
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+
+//
+// F16C version. The float -> half -> float round trip is done 8
+// coefficients at a time, which matches float_to_half() / half_to_float()
+// for all but NaN inputs (those rows are done by the scalar code), and
+// most coefficients end up below the error tolerance, and so quantize
+// to 0 without ever reaching algoQuantize().
+//
+
+IMF_AVX_F16C_FUNC static void
+quantizeCoeffAndZigXDR_f16c (
+    uint16_t* restrict    halfZigCoeff,
+    const float* restrict dctvals,
+    const float* restrict tolerances,
+    const uint16_t* restrict halftols)
+{
+    const __m256 absMask =
+        _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff));
+
+    for (int i = 0; i < 64; i += 8)
+    {
+        __m256   src = _mm256_loadu_ps (dctvals + i);
+        __m128i  hsrc;
+        __m256   fsrc;
+        int      zeromask;
+        uint16_t h[8];
+        float    f[8];
+
+        if (_mm256_movemask_ps (_mm256_cmp_ps (src, src, _CMP_UNORD_Q)))
+        {
+            for (int j = i; j < i + 8; ++j)
+            {
+                uint16_t s = float_to_half (dctvals[j]);
+                s = algoQuantize (
+                    s, halftols[j], tolerances[j], half_to_float (s));
+                halfZigCoeff[inv_remap[j]] = one_from_native16 (s);
+            }
+            continue;
+        }
+
+        hsrc = _mm256_cvtps_ph (src, _MM_FROUND_TO_NEAREST_INT);
+        fsrc = _mm256_cvtph_ps (hsrc);
+
+        //
+        // can't possibly beat 0 bits
+        //
+
+        zeromask = _mm256_movemask_ps (_mm256_cmp_ps (
+            _mm256_and_ps (fsrc, absMask),
+            _mm256_loadu_ps (tolerances + i),
+            _CMP_LT_OQ));
+
+        if (zeromask == 0xff)
+        {
+            for (int j = 0; j < 8; ++j)
+                halfZigCoeff[inv_remap[i + j]] = 0;
+            continue;
+        }
+
+        _mm_storeu_si128 ((__m128i*) h, hsrc);
+        _mm256_storeu_ps (f, fsrc);
+
+        for (int j = 0; j < 8; ++j)
+        {
+            uint16_t s = 0;
+            if (!(zeromask & (1 << j)))
+                s = algoQuantize (
+                    h[j], halftols[i + j], tolerances[i + j], f[j]);
+            halfZigCoeff[inv_remap[i + j]] = one_from_native16 (s);
+        }
+    }
+}
+
+#endif /* IMF_HAVE_AVX_F16C_TARGET */
@@ -46,6 +46,22 @@
 #    endif /* __LP64__ */
 #endif     /* OPENEXR_IMF_HAVE_GCC_INLINE_ASM_AVX */
 
+//
+// The forward (encoder) kernels use intrinsics, enabling AVX + F16C
+// only for those functions, so the rest of the library can still be
+// built without VEX encoding. They are selected at runtime, in
+// initializeFuncs(). FMA is deliberately not enabled, so the compiler
+// can not contract the multiply / adds, which keeps the results
+// bit-identical with the SSE2 and scalar versions.
+//
+
+#if (defined(__x86_64__) || defined(_M_X64)) &&                                \
+    (defined(__GNUC__) || defined(__clang__)) && !defined(__e2k__)
+#    define IMF_HAVE_AVX_F16C_TARGET 1
+#    define IMF_AVX_F16C_FUNC __attribute__ ((target ("avx,f16c")))
+#    include <immintrin.h>
+#endif
+
 #define _SSE_ALIGNMENT 32
 #define _SSE_ALIGNMENT_MASK 0x0F
 #define _AVX_ALIGNMENT_MASK 0x1F
@@ -172,8 +188,8 @@ csc709Inverse64 (float* comp0, float* comp1, float* comp2)
 // primary chromaticies, with no scaling or offsets.
 //
 
-static inline void
-csc709Forward64 (float* comp0, float* comp1, float* comp2)
+static void
+csc709Forward64_scalar (float* comp0, float* comp1, float* comp2)
 {
     float src[3];
 
@@ -189,6 +205,55 @@ csc709Forward64 (float* comp0, float* comp1, float* comp2)
     }
 }
 
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+
+//
+// AVX version, 8 pixels at a time. Evaluated in the same
+// order as the scalar version above.
+//
+
+IMF_AVX_F16C_FUNC static void
+csc709Forward64_avx (float* comp0, float* comp1, float* comp2)
+{
+    const __m256 r0 = _mm256_set1_ps (0.2126f);
+    const __m256 g0 = _mm256_set1_ps (0.7152f);
+    const __m256 b0 = _mm256_set1_ps (0.0722f);
+    const __m256 r1 = _mm256_set1_ps (-0.1146f);
+    const __m256 g1 = _mm256_set1_ps (0.3854f);
+    const __m256 b1 = _mm256_set1_ps (0.5000f);
+    const __m256 r2 = _mm256_set1_ps (0.5000f);
+    const __m256 g2 = _mm256_set1_ps (0.4542f);
+    const __m256 b2 = _mm256_set1_ps (0.0458f);
+
+    for (int i = 0; i < 64; i += 8)
+    {
+        __m256 src0 = _mm256_loadu_ps (comp0 + i);
+        __m256 src1 = _mm256_loadu_ps (comp1 + i);
+        __m256 src2 = _mm256_loadu_ps (comp2 + i);
+
+        _mm256_storeu_ps (
+            comp0 + i,
+            _mm256_add_ps (
+                _mm256_add_ps (
+                    _mm256_mul_ps (r0, src0), _mm256_mul_ps (g0, src1)),
+                _mm256_mul_ps (b0, src2)));
+        _mm256_storeu_ps (
+            comp1 + i,
+            _mm256_add_ps (
+                _mm256_sub_ps (
+                    _mm256_mul_ps (r1, src0), _mm256_mul_ps (g1, src1)),
+                _mm256_mul_ps (b1, src2)));
+        _mm256_storeu_ps (
+            comp2 + i,
+            _mm256_sub_ps (
+                _mm256_sub_ps (
+                    _mm256_mul_ps (r2, src0), _mm256_mul_ps (g2, src1)),
+                _mm256_mul_ps (b2, src2)));
+    }
+}
+
+#endif /* IMF_HAVE_AVX_F16C_TARGET */
+
 //
 // Byte interleaving of 2 byte arrays:
 //    src0 = AAAA
@@ -437,6 +502,50 @@ convertFloatToHalf64_f16c (uint16_t* dst, float* src)
 #endif /* IMF_HAVE_GCC_INLINEASM_X86 */
 }
 
+//
+// Half -> float conversion of an 8x8 block, used when
+// gathering source blocks in the encoder.
+//
+
+static void
+convertHalfToFloat64_scalar (float* dst, const uint16_t* src)
+{
+    for (int i = 0; i < 64; ++i)
+        dst[i] = half_to_float (src[i]);
+}
+
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+
+//
+// F16C conversion. All finite and infinite values convert
+// exactly, but NaNs are quieted by the hardware, where
+// half_to_float() preserves the payload as is, so defer rows
+// holding any NaN to the scalar conversion.
+//
+
+IMF_AVX_F16C_FUNC static void
+convertHalfToFloat64_f16c (float* dst, const uint16_t* src)
+{
+    const __m128i absMask = _mm_set1_epi16 (0x7fff);
+    const __m128i infBits = _mm_set1_epi16 (0x7c00);
+
+    for (int i = 0; i < 64; i += 8)
+    {
+        __m128i h = _mm_loadu_si128 ((const __m128i*) (src + i));
+
+        if (_mm_movemask_epi8 (
+                _mm_cmpgt_epi16 (_mm_and_si128 (h, absMask), infBits)))
+        {
+            for (int j = i; j < i + 8; ++j)
+                dst[j] = half_to_float (src[j]);
+        }
+        else
+            _mm256_storeu_ps (dst + i, _mm256_cvtph_ps (h));
+    }
+}
+
+#endif /* IMF_HAVE_AVX_F16C_TARGET */
+
 //
 // Convert an 8x8 block of HALF from zig-zag order to
 // FLOAT in normal order. The order we want is:
@@ -1894,7 +2003,7 @@ dctInverse8x8_avx_7 (float* data)
 //
 
 static void
-dctForward8x8 (float* data)
+dctForward8x8_scalar (float* data)
 {
     float A0, A1, A2, A3, A4, A5, A6, A7;
     float K0, K1, rot_x, rot_y;
@@ -2076,7 +2185,7 @@ dctForward8x8 (float* data)
 //
 
 static void
-dctForward8x8 (float* data)
+dctForward8x8_sse2 (float* data)
 {
     __m128* srcVec = (__m128*) data;
     __m128  a0Vec, a1Vec, a2Vec, a3Vec, a4Vec, a5Vec, a6Vec, a7Vec;
@@ -2277,6 +2386,147 @@ dctForward8x8 (float* data)
 
 #endif /* IMF_HAVE_SSE2 */
 
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+
+//
+// AVX implementation
+//
+// The same column-wise operation plus transposes as the SSE2
+// version, but with a full row of the block in each register.
+// The arithmetic is identical, operation for operation, so the
+// results are too.
+//
+
+IMF_AVX_F16C_FUNC static void
+dctForward8x8_avx (float* data)
+{
+    __m256 row[8];
+    __m256 a0Vec, a1Vec, a2Vec, a3Vec, a4Vec, a5Vec, a6Vec, a7Vec;
+    __m256 k0Vec, k1Vec, rotXVec, rotYVec;
+    __m256 transTmp[8], transTmp2[8];
+
+    const __m256 c4Vec    = _mm256_set1_ps (.70710678f);
+    const __m256 c4NegVec = _mm256_set1_ps (-.70710678f);
+
+    const __m256 c1HalfVec = _mm256_set1_ps (.490392640f);
+    const __m256 c2HalfVec = _mm256_set1_ps (.461939770f);
+    const __m256 c3HalfVec = _mm256_set1_ps (.415734810f);
+    const __m256 c5HalfVec = _mm256_set1_ps (.277785120f);
+    const __m256 c6HalfVec = _mm256_set1_ps (.191341720f);
+    const __m256 c7HalfVec = _mm256_set1_ps (.097545161f);
+
+    const __m256 halfVec = _mm256_set1_ps (.5f);
+
+    for (int i = 0; i < 8; ++i)
+        row[i] = _mm256_loadu_ps (data + 8 * i);
+
+    for (int iter = 0; iter < 2; ++iter)
+    {
+        a0Vec = _mm256_add_ps (row[0], row[7]);
+        a1Vec = _mm256_add_ps (row[1], row[2]);
+        a3Vec = _mm256_add_ps (row[3], row[4]);
+        a5Vec = _mm256_add_ps (row[5], row[6]);
+
+        a7Vec = _mm256_sub_ps (row[0], row[7]);
+        a2Vec = _mm256_sub_ps (row[1], row[2]);
+        a4Vec = _mm256_sub_ps (row[3], row[4]);
+        a6Vec = _mm256_sub_ps (row[5], row[6]);
+
+        //
+        // First stage; Compute out_0 and out_4
+        //
+
+        k0Vec = _mm256_mul_ps (c4Vec, _mm256_add_ps (a0Vec, a3Vec));
+        k1Vec = _mm256_mul_ps (c4Vec, _mm256_add_ps (a1Vec, a5Vec));
+
+        row[0] = _mm256_mul_ps (_mm256_add_ps (k0Vec, k1Vec), halfVec);
+        row[4] = _mm256_mul_ps (_mm256_sub_ps (k0Vec, k1Vec), halfVec);
+
+        //
+        // Second stage; Compute out_2 and out_6
+        //
+
+        k0Vec = _mm256_sub_ps (a2Vec, a6Vec);
+        k1Vec = _mm256_sub_ps (a0Vec, a3Vec);
+
+        row[2] = _mm256_add_ps (
+            _mm256_mul_ps (c6HalfVec, k0Vec), _mm256_mul_ps (c2HalfVec, k1Vec));
+        row[6] = _mm256_sub_ps (
+            _mm256_mul_ps (c6HalfVec, k1Vec), _mm256_mul_ps (c2HalfVec, k0Vec));
+
+        //
+        // Precompute K0 and K1 for the remaining stages
+        //
+
+        k0Vec = _mm256_mul_ps (_mm256_sub_ps (a1Vec, a5Vec), c4Vec);
+        k1Vec = _mm256_mul_ps (_mm256_add_ps (a2Vec, a6Vec), c4NegVec);
+
+        //
+        // Third Stage, compute out_3 and out_5
+        //
+
+        rotXVec = _mm256_sub_ps (a7Vec, k0Vec);
+        rotYVec = _mm256_add_ps (a4Vec, k1Vec);
+
+        row[3] = _mm256_sub_ps (
+            _mm256_mul_ps (c3HalfVec, rotXVec),
+            _mm256_mul_ps (c5HalfVec, rotYVec));
+        row[5] = _mm256_add_ps (
+            _mm256_mul_ps (c5HalfVec, rotXVec),
+            _mm256_mul_ps (c3HalfVec, rotYVec));
+
+        //
+        // Fourth Stage, compute out_1 and out_7
+        //
+
+        rotXVec = _mm256_add_ps (a7Vec, k0Vec);
+        rotYVec = _mm256_sub_ps (k1Vec, a4Vec);
+
+        row[1] = _mm256_sub_ps (
+            _mm256_mul_ps (c1HalfVec, rotXVec),
+            _mm256_mul_ps (c7HalfVec, rotYVec));
+        row[7] = _mm256_add_ps (
+            _mm256_mul_ps (c7HalfVec, rotXVec),
+            _mm256_mul_ps (c1HalfVec, rotYVec));
+
+        //
+        // Transpose: interleave pairs of rows, then pairs of pairs,
+        // then swap the 128-bit halves
+        //
+
+        for (int i = 0; i < 8; i += 2)
+        {
+            transTmp[i]     = _mm256_unpacklo_ps (row[i], row[i + 1]);
+            transTmp[i + 1] = _mm256_unpackhi_ps (row[i], row[i + 1]);
+        }
+
+        for (int i = 0; i < 8; i += 4)
+        {
+            transTmp2[i] =
+                _mm256_shuffle_ps (transTmp[i], transTmp[i + 2], 0x44);
+            transTmp2[i + 1] =
+                _mm256_shuffle_ps (transTmp[i], transTmp[i + 2], 0xEE);
+            transTmp2[i + 2] =
+                _mm256_shuffle_ps (transTmp[i + 1], transTmp[i + 3], 0x44);
+            transTmp2[i + 3] =
+                _mm256_shuffle_ps (transTmp[i + 1], transTmp[i + 3], 0xEE);
+        }
+
+        for (int i = 0; i < 4; ++i)
+        {
+            row[i] =
+                _mm256_permute2f128_ps (transTmp2[i], transTmp2[i + 4], 0x20);
+            row[i + 4] =
+                _mm256_permute2f128_ps (transTmp2[i], transTmp2[i + 4], 0x31);
+        }
+    }
+
+    for (int i = 0; i < 8; ++i)
+        _mm256_storeu_ps (data + 8 * i, row[i]);
+}
+
+#endif /* IMF_HAVE_AVX_F16C_TARGET */
+
 /**************************************/
 
 //
@@ -2307,6 +2557,48 @@ static void (*dctInverse8x8_5) (float*) = dctInverse8x8_scalar_5;
 static void (*dctInverse8x8_6) (float*) = dctInverse8x8_scalar_6;
 static void (*dctInverse8x8_7) (float*) = dctInverse8x8_scalar_7;
 
+//
+// The encoder side: gathering source blocks, the forward
+// color space conversion, forward DCT and quantization.
+//
+
+static void (*convertHalfToFloat64) (float*, const uint16_t*) =
+    convertHalfToFloat64_scalar;
+
+static void (*csc709Forward64) (float*, float*, float*) =
+    csc709Forward64_scalar;
+
+#ifdef IMF_HAVE_SSE2
+static void (*dctForward8x8) (float*) = dctForward8x8_sse2;
+#else
+static void (*dctForward8x8) (float*) = dctForward8x8_scalar;
+#endif
+
+//
+// The quantizer lives in internal_dwa_quantize.h, and needs
+// the tolerance tables alongside the coefficients.
+//
+
+static void quantizeCoeffAndZigXDR_scalar (
+    uint16_t* restrict       halfZigCoeff,
+    const float* restrict    dctvals,
+    const float* restrict    tolerances,
+    const uint16_t* restrict halftols);
+
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+static void quantizeCoeffAndZigXDR_f16c (
+    uint16_t* restrict       halfZigCoeff,
+    const float* restrict    dctvals,
+    const float* restrict    tolerances,
+    const uint16_t* restrict halftols);
+#endif
+
+static void (*quantizeCoeffAndZigXDR) (
+    uint16_t* restrict,
+    const float* restrict,
+    const float* restrict,
+    const uint16_t* restrict) = quantizeCoeffAndZigXDR_scalar;
+
 static void
 initializeFuncs (void)
 {
@@ -2336,6 +2628,20 @@ initializeFuncs (void)
         fromHalfZigZag       = fromHalfZigZag_f16c;
     }
 
+    //
+    // Setup the encoder kernels
+    //
+
+#    ifdef IMF_HAVE_AVX_F16C_TARGET
+    if (avx && f16c)
+    {
+        convertHalfToFloat64   = convertHalfToFloat64_f16c;
+        csc709Forward64        = csc709Forward64_avx;
+        dctForward8x8          = dctForward8x8_avx;
+        quantizeCoeffAndZigXDR = quantizeCoeffAndZigXDR_f16c;
+    }
+#    endif
+
     dctInverse8x8_0 = dctInverse8x8_scalar_0;
     dctInverse8x8_1 = dctInverse8x8_scalar_1;
     dctInverse8x8_2 = dctInverse8x8_scalar_2;
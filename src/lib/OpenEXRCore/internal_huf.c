@@ -1874,7 +1874,7 @@ internal_huf_compress (
     }
 
     if (outsz < 20) return EXR_ERR_INVALID_ARGUMENT;
-    if (sparebytes != internal_exr_huf_compress_spare_bytes ())
+    if (sparebytes < internal_exr_huf_compress_spare_bytes ())
         return EXR_ERR_INVALID_ARGUMENT;
 
     freq  = (uint64_t*) spare;
@@ -1937,7 +1937,7 @@ internal_huf_decompress (
         return EXR_ERR_SUCCESS;
     }
 
-    if (sparebytes != internal_exr_huf_decompress_spare_bytes ())
+    if (sparebytes < internal_exr_huf_decompress_spare_bytes ())
         return EXR_ERR_INVALID_ARGUMENT;
 
     im = readUInt (compressed);
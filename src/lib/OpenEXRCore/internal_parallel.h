@@ -0,0 +1,59 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#ifndef OPENEXR_PRIVATE_PARALLEL_H
+#define OPENEXR_PRIVATE_PARALLEL_H
+
+#include "openexr_base.h"
+#include "openexr_errors.h"
+#include "internal_structs.h"
+
+/** Returns a reasonable default number of worker threads for the
+ * parallel helpers (the number of online processors), always at
+ * least 1. */
+int internal_exr_default_thread_count (void);
+
+/** Runs @p fn once for each entry of @p task_data, using @p spawn_fn
+ * to schedule all but the first task, which is run on the calling
+ * thread. If @p spawn_fn is NULL, native threads are created for the
+ * duration of the call. Returns once all tasks have completed.
+ *
+ * If threading is disabled, or thread creation fails, the tasks are
+ * run serially on the calling thread, so this only fails if the
+ * bookkeeping memory can not be allocated.
+ */
+exr_result_t internal_exr_run_tasks (
+    exr_const_context_t ctxt,
+    int                 num_tasks,
+    exr_task_fn_t       fn,
+    void**              task_data,
+    exr_task_spawn_fn_t spawn_fn,
+    void*               spawn_user_data);
+
+/** Atomically claims the next index from a shared counter, returning
+ * a value >= @p end when there is no more work. */
+static inline int
+internal_exr_claim_next (atomic_uintptr_t* counter, int end)
+{
+    uintptr_t cur = atomic_load (counter);
+    while (cur < (uintptr_t) end)
+    {
+        if (atomic_compare_exchange_strong (counter, &cur, cur + 1))
+            return (int) cur;
+    }
+    return end;
+}
+
+/** Records @p rv in @p status if no error has been recorded yet, such
+ * that the first failure wins. */
+static inline void
+internal_exr_record_error (atomic_uintptr_t* status, exr_result_t rv)
+{
+    uintptr_t expected = 0;
+    if (rv != EXR_ERR_SUCCESS)
+        atomic_compare_exchange_strong (status, &expected, (uintptr_t) rv);
+}
+
+#endif /* OPENEXR_PRIVATE_PARALLEL_H */
@@ -7,7 +7,9 @@
 #include "internal_decompress.h"
 
 #include "internal_coding.h"
+#include "internal_cpuid.h"
 #include "internal_huf.h"
+#include "internal_piz_kernels.h"
 #include "internal_xdr.h"
 
 #include <string.h>
@@ -66,16 +68,6 @@ forwardLutFromBitmap (const uint8_t* bitmap, uint16_t* lut)
     return k - 1;
 }
 
-#ifndef __cplusplus
-// msvc does not seem to properly enable restrict in C compiling. /sigh
-#    ifndef _MSC_VER
-#        define NO_ALIAS restrict
-#    endif
-#endif
-#ifndef NO_ALIAS
-#    define NO_ALIAS
-#endif
-
 static inline uint16_t
 reverseLutFromBitmap (const uint8_t* NO_ALIAS bitmap, uint16_t* NO_ALIAS lut)
 {
@@ -114,119 +106,6 @@ applyLut (const uint16_t lut[NO_ALIAS USHORT_RANGE], uint16_t* NO_ALIAS data, ui
         data[i] = lut[data[i]];
 }
 
-/**************************************/
-//
-// Wavelet basis functions without modulo arithmetic; they produce
-// the best compression ratios when the wavelet-transformed data are
-// Huffman-encoded, but the wavelet transform works only for 14-bit
-// data (untransformed data values must be less than (1 << 14)).
-//
-
-static inline void
-wenc14 (uint16_t a, uint16_t b, uint16_t* l, uint16_t* h)
-{
-    int16_t as = (int16_t) a;
-    int16_t bs = (int16_t) b;
-
-    int16_t ms = (as + bs) >> 1;
-    int16_t ds = as - bs;
-
-    *l = (uint16_t) ms;
-    *h = (uint16_t) ds;
-}
-
-static inline void
-wdec14_4 (uint16_t* px, uint16_t* p01, uint16_t* p10, uint16_t* p11)
-{
-    /* pre swap
-     * px, p01, p10, p11
-     * px -> a
-     * p10 -> b
-     * p01 -> c
-     * p11 -> d
-     * */
-    int16_t a = (int16_t) *px;
-    int16_t b = (int16_t) *p10;
-    int16_t c = (int16_t) *p01;
-    int16_t d = (int16_t) *p11;
-
-    int ai = (int) a;
-    int bi = (int) b;
-    int ci = (int) c;
-    int di = (int) d;
-
-    int i00 = ai + (bi & 1) + (bi >> 1);
-    int i10 = i00 - bi;
-    int i01 = ci + (di & 1) + (di >> 1);
-    int i11 = i01 - di;
-
-    ai = i00 + (i01 & 1) + (i01 >> 1);
-    bi = ai - i01;
-    ci = i10 + (i11 & 1) + (i11 >> 1);
-    di = ci - i11;
-
-    /* different output order */
-    /* px, p01, p10, p11 */
-    *px  = (uint16_t) ai;
-    *p01 = (uint16_t) bi;
-    *p10 = (uint16_t) ci;
-    *p11 = (uint16_t) di;
-}
-
-static inline void
-wdec14 (uint16_t l, uint16_t h, uint16_t* a, uint16_t* b)
-{
-    int16_t ls = (int16_t) l;
-    int16_t hs = (int16_t) h;
-
-    int hi = (int) hs;
-    int li = (int) ls;
-    int ai = li + (hi & 1) + (hi >> 1);
-
-    int16_t as = (int16_t) ai;
-    int16_t bs = (int16_t) (ai - hi);
-
-    *a = (uint16_t) as;
-    *b = (uint16_t) bs;
-}
-
-//
-// Wavelet basis functions with modulo arithmetic; they work with full
-// 16-bit data, but Huffman-encoding the wavelet-transformed data doesn't
-// compress the data quite as well.
-//
-
-#define NBITS ((int) 16)
-#define A_OFFSET ((int) 1 << (NBITS - 1))
-#define M_OFFSET ((int) 1 << (NBITS - 1))
-#define MOD_MASK ((int) (1 << NBITS) - 1)
-
-static inline void
-wenc16 (uint16_t a, uint16_t b, uint16_t* l, uint16_t* h)
-{
-    int ao = (((int) a) + A_OFFSET) & MOD_MASK;
-    int m  = ((ao + ((int) b)) >> 1);
-    int d  = ao - ((int) b);
-
-    if (d < 0) m = (m + M_OFFSET) & MOD_MASK;
-
-    d &= MOD_MASK;
-
-    *l = (uint16_t) m;
-    *h = (uint16_t) d;
-}
-
-static inline void
-wdec16 (uint16_t l, uint16_t h, uint16_t* a, uint16_t* b)
-{
-    int m  = (int) l;
-    int d  = (int) h;
-    int bb = (m - (d >> 1)) & MOD_MASK;
-    int aa = (d + bb - A_OFFSET) & MOD_MASK;
-    *b     = (uint16_t) bb;
-    *a     = (uint16_t) aa;
-}
-
 /**************************************/
 
 static void
@@ -336,6 +215,31 @@ wav_2D_encode (uint16_t* in, int nx, int ox, int ny, int oy, uint16_t mx)
 
 /**************************************/
 
+static wav_decode_rows_fn wdec14_rows = wdec14_rows_scalar;
+static wav_decode_rows_fn wdec16_rows = wdec16_rows_scalar;
+
+static void
+initializeWavDecodeFuncs (void)
+{
+    static int done = 0;
+    if (done) return;
+
+#ifdef PIZ_HAVE_SSE2
+    wdec14_rows = wdec14_rows_sse2;
+    wdec16_rows = wdec16_rows_sse2;
+#endif
+#ifdef PIZ_HAVE_AVX2_TARGET
+    if (has_avx2 ())
+    {
+        wdec14_rows = wdec14_rows_avx2;
+        wdec16_rows = wdec16_rows_avx2;
+    }
+#endif
+    done = 1;
+}
+
+/**************************************/
+
 static void
 wav_2D_decode (
     uint16_t* in, // io: values are transformed in place
@@ -388,26 +292,44 @@ wav_2D_decode (
             // X loop
             //
 
-            for (; px <= ex; px += ox2)
+            if (ox2 == 2)
             {
-                uint16_t* p01 = px + ox1;
-                uint16_t* p10 = px + oy1;
-                uint16_t* p11 = p10 + ox1;
-
                 //
-                // 2D wavelet decoding
+                // finest level of a 16-bit channel, the 2x2 blocks
+                // are adjacent pairs in consecutive rows
                 //
 
+                int nblocks = nx / 2;
+
                 if (w14)
-                {
-                    wdec14_4 (px, p01, p10, p11);
-                }
+                    wdec14_rows (px, px + oy1, nblocks);
                 else
+                    wdec16_rows (px, px + oy1, nblocks);
+                px += 2 * nblocks;
+            }
+            else
+            {
+                for (; px <= ex; px += ox2)
                 {
-                    wdec16 (*px, *p10, &i00, &i10);
-                    wdec16 (*p01, *p11, &i01, &i11);
-                    wdec16 (i00, i01, px, p01);
-                    wdec16 (i10, i11, p10, p11);
+                    uint16_t* p01 = px + ox1;
+                    uint16_t* p10 = px + oy1;
+                    uint16_t* p11 = p10 + ox1;
+
+                    //
+                    // 2D wavelet decoding
+                    //
+
+                    if (w14)
+                    {
+                        wdec14_4 (px, p01, p10, p11);
+                    }
+                    else
+                    {
+                        wdec16 (*px, *p10, &i00, &i10);
+                        wdec16 (*p01, *p11, &i01, &i11);
+                        wdec16 (i00, i01, px, p01);
+                        wdec16 (i10, i11, p10, p11);
+                    }
                 }
             }
 
@@ -714,6 +636,8 @@ internal_exr_undo_piz (
     // Wavelet decoding
     //
 
+    initializeWavDecodeFuncs ();
+
     wavbuf = decode->scratch_buffer_1;
     for (int c = 0; c < decode->channel_count; ++c)
     {
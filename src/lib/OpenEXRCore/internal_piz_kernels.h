@@ -0,0 +1,380 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#ifndef OPENEXR_PRIVATE_PIZ_KERNELS_H
+#define OPENEXR_PRIVATE_PIZ_KERNELS_H
+
+/*
+ * The PIZ wavelet basis functions, and the row decode kernels built on
+ * them in scalar, SSE2 and AVX2 versions. These live in a header of
+ * their own so that the tests can check the versions against each
+ * other.
+ */
+
+#include <stdint.h>
+
+#if defined(__SSE2__) || (defined(_MSC_VER) && defined(_M_X64))
+#    define PIZ_HAVE_SSE2 1
+#    include <emmintrin.h>
+#endif
+
+#if (defined(__x86_64__) || defined(_M_X64)) &&                                \
+    (defined(__GNUC__) || defined(__clang__)) && !defined(__e2k__)
+#    define PIZ_HAVE_AVX2_TARGET 1
+#    include <immintrin.h>
+#endif
+
+/**************************************/
+
+#ifndef __cplusplus
+// msvc does not seem to properly enable restrict in C compiling. /sigh
+#    ifndef _MSC_VER
+#        define NO_ALIAS restrict
+#    endif
+#endif
+#ifndef NO_ALIAS
+#    define NO_ALIAS
+#endif
+
+/**************************************/
+//
+// Wavelet basis functions without modulo arithmetic; they produce
+// the best compression ratios when the wavelet-transformed data are
+// Huffman-encoded, but the wavelet transform works only for 14-bit
+// data (untransformed data values must be less than (1 << 14)).
+//
+
+static inline void
+wenc14 (uint16_t a, uint16_t b, uint16_t* l, uint16_t* h)
+{
+    int16_t as = (int16_t) a;
+    int16_t bs = (int16_t) b;
+
+    int16_t ms = (as + bs) >> 1;
+    int16_t ds = as - bs;
+
+    *l = (uint16_t) ms;
+    *h = (uint16_t) ds;
+}
+
+static inline void
+wdec14_4 (uint16_t* px, uint16_t* p01, uint16_t* p10, uint16_t* p11)
+{
+    /* pre swap
+     * px, p01, p10, p11
+     * px -> a
+     * p10 -> b
+     * p01 -> c
+     * p11 -> d
+     * */
+    int16_t a = (int16_t) *px;
+    int16_t b = (int16_t) *p10;
+    int16_t c = (int16_t) *p01;
+    int16_t d = (int16_t) *p11;
+
+    int ai = (int) a;
+    int bi = (int) b;
+    int ci = (int) c;
+    int di = (int) d;
+
+    int i00 = ai + (bi & 1) + (bi >> 1);
+    int i10 = i00 - bi;
+    int i01 = ci + (di & 1) + (di >> 1);
+    int i11 = i01 - di;
+
+    ai = i00 + (i01 & 1) + (i01 >> 1);
+    bi = ai - i01;
+    ci = i10 + (i11 & 1) + (i11 >> 1);
+    di = ci - i11;
+
+    /* different output order */
+    /* px, p01, p10, p11 */
+    *px  = (uint16_t) ai;
+    *p01 = (uint16_t) bi;
+    *p10 = (uint16_t) ci;
+    *p11 = (uint16_t) di;
+}
+
+static inline void
+wdec14 (uint16_t l, uint16_t h, uint16_t* a, uint16_t* b)
+{
+    int16_t ls = (int16_t) l;
+    int16_t hs = (int16_t) h;
+
+    int hi = (int) hs;
+    int li = (int) ls;
+    int ai = li + (hi & 1) + (hi >> 1);
+
+    int16_t as = (int16_t) ai;
+    int16_t bs = (int16_t) (ai - hi);
+
+    *a = (uint16_t) as;
+    *b = (uint16_t) bs;
+}
+
+//
+// Wavelet basis functions with modulo arithmetic; they work with full
+// 16-bit data, but Huffman-encoding the wavelet-transformed data doesn't
+// compress the data quite as well.
+//
+
+#define NBITS ((int) 16)
+#define A_OFFSET ((int) 1 << (NBITS - 1))
+#define M_OFFSET ((int) 1 << (NBITS - 1))
+#define MOD_MASK ((int) (1 << NBITS) - 1)
+
+static inline void
+wenc16 (uint16_t a, uint16_t b, uint16_t* l, uint16_t* h)
+{
+    int ao = (((int) a) + A_OFFSET) & MOD_MASK;
+    int m  = ((ao + ((int) b)) >> 1);
+    int d  = ao - ((int) b);
+
+    if (d < 0) m = (m + M_OFFSET) & MOD_MASK;
+
+    d &= MOD_MASK;
+
+    *l = (uint16_t) m;
+    *h = (uint16_t) d;
+}
+
+static inline void
+wdec16 (uint16_t l, uint16_t h, uint16_t* a, uint16_t* b)
+{
+    int m  = (int) l;
+    int d  = (int) h;
+    int bb = (m - (d >> 1)) & MOD_MASK;
+    int aa = (d + bb - A_OFFSET) & MOD_MASK;
+    *b     = (uint16_t) bb;
+    *a     = (uint16_t) aa;
+}
+
+/**************************************/
+
+//
+// The finest level of the wavelet decode touches 3/4 of the data, and
+// for 16-bit channels, the four values of each 2x2 block are adjacent
+// pairs in two rows. These decode runs of those blocks, with SIMD
+// variants selected at runtime. The vector versions work in 32-bit
+// lanes (one block row per lane), and do exactly the integer math of
+// wdec14_4 / wdec16, so the results are identical.
+//
+
+typedef void (*wav_decode_rows_fn) (
+    uint16_t* NO_ALIAS row0, uint16_t* NO_ALIAS row1, int nblocks);
+
+static void
+wdec14_rows_scalar (
+    uint16_t* NO_ALIAS row0, uint16_t* NO_ALIAS row1, int nblocks)
+{
+    for (int b = 0; b < nblocks; ++b)
+        wdec14_4 (
+            row0 + 2 * b, row0 + 2 * b + 1, row1 + 2 * b, row1 + 2 * b + 1);
+}
+
+static void
+wdec16_rows_scalar (
+    uint16_t* NO_ALIAS row0, uint16_t* NO_ALIAS row1, int nblocks)
+{
+    uint16_t i00, i01, i10, i11;
+
+    for (int b = 0; b < nblocks; ++b)
+    {
+        uint16_t* px  = row0 + 2 * b;
+        uint16_t* p01 = px + 1;
+        uint16_t* p10 = row1 + 2 * b;
+        uint16_t* p11 = p10 + 1;
+
+        wdec16 (*px, *p10, &i00, &i10);
+        wdec16 (*p01, *p11, &i01, &i11);
+        wdec16 (i00, i01, px, p01);
+        wdec16 (i10, i11, p10, p11);
+    }
+}
+
+#ifdef PIZ_HAVE_SSE2
+
+static void
+wdec14_rows_sse2 (
+    uint16_t* NO_ALIAS row0, uint16_t* NO_ALIAS row1, int nblocks)
+{
+    const __m128i one = _mm_set1_epi32 (1);
+    const __m128i lo  = _mm_set1_epi32 (0xffff);
+    int           b   = 0;
+
+    for (; b + 4 <= nblocks; b += 4)
+    {
+        __m128i v0 = _mm_loadu_si128 ((const __m128i*) (row0 + 2 * b));
+        __m128i v1 = _mm_loadu_si128 ((const __m128i*) (row1 + 2 * b));
+
+        /* sign extend the pairs: a, c in row 0, b, d in row 1 */
+        __m128i va = _mm_srai_epi32 (_mm_slli_epi32 (v0, 16), 16);
+        __m128i vc = _mm_srai_epi32 (v0, 16);
+        __m128i vb = _mm_srai_epi32 (_mm_slli_epi32 (v1, 16), 16);
+        __m128i vd = _mm_srai_epi32 (v1, 16);
+
+        __m128i i00 = _mm_add_epi32 (
+            _mm_add_epi32 (va, _mm_and_si128 (vb, one)),
+            _mm_srai_epi32 (vb, 1));
+        __m128i i10 = _mm_sub_epi32 (i00, vb);
+        __m128i i01 = _mm_add_epi32 (
+            _mm_add_epi32 (vc, _mm_and_si128 (vd, one)),
+            _mm_srai_epi32 (vd, 1));
+        __m128i i11 = _mm_sub_epi32 (i01, vd);
+
+        va = _mm_add_epi32 (
+            _mm_add_epi32 (i00, _mm_and_si128 (i01, one)),
+            _mm_srai_epi32 (i01, 1));
+        vb = _mm_sub_epi32 (va, i01);
+        vc = _mm_add_epi32 (
+            _mm_add_epi32 (i10, _mm_and_si128 (i11, one)),
+            _mm_srai_epi32 (i11, 1));
+        vd = _mm_sub_epi32 (vc, i11);
+
+        _mm_storeu_si128 (
+            (__m128i*) (row0 + 2 * b),
+            _mm_or_si128 (_mm_and_si128 (va, lo), _mm_slli_epi32 (vb, 16)));
+        _mm_storeu_si128 (
+            (__m128i*) (row1 + 2 * b),
+            _mm_or_si128 (_mm_and_si128 (vc, lo), _mm_slli_epi32 (vd, 16)));
+    }
+
+    wdec14_rows_scalar (row0 + 2 * b, row1 + 2 * b, nblocks - b);
+}
+
+#    define WDEC16_SSE2(l, h, a, b)                                            \
+        b = _mm_and_si128 (_mm_sub_epi32 (l, _mm_srli_epi32 (h, 1)), lo);      \
+        a = _mm_and_si128 (_mm_sub_epi32 (_mm_add_epi32 (h, b), aoff), lo)
+
+static void
+wdec16_rows_sse2 (
+    uint16_t* NO_ALIAS row0, uint16_t* NO_ALIAS row1, int nblocks)
+{
+    const __m128i lo   = _mm_set1_epi32 (0xffff);
+    const __m128i aoff = _mm_set1_epi32 (A_OFFSET);
+    int           b    = 0;
+
+    for (; b + 4 <= nblocks; b += 4)
+    {
+        __m128i v0 = _mm_loadu_si128 ((const __m128i*) (row0 + 2 * b));
+        __m128i v1 = _mm_loadu_si128 ((const __m128i*) (row1 + 2 * b));
+        __m128i i00, i01, i10, i11, va, vb, vc, vd;
+
+        WDEC16_SSE2 (
+            _mm_and_si128 (v0, lo), _mm_and_si128 (v1, lo), i00, i10);
+        WDEC16_SSE2 (
+            _mm_srli_epi32 (v0, 16), _mm_srli_epi32 (v1, 16), i01, i11);
+        WDEC16_SSE2 (i00, i01, va, vb);
+        WDEC16_SSE2 (i10, i11, vc, vd);
+
+        _mm_storeu_si128 (
+            (__m128i*) (row0 + 2 * b),
+            _mm_or_si128 (va, _mm_slli_epi32 (vb, 16)));
+        _mm_storeu_si128 (
+            (__m128i*) (row1 + 2 * b),
+            _mm_or_si128 (vc, _mm_slli_epi32 (vd, 16)));
+    }
+
+    wdec16_rows_scalar (row0 + 2 * b, row1 + 2 * b, nblocks - b);
+}
+
+#    undef WDEC16_SSE2
+
+#endif /* PIZ_HAVE_SSE2 */
+
+#ifdef PIZ_HAVE_AVX2_TARGET
+
+__attribute__ ((target ("avx2"))) static void
+wdec14_rows_avx2 (
+    uint16_t* NO_ALIAS row0, uint16_t* NO_ALIAS row1, int nblocks)
+{
+    const __m256i one = _mm256_set1_epi32 (1);
+    const __m256i lo  = _mm256_set1_epi32 (0xffff);
+    int           b   = 0;
+
+    for (; b + 8 <= nblocks; b += 8)
+    {
+        __m256i v0 = _mm256_loadu_si256 ((const __m256i*) (row0 + 2 * b));
+        __m256i v1 = _mm256_loadu_si256 ((const __m256i*) (row1 + 2 * b));
+
+        __m256i va = _mm256_srai_epi32 (_mm256_slli_epi32 (v0, 16), 16);
+        __m256i vc = _mm256_srai_epi32 (v0, 16);
+        __m256i vb = _mm256_srai_epi32 (_mm256_slli_epi32 (v1, 16), 16);
+        __m256i vd = _mm256_srai_epi32 (v1, 16);
+
+        __m256i i00 = _mm256_add_epi32 (
+            _mm256_add_epi32 (va, _mm256_and_si256 (vb, one)),
+            _mm256_srai_epi32 (vb, 1));
+        __m256i i10 = _mm256_sub_epi32 (i00, vb);
+        __m256i i01 = _mm256_add_epi32 (
+            _mm256_add_epi32 (vc, _mm256_and_si256 (vd, one)),
+            _mm256_srai_epi32 (vd, 1));
+        __m256i i11 = _mm256_sub_epi32 (i01, vd);
+
+        va = _mm256_add_epi32 (
+            _mm256_add_epi32 (i00, _mm256_and_si256 (i01, one)),
+            _mm256_srai_epi32 (i01, 1));
+        vb = _mm256_sub_epi32 (va, i01);
+        vc = _mm256_add_epi32 (
+            _mm256_add_epi32 (i10, _mm256_and_si256 (i11, one)),
+            _mm256_srai_epi32 (i11, 1));
+        vd = _mm256_sub_epi32 (vc, i11);
+
+        _mm256_storeu_si256 (
+            (__m256i*) (row0 + 2 * b),
+            _mm256_or_si256 (
+                _mm256_and_si256 (va, lo), _mm256_slli_epi32 (vb, 16)));
+        _mm256_storeu_si256 (
+            (__m256i*) (row1 + 2 * b),
+            _mm256_or_si256 (
+                _mm256_and_si256 (vc, lo), _mm256_slli_epi32 (vd, 16)));
+    }
+
+    wdec14_rows_scalar (row0 + 2 * b, row1 + 2 * b, nblocks - b);
+}
+
+#    define WDEC16_AVX2(l, h, a, b)                                            \
+        b = _mm256_and_si256 (                                                 \
+            _mm256_sub_epi32 (l, _mm256_srli_epi32 (h, 1)), lo);               \
+        a = _mm256_and_si256 (                                                 \
+            _mm256_sub_epi32 (_mm256_add_epi32 (h, b), aoff), lo)
+
+__attribute__ ((target ("avx2"))) static void
+wdec16_rows_avx2 (
+    uint16_t* NO_ALIAS row0, uint16_t* NO_ALIAS row1, int nblocks)
+{
+    const __m256i lo   = _mm256_set1_epi32 (0xffff);
+    const __m256i aoff = _mm256_set1_epi32 (A_OFFSET);
+    int           b    = 0;
+
+    for (; b + 8 <= nblocks; b += 8)
+    {
+        __m256i v0 = _mm256_loadu_si256 ((const __m256i*) (row0 + 2 * b));
+        __m256i v1 = _mm256_loadu_si256 ((const __m256i*) (row1 + 2 * b));
+        __m256i i00, i01, i10, i11, va, vb, vc, vd;
+
+        WDEC16_AVX2 (
+            _mm256_and_si256 (v0, lo), _mm256_and_si256 (v1, lo), i00, i10);
+        WDEC16_AVX2 (
+            _mm256_srli_epi32 (v0, 16), _mm256_srli_epi32 (v1, 16), i01, i11);
+        WDEC16_AVX2 (i00, i01, va, vb);
+        WDEC16_AVX2 (i10, i11, vc, vd);
+
+        _mm256_storeu_si256 (
+            (__m256i*) (row0 + 2 * b),
+            _mm256_or_si256 (va, _mm256_slli_epi32 (vb, 16)));
+        _mm256_storeu_si256 (
+            (__m256i*) (row1 + 2 * b),
+            _mm256_or_si256 (vc, _mm256_slli_epi32 (vd, 16)));
+    }
+
+    wdec16_rows_scalar (row0 + 2 * b, row1 + 2 * b, nblocks - b);
+}
+
+#    undef WDEC16_AVX2
+
+#endif /* PIZ_HAVE_AVX2_TARGET */
+
+#endif /* OPENEXR_PRIVATE_PIZ_KERNELS_H */
@@ -7,6 +7,7 @@
 #include "internal_decompress.h"
 
 #include "internal_coding.h"
+#include "internal_pxr24_kernels.h"
 #include "internal_xdr.h"
 
 #include <string.h>
@@ -14,74 +15,64 @@
 
 /**************************************/
 
-static inline uint32_t
-float_to_float24 (float f)
+static inline void
+split_uint (const uint8_t* in, int w, uint8_t* out)
 {
-    union
-    {
-        float    f;
-        uint32_t i;
-    } u;
-    uint32_t s, e, m, i;
-
-    u.f = f;
-
-    //
-    // Disassemble the 32-bit floating point number, f,
-    // into sign, s, exponent, e, and significand, m.
-    //
-
-    s = u.i & 0x80000000;
-    e = u.i & 0x7f800000;
-    m = u.i & 0x007fffff;
-
-    if (e == 0x7f800000)
-    {
-        if (m)
-        {
-            //
-            // F is a NAN; we preserve the sign bit and
-            // the 15 leftmost bits of the significand,
-            // with one exception: If the 15 leftmost
-            // bits are all zero, the NAN would turn
-            // into an infinity, so we have to set at
-            // least one bit in the significand.
-            //
-
-            m >>= 8;
-            i = (e >> 8) | m | (m == 0);
-        }
-        else
-        {
-            //
-            // F is an infinity.
-            //
+#ifdef PXR24_HAVE_SSE2
+    split_uint_sse2 (in, w, out);
+#else
+    split_uint_scalar (in, w, out);
+#endif
+}
 
-            i = e >> 8;
-        }
-    }
-    else
-    {
-        //
-        // F is finite, round the significand to 15 bits.
-        //
+static inline void
+split_half (const uint8_t* in, int w, uint8_t* out)
+{
+#ifdef PXR24_HAVE_SSE2
+    split_half_sse2 (in, w, out);
+#else
+    split_half_scalar (in, w, out);
+#endif
+}
 
-        i = ((e | m) + (m & 0x00000080)) >> 8;
+static inline void
+split_float (const uint8_t* in, int w, uint8_t* out)
+{
+#ifdef PXR24_HAVE_SSE2
+    split_float_sse2 (in, w, out);
+#else
+    split_float_scalar (in, w, out);
+#endif
+}
 
-        if (i >= 0x7f8000)
-        {
-            //
-            // F was close to FLT_MAX, and the significand was
-            // rounded up, resulting in an exponent overflow.
-            // Avoid the overflow by truncating the significand
-            // instead of rounding it.
-            //
+static inline void
+merge_uint (const uint8_t* in, int w, uint8_t* out)
+{
+#ifdef PXR24_HAVE_SSE2
+    merge_uint_sse2 (in, w, out);
+#else
+    merge_uint_scalar (in, w, out);
+#endif
+}
 
-            i = (e | m) >> 8;
-        }
-    }
+static inline void
+merge_half (const uint8_t* in, int w, uint8_t* out)
+{
+#ifdef PXR24_HAVE_SSE2
+    merge_half_sse2 (in, w, out);
+#else
+    merge_half_scalar (in, w, out);
+#endif
+}
 
-    return (s >> 8) | i;
+static inline void
+merge_float (const uint8_t* in, int w, uint8_t* out)
+{
+#ifdef PXR24_HAVE_SSE2
+    merge_float_sse2 (in, w, out);
+#else
+    merge_float_scalar (in, w, out);
+#endif
 }
 
 /**************************************/
@@ -111,106 +102,33 @@ apply_pxr24_impl (exr_encode_pipeline_t* encode)
 
             switch (curc->data_type)
             {
-                case EXR_PIXEL_UINT: {
-                    uint8_t*        ptr[4];
-                    uint32_t        prevPixel = 0;
-                    const uint32_t* din       = (const uint32_t*) (lastIn);
-
+                case EXR_PIXEL_UINT:
                     nBytes *= sizeof (uint32_t);
                     if (nOut + nBytes > encode->scratch_alloc_size_1)
                         return EXR_ERR_OUT_OF_MEMORY;
+                    split_uint (lastIn, w, out);
                     nOut += nBytes;
                     lastIn += nBytes;
-
-                    ptr[0] = out;
-                    out += w;
-                    ptr[1] = out;
-                    out += w;
-                    ptr[2] = out;
-                    out += w;
-                    ptr[3] = out;
-                    out += w;
-
-                    for (int x = 0; x < w; ++x)
-                    {
-                        uint32_t pixel = unaligned_load32 (din);
-                        uint32_t diff  = pixel - prevPixel;
-                        prevPixel      = pixel;
-
-                        ++din;
-                        *(ptr[0]++) = (uint8_t) (diff >> 24);
-                        *(ptr[1]++) = (uint8_t) (diff >> 16);
-                        *(ptr[2]++) = (uint8_t) (diff >> 8);
-                        *(ptr[3]++) = (uint8_t) (diff);
-                    }
+                    out += nBytes;
                     break;
-                }
-                case EXR_PIXEL_HALF: {
-                    uint8_t*        ptr[2];
-                    uint32_t        prevPixel = 0;
-                    const uint16_t* din       = (const uint16_t*) (lastIn);
-
+                case EXR_PIXEL_HALF:
                     nBytes *= sizeof (uint16_t);
                     if (nOut + nBytes > encode->scratch_alloc_size_1)
                         return EXR_ERR_OUT_OF_MEMORY;
+                    split_half (lastIn, w, out);
                     nOut += nBytes;
                     lastIn += nBytes;
-
-                    ptr[0] = out;
-                    out += w;
-                    ptr[1] = out;
-                    out += w;
-
-                    for (int x = 0; x < w; ++x)
-                    {
-                        uint32_t pixel = (uint32_t) unaligned_load16 (din);
-                        uint32_t diff  = pixel - prevPixel;
-                        prevPixel      = pixel;
-
-                        ++din;
-                        *(ptr[0]++) = (uint8_t) (diff >> 8);
-                        *(ptr[1]++) = (uint8_t) (diff);
-                    }
+                    out += nBytes;
                     break;
-                }
-                case EXR_PIXEL_FLOAT: {
-                    uint8_t*     ptr[3];
-                    uint32_t     prevPixel = 0;
-                    const float* din       = (const float*) (lastIn);
-
+                case EXR_PIXEL_FLOAT:
                     nBytes *= 3;
                     if (nOut + nBytes > encode->scratch_alloc_size_1)
                         return EXR_ERR_OUT_OF_MEMORY;
+                    split_float (lastIn, w, out);
                     nOut += nBytes;
                     lastIn += w * 4;
-
-                    ptr[0] = out;
-                    out += w;
-                    ptr[1] = out;
-                    out += w;
-                    ptr[2] = out;
-                    out += w;
-
-                    for (int x = 0; x < w; ++x)
-                    {
-                        union
-                        {
-                            uint32_t i;
-                            float    f;
-                        } v;
-                        uint32_t pixel24, diff;
-                        v.i       = unaligned_load32 (din);
-                        pixel24   = float_to_float24 (v.f);
-                        diff      = pixel24 - prevPixel;
-                        prevPixel = pixel24;
-
-                        ++din;
-                        *(ptr[0]++) = (uint8_t) (diff >> 16);
-                        *(ptr[1]++) = (uint8_t) (diff >> 8);
-                        *(ptr[2]++) = (uint8_t) (diff);
-                    }
+                    out += nBytes;
                     break;
-                }
                 default: return EXR_ERR_INVALID_ARGUMENT;
             }
         }
@@ -306,90 +224,27 @@ undo_pxr24_impl (
 
             switch (curc->data_type)
             {
-                case EXR_PIXEL_UINT: {
-                    const uint8_t* ptr[4];
-                    uint32_t       pixel = 0;
-                    uint32_t*      dout  = (uint32_t*) (out);
-
-                    ptr[0] = lastIn;
-                    lastIn += w;
-                    ptr[1] = lastIn;
-                    lastIn += w;
-                    ptr[2] = lastIn;
-                    lastIn += w;
-                    ptr[3] = lastIn;
-                    lastIn += w;
-
+                case EXR_PIXEL_UINT:
                     if (nDec + nBytes > uncompressed_size)
                         return EXR_ERR_CORRUPT_CHUNK;
-
-                    for (int x = 0; x < w; ++x)
-                    {
-                        uint32_t diff =
-                            (((uint32_t) (*(ptr[0]++)) << 24) |
-                             ((uint32_t) (*(ptr[1]++)) << 16) |
-                             ((uint32_t) (*(ptr[2]++)) << 8) |
-                             ((uint32_t) (*(ptr[3]++))));
-                        pixel += diff;
-                        unaligned_store32 (dout, pixel);
-                        ++dout;
-                    }
+                    merge_uint (lastIn, w, out);
+                    lastIn += nBytes;
                     nDec += nBytes;
                     break;
-                }
-                case EXR_PIXEL_HALF: {
-                    const uint8_t* ptr[2];
-                    uint32_t       pixel = 0;
-                    uint16_t*      dout  = (uint16_t*) (out);
-
-                    ptr[0] = lastIn;
-                    lastIn += w;
-                    ptr[1] = lastIn;
-                    lastIn += w;
-
+                case EXR_PIXEL_HALF:
                     if (nDec + nBytes > uncompressed_size)
                         return EXR_ERR_CORRUPT_CHUNK;
-
-                    for (int x = 0; x < w; ++x)
-                    {
-                        uint32_t diff =
-                            (((uint32_t) (*(ptr[0]++)) << 8) |
-                             ((uint32_t) (*(ptr[1]++))));
-                        pixel += diff;
-                        unaligned_store16 (dout, (uint16_t) pixel);
-                        ++dout;
-                    }
+                    merge_half (lastIn, w, out);
+                    lastIn += nBytes;
                     nDec += nBytes;
                     break;
-                }
-                case EXR_PIXEL_FLOAT: {
-                    const uint8_t* ptr[3];
-                    uint32_t       pixel = 0;
-                    uint32_t*      dout  = (uint32_t*) (out);
-
-                    ptr[0] = lastIn;
-                    lastIn += w;
-                    ptr[1] = lastIn;
-                    lastIn += w;
-                    ptr[2] = lastIn;
-                    lastIn += w;
-
+                case EXR_PIXEL_FLOAT:
                     if (nDec + (uint64_t) (w * 3) > uncompressed_size)
                         return EXR_ERR_CORRUPT_CHUNK;
-
-                    for (int x = 0; x < w; ++x)
-                    {
-                        uint32_t diff =
-                            (((uint32_t) (*(ptr[0]++)) << 24) |
-                             ((uint32_t) (*(ptr[1]++)) << 16) |
-                             ((uint32_t) (*(ptr[2]++)) << 8));
-                        pixel += diff;
-                        unaligned_store32 (dout, pixel);
-                        ++dout;
-                    }
+                    merge_float (lastIn, w, out);
+                    lastIn += w * 3;
                     nDec += (uint64_t) (w * 3);
                     break;
-                }
                 default: return EXR_ERR_INVALID_ARGUMENT;
             }
             out += nBytes;
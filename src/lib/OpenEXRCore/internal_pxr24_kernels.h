@@ -0,0 +1,524 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#ifndef OPENEXR_PRIVATE_PXR24_KERNELS_H
+#define OPENEXR_PRIVATE_PXR24_KERNELS_H
+
+/*
+ * The PXR24 float rounding, and the byte plane split and merge of each
+ * line, in scalar and SSE2 versions. These live in a header of their
+ * own so that the tests can check the two versions against each other.
+ */
+
+#include "openexr_errors.h"
+
+#include "internal_xdr.h"
+
+#if defined(__SSE2__) || (defined(_MSC_VER) && defined(_M_X64))
+#    define PXR24_HAVE_SSE2 1
+#    include <emmintrin.h>
+#endif
+
+/**************************************/
+
+static inline uint32_t
+float_to_float24 (float f)
+{
+    union
+    {
+        float    f;
+        uint32_t i;
+    } u;
+    uint32_t s, e, m, i;
+
+    u.f = f;
+
+    //
+    // Disassemble the 32-bit floating point number, f,
+    // into sign, s, exponent, e, and significand, m.
+    //
+
+    s = u.i & 0x80000000;
+    e = u.i & 0x7f800000;
+    m = u.i & 0x007fffff;
+
+    if (e == 0x7f800000)
+    {
+        if (m)
+        {
+            //
+            // F is a NAN; we preserve the sign bit and
+            // the 15 leftmost bits of the significand,
+            // with one exception: If the 15 leftmost
+            // bits are all zero, the NAN would turn
+            // into an infinity, so we have to set at
+            // least one bit in the significand.
+            //
+
+            m >>= 8;
+            i = (e >> 8) | m | (m == 0);
+        }
+        else
+        {
+            //
+            // F is an infinity.
+            //
+
+            i = e >> 8;
+        }
+    }
+    else
+    {
+        //
+        // F is finite, round the significand to 15 bits.
+        //
+
+        i = ((e | m) + (m & 0x00000080)) >> 8;
+
+        if (i >= 0x7f8000)
+        {
+            //
+            // F was close to FLT_MAX, and the significand was
+            // rounded up, resulting in an exponent overflow.
+            // Avoid the overflow by truncating the significand
+            // instead of rounding it.
+            //
+
+            i = (e | m) >> 8;
+        }
+    }
+
+    return (s >> 8) | i;
+}
+
+/**************************************/
+
+/*
+ * Each line of a channel is stored as the byte planes (most
+ * significant first) of the differences between adjacent pixels. The
+ * SSE2 kernels do 16 pixels per iteration, and the scalar loops (the
+ * *_rest functions) finish the line. x86 is little endian, so the
+ * kernels load and store pixels directly.
+ */
+
+static inline void
+split_uint_rest (
+    const uint8_t* in, int w, uint8_t* out, int x, uint32_t prevPixel)
+{
+    uint8_t* ptr[4] = {out, out + w, out + 2 * w, out + 3 * w};
+
+    for (; x < w; ++x)
+    {
+        uint32_t pixel = unaligned_load32 (in + 4 * x);
+        uint32_t diff  = pixel - prevPixel;
+        prevPixel      = pixel;
+
+        ptr[0][x] = (uint8_t) (diff >> 24);
+        ptr[1][x] = (uint8_t) (diff >> 16);
+        ptr[2][x] = (uint8_t) (diff >> 8);
+        ptr[3][x] = (uint8_t) (diff);
+    }
+}
+
+static inline void
+split_half_rest (
+    const uint8_t* in, int w, uint8_t* out, int x, uint32_t prevPixel)
+{
+    uint8_t* ptr[2] = {out, out + w};
+
+    for (; x < w; ++x)
+    {
+        uint32_t pixel = (uint32_t) unaligned_load16 (in + 2 * x);
+        uint32_t diff  = pixel - prevPixel;
+        prevPixel      = pixel;
+
+        ptr[0][x] = (uint8_t) (diff >> 8);
+        ptr[1][x] = (uint8_t) (diff);
+    }
+}
+
+static inline void
+split_float_rest (
+    const uint8_t* in, int w, uint8_t* out, int x, uint32_t prevPixel)
+{
+    uint8_t* ptr[3] = {out, out + w, out + 2 * w};
+
+    for (; x < w; ++x)
+    {
+        union
+        {
+            uint32_t i;
+            float    f;
+        } v;
+        uint32_t pixel24, diff;
+        v.i       = unaligned_load32 (in + 4 * x);
+        pixel24   = float_to_float24 (v.f);
+        diff      = pixel24 - prevPixel;
+        prevPixel = pixel24;
+
+        ptr[0][x] = (uint8_t) (diff >> 16);
+        ptr[1][x] = (uint8_t) (diff >> 8);
+        ptr[2][x] = (uint8_t) (diff);
+    }
+}
+
+static inline void
+merge_uint_rest (
+    const uint8_t* in, int w, uint8_t* out, int x, uint32_t pixel)
+{
+    const uint8_t* ptr[4] = {in, in + w, in + 2 * w, in + 3 * w};
+
+    for (; x < w; ++x)
+    {
+        uint32_t diff =
+            (((uint32_t) (ptr[0][x]) << 24) | ((uint32_t) (ptr[1][x]) << 16) |
+             ((uint32_t) (ptr[2][x]) << 8) | ((uint32_t) (ptr[3][x])));
+        pixel += diff;
+        unaligned_store32 (out + 4 * x, pixel);
+    }
+}
+
+static inline void
+merge_half_rest (
+    const uint8_t* in, int w, uint8_t* out, int x, uint32_t pixel)
+{
+    const uint8_t* ptr[2] = {in, in + w};
+
+    for (; x < w; ++x)
+    {
+        uint32_t diff =
+            (((uint32_t) (ptr[0][x]) << 8) | ((uint32_t) (ptr[1][x])));
+        pixel += diff;
+        unaligned_store16 (out + 2 * x, (uint16_t) pixel);
+    }
+}
+
+static inline void
+merge_float_rest (
+    const uint8_t* in, int w, uint8_t* out, int x, uint32_t pixel)
+{
+    const uint8_t* ptr[3] = {in, in + w, in + 2 * w};
+
+    for (; x < w; ++x)
+    {
+        uint32_t diff =
+            (((uint32_t) (ptr[0][x]) << 24) | ((uint32_t) (ptr[1][x]) << 16) |
+             ((uint32_t) (ptr[2][x]) << 8));
+        pixel += diff;
+        unaligned_store32 (out + 4 * x, pixel);
+    }
+}
+
+static inline void
+split_uint_scalar (const uint8_t* in, int w, uint8_t* out)
+{
+    split_uint_rest (in, w, out, 0, 0);
+}
+
+static inline void
+split_half_scalar (const uint8_t* in, int w, uint8_t* out)
+{
+    split_half_rest (in, w, out, 0, 0);
+}
+
+static inline void
+split_float_scalar (const uint8_t* in, int w, uint8_t* out)
+{
+    split_float_rest (in, w, out, 0, 0);
+}
+
+static inline void
+merge_uint_scalar (const uint8_t* in, int w, uint8_t* out)
+{
+    merge_uint_rest (in, w, out, 0, 0);
+}
+
+static inline void
+merge_half_scalar (const uint8_t* in, int w, uint8_t* out)
+{
+    merge_half_rest (in, w, out, 0, 0);
+}
+
+static inline void
+merge_float_scalar (const uint8_t* in, int w, uint8_t* out)
+{
+    merge_float_rest (in, w, out, 0, 0);
+}
+
+#ifdef PXR24_HAVE_SSE2
+
+static inline __m128i
+float_to_float24_sse2 (__m128i u)
+{
+    const __m128i expmask = _mm_set1_epi32 (0x7f800000);
+    const __m128i sigmask = _mm_set1_epi32 (0x007fffff);
+
+    __m128i s = _mm_srli_epi32 (
+        _mm_andnot_si128 (_mm_set1_epi32 (0x7fffffff), u), 8);
+    __m128i e      = _mm_and_si128 (u, expmask);
+    __m128i m      = _mm_and_si128 (u, sigmask);
+    __m128i em     = _mm_or_si128 (e, m);
+    __m128i infnan = _mm_cmpeq_epi32 (e, expmask);
+    __m128i fin, nan, trunc;
+
+    // NaNs keep the 15 leftmost bits of the significand, with at
+    // least one bit set
+    nan = _mm_or_si128 (
+        _mm_srli_epi32 (em, 8),
+        _mm_and_si128 (
+            _mm_and_si128 (
+                _mm_cmpgt_epi32 (m, _mm_setzero_si128 ()),
+                _mm_cmpeq_epi32 (_mm_srli_epi32 (m, 8), _mm_setzero_si128 ())),
+            _mm_set1_epi32 (1)));
+
+    // finite values round, unless that overflows the exponent
+    fin = _mm_srli_epi32 (
+        _mm_add_epi32 (em, _mm_and_si128 (m, _mm_set1_epi32 (0x80))), 8);
+    trunc = _mm_cmpgt_epi32 (fin, _mm_set1_epi32 (0x7f7fff));
+    fin   = _mm_or_si128 (
+        _mm_and_si128 (trunc, _mm_srli_epi32 (em, 8)),
+        _mm_andnot_si128 (trunc, fin));
+
+    return _mm_or_si128 (
+        s,
+        _mm_or_si128 (
+            _mm_and_si128 (infnan, nan), _mm_andnot_si128 (infnan, fin)));
+}
+
+/* 16 32-bit differences to the byte plane at shift */
+static inline void
+store_plane32 (uint8_t* out, const __m128i d[4], int shift)
+{
+    const __m128i lo8 = _mm_set1_epi32 (0xff);
+    __m128i       cnt = _mm_cvtsi32_si128 (shift);
+
+    _mm_storeu_si128 (
+        (__m128i*) out,
+        _mm_packus_epi16 (
+            _mm_packs_epi32 (
+                _mm_and_si128 (_mm_srl_epi32 (d[0], cnt), lo8),
+                _mm_and_si128 (_mm_srl_epi32 (d[1], cnt), lo8)),
+            _mm_packs_epi32 (
+                _mm_and_si128 (_mm_srl_epi32 (d[2], cnt), lo8),
+                _mm_and_si128 (_mm_srl_epi32 (d[3], cnt), lo8))));
+}
+
+/* 4 running sums of 32-bit differences, in place */
+static inline __m128i
+prefix_sum32 (__m128i d[4], __m128i carry)
+{
+    for (int k = 0; k < 4; ++k)
+    {
+        d[k] = _mm_add_epi32 (d[k], _mm_slli_si128 (d[k], 4));
+        d[k] = _mm_add_epi32 (d[k], _mm_slli_si128 (d[k], 8));
+        d[k] = _mm_add_epi32 (d[k], carry);
+        carry = _mm_shuffle_epi32 (d[k], 0xff);
+    }
+    return carry;
+}
+
+static inline void
+split_uint_sse2 (const uint8_t* in, int w, uint8_t* out)
+{
+    uint8_t* ptr[4] = {out, out + w, out + 2 * w, out + 3 * w};
+    uint32_t prevPixel = 0;
+    int      x         = 0;
+
+    __m128i prev = _mm_setzero_si128 ();
+
+    for (; x + 16 <= w; x += 16)
+    {
+        __m128i p[4], d[4];
+
+        for (int k = 0; k < 4; ++k)
+        {
+            p[k] = _mm_loadu_si128 ((const __m128i*) (in + 4 * x) + k);
+            d[k] = _mm_sub_epi32 (
+                p[k],
+                _mm_or_si128 (
+                    _mm_slli_si128 (p[k], 4), _mm_srli_si128 (prev, 12)));
+            prev = p[k];
+        }
+        store_plane32 (ptr[0] + x, d, 24);
+        store_plane32 (ptr[1] + x, d, 16);
+        store_plane32 (ptr[2] + x, d, 8);
+        store_plane32 (ptr[3] + x, d, 0);
+    }
+    prevPixel = (uint32_t) _mm_cvtsi128_si32 (_mm_srli_si128 (prev, 12));
+
+    split_uint_rest (in, w, out, x, prevPixel);
+}
+
+static inline void
+split_half_sse2 (const uint8_t* in, int w, uint8_t* out)
+{
+    uint8_t* ptr[2]    = {out, out + w};
+    uint32_t prevPixel = 0;
+    int      x         = 0;
+
+    const __m128i lo8  = _mm_set1_epi16 (0xff);
+    __m128i       prev = _mm_setzero_si128 ();
+
+    for (; x + 16 <= w; x += 16)
+    {
+        __m128i p0 = _mm_loadu_si128 ((const __m128i*) (in + 2 * x));
+        __m128i p1 = _mm_loadu_si128 ((const __m128i*) (in + 2 * x) + 1);
+        __m128i d0 = _mm_sub_epi16 (
+            p0,
+            _mm_or_si128 (_mm_slli_si128 (p0, 2), _mm_srli_si128 (prev, 14)));
+        __m128i d1 = _mm_sub_epi16 (
+            p1, _mm_or_si128 (_mm_slli_si128 (p1, 2), _mm_srli_si128 (p0, 14)));
+        prev = p1;
+
+        _mm_storeu_si128 (
+            (__m128i*) (ptr[0] + x),
+            _mm_packus_epi16 (_mm_srli_epi16 (d0, 8), _mm_srli_epi16 (d1, 8)));
+        _mm_storeu_si128 (
+            (__m128i*) (ptr[1] + x),
+            _mm_packus_epi16 (
+                _mm_and_si128 (d0, lo8), _mm_and_si128 (d1, lo8)));
+    }
+    prevPixel = (uint32_t) _mm_extract_epi16 (prev, 7);
+
+    split_half_rest (in, w, out, x, prevPixel);
+}
+
+static inline void
+split_float_sse2 (const uint8_t* in, int w, uint8_t* out)
+{
+    uint8_t* ptr[3]    = {out, out + w, out + 2 * w};
+    uint32_t prevPixel = 0;
+    int      x         = 0;
+
+    __m128i prev = _mm_setzero_si128 ();
+
+    for (; x + 16 <= w; x += 16)
+    {
+        __m128i p[4], d[4];
+
+        for (int k = 0; k < 4; ++k)
+        {
+            p[k] = float_to_float24_sse2 (
+                _mm_loadu_si128 ((const __m128i*) (in + 4 * x) + k));
+            d[k] = _mm_sub_epi32 (
+                p[k],
+                _mm_or_si128 (
+                    _mm_slli_si128 (p[k], 4), _mm_srli_si128 (prev, 12)));
+            prev = p[k];
+        }
+        store_plane32 (ptr[0] + x, d, 16);
+        store_plane32 (ptr[1] + x, d, 8);
+        store_plane32 (ptr[2] + x, d, 0);
+    }
+    prevPixel = (uint32_t) _mm_cvtsi128_si32 (_mm_srli_si128 (prev, 12));
+
+    split_float_rest (in, w, out, x, prevPixel);
+}
+
+static inline void
+merge_uint_sse2 (const uint8_t* in, int w, uint8_t* out)
+{
+    const uint8_t* ptr[4] = {in, in + w, in + 2 * w, in + 3 * w};
+    uint32_t       pixel  = 0;
+    int            x      = 0;
+
+    __m128i carry = _mm_setzero_si128 ();
+
+    for (; x + 16 <= w; x += 16)
+    {
+        __m128i b0 = _mm_loadu_si128 ((const __m128i*) (ptr[0] + x));
+        __m128i b1 = _mm_loadu_si128 ((const __m128i*) (ptr[1] + x));
+        __m128i b2 = _mm_loadu_si128 ((const __m128i*) (ptr[2] + x));
+        __m128i b3 = _mm_loadu_si128 ((const __m128i*) (ptr[3] + x));
+        __m128i lo = _mm_unpacklo_epi8 (b3, b2);
+        __m128i hi = _mm_unpacklo_epi8 (b1, b0);
+        __m128i d[4];
+
+        d[0] = _mm_unpacklo_epi16 (lo, hi);
+        d[1] = _mm_unpackhi_epi16 (lo, hi);
+        lo   = _mm_unpackhi_epi8 (b3, b2);
+        hi   = _mm_unpackhi_epi8 (b1, b0);
+        d[2] = _mm_unpacklo_epi16 (lo, hi);
+        d[3] = _mm_unpackhi_epi16 (lo, hi);
+
+        carry = prefix_sum32 (d, carry);
+        for (int k = 0; k < 4; ++k)
+            _mm_storeu_si128 ((__m128i*) (out + 4 * x) + k, d[k]);
+    }
+    pixel = (uint32_t) _mm_cvtsi128_si32 (carry);
+
+    merge_uint_rest (in, w, out, x, pixel);
+}
+
+static inline void
+merge_half_sse2 (const uint8_t* in, int w, uint8_t* out)
+{
+    const uint8_t* ptr[2] = {in, in + w};
+    uint32_t       pixel  = 0;
+    int            x      = 0;
+
+    __m128i carry = _mm_setzero_si128 ();
+
+    for (; x + 16 <= w; x += 16)
+    {
+        __m128i b0 = _mm_loadu_si128 ((const __m128i*) (ptr[0] + x));
+        __m128i b1 = _mm_loadu_si128 ((const __m128i*) (ptr[1] + x));
+        __m128i d[2];
+
+        d[0] = _mm_unpacklo_epi8 (b1, b0);
+        d[1] = _mm_unpackhi_epi8 (b1, b0);
+        for (int k = 0; k < 2; ++k)
+        {
+            d[k] = _mm_add_epi16 (d[k], _mm_slli_si128 (d[k], 2));
+            d[k] = _mm_add_epi16 (d[k], _mm_slli_si128 (d[k], 4));
+            d[k] = _mm_add_epi16 (d[k], _mm_slli_si128 (d[k], 8));
+            d[k] = _mm_add_epi16 (d[k], carry);
+            carry = _mm_shufflehi_epi16 (d[k], 0xff);
+            carry = _mm_unpackhi_epi64 (carry, carry);
+            _mm_storeu_si128 ((__m128i*) (out + 2 * x) + k, d[k]);
+        }
+    }
+    pixel = (uint32_t) _mm_extract_epi16 (carry, 0);
+
+    merge_half_rest (in, w, out, x, pixel);
+}
+
+static inline void
+merge_float_sse2 (const uint8_t* in, int w, uint8_t* out)
+{
+    const uint8_t* ptr[3] = {in, in + w, in + 2 * w};
+    uint32_t       pixel  = 0;
+    int            x      = 0;
+
+    __m128i carry = _mm_setzero_si128 ();
+
+    for (; x + 16 <= w; x += 16)
+    {
+        __m128i b0 = _mm_loadu_si128 ((const __m128i*) (ptr[0] + x));
+        __m128i b1 = _mm_loadu_si128 ((const __m128i*) (ptr[1] + x));
+        __m128i b2 = _mm_loadu_si128 ((const __m128i*) (ptr[2] + x));
+        __m128i lo = _mm_unpacklo_epi8 (_mm_setzero_si128 (), b2);
+        __m128i hi = _mm_unpacklo_epi8 (b1, b0);
+        __m128i d[4];
+
+        d[0] = _mm_unpacklo_epi16 (lo, hi);
+        d[1] = _mm_unpackhi_epi16 (lo, hi);
+        lo   = _mm_unpackhi_epi8 (_mm_setzero_si128 (), b2);
+        hi   = _mm_unpackhi_epi8 (b1, b0);
+        d[2] = _mm_unpacklo_epi16 (lo, hi);
+        d[3] = _mm_unpackhi_epi16 (lo, hi);
+
+        carry = prefix_sum32 (d, carry);
+        for (int k = 0; k < 4; ++k)
+            _mm_storeu_si128 ((__m128i*) (out + 4 * x) + k, d[k]);
+    }
+    pixel = (uint32_t) _mm_cvtsi128_si32 (carry);
+
+    merge_float_rest (in, w, out, x, pixel);
+}
+
+#endif /* PXR24_HAVE_SSE2 */
+
+#endif /* OPENEXR_PRIVATE_PXR24_KERNELS_H */
@@ -7,6 +7,7 @@
 #include "internal_decompress.h"
 
 #include "internal_coding.h"
+#include "internal_rle_kernels.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -14,6 +15,26 @@
 #define MIN_RUN_LENGTH 3
 #define MAX_RUN_LENGTH 127
 
+static inline uint64_t
+repeat_length (const int8_t* p, const int8_t* end, uint64_t max)
+{
+#ifdef RLE_HAVE_SSE2
+    return repeat_length_sse2 (p, end, max);
+#else
+    return repeat_length_scalar (p, end, max);
+#endif
+}
+
+static inline uint64_t
+literal_length (const int8_t* p, const int8_t* end, uint64_t max)
+{
+#ifdef RLE_HAVE_SSE2
+    return literal_length_sse2 (p, end, max);
+#else
+    return literal_length_scalar (p, end, max);
+#endif
+}
+
 uint64_t
 internal_rle_compress (
     void* out, uint64_t outbytes, const void* src, uint64_t srcbytes)
@@ -21,42 +42,32 @@ internal_rle_compress (
     int8_t*       cbuf = out;
     const int8_t* runs = src;
     const int8_t* end  = runs + srcbytes;
-    const int8_t* rune = runs + 1;
     uint64_t      outb = 0;
 
     while (runs < end)
     {
-        uint8_t curcount = 0;
-        while (rune < end && *runs == *rune && curcount < MAX_RUN_LENGTH)
-        {
-            ++rune;
-            ++curcount;
-        }
+        uint64_t curcount = repeat_length (runs, end, MAX_RUN_LENGTH);
 
         if (curcount >= (MIN_RUN_LENGTH - 1))
         {
             cbuf[outb++] = (int8_t) curcount;
             cbuf[outb++] = *runs;
 
-            runs = rune;
+            runs += curcount + 1;
         }
         else
         {
             /* incompressible */
+            const int8_t* rune = runs + curcount + 1;
+
             ++curcount;
-            while (rune < end &&
-                   ((rune + 1 >= end || *rune != *(rune + 1)) ||
-                    (rune + 2 >= end || *(rune + 1) != *(rune + 2))) &&
-                   curcount < MAX_RUN_LENGTH)
-            {
-                ++curcount;
-                ++rune;
-            }
+            curcount += literal_length (rune, end, MAX_RUN_LENGTH - curcount);
+
             cbuf[outb++] = (int8_t) (-((int) curcount));
-            while (runs < rune)
-                cbuf[outb++] = *runs++;
+            memcpy (cbuf + outb, runs, curcount);
+            outb += curcount;
+            runs += curcount;
         }
-        ++rune;
         if (outb >= outbytes) break;
     }
     return outb;
@@ -64,32 +75,6 @@ internal_rle_compress (
 
 /**************************************/
 
-static void
-reorder_and_predict (void* scratch, const void* packed, uint64_t packedbytes)
-{
-    int8_t*       t1   = scratch;
-    int8_t*       t2   = t1 + (packedbytes + 1) / 2;
-    const int8_t* in   = packed;
-    const int8_t* stop = in + packedbytes;
-    int           d, p;
-
-    while (in < stop)
-    {
-        *(t1++) = *(in++);
-        if (in < stop) *(t2++) = *(in++);
-    }
-
-    t1   = scratch;
-    stop = t1 + packedbytes;
-    p    = *(t1++);
-    while (t1 < stop)
-    {
-        d     = (int) (*t1) - p + (128 + 256);
-        p     = *t1;
-        *t1++ = (int8_t) (d);
-    }
-}
-
 exr_result_t
 internal_exr_apply_rle (exr_encode_pipeline_t* encode)
 {
@@ -106,7 +91,8 @@ internal_exr_apply_rle (exr_encode_pipeline_t* encode)
         srcb);
     if (rv != EXR_ERR_SUCCESS) return rv;
 
-    reorder_and_predict (encode->scratch_buffer_1, encode->packed_buffer, srcb);
+    internal_zip_deconstruct_bytes (
+        encode->scratch_buffer_1, encode->packed_buffer, srcb);
 
     outb = internal_rle_compress (
         encode->compressed_buffer,
@@ -167,31 +153,6 @@ internal_rle_decompress (
     return outbytes;
 }
 
-static void
-unpredict_and_reorder (void* out, void* scratch, uint64_t packedbytes)
-{
-    int8_t*       t1   = scratch;
-    int8_t*       t2   = t1 + (packedbytes + 1) / 2;
-    int8_t*       s    = out;
-    const int8_t* stop = t1 + packedbytes;
-
-    ++t1;
-    while (t1 < stop)
-    {
-        int d = (int) (t1[-1]) + (int) (t1[0]) - 128;
-        t1[0] = (int8_t) d;
-        ++t1;
-    }
-
-    t1   = scratch;
-    stop = s + packedbytes;
-    while (s < stop)
-    {
-        *(s++) = *(t1++);
-        if (s < stop) *(s++) = *(t2++);
-    }
-}
-
 exr_result_t
 internal_exr_undo_rle (
     exr_decode_pipeline_t* decode,
@@ -222,7 +183,7 @@ internal_exr_undo_rle (
     if (packsz > 0 && unpackb == 0)
         return EXR_ERR_CORRUPT_CHUNK;
 
-    unpredict_and_reorder (out, decode->scratch_buffer_1, unpackb);
+    internal_zip_reconstruct_bytes (out, decode->scratch_buffer_1, unpackb);
 
     decode->bytes_decompressed = unpackb;
 
@@ -0,0 +1,118 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#ifndef OPENEXR_PRIVATE_RLE_KERNELS_H
+#define OPENEXR_PRIVATE_RLE_KERNELS_H
+
+/*
+ * The run and literal scans of the RLE encoder, in scalar and SSE2
+ * versions. These live in a header of their own so that the tests can
+ * check the two versions against each other.
+ */
+
+#include <stdint.h>
+
+#if defined(__SSE2__) || (defined(_MSC_VER) && defined(_M_X64))
+#    define RLE_HAVE_SSE2 1
+#    include <emmintrin.h>
+#    ifdef _MSC_VER
+#        include <intrin.h>
+#    endif
+#endif
+
+/**************************************/
+
+/* how many of the (at most max) bytes following p repeat *p */
+static inline uint64_t
+repeat_length_scalar (const int8_t* p, const int8_t* end, uint64_t max)
+{
+    uint64_t n = 0;
+
+    while (n < max && p + 1 + n < end && p[1 + n] == *p)
+        ++n;
+    return n;
+}
+
+/* how many of the (at most max) bytes from p on can be taken before
+ * reaching one which starts a run worth encoding */
+static inline uint64_t
+literal_length_scalar (const int8_t* p, const int8_t* end, uint64_t max)
+{
+    uint64_t n = 0;
+
+    while (n < max && p + n < end &&
+           !(p + n + 2 < end && p[n] == p[n + 1] && p[n + 1] == p[n + 2]))
+        ++n;
+    return n;
+}
+
+#ifdef RLE_HAVE_SSE2
+
+static inline uint64_t
+first_set_bit (uint32_t m)
+{
+#    ifdef _MSC_VER
+    unsigned long r;
+    _BitScanForward (&r, m);
+    return r;
+#    else
+    return (uint64_t) __builtin_ctz (m);
+#    endif
+}
+
+static inline uint64_t
+repeat_length_sse2 (const int8_t* p, const int8_t* end, uint64_t max)
+{
+    const __m128i v = _mm_set1_epi8 (*p);
+    uint64_t      n = 0;
+
+    while (n < max && (uint64_t) (end - p) > n + 16)
+    {
+        __m128i  d = _mm_loadu_si128 ((const __m128i*) (p + 1 + n));
+        uint32_t m = (uint32_t) _mm_movemask_epi8 (_mm_cmpeq_epi8 (d, v));
+        if (m != 0xffff)
+        {
+            n += first_set_bit (~m);
+            return n < max ? n : max;
+        }
+        n += 16;
+    }
+    if (n > max) n = max;
+
+    while (n < max && p + 1 + n < end && p[1 + n] == *p)
+        ++n;
+    return n;
+}
+
+static inline uint64_t
+literal_length_sse2 (const int8_t* p, const int8_t* end, uint64_t max)
+{
+    uint64_t n = 0;
+
+    while (n < max && (uint64_t) (end - p) >= n + 18)
+    {
+        __m128i  a = _mm_loadu_si128 ((const __m128i*) (p + n));
+        __m128i  b = _mm_loadu_si128 ((const __m128i*) (p + n + 1));
+        __m128i  c = _mm_loadu_si128 ((const __m128i*) (p + n + 2));
+        uint32_t m = (uint32_t) _mm_movemask_epi8 (
+            _mm_and_si128 (_mm_cmpeq_epi8 (a, b), _mm_cmpeq_epi8 (b, c)));
+        if (m)
+        {
+            n += first_set_bit (m);
+            return n < max ? n : max;
+        }
+        n += 16;
+    }
+    if (n > max) n = max;
+
+    while (n < max && p + n < end &&
+           !(p + n + 2 < end && p[n] == p[n + 1] && p[n + 1] == p[n + 2]))
+        ++n;
+    return n;
+}
+
+#endif /* RLE_HAVE_SSE2 */
+
+#endif /* OPENEXR_PRIVATE_RLE_KERNELS_H */
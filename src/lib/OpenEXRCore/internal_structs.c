@@ -6,6 +6,7 @@
 #include "openexr_config.h"
 #include "internal_structs.h"
 #include "internal_attr.h"
+#include "internal_buffer_pool.h"
 #include "internal_constants.h"
 #include "internal_memory.h"
 
@@ -397,8 +398,9 @@ internal_exr_alloc_context (
         ret->legacy_header =
             (initializers->flags & EXR_CONTEXT_FLAG_WRITE_LEGACY_HEADER);
 
-        ret->file_size       = -1;
-        ret->max_name_length = EXR_SHORTNAME_MAXLEN;
+        ret->file_size        = -1;
+        ret->header_read_size = (uint64_t) initializers->header_read_size;
+        ret->max_name_length  = EXR_SHORTNAME_MAXLEN;
 
         ret->destroy_fn = initializers->destroy_fn;
         ret->read_fn    = initializers->read_fn;
@@ -419,6 +421,27 @@ internal_exr_alloc_context (
 #    endif
 #endif
 
+        rv = internal_exr_buffer_pool_init (
+            &(ret->builtin_pool),
+            initializers->alloc_fn,
+            initializers->free_fn,
+            EXR_DEFAULT_BUFFER_POOL_BYTES);
+        if (rv != EXR_ERR_SUCCESS)
+        {
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+            DeleteCriticalSection (&(ret->mutex));
+#    else
+            pthread_mutex_destroy (&(ret->mutex));
+#    endif
+#endif
+            (initializers->free_fn) (memptr);
+            *out = NULL;
+            return rv;
+        }
+        ret->builtin_pool.is_builtin = 1;
+        ret->buffer_pool             = &(ret->builtin_pool);
+
         *out = ret;
         rv   = EXR_ERR_SUCCESS;
 
@@ -461,6 +484,7 @@ internal_exr_destroy_context (exr_context_t ctxt)
     exr_attr_string_destroy (ctxt, &(ctxt->tmp_filename));
     exr_attr_list_destroy (ctxt, &(ctxt->custom_handlers));
     internal_exr_destroy_parts (ctxt);
+    internal_exr_buffer_pool_destroy (&(ctxt->builtin_pool));
 #ifdef ILMTHREAD_THREADING_ENABLED
 #    ifdef _WIN32
     DeleteCriticalSection (&(ctxt->mutex));
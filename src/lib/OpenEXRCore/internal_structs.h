@@ -161,6 +161,53 @@ enum _INTERNAL_EXR_CONTEXT_MODE
     EXR_CONTEXT_WRITE_FINISHED
 };
 
+/* 4 size classes per power of two, from 4 KiB up to 1 TiB */
+#define EXR_BUFFER_POOL_MIN_SHIFT 12
+#define EXR_BUFFER_POOL_CLASSES ((40 - EXR_BUFFER_POOL_MIN_SHIFT) * 4)
+
+/* when a buffer is sitting in the pool, the start of it is reused to
+ * hold the free list link, so there is no per-buffer bookkeeping */
+typedef struct _internal_exr_pool_block
+{
+    struct _internal_exr_pool_block* next;
+    size_t                           size;
+} internal_exr_pool_block_t;
+
+/* idle zlib (de)compressor states kept by a pool. These are fairly
+ * large and are otherwise allocated (and zeroed) for every chunk */
+#define EXR_BUFFER_POOL_DEFLATE_STATES 16
+
+struct libdeflate_compressor;
+struct libdeflate_decompressor;
+
+struct _priv_exr_buffer_pool_t
+{
+    exr_memory_allocation_func_t alloc_fn;
+    exr_memory_free_func_t       free_fn;
+
+    size_t max_bytes;
+    size_t cached_bytes;
+
+    internal_exr_pool_block_t* free_lists[EXR_BUFFER_POOL_CLASSES];
+
+    struct libdeflate_compressor* compressors[EXR_BUFFER_POOL_DEFLATE_STATES];
+    int compressor_levels[EXR_BUFFER_POOL_DEFLATE_STATES];
+    int num_compressors;
+    struct libdeflate_decompressor*
+        decompressors[EXR_BUFFER_POOL_DEFLATE_STATES];
+    int num_decompressors;
+
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    CRITICAL_SECTION mutex;
+#    else
+    pthread_mutex_t mutex;
+#    endif
+#endif
+    /* the pool embedded in a context can not be destroyed by the user */
+    uint8_t is_builtin;
+};
+
 struct _priv_exr_context_t
 {
     uint8_t mode;
@@ -214,6 +261,12 @@ struct _priv_exr_context_t
 
     int64_t             file_size;
     exr_read_func_ptr_t read_fn;
+    /* initial read size when parsing the header, 0 for the default */
+    uint64_t            header_read_size;
+    /* header bytes from an index entry, served in place of reads
+     * from the file while the header is parsed */
+    const uint8_t* header_cache;
+    uint64_t       header_cache_size;
 
     exr_write_func_ptr_t write_fn;
     /* used when writing under a mutex, is there a better way? */
@@ -245,6 +298,11 @@ struct _priv_exr_context_t
     uint8_t legacy_header;
     uint8_t _pad[2];
     uint32_t orig_version_and_flags;
+
+    /* scratch memory for the decode / encode pipelines, by default
+     * points to builtin_pool, but may be shared between contexts */
+    struct _priv_exr_buffer_pool_t* buffer_pool;
+    struct _priv_exr_buffer_pool_t  builtin_pool;
 };
 
 #define EXR_CONST_CAST(t, v) ((t) (uintptr_t) v)
@@ -340,6 +398,17 @@ exr_result_t internal_exr_add_part (
 void internal_exr_revert_add_part (
     exr_context_t ctxt, exr_priv_part_t* outpart, int* new_index);
 
+/** Installs a copy of @p count chunk offsets as the chunk table of the
+ * part, failing if it already has one. When @p file_order is set, the
+ * offsets are in file (little endian) byte order and need not be
+ * aligned */
+exr_result_t internal_exr_set_chunk_table (
+    exr_context_t         ctxt,
+    exr_const_priv_part_t part,
+    const void*           table,
+    int32_t               count,
+    int                   file_order);
+
 exr_result_t
 internal_exr_context_restore_handlers (exr_context_t ctxt, exr_result_t rv);
 
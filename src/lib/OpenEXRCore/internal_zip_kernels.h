@@ -0,0 +1,419 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#ifndef OPENEXR_PRIVATE_ZIP_KERNELS_H
+#define OPENEXR_PRIVATE_ZIP_KERNELS_H
+
+/*
+ * The byte reorder and predictor shared by ZIP, RLE and DWA, in scalar,
+ * SSE2 and NEON versions. These live in a header of their own so that
+ * the tests can check the versions against each other.
+ */
+
+#include <stdint.h>
+
+#if defined __SSE2__ || (_MSC_VER >= 1300 && (_M_IX86 || _M_X64))
+#    define ZIP_HAVE_SSE2 1
+#    include <emmintrin.h>
+#    include <mmintrin.h>
+#endif
+#if defined __SSE4_1__ || (_MSC_VER >= 1300 && (_M_IX86 || _M_X64))
+#    define ZIP_HAVE_SSE4_1 1
+#    include <smmintrin.h>
+#endif
+#if defined(__aarch64__)
+#    define ZIP_HAVE_NEON_AARCH64 1
+#    include <arm_neon.h>
+#endif
+
+/**************************************/
+
+static inline void
+reconstruct_scalar (uint8_t* buf, const uint64_t sz)
+{
+    uint8_t* t    = buf + 1;
+    uint8_t* stop = buf + sz;
+    while (t < stop)
+    {
+        int d = (int) (t[-1]) + (int) (t[0]) - 128;
+        t[0]  = (uint8_t) d;
+        ++t;
+    }
+}
+
+#ifdef ZIP_HAVE_SSE2
+
+static inline void
+reconstruct_sse2 (uint8_t* buf, const uint64_t outSize)
+{
+    static const uint64_t bytesPerChunk = sizeof (__m128i);
+    const uint64_t        vOutSize      = outSize / bytesPerChunk;
+    const __m128i         c             = _mm_set1_epi8 (-128);
+#    ifdef ZIP_HAVE_SSE4_1
+    const __m128i shuffleMask = _mm_set1_epi8 (15);
+#    endif
+    __m128i *vBuf, vPrev;
+    uint8_t               prev;
+
+    /*
+     * The first element doesn't have its high bit flipped during compression,
+     * so it must not be flipped here.  To make the SIMD loop nice and
+     * uniform, we pre-flip the bit so that the loop will unflip it again.
+     */
+    buf[0] += -128;
+    vBuf  = (__m128i*) buf;
+    vPrev = _mm_setzero_si128 ();
+
+    for (uint64_t i = 0; i < vOutSize; ++i)
+    {
+        __m128i d = _mm_add_epi8 (_mm_loadu_si128 (vBuf), c);
+
+        /* Compute the prefix sum of elements. */
+        d = _mm_add_epi8 (d, _mm_slli_si128 (d, 1));
+        d = _mm_add_epi8 (d, _mm_slli_si128 (d, 2));
+        d = _mm_add_epi8 (d, _mm_slli_si128 (d, 4));
+        d = _mm_add_epi8 (d, _mm_slli_si128 (d, 8));
+        d = _mm_add_epi8 (d, vPrev);
+
+        _mm_storeu_si128 (vBuf++, d);
+
+        // Broadcast the high byte in our result to all lanes of the prev
+        // value for the next iteration.
+#    ifdef ZIP_HAVE_SSE4_1
+        vPrev = _mm_shuffle_epi8 (d, shuffleMask);
+#    else
+        vPrev = _mm_unpackhi_epi8 (d, d);
+        vPrev = _mm_shufflehi_epi16 (vPrev, 0xff);
+        vPrev = _mm_shuffle_epi32 (vPrev, 0xff);
+#    endif
+    }
+
+    prev = (uint8_t) _mm_cvtsi128_si32 (vPrev);
+    for (uint64_t i = vOutSize * bytesPerChunk; i < outSize; ++i)
+    {
+        uint8_t d = prev + buf[i] - 128;
+        buf[i]    = d;
+        prev      = d;
+    }
+}
+
+#endif /* ZIP_HAVE_SSE2 */
+
+#ifdef ZIP_HAVE_NEON_AARCH64
+
+static inline void
+reconstruct_neon (uint8_t* buf, const uint64_t outSize)
+{
+    static const uint64_t bytesPerChunk = sizeof (uint8x16_t);
+    const uint64_t        vOutSize      = outSize / bytesPerChunk;
+    const uint8x16_t      c             = vdupq_n_u8 (-128);
+    const uint8x16_t      shuffleMask   = vdupq_n_u8 (15);
+    const uint8x16_t      zero          = vdupq_n_u8 (0);
+    uint8_t*              vBuf;
+    uint8x16_t            vPrev;
+    uint8_t               prev;
+
+    /*
+     * The first element doesn't have its high bit flipped during compression,
+     * so it must not be flipped here.  To make the SIMD loop nice and
+     * uniform, we pre-flip the bit so that the loop will unflip it again.
+     */
+    buf[0] += -128;
+    vBuf  = buf;
+    vPrev = vdupq_n_u8 (0);
+
+    for (uint64_t i = 0; i < vOutSize; ++i)
+    {
+        uint8x16_t d = vaddq_u8 (vld1q_u8 (vBuf), c);
+
+        /* Compute the prefix sum of elements. */
+        d = vaddq_u8 (d, vextq_u8 (zero, d, 16 - 1));
+        d = vaddq_u8 (d, vextq_u8 (zero, d, 16 - 2));
+        d = vaddq_u8 (d, vextq_u8 (zero, d, 16 - 4));
+        d = vaddq_u8 (d, vextq_u8 (zero, d, 16 - 8));
+        d = vaddq_u8 (d, vPrev);
+
+        vst1q_u8 (vBuf, d);
+        vBuf += sizeof (uint8x16_t);
+
+        // Broadcast the high byte in our result to all lanes of the prev
+        // value for the next iteration.
+        vPrev = vqtbl1q_u8 (d, shuffleMask);
+    }
+
+    prev = vgetq_lane_u8 (vPrev, 15);
+    for (uint64_t i = vOutSize * bytesPerChunk; i < outSize; ++i)
+    {
+        uint8_t d = prev + buf[i] - 128;
+        buf[i]    = d;
+        prev      = d;
+    }
+}
+
+#endif /* ZIP_HAVE_NEON_AARCH64 */
+
+/**************************************/
+
+static inline void
+interleave_scalar (
+    uint8_t* out, const uint8_t* const source, const uint64_t outSize)
+{
+    const uint8_t* t1   = source;
+    const uint8_t* t2   = source + (outSize + 1) / 2;
+    uint8_t*       s    = out;
+    uint8_t* const stop = s + outSize;
+
+    while (1)
+    {
+        if (s < stop)
+            *(s++) = *(t1++);
+        else
+            break;
+
+        if (s < stop)
+            *(s++) = *(t2++);
+        else
+            break;
+    }
+}
+
+#ifdef ZIP_HAVE_SSE2
+
+static inline void
+interleave_sse2 (
+    uint8_t* out, const uint8_t* const source, const uint64_t outSize)
+{
+    static const uint64_t bytesPerChunk = 2 * sizeof (__m128i);
+    const uint64_t        vOutSize      = outSize / bytesPerChunk;
+    const __m128i*        v1            = (const __m128i*) source;
+    const __m128i*        v2   = (const __m128i*) (source + (outSize + 1) / 2);
+    __m128i*              vOut = (__m128i*) out;
+    const uint8_t *       t1, *t2;
+    uint8_t*              sOut;
+
+    for (uint64_t i = 0; i < vOutSize; ++i)
+    {
+        __m128i a  = _mm_loadu_si128 (v1++);
+        __m128i b  = _mm_loadu_si128 (v2++);
+        __m128i lo = _mm_unpacklo_epi8 (a, b);
+        __m128i hi = _mm_unpackhi_epi8 (a, b);
+
+        _mm_storeu_si128 (vOut++, lo);
+        _mm_storeu_si128 (vOut++, hi);
+    }
+
+    t1   = (const uint8_t*) v1;
+    t2   = (const uint8_t*) v2;
+    sOut = (uint8_t*) vOut;
+
+    for (uint64_t i = vOutSize * bytesPerChunk; i < outSize; ++i)
+        *(sOut++) = (i % 2 == 0) ? *(t1++) : *(t2++);
+}
+
+#endif /* ZIP_HAVE_SSE2 */
+
+#ifdef ZIP_HAVE_NEON_AARCH64
+
+static inline void
+interleave_neon (
+    uint8_t* out, const uint8_t* const source, const uint64_t outSize)
+{
+    static const uint64_t bytesPerChunk = 2 * sizeof (uint8x16_t);
+    const uint64_t        vOutSize      = outSize / bytesPerChunk;
+    const uint8_t*        v1            = source;
+    const uint8_t*        v2            = source + (outSize + 1) / 2;
+
+    for (uint64_t i = 0; i < vOutSize; ++i)
+    {
+        uint8x16_t a = vld1q_u8 (v1);
+        v1 += sizeof (uint8x16_t);
+        uint8x16_t b = vld1q_u8 (v2);
+        v2 += sizeof (uint8x16_t);
+        uint8x16_t lo = vzip1q_u8 (a, b);
+        uint8x16_t hi = vzip2q_u8 (a, b);
+
+        vst1q_u8 (out, lo);
+        out += sizeof (uint8x16_t);
+        vst1q_u8 (out, hi);
+        out += sizeof (uint8x16_t);
+    }
+
+    for (uint64_t i = vOutSize * bytesPerChunk; i < outSize; ++i)
+        *(out++) = (i % 2 == 0) ? *(v1++) : *(v2++);
+}
+
+#endif /* ZIP_HAVE_NEON_AARCH64 */
+
+/**************************************/
+
+/*
+ * The encode side splits the even and odd bytes into the two halves
+ * of scratch, then replaces each byte with the difference to the one
+ * before it, running across both halves as if they were one buffer.
+ * The SIMD versions do both in a single pass, which means the second
+ * half has to be seeded with the last byte of the first half.
+ */
+
+static inline void
+deconstruct_scalar (
+    uint8_t* scratch, const uint8_t* source, const uint64_t count)
+{
+    int                  p;
+    uint8_t*             t1   = scratch;
+    uint8_t*             t2   = t1 + (count + 1) / 2;
+    const uint8_t*       raw  = source;
+    const uint8_t* const stop = raw + count;
+
+    /* reorder */
+    while (raw < stop)
+    {
+        *(t1++) = *(raw++);
+        if (raw < stop) *(t2++) = *(raw++);
+    }
+
+    /* predict */
+    t1 = scratch;
+    t2 = t1 + count;
+    t1++;
+    p = (int) t1[-1];
+    while (t1 < t2)
+    {
+        int d = (int) (t1[0]) - p + (128 + 256);
+        p     = (int) t1[0];
+        t1[0] = (uint8_t) d;
+        ++t1;
+    }
+}
+
+#ifdef ZIP_HAVE_SSE2
+
+static inline void
+deconstruct_sse2 (
+    uint8_t* scratch, const uint8_t* source, const uint64_t count)
+{
+    static const uint64_t bytesPerChunk = 2 * sizeof (__m128i);
+    const uint64_t        vCount        = count / bytesPerChunk;
+    const uint64_t        half          = (count + 1) / 2;
+    const __m128i         c             = _mm_set1_epi8 (-128);
+    const __m128i         lowMask       = _mm_set1_epi16 (0xff);
+    __m128i*              v1            = (__m128i*) scratch;
+    __m128i*              v2            = (__m128i*) (scratch + half);
+    const __m128i*        vIn           = (const __m128i*) source;
+    __m128i               prev1, prev2;
+    uint8_t *             t1, *t2;
+    int                   p1, p2;
+
+    if (count == 0) return;
+
+    /* the first byte is stored as is, which is the same as predicting
+     * it from 128 */
+    prev1 = _mm_slli_si128 (_mm_cvtsi32_si128 (128), 15);
+    prev2 = _mm_slli_si128 (_mm_cvtsi32_si128 (source[2 * (half - 1)]), 15);
+
+    for (uint64_t i = 0; i < vCount; ++i)
+    {
+        __m128i lo = _mm_loadu_si128 (vIn++);
+        __m128i hi = _mm_loadu_si128 (vIn++);
+        __m128i a  = _mm_packus_epi16 (
+            _mm_and_si128 (lo, lowMask), _mm_and_si128 (hi, lowMask));
+        __m128i b = _mm_packus_epi16 (
+            _mm_srli_epi16 (lo, 8), _mm_srli_epi16 (hi, 8));
+
+        /* shift the last byte of the previous block in front */
+        __m128i pa =
+            _mm_or_si128 (_mm_slli_si128 (a, 1), _mm_srli_si128 (prev1, 15));
+        __m128i pb =
+            _mm_or_si128 (_mm_slli_si128 (b, 1), _mm_srli_si128 (prev2, 15));
+
+        _mm_storeu_si128 (v1++, _mm_add_epi8 (_mm_sub_epi8 (a, pa), c));
+        _mm_storeu_si128 (v2++, _mm_add_epi8 (_mm_sub_epi8 (b, pb), c));
+
+        prev1 = a;
+        prev2 = b;
+    }
+
+    p1 = (uint8_t) _mm_cvtsi128_si32 (_mm_srli_si128 (prev1, 15));
+    p2 = (uint8_t) _mm_cvtsi128_si32 (_mm_srli_si128 (prev2, 15));
+    t1 = (uint8_t*) v1;
+    t2 = (uint8_t*) v2;
+    for (uint64_t i = vCount * bytesPerChunk; i < count; ++i)
+    {
+        int v = (int) source[i];
+        if (i % 2 == 0)
+        {
+            *(t1++) = (uint8_t) (v - p1 + (128 + 256));
+            p1      = v;
+        }
+        else
+        {
+            *(t2++) = (uint8_t) (v - p2 + (128 + 256));
+            p2      = v;
+        }
+    }
+}
+
+#endif /* ZIP_HAVE_SSE2 */
+
+#ifdef ZIP_HAVE_NEON_AARCH64
+
+static inline void
+deconstruct_neon (
+    uint8_t* scratch, const uint8_t* source, const uint64_t count)
+{
+    static const uint64_t bytesPerChunk = 2 * sizeof (uint8x16_t);
+    const uint64_t        vCount        = count / bytesPerChunk;
+    const uint64_t        half          = (count + 1) / 2;
+    const uint8x16_t      c             = vdupq_n_u8 (-128);
+    uint8_t*              t1            = scratch;
+    uint8_t*              t2            = scratch + half;
+    uint8x16_t            prev1, prev2;
+    int                   p1, p2;
+
+    if (count == 0) return;
+
+    /* the first byte is stored as is, which is the same as predicting
+     * it from 128 */
+    prev1 = vdupq_n_u8 (128);
+    prev2 = vdupq_n_u8 (source[2 * (half - 1)]);
+
+    for (uint64_t i = 0; i < vCount; ++i)
+    {
+        uint8x16x2_t ab = vld2q_u8 (source);
+        source += bytesPerChunk;
+
+        /* shift the last byte of the previous block in front */
+        uint8x16_t pa = vextq_u8 (prev1, ab.val[0], 16 - 1);
+        uint8x16_t pb = vextq_u8 (prev2, ab.val[1], 16 - 1);
+
+        vst1q_u8 (t1, vaddq_u8 (vsubq_u8 (ab.val[0], pa), c));
+        t1 += sizeof (uint8x16_t);
+        vst1q_u8 (t2, vaddq_u8 (vsubq_u8 (ab.val[1], pb), c));
+        t2 += sizeof (uint8x16_t);
+
+        prev1 = ab.val[0];
+        prev2 = ab.val[1];
+    }
+
+    p1 = vgetq_lane_u8 (prev1, 15);
+    p2 = vgetq_lane_u8 (prev2, 15);
+    for (uint64_t i = vCount * bytesPerChunk; i < count; ++i)
+    {
+        int v = (int) *(source++);
+        if (i % 2 == 0)
+        {
+            *(t1++) = (uint8_t) (v - p1 + (128 + 256));
+            p1      = v;
+        }
+        else
+        {
+            *(t2++) = (uint8_t) (v - p2 + (128 + 256));
+            p2      = v;
+        }
+    }
+}
+
+#endif /* ZIP_HAVE_NEON_AARCH64 */
+
+#endif /* OPENEXR_PRIVATE_ZIP_KERNELS_H */
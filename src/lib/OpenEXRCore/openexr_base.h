@@ -194,6 +194,37 @@ EXR_EXPORT void exr_set_default_memory_routines (
 
 /** @} */
 
+/**
+ * @defgroup TaskSpawning Allows the parallel helpers to use an external thread pool
+ * @{
+ */
+
+/** @brief Function pointer for a unit of work created by one of the
+ * parallel helper routines (e.g. exr_decode_part_parallel()).
+ */
+typedef void (*exr_task_fn_t) (void* task_data);
+
+/** @brief Function pointer used to hand a unit of work to a
+ * caller-controlled thread pool.
+ *
+ * The implementation must arrange for @p fn to be called exactly once
+ * with @p task_data, on any thread. The library waits for all the
+ * tasks it spawned before returning to the caller, so the tasks must
+ * be able to make progress while the spawning thread is blocked.
+ *
+ * Return 0 if the task was scheduled. Any other value indicates the
+ * task could not be scheduled, in which case the library will run it
+ * on the calling thread.
+ *
+ * If no spawn function is provided, the library uses a simple
+ * built-in fallback which creates (and joins) native threads for
+ * the duration of the call.
+ */
+typedef int (*exr_task_spawn_fn_t) (
+    void* spawn_user_data, exr_task_fn_t fn, void* task_data);
+
+/** @} */
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
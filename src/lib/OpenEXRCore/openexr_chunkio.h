@@ -188,6 +188,31 @@ exr_result_t exr_write_deep_tile_chunk (
     const void*   sample_data,
     uint64_t      sample_data_size);
 
+/**************************************/
+
+/** Copy all the chunks of a part from a file opened for reading to a
+ * part of a file being written, without decompressing them.
+ *
+ * The header of @p ctxt must have been written, and @p part_index
+ * must be the next part to be written with no chunks written to it
+ * yet. The destination part must match the source part's storage
+ * type, compression, data window, channels and tile description
+ * (for example, by initializing it with \c exr_copy_unset_attributes
+ * from the source part). Other attributes, such as the part name or
+ * view, may differ.
+ *
+ * Chunks are written in chunk table order. Runs of chunks that are
+ * adjacent in the source file are read with a single large read, so
+ * combining or splitting multi-part files streams through the data
+ * with few, sequential I/O calls.
+ */
+EXR_EXPORT
+exr_result_t exr_copy_chunks (
+    exr_context_t       ctxt,
+    int                 part_index,
+    exr_const_context_t source,
+    int                 src_part_index);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -190,7 +190,7 @@ typedef int64_t (*exr_write_func_ptr_t) (
  * \endcode
  *
  */
-typedef struct _exr_context_initializer_v3
+typedef struct _exr_context_initializer_v4
 {
     /** @brief Size member to tag initializer for version stability.
      *
@@ -324,6 +324,18 @@ typedef struct _exr_context_initializer_v3
     int flags;
 
     uint8_t pad[4];
+
+    /** Initialize the size in bytes of the first read made when
+     * parsing the header of a file opened for reading.
+     *
+     * If 0 (the default), 64 KiB is used. The read is capped at the
+     * size of the file, and if the header extends past it, each
+     * further read doubles in size, up to 1 MiB or this value,
+     * whichever is larger. Metadata scanners reading files with large
+     * headers (ID manifests, many parts) from high latency storage
+     * can set this to read the whole header with a single request.
+     */
+    size_t header_read_size;
 } exr_context_initializer_t;
 
 /** @brief context flag which will enforce strict header validation
@@ -353,7 +365,7 @@ typedef struct _exr_context_initializer_v3
 /* clang-format off */
 /** @brief Simple macro to initialize the context initializer with default values. */
 #define EXR_DEFAULT_CONTEXT_INITIALIZER                                        \
-    { sizeof (exr_context_initializer_t), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -2, -1.f, 0, { 0, 0, 0, 0 } }
+    { sizeof (exr_context_initializer_t), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -2, -1.f, 0, { 0, 0, 0, 0 }, 0 }
 /* clang-format on */
 
 /** @} */ /* context function pointer declarations */
@@ -411,6 +423,78 @@ EXR_EXPORT exr_result_t exr_start_read (
     const char*                      filename,
     const exr_context_initializer_t* ctxtdata);
 
+/** @brief Serialize the header and chunk tables of a file opened for
+ * read into an index entry.
+ *
+ * An index entry holds the raw header bytes of the file, its size,
+ * and the chunk offset table of every part (loading or reconstructing
+ * them if that has not happened yet). Passing the entry to
+ * exr_start_read_indexed() later opens the file without reading any
+ * of that metadata from it again, which makes re-opening frames of
+ * long sequences on high latency storage much cheaper.
+ *
+ * If @p buffer is `NULL`, only the required size is returned in @p
+ * size. Otherwise @p size must hold the size of @p buffer on input,
+ * and returns the number of bytes written.
+ */
+EXR_EXPORT exr_result_t
+exr_get_index_entry (exr_const_context_t ctxt, void* buffer, size_t* size);
+
+/** @brief Create and initialize a read-only exr context from a
+ * previously stored index entry.
+ *
+ * This behaves like exr_start_read(), except the header is parsed
+ * from the entry and the chunk tables are taken from it, so the only
+ * reads from the file are for chunk data. The entry is not referenced
+ * after this function returns.
+ *
+ * When the size of the file is known, it is compared with the size
+ * recorded in the entry, and `EXR_ERR_FILE_BAD_HEADER` is returned if
+ * they differ, as the entry is likely stale. An entry describing a
+ * different file of the same size can not be detected.
+ */
+EXR_EXPORT exr_result_t exr_start_read_indexed (
+    exr_context_t*                   ctxt,
+    const char*                      filename,
+    const void*                      entry,
+    size_t                           entrysize,
+    const exr_context_initializer_t* ctxtdata);
+
+/** @brief Look up an index entry by name in an index of a sequence.
+ *
+ * An index is a collection of named entries, as written by the
+ * exrindex tool, loaded into memory. It starts with the 4 bytes
+ * "EXRX", a 32-bit version (1) and a 64-bit entry count, followed by
+ * the entries, each a 32-bit name length (including the terminating
+ * nul), 32 bits of zero, the 64-bit entry size, the name, and the
+ * entry, padded to a multiple of 8 bytes. All values are little
+ * endian.
+ *
+ * On success, @p entry points into @p index. Returns
+ * `EXR_ERR_ARGUMENT_OUT_OF_RANGE` if there is no entry of that name,
+ * and `EXR_ERR_FILE_BAD_HEADER` if the index is malformed.
+ */
+EXR_EXPORT exr_result_t exr_find_index_entry (
+    const void*  index,
+    size_t       indexsize,
+    const char*  name,
+    const void** entry,
+    size_t*      entrysize);
+
+/** @brief Retrieve the n-th entry of an index of a sequence.
+ *
+ * See exr_find_index_entry() for the layout of an index. Returns
+ * `EXR_ERR_ARGUMENT_OUT_OF_RANGE` when @p idx is past the last entry,
+ * so this can also be used to iterate over the index.
+ */
+EXR_EXPORT exr_result_t exr_get_index_entry_by_index (
+    const void*  index,
+    size_t       indexsize,
+    int          idx,
+    const char** name,
+    const void** entry,
+    size_t*      entrysize);
+
 /** @brief Enum describing how default files are handled during write. */
 typedef enum exr_default_write_mode
 {
@@ -581,6 +665,87 @@ EXR_EXPORT exr_result_t exr_write_header (exr_context_t ctxt);
 
 /** @} */
 
+/**
+ * @defgroup BufferPool Scratch memory re-use for the coding pipelines
+ *
+ * @brief The decode and encode pipelines allocate a handful of
+ * buffers (packed, unpacked, and compressor scratch memory) per
+ * pipeline. When no custom allocator is provided to the pipeline,
+ * these are borrowed from a buffer pool attached to the context and
+ * returned to it when the pipeline is destroyed, such that pipelines
+ * which are frequently created and destroyed do not hit the system
+ * allocator.
+ *
+ * Each context has a pool of its own, which retains at most 8 MiB.
+ * Idle zlib compressor and decompressor states are kept in the pool
+ * as well, and count against the same limit. To also re-use memory
+ * across contexts (i.e. when reading a sequence of frames), or to
+ * bound the total when many files are open at once, create a pool
+ * and attach it to each context using exr_set_buffer_pool().
+ *
+ * Pools are thread safe.
+ *
+ * @{
+ */
+
+/** Opaque handle to a buffer pool */
+typedef struct _priv_exr_buffer_pool_t* exr_buffer_pool_t;
+
+/** @brief Create a buffer pool which may be shared between contexts.
+ *
+ * At most @p max_bytes of memory will be retained by the pool, any
+ * buffer returned beyond that is freed. A value of 0 disables
+ * retaining any memory.
+ *
+ * If @p alloc_fn or @p free_fn are `NULL`, the global default memory
+ * routines are used. A pool can only be attached to contexts which
+ * were created with the same free routine.
+ */
+EXR_EXPORT exr_result_t exr_buffer_pool_create (
+    exr_buffer_pool_t*           pool,
+    size_t                       max_bytes,
+    exr_memory_allocation_func_t alloc_fn,
+    exr_memory_free_func_t       free_fn);
+
+/** @brief Destroy a pool created with exr_buffer_pool_create(),
+ * freeing any memory it retains.
+ *
+ * All contexts using the pool must be finished (or switched to
+ * another pool) prior to destroying it. The pool attached to a context
+ * by default can not be destroyed.
+ */
+EXR_EXPORT exr_result_t exr_buffer_pool_destroy (exr_buffer_pool_t* pool);
+
+/** @brief Change the maximum amount of memory retained by the pool,
+ * freeing any cached memory beyond the new limit. */
+EXR_EXPORT exr_result_t
+exr_buffer_pool_set_max_bytes (exr_buffer_pool_t pool, size_t max_bytes);
+
+/** @brief Query how many bytes the pool currently retains. */
+EXR_EXPORT exr_result_t
+exr_buffer_pool_get_cached_bytes (exr_buffer_pool_t pool, size_t* bytes);
+
+/** @brief Free all the memory currently retained by the pool. */
+EXR_EXPORT exr_result_t exr_buffer_pool_trim (exr_buffer_pool_t pool);
+
+/** @brief Attach a buffer pool to a context.
+ *
+ * This should be done prior to creating any decode or encode
+ * pipelines. Passing `NULL` restores the pool owned by the context.
+ */
+EXR_EXPORT exr_result_t
+exr_set_buffer_pool (exr_context_t ctxt, exr_buffer_pool_t pool);
+
+/** @brief Retrieve the buffer pool currently used by the context.
+ *
+ * This can be used to adjust the limit (or trim) the pool owned by
+ * the context.
+ */
+EXR_EXPORT exr_result_t
+exr_get_buffer_pool (exr_const_context_t ctxt, exr_buffer_pool_t* pool);
+
+/** @} */
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
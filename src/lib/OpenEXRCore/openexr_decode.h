@@ -327,6 +327,101 @@ EXR_EXPORT
 exr_result_t
 exr_decoding_destroy (exr_const_context_t ctxt, exr_decode_pipeline_t* decode);
 
+/**************************************/
+
+/** Describes the destination of one channel for
+ * exr_decode_part_parallel().
+ *
+ * The buffer is described in the same manner as a slice of a C++
+ * FrameBuffer, except @p base points at the first pixel of the
+ * region being decoded, which is the data window origin for
+ * scanline parts, or the origin of the requested level for tiled
+ * parts. Sub-sampled channels are addressed in sampled coordinates
+ * (i.e. the buffer holds width / x_sampling pixels per line).
+ */
+typedef struct
+{
+    /** Name of the channel to fill. Channels in the part which are
+     * not listed are skipped (not unpacked). */
+    const char* channel_name;
+
+    /** Pointer to the first pixel of the region to decode. */
+    uint8_t* base;
+
+    /** Bytes between successive pixels in a line. */
+    int32_t pixel_stride;
+
+    /** Bytes between successive lines. */
+    int32_t line_stride;
+
+    /** 2 for half, 4 for float / uint. */
+    int16_t user_bytes_per_element;
+
+    /** Small form of exr_pixel_type_t enum to convert to. */
+    uint16_t user_data_type;
+} exr_decode_channel_buffer_t;
+
+/** Options controlling exr_decode_part_parallel().
+ *
+ * Initialize with \ref EXR_DECODE_PART_PARALLEL_OPTIONS_INITIALIZER
+ * so that future additions get default values.
+ */
+typedef struct
+{
+    /** Used for versioning the options in the future. */
+    size_t options_size;
+
+    /** Destination buffers, one per channel to fill. */
+    const exr_decode_channel_buffer_t* channels;
+    int                                num_channels;
+
+    /** For tiled parts, the level to decode. Ignored for scanlines. */
+    int level_x;
+    int level_y;
+
+    /** Range of chunks [begin, end) to decode. For scanline parts,
+     * this is the index of the scanline block counting from the top
+     * of the data window; for tiled parts, this is the tile index
+     * within the level in row-major order (tiley * count_x +
+     * tilex). If @p chunk_end is <= 0, decoding proceeds to the end
+     * of the part (or level). */
+    int chunk_begin;
+    int chunk_end;
+
+    /** Maximum number of concurrent workers. Each worker keeps its
+     * own decode pipeline, so intermediate buffers are reused across
+     * all the chunks a worker decodes. If <= 0, uses the number of
+     * processors. */
+    int num_threads;
+
+    /** Optional task spawner to run the workers in an external thread
+     * pool. If `NULL`, native threads are created for the duration
+     * of the call. */
+    exr_task_spawn_fn_t spawn_fn;
+    void*               spawn_user_data;
+} exr_decode_part_parallel_options_t;
+
+/** @brief Simple macro to initialize the parallel decode options. */
+#define EXR_DECODE_PART_PARALLEL_OPTIONS_INITIALIZER                    \
+    {                                                                   \
+        sizeof (exr_decode_part_parallel_options_t), 0                  \
+    }
+
+/** Decode a range of chunks of a (non-deep) part into the provided
+ * channel buffers, distributing the chunks over a number of workers.
+ *
+ * The caller is responsible for the buffers being large enough for
+ * the region decoded. Chunks write to disjoint regions of the
+ * buffers, so they are decoded in no particular order.
+ *
+ * Decoding stops early on the first error, which is returned.
+ */
+EXR_EXPORT
+exr_result_t exr_decode_part_parallel (
+    exr_const_context_t                       ctxt,
+    int                                       part_index,
+    const exr_decode_part_parallel_options_t* opts);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
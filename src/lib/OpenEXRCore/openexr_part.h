@@ -160,6 +160,21 @@ exr_get_chunk_count (exr_const_context_t ctxt, int part_index, int32_t* out);
 EXR_EXPORT exr_result_t
 exr_get_chunk_table (exr_const_context_t ctxt, int part_index, uint64_t **table, int32_t* count);
 
+/** Provide the chunk table for a part of a file opened for read.
+ *
+ * This is intended to be used with a table previously retrieved via
+ * @ref exr_get_chunk_table, such that a file with an incomplete
+ * chunk table (i.e. a render which crashed while writing), which has
+ * to be reconstructed by scanning the file, only has to be scanned
+ * once, and subsequent opens can re-use the cached result.
+ *
+ * This must be called prior to any chunk being read from the part,
+ * and the count must match the chunk count of the part. The table is
+ * copied.
+ */
+EXR_EXPORT exr_result_t
+exr_set_chunk_table (exr_context_t ctxt, int part_index, const uint64_t* table, int32_t count);
+
 /** Return whether the chunk table for this part is completely written.
  *
  * This only validates that all the offsets are valid.
@@ -0,0 +1,254 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#include "internal_parallel.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <unistd.h>
+#endif
+
+/**************************************/
+
+int
+internal_exr_default_thread_count (void)
+{
+    long n = 1;
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo (&si);
+    n = (long) si.dwNumberOfProcessors;
+#    elif defined(_SC_NPROCESSORS_ONLN)
+    n = sysconf (_SC_NPROCESSORS_ONLN);
+#    endif
+#endif
+    if (n < 1) n = 1;
+    if (n > 256) n = 256;
+    return (int) n;
+}
+
+/**************************************/
+
+#ifdef ILMTHREAD_THREADING_ENABLED
+
+typedef struct
+{
+#    ifdef _WIN32
+    CRITICAL_SECTION   mutex;
+    CONDITION_VARIABLE cond;
+#    else
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+#    endif
+    int           remaining;
+    exr_task_fn_t fn;
+} task_group_t;
+
+typedef struct
+{
+    task_group_t* group;
+    void*         task_data;
+} task_wrapper_t;
+
+static void
+task_group_run (void* data)
+{
+    task_wrapper_t* w = (task_wrapper_t*) data;
+    task_group_t*   g = w->group;
+
+    g->fn (w->task_data);
+
+#    ifdef _WIN32
+    EnterCriticalSection (&g->mutex);
+    if (--(g->remaining) == 0) WakeAllConditionVariable (&g->cond);
+    LeaveCriticalSection (&g->mutex);
+#    else
+    pthread_mutex_lock (&g->mutex);
+    if (--(g->remaining) == 0) pthread_cond_broadcast (&g->cond);
+    pthread_mutex_unlock (&g->mutex);
+#    endif
+}
+
+static exr_result_t
+run_with_spawn (
+    exr_const_context_t ctxt,
+    int                 num_tasks,
+    exr_task_fn_t       fn,
+    void**              task_data,
+    exr_task_spawn_fn_t spawn_fn,
+    void*               spawn_user_data)
+{
+    task_group_t    group;
+    task_wrapper_t* wrappers;
+
+    wrappers = ctxt->alloc_fn (sizeof (task_wrapper_t) * (size_t) num_tasks);
+    if (!wrappers) return ctxt->standard_error (ctxt, EXR_ERR_OUT_OF_MEMORY);
+
+    memset (&group, 0, sizeof (group));
+#    ifdef _WIN32
+    InitializeCriticalSection (&group.mutex);
+    InitializeConditionVariable (&group.cond);
+#    else
+    if (pthread_mutex_init (&group.mutex, NULL) != 0)
+    {
+        ctxt->free_fn (wrappers);
+        return ctxt->standard_error (ctxt, EXR_ERR_OUT_OF_MEMORY);
+    }
+    if (pthread_cond_init (&group.cond, NULL) != 0)
+    {
+        pthread_mutex_destroy (&group.mutex);
+        ctxt->free_fn (wrappers);
+        return ctxt->standard_error (ctxt, EXR_ERR_OUT_OF_MEMORY);
+    }
+#    endif
+    group.remaining = num_tasks;
+    group.fn        = fn;
+
+    for (int t = 0; t < num_tasks; ++t)
+    {
+        wrappers[t].group     = &group;
+        wrappers[t].task_data = task_data[t];
+    }
+
+    for (int t = 1; t < num_tasks; ++t)
+    {
+        if (spawn_fn (spawn_user_data, &task_group_run, wrappers + t) != 0)
+            task_group_run (wrappers + t);
+    }
+    task_group_run (wrappers);
+
+#    ifdef _WIN32
+    EnterCriticalSection (&group.mutex);
+    while (group.remaining > 0)
+        SleepConditionVariableCS (&group.cond, &group.mutex, INFINITE);
+    LeaveCriticalSection (&group.mutex);
+    DeleteCriticalSection (&group.mutex);
+#    else
+    pthread_mutex_lock (&group.mutex);
+    while (group.remaining > 0)
+        pthread_cond_wait (&group.cond, &group.mutex);
+    pthread_mutex_unlock (&group.mutex);
+    pthread_cond_destroy (&group.cond);
+    pthread_mutex_destroy (&group.mutex);
+#    endif
+
+    ctxt->free_fn (wrappers);
+    return EXR_ERR_SUCCESS;
+}
+
+typedef struct
+{
+    exr_task_fn_t fn;
+    void*         task_data;
+#    ifdef _WIN32
+    HANDLE thread;
+#    else
+    pthread_t thread;
+#    endif
+    int started;
+} native_thread_t;
+
+#    ifdef _WIN32
+static DWORD WINAPI
+native_thread_run (LPVOID data)
+{
+    native_thread_t* nt = (native_thread_t*) data;
+    nt->fn (nt->task_data);
+    return 0;
+}
+#    else
+static void*
+native_thread_run (void* data)
+{
+    native_thread_t* nt = (native_thread_t*) data;
+    nt->fn (nt->task_data);
+    return NULL;
+}
+#    endif
+
+static exr_result_t
+run_with_native_threads (
+    exr_const_context_t ctxt,
+    int                 num_tasks,
+    exr_task_fn_t       fn,
+    void**              task_data)
+{
+    native_thread_t* threads;
+
+    threads = ctxt->alloc_fn (sizeof (native_thread_t) * (size_t) num_tasks);
+    if (!threads) return ctxt->standard_error (ctxt, EXR_ERR_OUT_OF_MEMORY);
+    memset (threads, 0, sizeof (native_thread_t) * (size_t) num_tasks);
+
+    for (int t = 1; t < num_tasks; ++t)
+    {
+        native_thread_t* nt = threads + t;
+
+        nt->fn        = fn;
+        nt->task_data = task_data[t];
+#    ifdef _WIN32
+        nt->thread = CreateThread (NULL, 0, &native_thread_run, nt, 0, NULL);
+        nt->started = (nt->thread != NULL);
+#    else
+        nt->started =
+            (pthread_create (&nt->thread, NULL, &native_thread_run, nt) == 0);
+#    endif
+        /* out of threads, just do the work here */
+        if (!nt->started) fn (task_data[t]);
+    }
+
+    fn (task_data[0]);
+
+    for (int t = 1; t < num_tasks; ++t)
+    {
+        native_thread_t* nt = threads + t;
+        if (!nt->started) continue;
+#    ifdef _WIN32
+        WaitForSingleObject (nt->thread, INFINITE);
+        CloseHandle (nt->thread);
+#    else
+        pthread_join (nt->thread, NULL);
+#    endif
+    }
+
+    ctxt->free_fn (threads);
+    return EXR_ERR_SUCCESS;
+}
+
+#endif /* ILMTHREAD_THREADING_ENABLED */
+
+/**************************************/
+
+exr_result_t
+internal_exr_run_tasks (
+    exr_const_context_t ctxt,
+    int                 num_tasks,
+    exr_task_fn_t       fn,
+    void**              task_data,
+    exr_task_spawn_fn_t spawn_fn,
+    void*               spawn_user_data)
+{
+    if (num_tasks <= 0) return EXR_ERR_SUCCESS;
+
+#ifdef ILMTHREAD_THREADING_ENABLED
+    if (num_tasks > 1)
+    {
+        if (spawn_fn)
+            return run_with_spawn (
+                ctxt, num_tasks, fn, task_data, spawn_fn, spawn_user_data);
+        return run_with_native_threads (ctxt, num_tasks, fn, task_data);
+    }
+#else
+    (void) spawn_fn;
+    (void) spawn_user_data;
+#endif
+
+    for (int t = 0; t < num_tasks; ++t)
+        fn (task_data[t]);
+    return EXR_ERR_SUCCESS;
+}
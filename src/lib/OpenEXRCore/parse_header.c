@@ -54,6 +54,9 @@ struct _internal_exr_seq_scratch
     uint64_t curpos;
     int64_t  navail;
     uint64_t fileoff;
+    uint64_t bufsize;
+    uint64_t maxsize;
+    int      nrefill;
 
     exr_result_t (*sequential_read) (
         struct _internal_exr_seq_scratch*, void*, uint64_t);
@@ -79,7 +82,79 @@ scratch_attr_too_big (struct _internal_exr_seq_scratch* scr, int32_t attrsz)
     return 0;
 }
 
+/* the header is read in one request of the initial size when
+ * possible; when it does not fit, each later request doubles, up to
+ * the larger of the max size and the user's initial size */
 #define SCRATCH_BUFFER_SIZE 4096
+#define SCRATCH_INITIAL_SIZE (64 * 1024)
+#define SCRATCH_MAX_SIZE (1024 * 1024)
+
+static exr_result_t
+scratch_refill (struct _internal_exr_seq_scratch* scr, int stream_safe)
+{
+    exr_result_t rv;
+    int64_t      nread  = 0;
+    uint64_t     toread = scr->bufsize;
+
+    if (scr->nrefill++ > 0 && scr->bufsize < scr->maxsize)
+    {
+        /* still in the header after the first read, grow */
+        uint64_t newsize = scr->bufsize * 2;
+        uint8_t* newbuf;
+
+        if (newsize > scr->maxsize) newsize = scr->maxsize;
+        newbuf = scr->ctxt->alloc_fn (newsize);
+        if (newbuf)
+        {
+            scr->ctxt->free_fn (scr->scratch);
+            scr->scratch = newbuf;
+            scr->bufsize = newsize;
+            toread       = newsize;
+        }
+    }
+
+    if (scr->ctxt->file_size > 0)
+    {
+        if ((scr->fileoff + toread) > (uint64_t) scr->ctxt->file_size)
+        {
+            if (scr->fileoff < (uint64_t) scr->ctxt->file_size)
+                toread = (uint64_t) scr->ctxt->file_size - scr->fileoff;
+            else
+                toread = 1;
+        }
+    }
+    else if (stream_safe)
+    {
+        /*
+         * hrm, stream only with no known size, just read 1 byte at a
+         * time to be safer
+         */
+        toread = 1;
+    }
+    else if (toread > SCRATCH_BUFFER_SIZE)
+        toread = SCRATCH_BUFFER_SIZE;
+
+    rv = scr->ctxt->do_read (
+        scr->ctxt,
+        scr->scratch,
+        toread,
+        &(scr->fileoff),
+        &nread,
+        EXR_ALLOW_SHORT_READ);
+    if (nread > 0)
+    {
+        scr->navail = nread;
+        scr->curpos = 0;
+        return EXR_ERR_SUCCESS;
+    }
+
+    if (nread == 0)
+        rv = scr->ctxt->report_error (
+            scr->ctxt, EXR_ERR_READ_IO, "End of file attempting to read header");
+    else if (rv == EXR_ERR_SUCCESS)
+        rv = EXR_ERR_READ_IO;
+    return rv;
+}
 
 static exr_result_t
 scratch_seq_read (struct _internal_exr_seq_scratch* scr, void* buf, uint64_t sz)
@@ -103,15 +178,15 @@ scratch_seq_read (struct _internal_exr_seq_scratch* scr, void* buf, uint64_t sz)
             outbuf += nCopy;
             nCopied += nCopy;
         }
-        else if (notdone >= SCRATCH_BUFFER_SIZE)
+        else if (notdone >= scr->bufsize)
         {
-            uint64_t nPages  = notdone / SCRATCH_BUFFER_SIZE;
-            int64_t  nread   = 0;
-            uint64_t nToRead = nPages * SCRATCH_BUFFER_SIZE;
-            rv               = scr->ctxt->do_read (
+            /* larger than the buffer, read straight into the
+             * destination rather than through the scratch */
+            int64_t nread = 0;
+            rv            = scr->ctxt->do_read (
                 scr->ctxt,
                 outbuf,
-                nToRead,
+                notdone,
                 &(scr->fileoff),
                 &nread,
                 EXR_MUST_READ_ALL);
@@ -125,46 +200,9 @@ scratch_seq_read (struct _internal_exr_seq_scratch* scr, void* buf, uint64_t sz)
         }
         else
         {
-            int64_t nread = 0;
-            uint64_t toread = SCRATCH_BUFFER_SIZE;
-
-            if (scr->ctxt->file_size > 0)
-            {
-                if ((scr->fileoff + SCRATCH_BUFFER_SIZE) > scr->ctxt->file_size)
-                {
-                    toread = scr->ctxt->file_size - scr->fileoff;
-                }
-            }
-            else
-            {
-                /*
-                 * hrm, stream only with no known size, just read 1 byte at a
-                 * time to be safer
-                 */
-                toread = 1;
-            }
-
-            rv = scr->ctxt->do_read (
-                scr->ctxt,
-                scr->scratch,
-                toread,
-                &(scr->fileoff),
-                &nread,
-                EXR_ALLOW_SHORT_READ);
-            if (nread > 0)
-            {
-                scr->navail = nread;
-                scr->curpos = 0;
-            }
-            else
-            {
-                if (nread == 0)
-                    rv = scr->ctxt->report_error (
-                        scr->ctxt,
-                        EXR_ERR_READ_IO,
-                        "End of file attempting to read header");
-                break;
-            }
+            rv = scratch_refill (scr, 1);
+            if (rv != EXR_ERR_SUCCESS) break;
+            rv = -1;
         }
     }
     if (rv == -1)
@@ -198,28 +236,9 @@ scratch_seq_skip (struct _internal_exr_seq_scratch* scr, int32_t sz)
         }
         else
         {
-            int64_t nread = 0;
-            rv            = scr->ctxt->do_read (
-                scr->ctxt,
-                scr->scratch,
-                SCRATCH_BUFFER_SIZE,
-                &(scr->fileoff),
-                &nread,
-                EXR_ALLOW_SHORT_READ);
-            if (nread > 0)
-            {
-                scr->navail = nread;
-                scr->curpos = 0;
-            }
-            else
-            {
-                if (nread == 0)
-                    rv = scr->ctxt->report_error (
-                        scr->ctxt,
-                        EXR_ERR_READ_IO,
-                        "End of file attempting to read header");
-                break;
-            }
+            rv = scratch_refill (scr, 0);
+            if (rv != EXR_ERR_SUCCESS) break;
+            rv = -1;
         }
     }
     if (rv == -1)
@@ -238,13 +257,36 @@ static exr_result_t
 priv_init_scratch (
     exr_context_t ctxt, struct _internal_exr_seq_scratch* scr, uint64_t offset)
 {
+    uint64_t initsize = ctxt->header_read_size;
+
+    if (initsize == 0) initsize = SCRATCH_INITIAL_SIZE;
+    if (initsize < SCRATCH_BUFFER_SIZE) initsize = SCRATCH_BUFFER_SIZE;
+
     scr->curpos          = 0;
     scr->navail          = 0;
     scr->fileoff         = offset;
+    scr->maxsize         = SCRATCH_MAX_SIZE;
+    scr->nrefill         = 0;
     scr->sequential_read = &scratch_seq_read;
     scr->sequential_skip = &scratch_seq_skip;
     scr->ctxt            = ctxt;
-    scr->scratch         = ctxt->alloc_fn (SCRATCH_BUFFER_SIZE);
+    if (initsize > scr->maxsize) scr->maxsize = initsize;
+
+    /* small files, do not allocate more than the whole file */
+    if (ctxt->file_size > 0 && (uint64_t) ctxt->file_size < initsize)
+    {
+        initsize = (uint64_t) ctxt->file_size;
+        if (initsize < SCRATCH_BUFFER_SIZE) initsize = SCRATCH_BUFFER_SIZE;
+        scr->maxsize = initsize;
+    }
+    /* streams of unknown size read one byte at a time anyway */
+    else if (ctxt->file_size <= 0)
+    {
+        initsize     = SCRATCH_BUFFER_SIZE;
+        scr->maxsize = initsize;
+    }
+    scr->bufsize = initsize;
+    scr->scratch = ctxt->alloc_fn (initsize);
     if (scr->scratch == NULL)
         return ctxt->standard_error (ctxt, EXR_ERR_OUT_OF_MEMORY);
     return EXR_ERR_SUCCESS;
@@ -8,6 +8,7 @@
 #include "internal_attr.h"
 #include "internal_constants.h"
 #include "internal_structs.h"
+#include "internal_xdr.h"
 
 #include <string.h>
 
@@ -469,6 +470,63 @@ exr_get_chunk_table (exr_const_context_t ctxt, int part_index, uint64_t **table,
 
 /**************************************/
 
+exr_result_t
+internal_exr_set_chunk_table (
+    exr_context_t         ctxt,
+    exr_const_priv_part_t part,
+    const void*           table,
+    int32_t               count,
+    int                   file_order)
+{
+    uint64_t* ctable;
+    uint64_t  chunkbytes;
+    uintptr_t eptr = 0;
+
+    chunkbytes = sizeof (uint64_t) * (uint64_t) count;
+    ctable     = (uint64_t*) ctxt->alloc_fn (chunkbytes);
+    if (ctable == NULL)
+        return ctxt->standard_error (ctxt, EXR_ERR_OUT_OF_MEMORY);
+    memcpy (ctable, table, chunkbytes);
+    if (file_order) priv_to_native64 (ctable, count);
+
+    if (!atomic_compare_exchange_strong (
+            EXR_CONST_CAST (atomic_uintptr_t*, &(part->chunk_table)),
+            &eptr,
+            (uintptr_t) ctable))
+    {
+        ctxt->free_fn (ctable);
+        return ctxt->report_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Chunk table already loaded for part");
+    }
+
+    return EXR_ERR_SUCCESS;
+}
+
+exr_result_t
+exr_set_chunk_table (
+    exr_context_t ctxt, int part_index, const uint64_t* table, int32_t count)
+{
+    EXR_READONLY_AND_DEFINE_PART (part_index);
+
+    if (!table)
+        return ctxt->report_error (
+            ctxt, EXR_ERR_INVALID_ARGUMENT, "Missing chunk table to set");
+
+    if (count != part->chunk_count || count <= 0)
+        return ctxt->print_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Chunk table count (%d) does not match part chunk count (%d)",
+            count,
+            part->chunk_count);
+
+    return internal_exr_set_chunk_table (ctxt, part, table, count, 0);
+}
+
+/**************************************/
+
 exr_result_t
 exr_validate_chunk_table (exr_context_t ctxt, int part_index)
 {
@@ -24,9 +24,13 @@
 #include "ImfTiledInputPart.h"
 #include "ImfTiledMisc.h"
 
+#include "IlmThreadPool.h"
+
 #include "openexr.h"
 
 #include <algorithm>
+#include <atomic>
+#include <new>
 #include <stdlib.h>
 #include <vector>
 
@@ -36,6 +40,9 @@ namespace
 {
 
 using IMATH_NAMESPACE::Box2i;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
 using std::max;
 using std::vector;
 
@@ -1674,6 +1681,347 @@ checkCoreFile (exr_context_t f, bool reduceMemory, bool reduceTime)
     return false;
 }
 
+////////////////////////////////////////
+//
+// parallel core checks
+//
+// the chunks of all parts are numbered in file order, and handed out
+// to worker tasks on the global thread pool through a shared counter.
+// Each worker keeps a single decode pipeline and scratch buffer for
+// one chunk, so memory use is bounded by the number of workers rather
+// than the size of the image. The first chunk that fails to read or
+// decode stops all the workers.
+//
+
+struct CoreCheckRange
+{
+    // a scanline part, or one level of a tiled part
+    int           part;
+    exr_storage_t storage;
+    int32_t       minY;
+    int32_t       lineCount;
+    int32_t       xLevel;
+    int32_t       yLevel;
+    int32_t       chunkWidth;
+    int32_t       chunkHeight;
+    int32_t       numXChunks;
+    uint64_t      firstChunk;
+};
+
+struct CoreCheckShared
+{
+    exr_context_t          f;
+    bool                   reduceMemory;
+    vector<CoreCheckRange> ranges;
+    uint64_t               numChunks;
+    std::atomic<uint64_t>  nextChunk;
+    std::atomic<bool>      failed;
+};
+
+bool
+addCoreCheckRanges (exr_context_t f, int part, CoreCheckShared& shared)
+{
+    exr_result_t  rv;
+    exr_storage_t store;
+    rv = exr_get_storage (f, part, &store);
+    if (rv != EXR_ERR_SUCCESS) return true;
+
+    exr_attr_box2i_t datawin;
+    rv = exr_get_data_window (f, part, &datawin);
+    if (rv != EXR_ERR_SUCCESS) return true;
+
+    CoreCheckRange r;
+    r.part    = part;
+    r.storage = store;
+    r.minY    = datawin.min.y;
+
+    if (store == EXR_STORAGE_SCANLINE || store == EXR_STORAGE_DEEP_SCANLINE)
+    {
+        int64_t width  = (int64_t) datawin.max.x - (int64_t) datawin.min.x + 1;
+        int64_t height = (int64_t) datawin.max.y - (int64_t) datawin.min.y + 1;
+
+        int32_t lines_per_chunk;
+        rv = exr_get_scanlines_per_chunk (f, part, &lines_per_chunk);
+        if (rv != EXR_ERR_SUCCESS || lines_per_chunk <= 0) return true;
+        if (width <= 0 || height <= 0 || width > INT32_MAX) return true;
+
+        r.xLevel      = 0;
+        r.yLevel      = 0;
+        r.lineCount   = lines_per_chunk;
+        r.chunkWidth  = (int32_t) width;
+        r.chunkHeight = lines_per_chunk;
+        r.numXChunks  = 1;
+        r.firstChunk  = shared.numChunks;
+
+        shared.ranges.push_back (r);
+        shared.numChunks +=
+            ((uint64_t) height + (uint64_t) lines_per_chunk - 1) /
+            (uint64_t) lines_per_chunk;
+        return false;
+    }
+
+    if (store != EXR_STORAGE_TILED && store != EXR_STORAGE_DEEP_TILED)
+        return false;
+
+    uint32_t              txsz, tysz;
+    exr_tile_level_mode_t levelmode;
+    exr_tile_round_mode_t roundingmode;
+
+    rv = exr_get_tile_descriptor (
+        f, part, &txsz, &tysz, &levelmode, &roundingmode);
+    if (rv != EXR_ERR_SUCCESS) return true;
+
+    int32_t levelsx, levelsy;
+    rv = exr_get_tile_levels (f, part, &levelsx, &levelsy);
+    if (rv != EXR_ERR_SUCCESS) return true;
+
+    for (int32_t ylevel = 0; ylevel < levelsy; ++ylevel)
+    {
+        for (int32_t xlevel = 0; xlevel < levelsx; ++xlevel)
+        {
+            // mipmapped files only have the levels along the diagonal
+            if (levelmode != EXR_TILE_RIPMAP_LEVELS && xlevel != ylevel)
+                continue;
+
+            int32_t curtw, curth, countx, county;
+            rv = exr_get_tile_sizes (f, part, xlevel, ylevel, &curtw, &curth);
+            if (rv != EXR_ERR_SUCCESS || curtw <= 0 || curth <= 0)
+                return true;
+
+            rv = exr_get_tile_counts (
+                f, part, xlevel, ylevel, &countx, &county);
+            if (rv != EXR_ERR_SUCCESS || countx <= 0 || county <= 0)
+                return true;
+
+            r.xLevel      = xlevel;
+            r.yLevel      = ylevel;
+            r.lineCount   = 0;
+            r.chunkWidth  = curtw;
+            r.chunkHeight = curth;
+            r.numXChunks  = countx;
+            r.firstChunk  = shared.numChunks;
+
+            shared.ranges.push_back (r);
+            shared.numChunks += (uint64_t) countx * (uint64_t) county;
+        }
+    }
+
+    return false;
+}
+
+//
+// read and decode chunk 'index' of range r, (re)initializing the
+// decoder if this is the first chunk of the range seen by the worker.
+// returns true if the chunk is bad
+//
+
+bool
+checkCoreChunk (
+    exr_context_t          f,
+    const CoreCheckRange&  r,
+    uint64_t               index,
+    bool                   reduceMemory,
+    exr_decode_pipeline_t& decoder,
+    vector<uint8_t>&       chunkdata,
+    bool&                  doread)
+{
+    exr_result_t     rv;
+    exr_chunk_info_t cinfo = {0};
+    bool             deep  = (r.storage == EXR_STORAGE_DEEP_SCANLINE ||
+                       r.storage == EXR_STORAGE_DEEP_TILED);
+
+    int tx = (int) (index % (uint64_t) r.numXChunks);
+    int ty = (int) (index / (uint64_t) r.numXChunks);
+
+    if (r.lineCount > 0)
+    {
+        int y = (int) ((int64_t) r.minY + (int64_t) ty * r.lineCount);
+        rv    = exr_read_scanline_chunk_info (f, r.part, y, &cinfo);
+    }
+    else
+    {
+        rv = exr_read_tile_chunk_info (
+            f, r.part, tx, ty, r.xLevel, r.yLevel, &cinfo);
+    }
+    if (rv != EXR_ERR_SUCCESS) return true;
+
+    uint64_t width  = (uint64_t) r.chunkWidth;
+    uint64_t height = (uint64_t) r.chunkHeight;
+
+    if (decoder.channels == NULL)
+    {
+        rv = exr_decoding_initialize (f, r.part, &cinfo, &decoder);
+        if (rv != EXR_ERR_SUCCESS) return true;
+
+        uint64_t bytes = 0;
+        for (int c = 0; c < decoder.channel_count; c++)
+        {
+            exr_coding_channel_info_t& outc = decoder.channels[c];
+            // fake addr for default routines
+            outc.decode_to_ptr     = (uint8_t*) 0x1000 + bytes;
+            outc.user_pixel_stride = outc.user_bytes_per_element;
+            outc.user_line_stride  = outc.user_pixel_stride * width;
+            bytes += width * (uint64_t) outc.user_bytes_per_element * height;
+        }
+
+        doread = true;
+        if (reduceMemory && bytes >= (r.lineCount > 0 ? gMaxBytesPerScanline
+                                                      : gMaxTileBytes))
+            doread = false;
+
+        if (deep)
+        {
+            decoder.decoding_user_data       = &chunkdata;
+            decoder.realloc_nonimage_data_fn = &realloc_deepdata;
+        }
+        else if (doread && chunkdata.size () < bytes)
+        {
+            try
+            {
+                chunkdata.resize (bytes);
+            }
+            catch (std::bad_alloc&)
+            {
+                return true;
+            }
+        }
+
+        rv = exr_decoding_choose_default_routines (f, r.part, &decoder);
+        if (rv != EXR_ERR_SUCCESS) return true;
+    }
+    else
+    {
+        rv = exr_decoding_update (f, r.part, &cinfo, &decoder);
+        if (rv != EXR_ERR_SUCCESS) return true;
+    }
+
+    if (!doread) return false;
+
+    if (!deep)
+    {
+        uint8_t* dptr = &(chunkdata[0]);
+        for (int c = 0; c < decoder.channel_count; c++)
+        {
+            exr_coding_channel_info_t& outc = decoder.channels[c];
+            outc.decode_to_ptr              = dptr;
+            outc.user_pixel_stride          = outc.user_bytes_per_element;
+            outc.user_line_stride           = outc.user_pixel_stride * width;
+
+            dptr += width * (uint64_t) outc.user_bytes_per_element * height;
+        }
+    }
+
+    rv = exr_decoding_run (f, r.part, &decoder);
+    return (rv != EXR_ERR_SUCCESS);
+}
+
+class CoreCheckTask : public Task
+{
+public:
+    CoreCheckTask (TaskGroup* group, CoreCheckShared& shared)
+        : Task (group), _shared (shared)
+    {}
+
+    void execute () override;
+
+private:
+    CoreCheckShared& _shared;
+};
+
+void
+CoreCheckTask::execute ()
+{
+    exr_decode_pipeline_t decoder = EXR_DECODE_PIPELINE_INITIALIZER;
+    vector<uint8_t>       chunkdata;
+    bool                  doread = false;
+    const CoreCheckRange* cur    = nullptr;
+
+    while (!_shared.failed.load (std::memory_order_relaxed))
+    {
+        uint64_t chunk = _shared.nextChunk.fetch_add (1);
+        if (chunk >= _shared.numChunks) break;
+
+        //
+        // find the range holding this chunk: chunks are handed out in
+        // order, so this is almost always the range of the last chunk
+        //
+
+        const CoreCheckRange* r = cur;
+        if (!r || chunk < r->firstChunk ||
+            (r + 1 != _shared.ranges.data () + _shared.ranges.size () &&
+             chunk >= (r + 1)->firstChunk))
+        {
+            auto it = std::upper_bound (
+                _shared.ranges.begin (),
+                _shared.ranges.end (),
+                chunk,
+                [] (uint64_t c, const CoreCheckRange& range) {
+                    return c < range.firstChunk;
+                });
+            r = &(*(it - 1));
+        }
+
+        if (r != cur)
+        {
+            exr_decoding_destroy (_shared.f, &decoder);
+            cur = r;
+        }
+
+        if (checkCoreChunk (
+                _shared.f,
+                *r,
+                chunk - r->firstChunk,
+                _shared.reduceMemory,
+                decoder,
+                chunkdata,
+                doread))
+        {
+            _shared.failed = true;
+        }
+    }
+
+    exr_decoding_destroy (_shared.f, &decoder);
+}
+
+bool
+checkCoreFileParallel (exr_context_t f, bool reduceMemory, int numThreads)
+{
+    exr_result_t rv;
+    int          numparts;
+
+    rv = exr_get_count (f, &numparts);
+    if (rv != EXR_ERR_SUCCESS) return true;
+
+    CoreCheckShared shared;
+    shared.f            = f;
+    shared.reduceMemory = reduceMemory;
+    shared.numChunks    = 0;
+    shared.nextChunk    = 0;
+    shared.failed       = false;
+
+    for (int p = 0; p < numparts; ++p)
+    {
+        if (addCoreCheckRanges (f, p, shared)) return true;
+    }
+
+    if (shared.numChunks == 0) return false;
+
+    if (static_cast<uint64_t> (numThreads) > shared.numChunks)
+        numThreads = static_cast<int> (shared.numChunks);
+
+    {
+        //
+        // the TaskGroup destructor waits for all the workers to finish
+        //
+
+        TaskGroup group;
+        for (int t = 0; t < numThreads; ++t)
+            ThreadPool::addGlobalTask (new CoreCheckTask (&group, shared));
+    }
+
+    return shared.failed;
+}
+
 ////////////////////////////////////////
 
 static void
@@ -1695,7 +2043,8 @@ core_error_handler_cb (exr_const_context_t f, int code, const char* msg)
 ////////////////////////////////////////
 
 bool
-runCoreChecks (const char* filename, bool reduceMemory, bool reduceTime)
+runCoreChecks (
+    const char* filename, bool reduceMemory, bool reduceTime, int numThreads)
 {
     exr_result_t              rv;
     bool                      hadfail = false;
@@ -1721,7 +2070,10 @@ runCoreChecks (const char* filename, bool reduceMemory, bool reduceTime)
     rv = exr_start_read (&f, filename, &cinit);
     if (rv != EXR_ERR_SUCCESS) return true;
 
-    hadfail = checkCoreFile (f, reduceMemory, reduceTime);
+    if (numThreads > 1)
+        hadfail = checkCoreFileParallel (f, reduceMemory, numThreads);
+    else
+        hadfail = checkCoreFile (f, reduceMemory, reduceTime);
 
     exr_finish (&f);
 
@@ -1772,7 +2124,11 @@ memstream_size (exr_const_context_t ctxt, void* userdata)
 
 bool
 runCoreChecks (
-    const char* data, size_t numBytes, bool reduceMemory, bool reduceTime)
+    const char* data,
+    size_t      numBytes,
+    bool        reduceMemory,
+    bool        reduceTime,
+    int         numThreads)
 {
     bool                      hadfail = false;
     exr_result_t              rv;
@@ -1804,7 +2160,10 @@ runCoreChecks (
     rv = exr_start_read (&f, "<memstream>", &cinit);
     if (rv != EXR_ERR_SUCCESS) return true;
 
-    hadfail = checkCoreFile (f, reduceMemory, reduceTime);
+    if (numThreads > 1)
+        hadfail = checkCoreFileParallel (f, reduceMemory, numThreads);
+    else
+        hadfail = checkCoreFile (f, reduceMemory, reduceTime);
 
     exr_finish (&f);
 
@@ -1817,10 +2176,34 @@ bool
 checkOpenEXRFile (
     const char* fileName, bool reduceMemory, bool reduceTime, bool runCoreCheck)
 {
+    return checkOpenEXRFile (
+        fileName, reduceMemory, reduceTime, runCoreCheck, 1);
+}
+
+bool
+checkOpenEXRFile (
+    const char* data,
+    size_t      numBytes,
+    bool        reduceMemory,
+    bool        reduceTime,
+    bool        runCoreCheck)
+{
+    return checkOpenEXRFile (
+        data, numBytes, reduceMemory, reduceTime, runCoreCheck, 1);
+}
+
+bool
+checkOpenEXRFile (
+    const char* fileName,
+    bool        reduceMemory,
+    bool        reduceTime,
+    bool        runCoreCheck,
+    int         numThreads)
+{
 
     if (runCoreCheck)
     {
-        return runCoreChecks (fileName, reduceMemory, reduceTime);
+        return runCoreChecks (fileName, reduceMemory, reduceTime, numThreads);
     }
     else { return runChecks (fileName, reduceMemory, reduceTime); }
 }
@@ -1831,12 +2214,14 @@ checkOpenEXRFile (
     size_t      numBytes,
     bool        reduceMemory,
     bool        reduceTime,
-    bool        runCoreCheck)
+    bool        runCoreCheck,
+    int         numThreads)
 {
 
     if (runCoreCheck)
     {
-        return runCoreChecks (data, numBytes, reduceMemory, reduceTime);
+        return runCoreChecks (
+            data, numBytes, reduceMemory, reduceTime, numThreads);
     }
     else
     {
@@ -45,6 +45,35 @@ IMFUTIL_EXPORT bool checkOpenEXRFile (
     bool        reduceTime   = false,
     bool        runCoreCheck = false);
 
+//
+// versions of checkOpenEXRFile that spread the work over numThreads workers.
+//
+// With runCoreCheck, the chunks of all parts are read and decoded in
+// parallel by numThreads tasks on the global thread pool (see
+// setGlobalThreadCount), each holding one decoder and the scratch for
+// a single chunk, so memory use does not grow with the image size.
+// Checking stops at the first chunk that fails, whether or not
+// reduceTime is set. The C++ API checks use the global thread pool
+// through the input files' default thread counts.
+//
+// numThreads <= 1 behaves as the versions above
+//
+
+IMFUTIL_EXPORT bool checkOpenEXRFile (
+    const char* fileName,
+    bool        reduceMemory,
+    bool        reduceTime,
+    bool        runCoreCheck,
+    int         numThreads);
+
+IMFUTIL_EXPORT bool checkOpenEXRFile (
+    const char* data,
+    size_t      numBytes,
+    bool        reduceMemory,
+    bool        reduceTime,
+    bool        runCoreCheck,
+    int         numThreads);
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
 
 #endif
@@ -21,6 +21,7 @@ IMATH_INTERNAL_NAMESPACE_HEADER_EXIT
 #include "ImfDeepImageChannel.h"
 #include "ImfDeepImageLevel.h"
 #include <Iex.h>
+#include <algorithm>
 
 using namespace IMATH_NAMESPACE;
 using namespace IEX_NAMESPACE;
@@ -236,26 +237,27 @@ TypedDeepImageChannel<T>::initializeSampleLists ()
     // Allocate a new set of sample lists for this channel, and
     // construct zero-filled sample lists for the pixels.
     //
+    // The whole buffer is zeroed in one pass, rather than list by
+    // list; when the lists are packed back to back, as they are
+    // after SampleCountChannel::endEdit(), that is the same memory.
+    //
 
     delete[] _sampleBuffer;
 
     _sampleBuffer = 0; // set to 0 to prevent double deletion
                        // in case of an exception
 
-    const unsigned int* numSamples    = sampleCounts ().numSamples ();
     const size_t* sampleListPositions = sampleCounts ().sampleListPositions ();
+    size_t        sampleBufferSize    = sampleCounts ().sampleBufferSize ();
 
-    _sampleBuffer = new T[sampleCounts ().sampleBufferSize ()];
+    _sampleBuffer = new T[sampleBufferSize];
 
     resetBasePointer ();
 
+    std::fill (_sampleBuffer, _sampleBuffer + sampleBufferSize, T (0));
+
     for (size_t i = 0; i < numPixels (); ++i)
-    {
         _sampleListPointers[i] = _sampleBuffer + sampleListPositions[i];
-
-        for (unsigned int j = 0; j < numSamples[i]; ++j)
-            _sampleListPointers[i][j] = T (0);
-    }
 }
 
 template <class T>
@@ -25,7 +25,11 @@ DeepImageLevel::DeepImageLevel (
     int          xLevelNumber,
     int          yLevelNumber,
     const Box2i& dataWindow)
-    : ImageLevel (image, xLevelNumber, yLevelNumber), _sampleCounts (*this)
+    : ImageLevel (image, xLevelNumber, yLevelNumber)
+    , _sampleCounts (*this)
+    , _editFirstRow (0)
+    , _editLastRow (-1)
+    , _editNumSamples (0)
 {
     resize (dataWindow);
 }
@@ -45,6 +49,7 @@ DeepImageLevel::deepImage () const
 DeepImageLevel::~DeepImageLevel ()
 {
     clearChannels ();
+    delete[] _editNumSamples;
 }
 
 void
@@ -106,6 +111,10 @@ DeepImageLevel::resize (const Box2i& dataWindow)
     //
 
     ImageLevel::resize (dataWindow);
+
+    delete[] _editNumSamples;
+    _editNumSamples = 0;
+
     _sampleCounts.resize ();
 
     for (ChannelMap::iterator i = _channels.begin (); i != _channels.end ();
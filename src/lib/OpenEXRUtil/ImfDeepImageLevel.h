@@ -181,6 +181,20 @@ private:
 
     ChannelMap         _channels;
     SampleCountChannel _sampleCounts;
+
+    //
+    // State of a sample count edit started with
+    // _sampleCounts.beginEdit(firstRow,lastRow).  It is kept here,
+    // after all other members, rather than in SampleCountChannel,
+    // because deep image levels are only ever allocated by the library.
+    //
+
+    int _editFirstRow; // Rows being edited
+    int _editLastRow;
+
+    unsigned int* _editNumSamples; // Sample counts of the rows being
+                                   // edited, as they were when the
+                                   // edit began; 0 otherwise
 };
 
 class IMFUTIL_EXPORT_TYPE DeepImageLevel::Iterator
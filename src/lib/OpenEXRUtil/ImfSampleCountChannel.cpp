@@ -158,6 +158,7 @@ SampleCountChannel::set (int x, int y, unsigned int newNumSamples)
             i, _numSamples[i], newNumSamples, _totalSamplesOccupied);
 
         _sampleListPositions[i] = _totalSamplesOccupied;
+        _sampleListSizes[i]     = newSampleListSize;
         _totalSamplesOccupied += newSampleListSize;
         _totalNumSamples += newNumSamples - _numSamples[i];
         _numSamples[i] = newNumSamples;
@@ -222,11 +223,12 @@ SampleCountChannel::set (int x, int y, unsigned int newNumSamples)
 void
 SampleCountChannel::set (int r, unsigned int newNumSamples[])
 {
-    int x = level ().dataWindow ().min.x;
-    int y = r + level ().dataWindow ().min.x;
+    unsigned int* numSamples = beginEdit (r, r);
 
-    for (int i = 0; i < pixelsPerRow (); ++i, ++x)
-        set (x, y, newNumSamples[i]);
+    for (int i = 0; i < pixelsPerRow (); ++i)
+        numSamples[i] = newNumSamples[i];
+
+    endEdit ();
 }
 
 void
@@ -260,23 +262,70 @@ SampleCountChannel::beginEdit ()
     return _numSamples;
 }
 
+unsigned int*
+SampleCountChannel::beginEdit (int firstRow, int lastRow)
+{
+    if (firstRow < 0 || lastRow >= pixelsPerColumn () || firstRow > lastRow)
+    {
+        THROW (
+            ArgExc,
+            "Cannot edit sample counts of rows "
+                << firstRow << " to " << lastRow
+                << ". The rows must be in the range from 0 to "
+                << pixelsPerColumn () - 1 << ".");
+    }
+
+    size_t begin = size_t (firstRow) * pixelsPerRow ();
+    size_t end   = size_t (lastRow + 1) * pixelsPerRow ();
+
+    DeepImageLevel& lvl = deepLevel ();
+
+    delete[] lvl._editNumSamples;
+    lvl._editNumSamples = 0; // set to 0 to prevent double deletion
+                             // in case of an exception
+
+    lvl._editNumSamples = new unsigned int[end - begin];
+
+    for (size_t i = begin; i < end; ++i)
+        lvl._editNumSamples[i - begin] = _numSamples[i];
+
+    lvl._editFirstRow = firstRow;
+    lvl._editLastRow  = lastRow;
+
+    return _numSamples + begin;
+}
+
 void
 SampleCountChannel::endEdit ()
 {
+    if (deepLevel ()._editNumSamples)
+    {
+        endRowEdit ();
+        return;
+    }
+
     try
     {
-        _totalNumSamples      = 0;
-        _totalSamplesOccupied = 0;
+        //
+        // Pack the sample lists back to back: the position of each
+        // list is the sum of the sample counts of the pixels before it.
+        // This is the layout of a level that has just been read from
+        // a file, and it wastes no memory. The first sample list that
+        // later grows with set() causes a reallocation into the more
+        // generous layout that set() uses.
+        //
+
+        _totalNumSamples = 0;
 
         for (size_t i = 0; i < numPixels (); ++i)
         {
-            _sampleListSizes[i]     = roundListSizeUp (_numSamples[i]);
-            _sampleListPositions[i] = _totalSamplesOccupied;
+            _sampleListSizes[i]     = _numSamples[i];
+            _sampleListPositions[i] = _totalNumSamples;
             _totalNumSamples += _numSamples[i];
-            _totalSamplesOccupied += _sampleListSizes[i];
         }
 
-        _sampleBufferSize = roundBufferSizeUp (_totalSamplesOccupied);
+        _totalSamplesOccupied = _totalNumSamples;
+        _sampleBufferSize     = _totalSamplesOccupied;
 
         deepLevel ().initializeSampleLists ();
     }
@@ -287,6 +336,127 @@ SampleCountChannel::endEdit ()
     }
 }
 
+void
+SampleCountChannel::endRowEdit ()
+{
+    //
+    // Finish beginEdit(firstRow,lastRow): resize the sample lists of
+    // the pixels in the edited rows whose sample counts have changed.
+    //
+
+    DeepImageLevel& lvl = deepLevel ();
+
+    size_t begin = size_t (lvl._editFirstRow) * pixelsPerRow ();
+    size_t end   = size_t (lvl._editLastRow + 1) * pixelsPerRow ();
+
+    unsigned int* editNumSamples         = lvl._editNumSamples;
+    unsigned int* oldNumSamples          = 0;
+    size_t*       oldSampleListPositions = 0;
+
+    lvl._editNumSamples = 0;
+
+    try
+    {
+        //
+        // Sample lists that shrink, or that grow within the space that
+        // has been allocated for them, are resized in place. Add up the
+        // space needed by the lists that no longer fit.
+        //
+
+        size_t movedSamples = 0;
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            unsigned int oldN = editNumSamples[i - begin];
+            unsigned int newN = _numSamples[i];
+
+            _totalNumSamples -= oldN;
+            _totalNumSamples += newN;
+
+            if (newN <= oldN) continue;
+
+            if (newN <= _sampleListSizes[i])
+                deepLevel ().setSamplesToZero (i, oldN, newN);
+            else
+                movedSamples += roundListSizeUp (newN);
+        }
+
+        if (movedSamples > 0 &&
+            _totalSamplesOccupied + movedSamples <= _sampleBufferSize)
+        {
+            //
+            // There is room at the end of the sample buffer for all of
+            // the lists that have grown out of their space.
+            //
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                unsigned int newN = _numSamples[i];
+
+                if (newN <= _sampleListSizes[i]) continue;
+
+                deepLevel ().moveSampleList (
+                    i, editNumSamples[i - begin], newN, _totalSamplesOccupied);
+
+                _sampleListPositions[i] = _totalSamplesOccupied;
+                _sampleListSizes[i]     = roundListSizeUp (newN);
+                _totalSamplesOccupied += _sampleListSizes[i];
+            }
+        }
+        else if (movedSamples > 0)
+        {
+            //
+            // Allocate an entirely new sample buffer, once, and move all
+            // existing sample lists into it.
+            //
+
+            oldNumSamples = new unsigned int[numPixels ()];
+
+            for (size_t j = 0; j < numPixels (); ++j)
+                oldNumSamples[j] = _numSamples[j];
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (_numSamples[i] > _sampleListSizes[i])
+                    oldNumSamples[i] = editNumSamples[i - begin];
+            }
+
+            size_t* newSampleListPositions = new size_t[numPixels ()];
+
+            oldSampleListPositions = _sampleListPositions;
+            _sampleListPositions   = newSampleListPositions;
+
+            _totalSamplesOccupied = 0;
+
+            for (size_t j = 0; j < numPixels (); ++j)
+            {
+                _sampleListPositions[j] = _totalSamplesOccupied;
+                _sampleListSizes[j]     = roundListSizeUp (_numSamples[j]);
+                _totalSamplesOccupied += _sampleListSizes[j];
+            }
+
+            _sampleBufferSize = roundBufferSizeUp (_totalSamplesOccupied);
+
+            deepLevel ().moveSamplesToNewBuffer (
+                oldNumSamples, _numSamples, _sampleListPositions);
+
+            delete[] oldNumSamples;
+            delete[] oldSampleListPositions;
+        }
+
+        delete[] editNumSamples;
+    }
+    catch (...)
+    {
+        delete[] editNumSamples;
+        delete[] oldNumSamples;
+        delete[] oldSampleListPositions;
+
+        level ().image ().resize (Box2i (V2i (0, 0), V2i (-1, -1)));
+        throw;
+    }
+}
+
 void
 SampleCountChannel::resize ()
 {
@@ -119,6 +119,9 @@ public:
     // Memory allocation for the sample lists is not particularly clever;
     // repeatedly increasing and decreasing the number of samples in the
     // pixels of a level is likely to result in serious memory fragmentation.
+    // To change the sample counts of many pixels at once, editing whole
+    // rows with beginEdit(firstRow,lastRow) and endEdit() is considerably
+    // cheaper than calling set(x,y,m) for each pixel.
     //
     // Setting the number of samples for one or more pixels may cause the
     // program to run out of memory.  If this happens, the image is resized
@@ -155,6 +158,23 @@ public:
     //  endEdit()       allocates new memory for all samples in the deep
     //                  channels of the layer, according to the current
     //                  sample counts, and sets the samples to zero.
+    //                  The sample lists are packed back to back in the
+    //                  order of the pixels, with no space between them.
+    //
+    //  beginEdit(firstRow,lastRow)
+    //                  makes only the sample counts in rows firstRow
+    //                  to lastRow editable, and returns a pointer to the
+    //                  first sample count in row firstRow.  The rows are
+    //                  numbered as for row(r).  Samples in the deep
+    //                  channels remain accessible, and sample counts
+    //                  outside the rows must not be changed.
+    //
+    //                  The following endEdit() call resizes the sample
+    //                  lists of only those pixels in the rows whose sample
+    //                  counts have changed, as if set(x,y,m) had been
+    //                  called for each of them: existing samples are kept,
+    //                  new samples are set to zero, and the sample buffers
+    //                  are reallocated at most once.
     //
     // Application code must take make sure that each call to beginEdit()
     // is followed by a corresponding endEdit() call, even if an
@@ -172,6 +192,8 @@ public:
     IMFUTIL_EXPORT
     unsigned int* beginEdit ();
     IMFUTIL_EXPORT
+    unsigned int* beginEdit (int firstRow, int lastRow);
+    IMFUTIL_EXPORT
     void endEdit ();
 
     class Edit
@@ -179,12 +201,15 @@ public:
     public:
         //
         // Constructor calls level->beginEdit(),
+        // or level->beginEdit(firstRow,lastRow),
         // destructor calls level->endEdit().
         //
 
         IMFUTIL_EXPORT
         Edit (SampleCountChannel& level);
         IMFUTIL_EXPORT
+        Edit (SampleCountChannel& level, int firstRow, int lastRow);
+        IMFUTIL_EXPORT
         ~Edit ();
 
         Edit (const Edit& other)            = delete;
@@ -232,6 +257,8 @@ private:
 
     void resetBasePointer ();
 
+    void endRowEdit ();
+
     unsigned int* _numSamples; // Array of per-pixel sample counts
 
     unsigned int* _base; // Base pointer for faster access
@@ -265,6 +292,13 @@ inline SampleCountChannel::Edit::Edit (SampleCountChannel& channel)
     // empty
 }
 
+inline SampleCountChannel::Edit::Edit (
+    SampleCountChannel& channel, int firstRow, int lastRow)
+    : _channel (channel), _sampleCounts (channel.beginEdit (firstRow, lastRow))
+{
+    // empty
+}
+
 inline SampleCountChannel::Edit::~Edit ()
 {
     _channel.endEdit ();
@@ -405,6 +405,13 @@ testCPUIdent (const std::string& tempdir)
 #else
     has_native_half ();
 #endif
+
+    // avx2 implies avx
+    if (has_avx2 () && !havx)
+    {
+        std::cerr << "CPU Id test avx2 reported without avx" << std::endl;
+        EXRCORE_TEST (false);
+    }
 }
 
 void
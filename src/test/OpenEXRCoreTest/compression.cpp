@@ -145,6 +145,31 @@ internal_exr_free (void* p)
 #    include "../../lib/OpenEXRCore/internal_huf.h"
 #endif
 
+//
+// The DWA kernels are static, in headers normally only reached via
+// internal_dwa_helpers.h, so pull in just the pieces needed to check
+// the vectorized encoder kernels against the reference ones.
+//
+#include "../../lib/OpenEXRCore/internal_coding.h"
+#include "../../lib/OpenEXRCore/internal_cpuid.h"
+#include "../../lib/OpenEXRCore/internal_xdr.h"
+#define IMF_INTERNAL_DWA_HELPERS_H_HAS_BEEN_INCLUDED
+#define restrict __restrict
+#include "../../lib/OpenEXRCore/internal_dwa_simd.h"
+#include "../../lib/OpenEXRCore/internal_dwa_quantize.h"
+#undef restrict
+#undef IMF_INTERNAL_DWA_HELPERS_H_HAS_BEEN_INCLUDED
+
+// likewise the B44 block coding kernels
+#include "../../lib/OpenEXRCore/internal_b44_kernels.h"
+// and the PIZ wavelet decode rows
+#include "../../lib/OpenEXRCore/internal_piz_kernels.h"
+// the RLE scans and the byte reorder / predictor
+#include "../../lib/OpenEXRCore/internal_rle_kernels.h"
+#include "../../lib/OpenEXRCore/internal_zip_kernels.h"
+// and the PXR24 rounding and byte planes
+#include "../../lib/OpenEXRCore/internal_pxr24_kernels.h"
+
 using namespace IMATH_NAMESPACE;
 namespace IMF = OPENEXR_IMF_NAMESPACE;
 using namespace IMF;
@@ -1636,6 +1661,570 @@ testHUF (const std::string& tempdir)
 
 ////////////////////////////////////////
 
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+
+static float
+randomDWAValue (Rand32& rand, float scale)
+{
+    // mostly in range values, but with some arbitrary bit patterns
+    // (nan, inf, denormals) thrown in
+    if (rand.nexti () % 16 == 0)
+        return half_to_float ((uint16_t) (rand.nexti () & 0xffff));
+    return rand.nextf (-scale, scale);
+}
+
+// identical bits, except that NaNs only need to both be NaN: which
+// payload survives an operation on two NaNs depends on the operand
+// order the compiler happened to pick, even for the reference code
+static bool
+sameBits (const float* a, const float* b, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        if (std::isnan (a[i]) && std::isnan (b[i])) continue;
+        if (memcmp (a + i, b + i, sizeof (float)) != 0) return false;
+    }
+    return true;
+}
+
+#endif
+
+void
+testDWAKernels (const std::string& tempdir)
+{
+#ifdef IMF_HAVE_AVX_F16C_TARGET
+    int f16c = 0, avx = 0, sse2 = 0;
+
+    check_for_x86_simd (&f16c, &avx, &sse2);
+    if (!avx || !f16c)
+    {
+        std::cout << "  AVX / F16C not available, skipping" << std::endl;
+        return;
+    }
+
+    Rand32 rand (0x7e57da1a);
+
+    float    ref[3][64], vec[3][64];
+    uint16_t halfs[64], hrefZig[64], hvecZig[64];
+    float    tols[64];
+    uint16_t htols[64];
+
+    for (int iter = 0; iter < 4096; ++iter)
+    {
+        float scale = (iter & 1) ? 1.f : 65504.f;
+
+        //
+        // block gather
+        //
+
+        for (int i = 0; i < 64; ++i)
+            halfs[i] = (uint16_t) (rand.nexti () & 0xffff);
+        convertHalfToFloat64_scalar (ref[0], halfs);
+        convertHalfToFloat64_f16c (vec[0], halfs);
+        EXRCORE_TEST (sameBits (ref[0], vec[0], 64));
+
+        //
+        // color space conversion
+        //
+
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int i = 0; i < 64; ++i)
+                ref[c][i] = randomDWAValue (rand, scale);
+        }
+        memcpy (vec, ref, sizeof (ref));
+        csc709Forward64_scalar (ref[0], ref[1], ref[2]);
+        csc709Forward64_avx (vec[0], vec[1], vec[2]);
+        EXRCORE_TEST (sameBits (&ref[0][0], &vec[0][0], 3 * 64));
+
+        //
+        // forward DCT
+        //
+
+        for (int i = 0; i < 64; ++i)
+            ref[0][i] = randomDWAValue (rand, scale);
+        memcpy (vec[0], ref[0], sizeof (ref[0]));
+        dctForward8x8_sse2 (ref[0]);
+        dctForward8x8_avx (vec[0]);
+        EXRCORE_TEST (sameBits (ref[0], vec[0], 64));
+
+        //
+        // quantization, with tolerances in the range produced by
+        // the 0 - 100 dwa compression levels
+        //
+
+        for (int i = 0; i < 64; ++i)
+        {
+            tols[i]  = rand.nextf (0.f, 100.f) / 100000.f *
+                       (float) (1 + rand.nexti () % 10);
+            htols[i] = float_to_half (tols[i]);
+        }
+        if (iter % 64 == 0) tols[iter / 64] = 0.f;
+        for (int i = 0; i < 64; ++i)
+            ref[0][i] = randomDWAValue (rand, (iter & 2) ? 0.01f : scale);
+        quantizeCoeffAndZigXDR_scalar (hrefZig, ref[0], tols, htols);
+        quantizeCoeffAndZigXDR_f16c (hvecZig, ref[0], tols, htols);
+        EXRCORE_TEST (memcmp (hrefZig, hvecZig, sizeof (hrefZig)) == 0);
+    }
+#else
+    std::cout << "  no vectorized DWA encoder kernels, skipping" << std::endl;
+#endif
+}
+
+////////////////////////////////////////
+
+#ifdef B44_HAVE_AVX2_TARGET
+
+// a strip of 4 scanlines of halfs, made of blocks which are flat,
+// smooth, noisy, or full of arbitrary bit patterns (nan, inf, ...)
+static void
+randomB44Strip (Rand32& rand, std::vector<uint16_t>& strip, int nx)
+{
+    strip.resize (4 * nx);
+    for (int x = 0; x < nx; x += 4)
+    {
+        int      kind = rand.nexti () % 4;
+        uint16_t base = (uint16_t) (rand.nexti () & 0x7bff);
+        for (int y = 0; y < 4; ++y)
+        {
+            for (int i = x; i < x + 4 && i < nx; ++i)
+            {
+                uint16_t& v = strip[y * nx + i];
+                switch (kind)
+                {
+                    case 0: v = base; break;
+                    case 1: v = (uint16_t) (base + rand.nexti () % 8); break;
+                    case 2:
+                        v = float_to_half (rand.nextf (-1000.f, 1000.f));
+                        break;
+                    default: v = (uint16_t) (rand.nexti () & 0xffff); break;
+                }
+            }
+        }
+    }
+}
+
+#endif
+
+void
+testB44Kernels (const std::string& tempdir)
+{
+#ifdef B44_HAVE_AVX2_TARGET
+    if (!has_avx2 ())
+    {
+        std::cout << "  AVX2 not available, skipping" << std::endl;
+        return;
+    }
+
+    Rand32 rand (0x7e57b440);
+
+    std::vector<uint16_t> strip, ref, vec;
+    std::vector<uint8_t>  refOut, vecOut;
+
+    for (int iter = 0; iter < 2048; ++iter)
+    {
+        int nx         = 1 + (iter % 37);
+        int nrows      = 1 + (iter / 37) % 4;
+        int flatfields = (iter & 1);
+        int p_linear   = (iter & 2) ? 1 : 0;
+
+        if (iter % 256 == 255) nx = 1024 + iter % 4;
+
+        randomB44Strip (rand, strip, nx);
+
+        // the encoder repeats the bottom row of short strips
+        const uint16_t* rows[4];
+        for (int y = 0; y < 4; ++y)
+            rows[y] = strip.data () + (y < nrows ? y : nrows - 1) * nx;
+
+        int      nblocks = (nx + 3) / 4;
+        uint64_t avail   = (uint64_t) nblocks * 14 + 14;
+        uint64_t nRef = 0, nVec = 0;
+
+        refOut.assign (avail, 0);
+        vecOut.assign (avail, 0);
+        EXRCORE_TEST (
+            pack_strip_scalar (
+                rows, nx, flatfields, p_linear, refOut.data (), avail, &nRef) ==
+            EXR_ERR_SUCCESS);
+        EXRCORE_TEST (
+            pack_strip_avx2 (
+                rows, nx, flatfields, p_linear, vecOut.data (), avail, &nVec) ==
+            EXR_ERR_SUCCESS);
+        EXRCORE_TEST (nRef == nVec);
+        EXRCORE_TEST (memcmp (refOut.data (), vecOut.data (), nRef) == 0);
+
+        // decode with no slack after the last block, so the vector
+        // decoder also has to take its tail path
+        uint64_t inRef = 0, inVec = 0;
+        ref.assign (4 * nx, 0);
+        vec.assign (4 * nx, 0);
+        EXRCORE_TEST (
+            unpack_strip_scalar (
+                refOut.data (), nRef, &inRef, ref.data (), nx, nrows,
+                p_linear) == EXR_ERR_SUCCESS);
+        EXRCORE_TEST (
+            unpack_strip_avx2 (
+                refOut.data (), nRef, &inVec, vec.data (), nx, nrows,
+                p_linear) == EXR_ERR_SUCCESS);
+        EXRCORE_TEST (inRef == nRef && inVec == nRef);
+        EXRCORE_TEST (ref == vec);
+
+        // truncated input fails the same way
+        if (nRef > 3)
+        {
+            EXRCORE_TEST (
+                unpack_strip_scalar (
+                    refOut.data (), nRef - 1, &inRef, ref.data (), nx, nrows,
+                    p_linear) == EXR_ERR_OUT_OF_MEMORY);
+            EXRCORE_TEST (
+                unpack_strip_avx2 (
+                    refOut.data (), nRef - 1, &inVec, vec.data (), nx, nrows,
+                    p_linear) == EXR_ERR_OUT_OF_MEMORY);
+        }
+    }
+#else
+    std::cout << "  no vectorized B44 kernels, skipping" << std::endl;
+#endif
+}
+
+#if defined(PIZ_HAVE_SSE2) || defined(PIZ_HAVE_AVX2_TARGET)
+
+// decodes a pair of rows with the given kernel and checks the result
+// against the scalar version
+static void
+checkWavDecodeRows (
+    wav_decode_rows_fn            fn,
+    wav_decode_rows_fn            ref,
+    const std::vector<uint16_t>& in,
+    int                          offset,
+    int                          nblocks)
+{
+    std::vector<uint16_t> a = in, b = in;
+    int                   stride = 2 * nblocks + 3;
+
+    ref (a.data () + offset, a.data () + offset + stride, nblocks);
+    fn (b.data () + offset, b.data () + offset + stride, nblocks);
+    EXRCORE_TEST (a == b);
+}
+
+#endif
+
+void
+testPIZKernels (const std::string& tempdir)
+{
+#if defined(PIZ_HAVE_SSE2) || defined(PIZ_HAVE_AVX2_TARGET)
+    Rand32 rand (0x7e57812a);
+
+    std::vector<uint16_t> rows, orig;
+
+    for (int iter = 0; iter < 1024; ++iter)
+    {
+        int nblocks = iter % 41;
+        int offset  = (iter / 41) % 3;
+
+        if (iter % 128 == 127) nblocks = 1000 + iter % 8;
+
+        // arbitrary coefficients, with the occasional row of values
+        // near the ends of the range
+        rows.resize (2 * (2 * nblocks + 3) + 8);
+        for (size_t i = 0; i < rows.size (); ++i)
+        {
+            if (iter % 4 == 3)
+                rows[i] = (uint16_t) ((rand.nexti () & 1) ? 0xffff - i % 3
+                                                          : i % 3);
+            else
+                rows[i] = (uint16_t) (rand.nexti () & 0xffff);
+        }
+
+#    ifdef PIZ_HAVE_SSE2
+        checkWavDecodeRows (
+            wdec14_rows_sse2, wdec14_rows_scalar, rows, offset, nblocks);
+        checkWavDecodeRows (
+            wdec16_rows_sse2, wdec16_rows_scalar, rows, offset, nblocks);
+#    endif
+#    ifdef PIZ_HAVE_AVX2_TARGET
+        if (has_avx2 ())
+        {
+            checkWavDecodeRows (
+                wdec14_rows_avx2, wdec14_rows_scalar, rows, offset, nblocks);
+            checkWavDecodeRows (
+                wdec16_rows_avx2, wdec16_rows_scalar, rows, offset, nblocks);
+        }
+#    endif
+
+        // and the scalar rows still invert the encoder basis
+        int stride = 2 * nblocks + 3;
+        for (size_t i = 0; i < rows.size (); ++i)
+            rows[i] &= 0x3fff;
+        orig = rows;
+        for (int b = 0; b < nblocks; ++b)
+        {
+            uint16_t* px  = rows.data () + offset + 2 * b;
+            uint16_t* p01 = px + 1;
+            uint16_t* p10 = px + stride;
+            uint16_t* p11 = p10 + 1;
+            uint16_t  i00, i01, i10, i11;
+
+            wenc14 (*px, *p01, &i00, &i01);
+            wenc14 (*p10, *p11, &i10, &i11);
+            wenc14 (i00, i10, px, p10);
+            wenc14 (i01, i11, p01, p11);
+        }
+        wdec14_rows_scalar (
+            rows.data () + offset, rows.data () + offset + stride, nblocks);
+        EXRCORE_TEST (rows == orig);
+    }
+#else
+    std::cout << "  no vectorized PIZ kernels, skipping" << std::endl;
+#endif
+}
+
+#if defined(RLE_HAVE_SSE2) || defined(ZIP_HAVE_SSE2) ||                        \
+    defined(ZIP_HAVE_NEON_AARCH64)
+
+// bytes made of runs, literals, pairs which fall just short of a run,
+// and the extreme values where the predictor wraps around
+static void
+randomRunBytes (Rand32& rand, std::vector<uint8_t>& bytes, size_t count)
+{
+    bytes.resize (count);
+    for (size_t i = 0; i < count;)
+    {
+        size_t  len  = 1 + rand.nexti () % 40;
+        int     kind = rand.nexti () % 4;
+        uint8_t v    = (uint8_t) rand.nexti ();
+
+        for (size_t j = 0; j < len && i < count; ++j, ++i)
+        {
+            switch (kind)
+            {
+                case 0: bytes[i] = v; break;
+                case 1: bytes[i] = (uint8_t) (v + (j / 2) * 7); break;
+                case 2: bytes[i] = (rand.nexti () & 1) ? 0 : 255; break;
+                default: bytes[i] = (uint8_t) rand.nexti (); break;
+            }
+        }
+    }
+}
+
+#endif
+
+void
+testRLEKernels (const std::string& tempdir)
+{
+#ifdef RLE_HAVE_SSE2
+    Rand32 rand (0x7e57a1e0);
+
+    std::vector<uint8_t> bytes;
+
+    for (int iter = 0; iter < 256; ++iter)
+    {
+        size_t count = (size_t) iter;
+
+        if (iter % 64 == 63) count = 4096 + iter % 16;
+
+        randomRunBytes (rand, bytes, count);
+
+        const int8_t* p   = (const int8_t*) bytes.data ();
+        const int8_t* end = p + count;
+
+        // the encoder passes at most MAX_RUN_LENGTH, and starts the
+        // literal scan anywhere up to the end of the input
+        for (size_t i = 0; i <= count; ++i)
+        {
+            uint64_t max = (i % 3) ? 127 : rand.nexti () % 200;
+
+            if (i < count)
+            {
+                EXRCORE_TEST (
+                    repeat_length_scalar (p + i, end, max) ==
+                    repeat_length_sse2 (p + i, end, max));
+            }
+            EXRCORE_TEST (
+                literal_length_scalar (p + i, end, max) ==
+                literal_length_sse2 (p + i, end, max));
+        }
+    }
+#else
+    std::cout << "  no vectorized RLE kernels, skipping" << std::endl;
+#endif
+}
+
+void
+testZIPKernels (const std::string& tempdir)
+{
+#if defined(ZIP_HAVE_SSE2) || defined(ZIP_HAVE_NEON_AARCH64)
+#    if defined(ZIP_HAVE_SSE2)
+    auto deconstruct = deconstruct_sse2;
+    auto reconstruct = reconstruct_sse2;
+    auto interleave  = interleave_sse2;
+#    else
+    auto deconstruct = deconstruct_neon;
+    auto reconstruct = reconstruct_neon;
+    auto interleave  = interleave_neon;
+#    endif
+    Rand32 rand (0x7e5721b0);
+
+    std::vector<uint8_t> src, ref, vec, refOut, vecOut;
+
+    for (int iter = 0; iter < 1024; ++iter)
+    {
+        size_t count = 1 + iter % 97;
+
+        if (iter % 128 == 127) count = 65536 + iter % 64;
+
+        randomRunBytes (rand, src, count);
+
+        ref.assign (count, 0);
+        vec.assign (count, 0);
+        deconstruct_scalar (ref.data (), src.data (), count);
+        deconstruct (vec.data (), src.data (), count);
+        EXRCORE_TEST (ref == vec);
+
+        refOut.assign (count, 0);
+        vecOut.assign (count, 0);
+        reconstruct_scalar (ref.data (), count);
+        interleave_scalar (refOut.data (), ref.data (), count);
+        reconstruct (vec.data (), count);
+        interleave (vecOut.data (), vec.data (), count);
+        EXRCORE_TEST (ref == vec);
+        EXRCORE_TEST (refOut == vecOut);
+        EXRCORE_TEST (refOut == src);
+    }
+#else
+    std::cout << "  no vectorized ZIP kernels, skipping" << std::endl;
+#endif
+}
+
+#ifdef PXR24_HAVE_SSE2
+
+// float bit patterns at the edges of the 24-bit rounding: ties, values
+// which round up into the next exponent or overflow it, NaNs which
+// would turn into infinities, infinities, zeros and denormals
+static void
+pxr24EdgeFloats (std::vector<uint32_t>& bits)
+{
+    bits.clear ();
+    for (uint32_t sign = 0; sign < 2; ++sign)
+    {
+        uint32_t s = sign << 31;
+
+        for (uint32_t lo = 0x70; lo <= 0x90; ++lo)
+        {
+            bits.push_back (s | 0x3f800000 | lo);
+            bits.push_back (s | 0x3f80ff00 | lo);
+            bits.push_back (s | 0x3fffff00 | lo);
+            bits.push_back (s | 0x7f7fff00 | lo);
+            bits.push_back (s | 0x7f7ffe00 | lo);
+            bits.push_back (s | 0x00000000 | lo);
+        }
+        for (uint32_t m = 1; m < 0x200; ++m)
+            bits.push_back (s | 0x7f800000 | m);
+        bits.push_back (s | 0x7fffffff);
+        bits.push_back (s | 0x7fc00000);
+        bits.push_back (s | 0x7f800000);
+        bits.push_back (s | 0x7f7fffff);
+        bits.push_back (s | 0x00800000);
+        bits.push_back (s | 0x007fffff);
+        bits.push_back (s);
+    }
+}
+
+#endif
+
+void
+testPXR24Kernels (const std::string& tempdir)
+{
+#ifdef PXR24_HAVE_SSE2
+    Rand32 rand (0x7e57b824);
+
+    // the rounding, 4 values at a time, plus random bit patterns
+    std::vector<uint32_t> bits;
+    pxr24EdgeFloats (bits);
+    for (int i = 0; i < 65536; ++i)
+        bits.push_back (rand.nexti ());
+    while (bits.size () % 4)
+        bits.push_back (0);
+
+    for (size_t i = 0; i < bits.size (); i += 4)
+    {
+        uint32_t vec[4];
+        _mm_storeu_si128 (
+            (__m128i*) vec,
+            float_to_float24_sse2 (
+                _mm_loadu_si128 ((const __m128i*) (bits.data () + i))));
+        for (int k = 0; k < 4; ++k)
+        {
+            union
+            {
+                uint32_t i;
+                float    f;
+            } v;
+            v.i = bits[i + k];
+            EXRCORE_TEST (vec[k] == float_to_float24 (v.f));
+        }
+    }
+
+    // lines of every width up to a few vectors long, made of the edge
+    // values and random ones, split and merged both ways
+    std::vector<uint8_t> in, ref, vec;
+
+    for (int w = 1; w <= 100; ++w)
+    {
+        in.resize (4 * w);
+        for (int x = 0; x < w; ++x)
+        {
+            uint32_t v = (rand.nexti () & 1)
+                             ? bits[rand.nexti () % bits.size ()]
+                             : rand.nexti ();
+            memcpy (in.data () + 4 * x, &v, sizeof (v));
+        }
+
+        ref.assign (4 * w, 0);
+        vec.assign (4 * w, 0);
+        split_uint_scalar (in.data (), w, ref.data ());
+        split_uint_sse2 (in.data (), w, vec.data ());
+        EXRCORE_TEST (ref == vec);
+
+        ref.assign (2 * w, 0);
+        vec.assign (2 * w, 0);
+        split_half_scalar (in.data (), w, ref.data ());
+        split_half_sse2 (in.data (), w, vec.data ());
+        EXRCORE_TEST (ref == vec);
+
+        ref.assign (3 * w, 0);
+        vec.assign (3 * w, 0);
+        split_float_scalar (in.data (), w, ref.data ());
+        split_float_sse2 (in.data (), w, vec.data ());
+        EXRCORE_TEST (ref == vec);
+
+        // the byte planes are arbitrary on the decode side
+        ref.assign (4 * w, 0);
+        vec.assign (4 * w, 0);
+        merge_uint_scalar (in.data (), w, ref.data ());
+        merge_uint_sse2 (in.data (), w, vec.data ());
+        EXRCORE_TEST (ref == vec);
+
+        ref.assign (2 * w, 0);
+        vec.assign (2 * w, 0);
+        merge_half_scalar (in.data (), w, ref.data ());
+        merge_half_sse2 (in.data (), w, vec.data ());
+        EXRCORE_TEST (ref == vec);
+
+        ref.assign (4 * w, 0);
+        vec.assign (4 * w, 0);
+        merge_float_scalar (in.data (), w, ref.data ());
+        merge_float_sse2 (in.data (), w, vec.data ());
+        EXRCORE_TEST (ref == vec);
+    }
+#else
+    std::cout << "  no vectorized PXR24 kernels, skipping" << std::endl;
+#endif
+}
+
+////////////////////////////////////////
+
 void
 testNoCompression (const std::string& tempdir)
 {
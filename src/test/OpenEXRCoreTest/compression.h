@@ -9,8 +9,14 @@
 void testHUF (const std::string& tempdir);
 
 void testDWAQuantize (const std::string& tempdir);
+void testDWAKernels (const std::string& tempdir);
 void testDWATable (const std::string& tempdir);
 void testB44Table (const std::string& tempdir);
+void testB44Kernels (const std::string& tempdir);
+void testPIZKernels (const std::string& tempdir);
+void testRLEKernels (const std::string& tempdir);
+void testZIPKernels (const std::string& tempdir);
+void testPXR24Kernels (const std::string& tempdir);
 
 void testNoCompression (const std::string& tempdir);
 void testRLECompression (const std::string& tempdir);
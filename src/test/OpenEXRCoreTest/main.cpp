@@ -168,6 +168,8 @@ main (int argc, char* argv[])
     TEST (testReadBadArgs, "core_read");
     TEST (testReadBadFiles, "core_read");
     TEST (testReadMeta, "core_read");
+    TEST (testReadHeaderSize, "core_read");
+    TEST (testReadIndexed, "core_read");
     TEST (testOpenScans, "core_read");
     TEST (testOpenTiles, "core_read");
     TEST (testOpenMultiPart, "core_read");
@@ -177,6 +179,9 @@ main (int argc, char* argv[])
     TEST (testReadMultiPart, "core_read");
     TEST (testReadDeep, "core_read");
     TEST (testReadUnpack, "core_read");
+    TEST (testReadParallel, "core_read");
+    TEST (testReadBufferPool, "core_read");
+    TEST (testReadReconstructChunkTable, "core_read");
 
     TEST (testWriteBadArgs, "core_write");
     TEST (testWriteBadFiles, "core_write");
@@ -191,12 +196,19 @@ main (int argc, char* argv[])
     TEST (testWriteScans, "core_write");
     TEST (testWriteTiles, "core_write");
     TEST (testWriteMultiPart, "core_write");
+    TEST (testWriteCopyChunks, "core_write");
     TEST (testWriteDeep, "core_write");
 
     TEST (testHUF, "core_compression");
     TEST (testDWAQuantize, "core_compression");
+    TEST (testDWAKernels, "core_compression");
     TEST (testDWATable, "core_compression");
     TEST (testB44Table, "core_compression");
+    TEST (testB44Kernels, "core_compression");
+    TEST (testPIZKernels, "core_compression");
+    TEST (testRLEKernels, "core_compression");
+    TEST (testZIPKernels, "core_compression");
+    TEST (testPXR24Kernels, "core_compression");
     TEST (testNoCompression, "core_compression");
     TEST (testRLECompression, "core_compression");
     TEST (testZIPCompression, "core_compression");
@@ -2,13 +2,16 @@
 // Copyright Contributors to the OpenEXR Project.
 
 #include <errno.h>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include <algorithm>
 #include <chrono>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -18,9 +21,11 @@
 #include <ImfCompressor.h>
 #include <ImfFrameBuffer.h>
 #include <ImfHeader.h>
+#include <ImfIDManifest.h>
 #include <ImfInputPart.h>
 #include <ImfMultiPartInputFile.h>
 #include <ImfThreading.h>
+#include <half.h>
 #include <openexr.h>
 
 using namespace OPENEXR_IMF_NAMESPACE;
@@ -396,11 +401,368 @@ readImf (
     }
 }
 
+class HeaderCopyTask : public Task
+{
+public:
+    HeaderCopyTask (
+        TaskGroup* g, const std::vector<Header>& headers, int copies, int n)
+        : Task (g), _headers (headers), _copies (copies), _n (n)
+    {}
+    void execute () override
+    {
+        // every other task sets compression levels on its headers,
+        // so copies both with and without a compression record are
+        // measured
+        std::vector<Header> local (_headers);
+        if (_n & 1)
+        {
+            for (Header& h: local)
+            {
+                h.zipCompressionLevel () = 9;
+                h.dwaCompressionLevel () = 90.f;
+            }
+        }
+
+        for (int i = 0; i < _copies; ++i)
+        {
+            Header copy (local[i % local.size ()]);
+            Header assigned;
+            assigned = copy;
+        }
+    }
+
+private:
+    const std::vector<Header>& _headers;
+    int                        _copies;
+    int                        _n;
+};
+
+static int
+copyHeaders (const std::vector<std::string>& files)
+{
+    std::vector<Header> headers;
+    for (auto& f: files)
+    {
+        try
+        {
+            MultiPartInputFile infile (f.c_str ());
+            for (int p = 0; p < infile.parts (); ++p)
+                headers.push_back (infile.header (p));
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "MultiPartInputFile: " << e.what () << std::endl;
+            return 1;
+        }
+    }
+
+    constexpr int copies     = 20000;
+    int           maxThreads = ThreadPool::estimateThreadCountForFileIO ();
+
+    std::cout << "Stats for copying: " << headers.size () << " headers "
+              << copies << " times per thread\n\n";
+
+    for (int n = 1; n <= std::max (maxThreads, 1); n *= 2)
+    {
+        ThreadPool pool (n);
+        auto       start = std::chrono::steady_clock::now ();
+        {
+            TaskGroup g;
+            for (int t = 0; t < n; ++t)
+                pool.addTask (new HeaderCopyTask (&g, headers, copies, t));
+        }
+        auto end = std::chrono::steady_clock::now ();
+
+        double secs = std::chrono::duration<double> (end - start).count ();
+        std::cout << " Threads: " << std::setw (4) << std::left << n
+                  << std::setw (15) << std::left
+                  << uint64_t (double (copies) * n / secs) << " copies/s\n";
+    }
+
+    return 0;
+}
+
+template <typename F>
+static double
+timeSecs (F fn)
+{
+    auto start = std::chrono::steady_clock::now ();
+    fn ();
+    auto end = std::chrono::steady_clock::now ();
+    return std::chrono::duration<double> (end - start).count ();
+}
+
+static int
+benchManifest (size_t entries)
+{
+    //
+    // cryptomatte style: one name per object, with many objects
+    // sharing a few prefixes
+    //
+    std::vector<std::string> names (entries);
+    std::vector<uint64_t>    ids (entries);
+    for (size_t i = 0; i < entries; ++i)
+    {
+        names[i] = "/root/set" + std::to_string (i % 97) + "/geo/object" +
+                   std::to_string (i);
+        ids[i] = IDManifest::MurmurHash64 (names[i]);
+    }
+
+    std::vector<char> data;
+    {
+        IDManifest mfst;
+        mfst.add ("crypto").setComponent ("name");
+        mfst[0].setHashScheme (IDManifest::MURMURHASH3_64);
+        for (size_t i = 0; i < entries; ++i)
+            mfst[0].insert (ids[i], names[i]);
+        mfst.serialize (data);
+    }
+
+    std::cout << "Stats for an ID manifest of " << entries << " entries ("
+              << data.size () << " bytes serialized)\n\n"
+              << std::setw (12) << std::left << " "
+              << std::setw (15) << std::left << "decode s"
+              << std::setw (15) << std::left << "lookup s"
+              << std::setw (15) << std::left << "insert s"
+              << std::setw (15) << std::left << "serialize s" << "\n";
+
+    uint64_t found = 0;
+    {
+        IDManifest        mfst;
+        std::vector<char> out;
+        double            decode = timeSecs (
+            [&] { mfst = IDManifest (data.data (), data.data () + data.size ()); });
+        double lookup = timeSecs ([&] {
+            for (size_t i = 0; i < entries; ++i)
+            {
+                auto it = mfst[0].find (ids[i]);
+                if (it != mfst[0].end ()) found += it.text ()[0].size ();
+            }
+        });
+        IDManifest fresh;
+        fresh.add ("crypto").setComponent ("name");
+        fresh[0].setHashScheme (IDManifest::MURMURHASH3_64);
+        double insert = timeSecs ([&] {
+            for (size_t i = 0; i < entries; ++i)
+                fresh[0].insert (ids[i], names[i]);
+        });
+        double serialize = timeSecs ([&] { fresh.serialize (out); });
+        std::cout << std::setw (12) << std::left << " map"
+                  << std::setw (15) << std::left << decode
+                  << std::setw (15) << std::left << lookup
+                  << std::setw (15) << std::left << insert
+                  << std::setw (15) << std::left << serialize << "\n";
+    }
+    {
+        CompactIDManifest mfst;
+        std::vector<char> out;
+        double            decode = timeSecs ([&] {
+            mfst = CompactIDManifest (data.data (), data.data () + data.size ());
+        });
+        double lookup = timeSecs ([&] {
+            for (size_t i = 0; i < entries; ++i)
+            {
+                size_t e = mfst[0].find (ids[i]);
+                if (e != CompactIDManifest::ChannelGroup::npos)
+                    found += mfst[0].textLength (e, 0);
+            }
+        });
+        CompactIDManifest fresh;
+        fresh.add ("crypto").setComponent ("name");
+        fresh[0].setHashScheme (IDManifest::MURMURHASH3_64);
+        double insert = timeSecs ([&] {
+            for (size_t i = 0; i < entries; ++i)
+                fresh[0].insert (ids[i], names[i]);
+        });
+        double serialize = timeSecs ([&] { fresh.serialize (out); });
+        std::cout << std::setw (12) << std::left << " compact"
+                  << std::setw (15) << std::left << decode
+                  << std::setw (15) << std::left << lookup
+                  << std::setw (15) << std::left << insert
+                  << std::setw (15) << std::left << serialize << "\n";
+        if (out != data)
+        {
+            std::cerr << "compact manifest serialized differently" << std::endl;
+            return 1;
+        }
+    }
+    {
+        //
+        // lazy manifests only index the data; lookups decode the
+        // entries they return
+        //
+        LazyIDManifest           mfst;
+        std::vector<std::string> text;
+        double                   decode = timeSecs ([&] {
+            mfst = LazyIDManifest (data.data (), data.data () + data.size ());
+        });
+        double lookup = timeSecs ([&] {
+            for (size_t i = 0; i < entries; ++i)
+            {
+                if (mfst.lookup (0, ids[i], text)) found += text[0].size ();
+            }
+        });
+        std::cout << std::setw (12) << std::left << " lazy"
+                  << std::setw (15) << std::left << decode
+                  << std::setw (15) << std::left << lookup
+                  << std::setw (15) << std::left << "-"
+                  << std::setw (15) << std::left << "-" << "\n";
+    }
+
+    return found == 0;
+}
+
+static void
+benchCompressor (
+    const char*              label,
+    Compression              comp,
+    const Header&            hdr,
+    const std::vector<char>& chunk,
+    int                      bpl)
+{
+    std::unique_ptr<Compressor> compressor (newCompressor (comp, bpl, hdr));
+    std::unique_ptr<Compressor> decompressor (newCompressor (comp, bpl, hdr));
+
+    const int   iters   = std::max (1, (200 << 20) / int (chunk.size ()));
+    const char* outPtr  = nullptr;
+    int         outSize = 0;
+
+    std::vector<char> packed;
+
+    double csecs = timeSecs ([&] {
+        for (int i = 0; i < iters; ++i)
+            outSize = compressor->compress (
+                chunk.data (), int (chunk.size ()), 0, outPtr);
+    });
+    packed.assign (outPtr, outPtr + outSize);
+
+    double usecs = timeSecs ([&] {
+        for (int i = 0; i < iters; ++i)
+            decompressor->uncompress (
+                packed.data (), int (packed.size ()), 0, outPtr);
+    });
+
+    double mb = double (chunk.size ()) * iters / (1024.0 * 1024.0);
+    std::cout << std::setw (12) << std::left << label << std::setw (15)
+              << std::left << double (chunk.size ()) / double (packed.size ())
+              << std::setw (15) << std::left << mb / csecs << std::setw (15)
+              << std::left << mb / usecs << "\n";
+}
+
+static int
+benchB44 (int width)
+{
+    //
+    // B44 codes 32 lines per chunk; time compressing and uncompressing
+    // a chunk of 4 half channels, one of which is perceptually linear
+    // (converted through the log / exp tables)
+    //
+    const int   lines   = 32;
+    const char* names[] = {"A", "B", "G", "R"};
+    const int   bpl     = width * 4 * 2;
+
+    std::vector<char> chunk (size_t (bpl) * lines);
+    for (int y = 0; y < lines; ++y)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            char* line = chunk.data () + size_t (y) * bpl + c * width * 2;
+            for (int x = 0; x < width; ++x)
+            {
+                half h (
+                    0.5f + 0.4f * sinf (x * 0.01f * (c + 1)) * cosf (y * 0.1f) +
+                    float ((x * 7919 + y * 104729) % 97) * 0.0005f);
+                uint16_t bits = h.bits ();
+                line[2 * x]     = char (bits & 0xff);
+                line[2 * x + 1] = char (bits >> 8);
+            }
+        }
+    }
+
+    std::cout << "Stats for B44 chunks of " << width << " x " << lines
+              << " pixels, 4 half channels\n\n"
+              << std::setw (12) << std::left << " "
+              << std::setw (15) << std::left << "ratio"
+              << std::setw (15) << std::left << "compress MB/s"
+              << std::setw (15) << std::left << "uncompress MB/s" << "\n";
+
+    for (Compression comp: {B44_COMPRESSION, B44A_COMPRESSION})
+    {
+        Header hdr (width, lines);
+        hdr.compression () = comp;
+        for (int c = 0; c < 4; ++c)
+            hdr.channels ().insert (names[c], Channel (HALF, 1, 1, c == 3));
+
+        benchCompressor (
+            comp == B44_COMPRESSION ? " b44" : " b44a",
+            comp,
+            hdr,
+            chunk,
+            bpl);
+    }
+
+    return 0;
+}
+
+static int
+benchRle (int width)
+{
+    //
+    // RLE and ZIPS code a single line per chunk, and share the byte
+    // reorder and predictor. Use a mix of flat areas (which RLE is
+    // good at) and noisy ones, over 4 half channels
+    //
+    const char* names[] = {"A", "B", "G", "R"};
+    const int   bpl     = width * 4 * 2;
+
+    std::vector<char> chunk (bpl);
+    for (int c = 0; c < 4; ++c)
+    {
+        char* line = chunk.data () + c * width * 2;
+        for (int x = 0; x < width; ++x)
+        {
+            float v = float ((x / 64 + c) % 4) * 0.25f;
+            if ((x / 256) % 3 == 0)
+                v += float ((x * 7919 + c * 104729) % 97) * 0.001f;
+            uint16_t bits   = half (v).bits ();
+            line[2 * x]     = char (bits & 0xff);
+            line[2 * x + 1] = char (bits >> 8);
+        }
+    }
+
+    std::cout << "Stats for single line chunks of " << width
+              << " pixels, 4 half channels\n\n"
+              << std::setw (12) << std::left << " "
+              << std::setw (15) << std::left << "ratio"
+              << std::setw (15) << std::left << "compress MB/s"
+              << std::setw (15) << std::left << "uncompress MB/s" << "\n";
+
+    for (Compression comp: {RLE_COMPRESSION, ZIPS_COMPRESSION})
+    {
+        Header hdr (width, 1);
+        hdr.compression () = comp;
+        for (int c = 0; c < 4; ++c)
+            hdr.channels ().insert (names[c], Channel (HALF));
+
+        benchCompressor (
+            comp == RLE_COMPRESSION ? " rle" : " zips",
+            comp,
+            hdr,
+            chunk,
+            bpl);
+    }
+
+    return 0;
+}
+
 static int
 usageAndExit (const char* argv0, int ec)
 {
-    std::cerr << "Usage: " << argv0 << "[--imf|--core] <file1> [<file2>...]"
-              << std::endl;
+    std::cerr << "Usage: " << argv0
+              << "[--imf|--core|--headers] <file1> [<file2>...]\n"
+              << "       " << argv0 << " --manifest [<entries>]\n"
+              << "       " << argv0 << " --b44 [<width>]\n"
+              << "       " << argv0 << " --rle [<width>]" << std::endl;
     return ec;
 }
 
@@ -409,6 +771,7 @@ main (int argc, char* argv[])
 {
     std::vector<std::string> files;
     bool                     coreOnly = false, imfOnly = false;
+    bool                     headersOnly = false;
     for (int a = 1; a < argc; ++a)
     {
         if (!strcmp (argv[a], "-h") || !strcmp (argv[a], "--help") ||
@@ -436,12 +799,38 @@ main (int argc, char* argv[])
                 return usageAndExit (argv[0], 1);
             }
         }
+        else if (!strcmp (argv[a], "--manifest"))
+        {
+            size_t entries = 1000000;
+            if (a + 1 < argc) entries = strtoul (argv[a + 1], nullptr, 10);
+            return benchManifest (entries);
+        }
+        else if (!strcmp (argv[a], "--b44"))
+        {
+            int width = 3840;
+            if (a + 1 < argc) width = atoi (argv[a + 1]);
+            if (width <= 0) return usageAndExit (argv[0], 1);
+            return benchB44 (width);
+        }
+        else if (!strcmp (argv[a], "--rle"))
+        {
+            int width = 3840;
+            if (a + 1 < argc) width = atoi (argv[a + 1]);
+            if (width <= 0) return usageAndExit (argv[0], 1);
+            return benchRle (width);
+        }
+        else if (!strcmp (argv[a], "--headers"))
+        {
+            headersOnly = true;
+        }
         else
             files.push_back (argv[a]);
     }
 
     if (files.empty ()) return usageAndExit (argv[0], 1);
 
+    if (headersOnly) return copyHeaders (files);
+
     setGlobalThreadCount (THREADS);
     bool     odd          = false;
     uint64_t headerNanosN = 0, dataNanosN = 0, closeNanosN = 0, pixCountN = 0,
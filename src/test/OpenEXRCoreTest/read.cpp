@@ -12,9 +12,12 @@
 #include <math.h>
 #include <string.h>
 
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <thread>
+#include <vector>
 
 static void
 err_cb (exr_const_context_t f, int code, const char* msg)
@@ -616,3 +619,843 @@ testReadUnpack (const std::string& tempdir)
 
     exr_finish (&f);
 }
+
+////////////////////////////////////////
+
+struct ParallelTestChannel
+{
+    std::string          name;
+    int                  bpe;
+    uint16_t             type;
+    int                  width;
+    int                  xs;
+    int                  ys;
+    std::vector<uint8_t> serial;
+    std::vector<uint8_t> parallel;
+};
+
+static void
+decodeSerial (
+    exr_context_t                     f,
+    int                               lx,
+    int                               ly,
+    std::vector<ParallelTestChannel>& chans)
+{
+    exr_storage_t    st;
+    exr_attr_box2i_t dw;
+    exr_chunk_info_t cinfo;
+    std::vector<exr_chunk_info_t> chunks;
+
+    EXRCORE_TEST_RVAL (exr_get_storage (f, 0, &st));
+    EXRCORE_TEST_RVAL (exr_get_data_window (f, 0, &dw));
+
+    int32_t tw = 0, th = 0;
+    if (st == EXR_STORAGE_TILED)
+    {
+        int32_t cx, cy;
+        uint32_t txsz, tysz;
+        EXRCORE_TEST_RVAL (exr_get_tile_counts (f, 0, lx, ly, &cx, &cy));
+        EXRCORE_TEST_RVAL (
+            exr_get_tile_descriptor (f, 0, &txsz, &tysz, NULL, NULL));
+        tw = (int32_t) txsz;
+        th = (int32_t) tysz;
+        for (int ty = 0; ty < cy; ++ty)
+            for (int tx = 0; tx < cx; ++tx)
+            {
+                EXRCORE_TEST_RVAL (
+                    exr_read_tile_chunk_info (f, 0, tx, ty, lx, ly, &cinfo));
+                chunks.push_back (cinfo);
+            }
+    }
+    else
+    {
+        int32_t lpc;
+        EXRCORE_TEST_RVAL (exr_get_scanlines_per_chunk (f, 0, &lpc));
+        for (int y = dw.min.y; y <= dw.max.y; y += lpc)
+        {
+            EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (f, 0, y, &cinfo));
+            chunks.push_back (cinfo);
+        }
+    }
+
+    for (auto& ci: chunks)
+    {
+        exr_decode_pipeline_t decoder;
+        int64_t               x0, y0;
+
+        EXRCORE_TEST_RVAL (exr_decoding_initialize (f, 0, &ci, &decoder));
+        if (st == EXR_STORAGE_TILED)
+        {
+            x0 = (int64_t) ci.start_x * tw;
+            y0 = (int64_t) ci.start_y * th;
+        }
+        else
+        {
+            x0 = 0;
+            y0 = ci.start_y - dw.min.y;
+        }
+        for (int c = 0; c < decoder.channel_count; ++c)
+        {
+            exr_coding_channel_info_t& dc = decoder.channels[c];
+            ParallelTestChannel&       pc = chans[c];
+            dc.decode_to_ptr =
+                pc.serial.data () +
+                ((y0 / pc.ys) * pc.width + (x0 / pc.xs)) * pc.bpe;
+            dc.user_pixel_stride = pc.bpe;
+            dc.user_line_stride  = pc.bpe * pc.width;
+        }
+        EXRCORE_TEST_RVAL (
+            exr_decoding_choose_default_routines (f, 0, &decoder));
+        EXRCORE_TEST_RVAL (exr_decoding_run (f, 0, &decoder));
+        EXRCORE_TEST_RVAL (exr_decoding_destroy (f, &decoder));
+    }
+}
+
+static int
+threadSpawn (void* userdata, exr_task_fn_t fn, void* taskdata)
+{
+    std::vector<std::thread>* threads =
+        static_cast<std::vector<std::thread>*> (userdata);
+    threads->emplace_back (fn, taskdata);
+    return 0;
+}
+
+static int
+refuseSpawn (void* userdata, exr_task_fn_t fn, void* taskdata)
+{
+    return 1;
+}
+
+static void
+initTestChannels (
+    exr_context_t                     f,
+    int                               lx,
+    int                               ly,
+    std::vector<ParallelTestChannel>& chans)
+{
+    exr_storage_t            st;
+    exr_attr_box2i_t         dw;
+    const exr_attr_chlist_t* chl;
+    EXRCORE_TEST_RVAL (exr_get_storage (f, 0, &st));
+    EXRCORE_TEST_RVAL (exr_get_data_window (f, 0, &dw));
+    EXRCORE_TEST_RVAL (exr_get_channels (f, 0, &chl));
+
+    int32_t w = dw.max.x - dw.min.x + 1;
+    int32_t h = dw.max.y - dw.min.y + 1;
+    if (st == EXR_STORAGE_TILED)
+        EXRCORE_TEST_RVAL (exr_get_level_sizes (f, 0, lx, ly, &w, &h));
+
+    chans.resize (chl->num_channels);
+    for (int c = 0; c < chl->num_channels; ++c)
+    {
+        ParallelTestChannel& pc = chans[c];
+        pc.name  = chl->entries[c].name.str;
+        pc.type  = (uint16_t) chl->entries[c].pixel_type;
+        pc.bpe   = (chl->entries[c].pixel_type == EXR_PIXEL_HALF) ? 2 : 4;
+        pc.xs    = chl->entries[c].x_sampling;
+        pc.ys    = chl->entries[c].y_sampling;
+        pc.width = w / pc.xs;
+
+        size_t bytes = (size_t) pc.width * (size_t) (h / pc.ys) * pc.bpe;
+        pc.serial.assign (bytes, 0);
+        pc.parallel.assign (bytes, 0);
+    }
+}
+
+static void
+testParallelFile (const char* name, int lx, int ly)
+{
+    exr_context_t             f;
+    std::string               fn    = ILM_IMF_TEST_IMAGEDIR;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+
+    fn += name;
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+
+    exr_storage_t    st;
+    exr_attr_box2i_t dw;
+    EXRCORE_TEST_RVAL (exr_get_storage (f, 0, &st));
+    EXRCORE_TEST_RVAL (exr_get_data_window (f, 0, &dw));
+
+    int32_t h = dw.max.y - dw.min.y + 1;
+    if (st == EXR_STORAGE_TILED)
+        EXRCORE_TEST_RVAL (exr_get_level_sizes (f, 0, lx, ly, NULL, &h));
+
+    std::vector<ParallelTestChannel> chans;
+    initTestChannels (f, lx, ly, chans);
+
+    std::vector<exr_decode_channel_buffer_t> bufs (chans.size ());
+    for (size_t c = 0; c < chans.size (); ++c)
+    {
+        ParallelTestChannel& pc = chans[c];
+
+        bufs[c].channel_name           = pc.name.c_str ();
+        bufs[c].base                   = pc.parallel.data ();
+        bufs[c].pixel_stride           = pc.bpe;
+        bufs[c].line_stride            = pc.bpe * pc.width;
+        bufs[c].user_bytes_per_element = (int16_t) pc.bpe;
+        bufs[c].user_data_type         = pc.type;
+    }
+
+    decodeSerial (f, lx, ly, chans);
+
+    exr_decode_part_parallel_options_t opts =
+        EXR_DECODE_PART_PARALLEL_OPTIONS_INITIALIZER;
+    opts.channels     = bufs.data ();
+    opts.num_channels = (int) bufs.size ();
+    opts.level_x      = lx;
+    opts.level_y      = ly;
+    opts.num_threads  = 4;
+
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_MISSING_CONTEXT_ARG, exr_decode_part_parallel (NULL, 0, &opts));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_ARGUMENT_OUT_OF_RANGE, exr_decode_part_parallel (f, 1, &opts));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT, exr_decode_part_parallel (f, 0, NULL));
+    opts.chunk_begin = -1;
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_ARGUMENT_OUT_OF_RANGE, exr_decode_part_parallel (f, 0, &opts));
+    opts.chunk_begin = 0;
+
+    // built-in threads
+    EXRCORE_TEST_RVAL (exr_decode_part_parallel (f, 0, &opts));
+    for (auto& pc: chans)
+        EXRCORE_TEST (pc.serial == pc.parallel);
+
+    // external spawner
+    std::vector<std::thread> threads;
+    for (auto& pc: chans)
+        std::fill (pc.parallel.begin (), pc.parallel.end (), 0);
+    opts.spawn_fn        = &threadSpawn;
+    opts.spawn_user_data = &threads;
+    EXRCORE_TEST_RVAL (exr_decode_part_parallel (f, 0, &opts));
+    for (auto& t: threads)
+        t.join ();
+    for (auto& pc: chans)
+        EXRCORE_TEST (pc.serial == pc.parallel);
+
+    // spawner which refuses work falls back to the calling thread,
+    // also only decode the second half of the chunks
+    int32_t nchunks;
+    if (st == EXR_STORAGE_TILED)
+    {
+        int32_t cx, cy;
+        EXRCORE_TEST_RVAL (exr_get_tile_counts (f, 0, lx, ly, &cx, &cy));
+        nchunks = cx * cy;
+    }
+    else
+    {
+        int32_t lpc;
+        EXRCORE_TEST_RVAL (exr_get_scanlines_per_chunk (f, 0, &lpc));
+        nchunks = (h + lpc - 1) / lpc;
+    }
+    for (auto& pc: chans)
+        std::fill (pc.parallel.begin (), pc.parallel.end (), 0);
+    opts.spawn_fn    = &refuseSpawn;
+    opts.chunk_begin = nchunks / 2;
+    EXRCORE_TEST_RVAL (exr_decode_part_parallel (f, 0, &opts));
+    opts.chunk_end = opts.chunk_begin;
+    opts.chunk_begin = 0;
+    EXRCORE_TEST_RVAL (exr_decode_part_parallel (f, 0, &opts));
+    for (auto& pc: chans)
+        EXRCORE_TEST (pc.serial == pc.parallel);
+
+    opts.chunk_end = nchunks + 1;
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_ARGUMENT_OUT_OF_RANGE, exr_decode_part_parallel (f, 0, &opts));
+
+    exr_finish (&f);
+}
+
+void
+testReadParallel (const std::string& tempdir)
+{
+    testParallelFile ("comp_piz.exr", 0, 0);
+    testParallelFile ("comp_zip.exr", 0, 0);
+    testParallelFile ("comp_dwab_v2.exr", 0, 0);
+    testParallelFile ("v1.7.test.interleaved.exr", 0, 0);
+    testParallelFile ("v1.7.test.tiled.exr", 0, 0);
+}
+
+static int s_pool_allocs = 0;
+static void*
+pool_counting_malloc (size_t bytes)
+{
+    ++s_pool_allocs;
+    return malloc (bytes);
+}
+
+static void
+pool_free (void* p)
+{
+    free (p);
+}
+
+static int s_pool_frees = 0;
+static void
+pool_counting_free (void* p)
+{
+    ++s_pool_frees;
+    free (p);
+}
+
+void
+testReadBufferPool (const std::string& tempdir)
+{
+    exr_context_t             f;
+    exr_buffer_pool_t         pool = NULL;
+    exr_buffer_pool_t         cur  = NULL;
+    std::string               fn   = ILM_IMF_TEST_IMAGEDIR;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+    cinit.alloc_fn                  = &malloc;
+    cinit.free_fn                   = &pool_free;
+    size_t cached;
+
+    fn += "comp_piz.exr";
+
+    // reference decode using the pool owned by the context
+    std::vector<ParallelTestChannel> ref;
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_MISSING_CONTEXT_ARG, exr_get_buffer_pool (NULL, &cur));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT, exr_get_buffer_pool (f, NULL));
+    EXRCORE_TEST_RVAL (exr_get_buffer_pool (f, &cur));
+    EXRCORE_TEST (cur != NULL);
+    initTestChannels (f, 0, 0, ref);
+    decodeSerial (f, 0, 0, ref);
+    EXRCORE_TEST_RVAL (exr_buffer_pool_get_cached_bytes (cur, &cached));
+    EXRCORE_TEST (cached > 0);
+    // can't destroy the context's pool
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT, exr_buffer_pool_destroy (&cur));
+    EXRCORE_TEST_RVAL (exr_buffer_pool_trim (cur));
+    EXRCORE_TEST_RVAL (exr_buffer_pool_get_cached_bytes (cur, &cached));
+    EXRCORE_TEST (cached == 0);
+    exr_finish (&f);
+
+    // mismatched memory routines are rejected
+    EXRCORE_TEST_RVAL (exr_buffer_pool_create (&pool, 0, NULL, NULL));
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT, exr_set_buffer_pool (f, pool));
+    exr_finish (&f);
+    EXRCORE_TEST_RVAL (exr_buffer_pool_destroy (&pool));
+    EXRCORE_TEST (pool == NULL);
+
+    // a shared pool re-used across a sequence of "frames" only
+    // allocates for the first one
+    EXRCORE_TEST_RVAL (exr_buffer_pool_create (
+        &pool, 64 * 1024 * 1024, &pool_counting_malloc, &pool_free));
+    s_pool_allocs  = 0;
+    int firstframe = 0;
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        std::vector<ParallelTestChannel> chans;
+        EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+        EXRCORE_TEST_RVAL (exr_set_buffer_pool (f, pool));
+        EXRCORE_TEST_RVAL (exr_get_buffer_pool (f, &cur));
+        EXRCORE_TEST (cur == pool);
+        initTestChannels (f, 0, 0, chans);
+        decodeSerial (f, 0, 0, chans);
+        exr_finish (&f);
+
+        for (size_t c = 0; c < chans.size (); ++c)
+            EXRCORE_TEST (chans[c].serial == ref[c].serial);
+        if (frame == 0)
+        {
+            firstframe = s_pool_allocs;
+            EXRCORE_TEST (firstframe > 0);
+        }
+        else
+            EXRCORE_TEST (s_pool_allocs == firstframe);
+    }
+    EXRCORE_TEST_RVAL (exr_buffer_pool_get_cached_bytes (pool, &cached));
+    EXRCORE_TEST (cached > 0);
+    EXRCORE_TEST_RVAL (exr_buffer_pool_set_max_bytes (pool, 0));
+    EXRCORE_TEST_RVAL (exr_buffer_pool_get_cached_bytes (pool, &cached));
+    EXRCORE_TEST (cached == 0);
+    EXRCORE_TEST_RVAL (exr_buffer_pool_destroy (&pool));
+
+    // cached zlib states count against the limit, the same as buffers
+    fn = ILM_IMF_TEST_IMAGEDIR;
+    fn += "comp_zip.exr";
+    EXRCORE_TEST_RVAL (
+        exr_buffer_pool_create (&pool, 16 * 1024, &malloc, &pool_free));
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        std::vector<ParallelTestChannel> chans;
+        EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+        EXRCORE_TEST_RVAL (exr_set_buffer_pool (f, pool));
+        initTestChannels (f, 0, 0, chans);
+        decodeSerial (f, 0, 0, chans);
+        exr_finish (&f);
+
+        EXRCORE_TEST_RVAL (exr_buffer_pool_get_cached_bytes (pool, &cached));
+        EXRCORE_TEST (cached <= 16 * 1024);
+    }
+    EXRCORE_TEST_RVAL (exr_buffer_pool_trim (pool));
+    EXRCORE_TEST_RVAL (exr_buffer_pool_get_cached_bytes (pool, &cached));
+    EXRCORE_TEST (cached == 0);
+    EXRCORE_TEST_RVAL (exr_buffer_pool_destroy (&pool));
+
+    // the zlib states are kept in the pool from one chunk to the next,
+    // let go of on a trim, and not kept at all by a pool which may not
+    // cache anything. The context and the pool share the counting
+    // routines, so the states libdeflate allocates are counted too.
+    std::vector<uint8_t> raw (64 * 1024);
+    std::vector<uint8_t> packed (exr_compress_max_buffer_size (raw.size ()));
+    std::vector<uint8_t> unpacked (raw.size ());
+    for (size_t i = 0; i < raw.size (); ++i)
+        raw[i] = (uint8_t) ((i * 7) ^ (i >> 5));
+
+    cinit.alloc_fn = &pool_counting_malloc;
+    cinit.free_fn  = &pool_counting_free;
+    for (size_t maxbytes: {(size_t) 64 * 1024 * 1024, (size_t) 0})
+    {
+        EXRCORE_TEST_RVAL (exr_buffer_pool_create (
+            &pool, maxbytes, &pool_counting_malloc, &pool_counting_free));
+        EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+        EXRCORE_TEST_RVAL (exr_set_buffer_pool (f, pool));
+
+        bool caches   = true;
+        s_pool_allocs = 0;
+        s_pool_frees  = 0;
+        for (int chunk = 0; chunk < 4; ++chunk)
+        {
+            size_t outsz = 0, insz = 0;
+            EXRCORE_TEST_RVAL (exr_compress_buffer (
+                f,
+                4,
+                raw.data (),
+                raw.size (),
+                packed.data (),
+                packed.size (),
+                &outsz));
+            EXRCORE_TEST_RVAL (exr_uncompress_buffer (
+                f,
+                packed.data (),
+                outsz,
+                unpacked.data (),
+                unpacked.size (),
+                &insz));
+            EXRCORE_TEST (insz == raw.size () && unpacked == raw);
+
+            if (chunk == 0)
+            {
+                firstframe = s_pool_allocs;
+                EXRCORE_TEST (firstframe > 0);
+                EXRCORE_TEST_RVAL (
+                    exr_buffer_pool_get_cached_bytes (pool, &cached));
+                if (maxbytes == 0)
+                {
+                    EXRCORE_TEST (cached == 0);
+                    EXRCORE_TEST (s_pool_frees == s_pool_allocs);
+                }
+                else if (cached == 0)
+                {
+                    // libdeflate older than 1.19 has a process wide
+                    // allocator, and its states are never cached
+                    std::cout << "  libdeflate can't cache states, skipping"
+                              << std::endl;
+                    caches = false;
+                }
+            }
+            else if (maxbytes == 0)
+            {
+                // new states every time, freed straight away
+                EXRCORE_TEST (s_pool_allocs == firstframe * (chunk + 1));
+                EXRCORE_TEST (s_pool_frees == s_pool_allocs);
+            }
+            else if (caches)
+            {
+                EXRCORE_TEST (s_pool_allocs == firstframe);
+                EXRCORE_TEST (s_pool_frees == 0);
+            }
+        }
+
+        EXRCORE_TEST_RVAL (exr_buffer_pool_get_cached_bytes (pool, &cached));
+        if (maxbytes != 0 && caches)
+        {
+            EXRCORE_TEST (cached > 0);
+            EXRCORE_TEST_RVAL (exr_buffer_pool_trim (pool));
+            EXRCORE_TEST_RVAL (
+                exr_buffer_pool_get_cached_bytes (pool, &cached));
+            EXRCORE_TEST (s_pool_frees == firstframe);
+        }
+        EXRCORE_TEST (cached == 0);
+        exr_finish (&f);
+        EXRCORE_TEST_RVAL (exr_buffer_pool_destroy (&pool));
+    }
+}
+
+static void
+testReconstructFile (const std::string& tempdir, const char* name)
+{
+    exr_context_t             f;
+    std::string               fn    = ILM_IMF_TEST_IMAGEDIR;
+    std::string               dfn   = tempdir;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+    uint64_t*                 table;
+    uint64_t                  cto;
+    int32_t                   count;
+
+    fn += name;
+    dfn += "reconstruct_";
+    dfn += name;
+
+    std::vector<ParallelTestChannel> ref;
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_get_chunk_table (f, 0, &table, &count));
+    EXRCORE_TEST_RVAL (exr_get_chunk_table_offset (f, 0, &cto));
+    std::vector<uint64_t> reftable (table, table + count);
+    initTestChannels (f, 0, 0, ref);
+    decodeSerial (f, 0, 0, ref);
+    exr_finish (&f);
+
+    // simulate a file which was never finished, so the chunk table
+    // was never written
+    std::vector<char> bytes;
+    {
+        std::ifstream in (fn.c_str (), std::ios::binary);
+        bytes.assign (
+            std::istreambuf_iterator<char> (in),
+            std::istreambuf_iterator<char> ());
+    }
+    EXRCORE_TEST (cto + reftable.size () * sizeof (uint64_t) <= bytes.size ());
+    memset (bytes.data () + cto, 0, reftable.size () * sizeof (uint64_t));
+    {
+        std::ofstream out (dfn.c_str (), std::ios::binary);
+        out.write (bytes.data (), (std::streamsize) bytes.size ());
+    }
+
+    std::vector<ParallelTestChannel> chans;
+    EXRCORE_TEST_RVAL (exr_start_read (&f, dfn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_get_chunk_table (f, 0, &table, &count));
+    EXRCORE_TEST (std::vector<uint64_t> (table, table + count) == reftable);
+    initTestChannels (f, 0, 0, chans);
+    decodeSerial (f, 0, 0, chans);
+    for (size_t c = 0; c < chans.size (); ++c)
+        EXRCORE_TEST (chans[c].serial == ref[c].serial);
+    exr_finish (&f);
+
+    // a cached table can be provided to avoid the reconstruction
+    EXRCORE_TEST_RVAL (exr_start_read (&f, dfn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_MISSING_CONTEXT_ARG,
+        exr_set_chunk_table (NULL, 0, reftable.data (), count));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_ARGUMENT_OUT_OF_RANGE,
+        exr_set_chunk_table (f, 1, reftable.data (), count));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT, exr_set_chunk_table (f, 0, NULL, count));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT,
+        exr_set_chunk_table (f, 0, reftable.data (), count + 1));
+    EXRCORE_TEST_RVAL (exr_set_chunk_table (f, 0, reftable.data (), count));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT,
+        exr_set_chunk_table (f, 0, reftable.data (), count));
+    EXRCORE_TEST_RVAL (exr_validate_chunk_table (f, 0));
+    EXRCORE_TEST_RVAL (exr_get_chunk_table (f, 0, &table, &count));
+    EXRCORE_TEST (std::vector<uint64_t> (table, table + count) == reftable);
+    for (auto& pc: chans)
+        std::fill (pc.serial.begin (), pc.serial.end (), 0);
+    decodeSerial (f, 0, 0, chans);
+    for (size_t c = 0; c < chans.size (); ++c)
+        EXRCORE_TEST (chans[c].serial == ref[c].serial);
+    exr_finish (&f);
+
+    remove (dfn.c_str ());
+}
+
+void
+testReadReconstructChunkTable (const std::string& tempdir)
+{
+    testReconstructFile (tempdir, "comp_zip.exr");
+    testReconstructFile (tempdir, "comp_none.exr");
+    testReconstructFile (tempdir, "v1.7.test.tiled.exr");
+}
+
+struct CountingStream
+{
+    FILE*   file;
+    int64_t size;
+    int     reads;
+};
+
+static int64_t
+countingRead (
+    exr_const_context_t         f,
+    void*                       userdata,
+    void*                       buffer,
+    uint64_t                    sz,
+    uint64_t                    offset,
+    exr_stream_error_func_ptr_t errcb)
+{
+    CountingStream* s = static_cast<CountingStream*> (userdata);
+    ++s->reads;
+    if (fseek (s->file, (long) offset, SEEK_SET) != 0) return -1;
+    return (int64_t) fread (buffer, 1, sz, s->file);
+}
+
+static int64_t
+countingSize (exr_const_context_t f, void* userdata)
+{
+    return static_cast<CountingStream*> (userdata)->size;
+}
+
+// returns the number of reads needed to parse the header
+static int
+openCounted (
+    const std::string& fn,
+    size_t             readsize,
+    bool               knownsize,
+    int32_t            expectattrs,
+    uint64_t           expectcto)
+{
+    exr_context_t             f;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    CountingStream            s;
+    int32_t                   attrs;
+    uint64_t                  cto;
+
+    s.file = fopen (fn.c_str (), "rb");
+    EXRCORE_TEST (s.file != NULL);
+    fseek (s.file, 0, SEEK_END);
+    s.size  = ftell (s.file);
+    s.reads = 0;
+
+    cinit.error_handler_fn = &err_cb;
+    cinit.user_data        = &s;
+    cinit.read_fn          = &countingRead;
+    cinit.size_fn          = knownsize ? &countingSize : NULL;
+    cinit.header_read_size = readsize;
+
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_get_attribute_count (f, 0, &attrs));
+    EXRCORE_TEST (attrs == expectattrs);
+    EXRCORE_TEST_RVAL (exr_get_chunk_table_offset (f, 0, &cto));
+    EXRCORE_TEST (cto == expectcto);
+    int reads = s.reads;
+    exr_finish (&f);
+    fclose (s.file);
+    return reads;
+}
+
+void
+testReadHeaderSize (const std::string& tempdir)
+{
+    exr_context_t             f;
+    std::string               fn    = ILM_IMF_TEST_IMAGEDIR;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+    int32_t                   attrs;
+    uint64_t                  cto;
+
+    fn += "v1.7.test.1.exr";
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_get_attribute_count (f, 0, &attrs));
+    exr_finish (&f);
+
+    // small header: the magic number, then the whole header in one read
+    EXRCORE_TEST (openCounted (fn, 0, true, attrs, 331) == 2);
+    EXRCORE_TEST (openCounted (fn, 1, true, attrs, 331) == 2);
+    EXRCORE_TEST (openCounted (fn, 1 << 20, true, attrs, 331) == 2);
+    // unknown size streams still read a byte at a time
+    EXRCORE_TEST (openCounted (fn, 0, false, attrs, 331) > 300);
+
+    // large header: a long string attribute spanning several reads
+    std::string lfn = tempdir;
+    lfn += "header_read_size.exr";
+
+    std::string longstr (300 * 1024, 'x');
+    int         partidx;
+    uint16_t    line[8] = {0};
+
+    EXRCORE_TEST_RVAL (exr_start_write (
+        &f, lfn.c_str (), EXR_WRITE_FILE_DIRECTLY, &cinit));
+    EXRCORE_TEST_RVAL (
+        exr_add_part (f, "big", EXR_STORAGE_SCANLINE, &partidx));
+    EXRCORE_TEST_RVAL (exr_initialize_required_attr_simple (
+        f, partidx, 8, 8, EXR_COMPRESSION_NONE));
+    EXRCORE_TEST_RVAL (exr_add_channel (
+        f, partidx, "Y", EXR_PIXEL_HALF, EXR_PERCEPTUALLY_LOGARITHMIC, 1, 1));
+    EXRCORE_TEST_RVAL (
+        exr_attr_set_string (f, partidx, "comments", longstr.c_str ()));
+    EXRCORE_TEST_RVAL (exr_write_header (f));
+    for (int y = 0; y < 8; ++y)
+    {
+        exr_chunk_info_t cinfo;
+        EXRCORE_TEST_RVAL (exr_write_scanline_chunk_info (f, partidx, y, &cinfo));
+        EXRCORE_TEST_RVAL (
+            exr_write_scanline_chunk (f, partidx, y, line, sizeof (line)));
+    }
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+
+    EXRCORE_TEST_RVAL (exr_start_read (&f, lfn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_get_attribute_count (f, 0, &attrs));
+    EXRCORE_TEST_RVAL (exr_get_chunk_table_offset (f, 0, &cto));
+    const exr_attribute_t* attr;
+    EXRCORE_TEST_RVAL (exr_get_attribute_by_name (f, 0, "comments", &attr));
+    EXRCORE_TEST (attr->string->length == (int32_t) longstr.size ());
+    exr_finish (&f);
+
+    // default size grows 64k, 128k, 256k
+    EXRCORE_TEST (openCounted (lfn, 0, true, attrs, cto) <= 4);
+    EXRCORE_TEST (openCounted (lfn, 1 << 20, true, attrs, cto) == 2);
+    EXRCORE_TEST (openCounted (lfn, 4096, true, attrs, cto) < 16);
+    EXRCORE_TEST (openCounted (lfn, 0, false, attrs, cto) > 0);
+
+    remove (lfn.c_str ());
+}
+
+static void
+testIndexedFile (const std::string& tempdir, const char* name)
+{
+    exr_context_t             f;
+    std::string               fn    = ILM_IMF_TEST_IMAGEDIR;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+    uint64_t*                 table;
+    int32_t                   count;
+    size_t                    entrysize = 0;
+
+    fn += name;
+
+    std::vector<ParallelTestChannel> ref;
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_get_index_entry (f, NULL, &entrysize));
+    std::vector<uint8_t> entry (entrysize);
+    size_t               small = entrysize - 1;
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_ARGUMENT_OUT_OF_RANGE,
+        exr_get_index_entry (f, entry.data (), &small));
+    EXRCORE_TEST_RVAL (exr_get_index_entry (f, entry.data (), &entrysize));
+    EXRCORE_TEST (entrysize == entry.size ());
+    EXRCORE_TEST_RVAL (exr_get_chunk_table (f, 0, &table, &count));
+    std::vector<uint64_t> reftable (table, table + count);
+    initTestChannels (f, 0, 0, ref);
+    decodeSerial (f, 0, 0, ref);
+    exr_finish (&f);
+
+    // opening from the entry should not read anything until the pixels
+    CountingStream s;
+    s.file = fopen (fn.c_str (), "rb");
+    EXRCORE_TEST (s.file != NULL);
+    fseek (s.file, 0, SEEK_END);
+    s.size  = ftell (s.file);
+    s.reads = 0;
+
+    exr_context_initializer_t ccinit = cinit;
+    ccinit.user_data                 = &s;
+    ccinit.read_fn                   = &countingRead;
+    ccinit.size_fn                   = &countingSize;
+
+    std::vector<ParallelTestChannel> chans;
+    EXRCORE_TEST_RVAL (exr_start_read_indexed (
+        &f, fn.c_str (), entry.data (), entry.size (), &ccinit));
+    EXRCORE_TEST_RVAL (exr_get_chunk_table (f, 0, &table, &count));
+    EXRCORE_TEST (std::vector<uint64_t> (table, table + count) == reftable);
+    EXRCORE_TEST (s.reads == 0);
+    initTestChannels (f, 0, 0, chans);
+    decodeSerial (f, 0, 0, chans);
+    EXRCORE_TEST (s.reads > 0);
+    for (size_t c = 0; c < chans.size (); ++c)
+        EXRCORE_TEST (chans[c].serial == ref[c].serial);
+
+    // the entry is not referenced after the context is created
+    size_t               entrysize2 = entry.size ();
+    std::vector<uint8_t> entry2 (entrysize2);
+    EXRCORE_TEST_RVAL (exr_get_index_entry (f, entry2.data (), &entrysize2));
+    EXRCORE_TEST (entry2 == entry);
+    exr_finish (&f);
+    fclose (s.file);
+
+    // a truncated or damaged entry is rejected up front
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT,
+        exr_start_read_indexed (
+            &f, fn.c_str (), entry.data (), entry.size () - 1, &cinit));
+    EXRCORE_TEST (f == NULL);
+    entry2[0] = 'X';
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT,
+        exr_start_read_indexed (
+            &f, fn.c_str (), entry2.data (), entry2.size (), &cinit));
+
+    // an entry for a file of a different size is considered stale
+    std::string ofn = ILM_IMF_TEST_IMAGEDIR;
+    ofn += "v1.7.test.1.exr";
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_FILE_BAD_HEADER,
+        exr_start_read_indexed (
+            &f, ofn.c_str (), entry.data (), entry.size (), &cinit));
+    EXRCORE_TEST (f == NULL);
+
+    // lookup in an index of several entries
+    std::vector<uint8_t> index;
+    auto                 put = [&index] (const void* p, size_t n) {
+        index.insert (
+            index.end (),
+            static_cast<const uint8_t*> (p),
+            static_cast<const uint8_t*> (p) + n);
+    };
+    auto putle = [&index] (uint64_t v, int nbytes) {
+        for (int b = 0; b < nbytes; ++b)
+            index.push_back ((uint8_t) (v >> (8 * b)));
+    };
+    const char* names[] = {"frame.0001.exr", "frame.0002.exr"};
+    put ("EXRX", 4);
+    putle (1, 4);
+    putle (2, 8);
+    for (const char* n: names)
+    {
+        size_t namelen = strlen (n) + 1;
+        putle (namelen, 4);
+        putle (0, 4);
+        putle (entry.size (), 8);
+        put (n, namelen);
+        put (entry.data (), entry.size ());
+        while (index.size () % 8)
+            index.push_back (0);
+    }
+
+    const void* found;
+    size_t      foundsize;
+    const char* foundname;
+    EXRCORE_TEST_RVAL (exr_find_index_entry (
+        index.data (), index.size (), names[1], &found, &foundsize));
+    EXRCORE_TEST (foundsize == entry.size ());
+    EXRCORE_TEST (memcmp (found, entry.data (), foundsize) == 0);
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_ARGUMENT_OUT_OF_RANGE,
+        exr_find_index_entry (
+            index.data (), index.size (), "frame.0003.exr", &found, &foundsize));
+    EXRCORE_TEST_RVAL (exr_get_index_entry_by_index (
+        index.data (), index.size (), 0, &foundname, &found, &foundsize));
+    EXRCORE_TEST (!strcmp (foundname, names[0]));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_ARGUMENT_OUT_OF_RANGE,
+        exr_get_index_entry_by_index (
+            index.data (), index.size (), 2, &foundname, &found, &foundsize));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_FILE_BAD_HEADER,
+        exr_find_index_entry (
+            index.data (), index.size () / 2, names[1], &found, &foundsize));
+
+    EXRCORE_TEST_RVAL (exr_start_read_indexed (
+        &f, fn.c_str (), found, foundsize, &cinit));
+    exr_finish (&f);
+}
+
+void
+testReadIndexed (const std::string& tempdir)
+{
+    testIndexedFile (tempdir, "comp_piz.exr");
+    testIndexedFile (tempdir, "v1.7.test.tiled.exr");
+}
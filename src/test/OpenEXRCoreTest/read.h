@@ -10,6 +10,8 @@ void testReadBadArgs (const std::string& tempdir);
 void testReadBadFiles (const std::string& tempdir);
 
 void testReadMeta (const std::string& tempdir);
+void testReadHeaderSize (const std::string& tempdir);
+void testReadIndexed (const std::string& tempdir);
 
 void testOpenScans (const std::string& tempdir);
 void testOpenTiles (const std::string& tempdir);
@@ -21,5 +23,8 @@ void testReadTiles (const std::string& tempdir);
 void testReadMultiPart (const std::string& tempdir);
 
 void testReadUnpack (const std::string& tempdir);
+void testReadParallel (const std::string& tempdir);
+void testReadBufferPool (const std::string& tempdir);
+void testReadReconstructChunkTable (const std::string& tempdir);
 
 #endif // OPENEXR_CORE_TEST_READ_H
@@ -26,6 +26,7 @@
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <vector>
 
 static void
 err_cb (exr_const_context_t f, exr_result_t code, const char* msg)
@@ -1413,6 +1414,207 @@ testWriteMultiPart (const std::string& tempdir)
     remove (outfn.c_str ());
 }
 
+static void
+compareRawChunk (
+    exr_context_t     a,
+    exr_context_t     b,
+    int               partb,
+    exr_chunk_info_t& ca,
+    exr_chunk_info_t& cb)
+{
+    EXRCORE_TEST (ca.packed_size == cb.packed_size);
+    EXRCORE_TEST (ca.unpacked_size == cb.unpacked_size);
+    EXRCORE_TEST (ca.sample_count_table_size == cb.sample_count_table_size);
+
+    std::vector<uint8_t> da (ca.packed_size), db (cb.packed_size);
+    if (ca.sample_count_table_size > 0)
+    {
+        std::vector<uint8_t> sa (ca.sample_count_table_size),
+            sb (cb.sample_count_table_size);
+        EXRCORE_TEST_RVAL (
+            exr_read_deep_chunk (a, 0, &ca, da.data (), sa.data ()));
+        EXRCORE_TEST_RVAL (
+            exr_read_deep_chunk (b, partb, &cb, db.data (), sb.data ()));
+        EXRCORE_TEST (sa == sb);
+    }
+    else
+    {
+        EXRCORE_TEST_RVAL (exr_read_chunk (a, 0, &ca, da.data ()));
+        EXRCORE_TEST_RVAL (exr_read_chunk (b, partb, &cb, db.data ()));
+    }
+    EXRCORE_TEST (da == db);
+}
+
+/* a deep tiled file of 4x4 tiles, one of which has no samples at all */
+static void
+writeDeepTiles (
+    const std::string&         fn,
+    const exr_attr_box2i_t&    displayWindow,
+    exr_context_initializer_t& cinit)
+{
+    exr_context_t outf;
+    int           partidx;
+
+    EXRCORE_TEST_RVAL (
+        exr_start_write (&outf, fn.c_str (), EXR_WRITE_FILE_DIRECTLY, &cinit));
+    EXRCORE_TEST_RVAL (
+        exr_add_part (outf, "deep", EXR_STORAGE_DEEP_TILED, &partidx));
+    EXRCORE_TEST_RVAL (exr_initialize_required_attr_simple (
+        outf, partidx, 16, 8, EXR_COMPRESSION_NONE));
+    /* the display window is shared by all the parts of a file */
+    EXRCORE_TEST_RVAL (exr_set_display_window (outf, partidx, &displayWindow));
+    EXRCORE_TEST_RVAL (exr_set_tile_descriptor (
+        outf, partidx, 4, 4, EXR_TILE_ONE_LEVEL, EXR_TILE_ROUND_DOWN));
+    EXRCORE_TEST_RVAL (exr_add_channel (
+        outf,
+        partidx,
+        "Z",
+        EXR_PIXEL_FLOAT,
+        EXR_PERCEPTUALLY_LOGARITHMIC,
+        1,
+        1));
+    EXRCORE_TEST_RVAL (exr_write_header (outf));
+
+    for (int32_t ty = 0; ty < 2; ++ty)
+    {
+        for (int32_t tx = 0; tx < 4; ++tx)
+        {
+            /* the table holds the running total of samples */
+            std::vector<int32_t> counts (16);
+            int32_t              total = 0;
+            for (int p = 0; p < 16; ++p)
+            {
+                if (tx != 2 || ty != 0) total += (p + tx + ty) % 3;
+                counts[p] = total;
+            }
+            std::vector<float> samples (total);
+            for (int32_t i = 0; i < total; ++i)
+                samples[i] = (float) (ty * 1000 + tx * 100 + i);
+
+            EXRCORE_TEST_RVAL (exr_write_deep_tile_chunk (
+                outf,
+                0,
+                tx,
+                ty,
+                0,
+                0,
+                total > 0 ? samples.data () : NULL,
+                total * sizeof (float),
+                total * sizeof (float),
+                counts.data (),
+                counts.size () * sizeof (int32_t)));
+        }
+    }
+    EXRCORE_TEST_RVAL (exr_finish (&outf));
+}
+
+void
+testWriteCopyChunks (const std::string& tempdir)
+{
+    exr_context_t             scan, tile, deep, outf, testf;
+    std::string               outfn  = tempdir + "testcopychunks.exr";
+    std::string               deepfn = tempdir + "testcopychunksdeep.exr";
+    std::string               scanfn = ILM_IMF_TEST_IMAGEDIR;
+    std::string               tilefn = ILM_IMF_TEST_IMAGEDIR;
+    int                       partidx;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+
+    scanfn += "v1.7.test.planar.exr";
+    tilefn += "v1.7.test.tiled.exr";
+    EXRCORE_TEST_RVAL (exr_start_read (&scan, scanfn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_start_read (&tile, tilefn.c_str (), &cinit));
+
+    exr_attr_box2i_t dispw;
+    EXRCORE_TEST_RVAL (exr_get_display_window (tile, 0, &dispw));
+    writeDeepTiles (deepfn, dispw, cinit);
+    EXRCORE_TEST_RVAL (exr_start_read (&deep, deepfn.c_str (), &cinit));
+
+    EXRCORE_TEST_RVAL (exr_start_write (
+        &outf, outfn.c_str (), EXR_WRITE_FILE_DIRECTLY, &cinit));
+    EXRCORE_TEST_RVAL (
+        exr_add_part (outf, "scan", EXR_STORAGE_SCANLINE, &partidx));
+    EXRCORE_TEST_RVAL (exr_copy_unset_attributes (outf, 0, scan, 0));
+    EXRCORE_TEST_RVAL (
+        exr_add_part (outf, "tile", EXR_STORAGE_TILED, &partidx));
+    EXRCORE_TEST_RVAL (exr_copy_unset_attributes (outf, 1, tile, 0));
+    EXRCORE_TEST_RVAL (
+        exr_add_part (outf, "deep", EXR_STORAGE_DEEP_TILED, &partidx));
+    EXRCORE_TEST_RVAL (exr_copy_unset_attributes (outf, 2, deep, 0));
+    /* every part of a file with deep data needs a version */
+    EXRCORE_TEST_RVAL (exr_set_version (outf, 0, 1));
+    EXRCORE_TEST_RVAL (exr_set_version (outf, 1, 1));
+
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_HEADER_NOT_WRITTEN, exr_copy_chunks (outf, 0, scan, 0));
+    EXRCORE_TEST_RVAL (exr_write_header (outf));
+
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_NOT_OPEN_READ, exr_copy_chunks (outf, 0, outf, 0));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INCORRECT_PART, exr_copy_chunks (outf, 1, tile, 0));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT, exr_copy_chunks (outf, 0, tile, 0));
+
+    EXRCORE_TEST_RVAL (exr_copy_chunks (outf, 0, scan, 0));
+    EXRCORE_TEST_RVAL (exr_copy_chunks (outf, 1, tile, 0));
+    EXRCORE_TEST_RVAL (exr_copy_chunks (outf, 2, deep, 0));
+    EXRCORE_TEST_RVAL (exr_finish (&outf));
+
+    EXRCORE_TEST_RVAL (exr_start_read (&testf, outfn.c_str (), &cinit));
+
+    int32_t          lpc;
+    exr_attr_box2i_t dw;
+    EXRCORE_TEST_RVAL (exr_get_scanlines_per_chunk (testf, 0, &lpc));
+    EXRCORE_TEST_RVAL (exr_get_data_window (testf, 0, &dw));
+    for (int32_t y = dw.min.y; y <= dw.max.y; y += lpc)
+    {
+        exr_chunk_info_t ca, cb;
+        EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (scan, 0, y, &ca));
+        EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (testf, 0, y, &cb));
+        compareRawChunk (scan, testf, 0, ca, cb);
+    }
+
+    int32_t tx, ty;
+    EXRCORE_TEST_RVAL (exr_get_tile_counts (testf, 1, 0, 0, &tx, &ty));
+    for (int32_t y = 0; y < ty; ++y)
+    {
+        for (int32_t x = 0; x < tx; ++x)
+        {
+            exr_chunk_info_t ca, cb;
+            EXRCORE_TEST_RVAL (
+                exr_read_tile_chunk_info (tile, 0, x, y, 0, 0, &ca));
+            EXRCORE_TEST_RVAL (
+                exr_read_tile_chunk_info (testf, 1, x, y, 0, 0, &cb));
+            compareRawChunk (tile, testf, 1, ca, cb);
+        }
+    }
+
+    EXRCORE_TEST_RVAL (exr_get_tile_counts (testf, 2, 0, 0, &tx, &ty));
+    EXRCORE_TEST (tx == 4 && ty == 2);
+    for (int32_t y = 0; y < ty; ++y)
+    {
+        for (int32_t x = 0; x < tx; ++x)
+        {
+            exr_chunk_info_t ca, cb;
+            EXRCORE_TEST_RVAL (
+                exr_read_tile_chunk_info (deep, 0, x, y, 0, 0, &ca));
+            EXRCORE_TEST_RVAL (
+                exr_read_tile_chunk_info (testf, 2, x, y, 0, 0, &cb));
+            EXRCORE_TEST (ca.sample_count_table_size == 16 * sizeof (int32_t));
+            EXRCORE_TEST ((ca.packed_size == 0) == (x == 2 && y == 0));
+            compareRawChunk (deep, testf, 2, ca, cb);
+        }
+    }
+
+    EXRCORE_TEST_RVAL (exr_finish (&testf));
+    EXRCORE_TEST_RVAL (exr_finish (&deep));
+    EXRCORE_TEST_RVAL (exr_finish (&tile));
+    EXRCORE_TEST_RVAL (exr_finish (&scan));
+    remove (deepfn.c_str ());
+    remove (outfn.c_str ());
+}
+
 void
 testStartWriteUTF8 (const std::string& tempdir)
 {
@@ -15,6 +15,7 @@
 #include "testBadTypeAttributes.h"
 #include "testChannels.h"
 #include "testCompositeDeepScanLine.h"
+#include "testCompositeDeepTile.h"
 #include "testCompression.h"
 #include "testCompressionApi.h"
 #include "testConversion.h"
@@ -31,6 +32,7 @@
 #include "testExistingStreams.h"
 #include "testFutureProofing.h"
 #include "testHeader.h"
+#include "testHeaderView.h"
 #include "testHuf.h"
 #include "testIDManifest.h"
 #include "testInputPart.h"
@@ -217,6 +219,7 @@ main (int argc, char* argv[])
     TEST (testDeepTiledBasic, "deep");
     TEST (testCopyDeepTiled, "deep");
     TEST (testCompositeDeepScanLine, "deep");
+    TEST (testCompositeDeepTile, "deep");
     TEST (testMultiPartFileMixingBasic, "multi");
     TEST (testInputPart, "multi");
     TEST (testPartHelper, "multi");
@@ -233,6 +236,7 @@ main (int argc, char* argv[])
     TEST (testIDManifest, "core");
     TEST (testCpuId, "core");
     TEST (testHeader, "basic");
+    TEST (testHeaderView, "multi");
 
     // NB: If you add a test here, make sure to enumerate it in the
     // CMakeLists.txt so it runs as part of the test suite
@@ -0,0 +1,549 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include "testCompositeDeepTile.h"
+#include "random.h"
+
+#include <Iex.h>
+#include <assert.h>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <IlmThread.h>
+#include <ImfChannelList.h>
+#include <ImfCompositeDeepTile.h>
+#include <ImfDeepCompositing.h>
+#include <ImfDeepFrameBuffer.h>
+#include <ImfDeepTiledInputPart.h>
+#include <ImfDeepTiledOutputPart.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfMultiPartOutputFile.h>
+#include <ImfPartType.h>
+#include <ImfThreading.h>
+#include <ImfTiledInputFile.h>
+#include <ImfTiledOutputFile.h>
+
+namespace IMF = OPENEXR_IMF_NAMESPACE;
+using namespace IMF;
+using namespace IMATH_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+//
+// the samples of one level of one part, stored per channel
+// as consecutive runs, one per pixel
+//
+
+struct LevelData
+{
+    Box2i                  dw;
+    vector<unsigned int>   counts;
+    vector<size_t>         offsets;
+    vector<vector<float>>  values;   // [channel][sample]
+    vector<vector<float*>> pointers; // [channel][pixel]
+};
+
+struct Pattern
+{
+    vector<string>            channels; // Z, [ZBack], A, then colour channels
+    vector<vector<LevelData>> parts;    // [part][level]
+};
+
+void
+makeLevel (LevelData& level, const Box2i& dw, size_t channels, bool zback)
+{
+    size_t w = dw.max.x - dw.min.x + 1;
+    size_t h = dw.max.y - dw.min.y + 1;
+    level.dw = dw;
+    level.counts.resize (w * h);
+    level.offsets.resize (w * h);
+    level.values.assign (channels, vector<float> ());
+    level.pointers.assign (channels, vector<float*> (w * h));
+
+    size_t total = 0;
+    for (size_t p = 0; p < w * h; p++)
+    {
+        level.counts[p]  = random_int (5);
+        level.offsets[p] = total;
+        total += level.counts[p];
+    }
+
+    for (size_t c = 0; c < channels; c++)
+        level.values[c].resize (total);
+
+    for (size_t s = 0; s < total; s++)
+    {
+        // coarse depths, so samples from different parts tie
+        float  z           = random_int (16) * 0.5f;
+        size_t c           = 0;
+        level.values[c++][s] = z;
+        if (zback) level.values[c++][s] = z + random_int (4) * 0.25f;
+        level.values[c++][s] = random_float (0.6f);
+        for (; c < channels; c++)
+            level.values[c][s] = random_float (1.0f);
+    }
+
+    for (size_t c = 0; c < channels; c++)
+        for (size_t p = 0; p < w * h; p++)
+            level.pointers[c][p] =
+                level.values[c].data () + level.offsets[p];
+}
+
+void
+writeFile (
+    const string& fn,
+    Pattern&      pattern,
+    int           numParts,
+    bool          zback,
+    LevelMode     levelMode)
+{
+    pattern.channels.clear ();
+    pattern.channels.push_back ("Z");
+    if (zback) pattern.channels.push_back ("ZBack");
+    pattern.channels.push_back ("A");
+    pattern.channels.push_back ("G");
+    pattern.channels.push_back ("R");
+
+    Box2i dw;
+    dw.min.x = random_int (100) - 50;
+    dw.min.y = random_int (100) - 50;
+    dw.max.x = dw.min.x + 30 + random_int (90);
+    dw.max.y = dw.min.y + 30 + random_int (90);
+
+    vector<Header> headers (numParts);
+    for (int i = 0; i < numParts; i++)
+    {
+        headers[i].dataWindow ()    = dw;
+        headers[i].displayWindow () = dw;
+        headers[i].setType (DEEPTILE);
+        headers[i].setTileDescription (TileDescription (17, 13, levelMode));
+        headers[i].compression () = ZIPS_COMPRESSION;
+        ostringstream s;
+        s << "Part" << i;
+        headers[i].setName (s.str ());
+        for (size_t c = 0; c < pattern.channels.size (); c++)
+            headers[i].channels ().insert (pattern.channels[c], FLOAT);
+    }
+
+    MultiPartOutputFile file (fn.c_str (), &headers[0], numParts);
+    pattern.parts.assign (numParts, vector<LevelData> ());
+
+    for (int i = 0; i < numParts; i++)
+    {
+        DeepTiledOutputPart part (file, i);
+        pattern.parts[i].resize (part.numLevels ());
+
+        for (int l = 0; l < part.numLevels (); l++)
+        {
+            LevelData& level = pattern.parts[i][l];
+            makeLevel (
+                level,
+                part.dataWindowForLevel (l),
+                pattern.channels.size (),
+                zback);
+
+            ptrdiff_t w = level.dw.max.x - level.dw.min.x + 1;
+            ptrdiff_t o = level.dw.min.x + level.dw.min.y * w;
+
+            DeepFrameBuffer fb;
+            fb.insertSampleCountSlice (Slice (
+                IMF::UINT,
+                (char*) (&level.counts[0] - o),
+                sizeof (unsigned int),
+                sizeof (unsigned int) * w));
+            for (size_t c = 0; c < pattern.channels.size (); c++)
+            {
+                fb.insert (
+                    pattern.channels[c],
+                    DeepSlice (
+                        FLOAT,
+                        (char*) (&level.pointers[c][0] - o),
+                        sizeof (float*),
+                        sizeof (float*) * w,
+                        sizeof (float)));
+            }
+            part.setFrameBuffer (fb);
+            part.writeTiles (
+                0, part.numXTiles (l) - 1, 0, part.numYTiles (l) - 1, l);
+        }
+    }
+}
+
+//
+// composite pixel (x, y) of a level across all parts, in part order,
+// with the default compositing engine
+//
+
+void
+expectedPixel (
+    const Pattern& pattern, int l, int x, int y, vector<float>& result)
+{
+    size_t                nc = pattern.channels.size ();
+    vector<vector<float>> samples (nc);
+    int                   sources = 0;
+
+    for (size_t i = 0; i < pattern.parts.size (); i++)
+    {
+        const LevelData& level = pattern.parts[i][l];
+        size_t           w     = level.dw.max.x - level.dw.min.x + 1;
+        size_t p = (y - level.dw.min.y) * w + (x - level.dw.min.x);
+        if (level.counts[p] > 0) sources++;
+        for (size_t c = 0; c < nc; c++)
+            for (unsigned int s = 0; s < level.counts[p]; s++)
+                samples[c].push_back (level.values[c][level.offsets[p] + s]);
+    }
+
+    // inputs are Z, ZBack (or Z again), A, then the colour channels
+    vector<const float*> inputs;
+    vector<const char*>  names;
+    bool                 zback = pattern.channels[1] == "ZBack";
+    for (size_t c = 0; c < nc; c++)
+    {
+        inputs.push_back (samples[c].data ());
+        names.push_back (pattern.channels[c].c_str ());
+        if (c == 0 && !zback)
+        {
+            inputs.push_back (samples[0].data ());
+            names.push_back (names[0]);
+        }
+    }
+
+    result.assign (inputs.size (), 0.0f);
+    DeepCompositing comp;
+    comp.composite_pixel (
+        &result[0],
+        &inputs[0],
+        &names[0],
+        int (inputs.size ()),
+        int (samples[0].size ()),
+        sources);
+
+    if (!zback) result.erase (result.begin () + 1);
+}
+
+//
+// an output frame buffer of w by h float pixels per channel, origin
+// at (x0, y0) or in tile coordinates
+//
+
+void
+setUpFrameBuffer (
+    const Pattern&         pattern,
+    vector<vector<float>>& data,
+    FrameBuffer&           fb,
+    int                    x0,
+    int                    y0,
+    int                    w,
+    int                    h,
+    bool                   tileCoords)
+{
+    data.assign (pattern.channels.size (), vector<float> (w * h, -1.0f));
+    for (size_t c = 0; c < pattern.channels.size (); c++)
+    {
+        ptrdiff_t o = tileCoords ? 0 : x0 + ptrdiff_t (y0) * w;
+        fb.insert (
+            pattern.channels[c],
+            Slice (
+                FLOAT,
+                (char*) (&data[c][0] - o),
+                sizeof (float),
+                sizeof (float) * w,
+                1,
+                1,
+                0.0,
+                tileCoords,
+                tileCoords));
+    }
+}
+
+void
+checkRegion (
+    const Pattern&               pattern,
+    int                          l,
+    const Box2i&                 region,
+    const vector<vector<float>>& data,
+    int                          x0,
+    int                          y0,
+    int                          w)
+{
+    vector<float> expected;
+    for (int y = region.min.y; y <= region.max.y; y++)
+    {
+        for (int x = region.min.x; x <= region.max.x; x++)
+        {
+            expectedPixel (pattern, l, x, y, expected);
+            for (size_t c = 0; c < pattern.channels.size (); c++)
+            {
+                float got = data[c][(y - y0) * w + (x - x0)];
+                if (got != expected[c])
+                {
+                    cout << "pixel " << x << "," << y << " level " << l
+                         << " channel " << pattern.channels[c] << ": got "
+                         << got << " expected " << expected[c] << endl;
+                }
+                assert (got == expected[c]);
+            }
+        }
+    }
+}
+
+void
+testLevels (const string& fn, int numParts, bool zback, LevelMode levelMode)
+{
+    cout << "   " << numParts << " part(s), " << (zback ? "with" : "no")
+         << " ZBack, level mode " << levelMode << endl;
+
+    Pattern pattern;
+    writeFile (fn, pattern, numParts, zback, levelMode);
+
+    MultiPartInputFile          input (fn.c_str ());
+    vector<DeepTiledInputPart*> parts (numParts);
+    CompositeDeepTile           comp;
+
+    for (int i = 0; i < numParts; i++)
+    {
+        parts[i] = new DeepTiledInputPart (input, i);
+        comp.addSource (parts[i]);
+    }
+    assert (comp.sources () == numParts);
+
+    for (size_t l = 0; l < pattern.parts[0].size (); l++)
+    {
+        const Box2i& dw = pattern.parts[0][l].dw;
+        int          w  = dw.max.x - dw.min.x + 1;
+        int          h  = dw.max.y - dw.min.y + 1;
+        int          nx = comp.numXTiles (int (l));
+        int          ny = comp.numYTiles (int (l));
+
+        //
+        // the whole level into one frame buffer
+        //
+        {
+            vector<vector<float>> data;
+            FrameBuffer           fb;
+            setUpFrameBuffer (
+                pattern, data, fb, dw.min.x, dw.min.y, w, h, false);
+            comp.setFrameBuffer (fb);
+            comp.readTiles (0, nx - 1, 0, ny - 1, int (l));
+            checkRegion (pattern, int (l), dw, data, dw.min.x, dw.min.y, w);
+        }
+
+        //
+        // tile by tile, into a buffer in tile coordinates
+        //
+        {
+            const TileDescription& td = comp.tileDescription ();
+            vector<vector<float>>  data;
+            FrameBuffer            fb;
+            setUpFrameBuffer (
+                pattern, data, fb, 0, 0, td.xSize, td.ySize, true);
+            comp.setFrameBuffer (fb);
+            for (int dy = 0; dy < ny; dy++)
+            {
+                for (int dx = 0; dx < nx; dx++)
+                {
+                    Box2i tile = parts[0]->dataWindowForTile (dx, dy, int (l));
+                    comp.readTile (dx, dy, int (l));
+                    checkRegion (
+                        pattern,
+                        int (l),
+                        tile,
+                        data,
+                        tile.min.x,
+                        tile.min.y,
+                        td.xSize);
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < numParts; i++)
+    {
+        delete parts[i];
+    }
+}
+
+//
+// flatten a deep tiled file into a flat tiled one, a row of tiles at a
+// time, through a frame buffer shared by the compositor and the output
+//
+
+void
+testFlatten (const string& fn, const string& outfn, int numParts)
+{
+    cout << "   flattening " << numParts << " part(s) to a tiled file"
+         << endl;
+
+    Pattern pattern;
+    writeFile (fn, pattern, numParts, true, ONE_LEVEL);
+
+    MultiPartInputFile          input (fn.c_str ());
+    vector<DeepTiledInputPart*> parts (numParts);
+    CompositeDeepTile           comp;
+
+    for (int i = 0; i < numParts; i++)
+    {
+        parts[i] = new DeepTiledInputPart (input, i);
+        comp.addSource (parts[i]);
+    }
+
+    const Box2i&           dw = comp.dataWindow ();
+    const TileDescription& td = comp.tileDescription ();
+    int                    w  = dw.max.x - dw.min.x + 1;
+    int                    h  = dw.max.y - dw.min.y + 1;
+
+    {
+        Header header (dw, dw);
+        header.setTileDescription (td);
+        for (size_t c = 0; c < pattern.channels.size (); c++)
+            header.channels ().insert (pattern.channels[c], FLOAT);
+
+        TiledOutputFile out (outfn.c_str (), header);
+
+        // one row of tiles: absolute in x, tile coordinates in y
+        vector<vector<float>> data (
+            pattern.channels.size (), vector<float> (w * td.ySize));
+        FrameBuffer fb;
+        for (size_t c = 0; c < pattern.channels.size (); c++)
+        {
+            fb.insert (
+                pattern.channels[c],
+                Slice (
+                    FLOAT,
+                    (char*) (&data[c][0] - dw.min.x),
+                    sizeof (float),
+                    sizeof (float) * w,
+                    1,
+                    1,
+                    0.0,
+                    false,
+                    true));
+        }
+        comp.setFrameBuffer (fb);
+        out.setFrameBuffer (fb);
+
+        for (int dy = 0; dy < comp.numYTiles (); dy++)
+        {
+            comp.readTiles (0, comp.numXTiles () - 1, dy, dy);
+            out.writeTiles (0, out.numXTiles () - 1, dy, dy);
+        }
+    }
+
+    {
+        TiledInputFile        in (outfn.c_str ());
+        vector<vector<float>> data;
+        FrameBuffer           fb;
+        setUpFrameBuffer (pattern, data, fb, dw.min.x, dw.min.y, w, h, false);
+        in.setFrameBuffer (fb);
+        in.readTiles (0, in.numXTiles () - 1, 0, in.numYTiles () - 1);
+        checkRegion (pattern, 0, dw, data, dw.min.x, dw.min.y, w);
+    }
+
+    for (int i = 0; i < numParts; i++)
+    {
+        delete parts[i];
+    }
+    remove (outfn.c_str ());
+}
+
+void
+testErrors (const string& fn)
+{
+    cout << "   error handling" << endl;
+
+    Pattern pattern;
+    writeFile (fn, pattern, 2, false, ONE_LEVEL);
+
+    MultiPartInputFile input (fn.c_str ());
+    DeepTiledInputPart part0 (input, 0);
+    DeepTiledInputPart part1 (input, 1);
+
+    {
+        // nothing to composite
+        CompositeDeepTile comp;
+        try
+        {
+            comp.readTile (0, 0);
+            assert (false);
+        }
+        catch (const IEX_NAMESPACE::ArgExc&)
+        {}
+    }
+
+    {
+        // sample limit
+        CompositeDeepTile comp;
+        comp.addSource (&part0);
+        comp.addSource (&part1);
+
+        vector<vector<float>> data;
+        FrameBuffer           fb;
+        setUpFrameBuffer (pattern, data, fb, 0, 0, 17, 13, true);
+        comp.setFrameBuffer (fb);
+
+        int64_t oldLimit = CompositeDeepTile::getMaximumSampleCount ();
+        CompositeDeepTile::setMaximumSampleCount (1);
+        bool threw = false;
+        try
+        {
+            comp.readTiles (0, comp.numXTiles () - 1, 0, 0);
+        }
+        catch (const IEX_NAMESPACE::ArgExc&)
+        {
+            threw = true;
+        }
+        CompositeDeepTile::setMaximumSampleCount (oldLimit);
+        assert (threw);
+
+        comp.readTiles (0, comp.numXTiles () - 1, 0, 0);
+    }
+}
+
+} // namespace
+
+void
+testCompositeDeepTile (const std::string& tempDir)
+{
+    cout << "\n\nTesting deep tiled compositing:\n" << endl;
+
+    std::string fn    = tempDir + "imf_test_composite_deep_tile_source.exr";
+    std::string outfn = tempDir + "imf_test_composite_deep_tile_flat.exr";
+
+    int passes = 2;
+    if (!ILMTHREAD_NAMESPACE::supportsThreads ()) { passes = 1; }
+
+    random_reseed (1);
+
+    for (int pass = 0; pass < passes; pass++)
+    {
+        testLevels (fn, 1, false, ONE_LEVEL);
+        testLevels (fn, 1, true, MIPMAP_LEVELS);
+        testLevels (fn, 3, false, MIPMAP_LEVELS);
+        testLevels (fn, 4, true, MIPMAP_LEVELS);
+        testFlatten (fn, outfn, 3);
+        testErrors (fn);
+
+        if (passes == 2 && pass == 0)
+        {
+            cout << " testing with multithreading...\n";
+            setGlobalThreadCount (8);
+        }
+    }
+    setGlobalThreadCount (0);
+
+    remove (fn.c_str ());
+    cout << " ok\n" << endl;
+}
@@ -0,0 +1,13 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef TESTCOMPOSITEDEEPTILE_H_
+#define TESTCOMPOSITEDEEPTILE_H_
+
+#include <string>
+
+void testCompositeDeepTile (const std::string& tempDir);
+
+#endif /* TESTCOMPOSITEDEEPTILE_H_ */
@@ -7,12 +7,18 @@
 #    undef NDEBUG
 #endif
 
+#include <IlmThread.h>
 #include <ImfBoxAttribute.h>
 #include <ImfHeader.h>
 
+#include <atomic>
 #include <exception>
 #include <iostream>
 #include <string>
+#include <vector>
+#if ILMTHREAD_THREADING_ENABLED
+#    include <thread>
+#endif
 
 #include <assert.h>
 
@@ -83,6 +89,71 @@ testEraseAttributeThrowsWithEmptyString ()
     }
 }
 
+void
+testCompressionLevelsThreaded ()
+{
+    //
+    // Copy, assign, move and destroy headers on several threads
+    // at once, half of them with compression levels set, and
+    // check that every copy carries the levels of its source.
+    //
+
+    if (!ILMTHREAD_NAMESPACE::supportsThreads ()) return;
+
+#if ILMTHREAD_THREADING_ENABLED
+    const int numThreads = 8;
+    const int numCopies  = 2000;
+
+    const Header defaults;
+    const int    defaultZip = defaults.zipCompressionLevel ();
+    const float  defaultDwa = defaults.dwaCompressionLevel ();
+
+    atomic<int>    failures (0);
+    vector<thread> threads;
+
+    for (int t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back ([=, &failures] () {
+            bool   custom = (t & 1) != 0;
+            Header source;
+
+            if (custom)
+            {
+                source.zipCompressionLevel () = t;
+                source.dwaCompressionLevel () = 10.0f * t;
+            }
+
+            int   zip = custom ? t : defaultZip;
+            float dwa = custom ? 10.0f * t : defaultDwa;
+
+            for (int i = 0; i < numCopies; ++i)
+            {
+                Header copy (source);
+                Header assigned;
+                assigned = copy;
+                Header moved (std::move (copy));
+
+                const Header& a = assigned;
+                const Header& m = moved;
+
+                if (a.zipCompressionLevel () != zip ||
+                    a.dwaCompressionLevel () != dwa ||
+                    m.zipCompressionLevel () != zip ||
+                    m.dwaCompressionLevel () != dwa)
+                {
+                    ++failures;
+                }
+            }
+        });
+    }
+
+    for (thread& t: threads)
+        t.join ();
+
+    assert (failures == 0);
+#endif
+}
+
 void
 testHeader (const string& tempDir)
 {
@@ -102,6 +173,7 @@ testHeader (const string& tempDir)
         }
         testEraseAttribute ("displayWindow");
         testEraseAttributeThrowsWithEmptyString ();
+        testCompressionLevelsThreaded ();
         cout << "ok\n" << endl;
     }
     catch (const exception& e)
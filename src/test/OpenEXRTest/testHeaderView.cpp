@@ -0,0 +1,205 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include "testHeaderView.h"
+
+#include <ImfChannelList.h>
+#include <ImfHeader.h>
+#include <ImfHeaderView.h>
+#include <ImfIntAttribute.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfMultiPartOutputFile.h>
+#include <ImfPartType.h>
+#include <ImfStringAttribute.h>
+
+#include <openexr.h>
+
+#include <assert.h>
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace IMF = OPENEXR_IMF_NAMESPACE;
+using namespace IMF;
+using namespace std;
+using namespace IMATH_NAMESPACE;
+
+namespace
+{
+
+void
+writeFile (const string& fn, vector<Header>& headers)
+{
+    Box2i dataWindow (V2i (-4, 2), V2i (27, 19));
+
+    Header scanline (Box2i (V2i (0, 0), V2i (31, 23)), dataWindow, 2.f);
+    scanline.setName ("left");
+    scanline.setType (SCANLINEIMAGE);
+    scanline.compression ()        = PIZ_COMPRESSION;
+    scanline.lineOrder ()          = DECREASING_Y;
+    scanline.screenWindowCenter () = V2f (0.25f, -0.5f);
+    scanline.screenWindowWidth ()  = 3.f;
+    scanline.channels ().insert ("R", Channel (HALF));
+    scanline.channels ().insert ("G", Channel (FLOAT, 2, 2));
+    scanline.channels ().insert ("B", Channel (UINT));
+    scanline.insert ("view", StringAttribute ("left"));
+    scanline.insert ("frame", IntAttribute (42));
+    headers.push_back (scanline);
+
+    Header tiled (dataWindow);
+    tiled.setName ("right");
+    tiled.setType (TILEDIMAGE);
+    tiled.compression () = ZIP_COMPRESSION;
+    tiled.setTileDescription (
+        TileDescription (8, 4, MIPMAP_LEVELS, ROUND_UP));
+    tiled.channels ().insert ("Y", Channel (HALF));
+    tiled.insert ("view", StringAttribute ("right"));
+    headers.push_back (tiled);
+
+    remove (fn.c_str ());
+    MultiPartOutputFile file (fn.c_str (), &headers[0], headers.size ());
+}
+
+void
+compareChannels (const exr_attr_chlist_t* view, const ChannelList& channels)
+{
+    int count = 0;
+    for (ChannelList::ConstIterator i = channels.begin ();
+         i != channels.end ();
+         ++i, ++count)
+    {
+        assert (count < view->num_channels);
+
+        const exr_attr_chlist_entry_t& e = view->entries[count];
+        assert (!strcmp (e.name.str, i.name ()));
+        assert (e.pixel_type == static_cast<exr_pixel_type_t> (i.channel ().type));
+        assert (e.x_sampling == i.channel ().xSampling);
+        assert (e.y_sampling == i.channel ().ySampling);
+    }
+    assert (count == view->num_channels);
+}
+
+void
+compare (const HeaderView& view, const Header& hdr)
+{
+    assert (view.displayWindow () == hdr.displayWindow ());
+    assert (view.dataWindow () == hdr.dataWindow ());
+    assert (view.pixelAspectRatio () == hdr.pixelAspectRatio ());
+    assert (view.screenWindowCenter () == hdr.screenWindowCenter ());
+    assert (view.screenWindowWidth () == hdr.screenWindowWidth ());
+    assert (view.lineOrder () == hdr.lineOrder ());
+    assert (view.compression () == hdr.compression ());
+    compareChannels (view.channels (), hdr.channels ());
+
+    assert (view.hasTileDescription () == hdr.hasTileDescription ());
+    if (hdr.hasTileDescription ())
+        assert (view.tileDescription () == hdr.tileDescription ());
+
+    assert (view.name () && hdr.name () == view.name ());
+    assert (view.type () && hdr.type () == view.type ());
+    assert (
+        view.view () &&
+        hdr.typedAttribute<StringAttribute> ("view").value () == view.view ());
+
+    //
+    // every attribute in the header is visible through the view, and
+    // nothing else is
+    //
+
+    int count = 0;
+    for (Header::ConstIterator i = hdr.begin (); i != hdr.end (); ++i)
+    {
+        const exr_attribute_t* attr = view.findAttribute (i.name ());
+        assert (attr);
+        assert (!strcmp (attr->type_name, i.attribute ().typeName ()));
+        ++count;
+    }
+    assert (view.attributeCount () == count);
+
+    for (int a = 0; a < count; ++a)
+        assert (hdr.find (view.attribute (a)->name) != hdr.end ());
+
+    assert (view.findAttribute ("noSuchAttribute") == nullptr);
+    assert (view.findAttribute ("name", EXR_ATTR_INT) == nullptr);
+    assert (view.findAttribute ("name", EXR_ATTR_STRING) != nullptr);
+}
+
+} // namespace
+
+void
+testHeaderView (const string& tempDir)
+{
+    try
+    {
+        cout << "Testing header views" << endl;
+
+        string         fn = tempDir + "imf_test_header_view.exr";
+        vector<Header> headers;
+        writeFile (fn, headers);
+
+        MultiPartInputFile* file = new MultiPartInputFile (fn.c_str ());
+        assert (file->parts () == 2);
+
+        //
+        // views are taken before any header is materialized, then
+        // compared against the full headers
+        //
+
+        vector<HeaderView> views;
+        for (int p = 0; p < file->parts (); ++p)
+            views.push_back (file->headerView (p));
+
+        assert (views[0].storage () == EXR_STORAGE_SCANLINE);
+        assert (views[1].storage () == EXR_STORAGE_TILED);
+        assert (views[0].chunkCount () == 1);
+        assert (views[1].chunkCount () > 0);
+        assert (!strcmp (views[0].name (), "left"));
+        assert (!strcmp (views[1].name (), "right"));
+
+        for (int p = 0; p < file->parts (); ++p)
+        {
+            assert (views[p].partNumber () == p);
+            compare (views[p], file->header (p));
+            compare (views[p], views[p].header ());
+            assert (views[p].dataWindow () == headers[p].dataWindow ());
+            assert (views[p].compression () == headers[p].compression ());
+            compareChannels (views[p].channels (), headers[p].channels ());
+        }
+
+        bool caught = false;
+        try
+        {
+            file->headerView (2);
+        }
+        catch (const IEX_NAMESPACE::ArgExc&)
+        {
+            caught = true;
+        }
+        assert (caught);
+
+        //
+        // a view keeps the file open after the file object is gone
+        //
+
+        delete file;
+        compare (views[1], views[1].header ());
+        assert (views[1].tileDescription () == headers[1].tileDescription ());
+
+        views.clear ();
+        remove (fn.c_str ());
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
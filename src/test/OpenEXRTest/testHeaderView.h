@@ -0,0 +1,13 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef TESTHEADERVIEW_H_
+#define TESTHEADERVIEW_H_
+
+#include <string>
+
+void testHeaderView (const std::string& tempDir);
+
+#endif /* TESTHEADERVIEW_H_ */
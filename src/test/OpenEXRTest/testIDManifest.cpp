@@ -555,6 +555,385 @@ testMerge ()
         }
     }
 }
+
+void
+testCompactManifest ()
+{
+    random_reseed (2);
+
+    //
+    // a manifest with a shared string table between groups, and
+    // strings shared between entries and components
+    //
+    IDManifest mfst;
+    mfst.add ("id");
+    mfst.add ("crypto");
+
+    // add() may move the groups, so only take references once all are added
+    IDManifest::ChannelGroupManifest& idGroup = mfst[0];
+    vector<string>                    comps (2);
+    comps[0] = "model";
+    comps[1] = "material";
+    idGroup.setComponents (comps);
+    idGroup.setHashScheme (IDManifest::NOTHASHED);
+
+    IDManifest::ChannelGroupManifest& hashGroup = mfst[1];
+    hashGroup.setComponent ("name");
+    hashGroup.setHashScheme (IDManifest::MURMURHASH3_32);
+
+    vector<string> words;
+    for (int i = 0; i < 300; ++i)
+    {
+        words.push_back (randomWord (i & 1, vector<string> ()));
+    }
+    words.push_back (string (300, 'x')); // long prefix
+    words.push_back (string (300, 'x') + "y");
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        vector<string> text (2);
+        text[0] = words[random_int (words.size ())];
+        text[1] = words[random_int (words.size ())];
+        idGroup.insert (random_int (1 << 20), text);
+        hashGroup.insert (words[random_int (words.size ())]);
+    }
+
+    vector<char> data;
+    mfst.serialize (data);
+
+    //
+    // compact manifests, decoded or converted, hold the same entries and
+    // serialize to the same bytes
+    //
+    CompactIDManifest decoded (data.data (), data.data () + data.size ());
+    CompactIDManifest converted (mfst);
+
+    assert (decoded.size () == mfst.size ());
+    for (size_t g = 0; g < mfst.size (); ++g)
+    {
+        const CompactIDManifest::ChannelGroup& cg = decoded[g];
+        assert (cg.getChannels () == mfst[g].getChannels ());
+        assert (cg.getComponents () == mfst[g].getComponents ());
+        assert (cg.getHashScheme () == mfst[g].getHashScheme ());
+        assert (cg.size () == mfst[g].size ());
+
+        for (IDManifest::ChannelGroupManifest::ConstIterator i =
+                 mfst[g].begin ();
+             i != mfst[g].end ();
+             ++i)
+        {
+            size_t e = cg.find (i.id ());
+            assert (e != CompactIDManifest::ChannelGroup::npos);
+            assert (cg.id (e) == i.id ());
+            for (size_t c = 0; c < i.text ().size (); ++c)
+            {
+                assert (
+                    string (cg.text (e, c), cg.textLength (e, c)) ==
+                    i.text ()[c]);
+                assert (cg.lookup (i.id (), c) == cg.text (e, c));
+            }
+        }
+    }
+    assert (decoded.find ("crypto") == 1);
+    assert (decoded.find ("missing") == decoded.size ());
+    assert (decoded[0].lookup (1 << 21) == nullptr);
+
+    vector<char> out;
+    decoded.serialize (out);
+    assert (out == data);
+    converted.serialize (out);
+    assert (out == data);
+    assert (decoded.toIDManifest () == mfst);
+
+    CompressedIDManifest compressed (decoded);
+    assert (CompactIDManifest (compressed).toIDManifest () == mfst);
+    assert (IDManifest (compressed) == mfst);
+
+    //
+    // inserting: duplicates are rejected, strings are interned
+    //
+    CompactIDManifest                compact;
+    CompactIDManifest::ChannelGroup& group = compact.add ("id");
+    group.setComponents (comps);
+    vector<string> text (2);
+    text[0] = "merino/body";
+    text[1] = "wool";
+    assert (group.insert (1, text));
+    text[1] = "skin";
+    assert (!group.insert (1, text));
+    assert (group.insert (2, text));
+    assert (group.size () == 2);
+    assert (group.stringCount () == 3);
+    assert (string (group.lookup (1, 1)) == "wool");
+
+    bool threw = false;
+    try
+    {
+        group.insert (3, "onlyOneComponentInserted");
+    }
+    catch (IEX_NAMESPACE::ArgExc&)
+    {
+        threw = true;
+    }
+    assert (threw);
+
+    //
+    // corrupt and truncated data must be rejected, not crash
+    //
+    for (size_t size = 0; size < data.size (); size += 1 + size / 8)
+    {
+        try
+        {
+            CompactIDManifest bad (data.data (), data.data () + size);
+        }
+        catch (IEX_NAMESPACE::InputExc&)
+        {}
+    }
+    for (int pass = 0; pass < 200; ++pass)
+    {
+        vector<char> bad = data;
+        bad[random_int (bad.size ())] = char (random_int (256));
+        try
+        {
+            CompactIDManifest m (bad.data (), bad.data () + bad.size ());
+            m.serialize (out);
+        }
+        catch (IEX_NAMESPACE::BaseExc&)
+        {}
+    }
+}
+
+void
+testLazyManifest ()
+{
+    random_reseed (3);
+
+    //
+    // enough entries for several index blocks, and strings sharing long
+    // and short prefixes with their neighbours in the string table
+    //
+    IDManifest mfst;
+    mfst.add ("id");
+    mfst.add ("crypto");
+
+    IDManifest::ChannelGroupManifest& idGroup = mfst[0];
+    vector<string>                    comps (2);
+    comps[0] = "model";
+    comps[1] = "material";
+    idGroup.setComponents (comps);
+
+    IDManifest::ChannelGroupManifest& hashGroup = mfst[1];
+    hashGroup.setComponent ("name");
+    hashGroup.setHashScheme (IDManifest::MURMURHASH3_64);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        vector<string> text (2);
+        text[0] = "/set/object" + std::to_string (random_int (300));
+        text[1] = randomWord (false, vector<string> ());
+        idGroup.insert (i * 7, text);
+        hashGroup.insert (
+            string (random_int (400), 'p') + std::to_string (i));
+    }
+
+    vector<char> data;
+    mfst.serialize (data);
+
+    LazyIDManifest lazy (data.data (), data.data () + data.size ());
+    assert (lazy.size () == mfst.size ());
+    assert (lazy.find ("crypto") == 1);
+    assert (lazy.find ("missing") == lazy.size ());
+
+    vector<string> text;
+    string         component;
+    for (size_t g = 0; g < mfst.size (); ++g)
+    {
+        assert (lazy[g].getChannels () == mfst[g].getChannels ());
+        assert (lazy[g].getComponents () == mfst[g].getComponents ());
+        assert (lazy[g].getHashScheme () == mfst[g].getHashScheme ());
+        assert (lazy[g].size () == mfst[g].size ());
+
+        for (IDManifest::ChannelGroupManifest::ConstIterator i =
+                 mfst[g].begin ();
+             i != mfst[g].end ();
+             ++i)
+        {
+            assert (lazy.lookup (g, i.id (), text));
+            assert (text == i.text ());
+            assert (lazy.lookup (g, i.id (), text.size () - 1, component));
+            assert (component == i.text ().back ());
+            assert (!lazy.lookup (g, i.id (), text.size (), component));
+            assert (
+                lazy.contains (g, i.id () + 1) ==
+                (mfst[g].find (i.id () + 1) != mfst[g].end ()));
+        }
+    }
+    assert (!lazy.contains (0, 1));
+    assert (!lazy.contains (0, 7000));
+
+    LazyIDManifest compressed ((CompressedIDManifest (mfst)));
+    assert (compressed.lookup (0, 7 * 999, text));
+    assert (text == mfst[0].find (7 * 999).text ());
+
+    bool threw = false;
+    try
+    {
+        lazy.contains (2, 0);
+    }
+    catch (IEX_NAMESPACE::ArgExc&)
+    {
+        threw = true;
+    }
+    assert (threw);
+
+    //
+    // corrupt and truncated data must be rejected when indexed
+    //
+    for (size_t size = 0; size < data.size (); size += 1 + size / 8)
+    {
+        try
+        {
+            LazyIDManifest bad (data.data (), data.data () + size);
+        }
+        catch (IEX_NAMESPACE::InputExc&)
+        {}
+    }
+    for (int pass = 0; pass < 200; ++pass)
+    {
+        vector<char> bad = data;
+        bad[random_int (bad.size ())] = char (random_int (256));
+        try
+        {
+            LazyIDManifest m (bad.data (), bad.data () + bad.size ());
+            for (int i = 0; i < 1000; i += 10)
+            {
+                m.lookup (0, i * 7, text);
+            }
+        }
+        catch (IEX_NAMESPACE::InputExc&)
+        {}
+    }
+}
+
+void
+testLazyManifestOrder ()
+{
+    //
+    // serialize() writes the entries of a group in ID order, but the
+    // format stores differences which may wrap, so other writers can
+    // store them in any order. Give the IDs of the last group large
+    // gaps, so they are stored as 64 bit differences, each followed by
+    // a one byte string index, and rewrite them shuffled
+    //
+    IDManifest mfst;
+    mfst.add ("id");
+    mfst.add ("crypto");
+
+    IDManifest::ChannelGroupManifest& idGroup = mfst[0];
+    idGroup.setComponent ("name");
+    for (int i = 0; i < 100; ++i)
+    {
+        idGroup.insert (i * 3, "object" + std::to_string (i));
+    }
+
+    const int                         entries   = 8;
+    IDManifest::ChannelGroupManifest& hashGroup = mfst[1];
+    hashGroup.setComponent ("name");
+    for (int i = 0; i < entries; ++i)
+    {
+        hashGroup.insert (
+            i * ((uint64_t (1) << 61) + 3) + 5, "hash" + std::to_string (i));
+    }
+
+    vector<char> data;
+    mfst.serialize (data);
+
+    const size_t entrySize = 9;
+    const size_t table     = data.size () - entries * entrySize;
+
+    vector<uint64_t> ids;
+    vector<char>     strings;
+    uint64_t         id = 0;
+    for (int i = 0; i < entries; ++i)
+    {
+        const char* entry = &data[table + i * entrySize];
+        uint64_t    delta = 0;
+        for (int b = 7; b >= 0; --b)
+        {
+            delta = (delta << 8) | (unsigned char) entry[b];
+        }
+        id += delta;
+        assert (hashGroup.find (id) != hashGroup.end ());
+        ids.push_back (id);
+        strings.push_back (entry[8]);
+    }
+
+    auto reorder = [&] (const int* order) {
+        vector<char> out        = data;
+        uint64_t     previousId = 0;
+        for (int i = 0; i < entries; ++i)
+        {
+            char*    entry = &out[table + i * entrySize];
+            uint64_t delta = ids[order[i]] - previousId;
+            for (int b = 0; b < 8; ++b)
+            {
+                entry[b] = char (delta >> (8 * b));
+            }
+            entry[8]   = strings[order[i]];
+            previousId = ids[order[i]];
+        }
+        return out;
+    };
+
+    const int    shuffle[entries] = {3, 7, 0, 5, 1, 6, 2, 4};
+    vector<char> shuffled         = reorder (shuffle);
+    assert (shuffled != data);
+
+    const char* begin = shuffled.data ();
+    const char* end   = begin + shuffled.size ();
+    assert (IDManifest (begin, end) == mfst);
+    assert (CompactIDManifest (begin, end).toIDManifest () == mfst);
+
+    LazyIDManifest lazy (begin, end);
+    vector<string> text;
+    for (size_t g = 0; g < mfst.size (); ++g)
+    {
+        assert (lazy[g].size () == mfst[g].size ());
+        for (IDManifest::ChannelGroupManifest::ConstIterator i =
+                 mfst[g].begin ();
+             i != mfst[g].end ();
+             ++i)
+        {
+            assert (lazy.lookup (g, i.id (), text));
+            assert (text == i.text ());
+            assert (!lazy.contains (g, i.id () + 1));
+        }
+    }
+    assert (!lazy.contains (1, 0));
+    assert (!lazy.contains (1, ~uint64_t (0)));
+
+    //
+    // repeated IDs are rejected as by the other decoders, whether next
+    // to each other or not
+    //
+    const int repeats[2][entries] = {
+        {0, 1, 2, 3, 3, 5, 6, 7}, {3, 7, 0, 5, 1, 6, 3, 4}};
+    for (int r = 0; r < 2; ++r)
+    {
+        vector<char> repeated = reorder (repeats[r]);
+        bool         threw    = false;
+        try
+        {
+            LazyIDManifest bad (
+                repeated.data (), repeated.data () + repeated.size ());
+        }
+        catch (IEX_NAMESPACE::InputExc&)
+        {
+            threw = true;
+        }
+        assert (threw);
+    }
+}
 } // namespace
 
 void
@@ -575,4 +954,11 @@ testIDManifest (const std::string& tempDir)
 
     // test the API prevents creating invalid manifests
     testDoingBadThings ();
+
+    // the hash indexed manifest matches the map based one
+    testCompactManifest ();
+
+    // lookups without decoding the whole manifest
+    testLazyManifest ();
+    testLazyManifestOrder ();
 }
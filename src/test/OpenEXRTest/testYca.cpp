@@ -9,12 +9,20 @@
 
 #include "IlmThread.h"
 #include "ImathMath.h"
+#include <ImathRandom.h>
 #include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfChromaticities.h>
+#include <ImfFrameBuffer.h>
+#include <ImfInputFile.h>
 #include <ImfRgbaFile.h>
+#include <ImfRgbaYca.h>
 #include <ImfThreading.h>
 #include <algorithm>
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
+#include <vector>
 
 using namespace OPENEXR_IMF_NAMESPACE;
 using namespace std;
@@ -178,6 +186,602 @@ writeReadYca (
     remove (fileName);
 }
 
+//
+// Scalar reference versions of the RgbaYca conversions and filters,
+// which the library may run with AVX and F16C instead. They do the same
+// float operations in the same order, so the results must be identical.
+//
+
+using RgbaYca::N;
+using RgbaYca::N2;
+
+const float decimateCoeffs[15] = {
+    0.001064f,
+    -0.003771f,
+    0.009801f,
+    -0.021586f,
+    0.043978f,
+    -0.093067f,
+    0.313659f,
+    0.499846f,
+    0.313659f,
+    -0.093067f,
+    0.043978f,
+    -0.021586f,
+    0.009801f,
+    -0.003771f,
+    0.001064f};
+
+const int decimateTaps[15] = {
+    0, 2, 4, 6, 8, 10, 12, 13, 14, 16, 18, 20, 22, 24, 26};
+
+const float reconstructCoeffs[14] = {
+    0.002128f,
+    -0.007540f,
+    0.019597f,
+    -0.043159f,
+    0.087929f,
+    -0.186077f,
+    0.627123f,
+    0.627123f,
+    -0.186077f,
+    0.087929f,
+    -0.043159f,
+    0.019597f,
+    -0.007540f,
+    0.002128f};
+
+const int reconstructTaps[14] = {
+    0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26};
+
+template <int numTaps>
+void
+filterChroma (
+    const float coeffs[numTaps],
+    const int   taps[numTaps],
+    const Rgba* const in[N],
+    int         i,
+    Rgba&       out)
+{
+    float r = float (in[taps[0]][i].r) * coeffs[0];
+    float b = float (in[taps[0]][i].b) * coeffs[0];
+
+    for (int k = 1; k < numTaps; ++k)
+    {
+        r = r + float (in[taps[k]][i].r) * coeffs[k];
+        b = b + float (in[taps[k]][i].b) * coeffs[k];
+    }
+
+    out.r = r;
+    out.b = b;
+}
+
+void
+refRGBAtoYCA (
+    const V3f& yw, int n, bool aIsValid, const Rgba rgbaIn[], Rgba ycaOut[])
+{
+    for (int i = 0; i < n; ++i)
+    {
+        Rgba  in  = rgbaIn[i];
+        Rgba& out = ycaOut[i];
+
+        if (!in.r.isFinite () || in.r < 0) in.r = 0;
+        if (!in.g.isFinite () || in.g < 0) in.g = 0;
+        if (!in.b.isFinite () || in.b < 0) in.b = 0;
+
+        if (in.r == in.g && in.g == in.b)
+        {
+            out.r = 0;
+            out.g = in.g;
+            out.b = 0;
+        }
+        else
+        {
+            out.g = in.r * yw.x + in.g * yw.y + in.b * yw.z;
+
+            float Y = out.g;
+
+            if (abs (in.r - Y) < HALF_MAX * Y)
+                out.r = (in.r - Y) / Y;
+            else
+                out.r = 0;
+
+            if (abs (in.b - Y) < HALF_MAX * Y)
+                out.b = (in.b - Y) / Y;
+            else
+                out.b = 0;
+        }
+
+        out.a = aIsValid ? in.a : half (1);
+    }
+}
+
+void
+refYCAtoRGBA (const V3f& yw, int n, const Rgba ycaIn[], Rgba rgbaOut[])
+{
+    for (int i = 0; i < n; ++i)
+    {
+        const Rgba& in  = ycaIn[i];
+        Rgba&       out = rgbaOut[i];
+
+        if (in.r == 0 && in.b == 0)
+        {
+            out.r = in.g;
+            out.g = in.g;
+            out.b = in.g;
+            out.a = in.a;
+        }
+        else
+        {
+            float Y = in.g;
+            float r = (in.r + 1) * Y;
+            float b = (in.b + 1) * Y;
+            float g = (Y - r * yw.x - b * yw.z) / yw.y;
+
+            out.r = r;
+            out.g = g;
+            out.b = b;
+            out.a = in.a;
+        }
+    }
+}
+
+void
+refDecimateChromaHoriz (int n, const Rgba ycaIn[], Rgba ycaOut[])
+{
+    const Rgba* in[N];
+
+    for (int j = 0; j < n; ++j)
+    {
+        for (int k = 0; k < N; ++k)
+            in[k] = ycaIn + j + k;
+
+        if ((j & 1) == 0)
+            filterChroma<15> (decimateCoeffs, decimateTaps, in, 0, ycaOut[j]);
+
+        ycaOut[j].g = ycaIn[j + N2].g;
+        ycaOut[j].a = ycaIn[j + N2].a;
+    }
+}
+
+void
+refDecimateChromaVert (int n, const Rgba* const ycaIn[N], Rgba ycaOut[])
+{
+    for (int i = 0; i < n; ++i)
+    {
+        if ((i & 1) == 0)
+            filterChroma<15> (decimateCoeffs, decimateTaps, ycaIn, i, ycaOut[i]);
+
+        ycaOut[i].g = ycaIn[N2][i].g;
+        ycaOut[i].a = ycaIn[N2][i].a;
+    }
+}
+
+void
+refReconstructChromaHoriz (int n, const Rgba ycaIn[], Rgba ycaOut[])
+{
+    const Rgba* in[N];
+
+    for (int j = 0; j < n; ++j)
+    {
+        for (int k = 0; k < N; ++k)
+            in[k] = ycaIn + j + k;
+
+        if (j & 1)
+            filterChroma<14> (
+                reconstructCoeffs, reconstructTaps, in, 0, ycaOut[j]);
+        else
+        {
+            ycaOut[j].r = ycaIn[j + N2].r;
+            ycaOut[j].b = ycaIn[j + N2].b;
+        }
+
+        ycaOut[j].g = ycaIn[j + N2].g;
+        ycaOut[j].a = ycaIn[j + N2].a;
+    }
+}
+
+void
+refReconstructChromaVert (int n, const Rgba* const ycaIn[N], Rgba ycaOut[])
+{
+    for (int i = 0; i < n; ++i)
+    {
+        filterChroma<14> (reconstructCoeffs, reconstructTaps, ycaIn, i, ycaOut[i]);
+
+        ycaOut[i].g = ycaIn[N2][i].g;
+        ycaOut[i].a = ycaIn[N2][i].a;
+    }
+}
+
+bool
+sameHalf (half a, half b)
+{
+    return a.bits () == b.bits () || (a.isNan () && b.isNan ());
+}
+
+bool
+samePixels (int n, const Rgba p1[], const Rgba p2[])
+{
+    for (int i = 0; i < n; ++i)
+    {
+        if (!sameHalf (p1[i].r, p2[i].r) || !sameHalf (p1[i].g, p2[i].g) ||
+            !sameHalf (p1[i].b, p2[i].b) || !sameHalf (p1[i].a, p2[i].a))
+        {
+            cout << "pixel " << i << " differs" << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+half
+randomHalf (Rand48& rand, bool specials)
+{
+    if (specials)
+    {
+        switch (rand.nexti () % 16)
+        {
+            case 0: return half::qNan ();
+            case 1: return half::posInf ();
+            case 2: return half::negInf ();
+            case 3: return half (0.f);
+            case 4: return half (HALF_DENORM_MIN);
+            case 5: return half (-0.5f);
+            case 6: return half (HALF_MAX);
+            default: break;
+        }
+    }
+
+    return half (float (rand.nextf (-0.25, 4.0)));
+}
+
+void
+fillRandom (Rand48& rand, Rgba* pixels, int n, bool specials)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        pixels[i].r = randomHalf (rand, specials);
+        pixels[i].g = randomHalf (rand, specials);
+        pixels[i].b = randomHalf (rand, specials);
+        pixels[i].a = randomHalf (rand, specials);
+
+        if (rand.nexti () % 8 == 0) // gray pixels take a special case
+            pixels[i].r = pixels[i].b = pixels[i].g;
+    }
+}
+
+void
+testKernels (int n, Rand48& rand, bool specials)
+{
+    V3f yw = RgbaYca::computeYw (Chromaticities ());
+
+    std::vector<Rgba> in ((n + N - 1) * N);
+    std::vector<Rgba> out1 (n), out2 (n);
+    const Rgba*       lines[N];
+
+    fillRandom (rand, in.data (), int (in.size ()), specials);
+
+    for (int k = 0; k < N; ++k)
+        lines[k] = &in[k * (n + N - 1)];
+
+    RgbaYca::RGBAtoYCA (yw, n, true, in.data (), out1.data ());
+    refRGBAtoYCA (yw, n, true, in.data (), out2.data ());
+    assert (samePixels (n, out1.data (), out2.data ()));
+
+    RgbaYca::RGBAtoYCA (yw, n, false, in.data (), out1.data ());
+    refRGBAtoYCA (yw, n, false, in.data (), out2.data ());
+    assert (samePixels (n, out1.data (), out2.data ()));
+
+    RgbaYca::YCAtoRGBA (yw, n, in.data (), out1.data ());
+    refYCAtoRGBA (yw, n, in.data (), out2.data ());
+    assert (samePixels (n, out1.data (), out2.data ()));
+
+    //
+    // The filters only write the chroma of every other output pixel
+    //
+
+    out1.assign (n, Rgba (0, 0, 0, 0));
+    out2.assign (n, Rgba (0, 0, 0, 0));
+    RgbaYca::decimateChromaHoriz (n, in.data (), out1.data ());
+    refDecimateChromaHoriz (n, in.data (), out2.data ());
+    assert (samePixels (n, out1.data (), out2.data ()));
+
+    out1.assign (n, Rgba (0, 0, 0, 0));
+    out2.assign (n, Rgba (0, 0, 0, 0));
+    RgbaYca::decimateChromaVert (n, lines, out1.data ());
+    refDecimateChromaVert (n, lines, out2.data ());
+    assert (samePixels (n, out1.data (), out2.data ()));
+
+    RgbaYca::reconstructChromaHoriz (n, in.data (), out1.data ());
+    refReconstructChromaHoriz (n, in.data (), out2.data ());
+    assert (samePixels (n, out1.data (), out2.data ()));
+
+    RgbaYca::reconstructChromaVert (n, lines, out1.data ());
+    refReconstructChromaVert (n, lines, out2.data ());
+    assert (samePixels (n, out1.data (), out2.data ()));
+}
+
+//
+// Compute the pixels RgbaOutputFile stores in a luminance/chroma file,
+// the way it used to, one scan line at a time: each line is filtered
+// horizontally as it is converted, and the first and last lines are
+// repeated at the top and bottom of the image for the vertical filter.
+// Lines are numbered from the top of the data window.
+//
+
+void
+referenceToYca (
+    const Array2D<Rgba>& pixels,
+    int                  w,
+    int                  h,
+    RgbaChannels         channels,
+    LineOrder            lineOrder,
+    Array2D<Rgba>&       yca)
+{
+    bool writeC = (channels & WRITE_C) != 0;
+    bool writeA = (channels & WRITE_A) != 0;
+    V3f  yw     = RgbaYca::computeYw (Chromaticities ());
+
+    std::vector<Rgba>              tmpBuf (w + N - 1);
+    std::vector<std::vector<Rgba>> lines (N, std::vector<Rgba> (w));
+    Rgba*                          buf[N];
+
+    for (int i = 0; i < N; ++i)
+        buf[i] = lines[i].data ();
+
+    int linesConverted = 0;
+    int linesWritten   = 0;
+
+    auto writeLine = [&] (const Rgba* line) {
+        int y =
+            lineOrder == INCREASING_Y ? linesWritten : h - 1 - linesWritten;
+
+        for (int x = 0; x < w; ++x)
+            yca[y][x] = line[x];
+
+        ++linesWritten;
+    };
+
+    auto rotateBuffers = [&] () {
+        Rgba* tmp = buf[0];
+
+        for (int i = 0; i < N - 1; ++i)
+            buf[i] = buf[i + 1];
+
+        buf[N - 1] = tmp;
+    };
+
+    auto duplicateBuffer = [&] (int i) {
+        rotateBuffers ();
+        memcpy (buf[N - 1], buf[i], w * sizeof (Rgba));
+    };
+
+    auto decimateVertAndWrite = [&] () {
+        if (linesConverted & 1)
+            memcpy (tmpBuf.data (), buf[N2], w * sizeof (Rgba));
+        else
+            RgbaYca::decimateChromaVert (w, buf, tmpBuf.data ());
+
+        RgbaYca::roundYCA (w, 7, 5, tmpBuf.data (), tmpBuf.data ());
+        writeLine (tmpBuf.data ());
+    };
+
+    for (int i = 0; i < h; ++i)
+    {
+        int y = lineOrder == INCREASING_Y ? i : h - 1 - i;
+
+        if (!writeC)
+        {
+            RgbaYca::RGBAtoYCA (yw, w, writeA, &pixels[y][0], tmpBuf.data ());
+            writeLine (tmpBuf.data ());
+            continue;
+        }
+
+        RgbaYca::RGBAtoYCA (yw, w, writeA, &pixels[y][0], &tmpBuf[N2]);
+
+        for (int j = 0; j < N2; ++j)
+        {
+            tmpBuf[j]          = tmpBuf[N2];
+            tmpBuf[w + N2 + j] = tmpBuf[max (w - 2, 0) + N2];
+        }
+
+        rotateBuffers ();
+        RgbaYca::decimateChromaHoriz (w, tmpBuf.data (), buf[N - 1]);
+
+        if (linesConverted == 0)
+        {
+            for (int j = 0; j < N2; ++j)
+                duplicateBuffer (N - 2);
+        }
+
+        ++linesConverted;
+
+        if (linesConverted > N2) decimateVertAndWrite ();
+
+        if (linesConverted >= h)
+        {
+            for (int j = 0; j < N2 - h; ++j)
+                duplicateBuffer (N - 2);
+
+            duplicateBuffer (N - 3);
+            ++linesConverted;
+            decimateVertAndWrite ();
+
+            for (int j = 1; j < min (h, N2); ++j)
+            {
+                duplicateBuffer (N - 2);
+                ++linesConverted;
+                decimateVertAndWrite ();
+            }
+        }
+    }
+
+    assert (linesWritten == h);
+}
+
+//
+// Write an image with RgbaOutputFile, in batches of linesPerCall scan
+// lines, and compare the luminance/chroma channels stored in the file
+// with referenceToYca().
+//
+
+void
+writeCompareYca (
+    const char   fileName[],
+    const Box2i& dw,
+    RgbaChannels channels,
+    LineOrder    lineOrder,
+    int          linesPerCall)
+{
+    int           w = dw.max.x - dw.min.x + 1;
+    int           h = dw.max.y - dw.min.y + 1;
+    Array2D<Rgba> pixels (h, w);
+    Array2D<Rgba> expected (h, w);
+
+    cout << w << " by " << h << ", channels " << channels << ", line order "
+         << lineOrder << ", " << linesPerCall << " lines per call" << endl;
+
+    fillPixelsColor (pixels, w, h);
+    referenceToYca (pixels, w, h, channels, lineOrder, expected);
+
+    {
+        RgbaOutputFile out (
+            fileName,
+            dw,
+            dw,
+            channels,
+            1,
+            V2f (0, 0),
+            1,
+            lineOrder);
+
+        out.setFrameBuffer (&pixels[-dw.min.y][-dw.min.x], 1, w);
+
+        for (int y = 0; y < h; y += linesPerCall)
+            out.writePixels (min (linesPerCall, h - y));
+    }
+
+    Array2D<half> Y (h, w), RY (h, w), BY (h, w), A (h, w);
+
+    {
+        InputFile   in (fileName);
+        FrameBuffer fb;
+        size_t      xs = sizeof (half);
+        size_t      ys = sizeof (half) * w;
+
+        fb.insert (
+            "Y", Slice (HALF, (char*) &Y[-dw.min.y][-dw.min.x], xs, ys));
+        fb.insert (
+            "A", Slice (HALF, (char*) &A[-dw.min.y][-dw.min.x], xs, ys));
+
+        //
+        // Store each chroma sample at the position of the pixel it
+        // belongs to; the data window starts at even coordinates.
+        //
+
+        assert (dw.min.x % 2 == 0 && dw.min.y % 2 == 0);
+
+        fb.insert (
+            "RY",
+            Slice (
+                HALF,
+                (char*) &RY[0][0] - dw.min.x * xs - dw.min.y * ys,
+                2 * xs,
+                2 * ys,
+                2,
+                2));
+        fb.insert (
+            "BY",
+            Slice (
+                HALF,
+                (char*) &BY[0][0] - dw.min.x * xs - dw.min.y * ys,
+                2 * xs,
+                2 * ys,
+                2,
+                2));
+
+        in.setFrameBuffer (fb);
+        in.readPixels (dw.min.y, dw.max.y);
+    }
+
+    for (int y = 0; y < h; ++y)
+    {
+        for (int x = 0; x < w; ++x)
+        {
+            const Rgba& e = expected[y][x];
+
+            if (channels & WRITE_Y) assert (sameHalf (Y[y][x], e.g));
+
+            if (channels & WRITE_A) assert (sameHalf (A[y][x], e.a));
+
+            if ((channels & WRITE_C) && x % 2 == 0 && y % 2 == 0)
+            {
+                assert (sameHalf (RY[y][x], e.r));
+                assert (sameHalf (BY[y][x], e.b));
+            }
+        }
+    }
+
+    remove (fileName);
+}
+
+void
+testYcaKernels ()
+{
+    cout << "comparing conversions and filters with scalar code" << endl;
+
+    Rand48 rand (0);
+
+    for (int n = 0; n <= 40; ++n)
+    {
+        testKernels (n, rand, false);
+        testKernels (n, rand, true);
+    }
+
+    testKernels (4099, rand, false);
+    testKernels (4099, rand, true);
+}
+
+void
+testToYca (const std::string& fileName)
+{
+    cout << "comparing luminance/chroma output with line at a time conversion"
+         << endl;
+
+    //
+    // Heights below, at and above N2, where the first and last lines are
+    // repeated differently, and widths including a single pixel.
+    //
+
+    const int widths[]  = {1, 2, 37};
+    const int heights[] = {1, 2, N2 - 1, N2, N2 + 1, 2 * N2 + 3, 100};
+
+    for (int w: widths)
+    {
+        for (int h: heights)
+        {
+            for (int lineOrder = INCREASING_Y; lineOrder <= DECREASING_Y;
+                 ++lineOrder)
+            {
+                Box2i dw (V2i (0, 0), V2i (w - 1, h - 1));
+
+                writeCompareYca (
+                    fileName.c_str (), dw, WRITE_YCA, LineOrder (lineOrder), h);
+                writeCompareYca (
+                    fileName.c_str (), dw, WRITE_YC, LineOrder (lineOrder), 7);
+                writeCompareYca (
+                    fileName.c_str (), dw, WRITE_YA, LineOrder (lineOrder), 1);
+            }
+        }
+    }
+
+    Box2i dw (V2i (-18, -28), V2i (247, 255));
+
+    writeCompareYca (fileName.c_str (), dw, WRITE_YCA, INCREASING_Y, 284);
+    writeCompareYca (fileName.c_str (), dw, WRITE_YCA, DECREASING_Y, 5);
+}
+
 } // namespace
 
 void
@@ -189,13 +793,19 @@ testYca (const std::string& tempDir)
 
         std::string fileName = tempDir + "imf_test_yca.exr";
 
-        Box2i dataWindow[6];
+        testYcaKernels ();
+
+        std::string fileName = tempDir + "imf_test_yca.exr";
+
+        Box2i dataWindow[8];
         dataWindow[0] = Box2i (V2i (0, 0), V2i (1, 17));
         dataWindow[1] = Box2i (V2i (0, 0), V2i (5, 17));
         dataWindow[2] = Box2i (V2i (0, 0), V2i (17, 1));
         dataWindow[3] = Box2i (V2i (0, 0), V2i (17, 5));
         dataWindow[4] = Box2i (V2i (0, 0), V2i (1, 1));
         dataWindow[5] = Box2i (V2i (-18, -28), V2i (247, 255));
+        dataWindow[6] = Box2i (V2i (0, 0), V2i (0, 17));
+        dataWindow[7] = Box2i (V2i (0, 0), V2i (17, N2 - 1));
 
         int maxThreads = ILMTHREAD_NAMESPACE::supportsThreads () ? 3 : 0;
 
@@ -207,7 +817,9 @@ testYca (const std::string& tempDir)
                 cout << "\nnumber of threads: " << globalThreadCount () << endl;
             }
 
-            for (int i = 0; i < 6; ++i)
+            testToYca (fileName);
+
+            for (int i = 0; i < 8; ++i)
             {
                 for (int writeOrder = INCREASING_Y; writeOrder <= DECREASING_Y;
                      ++writeOrder)
@@ -15,6 +15,7 @@
 
 #include <cassert>
 #include <cstdio>
+#include <vector>
 
 using namespace OPENEXR_IMF_NAMESPACE;
 using namespace IMATH_NAMESPACE;
@@ -450,6 +451,106 @@ testSetSampleCounts ()
     testSetSampleCounts (Box2i (V2i (50, 10), V2i (699, 199)));
 }
 
+void
+testEditRows (const Box2i& dataWindow)
+{
+    cout << "edit rows of sample counts, data window = "
+            "("
+         << dataWindow.min.x << ", " << dataWindow.min.y
+         << ") - "
+            "("
+         << dataWindow.max.x << ", " << dataWindow.max.y << ")" << endl;
+
+    //
+    // Change the sample counts of ranges of rows in two identical
+    // images, pixel by pixel in one and a range of rows at a time in
+    // the other, and verify that the images remain the same.
+    //
+
+    DeepImage img1 (dataWindow, ONE_LEVEL);
+    img1.insertChannel ("F", FLOAT);
+    img1.insertChannel ("H", HALF);
+
+    DeepImage img2 (dataWindow, ONE_LEVEL);
+    img2.insertChannel ("F", FLOAT);
+    img2.insertChannel ("H", HALF);
+
+    {
+        Rand48 random (2);
+        fillChannels (random, img1);
+    }
+
+    {
+        Rand48 random (2);
+        fillChannels (random, img2);
+    }
+
+    Rand48 random (3);
+
+    SampleCountChannel& scc1 = img1.level ().sampleCounts ();
+    SampleCountChannel& scc2 = img2.level ().sampleCounts ();
+
+    int w = scc1.pixelsPerRow ();
+    int h = scc1.pixelsPerColumn ();
+
+    for (int pass = 0; pass < 20; ++pass)
+    {
+        int r0 = random.nexti () % h;
+        int r1 = r0 + random.nexti () % 8;
+        if (r1 >= h) r1 = h - 1;
+
+        // every fifth pass grows the lists enough to force reallocation
+        int maxSamples = (pass % 5 == 4) ? 40 : 12;
+
+        vector<unsigned int> counts (size_t (r1 - r0 + 1) * w);
+        for (size_t i = 0; i < counts.size (); ++i)
+            counts[i] = random.nexti () % (maxSamples + 1);
+
+        for (int r = r0; r <= r1; ++r)
+            for (int i = 0; i < w; ++i)
+                scc1.set (
+                    dataWindow.min.x + i,
+                    dataWindow.min.y + r,
+                    counts[size_t (r - r0) * w + i]);
+
+        if (r0 == r1)
+        {
+            scc2.set (r0, &counts[0]);
+        }
+        else
+        {
+            SampleCountChannel::Edit edit (scc2, r0, r1);
+
+            for (size_t i = 0; i < counts.size (); ++i)
+                edit.sampleCounts ()[i] = counts[i];
+        }
+
+        verifyImagesAreEqual (img1, img2);
+    }
+
+    bool caught = false;
+
+    try
+    {
+        scc2.beginEdit (h - 1, h); // last row is out of range
+        assert (false);
+    }
+    catch (...)
+    {
+        // expecting exception
+        caught = true;
+    }
+    assert (caught);
+}
+
+void
+testEditRows ()
+{
+    testEditRows (Box2i (V2i (0, 0), V2i (99, 79)));
+    testEditRows (Box2i (V2i (-10, -50), V2i (109, 29)));
+    testEditRows (Box2i (V2i (50, 10), V2i (179, 99)));
+}
+
 void
 testShiftPixels ()
 {
@@ -683,6 +784,7 @@ testDeepImage (const string& tempDir)
         testScanLineImages (tempDir + "deepScanLines.exr");
         testTiledImages (tempDir + "deepTiles.exr");
         testSetSampleCounts ();
+        testEditRows ();
         testShiftPixels ();
         testCropping (tempDir + "deepCropped.exr");
         testRenameChannel ();
@@ -3,7 +3,8 @@
 # SPDX-License-Identifier: BSD-3-Clause
 # Copyright (c) Contributors to the OpenEXR Project.
 
-import sys, os
+import sys, os, struct, tempfile
+from subprocess import PIPE, run
 from do_run import do_run
 
 print(f"testing exrcheck: {' '.join(sys.argv)}")
@@ -22,6 +23,78 @@ for exr_file in image_files:
     do_run([exrcheck, "-t", exr_file])
     do_run([exrcheck, "-s", exr_file])
     do_run([exrcheck, "-c", exr_file])
+    do_run([exrcheck, "-c", "-p", "4", exr_file])
+    do_run([exrcheck, "-c", "-m", "-t", "-s", "-p", "4", exr_file])
+
+result = do_run([exrcheck, "-c", "-p", "4", "--timing"] + image_files)
+if f"checked {len(image_files)} files" not in result.stdout:
+    print(f"error: missing throughput summary:\n{result.stdout}")
+    sys.exit(1)
+
+# damaged files must get the same verdict with the chunks checked in
+# parallel as they do serially, and must not crash either way
+
+def end_of_headers(data):
+    multipart = struct.unpack_from("<I", data, 4)[0] & 0x1000
+    pos = 8
+    while True:
+        start = pos
+        while data[pos] != 0:
+            pos = data.index(b"\0", pos) + 1 # name
+            pos = data.index(b"\0", pos) + 1 # type
+            pos += 4 + struct.unpack_from("<i", data, pos)[0]
+        pos += 1
+        if not multipart or pos - 1 == start:
+            return pos
+
+def check(args, exr_file):
+    cmd = [exrcheck] + args + [exr_file]
+    print(f"running {' '.join(cmd)}")
+    result = run(cmd, stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    if result.returncode not in (0, 1):
+        print(f"error: {' '.join(cmd)} crashed: returncode={result.returncode}")
+        print(f"stderr:\n{result.stderr}")
+        sys.exit(1)
+    return result
+
+with tempfile.TemporaryDirectory() as tempdir:
+
+    for exr_file in image_files:
+
+        with open(exr_file, "rb") as f:
+            data = f.read()
+        table = end_of_headers(data)
+        name = os.path.basename(exr_file)
+
+        garbage = bytearray(data)
+        garbage[len(data) * 2 // 3:len(data) * 2 // 3 + 64] = b"\x5a" * 64
+        offsets = bytearray(data)
+        offsets[table:table + 8] = b"\xff" * 8
+
+        damaged = [
+            (f"{tempdir}/short.{name}", data[:len(data) * 3 // 4], True),
+            (f"{tempdir}/table.{name}", data[:table + 8], True),
+            (f"{tempdir}/offsets.{name}", offsets, False),
+            (f"{tempdir}/garbage.{name}", garbage, False),
+        ]
+
+        for path, contents, must_fail in damaged:
+
+            with open(path, "wb") as f:
+                f.write(contents)
+
+            for options in [["-c"], ["-c", "-m", "-t"]]:
+                serial = check(options, path)
+                parallel = check(options + ["-p", "4"], path)
+                if must_fail and serial.returncode != 1:
+                    print(f"error: {path} was not reported as bad")
+                    sys.exit(1)
+                if (serial.returncode != parallel.returncode or
+                    serial.stdout != parallel.stdout):
+                    print(f"error: {path} checked differently with -p 4")
+                    print(f"serial:\n{serial.stdout}")
+                    print(f"parallel:\n{parallel.stdout}")
+                    sys.exit(1)
 
 print("success.")
 sys.exit(0)
@@ -175,6 +175,21 @@ for z in ["none", "rle", "zip", "piz", "pxr24", "b44", "b44a", "dwaa", "dwab"]:
     assert f'compression: compression \'{z}\'' in result.stdout
     os.unlink(outimage)
 
+# -b, with and without threads
+with tempfile.TemporaryDirectory() as tempdir:
+
+    blurred = f"{tempdir}/blurred.exr"
+    blurred_threads = f"{tempdir}/blurred_threads.exr"
+
+    result = do_run ([exrenvmap, "-b", "--threads", "0", test_images["latlong"], blurred])
+    result = do_run ([exrenvmap, "-b", "--threads", "4", test_images["latlong"], blurred_threads])
+
+    with open(blurred, "rb") as f1, open(blurred_threads, "rb") as f2:
+        assert f1.read() == f2.read()
+
+result = do_run ([exrenvmap, "--threads", "-1", test_images["latlong"], outimage], True)
+assert not os.path.isfile(outimage)
+
 with tempfile.TemporaryDirectory() as tempdir:
 
     cube_face_image_t = f"{tempdir}/out.%.exr"
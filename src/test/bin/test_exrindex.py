@@ -0,0 +1,78 @@
+#!/usr/bin/env python
+
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright (c) Contributors to the OpenEXR Project.
+
+import sys, os, shutil, tempfile, atexit
+from do_run import do_run
+
+print(f"testing exrindex: {sys.argv}")
+
+exrindex = sys.argv[1]
+exrinfo = sys.argv[2]
+image_dir = sys.argv[3]
+version = sys.argv[4]
+
+fd, index = tempfile.mkstemp(".exrx")
+os.close(fd)
+fd, frame = tempfile.mkstemp(".exr")
+os.close(fd)
+
+def cleanup():
+    print(f"deleting {index} {frame}")
+    for f in [index, frame]:
+        if os.path.exists(f):
+            os.unlink(f)
+atexit.register(cleanup)
+
+# no args = usage message, error
+result = do_run ([exrindex], True)
+assert result.stderr.startswith ("Usage: ")
+
+# -h = usage message
+result = do_run ([exrindex, "-h"])
+assert result.stdout.startswith ("Usage: ")
+
+result = do_run ([exrindex, "--help"])
+assert result.stdout.startswith ("Usage: ")
+
+# --version
+result = do_run ([exrindex, "--version"])
+assert result.stdout.startswith ("exrindex")
+assert version in result.stdout
+
+# invalid arguments
+result = do_run ([exrindex, "-l"], True)
+result = do_run ([exrindex, "-o", index], True)
+result = do_run ([exrindex, "-o", index, f"{image_dir}/nonexistent.exr"], True)
+assert not os.path.exists(index)
+
+images = [f"{image_dir}/GrayRampsHorizontal.exr",
+          f"{image_dir}/multipart.0001.exr",
+          frame]
+shutil.copyfile(f"{image_dir}/Flowers.exr", frame)
+
+result = do_run ([exrindex, "-o", index] + images)
+
+result = do_run ([exrindex, "-l", index])
+output = result.stdout.splitlines()
+assert len(output) == len(images)
+for line, image in zip(output, images):
+    assert line.startswith(f"{image}: ")
+
+result = do_run ([exrindex, "-c", index])
+output = result.stdout.splitlines()
+assert output[0] == f"{images[0]}: ok, 1 part(s)"
+assert output[1] == f"{images[1]}: ok, 10 part(s)"
+assert output[2] == f"{images[2]}: ok, 1 part(s)"
+
+# a file which changed since it was indexed is reported as stale
+with open(frame, "ab") as f:
+    f.write(b"\0" * 16)
+result = do_run ([exrindex, "-c", index], True)
+assert f"{frame}: stale" in result.stdout
+
+# an index is not an image
+result = do_run ([exrindex, "-l", images[0]], True)
+
+print("success")
@@ -24,8 +24,12 @@ assert(os.path.isfile(test_images["GammaChart"])), "\nMissing " + image
 fd, outimage = tempfile.mkstemp(".exr")
 os.close(fd)
 
+fd, outimage2 = tempfile.mkstemp(".exr")
+os.close(fd)
+
 def cleanup():
     print(f"deleting {outimage}")
+    print(f"deleting {outimage2}")
 atexit.register(cleanup)
 
 # no args = usage message
@@ -50,4 +54,18 @@ assert os.path.isfile(outimage)
 result = do_run ([exrinfo, "-v", outimage])
 assert 'tiled image has levels: x 1 y 1' in result.stdout
 
+# multi-resolution images are identical with and without threads
+for mode in ["-m", "-r"]:
+    result = do_run ([exrmaketiled, mode, "--threads", "0", test_images["GammaChart"], outimage])
+    result = do_run ([exrmaketiled, mode, "--threads", "4", test_images["GammaChart"], outimage2])
+
+    result = do_run ([exrinfo, "-v", outimage2])
+    assert 'tiled image has levels: x 10 y 10' in result.stdout
+
+    with open(outimage, "rb") as f1, open(outimage2, "rb") as f2:
+        assert f1.read() == f2.read()
+
+# bad thread count
+result = do_run ([exrmaketiled, "--threads", "-1", test_images["GammaChart"], outimage], True)
+
 print("success")
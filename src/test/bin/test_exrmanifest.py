@@ -47,6 +47,14 @@ for image in test_images:
         stdout_should_be = file.read()
         assert stdout_is == stdout_should_be
 
+# --id looks up individual entries
+result = do_run ([exrmanifest, "--id", "523461226", "-i", "42", test_images["11"]])
+assert "     523461226 id model=circle/medium material=blue\n" in result.stdout
+assert "     42 not found\n" in result.stdout
+
+result = do_run ([exrmanifest, "--id", "notanumber", test_images["11"]], True)
+assert "requires a numeric ID" in result.stderr
+
 print("success")
 
 
@@ -30,6 +30,7 @@
 #include <ImfDeepFrameBuffer.h>
 #include <ImfPartType.h>
 #include <ImfArray.h>
+#include <ImfThreading.h>
 
 #include <ImfBoxAttribute.h>
 #include <ImfChannelListAttribute.h>
@@ -52,6 +53,13 @@
 #include <ImfVecAttribute.h>
 
 #include <typeinfo>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <sys/types.h>
 
 namespace py = pybind11;
@@ -139,11 +147,95 @@ PyFile::PyFile(const py::dict& header, const py::dict& channels)
 // channels dict is "RGB" or "RGBA".  For channels with a prefix,
 // e.g. "left.R", "left.G", etc, the channel key is the prefix.
 //
+// 'threads' is the number of threads used to decode the file, or the
+// global thread count if negative.
+//
+// 'out' optionally provides the numpy arrays to decode into, either a
+// dict (for the first part) or a list of dicts (one per part), with the
+// same keys as the resulting channels dict. Channels not present in
+// 'out' get newly allocated arrays.
+//
+// 'channel_names' optionally restricts the channels read to those with
+// the given names, or in the given layers (i.e. "left" selects
+// "left.R", "left.G", etc). Only the selected channels are added to
+// the frame buffer, so the others are never unpacked.
+//
+// 'data_window' optionally restricts the pixels read to a sub-region
+// ((xmin,ymin),(xmax,ymax)) of the data window; only the scanlines or
+// tiles overlapping the region are decoded.
+//
+// If 'lazy' is true, the pixels of a channel are not decoded until its
+// 'pixels' are first accessed. The file stays open until then.
+//
+// The GIL is released while the file is opened and the pixels are
+// decoded, so reads can overlap in multiple python threads.
+//
+
+static int
+resolveThreadCount(int threads)
+{
+    if (threads < 0)
+        return globalThreadCount();
+    return threads;
+}
+
+bool objectToBox2i(const py::object& object, Box2i& b);
+template <class T> py::array make_v2(const Vec2<T>& v);
+
+static bool
+isSelectedChannel(const std::vector<std::string>& selection, const std::string& name,
+                  std::vector<bool>& matched)
+{
+    bool selected = false;
+    for (size_t i = 0; i < selection.size(); i++)
+    {
+        const std::string& s = selection[i];
+        if (name == s ||
+            (name.size() > s.size() && name.compare(0, s.size(), s) == 0 && name[s.size()] == '.'))
+        {
+            matched[i] = true;
+            selected = true;
+        }
+    }
+    return selected;
+}
 
-PyFile::PyFile(const std::string& filename, bool separate_channels, bool header_only)
+PyFile::PyFile(const std::string& filename, bool separate_channels, bool header_only,
+               int threads, const py::object& out, const py::object& channel_names,
+               const py::object& data_window, bool lazy)
     : filename(filename), header_only(header_only)
 {
-    MultiPartInputFile infile(filename.c_str());
+    std::shared_ptr<PyInputFile> infilePtr;
+    {
+        py::gil_scoped_release release;
+        infilePtr = std::make_shared<PyInputFile>(filename.c_str(), resolveThreadCount(threads));
+    }
+    MultiPartInputFile& infile = infilePtr->file;
+
+    py::list out_parts;
+    if (py::isinstance<py::dict>(out))
+        out_parts.append(out);
+    else if (py::isinstance<py::list>(out))
+        out_parts = out.cast<py::list>();
+    else if (!out.is_none())
+        throw std::invalid_argument("out must be a dict of numpy arrays, or a list of dicts, one per part");
+
+    if (out_parts.size() > static_cast<size_t>(infile.parts()))
+        throw std::invalid_argument("out has more entries than the file has parts");
+
+    std::vector<std::string> selection;
+    if (py::isinstance<py::str>(channel_names))
+        selection.push_back(channel_names.cast<std::string>());
+    else if (!channel_names.is_none())
+    {
+        for (auto n : channel_names)
+            selection.push_back(n.cast<std::string>());
+    }
+    std::vector<bool> matched(selection.size(), false);
+
+    Box2i window;
+    if (!data_window.is_none() && !objectToBox2i(data_window, window))
+        throw std::invalid_argument("data_window must be a tuple ((xmin,ymin),(xmax,ymax))");
 
     for (int part_index = 0; part_index < infile.parts(); part_index++)
     {
@@ -154,8 +246,6 @@ PyFile::PyFile(const std::string& filename, bool separate_channels, bool header_
         P.part_index = part_index;
         
         const Box2i& dw = header.dataWindow();
-        auto width = static_cast<size_t>(dw.max.x - dw.min.x + 1);
-        auto height = static_cast<size_t>(dw.max.y - dw.min.y + 1);
 
         //
         // Fill the header dict with attributes from the input file header
@@ -173,8 +263,52 @@ PyFile::PyFile(const std::string& filename, bool separate_channels, bool header_
         //
         
         if (header_only)
+        {
+            parts.append(py::cast<PyPart>(PyPart(P)));
             continue;
+        }
+        
+        //
+        // The channels to read, either all of them, or the selection
+        //
         
+        ChannelList channel_list;
+        for (auto c = header.channels().begin(); c != header.channels().end(); c++)
+            if (channel_names.is_none() || isSelectedChannel(selection, c.name(), matched))
+                channel_list.insert(c.name(), c.channel());
+
+        //
+        // The region to read, either the data window or the requested
+        // sub-region of it
+        //
+
+        Box2i part_window = dw;
+        if (!data_window.is_none())
+        {
+            if (window.isEmpty() ||
+                window.min.x < dw.min.x || window.min.y < dw.min.y ||
+                window.max.x > dw.max.x || window.max.y > dw.max.y)
+            {
+                std::stringstream err;
+                err << "data_window " << window << " is not within the data window "
+                    << dw << " of part " << part_index;
+                throw std::invalid_argument(err.str());
+            }
+
+            for (auto c = channel_list.begin(); c != channel_list.end(); c++)
+                if (c.channel().xSampling != 1 || c.channel().ySampling != 1)
+                {
+                    std::stringstream err;
+                    err << "data_window is not supported for subsampled channel '" << c.name() << "'";
+                    throw std::invalid_argument(err.str());
+                }
+
+            part_window = window;
+        }
+
+        auto width = static_cast<size_t>(part_window.max.x - part_window.min.x + 1);
+        auto height = static_cast<size_t>(part_window.max.y - part_window.min.y + 1);
+
         //
         // If we're gathering RGB channels, identify which channels to gather
         // by examining common prefixes.
@@ -183,17 +317,25 @@ PyFile::PyFile(const std::string& filename, bool separate_channels, bool header_
         std::set<std::string> rgbaChannels;
         if (!separate_channels)
         {
-            for (auto c = header.channels().begin(); c != header.channels().end(); c++)
+            for (auto c = channel_list.begin(); c != channel_list.end(); c++)
             {
                 std::string py_channel_name;
                 char channel_name;
-                if (P.channelNameToRGBA(header.channels(), c.name(), py_channel_name, channel_name) > 0)
+                if (P.channelNameToRGBA(channel_list, c.name(), py_channel_name, channel_name) > 0)
                     rgbaChannels.insert(c.name());
             }
         }
         
         std::vector<size_t> shape ({height, width});
 
+        py::dict out_channels;
+        if (static_cast<size_t>(part_index) < out_parts.size() && !out_parts[part_index].is_none())
+        {
+            if (!py::isinstance<py::dict>(out_parts[part_index]))
+                throw std::invalid_argument("out must be a dict of numpy arrays, or a list of dicts, one per part");
+            out_channels = out_parts[part_index].cast<py::dict>();
+        }
+
         //
         // Read the channel data, different for image vs. deep
         //
@@ -201,23 +343,272 @@ PyFile::PyFile(const std::string& filename, bool separate_channels, bool header_
         auto type = header.type();
         if (type == SCANLINEIMAGE || type == TILEDIMAGE)
         {
-            P.readPixels(infile, header.channels(), shape, rgbaChannels, dw, separate_channels);
+            P.readPixels(infilePtr, channel_list, shape, rgbaChannels, dw, part_window,
+                         separate_channels, out_channels, lazy);
+
+            //
+            // The header describes the pixels actually read, so the
+            // part can be written back out as-is.
+            //
+
+            if (!data_window.is_none())
+                P.header["dataWindow"] = py::make_tuple(make_v2<int>(part_window.min),
+                                                        make_v2<int>(part_window.max));
         }
         else if (type == DEEPSCANLINE || type == DEEPTILE)
         {
-            P.readDeepPixels(infile, type, header.channels(), shape, rgbaChannels, dw, separate_channels);
+            if (out_channels.size() > 0)
+                throw std::invalid_argument("out arrays are not supported for deep parts");
+            if (!data_window.is_none())
+                throw std::invalid_argument("data_window is not supported for deep parts");
+            P.readDeepPixels(infile, type, channel_list, shape, rgbaChannels, dw, separate_channels);
         }
         parts.append(py::cast<PyPart>(PyPart(P)));
     } // for parts
+
+    for (size_t i = 0; i < selection.size(); i++)
+        if (!matched[i] && !header_only)
+        {
+            std::stringstream err;
+            err << "no channel or layer named '" << selection[i] << "' in file '" << filename << "'";
+            throw std::invalid_argument(err.str());
+        }
+}
+
+//
+// Validate a caller-provided array to decode a channel into: it must
+// match the array that would otherwise be allocated exactly, since the
+// framebuffer writes directly into its memory.
+//
+
+template <class T>
+static py::array
+validateOutArray(const py::object& object, const std::string& name,
+                 const std::vector<size_t>& c_shape)
+{
+    if (!py::isinstance<py::array>(object))
+    {
+        std::stringstream err;
+        err << "out[\"" << name << "\"] must be a numpy array";
+        throw std::invalid_argument(err.str());
+    }
+
+    auto a = object.cast<py::array>();
+    
+    if (!a.dtype().equal(py::dtype::of<T>()))
+    {
+        std::stringstream err;
+        err << "out[\"" << name << "\"] has dtype " << py::str(a.dtype()).cast<std::string>()
+            << ", expected " << py::str(py::dtype::of<T>()).cast<std::string>();
+        throw std::invalid_argument(err.str());
+    }
+
+    bool shape_ok = static_cast<size_t>(a.ndim()) == c_shape.size();
+    for (size_t i = 0; shape_ok && i < c_shape.size(); i++)
+        shape_ok = static_cast<size_t>(a.shape(i)) == c_shape[i];
+    if (!shape_ok)
+    {
+        std::stringstream err;
+        err << "out[\"" << name << "\"] has shape (";
+        for (decltype(a.ndim()) i = 0; i < a.ndim(); i++)
+            err << (i > 0 ? ", " : "") << a.shape(i);
+        err << "), expected (";
+        for (size_t i = 0; i < c_shape.size(); i++)
+            err << (i > 0 ? ", " : "") << c_shape[i];
+        err << ")";
+        throw std::invalid_argument(err.str());
+    }
+
+    if (!(a.flags() & py::array::c_style) || !a.writeable())
+    {
+        std::stringstream err;
+        err << "out[\"" << name << "\"] must be a writeable, C-contiguous array";
+        throw std::invalid_argument(err.str());
+    }
+
+    return a;
+}
+
+//
+// Decode the pixels for the given sources, which all come from the same
+// part, with a single frame buffer. Sources which are already decoded
+// are skipped.
+//
+
+static void
+decodePixelSources(const std::vector<std::shared_ptr<PyPixelSource>>& sources)
+{
+    const auto style = py::array::c_style | py::array::forcecast;
+
+    struct Dest
+    {
+        PyPixelSource* source;
+        uint8_t*       ptr;
+        size_t         itemsize;
+    };
+    
+    std::vector<Dest> dests;
+
+    //
+    // Allocate the arrays while we still have the GIL
+    //
+    
+    for (auto& s : sources)
+    {
+        if (s->decoded)
+            continue;
+        
+        if (!s->pixels)
+        {
+            switch (s->type)
+            {
+              case UINT:
+                  s->pixels = py::array_t<uint32_t,style>(s->shape);
+                  break;
+              case HALF:
+                  s->pixels = py::array_t<half,style>(s->shape);
+                  break;
+              case FLOAT:
+                  s->pixels = py::array_t<float,style>(s->shape);
+                  break;
+              default:
+                  throw std::runtime_error("invalid pixel type");
+            } // switch s->type
+        }
+
+        auto a = s->pixels.cast<py::array>();
+        dests.push_back({s.get(), static_cast<uint8_t*>(a.mutable_data()),
+                         static_cast<size_t>(a.itemsize())});
+    }
+
+    if (dests.empty())
+        return;
+
+    PyInputFile& infile = *dests[0].source->file;
+    int part_index = dests[0].source->part_index;
+    const Box2i& dw = dests[0].source->dw;
+    const Box2i& window = dests[0].source->window;
+
+    py::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock (infile.mutex);
+
+    //
+    // Another thread may have decoded some of the sources while we
+    // waited for the lock.
+    //
+
+    dests.erase (std::remove_if (dests.begin(), dests.end(),
+                                 [] (const Dest& D) { return D.source->decoded.load(); }),
+                 dests.end());
+
+    if (dests.empty())
+        return;
+
+    InputPart part (infile.file, part_index);
+
+    bool crop = window.min.x != dw.min.x || window.max.x != dw.max.x;
+    size_t width = window.max.x - window.min.x + 1;
+
+    if (!crop)
+    {
+        FrameBuffer frameBuffer;
+
+        for (auto& D : dests)
+        {
+            size_t ncomp = D.source->shape.size() == 3 ? D.source->shape[2] : 1;
+            size_t xStride = D.itemsize * ncomp;
+            size_t yStride = xStride * width / D.source->xSampling;
+
+            for (auto& fc : D.source->channels)
+                frameBuffer.insert (fc.first,
+                                    Slice::Make (D.source->type,
+                                                 (void*) (D.ptr + fc.second * D.itemsize),
+                                                 window, xStride, yStride,
+                                                 D.source->xSampling,
+                                                 D.source->ySampling));
+        }
+
+        part.setFrameBuffer (frameBuffer);
+        part.readPixels (window.min.y, window.max.y);
+    }
+    else
+    {
+        //
+        // The library fills complete scanlines of the frame buffer, so
+        // reading a narrower region decodes a band of scanlines at a
+        // time into full width buffers, and copies the requested
+        // columns out. The bands are aligned with the chunks of the
+        // part, so each chunk is decoded once. Cropped reads don't
+        // support subsampled channels.
+        //
+
+        const Header& header = part.header();
+        int chunk_lines = header.hasTileDescription()
+                              ? static_cast<int>(header.tileDescription().ySize)
+                              : getCompressionNumScanlines (header.compression());
+        int band_lines = std::max (chunk_lines, (64 / chunk_lines) * chunk_lines);
+        size_t full_width = dw.max.x - dw.min.x + 1;
+        size_t xOffset = window.min.x - dw.min.x;
+
+        std::vector<std::vector<uint8_t>> band_buffers (dests.size());
+        for (size_t d = 0; d < dests.size(); d++)
+        {
+            size_t ncomp = dests[d].source->shape.size() == 3 ? dests[d].source->shape[2] : 1;
+            band_buffers[d].resize (dests[d].itemsize * ncomp * full_width * band_lines);
+        }
+
+        for (int y0 = window.min.y; y0 <= window.max.y; )
+        {
+            int y1 = std::min (window.max.y,
+                               dw.min.y + ((y0 - dw.min.y) / band_lines + 1) * band_lines - 1);
+            Box2i band (V2i (dw.min.x, y0), V2i (dw.max.x, y1));
+
+            FrameBuffer frameBuffer;
+
+            for (size_t d = 0; d < dests.size(); d++)
+            {
+                Dest& D = dests[d];
+                size_t ncomp = D.source->shape.size() == 3 ? D.source->shape[2] : 1;
+                size_t xStride = D.itemsize * ncomp;
+
+                for (auto& fc : D.source->channels)
+                    frameBuffer.insert (fc.first,
+                                        Slice::Make (D.source->type,
+                                                     (void*) (band_buffers[d].data() + fc.second * D.itemsize),
+                                                     band, xStride, xStride * full_width));
+            }
+
+            part.setFrameBuffer (frameBuffer);
+            part.readPixels (y0, y1);
+
+            for (size_t d = 0; d < dests.size(); d++)
+            {
+                Dest& D = dests[d];
+                size_t ncomp = D.source->shape.size() == 3 ? D.source->shape[2] : 1;
+                size_t pixelBytes = D.itemsize * ncomp;
+
+                for (int y = y0; y <= y1; y++)
+                    memcpy (D.ptr + (y - window.min.y) * width * pixelBytes,
+                            band_buffers[d].data() + ((y - y0) * full_width + xOffset) * pixelBytes,
+                            width * pixelBytes);
+            }
+
+            y0 = y1 + 1;
+        }
+    }
+
+    for (auto& D : dests)
+        D.source->decoded = true;
 }
 
 void
-PyPart::readPixels(MultiPartInputFile& infile, const ChannelList& channel_list,
+PyPart::readPixels(const std::shared_ptr<PyInputFile>& infile, const ChannelList& channel_list,
                    const std::vector<size_t>& shape, const std::set<std::string>& rgbaChannels,
-                   const Box2i& dw, bool separate_channels)
+                   const Box2i& dw, const Box2i& window, bool separate_channels,
+                   const py::dict& out, bool lazy)
 {
-    FrameBuffer frameBuffer;
-
+    std::vector<std::shared_ptr<PyPixelSource>> sources;
+    
     for (auto c = channel_list.begin(); c != channel_list.end(); c++)
     {
         std::string py_channel_name = c.name();
@@ -231,7 +622,8 @@ PyPart::readPixels(MultiPartInputFile& infile, const ChannelList& channel_list,
         if (!channels.contains(py_channel_name_str))
         {
             //
-            // We haven't add a PyChannel yet, so add one now.
+            // We haven't add a PyChannel yet, so add one now, with the
+            // description of where its pixels come from.
             //
             
             PyChannel C;
@@ -241,8 +633,6 @@ PyPart::readPixels(MultiPartInputFile& infile, const ChannelList& channel_list,
             C.ySampling = c.channel().ySampling;
             C.pLinear = c.channel().pLinear;
                 
-            const auto style = py::array::c_style | py::array::forcecast;
-
             std::vector<size_t> c_shape = shape;
 
             //
@@ -254,80 +644,114 @@ PyPart::readPixels(MultiPartInputFile& infile, const ChannelList& channel_list,
             if (rgbaChannels.find(c.name()) != rgbaChannels.end())
                 c_shape.push_back(nrgba);
 
-            switch (c.channel().type)
+            auto source = std::make_shared<PyPixelSource>();
+            source->file = infile;
+            source->part_index = static_cast<int>(part_index);
+            source->dw = dw;
+            source->window = window;
+            source->type = c.channel().type;
+            source->shape = c_shape;
+            source->xSampling = c.channel().xSampling;
+            source->ySampling = c.channel().ySampling;
+
+            if (out.contains(py_channel_name_str))
             {
-              case UINT:
-                  C.pixels = py::array_t<uint32_t,style>(c_shape);
-                  break;
-              case HALF:
-                  C.pixels = py::array_t<half,style>(c_shape);
-                  break;
-              case FLOAT:
-                  C.pixels = py::array_t<float,style>(c_shape);
-                  break;
-              default:
-                  throw std::runtime_error("invalid pixel type");
-            } // switch c->type
+                py::object o = out[py_channel_name_str];
+                switch (c.channel().type)
+                {
+                  case UINT:
+                      source->pixels = validateOutArray<uint32_t>(o, py_channel_name, c_shape);
+                      break;
+                  case HALF:
+                      source->pixels = validateOutArray<half>(o, py_channel_name, c_shape);
+                      break;
+                  case FLOAT:
+                      source->pixels = validateOutArray<float>(o, py_channel_name, c_shape);
+                      break;
+                  default:
+                      throw std::runtime_error("invalid pixel type");
+                } // switch c->type
+            }
+            else if (c.channel().type != UINT &&
+                     c.channel().type != HALF &&
+                     c.channel().type != FLOAT)
+                throw std::runtime_error("invalid pixel type");
 
+            C._source = source;
+            sources.push_back(source);
+            
             channels[py_channel_name.c_str()] = C;
         }
 
         //
-        // Add a slice to the framebuffer
+        // Add the file channel to the PyChannel's source, offset into
+        // the interleaved RGBA pixels
         //
         
-        auto v = channels[py_channel_name.c_str()];
-        auto C = v.cast<PyChannel&>();
+        PyChannel& C = channels[py_channel_name.c_str()].cast<PyChannel&>();
 
-        py::buffer_info buf = C.pixels.request();
-        auto basePtr = static_cast<uint8_t*>(buf.ptr);
-
-        //
-        // Offset the pointer for the channel
-        //
-        
-        py::dtype dt = C.pixels.dtype();
-        size_t xStride = dt.itemsize();
+        int offset = 0;
         if (nrgba > 0)
         {
-            xStride *= nrgba;
             switch (channel_name)
             {
-              case 'R':
-                  break;
               case 'G':
-                  basePtr += dt.itemsize();
+                  offset = 1;
                   break;
               case 'B':
-                  basePtr += 2 * dt.itemsize();
+                  offset = 2;
                   break;
               case 'A':
-                  basePtr += 3 * dt.itemsize();
+                  offset = 3;
                   break;
               default:
                   break;
             }
         }
 
-        size_t yStride = xStride * shape[1] / C.xSampling;
-
-        frameBuffer.insert (c.name(),
-                            Slice::Make (c.channel().type,
-                                         (void*) basePtr,
-                                         dw, xStride, yStride,
-                                         C.xSampling,
-                                         C.ySampling));
-    } // for header.channels()
-
+        C._source->channels.push_back(std::make_pair(std::string(c.name()), offset));
+    } // for channel_list
 
     //
-    // Read the pixels
+    // Unless reading lazily, decode all the channels at once, and let go
+    // of the file.
     //
     
-    InputPart part (infile, part_index);
+    if (!lazy)
+    {
+        decodePixelSources(sources);
+        for (auto c : channels)
+            py::cast<PyChannel&>(c.second).getPixels();
+    }
+}
+
+//
+// Return the pixel array, decoding it first if it hasn't been yet
+//
+
+const py::array&
+PyChannel::getPixels() const
+{
+    if (_source)
+    {
+        //
+        // The GIL is released while decoding, so another thread may
+        // finish first, and reset _source.
+        //
+
+        auto source = _source;
+        decodePixelSources({source});
+        pixels = source->pixels.cast<py::array>();
+        _source.reset();
+    }
+    return pixels;
+}
 
-    part.setFrameBuffer (frameBuffer);
-    part.readPixels (dw.min.y, dw.max.y);
+void
+PyChannel::setPixels(const py::array& p)
+{
+    pixels = p;
+    _source.reset();
 }
 
 void
@@ -566,14 +990,23 @@ PyPart::readDeepPixels(MultiPartInputFile& infile, const std::string& type, cons
                                        c.channel().ySampling));
     } // for header.channels()
 
+    //
+    // The sample arrays are python objects, so the GIL is only released
+    // around the decoding, not while creating the arrays.
+    //
+    
     if (type == DEEPSCANLINE)
     {
         DeepScanLineInputPart part (infile, part_index);
         part.setFrameBuffer (frameBuffer);
-        part.readPixelSampleCounts (dw.min.y, dw.max.y);
+        {
+            py::gil_scoped_release release;
+            part.readPixelSampleCounts (dw.min.y, dw.max.y);
+        }
 
         setDeepSliceData(channel_list, height, width, sliceDataMap, rgbaChannelMap, sampleCount);
 
+        py::gil_scoped_release release;
         part.readPixels (dw.min.y, dw.max.y);
     }
     else if (type == DEEPTILE)
@@ -584,10 +1017,14 @@ PyPart::readDeepPixels(MultiPartInputFile& infile, const std::string& type, cons
         int numXTiles = part.numXTiles (0);
         int numYTiles = part.numYTiles (0);
 
-        part.readPixelSampleCounts (0, numXTiles - 1, 0, numYTiles - 1);
+        {
+            py::gil_scoped_release release;
+            part.readPixelSampleCounts (0, numXTiles - 1, 0, numYTiles - 1);
+        }
 
         setDeepSliceData(channel_list, height, width, sliceDataMap, rgbaChannelMap, sampleCount);
 
+        py::gil_scoped_release release;
         part.readTiles (0, numXTiles - 1, 0, numYTiles - 1);
     }
 }
@@ -596,10 +1033,18 @@ void
 PyPart::writePixels(MultiPartOutputFile& outfile, const Box2i& dw) const
 {
     FrameBuffer frameBuffer;
-        
+
+    //
+    // Hold references to the arrays, so they stay valid while the
+    // GIL is released during the write.
+    //
+    
+    std::vector<py::array> arrays;
+    
     for (auto c : channels)
     {
-        auto C = c.second.cast<const PyChannel&>();
+        const PyChannel& C = c.second.cast<const PyChannel&>();
+        arrays.push_back(C.getPixels());
 
         auto pixelType = C.pixelType();
             
@@ -669,11 +1114,16 @@ PyPart::writePixels(MultiPartOutputFile& outfile, const Box2i& dw) const
         }
     }
                 
-    if (type() == EXR_STORAGE_SCANLINE)
+    auto storage = type();
+    auto lines = height();
+    
+    py::gil_scoped_release release;
+
+    if (storage == EXR_STORAGE_SCANLINE)
     {
         OutputPart part(outfile, part_index);
         part.setFrameBuffer (frameBuffer);
-        part.writePixels (height());
+        part.writePixels (lines);
     }
     else
     {
@@ -864,7 +1314,16 @@ PyPart::writeDeepPixels(MultiPartOutputFile& outfile, const Box2i& dw) const
         }
     }
 
-    if (type() == EXR_STORAGE_DEEP_SCANLINE)
+    //
+    // The channels dict holds the sample arrays, which the slice data
+    // points into, so the GIL isn't needed while encoding them.
+    //
+    
+    auto storage = type();
+
+    py::gil_scoped_release release;
+
+    if (storage == EXR_STORAGE_DEEP_SCANLINE)
     {
         DeepScanLineOutputPart part(outfile, part_index);
         part.setFrameBuffer (frameBuffer);
@@ -965,7 +1424,8 @@ PyFile::__exit__(py::args args)
 
         for (auto c : P.channels)
         {
-            auto C = py::cast<PyChannel&>(c.second);
+            PyChannel& C = py::cast<PyChannel&>(c.second);
+            C._source.reset();
             C.pixels = py::none();
         }
         P.channels.clear();
@@ -1011,11 +1471,12 @@ PyFile::channels(int part_index)
 }
 
 //
-// Write the PyFile to the given filename
+// Write the PyFile to the given filename, using 'threads' threads to
+// encode, or the global thread count if negative.
 //
 
 void
-PyFile::write(const char* outfilename)
+PyFile::write(const char* outfilename, int threads)
 {
     std::vector<Header> headers;
 
@@ -1087,6 +1548,7 @@ PyFile::write(const char* outfilename)
         for (auto c : P.channels)
         {
             auto C = py::cast<PyChannel&>(c.second);
+            C.getPixels();
             auto pixelType = C.pixelType();
 
             int nrgba;
@@ -1124,7 +1586,13 @@ PyFile::write(const char* outfilename)
         headers.push_back (header);
     }
 
-    MultiPartOutputFile outfile(outfilename, headers.data(), headers.size());
+    std::unique_ptr<MultiPartOutputFile> outfilePtr;
+    {
+        py::gil_scoped_release release;
+        outfilePtr.reset(new MultiPartOutputFile(outfilename, headers.data(), headers.size(),
+                                                 false, resolveThreadCount(threads)));
+    }
+    MultiPartOutputFile& outfile = *outfilePtr;
 
     //
     // Write the channel data: add slices to the framebuffer and write.
@@ -1151,6 +1619,15 @@ PyFile::write(const char* outfilename)
             throw std::runtime_error("invalid type");
     }
 
+    //
+    // Closing the file writes the offset tables
+    //
+    
+    {
+        py::gil_scoped_release release;
+        outfilePtr.reset();
+    }
+
     filename = outfilename;
 }
 
@@ -2085,10 +2562,22 @@ PyPart::shape() const
     {
         auto C = py::cast<PyChannel&>(c.second);
 
-        if (C.pixels.ndim() < 2 ||  C.pixels.ndim() > 3)
-            throw std::invalid_argument("error: channel must have a 2D or 3D array");
+        V2i c_S;
+        if (C._source)
+        {
+            //
+            // Not decoded yet, so the shape comes from the file
+            //
+            
+            c_S = V2i(C._source->shape[0], C._source->shape[1]);
+        }
+        else
+        {
+            if (C.pixels.ndim() < 2 ||  C.pixels.ndim() > 3)
+                throw std::invalid_argument("error: channel must have a 2D or 3D array");
 
-        V2i c_S(C.pixels.shape(0), C.pixels.shape(1));
+            c_S = V2i(C.pixels.shape(0), C.pixels.shape(1));
+        }
             
         if (S == V2i(0, 0))
         {
@@ -2168,6 +2657,9 @@ PyPart::typeString() const
 PixelType
 PyChannel::pixelType() const
 {
+    if (_source)
+        return _source->type;
+
     auto buf = py::array::ensure(pixels);
     if (buf)
     {
@@ -2202,9 +2694,635 @@ PyChannel::pixelType() const
     return NUM_PIXELTYPES;
 }
 
-template <class T>
-std::string
-repr(const T& v)
+//
+// PyChunkReader
+//
+
+static py::dtype
+pixelTypeDtype(exr_pixel_type_t type)
+{
+    switch (type)
+    {
+      case EXR_PIXEL_UINT:
+          return py::dtype::of<uint32_t>();
+      case EXR_PIXEL_HALF:
+          return py::dtype::of<half>();
+      case EXR_PIXEL_FLOAT:
+          return py::dtype::of<float>();
+      default:
+          throw std::runtime_error("invalid pixel type");
+    }
+}
+
+//
+// Hand the contents of a vector over to a numpy array, without copying.
+//
+
+template <class T>
+static py::array
+releaseToArray(std::vector<T>& data, const py::dtype& dt, const std::vector<size_t>& shape)
+{
+    auto owner = new std::vector<T>(std::move(data));
+    py::capsule base(owner, [](void* p) { delete static_cast<std::vector<T>*>(p); });
+    return py::array(dt, shape, owner->data(), base);
+}
+
+//
+// The decoded data of a deep chunk: the sample count of each pixel, and
+// the samples of each channel read, concatenated in pixel order.
+//
+
+struct PyDeepChunkData
+{
+    exr_chunk_info_t                  cinfo;
+    std::vector<int32_t>              counts;
+    std::vector<std::vector<uint8_t>> samples;
+};
+
+struct PyDeepDecodeState
+{
+    PyDeepChunkData*        chunk;
+    const std::vector<int>* slots;
+};
+
+//
+// Called by the decode pipeline once the sample counts of a deep chunk
+// are known, to size the sample buffers and point the channels at them.
+//
+
+static exr_result_t
+reallocDeepSamples(exr_decode_pipeline_t* decode)
+{
+    auto state = static_cast<PyDeepDecodeState*>(decode->decoding_user_data);
+    PyDeepChunkData& D = *state->chunk;
+
+    size_t npixels = static_cast<size_t>(decode->chunk.width) * static_cast<size_t>(decode->chunk.height);
+    size_t total = static_cast<size_t>(decode->sample_count_table[npixels]);
+
+    try
+    {
+        D.counts.assign(decode->sample_count_table, decode->sample_count_table + npixels);
+
+        for (int c = 0; c < decode->channel_count; c++)
+        {
+            exr_coding_channel_info_t& decc = decode->channels[c];
+            int slot = (*state->slots)[c];
+            if (slot < 0 || total == 0)
+            {
+                decc.decode_to_ptr = nullptr;
+                continue;
+            }
+
+            D.samples[slot].resize(total * decc.bytes_per_element);
+            decc.user_bytes_per_element = decc.bytes_per_element;
+            decc.user_data_type = decc.data_type;
+            decc.user_pixel_stride = decc.bytes_per_element;
+            decc.user_line_stride = 0;
+            decc.decode_to_ptr = D.samples[slot].data();
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        return EXR_ERR_OUT_OF_MEMORY;
+    }
+
+    return EXR_ERR_SUCCESS;
+}
+
+//
+// Decode the deep chunks [begin, begin + chunks.size()), on up to
+// 'threads' threads, each with its own decode pipeline.
+//
+
+static exr_result_t
+decodeDeepChunks(exr_const_context_t ctxt, int part_index, bool tiled,
+                 int count_x, int lines_per_chunk, int origin_y, const V2i& level,
+                 int begin, std::vector<PyDeepChunkData>& chunks,
+                 const std::vector<int>& slots, size_t num_slots, int threads)
+{
+    std::atomic<int>          next (0);
+    std::atomic<exr_result_t> status (EXR_ERR_SUCCESS);
+    
+    auto worker = [&]()
+    {
+        exr_decode_pipeline_t decode = EXR_DECODE_PIPELINE_INITIALIZER;
+        bool                  initialized = false;
+        PyDeepDecodeState     state;
+
+        state.slots = &slots;
+        
+        while (status.load() == EXR_ERR_SUCCESS)
+        {
+            int i = next++;
+            if (i >= static_cast<int>(chunks.size()))
+                break;
+            
+            PyDeepChunkData& D = chunks[i];
+            D.samples.resize(num_slots);
+            state.chunk = &D;
+
+            int          chunk = begin + i;
+            exr_result_t rv;
+            if (tiled)
+                rv = exr_read_tile_chunk_info(ctxt, part_index,
+                                              chunk % count_x, chunk / count_x,
+                                              level.x, level.y, &D.cinfo);
+            else
+                rv = exr_read_scanline_chunk_info(ctxt, part_index,
+                                                  origin_y + chunk * lines_per_chunk,
+                                                  &D.cinfo);
+
+            if (rv == EXR_ERR_SUCCESS)
+            {
+                if (!initialized)
+                {
+                    initialized = true;
+                    rv = exr_decoding_initialize(ctxt, part_index, &D.cinfo, &decode);
+                    if (rv == EXR_ERR_SUCCESS)
+                    {
+                        decode.decode_flags |= EXR_DECODE_SAMPLE_COUNTS_AS_INDIVIDUAL;
+                        decode.decoding_user_data = &state;
+                        decode.realloc_nonimage_data_fn = &reallocDeepSamples;
+                        rv = exr_decoding_choose_default_routines(ctxt, part_index, &decode);
+                    }
+                }
+                else
+                    rv = exr_decoding_update(ctxt, part_index, &D.cinfo, &decode);
+            }
+
+            if (rv == EXR_ERR_SUCCESS)
+                rv = exr_decoding_run(ctxt, part_index, &decode);
+
+            if (rv != EXR_ERR_SUCCESS)
+            {
+                exr_result_t expected = EXR_ERR_SUCCESS;
+                status.compare_exchange_strong(expected, rv);
+            }
+        }
+
+        if (initialized)
+            exr_decoding_destroy(ctxt, &decode);
+    };
+
+    int nthreads = std::min(std::max(threads, 1), static_cast<int>(chunks.size()));
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < nthreads; t++)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& w : workers)
+        w.join();
+    
+    return status.load();
+}
+
+//
+// A batch of consecutive chunks, decoded together. Flat chunks are
+// decoded into one array per channel covering the batch, which the
+// chunks are views of; deep chunks each have their own buffers.
+//
+
+struct PyChunkReader::Batch
+{
+    int                                      begin = 0;
+    int                                      end = 0;
+    Box2i                                    region;
+    std::vector<py::array>                   arrays;
+    std::vector<exr_decode_channel_buffer_t> buffers;
+    exr_decode_part_parallel_options_t       options;
+    std::vector<PyDeepChunkData>             deep;
+    std::future<exr_result_t>                result;
+};
+
+PyChunkReader::PyChunkReader(const std::string& filename, int part_index,
+                             const py::object& channel_names, const py::object& tile_level,
+                             int threads, int prefetch)
+    : filename(filename), part_index(part_index), storage(EXR_STORAGE_LAST_TYPE),
+      level(0, 0), chunk_count(0), _ctxt(nullptr),
+      _threads(std::max(resolveThreadCount(threads), 1)), _prefetch(std::max(prefetch, 0)),
+      _batch_size(1), _lines_per_chunk(1), _count_x(1), _tile_size(0, 0), _level_size(0, 0),
+      _next_chunk(0), _next_batch(0)
+{
+    exr_context_initializer_t init = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    init.error_handler_fn = &PyChunkReader::errorHandler;
+    init.user_data = this;
+
+    exr_result_t rv;
+    {
+        py::gil_scoped_release release;
+        rv = exr_start_read(&_ctxt, filename.c_str(), &init);
+    }
+    if (rv != EXR_ERR_SUCCESS)
+    {
+        std::string err = errorMessage(rv);
+        exr_finish(&_ctxt);
+        throw std::runtime_error(err);
+    }
+
+    try
+    {
+        int nparts = 0;
+        exr_get_count(_ctxt, &nparts);
+        if (part_index < 0 || part_index >= nparts)
+        {
+            std::stringstream err;
+            err << "invalid part index " << part_index << ", file has " << nparts << " parts";
+            throw std::invalid_argument(err.str());
+        }
+
+        exr_attr_box2i_t box;
+        exr_get_storage(_ctxt, part_index, &storage);
+        exr_get_data_window(_ctxt, part_index, &box);
+        dw = Box2i(V2i(box.min.x, box.min.y), V2i(box.max.x, box.max.y));
+
+        if (!tile_level.is_none() && !objectToV2i(tile_level, level))
+            throw std::invalid_argument("level must be a tuple (lx, ly)");
+
+        if (isTiled())
+        {
+            int32_t  levels_x, levels_y, count_y;
+            uint32_t tile_w, tile_h;
+            
+            exr_get_tile_levels(_ctxt, part_index, &levels_x, &levels_y);
+            if (level.x < 0 || level.y < 0 || level.x >= levels_x || level.y >= levels_y)
+            {
+                std::stringstream err;
+                err << "invalid level " << level << ", part has "
+                    << levels_x << "x" << levels_y << " levels";
+                throw std::invalid_argument(err.str());
+            }
+            
+            exr_get_tile_descriptor(_ctxt, part_index, &tile_w, &tile_h, nullptr, nullptr);
+            exr_get_tile_counts(_ctxt, part_index, level.x, level.y, &_count_x, &count_y);
+            exr_get_level_sizes(_ctxt, part_index, level.x, level.y, &_level_size.x, &_level_size.y);
+            
+            _tile_size = V2i(tile_w, tile_h);
+            chunk_count = _count_x * count_y;
+            _batch_size = _threads;
+        }
+        else
+        {
+            if (level != V2i(0, 0))
+                throw std::invalid_argument("level is only valid for tiled parts");
+
+            exr_get_scanlines_per_chunk(_ctxt, part_index, &_lines_per_chunk);
+
+            _level_size = V2i(dw.max.x - dw.min.x + 1, dw.max.y - dw.min.y + 1);
+            chunk_count = (_level_size.y + _lines_per_chunk - 1) / _lines_per_chunk;
+
+            //
+            // Small chunks are batched so that each thread decodes a
+            // reasonable number of scanlines at a time.
+            //
+            
+            _batch_size = _threads * std::max(16 / _lines_per_chunk, 1);
+        }
+
+        //
+        // The channels to read, either all of them, or the selection
+        //
+        
+        std::vector<std::string> selection;
+        if (py::isinstance<py::str>(channel_names))
+            selection.push_back(channel_names.cast<std::string>());
+        else if (!channel_names.is_none())
+        {
+            for (auto n : channel_names)
+                selection.push_back(n.cast<std::string>());
+        }
+        std::vector<bool> matched(selection.size(), false);
+        
+        const exr_attr_chlist_t* chlist = nullptr;
+        exr_get_channels(_ctxt, part_index, &chlist);
+
+        _slots.assign(chlist->num_channels, -1);
+        for (int c = 0; c < chlist->num_channels; c++)
+        {
+            const exr_attr_chlist_entry_t& e = chlist->entries[c];
+            std::string name (e.name.str, e.name.length);
+            
+            if (!channel_names.is_none() && !isSelectedChannel(selection, name, matched))
+                continue;
+
+            if (e.x_sampling != 1 || e.y_sampling != 1)
+            {
+                std::stringstream err;
+                err << "subsampled channel '" << name << "' is not supported";
+                throw std::invalid_argument(err.str());
+            }
+            
+            _slots[c] = static_cast<int>(_channels.size());
+            _channels.push_back({name, c, e.pixel_type});
+        }
+
+        for (size_t i = 0; i < selection.size(); i++)
+            if (!matched[i])
+            {
+                std::stringstream err;
+                err << "no channel or layer named '" << selection[i] << "' in file '" << filename << "'";
+                throw std::invalid_argument(err.str());
+            }
+    }
+    catch (...)
+    {
+        exr_finish(&_ctxt);
+        throw;
+    }
+}
+
+PyChunkReader::~PyChunkReader()
+{
+    close();
+}
+
+py::object
+PyChunkReader::__enter__()
+{
+    return py::cast(this);
+}
+
+void
+PyChunkReader::__exit__(py::args args)
+{
+    close();
+}
+
+//
+// Wait for the batches being decoded in the background, then close the
+// file.
+//
+
+void
+PyChunkReader::close()
+{
+    wait();
+    
+    _current.reset();
+    _pending.clear();
+
+    if (_ctxt)
+        exr_finish(&_ctxt);
+}
+
+void
+PyChunkReader::wait()
+{
+    py::gil_scoped_release release;
+
+    for (auto& B : _pending)
+        if (B->result.valid() &&
+            B->result.wait_for(std::chrono::seconds(0)) != std::future_status::deferred)
+            B->result.wait();
+}
+
+bool
+PyChunkReader::isDeep() const
+{
+    return storage == EXR_STORAGE_DEEP_SCANLINE || storage == EXR_STORAGE_DEEP_TILED;
+}
+
+bool
+PyChunkReader::isTiled() const
+{
+    return storage == EXR_STORAGE_TILED || storage == EXR_STORAGE_DEEP_TILED;
+}
+
+std::vector<std::string>
+PyChunkReader::channel_names() const
+{
+    std::vector<std::string> names;
+    for (auto& C : _channels)
+        names.push_back(C.name);
+    return names;
+}
+
+//
+// The pixels covered by a chunk: for tiles, in the coordinates of the
+// level, offset by the data window origin.
+//
+
+Box2i
+PyChunkReader::chunkRegion(int chunk) const
+{
+    if (isTiled())
+    {
+        V2i min (dw.min.x + (chunk % _count_x) * _tile_size.x,
+                 dw.min.y + (chunk / _count_x) * _tile_size.y);
+        V2i max (std::min(min.x + _tile_size.x, dw.min.x + _level_size.x) - 1,
+                 std::min(min.y + _tile_size.y, dw.min.y + _level_size.y) - 1);
+        return Box2i(min, max);
+    }
+
+    int y = dw.min.y + chunk * _lines_per_chunk;
+    return Box2i(V2i(dw.min.x, y),
+                 V2i(dw.max.x, std::min(y + _lines_per_chunk - 1, dw.max.y)));
+}
+
+//
+// Start decoding the next batch of chunks, in the background if
+// prefetching, otherwise when it's first waited on.
+//
+
+void
+PyChunkReader::scheduleBatch()
+{
+    std::unique_ptr<Batch> B (new Batch);
+    
+    B->begin = _next_batch;
+    B->end = std::min(_next_batch + _batch_size, chunk_count);
+    if (isTiled())
+    {
+        //
+        // A batch doesn't span rows of tiles, so it covers a rectangle.
+        //
+        
+        B->end = std::min(B->end, (B->begin / _count_x + 1) * _count_x);
+    }
+    _next_batch = B->end;
+
+    B->region = Box2i(chunkRegion(B->begin).min, chunkRegion(B->end - 1).max);
+
+    Batch*              batch = B.get();
+    exr_const_context_t ctxt = _ctxt;
+    int                 part = part_index;
+    auto                launch = _prefetch > 0 ? std::launch::async : std::launch::deferred;
+
+    if (isDeep())
+    {
+        B->deep.resize(B->end - B->begin);
+
+        bool tiled = isTiled();
+        int  count_x = _count_x;
+        int  lines_per_chunk = _lines_per_chunk;
+        int  origin_y = dw.min.y;
+        V2i  lvl = level;
+        int  threads = _threads;
+        const std::vector<int>* slots = &_slots;
+        size_t num_slots = _channels.size();
+
+        B->result = std::async(launch, [=]() {
+            return decodeDeepChunks(ctxt, part, tiled, count_x, lines_per_chunk, origin_y, lvl,
+                                    batch->begin, batch->deep, *slots, num_slots, threads);
+        });
+    }
+    else
+    {
+        //
+        // Allocate the arrays now, while we hold the GIL, and offset
+        // the buffer pointers so they address the part (or level) origin,
+        // which is where the decoder positions chunks from.
+        //
+        
+        size_t  width = B->region.max.x - B->region.min.x + 1;
+        size_t  height = B->region.max.y - B->region.min.y + 1;
+        int64_t dx = B->region.min.x - dw.min.x;
+        int64_t dy = B->region.min.y - dw.min.y;
+        
+        for (auto& C : _channels)
+        {
+            py::dtype dt = pixelTypeDtype(C.type);
+            py::array a (dt, std::vector<size_t>({height, width}));
+            
+            exr_decode_channel_buffer_t buf;
+            buf.channel_name = C.name.c_str();
+            buf.pixel_stride = static_cast<int32_t>(dt.itemsize());
+            buf.line_stride = static_cast<int32_t>(dt.itemsize() * width);
+            buf.user_bytes_per_element = static_cast<int16_t>(dt.itemsize());
+            buf.user_data_type = static_cast<uint16_t>(C.type);
+            buf.base = static_cast<uint8_t*>(a.mutable_data()) -
+                       (dy * buf.line_stride + dx * buf.pixel_stride);
+            
+            B->arrays.push_back(a);
+            B->buffers.push_back(buf);
+        }
+
+        exr_decode_part_parallel_options_t options = EXR_DECODE_PART_PARALLEL_OPTIONS_INITIALIZER;
+        options.channels = B->buffers.data();
+        options.num_channels = static_cast<int>(B->buffers.size());
+        options.level_x = level.x;
+        options.level_y = level.y;
+        options.chunk_begin = B->begin;
+        options.chunk_end = B->end;
+        options.num_threads = _threads;
+        B->options = options;
+
+        B->result = std::async(launch, [=]() {
+            return exr_decode_part_parallel(ctxt, part, &batch->options);
+        });
+    }
+
+    _pending.push_back(std::move(B));
+}
+
+//
+// Return the next chunk, waiting for its batch to be decoded, and
+// keeping 'prefetch' batches decoding ahead of it.
+//
+
+PyChunk
+PyChunkReader::next()
+{
+    if (!_ctxt)
+        throw std::invalid_argument("I/O operation on closed ChunkReader");
+    
+    if (_next_chunk >= chunk_count)
+        throw py::stop_iteration();
+
+    if (!_current || _next_chunk >= _current->end)
+    {
+        _current.reset();
+        
+        if (_pending.empty())
+            scheduleBatch();
+        _current = std::move(_pending.front());
+        _pending.pop_front();
+
+        while (static_cast<int>(_pending.size()) < _prefetch && _next_batch < chunk_count)
+            scheduleBatch();
+
+        exr_result_t rv;
+        {
+            py::gil_scoped_release release;
+            rv = _current->result.get();
+        }
+        
+        if (rv != EXR_ERR_SUCCESS)
+        {
+            std::string err = errorMessage(rv);
+            close();
+            throw std::runtime_error(err);
+        }
+    }
+
+    Batch& B = *_current;
+    Box2i  r = chunkRegion(_next_chunk);
+    
+    PyChunk C;
+    C.index = _next_chunk;
+    C.x = r.min.x;
+    C.y = r.min.y;
+    C.width = r.max.x - r.min.x + 1;
+    C.height = r.max.y - r.min.y + 1;
+    C.level = level;
+
+    if (isDeep())
+    {
+        PyDeepChunkData& D = B.deep[_next_chunk - B.begin];
+
+        std::vector<size_t> shape ({static_cast<size_t>(D.cinfo.height), static_cast<size_t>(D.cinfo.width)});
+        if (D.counts.empty())
+            D.counts.assign(shape[0] * shape[1], 0);
+        C.sample_counts = releaseToArray(D.counts, py::dtype::of<uint32_t>(), shape);
+        
+        for (size_t s = 0; s < _channels.size(); s++)
+        {
+            py::dtype dt = pixelTypeDtype(_channels[s].type);
+            size_t    nsamples = D.samples[s].size() / dt.itemsize();
+            C.channels[py::str(_channels[s].name)] = releaseToArray(D.samples[s], dt, {nsamples});
+        }
+    }
+    else
+    {
+        auto rows = py::slice(r.min.y - B.region.min.y, r.max.y - B.region.min.y + 1, 1);
+        auto cols = py::slice(r.min.x - B.region.min.x, r.max.x - B.region.min.x + 1, 1);
+        auto index = py::make_tuple(rows, cols);
+        
+        for (size_t c = 0; c < _channels.size(); c++)
+            C.channels[py::str(_channels[c].name)] = py::object(B.arrays[c][index]);
+    }
+    
+    _next_chunk++;
+    
+    return C;
+}
+
+void
+PyChunkReader::errorHandler(exr_const_context_t ctxt, exr_result_t code, const char* msg)
+{
+    void* user_data = nullptr;
+    if (exr_get_user_data(ctxt, &user_data) != EXR_ERR_SUCCESS || !user_data)
+        return;
+
+    auto reader = static_cast<PyChunkReader*>(user_data);
+    std::lock_guard<std::mutex> lock (reader->_error_mutex);
+    if (reader->_error.empty())
+        reader->_error = msg ? msg : exr_get_default_error_message(code);
+}
+
+std::string
+PyChunkReader::errorMessage(exr_result_t rv)
+{
+    std::lock_guard<std::mutex> lock (_error_mutex);
+    
+    std::stringstream err;
+    err << "error reading '" << filename << "': "
+        << (_error.empty() ? exr_get_default_error_message(rv) : _error.c_str());
+    return err.str();
+}
+
+template <class T>
+std::string
+repr(const T& v)
 {
     std::stringstream s;
     s << v;
@@ -2230,6 +3348,19 @@ PYBIND11_MODULE(OpenEXR, m)
     
     init_OpenEXR_old(m.ptr());
 
+    //
+    // Threading
+    //
+
+    m.def("setGlobalThreadCount", &setGlobalThreadCount, py::arg("count"),
+          R"pbdoc(
+          Set the number of threads in the global thread pool used to encode and decode files which don't specify a thread count. 0 disables multithreading.
+          )pbdoc");
+    m.def("globalThreadCount", &globalThreadCount,
+          R"pbdoc(
+          Return the number of threads in the global thread pool.
+          )pbdoc");
+
     //
     // Enums
     //
@@ -2514,9 +3645,9 @@ PYBIND11_MODULE(OpenEXR, m)
              R"pbdoc(
              bool : The pLinear value, used for DWA compression.
              )pbdoc")
-        .def_readwrite("pixels", &PyChannel::pixels,
+        .def_property("pixels", &PyChannel::getPixels, &PyChannel::setPixels,
              R"pbdoc(
-             np.array : The channel pixel array.
+             np.array : The channel pixel array. For a file read with `lazy=True`, the pixels are decoded on first access.
              )pbdoc")
         .def_readonly("channel_index", &PyChannel::channel_index,
              R"pbdoc(
@@ -2621,13 +3752,21 @@ PYBIND11_MODULE(OpenEXR, m)
          >>> f.write("out.exr")
     )pbdoc")
         .def(py::init<>())
-        .def(py::init<std::string,bool,bool>(),
+        .def(py::init<std::string,bool,bool,int,py::object,py::object,py::object,bool>(),
              py::arg("filename"),
              py::arg("separate_channels")=false,
              py::arg("header_only")=false,
+             py::arg("threads")=-1,
+             py::arg("out")=py::none(),
+             py::arg("channels")=py::none(),
+             py::arg("data_window")=py::none(),
+             py::arg("lazy")=false,
              R"pbdoc(
              Initialize a File by reading the image from the given filename.
 
+             The GIL is released while the pixels are decoded, so reads of
+             separate files can proceed in parallel in multiple python threads.
+
              Parameters
              ----------
              filename : str
@@ -2637,10 +3776,23 @@ PYBIND11_MODULE(OpenEXR, m)
                  if False (default), read pixel data into a single "RGB" or "RGBA" numpy array of dimension (height,width,3) or (height,width,4);
              header_only : bool
                  If True, read only the header metadata, not the image pixel data.
+             threads : int
+                 The number of threads used to decode the file; 0 decodes on the calling thread. If negative (default), use the global thread count (see `setGlobalThreadCount`).
+             out : dict or list of dict
+                 Optional preallocated numpy arrays to decode into, keyed by channel name as they would appear in `channels()`, either a dict for the first part or a list of dicts, one per part. Each array must match the dtype and shape of the array that would otherwise be allocated, and be writeable and C-contiguous. Channels not in `out` are allocated as usual. Not supported for deep parts.
+             channels : str or list of str
+                 Optional names of the channels to read, or of layers, i.e. "left" reads "left.R", "left.G", etc. Other channels are not decoded, and do not appear in `channels()`. Raises `ValueError` if a name matches no channel.
+             data_window : tuple
+                 Optional region ((xmin,ymin),(xmax,ymax)) of the data window to read; only the scanlines or tiles that overlap it are decoded, and the arrays have the shape of the region. Not supported for deep parts or subsampled channels.
+             lazy : bool
+                 If True, don't decode a channel until its `pixels` are first accessed; the file stays open until then.
 
              Example
              -------  
              >>> f = OpenEXR.File("image.exr", separate_channels=False, header_only=False)
+             >>> RGBA = np.empty((height, width, 4), dtype='e')
+             >>> f = OpenEXR.File("image.exr", threads=4, out={"RGBA" : RGBA})
+             >>> f = OpenEXR.File("image.exr", channels=["Z"], data_window=((0,0),(63,63)))
              )pbdoc")
         .def(py::init<py::dict,py::dict>(),
              py::arg("header"),
@@ -2737,18 +3889,139 @@ PYBIND11_MODULE(OpenEXR, m)
              {'A': Channel("A", xSampling=1, ySampling=1), 'B': Channel("B", xSampling=1, ySampling=1), 'G': Channel("G", xSampling=1, ySampling=1), 'R': Channel("R", xSampling=1, ySampling=1)}
              )pbdoc")
         .def("write", &PyFile::write,
+             py::arg("filename"),
+             py::arg("threads")=-1,
              R"pbdoc(
              Write the File to the give file name.
 
+             The GIL is released while the pixels are encoded.
+
              Parameters
              ----------
              filename : str
                  The output path name.
+             threads : int
+                 The number of threads used to encode the file; 0 encodes on the calling thread. If negative (default), use the global thread count (see `setGlobalThreadCount`).
 
              Example
              -------
              >>> f = OpenEXR.File("image.exr")
              >>> f.write("out.exr"))pbdoc")
         ;
+
+    py::class_<PyChunk>(m, "Chunk", R"pbdoc(
+         A block of scanlines or a tile of an image part, as returned by a ChunkReader.
+    )pbdoc")
+        .def_readonly("index", &PyChunk::index,
+             R"pbdoc(
+             int : The index of the chunk in the part, or in the level for tiled parts.
+             )pbdoc")
+        .def_readonly("x", &PyChunk::x,
+             R"pbdoc(
+             int : The x coordinate of the upper left pixel of the chunk.
+             )pbdoc")
+        .def_readonly("y", &PyChunk::y,
+             R"pbdoc(
+             int : The y coordinate of the upper left pixel of the chunk.
+             )pbdoc")
+        .def_readonly("width", &PyChunk::width,
+             R"pbdoc(
+             int : The width of the chunk, in pixels.
+             )pbdoc")
+        .def_readonly("height", &PyChunk::height,
+             R"pbdoc(
+             int : The height of the chunk, in pixels.
+             )pbdoc")
+        .def_property_readonly("level", [](const PyChunk& c) { return py::make_tuple(c.level.x, c.level.y); },
+             R"pbdoc(
+             tuple : The (x, y) level of a tile; (0, 0) for scanline parts.
+             )pbdoc")
+        .def_readonly("channels", &PyChunk::channels,
+             R"pbdoc(
+             dict : The pixels of each channel read, keyed by channel name. For flat parts, a 2D numpy array of shape (height, width), a view of the batch of chunks decoded with it. For deep parts, a 1D numpy array of all the samples of the chunk, in pixel order.
+             )pbdoc")
+        .def_readonly("sample_counts", &PyChunk::sample_counts,
+             R"pbdoc(
+             np.array : For deep parts, the number of samples of each pixel, of shape (height, width); None for flat parts.
+             )pbdoc")
+        .def("__repr__", [](const PyChunk& c) {
+            std::stringstream s;
+            s << "Chunk(" << c.index << ", x=" << c.x << ", y=" << c.y
+              << ", width=" << c.width << ", height=" << c.height << ")";
+            return s.str();
+        })
+        ;
+    
+    py::class_<PyChunkReader>(m, "ChunkReader", R"pbdoc(
+         Iterate over the chunks (scanline blocks or tiles) of an image part.
+
+         Chunks are decoded in batches on a number of threads, and the
+         following batches are decoded in the background while the
+         current one is processed, so only the batches in flight are
+         held in memory, regardless of the size of the image.
+
+         Example
+         -------
+         >>> with OpenEXR.ChunkReader("image.exr", channels=["Z"], threads=4) as reader:
+         ...     for chunk in reader:
+         ...         zmax = max(zmax, chunk.channels["Z"].max())
+    )pbdoc")
+        .def(py::init<std::string,int,py::object,py::object,int,int>(),
+             py::arg("filename"),
+             py::arg("part")=0,
+             py::arg("channels")=py::none(),
+             py::arg("level")=py::none(),
+             py::arg("threads")=-1,
+             py::arg("prefetch")=1,
+             R"pbdoc(
+             Open the given part of a file for reading chunk by chunk.
+
+             Parameters
+             ----------
+             filename : str
+                 The path to the image file on disk.
+             part : int
+                 The index of the part to read.
+             channels : str or list of str
+                 Optional names of the channels to read, or of layers, i.e. "left" reads "left.R", "left.G", etc. Other channels are not decoded. Subsampled channels are not supported.
+             level : tuple
+                 For tiled parts, the (x, y) level to read; (0, 0) by default.
+             threads : int
+                 The number of chunks decoded concurrently. If negative (default), use the global thread count (see `setGlobalThreadCount`).
+             prefetch : int
+                 The number of batches of chunks decoded in the background ahead of the current one; 0 decodes each batch on demand.
+             )pbdoc")
+        .def("__enter__", &PyChunkReader::__enter__)
+        .def("__exit__", &PyChunkReader::__exit__)
+        .def("__iter__", [](py::object self) { return self; })
+        .def("__next__", &PyChunkReader::next)
+        .def("__len__", [](const PyChunkReader& r) { return r.chunk_count; })
+        .def("close", &PyChunkReader::close,
+             R"pbdoc(
+             Stop decoding and close the file.
+             )pbdoc")
+        .def_readonly("filename", &PyChunkReader::filename,
+             R"pbdoc(
+             str : The filename being read.
+             )pbdoc")
+        .def_readonly("part_index", &PyChunkReader::part_index,
+             R"pbdoc(
+             int : The index of the part being read.
+             )pbdoc")
+        .def("type", [](const PyChunkReader& r) { return r.storage; },
+             R"pbdoc(
+             OpenEXR.Storage : The storage type of the part.
+             )pbdoc")
+        .def("dataWindow", [](const PyChunkReader& r) {
+            return py::make_tuple(make_v2<int>(r.dw.min), make_v2<int>(r.dw.max));
+        },
+             R"pbdoc(
+             tuple : The data window of the part, ((xmin,ymin),(xmax,ymax)).
+             )pbdoc")
+        .def("channels", &PyChunkReader::channel_names,
+             R"pbdoc(
+             list : The names of the channels being read.
+             )pbdoc")
+        ;
 }
 
@@ -13,12 +13,29 @@ typedef std::map<std::string,std::unique_ptr<Array2DVoidPtr>> SliceDataMap;
 
 class PyPart;
 class PyChannel;
+struct PyPixelSource;
+
+//
+// PyInputFile is an input file shared by the channels read from it,
+// which keeps it open until the last lazily-read channel is decoded.
+//
+
+struct PyInputFile
+{
+    PyInputFile(const char* filename, int threads) : file(filename, threads) {}
+
+    MultiPartInputFile file;
+    std::mutex         mutex;
+};
 
 class PyFile 
 {
 public:
     PyFile() {}
-    PyFile(const std::string& filename, bool separate_channels = false, bool header_only = false);
+    PyFile(const std::string& filename, bool separate_channels = false, bool header_only = false,
+           int threads = -1, const py::object& out = py::none(),
+           const py::object& channel_names = py::none(),
+           const py::object& data_window = py::none(), bool lazy = false);
     PyFile(const py::dict& header, const py::dict& channels);
     PyFile(const py::list& parts);
 
@@ -28,7 +45,7 @@ public:
     py::dict&    header(int part_index = 0);
     py::dict&    channels(int part_index = 0);
 
-    void         write(const char* filename);
+    void         write(const char* filename, int threads = -1);
     
     std::string  filename;
     py::list     parts;
@@ -78,9 +95,10 @@ class PyPart
                                     std::map<std::string,PyChannel*>& rgbaChannelMap,
                                     const Array2D<unsigned int>& sampleCount);
 
-    void           readPixels(MultiPartInputFile& infile, const ChannelList& channel_list,
+    void           readPixels(const std::shared_ptr<PyInputFile>& infile, const ChannelList& channel_list,
                               const std::vector<size_t>& shape, const std::set<std::string>& rgbaChannels,
-                              const Box2i& dw, bool separate_channels);
+                              const Box2i& dw, const Box2i& window, bool separate_channels,
+                              const py::dict& out, bool lazy);
     void           readDeepPixels(MultiPartInputFile& infile, const std::string& type, const ChannelList& channel_list,
                                   const std::vector<size_t>& shape, const std::set<std::string>& rgbaChannels,
                                   const Box2i& dw, bool separate_channels);
@@ -89,9 +107,31 @@ class PyPart
     
 };
 
+//
+// PyPixelSource describes where the pixels of a PyChannel come from in
+// an input file, until they are decoded: the part, the region, and the
+// file channels interleaved into the array, with their offsets.
+//
+
+struct PyPixelSource
+{
+    std::shared_ptr<PyInputFile> file;
+    int                          part_index = 0;
+    Box2i                        dw;
+    Box2i                        window;
+    PixelType                    type = NUM_PIXELTYPES;
+    std::vector<size_t>          shape;
+    int                          xSampling = 1;
+    int                          ySampling = 1;
+    std::vector<std::pair<std::string,int>> channels;
+    py::object                   pixels;
+    std::atomic<bool>            decoded {false}; // set under file->mutex
+};
+
 //
 // PyChannel holds information for a channel of a PyPart: name, type, x/y
-// sampling, and the array of pixel data.
+// sampling, and the array of pixel data. A channel read lazily holds
+// the source of its pixels until they're first accessed.
 //
   
 class PyChannel 
@@ -126,14 +166,18 @@ public:
           _type(NUM_PIXELTYPES), _nrgba(0) { validatePixelArray(); }
 
     PixelType             pixelType() const;
+    const py::array&      getPixels() const;
+    void                  setPixels(const py::array& p);
 
     std::string           name;
     int                   xSampling;
     int                   ySampling;
     int                   pLinear;
-    py::array             pixels;
+    mutable py::array     pixels;
     size_t                channel_index;
 
+    mutable std::shared_ptr<PyPixelSource> _source;
+
     mutable PixelType      _type;
     mutable int            _nrgba;
 
@@ -149,7 +193,100 @@ public:
                                            Array2D<unsigned int>& sampleCount,
                                            std::vector<std::shared_ptr<Array2DVoidPtr>>& slice_datas) const;
 };
-    
+
+//
+// PyChunk is a block of scanlines or a tile yielded by PyChunkReader:
+// its position in the data window (or level, for tiles) and the pixels
+// of the channels read. For deep parts, each channel is a 1D array of
+// all the samples of the chunk, in pixel order, with sample_counts
+// giving the number of samples per pixel.
+//
+
+class PyChunk
+{
+  public:
+    int          index = 0;
+    int          x = 0;
+    int          y = 0;
+    int          width = 0;
+    int          height = 0;
+    V2i          level = V2i(0, 0);
+    py::dict     channels;
+    py::object   sample_counts = py::none();
+};
+
+//
+// PyChunkReader iterates over the chunks of a part through OpenEXRCore,
+// decoding batches of chunks on a number of threads, and optionally
+// decoding the following batches in the background while the caller
+// processes the current one. Only the batches in flight are held in
+// memory, so files of any size can be processed chunk by chunk.
+//
+
+class PyChunkReader
+{
+  public:
+    PyChunkReader(const std::string& filename, int part_index = 0,
+                  const py::object& channel_names = py::none(),
+                  const py::object& tile_level = py::none(),
+                  int threads = -1, int prefetch = 1);
+    ~PyChunkReader();
+
+    py::object    __enter__();
+    void          __exit__(py::args args);
+    void          close();
+
+    PyChunk       next();
+
+    std::string   filename;
+    int           part_index;
+    exr_storage_t storage;
+    Box2i         dw;
+    V2i           level;
+    int           chunk_count;
+    std::vector<std::string> channel_names() const;
+
+    struct Channel
+    {
+        std::string      name;
+        int              file_index;
+        exr_pixel_type_t type;
+    };
+
+    struct Batch;
+
+  protected:
+
+    exr_context_t _ctxt;
+    std::mutex    _error_mutex;
+    std::string   _error;
+
+    int           _threads;
+    int           _prefetch;
+    int           _batch_size;
+    int           _lines_per_chunk;
+    int           _count_x;
+    V2i           _tile_size;
+    V2i           _level_size;
+
+    std::vector<Channel> _channels;
+    std::vector<int>     _slots;
+
+    std::unique_ptr<Batch>             _current;
+    std::deque<std::unique_ptr<Batch>> _pending;
+    int                                _next_chunk;
+    int                                _next_batch;
+
+    bool          isDeep() const;
+    bool          isTiled() const;
+    void          scheduleBatch();
+    Box2i         chunkRegion(int chunk) const;
+    void          wait();
+    std::string   errorMessage(exr_result_t rv);
+
+    static void   errorHandler(exr_const_context_t ctxt, exr_result_t code, const char* msg);
+};
+
 class PyPreviewImage
 {
 public:
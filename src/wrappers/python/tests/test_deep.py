@@ -217,6 +217,60 @@ class TestDeep(unittest.TestCase):
 
                 compare_files(infile, outfile)
 
+    def test_deep_chunks(self):
+
+        dataWindow = ((100,100), (120,130))
+        height = dataWindow[1][1] - dataWindow[0][1] + 1
+        width = dataWindow[1][0] - dataWindow[0][0] + 1
+        
+        Z = np.empty((height, width), dtype=object)
+        A = np.empty((height, width), dtype=object)
+        for y in range(height):
+            for x in range(width):
+                i = (y*width+x) % 5
+                if i > 0:
+                    Z[y, x] = np.array([j*2 for j in range(y,y+i)], dtype='float32')
+                    A[y, x] = np.array([j for j in range(i)], dtype='float16')
+                else:
+                    Z[y, x] = None
+                    A[y, x] = None
+        
+        channels = { "Z" : Z, "A" : A }
+
+        for storage, tiles in [(OpenEXR.deepscanline, None), (OpenEXR.deeptile, OpenEXR.TileDescription())]:
+
+            header = { "compression" : OpenEXR.ZIP_COMPRESSION,
+                       "type" : storage,
+                       "dataWindow" : dataWindow}
+            if tiles:
+                header["tiles"] = tiles
+
+            filename = "test_deep_chunks.exr"
+            with OpenEXR.File(header, channels) as outfile:
+                outfile.write(filename)
+
+            for threads, prefetch in [(0, 0), (3, 2)]:
+
+                count = 0
+                with OpenEXR.ChunkReader(filename, channels="Z", threads=threads, prefetch=prefetch) as reader:
+                    self.assertEqual(reader.channels(), ["Z"])
+                    for chunk in reader:
+                        self.assertEqual(chunk.sample_counts.shape, (chunk.height, chunk.width))
+                        samples = chunk.channels["Z"]
+                        self.assertEqual(samples.shape[0], chunk.sample_counts.sum())
+                        s = 0
+                        for y in range(chunk.height):
+                            for x in range(chunk.width):
+                                n = chunk.sample_counts[y, x]
+                                expected = Z[chunk.y - dataWindow[0][1] + y, chunk.x - dataWindow[0][0] + x]
+                                if expected is None:
+                                    self.assertEqual(n, 0)
+                                else:
+                                    self.assertEqual(samples[s:s+n].tolist(), expected.tolist())
+                                s += n
+                                count += 1
+                self.assertEqual(count, width * height)
+
 if __name__ == '__main__':
     unittest.main()
     print("OK")
@@ -564,5 +564,185 @@ class TestUnittest(unittest.TestCase):
             with OpenEXR.File(outfilename, separate_channels=True) as i:
                 compare_files (i, outfile2)
 
+    def test_threads_and_out(self):
+
+        width = 64
+        height = 48
+        size = width * height
+        RGB = np.array([i for i in range(0,size*3)], dtype='f').reshape((height, width, 3))
+        Z = np.array([i*2 for i in range(0,size)], dtype='uint32').reshape((height, width))
+        channels = { "RGB" : RGB, "Z" : Z }
+        header = { "compression" : OpenEXR.ZIP_COMPRESSION }
+
+        OpenEXR.setGlobalThreadCount(2)
+        self.assertEqual(OpenEXR.globalThreadCount(), 2)
+
+        with OpenEXR.File(header, channels) as outfile:
+
+            outfilename = mktemp_outfilename()
+            outfile.write(outfilename, threads=3)
+
+            with OpenEXR.File(outfilename, threads=0) as infile:
+                compare_files(infile, outfile)
+
+            # decode into caller-provided arrays; channels not in out
+            # are allocated
+            RGB_out = np.zeros((height, width, 3), dtype='f')
+            with OpenEXR.File(outfilename, threads=2, out={"RGB" : RGB_out}) as infile:
+                self.assertTrue(np.array_equal(RGB_out, RGB))
+                self.assertTrue(np.shares_memory(infile.channels()["RGB"].pixels, RGB_out))
+                self.assertTrue(np.array_equal(infile.channels()["Z"].pixels, Z))
+
+            Z_out = np.zeros((height, width), dtype='uint32')
+            with OpenEXR.File(outfilename, separate_channels=True, out=[{"Z" : Z_out}]) as infile:
+                self.assertTrue(np.array_equal(Z_out, Z))
+
+            # mismatched out arrays are rejected
+            with self.assertRaises(ValueError):
+                OpenEXR.File(outfilename, out={"RGB" : np.zeros((height, width, 3), dtype='e')})
+            with self.assertRaises(ValueError):
+                OpenEXR.File(outfilename, out={"RGB" : np.zeros((height, width, 4), dtype='f')})
+            with self.assertRaises(ValueError):
+                OpenEXR.File(outfilename, out={"RGB" : np.zeros((height*2, width, 3), dtype='f')[::2]})
+            with self.assertRaises(ValueError):
+                OpenEXR.File(outfilename, out=[{}, {}])
+
+            # reads in concurrent python threads
+            from concurrent.futures import ThreadPoolExecutor
+            def read(i):
+                with OpenEXR.File(outfilename) as f:
+                    return np.array_equal(f.channels()["RGB"].pixels, RGB)
+            with ThreadPoolExecutor(max_workers=4) as executor:
+                self.assertTrue(all(executor.map(read, range(8))))
+
+        OpenEXR.setGlobalThreadCount(0)
+
+    def test_lazy_and_partial_reads(self):
+
+        width = 40
+        height = 150
+        size = width * height
+        RGB = np.array([i for i in range(0,size*3)], dtype='f').reshape((height, width, 3))
+        Z = np.array([i*2 for i in range(0,size)], dtype='uint32').reshape((height, width))
+        N = np.array([i % 100 for i in range(0,size*3)], dtype='e').reshape((height, width, 3))
+        channels = { "RGB" : RGB, "Z" : Z, "normal.R" : N[:,:,0].copy(),
+                     "normal.G" : N[:,:,1].copy(), "normal.B" : N[:,:,2].copy() }
+
+        for compression, tiled in [(OpenEXR.ZIP_COMPRESSION, False),
+                                   (OpenEXR.PIZ_COMPRESSION, True)]:
+
+            header = { "compression" : compression }
+            if tiled:
+                header["type"] = OpenEXR.tiledimage
+                header["tiles"] = OpenEXR.TileDescription()
+                header["tiles"].xSize = 16
+                header["tiles"].ySize = 8
+
+            outfilename = mktemp_outfilename()
+            with OpenEXR.File(header, channels) as outfile:
+                outfile.write(outfilename)
+
+            # lazy reads decode on first access
+            with OpenEXR.File(outfilename, lazy=True) as infile:
+                self.assertEqual(infile.parts[0].width(), width)
+                self.assertEqual(infile.channels()["Z"].type(), OpenEXR.UINT)
+                self.assertTrue(np.array_equal(infile.channels()["Z"].pixels, Z))
+                self.assertTrue(np.array_equal(infile.channels()["RGB"].pixels, RGB))
+                self.assertTrue(np.array_equal(infile.channels()["normal"].pixels, N))
+
+            # channel and layer selection
+            with OpenEXR.File(outfilename, channels=["Z", "normal"]) as infile:
+                self.assertEqual(set(infile.channels().keys()), {"Z", "normal"})
+                self.assertTrue(np.array_equal(infile.channels()["normal"].pixels, N))
+
+            with OpenEXR.File(outfilename, channels="G", separate_channels=True) as infile:
+                self.assertEqual(list(infile.channels().keys()), ["G"])
+                self.assertTrue(np.array_equal(infile.channels()["G"].pixels, RGB[:,:,1]))
+
+            with self.assertRaises(ValueError):
+                OpenEXR.File(outfilename, channels=["nonexistent"])
+
+            # a sub-region of the data window, spanning several bands
+            window = ((5,7),(22,139))
+            with OpenEXR.File(outfilename, data_window=window, lazy=True) as infile:
+                self.assertEqual(infile.parts[0].width(), 18)
+                self.assertEqual(infile.parts[0].height(), 133)
+                self.assertTrue(np.array_equal(infile.channels()["RGB"].pixels, RGB[7:140,5:23]))
+                self.assertTrue(np.array_equal(infile.channels()["Z"].pixels, Z[7:140,5:23]))
+                self.assertEqual(infile.header()["dataWindow"][0].tolist(), [5,7])
+
+            # concurrent first accesses of the channels of a lazy read
+            from concurrent.futures import ThreadPoolExecutor
+            expected = { "RGB" : RGB[7:140,5:23], "Z" : Z[7:140,5:23], "normal" : N[7:140,5:23] }
+            with OpenEXR.File(outfilename, data_window=window, lazy=True) as infile:
+                channels_in = infile.channels()
+                def read(name):
+                    return np.array_equal(channels_in[name].pixels, expected[name])
+                with ThreadPoolExecutor(max_workers=4) as executor:
+                    self.assertTrue(all(executor.map(read, list(expected.keys()) * 4)))
+
+            with self.assertRaises(ValueError):
+                OpenEXR.File(outfilename, data_window=((0,0),(width,height)))
+
+    def test_chunk_reader(self):
+
+        width = 70
+        height = 45
+        size = width * height
+        RGB = np.array([i for i in range(0,size*3)], dtype='f').reshape((height, width, 3))
+        Z = np.array([i*2 for i in range(0,size)], dtype='uint32').reshape((height, width))
+        channels = { "RGB" : RGB, "Z" : Z }
+
+        for compression, tiled in [(OpenEXR.ZIP_COMPRESSION, False),
+                                   (OpenEXR.NO_COMPRESSION, False),
+                                   (OpenEXR.PIZ_COMPRESSION, True)]:
+
+            header = { "compression" : compression,
+                       "dataWindow" : ((10,20), (10+width-1, 20+height-1)) }
+            if tiled:
+                header["type"] = OpenEXR.tiledimage
+                header["tiles"] = OpenEXR.TileDescription()
+                header["tiles"].xSize = 16
+                header["tiles"].ySize = 8
+
+            outfilename = mktemp_outfilename()
+            with OpenEXR.File(header, channels) as outfile:
+                outfile.write(outfilename)
+
+            for threads, prefetch in [(0, 0), (1, 1), (4, 3)]:
+
+                R = np.zeros((height, width), dtype='f')
+                Zin = np.zeros((height, width), dtype='uint32')
+                
+                with OpenEXR.ChunkReader(outfilename, channels=["R", "Z"],
+                                         threads=threads, prefetch=prefetch) as reader:
+                    self.assertEqual(reader.channels(), ["R", "Z"])
+                    self.assertEqual(reader.dataWindow()[0].tolist(), [10, 20])
+                    nchunks = 0
+                    for chunk in reader:
+                        y0 = chunk.y - 20
+                        x0 = chunk.x - 10
+                        self.assertEqual(chunk.channels["R"].shape, (chunk.height, chunk.width))
+                        self.assertIsNone(chunk.sample_counts)
+                        R[y0:y0+chunk.height, x0:x0+chunk.width] = chunk.channels["R"]
+                        Zin[y0:y0+chunk.height, x0:x0+chunk.width] = chunk.channels["Z"]
+                        nchunks += 1
+                    self.assertEqual(nchunks, len(reader))
+
+                self.assertTrue(np.array_equal(R, RGB[:,:,0]))
+                self.assertTrue(np.array_equal(Zin, Z))
+
+            # stopping early and closing is fine
+            reader = OpenEXR.ChunkReader(outfilename, prefetch=4)
+            chunk = next(reader)
+            reader.close()
+            with self.assertRaises(ValueError):
+                next(reader)
+
+            with self.assertRaises(ValueError):
+                OpenEXR.ChunkReader(outfilename, channels=["nonexistent"])
+            with self.assertRaises(ValueError):
+                OpenEXR.ChunkReader(outfilename, part=1)
+
 if __name__ == '__main__':
     unittest.main()
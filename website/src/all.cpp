@@ -6,6 +6,7 @@
 #include <ImfHeader.h>
 #include <ImfArray.h>
 #include <ImfInputFile.h>
+#include <ImfMultiPartInputFile.h>
 #include <ImfFrameBuffer.h>
 #include <ImfOutputFile.h>
 #include <ImfPreviewImage.h>
@@ -38,3 +38,23 @@ readComments (const char fileName[], const StringAttribute *&comments)
     comments = file.header().findTypedAttribute <StringAttribute> ("comments");
 }
 // [end readCommentsError]
+
+// [begin readHeaderView]
+void
+readHeaderView (const char fileName[])
+{
+    MultiPartInputFile file (fileName);
+
+    for (int p = 0; p < file.parts (); ++p)
+    {
+        HeaderView view = file.headerView (p);
+
+        const char* name = view.name ();
+        Box2i       dw   = view.dataWindow ();
+
+        cout << (name ? name : "(unnamed)") << ": " << dw.min << " - "
+             << dw.max << ", " << view.channels ()->num_channels
+             << " channels" << endl;
+    }
+}
+// [end readHeaderView]